@@ -71,8 +71,9 @@
 
 /* Memory allocation related definitions. */
 #ifndef configSUPPORT_STATIC_ALLOCATION
-#define configSUPPORT_STATIC_ALLOCATION         0
+#define configSUPPORT_STATIC_ALLOCATION         1   // tasks with stacks in scratch RAM (tkjhat/sram.h)
 #endif
+#define configKERNEL_PROVIDED_STATIC_MEMORY     1   // idle/timer task memory from the kernel
 #ifndef configSUPPORT_DYNAMIC_ALLOCATION
 #define configSUPPORT_DYNAMIC_ALLOCATION        1
 #endif
@@ -85,10 +86,19 @@
 #define configUSE_DAEMON_TASK_STARTUP_HOOK      0
 
 /* Run time and task stats gathering related definitions. */
-#define configGENERATE_RUN_TIME_STATS           0
+#define configGENERATE_RUN_TIME_STATS           1
 #define configUSE_TRACE_FACILITY                1
 #define configUSE_STATS_FORMATTING_FUNCTIONS    0
 
+/* Run time counter: the 1 MHz system timer. The 32-bit value wraps after ~71 min,
+   consumers (e.g. the TKJHAT task monitor) only use differences. */
+#ifndef __ASSEMBLER__
+#include <stdint.h>
+extern uint64_t time_us_64(void);
+#endif
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()        ( ( uint32_t ) time_us_64() )
+
 /* Co-routine related definitions. */
 #define configUSE_CO_ROUTINES                   0
 #define configMAX_CO_ROUTINE_PRIORITIES         1
@@ -157,5 +167,16 @@ to exclude the API function. */
 
 /* A header file that defines trace macro can be included here. */
 
+/* XIP cache profiling (TKJHAT_XIP_PROFILE, see tkjhat/xip_prof.h): the cache
+   accesses are credited to the task switched in. */
+#if defined(TKJHAT_XIP_PROFILE) && TKJHAT_XIP_PROFILE
+#ifndef __ASSEMBLER__
+extern void xip_prof_task_switched_in(void *task);
+extern void xip_prof_task_deleted(void *task);
+#endif
+#define traceTASK_SWITCHED_IN()                 xip_prof_task_switched_in( ( void * ) pxCurrentTCB )
+#define traceTASK_DELETE( pxTaskToDelete )      xip_prof_task_deleted( ( void * ) ( pxTaskToDelete ) )
+#endif
+
 #endif /* FREERTOS_CONFIG_H */
 
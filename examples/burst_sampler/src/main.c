@@ -0,0 +1,197 @@
+// Anomaly-triggered burst sampling.
+//
+// IMU and light are sampled slowly and nothing is sent while the readings are
+// normal. A knock on the board, a shadow over the light sensor or button 1
+// starts a burst: the IMU ODR goes up, the light sensor is read at every
+// integration, the microphone starts and the samples (with one second of
+// history from before the trigger) are written as CSV lines to CDC1.
+// CDC0 gets a short status report every 10 s.
+
+#include <math.h>
+#include <stdio.h>
+#include <pico/stdlib.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <tusb.h>
+#include "usbSerialDebug/helper.h"
+#include <tkjhat/sdk.h>
+#include <tkjhat/burst.h>
+#include <tkjhat/gpio_irq.h>
+
+#if CFG_TUSB_OS != OPT_OS_FREERTOS
+#error "This should be using FREERTOS but the CFG_TUSB_OS is not OPT_OS_FREERTOS"
+#endif
+
+#define CDC_ITF_BURST           1
+#define IMU_IDLE_ODR_HZ         25
+#define IMU_BURST_ODR_HZ        400
+
+// ---- Sources ----
+static int read_imu(float *v, void *ctx) {
+    (void)ctx;
+    float t;
+    return ICM42670_read_sensor_data(&v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &t) == 0 ? 6 : -1;
+}
+
+static void imu_rate(bool burst, void *ctx) {
+    (void)ctx;
+    ICM42670_startAccel(burst ? IMU_BURST_ODR_HZ : IMU_IDLE_ODR_HZ, ICM42670_ACCEL_FSR_DEFAULT);
+    ICM42670_startGyro(burst ? IMU_BURST_ODR_HZ : IMU_IDLE_ODR_HZ, ICM42670_GYRO_FSR_DEFAULT);
+}
+
+static int read_light(float *v, void *ctx) {
+    (void)ctx;
+    v[0] = (float)veml6030_read_light();
+    return 1;
+}
+
+// Level of the last microphone block, written from the sample-ready callback
+static int16_t mic_block[MEMS_BUFFER_SIZE];
+static volatile float mic_rms, mic_peak;
+static volatile bool mic_fresh;
+
+static void on_mic_block(void) {
+    int n = get_microphone_samples(mic_block, MEMS_BUFFER_SIZE);
+    if (n <= 0) return;
+    float acc = 0.0f, peak = 0.0f;
+    for (int i = 0; i < n; i++) {
+        float s = (float)mic_block[i];
+        acc += s * s;
+        if (fabsf(s) > peak) peak = fabsf(s);
+    }
+    mic_rms = sqrtf(acc / (float)n);
+    mic_peak = peak;
+    mic_fresh = true;
+}
+
+static int read_mic(float *v, void *ctx) {
+    (void)ctx;
+    if (!mic_fresh) return 0;
+    mic_fresh = false;
+    v[0] = mic_rms;
+    v[1] = mic_peak;
+    return 2;
+}
+
+static void mic_rate(bool burst, void *ctx) {
+    (void)ctx;
+    if (burst) {
+        mic_fresh = false;
+        init_microphone_sampling();
+    } else {
+        end_microphone_sampling();
+    }
+}
+
+// ---- Output ----
+// CDC1 carries the bursts. Waits a little for room in the TX FIFO and drops
+// the line if the host does not read.
+static int burst_to_cdc(const char *text, size_t len, void *ctx) {
+    (void)ctx;
+    if (!tud_cdc_n_connected(CDC_ITF_BURST)) return -1;
+    for (int tries = 0; len && tries < 20; tries++) {
+        uint32_t n = tud_cdc_n_write(CDC_ITF_BURST, text, len);
+        text += n;
+        len -= n;
+        if (len) {
+            tud_cdc_n_write_flush(CDC_ITF_BURST);
+            vTaskDelay(pdMS_TO_TICKS(1));
+        }
+    }
+    tud_cdc_n_write_flush(CDC_ITF_BURST);
+    return len ? -1 : 0;
+}
+
+static void button1_handler(const gpio_irq_event_t *ev, void *ctx) {
+    (void)ev;
+    (void)ctx;
+    burst_trigger();
+}
+
+static void report_task(void *arg) {
+    (void)arg;
+    static char report[BURST_REPORT_SIZE];
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(10000));
+        burst_format_report(report, sizeof(report));
+        usb_serial_print(report);
+    }
+}
+
+// ---- Task running USB stack ----
+static void usbTask(void *arg) {
+    (void)arg;
+    while (1) {
+        tud_task();              // With FreeRTOS wait for events
+                                 // Do not add vTaskDelay.
+    }
+}
+
+int main() {
+    init_hat_sdk();
+    sleep_ms(300); //Wait some time so initialization of USB and hat is done.
+
+    init_ICM42670();
+    ICM42670_start_with_default_values();
+    init_veml6030();
+    init_pdm_microphone();
+    pdm_microphone_set_callback(on_mic_block);
+
+    // |a| in g: a knock is a few sigma above the gravity baseline
+    burst_source_t imu = BURST_SOURCE_DEFAULT;
+    imu.name = "imu";
+    imu.idle_period_ms = 1000 / IMU_IDLE_ODR_HZ;
+    imu.burst_period_ms = 1000 / IMU_BURST_ODR_HZ;
+    imu.read = read_imu;
+    imu.set_rate = imu_rate;
+    imu.detect_first = 0;
+    imu.detect_count = 3;
+    imu.detect.z_threshold = 5.0f;
+    imu.detect.min_std = 0.01f;
+    burst_add_source(&imu);
+
+    // Lux: sudden shadows or flashes, by z-score or by 500 lux/s
+    burst_source_t light = BURST_SOURCE_DEFAULT;
+    light.name = "lux";
+    light.idle_period_ms = 500;
+    light.burst_period_ms = 100;         // one integration time
+    light.read = read_light;
+    light.detect.min_std = 2.0f;
+    light.detect.rate_threshold = 500.0f;
+    light.detect.warmup = 8;
+    burst_add_source(&light);
+
+    // Microphone: off outside bursts, block RMS and peak during them
+    burst_source_t mic = BURST_SOURCE_DEFAULT;
+    mic.name = "mic";
+    mic.idle_period_ms = 0;
+    mic.burst_period_ms = 1000 * MEMS_BUFFER_SIZE / MEMS_SAMPLING_FREQUENCY;
+    mic.read = read_mic;
+    mic.set_rate = mic_rate;
+    mic.detect_count = 0;
+    burst_add_source(&mic);
+
+    burst_config_t cfg = BURST_DEFAULT_CONFIG;
+    burst_init(&cfg, burst_to_cdc, NULL);
+
+    init_button1();
+    gpio_irq_register(BUTTON1, GPIO_IRQ_EDGE_FALL, button1_handler, NULL, true);
+
+    TaskHandle_t hUsb = NULL;
+    xTaskCreate(usbTask, "usb", 1024, NULL, 3, &hUsb);
+    xTaskCreate(report_task, "report", 1024, NULL, 1, NULL);
+    #if (configNUMBER_OF_CORES > 1)
+        vTaskCoreAffinitySet(hUsb, 1u << 0);
+    #endif
+
+    // VERY IMPORTANT, THIS SHOULD GO JUST BEFORE vTaskStartSheduler
+    // WITHOUT ANY DELAYS. OTHERWISE, THE TinyUSB stack wont recognize
+    // the device.
+    tusb_init();
+    usb_serial_init();
+    vTaskStartScheduler();
+
+    return 0;
+}
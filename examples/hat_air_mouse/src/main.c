@@ -0,0 +1,97 @@
+// IMU air mouse / gamepad on USB HID (usbSerialDebug/hid.h).
+//
+// The IMU runs at 800 Hz and its data-ready interrupt paces the reports: turn
+// the board left / right and up / down to move the pointer, BUTTON1 and
+// BUTTON2 are the mouse buttons. The device stays a composite device, so CDC0
+// keeps working:
+//
+//   p   pointer mode (default)
+//   g   gamepad mode: tilt gives X / Y, turning gives Rz
+//   r   clear the latency histograms
+//
+// CDC0 gets the counters and the motion-to-host latency percentiles every 5 s.
+
+#include <stdio.h>
+#include <pico/stdlib.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <tusb.h>
+#include "usbSerialDebug/helper.h"
+#include "usbSerialDebug/hid.h"
+#include <tkjhat/sdk.h>
+#include <tkjhat/hat_snapshot.h>
+
+#if CFG_TUSB_OS != OPT_OS_FREERTOS
+#error "This should be using FREERTOS but the CFG_TUSB_OS is not OPT_OS_FREERTOS"
+#endif
+
+#define IMU_ODR_HZ              800
+#define REPORT_PERIOD_MS        5000
+
+static void report_task(void *arg) {
+    (void)arg;
+    static char text[384];
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(REPORT_PERIOD_MS));
+        if (!usb_serial_connected()) continue;
+        usb_hid_format_report(text, sizeof(text));
+        usb_serial_print(text);
+    }
+}
+
+// ---- Task running USB stack ----
+static void usbTask(void *arg) {
+    (void)arg;
+    while (1) {
+        tud_task();              // With FreeRTOS wait for events
+                                 // Do not add vTaskDelay.
+    }
+}
+
+// Single letter commands on CDC0; CDC1 input is read and dropped
+void tud_cdc_rx_cb(uint8_t itf) {
+    uint8_t buf[64];
+    uint32_t n;
+    while ((n = tud_cdc_n_read(itf, buf, sizeof(buf))) > 0) {
+        if (itf != 0) continue;
+        for (uint32_t i = 0; i < n; i++) {
+            if (buf[i] == 'p') usb_hid_set_mode(AIR_MOUSE_POINTER);
+            else if (buf[i] == 'g') usb_hid_set_mode(AIR_MOUSE_GAMEPAD);
+            else if (buf[i] == 'r') usb_hid_reset_stats();
+        }
+    }
+}
+
+int main() {
+    init_hat_sdk();
+    sleep_ms(300); //Wait some time so initialization of USB and hat is done.
+
+    if (init_ICM42670() != 0) {
+        init_red_led();
+        set_red_led_status(true);       // no IMU: nothing to report
+    }
+    ICM42670_enable_accel_gyro_ln_mode();
+    ICM42670_startAccel(IMU_ODR_HZ, 4);
+    ICM42670_startGyro(IMU_ODR_HZ, 500);
+    hat_snapshot_init();
+
+    TaskHandle_t hUsb = NULL;
+    xTaskCreate(usbTask, "usb", 1024, NULL, 3, &hUsb);
+    xTaskCreate(report_task, "report", 512, NULL, 1, NULL);
+    #if (configNUMBER_OF_CORES > 1)
+        vTaskCoreAffinitySet(hUsb, 1u << 0);
+    #endif
+
+    // VERY IMPORTANT, THIS SHOULD GO JUST BEFORE vTaskStartSheduler
+    // WITHOUT ANY DELAYS. OTHERWISE, THE TinyUSB stack wont recognize
+    // the device.
+    tusb_init();
+    usb_serial_init();
+    air_mouse_config_t cfg = AIR_MOUSE_DEFAULT_CONFIG;
+    usb_hid_init(&cfg);
+    vTaskStartScheduler();
+
+    return 0;
+}
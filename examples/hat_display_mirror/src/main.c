@@ -0,0 +1,117 @@
+// OLED mirror on CDC1 (tkjhat/display_mirror.h).
+//
+// A ball bounces around the OLED. Every ssd1306_show() is encoded as a delta
+// against the previous frame and written to CDC1, raw, with a keyframe every
+// 100 records. On the PC, open the second serial port with the viewer:
+//
+//   display_mirror_rx /dev/ttyACM1 frames/
+//
+// It writes one PBM image per frame plus frames.csv and frames.ffconcat.
+// CDC0 gets the mirroring counters every 5 s.
+
+#include <stdio.h>
+#include <pico/stdlib.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <tusb.h>
+#include "usbSerialDebug/helper.h"
+#include <tkjhat/sdk.h>
+#include <tkjhat/display_mirror.h>
+
+#if CFG_TUSB_OS != OPT_OS_FREERTOS
+#error "This should be using FREERTOS but the CFG_TUSB_OS is not OPT_OS_FREERTOS"
+#endif
+
+#define CDC_ITF_MIRROR          1
+#define KEYFRAME_INTERVAL       100
+#define FRAME_PERIOD_MS         100
+#define REPORT_PERIOD_MS        5000
+#define BALL_R                  6
+
+// Display sink: the whole record or nothing, never waits for the host. A
+// refused record makes the next one a keyframe, so the viewer resynchronizes.
+static bool cdc1_sink(const uint8_t *data, size_t len, void *ctx) {
+    (void)ctx;
+    if (!tud_mounted() || !tud_cdc_n_connected(CDC_ITF_MIRROR)) return false;
+    if (tud_cdc_n_write_available(CDC_ITF_MIRROR) < len) return false;
+    tud_cdc_n_write(CDC_ITF_MIRROR, data, len);
+    tud_cdc_n_write_flush(CDC_ITF_MIRROR);
+    return true;
+}
+
+static void draw_task(void *arg) {
+    (void)arg;
+    int16_t x = 20, y = 20, dx = 3, dy = 2;
+
+    init_display();
+    display_mirror_start(cdc1_sink, NULL, KEYFRAME_INTERVAL);
+
+    for (;;) {
+        clear_display();
+        draw_circle(x, y, BALL_R, true);
+
+        x += dx;
+        y += dy;
+        if (x < BALL_R || x > 127 - BALL_R) dx = -dx;
+        if (y < BALL_R || y > 63 - BALL_R) dy = -dy;
+        vTaskDelay(pdMS_TO_TICKS(FRAME_PERIOD_MS));
+    }
+}
+
+static void report_task(void *arg) {
+    (void)arg;
+    char text[160];
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(REPORT_PERIOD_MS));
+        if (!usb_serial_connected()) continue;
+
+        display_mirror_stats_t s;
+        display_mirror_get_stats(&s);
+        snprintf(text, sizeof(text),
+                 "[mirror] frames=%lu records=%lu key=%lu same=%lu drop=%lu bytes=%lu enc avg/max=%lu/%luus\n",
+                 (unsigned long)s.frames, (unsigned long)s.records, (unsigned long)s.keyframes,
+                 (unsigned long)s.unchanged, (unsigned long)s.dropped, (unsigned long)s.bytes,
+                 (unsigned long)s.encode_us_avg, (unsigned long)s.encode_us_max);
+        usb_serial_print(text);
+    }
+}
+
+// ---- Task running USB stack ----
+static void usbTask(void *arg) {
+    (void)arg;
+    while (1) {
+        tud_task();              // With FreeRTOS wait for events
+                                 // Do not add vTaskDelay.
+    }
+}
+
+// Nothing is expected from the host: read and drop, so the ports stay usable
+void tud_cdc_rx_cb(uint8_t itf) {
+    uint8_t buf[64];
+    while (tud_cdc_n_read(itf, buf, sizeof(buf)) > 0) {
+    }
+}
+
+int main() {
+    init_hat_sdk();
+    sleep_ms(300); //Wait some time so initialization of USB and hat is done.
+
+    TaskHandle_t hUsb = NULL;
+    xTaskCreate(usbTask, "usb", 1024, NULL, 3, &hUsb);
+    xTaskCreate(draw_task, "draw", 1024, NULL, 2, NULL);
+    xTaskCreate(report_task, "report", 512, NULL, 1, NULL);
+    #if (configNUMBER_OF_CORES > 1)
+        vTaskCoreAffinitySet(hUsb, 1u << 0);
+    #endif
+
+    // VERY IMPORTANT, THIS SHOULD GO JUST BEFORE vTaskStartSheduler
+    // WITHOUT ANY DELAYS. OTHERWISE, THE TinyUSB stack wont recognize
+    // the device.
+    tusb_init();
+    usb_serial_init();
+    vTaskStartScheduler();
+
+    return 0;
+}
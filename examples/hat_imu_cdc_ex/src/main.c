@@ -9,6 +9,7 @@
 #include <tusb.h>
 #include "usbSerialDebug/helper.h"
 #include <tkjhat/sdk.h>
+#include <tkjhat/energy.h>
 
 #if CFG_TUSB_OS != OPT_OS_FREERTOS
 #error "This should be using FREERTOS but the CFG_TUSB_OS is not OPT_OS_FREERTOS"
@@ -52,6 +53,24 @@ void imu_task(void *pvParameters) {
 
 }
 
+// ---- Energy accounting ----
+// The SDK reports the sensors; USB state is only known to TinyUSB.
+static energy_state_t usb_energy_state(uint8_t *level) {
+    (void)level;
+    if (!tud_mounted()) return ENERGY_OFF;
+    return tud_suspended() ? ENERGY_IDLE : ENERGY_ON;
+}
+
+static void energy_report_task(void *arg) {
+    (void)arg;
+    static char report[ENERGY_REPORT_SIZE];
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(10000));
+        energy_format_report(report, sizeof(report));
+        usb_serial_print(report);
+    }
+}
+
 // ---- Task running USB stack ----
 static void usbTask(void *arg) {
     (void)arg;
@@ -63,6 +82,8 @@ static void usbTask(void *arg) {
 
 int main() {
     
+    energy_init(1000);
+    energy_set_probe(ENERGY_USB, usb_energy_state);
     init_hat_sdk();
     sleep_ms(300); //Wait some time so initialization of USB and hat is done.
     init_led();
@@ -72,6 +93,7 @@ int main() {
 
     xTaskCreate(imu_task, "IMUTask", 1024, NULL, 2, &hIMUTask);
     xTaskCreate(usbTask, "usb", 1024, NULL, 3, &hUsb);
+    xTaskCreate(energy_report_task, "energy_rpt", 1024, NULL, 1, NULL);
     #if (configNUMBER_OF_CORES > 1)
         vTaskCoreAffinitySet(hUsb, 1u << 0);
     #endif
@@ -0,0 +1,99 @@
+/*
+ * Sensor dashboard read: per-call APIs vs hat_snapshot_read().
+ *
+ * Every 5 s the task reads all the HAT sensors ROUNDS times each way and
+ * prints the average time of one full read on USB stdio:
+ *
+ *  - per-call: veml6030_read_light, hdc2021_read_temperature,
+ *    hdc2021_read_humidity and ICM42670_read_sensor_data (4 transactions,
+ *    float conversions),
+ *  - snapshot: hat_snapshot_read(HAT_SNAPSHOT_ALL) (3 burst transactions,
+ *    integer conversions).
+ *
+ * The last values of both paths are printed side by side to check that the
+ * conversions agree.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pico/stdlib.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <tkjhat/sdk.h>
+#include <tkjhat/early_log.h>
+#include <tkjhat/hat_snapshot.h>
+
+#define ROUNDS              100
+#define REPORT_MS           5000
+
+typedef struct {
+    uint32_t lux;
+    float temp, humidity;
+    float ax, ay, az, gx, gy, gz, imu_temp;
+} legacy_t;
+
+static void read_legacy(legacy_t *v) {
+    v->lux = veml6030_read_light();
+    v->temp = hdc2021_read_temperature();
+    v->humidity = hdc2021_read_humidity();
+    ICM42670_read_sensor_data(&v->ax, &v->ay, &v->az, &v->gx, &v->gy, &v->gz, &v->imu_temp);
+}
+
+static void report_task(void *arg) {
+    (void)arg;
+
+    // Both sensors need one integration / measurement period before the first read
+    vTaskDelay(pdMS_TO_TICKS(1100));
+
+    for (;;) {
+        legacy_t l;
+        hat_snapshot_t s;
+        uint32_t bus_us = 0;
+
+        uint64_t t0 = time_us_64();
+        for (int i = 0; i < ROUNDS; i++) read_legacy(&l);
+        uint64_t t1 = time_us_64();
+        for (int i = 0; i < ROUNDS; i++) {
+            hat_snapshot_read(&s, HAT_SNAPSHOT_ALL);
+            bus_us += s.bus_us;
+        }
+        uint64_t t2 = time_us_64();
+
+        printf("[snap] per-call %4lu us | snapshot %4lu us (bus %4lu us) | %d rounds\n",
+               (unsigned long)((t1 - t0) / ROUNDS), (unsigned long)((t2 - t1) / ROUNDS),
+               (unsigned long)(bus_us / ROUNDS), ROUNDS);
+        printf("[snap] light %lu / %lu lx | temp %.2f / %d.%02d C | rh %.2f / %u.%02u %%\n",
+               (unsigned long)l.lux, (unsigned long)s.lux,
+               l.temp, s.temp_c100 / 100, abs(s.temp_c100 % 100),
+               l.humidity, s.humidity_p100 / 100, s.humidity_p100 % 100);
+        printf("[snap] accel %.3f %.3f %.3f / %ld %ld %ld mg | gyro %.2f %.2f %.2f / %ld %ld %ld mdps | valid 0x%x\n",
+               l.ax, l.ay, l.az, (long)s.accel_mg[0], (long)s.accel_mg[1], (long)s.accel_mg[2],
+               l.gx, l.gy, l.gz, (long)s.gyro_mdps[0], (long)s.gyro_mdps[1], (long)s.gyro_mdps[2],
+               s.valid);
+
+        vTaskDelay(pdMS_TO_TICKS(REPORT_MS));
+    }
+}
+
+int main(void) {
+    stdio_init_all();
+    early_log_init(true);
+    init_hat_sdk();
+    sleep_ms(300);
+
+    init_veml6030();
+    init_hdc2021_();
+    if (init_ICM42670() != 0 || ICM42670_start_with_default_values() != 0) {
+        printf("ICM-42670P initialization failed!\n");
+    }
+    if (hat_snapshot_init() != 0) {
+        printf("hat_snapshot_init failed, using default IMU scale\n");
+    }
+
+    xTaskCreate(report_task, "snap", 1024, NULL, 2, NULL);
+
+    vTaskStartScheduler();
+    return 0;
+}
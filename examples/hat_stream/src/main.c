@@ -0,0 +1,173 @@
+// HAT sensors as record streams on CDC1 (usbSerialDebug/stream.h).
+//
+// A sensor task reads the IMU every 5 ms and the light and temperature /
+// humidity sensors every 100 ms with hat_snapshot_read(), and the microphone
+// blocks are forwarded as they arrive. Nothing is sent until the host enables
+// the streams, e.g. with the host client:
+//
+//   ./build-host/stream_client_pty monitor /dev/ttyACM1
+//
+// Command 0x40 switches the red LED (argument 0 or 1). CDC0 gets a short
+// status line every 10 s.
+
+#include <stdio.h>
+#include <pico/stdlib.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <tusb.h>
+#include "usbSerialDebug/helper.h"
+#include "usbSerialDebug/stream.h"
+#include <tkjhat/sdk.h>
+#include <tkjhat/hat_snapshot.h>
+
+#if CFG_TUSB_OS != OPT_OS_FREERTOS
+#error "This should be using FREERTOS but the CFG_TUSB_OS is not OPT_OS_FREERTOS"
+#endif
+
+#define IMU_PERIOD_MS           5
+#define SLOW_EVERY              20      // light and environment every 20 IMU reads
+#define CMD_LED                 STREAM_CMD_USER
+
+// ---- Microphone: blocks handed from the driver callback to the audio task ----
+static int16_t mic_block[MEMS_BUFFER_SIZE];
+static volatile int mic_count;
+static volatile uint32_t mic_timestamp;
+static TaskHandle_t audio_task_handle;
+
+static void on_mic_block(void) {
+    int n = get_microphone_samples(mic_block, MEMS_BUFFER_SIZE);
+    if (n <= 0 || !audio_task_handle) return;
+    // Time of the first sample of the block
+    mic_timestamp = time_us_32() - (uint32_t)n * 1000000u / MEMS_SAMPLING_FREQUENCY;
+    mic_count = n;
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(audio_task_handle, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+static void audio_task(void *arg) {
+    (void)arg;
+    int16_t block[MEMS_BUFFER_SIZE];
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        uint32_t irq = save_and_disable_interrupts();
+        int n = mic_count;
+        uint32_t ts = mic_timestamp;
+        for (int i = 0; i < n; i++) block[i] = mic_block[i];
+        mic_count = 0;
+        restore_interrupts(irq);
+        if (n > 0) usb_stream_send_audio(ts, MEMS_SAMPLING_FREQUENCY, block, (size_t)n);
+    }
+}
+
+// ---- Sensors ----
+static void sensor_task(void *arg) {
+    (void)arg;
+    TickType_t last = xTaskGetTickCount();
+    unsigned n = 0;
+    for (;;) {
+        vTaskDelayUntil(&last, pdMS_TO_TICKS(IMU_PERIOD_MS));
+        bool slow = (n++ % SLOW_EVERY) == 0;
+        if (!usb_stream_enabled(STREAM_MSG_IMU) && !(slow && (usb_stream_enabled(STREAM_MSG_ENV) ||
+                                                               usb_stream_enabled(STREAM_MSG_LIGHT))))
+            continue;
+
+        hat_snapshot_t s;
+        uint32_t devices = HAT_SNAPSHOT_IMU | (slow ? HAT_SNAPSHOT_LIGHT | HAT_SNAPSHOT_TEMP_HUMIDITY : 0);
+        hat_snapshot_read(&s, devices);
+        uint32_t ts = (uint32_t)s.timestamp_us;
+
+        if (s.valid & HAT_SNAPSHOT_IMU) {
+            stream_imu_t r = { .timestamp_us = ts, .temp_c100 = s.imu_temp_c100 };
+            for (int i = 0; i < 3; i++) {
+                r.accel_mg[i] = (int16_t)s.accel_mg[i];
+                r.gyro_mdps[i] = s.gyro_mdps[i];
+            }
+            usb_stream_send_imu(&r);
+        }
+        if (s.valid & HAT_SNAPSHOT_TEMP_HUMIDITY) {
+            stream_env_t e = { .timestamp_us = ts, .temp_c100 = s.temp_c100, .humidity_p100 = s.humidity_p100 };
+            usb_stream_send_env(&e);
+        }
+        if (s.valid & HAT_SNAPSHOT_LIGHT) {
+            stream_light_t l = { .timestamp_us = ts, .lux = s.lux };
+            usb_stream_send_light(&l);
+        }
+    }
+}
+
+static int cmd_led(void *ctx, const uint8_t *args, size_t len, uint8_t *out, size_t *out_len) {
+    (void)ctx; (void)out; (void)out_len;
+    if (len != 1 || args[0] > 1) return STREAM_ERR_BAD_ARGS;
+    set_red_led_status(args[0] != 0);
+    return STREAM_OK;
+}
+
+static void report_task(void *arg) {
+    (void)arg;
+    char line[96];
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(10000));
+        if (!usb_serial_connected()) continue;
+        snprintf(line, sizeof(line), "[stream] imu %d env %d light %d audio %d\n",
+                 usb_stream_enabled(STREAM_MSG_IMU), usb_stream_enabled(STREAM_MSG_ENV),
+                 usb_stream_enabled(STREAM_MSG_LIGHT), usb_stream_enabled(STREAM_MSG_AUDIO));
+        usb_serial_print(line);
+    }
+}
+
+// ---- Task running USB stack ----
+static void usbTask(void *arg) {
+    (void)arg;
+    while (1) {
+        tud_task();              // With FreeRTOS wait for events
+                                 // Do not add vTaskDelay.
+    }
+}
+
+// Data arrived on a CDC interface. CDC0 input is read and dropped so it does not block CDC0.
+void tud_cdc_rx_cb(uint8_t itf) {
+    if (itf == USB_STREAM_ITF) {
+        usb_stream_rx(itf);
+    } else {
+        uint8_t buf[64];
+        while (tud_cdc_n_read(itf, buf, sizeof(buf))) {}
+    }
+}
+
+int main() {
+    init_hat_sdk();
+    sleep_ms(300); //Wait some time so initialization of USB and hat is done.
+
+    init_red_led();
+    init_veml6030();
+    init_hdc2021_();
+    init_ICM42670();
+    ICM42670_start_with_default_values();
+    hat_snapshot_init();
+    init_pdm_microphone();
+    pdm_microphone_set_callback(on_mic_block);
+    init_microphone_sampling();
+
+    TaskHandle_t hUsb = NULL;
+    xTaskCreate(usbTask, "usb", 1024, NULL, 3, &hUsb);
+    xTaskCreate(sensor_task, "sensors", 1024, NULL, 2, NULL);
+    xTaskCreate(audio_task, "audio", 1024, NULL, 2, &audio_task_handle);
+    xTaskCreate(report_task, "report", 512, NULL, 1, NULL);
+    #if (configNUMBER_OF_CORES > 1)
+        vTaskCoreAffinitySet(hUsb, 1u << 0);
+    #endif
+
+    // VERY IMPORTANT, THIS SHOULD GO JUST BEFORE vTaskStartSheduler
+    // WITHOUT ANY DELAYS. OTHERWISE, THE TinyUSB stack wont recognize
+    // the device.
+    tusb_init();
+    usb_serial_init();
+    usb_stream_init("tkjhat");
+    usb_stream_register_command(CMD_LED, cmd_led, NULL);
+    vTaskStartScheduler();
+
+    return 0;
+}
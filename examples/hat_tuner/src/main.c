@@ -0,0 +1,187 @@
+// Tuner on the HAT microphone (tkjhat/pitch.h).
+//
+// Every microphone block goes through the YIN pitch detector, which gives an
+// estimate every 16 ms. The OLED shows the nearest note, its offset in cents as
+// a needle and the frequency, ten times per second.
+//
+// BUTTON1 checks the buzzer: it plays a few tones and CDC0 gets, for each, the
+// frequency requested, the median of the estimates heard while it played and
+// the difference in cents.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pico/stdlib.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <tusb.h>
+#include "usbSerialDebug/helper.h"
+#include <tkjhat/sdk.h>
+#include <tkjhat/pitch.h>
+
+#if CFG_TUSB_OS != OPT_OS_FREERTOS
+#error "This should be using FREERTOS but the CFG_TUSB_OS is not OPT_OS_FREERTOS"
+#endif
+
+#define DISPLAY_PERIOD_MS       100
+#define TONE_MS                 800
+#define SETTLE_MS               200     // estimates ignored at the start of a tone
+#define MAX_HEARD               64
+
+static const char *const note_names[12] = {
+    "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"
+};
+static const uint32_t test_tones[] = { 262, 440, 523, 880, 1047, 1319 };
+
+static pitch_t detector;
+static pitch_result_t latest;                   // guarded by a critical section
+
+// Estimates collected while the buzzer plays (check_hz != 0)
+static volatile uint32_t check_hz;
+static uint32_t heard[MAX_HEARD];
+static volatile uint32_t heard_count;
+
+// ---- Microphone: the interrupt only wakes the audio task ----
+static int16_t pcm[MEMS_BUFFER_SIZE];
+static TaskHandle_t audio_task_handle;
+
+static void on_mic_block(void) {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(audio_task_handle, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+static void audio_task(void *arg) {
+    (void)arg;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        int n = get_microphone_samples(pcm, MEMS_BUFFER_SIZE);
+        if (n <= 0) continue;
+        pitch_result_t r;
+        if (!pitch_process(&detector, pcm, (size_t)n, &r)) continue;
+        taskENTER_CRITICAL();
+        latest = r;
+        taskEXIT_CRITICAL();
+        if (check_hz && r.voiced && heard_count < MAX_HEARD) heard[heard_count++] = r.freq_chz;
+    }
+}
+
+// ---- Display: note, needle and frequency ----
+static void display_task(void *arg) {
+    (void)arg;
+    char text[24];
+    for (;;) {
+        pitch_result_t r;
+        taskENTER_CRITICAL();
+        r = latest;
+        taskEXIT_CRITICAL();
+
+        clear_display();
+        if (r.voiced) {
+            int cents;
+            int note = pitch_note(r.freq_chz, &cents);
+            snprintf(text, sizeof(text), "%s%d %+d c", note_names[note % 12], note / 12 - 1, cents);
+            write_text_xy(0, 0, text);
+            snprintf(text, sizeof(text), "%lu.%02lu Hz", (unsigned long)(r.freq_chz / 100),
+                     (unsigned long)(r.freq_chz % 100));
+            write_text_xy(0, 48, text);
+            int16_t x = (int16_t)(64 + cents);                  // -50..50 cents across the middle
+            draw_line(14, 32, 114, 32);
+            draw_line(64, 26, 64, 38);
+            draw_line(x, 20, x, 44);
+        } else {
+            write_text_xy(0, 0, "-");
+        }
+        vTaskDelay(pdMS_TO_TICKS(DISPLAY_PERIOD_MS));
+    }
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+// ---- Buzzer check on BUTTON1 ----
+static void buzzer_task(void *arg) {
+    (void)arg;
+    char text[96];
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(50));
+        if (!gpio_get(SW1_PIN)) continue;
+
+        usb_serial_print("buzzer check: requested / heard (median of estimates) / cents\n");
+        for (size_t i = 0; i < sizeof(test_tones) / sizeof(test_tones[0]); i++) {
+            uint32_t hz = test_tones[i];
+            buzzer_play_tone(hz, SETTLE_MS);
+            heard_count = 0;
+            check_hz = hz;
+            buzzer_play_tone(hz, TONE_MS - SETTLE_MS);
+            check_hz = 0;
+            buzzer_turn_off();
+
+            uint32_t n = heard_count;
+            if (n == 0) {
+                snprintf(text, sizeof(text), "  %4lu Hz  not heard\n", (unsigned long)hz);
+            } else {
+                qsort(heard, n, sizeof(heard[0]), compare_u32);
+                uint32_t median = heard[n / 2];
+                snprintf(text, sizeof(text), "  %4lu Hz  %7lu.%02lu Hz  %+ld cents (%lu estimates)\n",
+                         (unsigned long)hz, (unsigned long)(median / 100), (unsigned long)(median % 100),
+                         (long)pitch_cents(median, hz * 100u), (unsigned long)n);
+            }
+            usb_serial_print(text);
+            vTaskDelay(pdMS_TO_TICKS(200));
+        }
+        while (gpio_get(SW1_PIN)) vTaskDelay(pdMS_TO_TICKS(50));
+    }
+}
+
+// ---- Task running USB stack ----
+static void usbTask(void *arg) {
+    (void)arg;
+    while (1) {
+        tud_task();              // With FreeRTOS wait for events
+                                 // Do not add vTaskDelay.
+    }
+}
+
+// Input on either CDC is read and dropped
+void tud_cdc_rx_cb(uint8_t itf) {
+    uint8_t buf[64];
+    while (tud_cdc_n_read(itf, buf, sizeof(buf))) {}
+}
+
+int main() {
+    init_hat_sdk();
+    sleep_ms(300); //Wait some time so initialization of USB and hat is done.
+
+    init_display();
+    init_buzzer();
+    init_button1();
+
+    pitch_config_t cfg = PITCH_DEFAULT_CONFIG;
+    cfg.sample_rate = MEMS_SAMPLING_FREQUENCY;
+    pitch_init(&detector, &cfg);
+    init_pdm_microphone();
+    pdm_microphone_set_callback(on_mic_block);
+    init_microphone_sampling();
+
+    TaskHandle_t hUsb = NULL;
+    xTaskCreate(usbTask, "usb", 1024, NULL, 3, &hUsb);
+    xTaskCreate(audio_task, "audio", 1024, NULL, 2, &audio_task_handle);
+    xTaskCreate(display_task, "display", 1024, NULL, 1, NULL);
+    xTaskCreate(buzzer_task, "buzzer", 1024, NULL, 1, NULL);
+    #if (configNUMBER_OF_CORES > 1)
+        vTaskCoreAffinitySet(hUsb, 1u << 0);
+    #endif
+
+    // VERY IMPORTANT, THIS SHOULD GO JUST BEFORE vTaskStartSheduler
+    // WITHOUT ANY DELAYS. OTHERWISE, THE TinyUSB stack wont recognize
+    // the device.
+    tusb_init();
+    usb_serial_init();
+    vTaskStartScheduler();
+
+    return 0;
+}
@@ -3,6 +3,9 @@
 #include <hardware/gpio.h>
 #include <pico/stdlib.h>
 #include <tkjhat/sdk.h>
+#include <tkjhat/agc.h>
+#include <tkjhat/denoise.h>
+#include <tkjhat/early_log.h>
 #include <pico/binary_info.h>
 #include <hardware/sync.h>
 
@@ -23,6 +26,11 @@ static inline void _blink(int n){
     int16_t sample_buffer[MEMS_BUFFER_SIZE];
     int16_t temp_sample_buffer[MEMS_BUFFER_SIZE];//use to have two different buffers.
     volatile int samples_read = 0;    
+    // Automatic gain control, run by the driver on every block
+    static agc_t agc;
+    // Removes the steady hiss of the microphone before the samples are sent
+    static denoise_t denoise;
+    static bool denoise_ready;
 
     void on_sound_buffer_ready(){
         // callback from library when all the samples in the library
@@ -32,7 +40,7 @@ static inline void _blink(int n){
 
     int main() {
         stdio_init_all();
-        sleep_ms(1500); //Wait to see the output.
+        early_log_init(false); //Keep the output until a host connects, no need to wait.
         init_hat_sdk();
         setvbuf(stdout, NULL, _IONBF, 0);
         printf("Start tests\n");
@@ -51,7 +59,19 @@ static inline void _blink(int n){
         pdm_microphone_set_callback(on_sound_buffer_ready);
         pdm_microphone_set_filter_max_volume(64); // keep default
         pdm_microphone_set_filter_gain(8);        // safer base gain than 16
-        pdm_microphone_set_filter_volume(56);     // was 64 ⇒ lower hiss; raise if still too quiet
+        // The level is handled by the AGC instead of a fixed volume: it raises quiet
+        // sounds, keeps the hiss down with its noise gate and limits loud sounds
+        // instead of clipping them. Feedback mode (the AGC sets the filter volume) only
+        // wins on very quiet input and loses SNR at speech levels (host/bench/bench_agc),
+        // so the gain is applied to the 16-bit samples.
+        agc_config_t agc_cfg = AGC_DEFAULT_CONFIG;
+        agc_cfg.sample_rate = MEMS_SAMPLING_FREQUENCY;
+        agc_cfg.feedback = false;
+        if (agc_init(&agc, &agc_cfg) == 0)
+            pdm_microphone_set_agc(&agc);
+        denoise_config_t dn_cfg = DENOISE_DEFAULT_CONFIG;
+        dn_cfg.sample_rate = MEMS_SAMPLING_FREQUENCY;
+        denoise_ready = denoise_init(&denoise, &dn_cfg) == 0;
         //Each iteration are 5 seconds. 
         while(true){
             //We are going to send 5 seconds. Each sample is two bytes and sampling rate 8Khz. 
@@ -59,9 +79,8 @@ static inline void _blink(int n){
             uint32_t sent_bytes = 0;
             _blink (5);
             if (is_mic_init >=0) {
-                // Wait till usb is ready and after that, turn the mike and inform other end with READY.
-                while (!stdio_usb_connected()) 
-                    sleep_ms(100);
+                // Sampling starts right away. Blocks are only sent while a host is connected,
+                // after the text printed at boot has been replayed to it.
                 if (init_microphone_sampling()<0){
                     printf("Cannot start sampling the microphone\n");
                     sleep_ms(500);
@@ -69,7 +88,7 @@ static inline void _blink(int n){
                 }
                 set_red_led_status(true);
                 while (sent_bytes < target_bytes){
-                    if (!stdio_usb_connected()) {
+                    if (sent_bytes > 0 && !early_log_connected()) {
                         _blink(1);
                         set_red_led_status(false);
                         break;
@@ -85,6 +104,13 @@ static inline void _blink(int n){
                     memcpy(temp_sample_buffer, sample_buffer, (size_t)sample_count * sizeof(sample_buffer[0]));
                     samples_read = 0;// restart the samples read
                     restore_interrupts(irq);
+                    // Nobody listening yet: drop the block instead of filling the early-log ring
+                    if (!early_log_connected())
+                        continue;
+
+                    // Noise suppression runs here, on the copy, so the callback is never delayed
+                    if (denoise_ready)
+                        denoise_process(&denoise, temp_sample_buffer, (size_t)sample_count);
 
                     // loop through any new collected samples
                     // OPTION 1 using fwrite
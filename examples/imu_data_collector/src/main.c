@@ -33,6 +33,7 @@
 #include <stdio.h>
 #include <pico/stdlib.h>
 #include <tkjhat/sdk.h>
+#include <tkjhat/early_log.h>
 
 // ============================================================================
 // GLOBAL VARIABLES
@@ -131,11 +132,9 @@ void init_imu_sensor(void) {
 int main() {
     stdio_init_all();
     
-    // Wait for serial connection (important for data collection!)
-    printf("Waiting for serial connection...\n");
-    while (!stdio_usb_connected()){
-        sleep_ms(100);
-    }
+    // Start right away: everything printed before the serial monitor connects
+    // is kept and replayed when it does
+    early_log_init(false);
     
     init_hat_sdk();
     sleep_ms(300);
@@ -178,7 +177,8 @@ int main() {
     // Main loop - just keep the program running
     // All data collection happens via interrupt
     while (1) {
-        tight_loop_contents();  // Low-power idle loop
+        early_log_connected();  // Replays the buffered output once a terminal opens
+        sleep_ms(50);
     }
     
     return 0;
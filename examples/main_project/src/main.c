@@ -6,9 +6,14 @@
 
 #include <FreeRTOS.h>
 #include <queue.h>
+#include <semphr.h>
 #include <task.h>
 
 #include "tkjhat/sdk.h"
+#include "tkjhat/gpio_irq.h"
+#include "tkjhat/early_log.h"
+#include "tkjhat/morse_wire.h"
+#include "tkjhat/display_sched.h"
 
 // Default stack size for the tasks. It can be reduced to 1024 if task is not using lot of memory.
 #define DEFAULT_STACK_SIZE 2048
@@ -51,6 +56,11 @@ volatile uint32_t last_button_time = 0;
 char received_buffer[RECEIVED_BUFFER_SIZE];
 volatile uint16_t received_index = 0;
 
+// Sarjayhteys: ASCII-viestit, tai tiivis muoto (tkjhat/morse_wire.h) kun isäntä on käyttänyt sitä.
+// wire_lock suojaa tilaa, koska receiver_task ja sender_task käyttävät sitä.
+static morse_wire_t wire;
+static SemaphoreHandle_t wire_lock;
+
 /*
 Buffereihin käytetty chatgpt:n apua
 Promptilla: "Miten voin hyödyntää bufferia koodissa viestin käsittelyyn?"
@@ -58,64 +68,72 @@ Koodia on muokattu aloittelijaystävällisemmäksi kasvattamalla indeksiä vasta
 sekä myös lisäämällä globaali muuttuja sanan pituudelle.
 */
 
-// Yksittäinen interrupt handler joka reitittää molemmat napit
-static void button_handler(uint gpio, uint32_t events) {
-    (void)events;
-
-    // debouncing ettei nappi rekisteröidy useasti
-    uint32_t current_time = to_ms_since_boot(get_absolute_time());
+// debouncing ettei nappi rekisteröidy useasti (yhteinen molemmille napeille)
+static bool debounced(const gpio_irq_event_t *ev) {
+    uint32_t current_time = (uint32_t)(ev->timestamp_us / 1000);
     if (current_time - last_button_time < DEBOUNCE_MS) {
-        return;
+        return false;
     }
     last_button_time = current_time;
+    return true;
+}
 
-    if (gpio == BUTTON2) {
-        // Vasen nappi = lisää symboli
-        if (system_state == IDLE) {
-            system_state = RECORDING;
-        }
-
-        if (system_state == RECORDING && message_index < MESSAGE_BUFFER_SIZE - 4) {
-            switch (current_tilt) {
-                case TILT_LEFT:
-                    message_buffer[message_index] = '.';
-                    message_index++;
-                    break;
-                case TILT_MIDDLE:
-                    message_buffer[message_index] = ' ';
-                    message_index++;
-                    break;
-                case TILT_RIGHT:
-                    message_buffer[message_index] = '-';
-                    message_index++;
-                    break;
-                default:
-                    break;
-            }
-            message_buffer[message_index] = '\0';
-        }
+// Vasen nappi = lisää symboli
+static void button2_handler(const gpio_irq_event_t *ev, void *ctx) {
+    (void)ctx;
+    if (!debounced(ev)) {
         return;
     }
 
-    if (gpio == BUTTON1) {
-        if (system_state == RECORDING) {
-            // Oikea nappi = lähetä viesti
-            if (message_index > 0 && message_index < MESSAGE_BUFFER_SIZE - 3) {
-                message_buffer[message_index] = ' ';
+    if (system_state == IDLE) {
+        system_state = RECORDING;
+    }
+
+    if (system_state == RECORDING && message_index < MESSAGE_BUFFER_SIZE - 4) {
+        switch (current_tilt) {
+            case TILT_LEFT:
+                message_buffer[message_index] = '.';
                 message_index++;
+                break;
+            case TILT_MIDDLE:
                 message_buffer[message_index] = ' ';
                 message_index++;
-                message_buffer[message_index] = '\n';
+                break;
+            case TILT_RIGHT:
+                message_buffer[message_index] = '-';
                 message_index++;
-                message_buffer[message_index] = '\0';
-                
-                system_state = SENDING;
-            } else {
-                // Tyhjä viesti tai buffer täynnä - peru
-                message_index = 0;
-                message_buffer[0] = '\0';
-                system_state = IDLE;
-            }
+                break;
+            default:
+                break;
+        }
+        message_buffer[message_index] = '\0';
+    }
+}
+
+// Oikea nappi = lähetä viesti
+static void button1_handler(const gpio_irq_event_t *ev, void *ctx) {
+    (void)ctx;
+    if (!debounced(ev)) {
+        return;
+    }
+
+    if (system_state == RECORDING) {
+        // Oikea nappi = lähetä viesti
+        if (message_index > 0 && message_index < MESSAGE_BUFFER_SIZE - 3) {
+            message_buffer[message_index] = ' ';
+            message_index++;
+            message_buffer[message_index] = ' ';
+            message_index++;
+            message_buffer[message_index] = '\n';
+            message_index++;
+            message_buffer[message_index] = '\0';
+            
+            system_state = SENDING;
+        } else {
+            // Tyhjä viesti tai buffer täynnä - peru
+            message_index = 0;
+            message_buffer[0] = '\0';
+            system_state = IDLE;
         }
     }
 }
@@ -153,31 +171,62 @@ static void imu_task(void *pvParameters) {
                     current_tilt = TILT_MIDDLE;
                 }
             }
+            // Näytön viivästetyt päivitykset, kirkkaus ja sammutus samalla I2C-vuorolla
+            display_sched_service();
         }
         vTaskDelay(pdMS_TO_TICKS(50));
     }
 }
 
+static uint32_t now_ms(void) {
+    return to_ms_since_boot(get_absolute_time());
+}
+
+// Tiiviin muodon kehykset ovat binääriä: ei CR/LF-muunnosta
+static bool wire_write(void *ctx, const uint8_t *frame, size_t len) {
+    (void)ctx;
+    stdio_put_string((const char *)frame, (int)len, false, false);
+    stdio_flush();
+    return true;
+}
+
+// Valmis viesti (kumpi tahansa muoto) näytölle. Kesken olevan näytön aikana viesti jää pois kuten ennenkin.
+static void wire_message(void *ctx, const char *symbols, size_t len) {
+    (void)ctx;
+    if (system_state != IDLE && system_state != RECEIVING) {
+        return;
+    }
+    if (len > RECEIVED_BUFFER_SIZE - 1) {
+        len = RECEIVED_BUFFER_SIZE - 1;
+    }
+    memcpy(received_buffer, symbols, len);
+    received_index = len;
+    received_buffer[received_index] = '\0';
+    system_state = DISPLAY_UPDATE;
+}
+
 static void receiver_task(void *pvParameters) {
+    uint8_t buf[64];
     while(1) {
-        int ch = getchar_timeout_us(0);
-
-        if (ch != PICO_ERROR_TIMEOUT) {
-            if (system_state == IDLE || system_state == RECEIVING) {
-                system_state = RECEIVING;
-
-                // Jos viesti valmis, näytä se
-                if (ch == '\n') {
-                    system_state = DISPLAY_UPDATE;
-                } else if (received_index < RECEIVED_BUFFER_SIZE - 1) {
-                    // Muuten lisää merkki bufferiin
-                    received_buffer[received_index] = (char)ch;
-                    received_index++;
-                    received_buffer[received_index] = '\0';
-                }
-            }
+        // Luetaan kaikki saapunut kerralla, ei yhtä merkkiä per herätys
+        size_t n = 0;
+        int ch;
+        while (n < sizeof(buf) && (ch = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT) {
+            buf[n++] = (uint8_t)ch;
+        }
+
+        xSemaphoreTake(wire_lock, portMAX_DELAY);
+        morse_wire_feed(&wire, buf, n, now_ms());
+        morse_wire_poll(&wire, now_ms());
+        // Viesti kesken: ei aloiteta nauhoitusta
+        if (system_state == IDLE && wire.msg_len > 0) {
+            system_state = RECEIVING;
+        }
+        xSemaphoreGive(wire_lock);
+
+        if (n < sizeof(buf)) {
+            vTaskDelay(pdMS_TO_TICKS(10));
         }
-        vTaskDelay(pdMS_TO_TICKS(10));
     }
 }
 
@@ -225,7 +274,16 @@ static void display_task(void *pvParameters) {
 static void sender_task(void *pvParameters) {
     while (1) {
         if (system_state == SENDING) {
-            printf("%s", message_buffer);
+            xSemaphoreTake(wire_lock, portMAX_DELAY);
+            bool compact = morse_wire_peer_compact(&wire);
+            if (compact) {
+                // Ilman loppumerkkiä "  \n", tiivis muoto merkitsee viestin lopun itse
+                morse_wire_send(&wire, message_buffer, message_index - 3, now_ms());
+            }
+            xSemaphoreGive(wire_lock);
+            if (!compact) {
+                printf("%s", message_buffer);
+            }
             
             message_index = 0;
             message_buffer[0] = '\0';
@@ -247,10 +305,8 @@ static void sender_task(void *pvParameters) {
 int main() {
     stdio_init_all();
     
-    // odotetaan että USB on yhdistetty
-    while (!stdio_usb_connected()) {
-        sleep_ms(100);
-    }
+    // ei odoteta USB:tä: tulosteet puskuroidaan ja toistetaan kun terminaali avataan
+    early_log_init(true);
     
     printf("Starting...\n");
     
@@ -261,6 +317,11 @@ int main() {
     clear_display();
     write_text("LCD is OK");
 
+    // Näyttö päivitetään vain kun sisältö muuttuu, kirkkaus valoisuuden mukaan
+    init_veml6030();
+    display_sched_config_t display_cfg = DISPLAY_SCHED_DEFAULT_CONFIG;
+    display_sched_start(&display_cfg);
+
     // alusta buzzer
     init_buzzer();
 
@@ -269,14 +330,21 @@ int main() {
     message_index = 0;
     received_buffer[0] = '\0';
     received_index = 0;
+
+    // alusta sarjayhteys
+    morse_wire_config_t wire_cfg = MORSE_WIRE_DEFAULT_CONFIG;
+    wire_cfg.write = wire_write;
+    wire_cfg.on_message = wire_message;
+    morse_wire_init(&wire, &wire_cfg);
+    wire_lock = xSemaphoreCreateMutex();
     
     // alusta napit
     init_button1();
     init_button2();
     
-    // Rekisteröi interrupt molemille napeille
-    gpio_set_irq_enabled_with_callback(BUTTON1, GPIO_IRQ_EDGE_FALL, true, button_handler);
-    gpio_set_irq_enabled(BUTTON2, GPIO_IRQ_EDGE_FALL, true);
+    // Rekisteröi oma interrupt handler kummallekin napille
+    gpio_irq_register(BUTTON1, GPIO_IRQ_EDGE_FALL, button1_handler, NULL, false);
+    gpio_irq_register(BUTTON2, GPIO_IRQ_EDGE_FALL, button2_handler, NULL, false);
     
     // IMU taski
     TaskHandle_t hIMUTask = NULL;
@@ -0,0 +1,196 @@
+/*
+ * SRAM bank contention benchmark.
+ *
+ * Runs the microphone pipeline while the rest of the chip loads the SRAM
+ * banks, and reports worst-case interrupt and decimation times:
+ *
+ *  - core 1 copies 16 KB blocks back and forth (like a busy application task),
+ *  - two chained DMA channels stream memory to memory without pause
+ *    (like display / USB traffic),
+ *  - a 1 kHz timer interrupt on core 0 runs a small filter over a window
+ *    and measures its own entry latency and execution time,
+ *  - a core 0 task decimates each PDM block (get_microphone_samples) and
+ *    measures how long it takes.
+ *
+ * Build once with TKJHAT_BANKED_SRAM=OFF and once with ON (see
+ * CMakeLists.txt) and compare the reports printed every 5 s on USB stdio.
+ * Each report ends with the DMA channel owners and their busy time
+ * (tkjhat/hw_res.h), sampled by a short timer interrupt every 997 us.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <pico/stdlib.h>
+#include <hardware/dma.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <tkjhat/sdk.h>
+#include <tkjhat/hw_res.h>
+#include <tkjhat/sram.h>
+
+#define HAMMER_WORDS        4096            // 16 KB per block
+#define DMA_RING_BITS       12              // 4 KB rings
+#define DMA_WORDS           ((1u << DMA_RING_BITS) / 4)
+#define TIMER_PERIOD_US     1000
+#define FILTER_TAPS         64
+#define REPORT_MS           5000
+#define BUSY_SAMPLE_US      997             // not a multiple of the 1 ms timer
+
+typedef struct {
+    uint32_t max_us;
+    uint64_t sum_us;
+    uint32_t count;
+} stat_t;
+
+static void stat_add(stat_t *s, uint32_t us) {
+    if (us > s->max_us) s->max_us = us;
+    s->sum_us += us;
+    s->count++;
+}
+
+/* =========================
+ *  Background load
+ * ========================= */
+// Application data in the shared banks
+static uint32_t hammer_a[HAMMER_WORDS];
+static uint32_t hammer_b[HAMMER_WORDS];
+
+// Memory-to-memory DMA streams
+static uint32_t dma_src[DMA_WORDS] __attribute__((aligned(1u << DMA_RING_BITS)));
+static uint32_t dma_dst[DMA_WORDS] __attribute__((aligned(1u << DMA_RING_BITS)));
+static uint32_t dma_word;
+
+static void hammer_task(void *arg) {
+    (void)arg;
+    for (uint32_t i = 0;; i++) {
+        memcpy(hammer_b, hammer_a, sizeof(hammer_a));
+        memcpy(hammer_a, hammer_b, sizeof(hammer_b));
+        if ((i & 63) == 0) vTaskDelay(1);   // let core 1 run its other tasks
+    }
+}
+
+// Two channels triggering each other forever: A fills dma_dst, B drains dma_src
+static void start_dma_load(void) {
+    int a = hw_res_dma_claim("load_a");
+    int b = hw_res_dma_claim("load_b");
+    if (a < 0 || b < 0) return;
+
+    dma_channel_config ca = dma_channel_get_default_config(a);
+    channel_config_set_transfer_data_size(&ca, DMA_SIZE_32);
+    channel_config_set_read_increment(&ca, false);
+    channel_config_set_write_increment(&ca, true);
+    channel_config_set_ring(&ca, true, DMA_RING_BITS);
+    channel_config_set_chain_to(&ca, b);
+    dma_channel_configure(a, &ca, dma_dst, &dma_word, DMA_WORDS, false);
+
+    dma_channel_config cb = dma_channel_get_default_config(b);
+    channel_config_set_transfer_data_size(&cb, DMA_SIZE_32);
+    channel_config_set_read_increment(&cb, true);
+    channel_config_set_write_increment(&cb, false);
+    channel_config_set_ring(&cb, false, DMA_RING_BITS);
+    channel_config_set_chain_to(&cb, a);
+    dma_channel_configure(b, &cb, &dma_word, dma_src, DMA_WORDS, false);
+
+    dma_channel_start(a);
+}
+
+/* =========================
+ *  Measured work
+ * ========================= */
+// Hot data of core 0: the interrupt's window and the decimated block
+static int16_t isr_window[FILTER_TAPS] TKJHAT_CORE0_DATA;
+static int16_t pcm[MEMS_BUFFER_SIZE] TKJHAT_CORE0_DATA;
+
+static volatile uint32_t timer_expected_us;
+static volatile int32_t isr_sink;
+static stat_t isr_latency, isr_exec, decim;
+static TaskHandle_t mic_task_handle;
+
+static bool timer_cb(repeating_timer_t *rt) {
+    (void)rt;
+    uint32_t entry = time_us_32();
+    stat_add(&isr_latency, entry - timer_expected_us);
+    timer_expected_us += TIMER_PERIOD_US;
+
+    int32_t acc = 0;
+    for (int i = 0; i < FILTER_TAPS; i++) {
+        acc += isr_window[i] * (i + 1);
+        isr_window[i] = (int16_t)(isr_window[(i + 1) % FILTER_TAPS] ^ acc);
+    }
+    isr_sink = acc;
+
+    stat_add(&isr_exec, time_us_32() - entry);
+    return true;
+}
+
+static void on_samples_ready(void) {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(mic_task_handle, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+static void mic_task(void *arg) {
+    (void)arg;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        uint32_t t0 = time_us_32();
+        get_microphone_samples(pcm, MEMS_BUFFER_SIZE);
+        stat_add(&decim, time_us_32() - t0);
+    }
+}
+
+static void report_task(void *arg) {
+    (void)arg;
+    static repeating_timer_t timer;
+    static char text[768];
+    timer_expected_us = time_us_32() + TIMER_PERIOD_US;
+    add_repeating_timer_us(-TIMER_PERIOD_US, timer_cb, NULL, &timer);
+
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(REPORT_MS));
+
+        // Snapshot and restart the window
+        taskENTER_CRITICAL();
+        stat_t lat = isr_latency, exe = isr_exec, dec = decim;
+        memset(&isr_latency, 0, sizeof(isr_latency));
+        memset(&isr_exec, 0, sizeof(isr_exec));
+        memset(&decim, 0, sizeof(decim));
+        taskEXIT_CRITICAL();
+
+        printf("[sram] layout %-7s | isr latency max %3lu us | isr exec max %3lu avg %3lu us | "
+               "decimation max %4lu avg %4lu us (%lu blocks)\n",
+               sram_banked() ? "banked" : "striped",
+               (unsigned long)lat.max_us,
+               (unsigned long)exe.max_us, (unsigned long)(exe.count ? exe.sum_us / exe.count : 0),
+               (unsigned long)dec.max_us, (unsigned long)(dec.count ? dec.sum_us / dec.count : 0),
+               (unsigned long)dec.count);
+        hw_res_format_report(text, sizeof(text));
+        printf("%s", text);
+    }
+}
+
+int main(void) {
+    stdio_init_all();
+    init_hat_sdk();
+
+    if (init_pdm_microphone() < 0) {
+        printf("PDM microphone initialization failed!\n");
+    }
+    pdm_microphone_set_callback(on_samples_ready);
+
+    // Core 0: the measured work. Core 1: the application load. The small
+    // stacks fit the scratch arenas; the printf stack of the report task
+    // does not and ends up on the heap.
+    sram_task_create_on_core(mic_task, "mic", 192, NULL, 3, 0, &mic_task_handle);
+    sram_task_create_on_core(hammer_task, "hammer", 192, NULL, 1, 1, NULL);
+    sram_task_create_on_core(report_task, "report", 1024, NULL, 2, 0, NULL);
+
+    start_dma_load();
+    init_microphone_sampling();
+    hw_res_monitor_start(BUSY_SAMPLE_US);
+
+    vTaskStartScheduler();
+    return 0;
+}
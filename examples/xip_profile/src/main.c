@@ -0,0 +1,115 @@
+// XIP flash cache profile of interleaved display, microphone and USB work (tkjhat/xip_prof.h).
+//
+// Three paths share the 16 KB XIP cache:
+//
+//   display   redraws a bouncing ball and a counter on the OLED every 40 ms
+//   audio     decimates the PDM blocks signalled by the microphone interrupt
+//   usb       TinyUSB; CDC1 gets the PCM blocks while a terminal has it open
+//
+// CDC0 gets the XIP report every 5 s: hit rate, misses and the estimated
+// stall time per 1 s window. Built with -DTKJHAT_XIP_PROFILE=ON the report
+// also lists the tasks and ISRs with most misses, the candidates to move to
+// SRAM. Opening CDC1 adds the USB path to the mix.
+
+#include <stdio.h>
+#include <pico/stdlib.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <tusb.h>
+#include "usbSerialDebug/helper.h"
+#include <tkjhat/sdk.h>
+#include <tkjhat/xip_prof.h>
+
+#if CFG_TUSB_OS != OPT_OS_FREERTOS
+#error "This should be using FREERTOS but the CFG_TUSB_OS is not OPT_OS_FREERTOS"
+#endif
+
+#define WINDOW_MS               1000
+#define REPORT_EVERY            5       // windows
+#define FRAME_MS                40
+#define BALL_R                  6
+
+// ---- Microphone: the interrupt only wakes the audio task ----
+static int16_t pcm[MEMS_BUFFER_SIZE];
+static TaskHandle_t audio_task_handle;
+
+static void on_mic_block(void) {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(audio_task_handle, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+static void audio_task(void *arg) {
+    (void)arg;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        int n = get_microphone_samples(pcm, MEMS_BUFFER_SIZE);
+        if (n > 0 && tud_cdc_n_connected(1)) {
+            tud_cdc_n_write(1, pcm, (uint32_t)n * sizeof(pcm[0]));
+            tud_cdc_n_write_flush(1);
+        }
+    }
+}
+
+// ---- Display: a ball bouncing around a frame counter ----
+static void display_task(void *arg) {
+    (void)arg;
+    int16_t x = BALL_R, y = BALL_R, dx = 3, dy = 2;
+    char text[16];
+    for (uint32_t frame = 0;; frame++) {
+        clear_display();
+        draw_circle(x, y, BALL_R, true);
+        snprintf(text, sizeof(text), "%lu", (unsigned long)frame);
+        write_text_xy(40, 28, text);
+        x += dx;
+        y += dy;
+        if (x <= BALL_R || x >= 127 - BALL_R) dx = -dx;
+        if (y <= BALL_R || y >= 63 - BALL_R) dy = -dy;
+        vTaskDelay(pdMS_TO_TICKS(FRAME_MS));
+    }
+}
+
+// ---- Task running USB stack ----
+static void usbTask(void *arg) {
+    (void)arg;
+    while (1) {
+        tud_task();              // With FreeRTOS wait for events
+                                 // Do not add vTaskDelay.
+    }
+}
+
+// Input on either CDC is read and dropped
+void tud_cdc_rx_cb(uint8_t itf) {
+    uint8_t buf[64];
+    while (tud_cdc_n_read(itf, buf, sizeof(buf))) {}
+}
+
+int main() {
+    init_hat_sdk();
+    sleep_ms(300); //Wait some time so initialization of USB and hat is done.
+
+    init_display();
+    init_pdm_microphone();
+    pdm_microphone_set_callback(on_mic_block);
+    init_microphone_sampling();
+
+    TaskHandle_t hUsb = NULL;
+    xTaskCreate(usbTask, "usb", 1024, NULL, 3, &hUsb);
+    xTaskCreate(audio_task, "audio", 1024, NULL, 2, &audio_task_handle);
+    xTaskCreate(display_task, "display", 1024, NULL, 1, NULL);
+    #if (configNUMBER_OF_CORES > 1)
+        vTaskCoreAffinitySet(hUsb, 1u << 0);
+    #endif
+    xip_prof_start(WINDOW_MS, REPORT_EVERY, usb_serial_print);
+
+    // VERY IMPORTANT, THIS SHOULD GO JUST BEFORE vTaskStartSheduler
+    // WITHOUT ANY DELAYS. OTHERWISE, THE TinyUSB stack wont recognize
+    // the device.
+    tusb_init();
+    usb_serial_init();
+    vTaskStartScheduler();
+
+    return 0;
+}
@@ -0,0 +1,193 @@
+// Exercises the fixed-point AGC (tkjhat/agc.h) on a synthetic microphone signal.
+//
+// The input is a sequence of steady two-tone segments from -50 dBFS to -3 dBFS
+// over a -70 dBFS noise floor, so that once the gain has settled the remaining
+// error is the quantization of each chain. The decimation
+// filter is modelled by its last step: the signal is multiplied by volume / 64,
+// rounded to int16 and saturated at +-32700, like Open_PDM_Filter_* do.
+//
+// Three chains are compared: a fixed volume (what hello_microphone did before),
+// the AGC applied to the 16-bit samples only, and the AGC feeding its gain back
+// into the filter volume. For every level the output level, the peak and the SNR
+// against the clean signal (least-squares fit over the settled half) are printed,
+// followed by the cost per 256-sample block: host time, host TSC cycles (x86
+// only) and a static estimate for the RP2040, which is not measured here.
+//
+// Usage: bench_agc [timing_blocks]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC 1
+#endif
+
+#include "tkjhat/agc.h"
+
+namespace {
+
+constexpr unsigned kSampleRate = 8000;      // MEMS_SAMPLING_FREQUENCY
+constexpr unsigned kBlock = 256;            // MEMS_BUFFER_SIZE
+constexpr unsigned kBaseVolume = 64;
+constexpr unsigned kFixedVolume = 56;       // the old hand-tuned value
+constexpr size_t kSegment = 96 * kBlock;    // ~3 s per level
+const double kLevelsDb[] = { -50, -40, -30, -20, -10, -3 };
+
+// RP2040 estimate, from the instructions of the two per-sample loops of
+// agc_process on a Cortex-M0+ (single-cycle MUL, 2-cycle loads and taken
+// branches): ~18 cycles each. The per-block part is dominated by the five
+// 64-bit divisions of scale_u32 (software __aeabi_uldivmod, ~150 cycles each).
+constexpr double kM0CyclesPerSample = 36;
+constexpr double kM0CyclesPerBlock = 900;
+constexpr double kSysClkMhz = 125;
+
+// Clean input in "volume 64" units (full scale 32767)
+std::vector<double> make_signal(unsigned seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> noise(0.0, 32767.0 * std::pow(10.0, -70.0 / 20.0));
+    const size_t seg = kSegment;
+    std::vector<double> x;
+    for (double db : kLevelsDb) {
+        double amp = 32767.0 * std::pow(10.0, db / 20.0);
+        for (size_t n = 0; n < seg; n++) {
+            double t = double(n) / kSampleRate;
+            double tone = 0.7 * std::sin(2.0 * M_PI * 220.0 * t) + 0.3 * std::sin(2.0 * M_PI * 660.0 * t + 1.0);
+            x.push_back(amp * tone + noise(rng));
+        }
+    }
+    return x;
+}
+
+// Last step of OpenPDMFilter: Z * volume / div_const, saturated
+int16_t filter_out(double x, unsigned volume) {
+    double z = std::nearbyint(x * volume / kBaseVolume);
+    return int16_t(std::clamp(z, -32700.0, 32700.0));
+}
+
+struct Chain {
+    const char *name;
+    bool use_agc;
+    bool feedback;
+};
+
+struct SegmentResult {
+    double out_dbfs, peak, snr_db;
+};
+
+std::vector<SegmentResult> run_chain(const Chain &c, const std::vector<double> &x, agc_t *agc_out) {
+    agc_t agc;
+    agc_config_t cfg = AGC_DEFAULT_CONFIG;
+    cfg.sample_rate = kSampleRate;
+    cfg.feedback = c.feedback;
+    agc_init(&agc, &cfg);
+
+    std::vector<int16_t> y(x.size());
+    unsigned volume = c.use_agc ? (c.feedback ? agc_volume(&agc) : kBaseVolume) : kFixedVolume;
+    for (size_t off = 0; off + kBlock <= x.size(); off += kBlock) {
+        for (unsigned i = 0; i < kBlock; i++) y[off + i] = filter_out(x[off + i], volume);
+        if (!c.use_agc) continue;
+        agc_process(&agc, &y[off], kBlock, uint16_t(volume));
+        if (c.feedback) volume = agc_volume(&agc);
+    }
+    if (agc_out) *agc_out = agc;
+
+    std::vector<SegmentResult> res;
+    const size_t seg = kSegment;
+    for (size_t s = 0; s < std::size(kLevelsDb); s++) {
+        size_t a = s * seg + seg / 2, b = (s + 1) * seg;
+        double sxy = 0, sxx = 0, syy = 0, peak = 0;
+        for (size_t n = a; n < b; n++) {
+            sxy += x[n] * y[n];
+            sxx += x[n] * x[n];
+            syy += double(y[n]) * y[n];
+            peak = std::max(peak, std::fabs(double(y[n])));
+        }
+        double k = sxy / sxx;
+        double err = 0;
+        for (size_t n = a; n < b; n++) err += (y[n] - k * x[n]) * (y[n] - k * x[n]);
+        double sig = k * k * sxx;
+        double rms = std::sqrt(syy / double(b - a));
+        res.push_back({ 20.0 * std::log10(std::max(rms, 1e-3) / 32767.0), peak,
+                        err > 0 ? 10.0 * std::log10(sig / err) : 99.0 });
+    }
+    return res;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    unsigned timing_blocks = argc > 1 ? unsigned(std::atoi(argv[1])) : 200000;
+    if (timing_blocks == 0) timing_blocks = 1;
+
+    std::vector<double> x = make_signal(42);
+    const Chain chains[] = {
+        { "fixed volume 56", false, false },
+        { "AGC on int16", true, false },
+        { "AGC + volume feedback", true, true },
+    };
+
+    std::printf("%-10s", "input");
+    for (const Chain &c : chains) std::printf(" | %-26s", c.name);
+    std::printf("\n%-10s", "dBFS");
+    for (size_t i = 0; i < std::size(chains); i++) std::printf(" | %8s %7s %8s ", "out dBFS", "peak", "SNR dB");
+    std::printf("\n");
+
+    std::vector<SegmentResult> r[std::size(chains)];
+    agc_t final_state[std::size(chains)];
+    for (size_t i = 0; i < std::size(chains); i++) r[i] = run_chain(chains[i], x, &final_state[i]);
+    for (size_t s = 0; s < std::size(kLevelsDb); s++) {
+        std::printf("%-10.0f", kLevelsDb[s]);
+        for (size_t i = 0; i < std::size(chains); i++)
+            std::printf(" | %8.1f %7.0f %8.1f ", r[i][s].out_dbfs, r[i][s].peak, r[i][s].snr_db);
+        std::printf("\n");
+    }
+    for (size_t i = 1; i < std::size(chains); i++) {
+        const agc_t &a = final_state[i];
+        std::printf("%-22s blocks %u, gated %u, limited %u, clipped samples %u\n", chains[i].name,
+                    a.blocks, a.gated_blocks, a.limited_blocks, a.clipped_samples);
+    }
+
+    // Cost per block, on a block that keeps the gain moving
+    agc_t agc;
+    agc_config_t cfg = AGC_DEFAULT_CONFIG;
+    agc_init(&agc, &cfg);
+    std::vector<int16_t> src(kBlock), buf(kBlock);
+    for (unsigned i = 0; i < kBlock; i++) src[i] = filter_out(x[x.size() / 2 + i], kBaseVolume);
+
+    using clock = std::chrono::steady_clock;
+    uint64_t sink = 0;
+    auto t0 = clock::now();
+#ifdef HAVE_RDTSC
+    uint64_t c0 = __rdtsc();
+#endif
+    for (unsigned b = 0; b < timing_blocks; b++) {
+        std::copy(src.begin(), src.end(), buf.begin());
+        agc_process(&agc, buf.data(), kBlock, kBaseVolume);
+        sink += uint16_t(buf[b % kBlock]);
+    }
+#ifdef HAVE_RDTSC
+    uint64_t c1 = __rdtsc();
+#endif
+    auto t1 = clock::now();
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / timing_blocks;
+
+    std::printf("\nagc_process, %u samples, host:  %.0f ns per block (%.2f ns per sample)", kBlock, ns, ns / kBlock);
+#ifdef HAVE_RDTSC
+    std::printf(", %.0f host TSC cycles per block", double(c1 - c0) / timing_blocks);
+#endif
+    double m0_cycles = kM0CyclesPerBlock + kM0CyclesPerSample * kBlock;
+    double m0_us = m0_cycles / kSysClkMhz;
+    double block_us = 1e6 * kBlock / kSampleRate;
+    std::printf("\nRP2040 estimate (not measured): ~%.0f cycles per block, %.0f us at %.0f MHz, "
+                "%.2f%% of one core at %u Hz",
+                m0_cycles, m0_us, kSysClkMhz, 100.0 * m0_us / block_us, kSampleRate);
+    std::printf("\n(checksum %llu)\n", (unsigned long long)sink);
+    return 0;
+}
@@ -0,0 +1,263 @@
+// IMU air mouse (tkjhat/air_mouse.h) and the latency of its USB HID reports.
+//
+// Mapping: synthetic gyro traces with offset and noise, at the IMU rates the
+// HID task uses. A turn moves the pointer by the configured counts per degree
+// (minus the dead zone), a board lying still does not make it creep once the
+// offset is tracked, a fast flick is split into ±127 reports without losing
+// counts, a slow turn adds up sub-count motion, and tilt drives the gamepad.
+//
+// Latency: the pipeline of usbSerialDebug/hid.c replayed in virtual time. The
+// IMU makes a sample every ODR period, the task reads it in 420 us (14 bytes
+// at 400 kHz) and queues a report if the endpoint is free, and the host reads
+// the endpoint once per 1 ms frame. Compared with the 10 ms polling loop of
+// the IMU examples, and with queueing the merged motion from the completion
+// callback as well (which hid.c does not do: that report then holds the
+// endpoint while fresher samples arrive). Latency is from the sample being
+// ready in the IMU to the host reading the report that carries it.
+// Exits non-zero if a check fails.
+//
+// Usage: bench_air_mouse
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+
+#include <tkjhat/air_mouse.h>
+#include <tkjhat/log_hist.h>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char *what) {
+    std::printf("  %-4s %s\n", ok ? "ok" : "FAIL", what);
+    if (!ok) failures++;
+}
+
+struct Imu {
+    std::mt19937 rng{11};
+    std::normal_distribution<double> noise{0.0, 60.0};     // mdps, LN mode at 800 Hz
+    int32_t bias[3] = {700, -450, 900};                    // mdps, within the ±1 dps of the datasheet
+
+    void sample(const double rate_dps[3], int32_t gyro[3]) {
+        for (int i = 0; i < 3; i++) gyro[i] = static_cast<int32_t>(std::lround(rate_dps[i] * 1000 + bias[i] + noise(rng)));
+    }
+};
+
+struct Sum {
+    long dx = 0, dy = 0, reports = 0;
+};
+
+// Feed samples at @p odr for @p seconds, taking a report every 1 ms
+Sum run(air_mouse_t &m, Imu &imu, unsigned odr, double seconds, double t0, double (*yaw_dps)(double)) {
+    Sum s;
+    const int32_t accel[3] = {0, 0, 1000};
+    uint64_t period = 1000000 / odr, next_poll = static_cast<uint64_t>(t0 * 1e6);
+    for (uint64_t t = static_cast<uint64_t>(t0 * 1e6); t < (t0 + seconds) * 1e6; t += period) {
+        double rate[3] = {0, 0, yaw_dps ? yaw_dps(t / 1e6 - t0) : 0};
+        int32_t gyro[3];
+        imu.sample(rate, gyro);
+        air_mouse_update(&m, t, gyro, accel, 0);
+        for (; next_poll <= t; next_poll += 1000) {
+            air_mouse_report_t r;
+            if (air_mouse_take(&m, &r)) {
+                s.dx += r.dx;
+                s.dy += r.dy;
+                s.reports++;
+            }
+        }
+    }
+    air_mouse_report_t r;
+    while (air_mouse_take(&m, &r)) {
+        s.dx += r.dx;
+        s.dy += r.dy;
+        s.reports++;
+    }
+    return s;
+}
+
+double still(double) { return 0; }
+double turn45(double t) { return t < 0.25 ? 90 * M_PI * std::sin(M_PI * t / 0.25) : 0; }     // 45 deg in 250 ms
+double slow(double) { return 3; }
+double flick(double t) { return t < 0.045 ? 1000 : 0; }     // 5 samples at 100 Hz: 50 ms
+
+void mapping() {
+    std::printf("pointer mapping (20 counts/deg, 1.5 dps dead zone)\n");
+    air_mouse_t m;
+    Imu imu;
+    air_mouse_init(&m, nullptr);
+    run(m, imu, 800, 2.0, 0, still);       // offset tracking settles
+    air_mouse_stats_t st;
+    air_mouse_get_stats(&m, &st);
+    std::printf("  offset estimate %" PRId32 " %" PRId32 " %" PRId32 " mdps (true %d %d %d)\n", st.bias_mdps[0],
+                st.bias_mdps[1], st.bias_mdps[2], imu.bias[0], imu.bias[1], imu.bias[2]);
+    check(std::abs(st.bias_mdps[2] - imu.bias[2]) < 50, "gyro offset tracked while still");
+
+    Sum rest = run(m, imu, 800, 10.0, 2.0, still);
+    std::printf("  10 s still: %ld, %ld counts\n", rest.dx, rest.dy);
+    check(rest.dx == 0 && rest.dy == 0, "no creep while still");
+
+    air_mouse_config_t raw = AIR_MOUSE_DEFAULT_CONFIG;
+    raw.deadzone_mdps = 0;
+    raw.still_mdps = 0;
+    air_mouse_t m0;
+    Imu imu0;
+    air_mouse_init(&m0, &raw);
+    Sum creep = run(m0, imu0, 800, 10.0, 0, still);
+    std::printf("  10 s still without offset tracking and dead zone: %ld, %ld counts\n", creep.dx, creep.dy);
+
+    Sum turn = run(m, imu, 800, 0.5, 12.0, turn45);
+    // Expected: 45 deg minus the dead zone while the rate is above it
+    double lost = 0;
+    for (double t = 0; t < 0.25; t += 1e-5) lost += std::min(turn45(t), 1.5) * 1e-5;
+    long expect = std::lround(-(45 - lost) * 20);
+    std::printf("  45 deg turn: dx %ld (expected %ld), %ld reports\n", turn.dx, expect, turn.reports);
+    check(std::abs(turn.dx - expect) <= 4 && std::abs(turn.dy) <= 1, "turn moves the pointer by counts per degree");
+
+    air_mouse_init(&m, nullptr);
+    run(m, imu, 100, 2.0, 0, still);
+    Sum flk = run(m, imu, 100, 0.2, 2.0, flick);
+    air_mouse_get_stats(&m, &st);
+    long flick_expect = std::lround(-(1000 - 1.5) * 0.05 * 20);
+    std::printf("  50 ms flick at 1000 dps, 100 Hz: dx %ld (expected %ld), %" PRIu32 " reports carried motion\n",
+                flk.dx, flick_expect, st.carried);
+    check(std::abs(flk.dx - flick_expect) <= 2 && st.carried > 0, "fast motion split over reports without loss");
+
+    air_mouse_init(&m, nullptr);
+    run(m, imu, 800, 2.0, 0, still);
+    Sum crawl = run(m, imu, 800, 10.0, 2.0, slow);
+    std::printf("  3 dps for 10 s: dx %ld (expected %d)\n", crawl.dx, -300);
+    check(std::abs(crawl.dx + 300) <= 6, "slow motion below one count per sample adds up");
+
+    air_mouse_config_t pad = AIR_MOUSE_DEFAULT_CONFIG;
+    pad.mode = AIR_MOUSE_GAMEPAD;
+    air_mouse_init(&m, &pad);
+    const int32_t gyro[3] = {0, 0, 0}, tilt[3] = {250, -600, 900};
+    air_mouse_update(&m, 0, gyro, tilt, AIR_MOUSE_BUTTON2);
+    air_mouse_report_t r;
+    bool first = air_mouse_take(&m, &r);
+    air_mouse_update(&m, 1250, gyro, tilt, AIR_MOUSE_BUTTON2);
+    air_mouse_report_t r2;
+    bool again = air_mouse_take(&m, &r2);
+    check(first && r.x == -63 && r.y == 127 && r.buttons == AIR_MOUSE_BUTTON2 && !again,
+          "gamepad: tilt to axes, a report only when something changes");
+}
+
+// ---- Latency ----
+struct Latency {
+    log_hist_t total{};
+    long generated = 0, delivered = 0, reports = 0;
+    uint32_t merged = 0;
+};
+
+// @p odr IMU rate, @p loop_us > 0: a task polling the IMU at that period instead of the data-ready
+// interrupt, @p refill: the completion callback queues the motion merged meanwhile
+Latency pipeline(unsigned odr, uint64_t loop_us, bool refill, double seconds) {
+    const uint64_t read_us = 420, frame_us = 1000, poll_phase = 250, callback_us = 40;
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<int> jitter(-20, 20);
+    Latency L;
+    log_hist_init(&L.total);
+    air_mouse_t m;
+    air_mouse_init(&m, nullptr);
+    air_mouse_config_t cfg = AIR_MOUSE_DEFAULT_CONFIG;
+    cfg.deadzone_mdps = 0;
+    cfg.still_mdps = 0;
+    air_mouse_init(&m, &cfg);
+
+    const uint64_t period = 1000000 / odr, end = static_cast<uint64_t>(seconds * 1e6);
+    const uint64_t imu_phase = 137;
+    // Next read by the task: right after an edge, or on its own timer
+    uint64_t next_read = loop_us ? 4300 : imu_phase + read_us;
+    uint64_t next_poll = poll_phase;
+    bool in_flight = false;
+    uint64_t flight_sample = 0, pending_total = 0, first_sample = 0, last_sample = 0;
+    const int32_t accel[3] = {0, 0, 1000};
+    const int32_t gyro[3] = {0, 0, -75000};         // 75 dps: 1.9 counts per 800 Hz sample
+
+    auto queue = [&](void) {
+        air_mouse_report_t r;
+        if (in_flight || !air_mouse_take(&m, &r)) return;
+        in_flight = true;
+        flight_sample = r.sample_us;
+        pending_total = static_cast<uint64_t>(r.dx);
+        L.reports++;
+    };
+
+    while (next_read < end || next_poll < end) {
+        if (next_read <= next_poll) {
+            uint64_t t = next_read;
+            // Newest sample in the IMU when the read started
+            uint64_t start = t - read_us;
+            uint64_t sample = start < imu_phase ? imu_phase : imu_phase + (start - imu_phase) / period * period;
+            if (!first_sample) first_sample = sample;
+            last_sample = sample;
+            air_mouse_update(&m, sample, gyro, accel, 0);
+            queue();
+            next_read = loop_us ? t + loop_us : sample + period + read_us;
+        } else {
+            uint64_t t = next_poll + static_cast<uint64_t>(jitter(rng));
+            if (in_flight) {
+                in_flight = false;
+                L.delivered += static_cast<long>(pending_total);
+                log_hist_add(&L.total, static_cast<uint32_t>(t + callback_us - flight_sample));
+                if (refill) queue();
+            }
+            next_poll += frame_us;
+        }
+    }
+    // Still in flight or pending at the end
+    if (in_flight) L.delivered += static_cast<long>(pending_total);
+    for (air_mouse_report_t r; air_mouse_take(&m, &r);) L.delivered += r.dx;
+    air_mouse_stats_t st;
+    air_mouse_get_stats(&m, &st);
+    L.merged = st.merged;
+    L.generated = std::lround(75.0 * 20 * (last_sample - first_sample) / 1e6);
+    return L;
+}
+
+void latency() {
+    std::printf("\nmotion to host, 1 ms HID polling (10 s of continuous motion)\n");
+    std::printf("  %-36s %8s %8s %8s %8s %8s\n", "", "reports", "merged", "p50 us", "p99 us", "max us");
+    struct {
+        const char *name;
+        unsigned odr;
+        uint64_t loop_us;
+        bool refill;
+    } cases[] = {
+        {"10 ms loop, 100 Hz IMU", 100, 10000, false},
+        {"data ready, 800 Hz IMU", 800, 0, false},
+        {"data ready, 1600 Hz IMU", 1600, 0, false},
+        {"800 Hz, queued from completion too", 800, 0, true},
+        {"1600 Hz, queued from completion too", 1600, 0, true},
+    };
+    constexpr int N = sizeof(cases) / sizeof(cases[0]);
+    Latency res[N];
+    for (int i = 0; i < N; i++) {
+        res[i] = pipeline(cases[i].odr, cases[i].loop_us, cases[i].refill, 10.0);
+        const Latency &L = res[i];
+        std::printf("  %-36s %8ld %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32 "\n", cases[i].name, L.reports,
+                    L.merged, log_hist_quantile(&L.total, 0.5f), log_hist_quantile(&L.total, 0.99f), L.total.max);
+    }
+    check(log_hist_quantile(&res[1].total, 0.99f) <= 2000, "800 Hz data ready: p99 within two polling intervals");
+    check(log_hist_quantile(&res[1].total, 0.5f) * 4 < log_hist_quantile(&res[0].total, 0.5f),
+          "data ready cuts the median latency of the 10 ms loop by 4x or more");
+    check(log_hist_quantile(&res[2].total, 0.5f) < log_hist_quantile(&res[4].total, 0.5f) &&
+              log_hist_quantile(&res[1].total, 0.5f) <= log_hist_quantile(&res[3].total, 0.5f),
+          "queueing only on new samples is never slower than also queueing from the completion");
+    bool all = true;
+    for (const Latency &L : res) all = all && std::labs(L.delivered - L.generated) <= 2;
+    check(all, "every count of motion reaches the host");
+}
+
+}  // namespace
+
+int main() {
+    mapping();
+    latency();
+    std::printf("\n%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,134 @@
+// Exercises the EWMA anomaly detector on synthetic sensor streams.
+//
+// Each stream is Gaussian noise around a slowly drifting baseline (like lux
+// over a day or |a| of a board on a desk) with injected events: short knocks,
+// shadows (z-score check) and fast ramps (rate-of-change check). The bench reports, per stream, how many events were
+// detected, the detection delay and the false alarms in the quiet parts, and
+// checks that a lasting level shift stops alarming once the baseline adapts.
+//
+// Usage: bench_anomaly [samples]
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include <tkjhat/anomaly.h>
+
+namespace {
+
+struct Event {
+    size_t at;
+    size_t len;
+    double amplitude;   // in noise sigmas
+    bool ramp;          // linear ramp instead of a step
+};
+
+struct Result {
+    unsigned detected = 0;
+    double delay_sum = 0.0;
+    unsigned false_alarms = 0;
+};
+
+Result run(const anomaly_config_t &cfg, size_t n, double dt, double sigma,
+           const std::vector<Event> &events, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> noise(0.0, sigma);
+    anomaly_channel_t ch;
+    anomaly_init(&ch, &cfg);
+
+    Result r;
+    size_t e = 0;
+    bool hit = false;
+    for (size_t i = 0; i < n; ++i) {
+        double base = 100.0 + 10.0 * sigma * std::sin(2.0 * M_PI * double(i) / double(n));
+        double x = base + noise(rng);
+        bool in_event = e < events.size() && i >= events[e].at && i < events[e].at + events[e].len;
+        if (in_event) {
+            const Event &ev = events[e];
+            double k = ev.ramp ? double(i - ev.at + 1) / double(ev.len) : 1.0;
+            x += ev.amplitude * sigma * k;
+        }
+        uint8_t flags = anomaly_update(&ch, float(x), float(dt));
+        if (in_event) {
+            if (flags && !hit) {
+                hit = true;
+                r.detected++;
+                r.delay_sum += double(i - events[e].at);
+            }
+        } else {
+            // Count alarms outside events, with a grace period after each one
+            bool grace = e > 0 && i < events[e - 1].at + events[e - 1].len + 50;
+            if (flags && !grace) r.false_alarms++;
+        }
+        if (e < events.size() && i + 1 == events[e].at + events[e].len) {
+            e++;
+            hit = false;
+        }
+    }
+    return r;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    size_t n = argc > 1 ? size_t(std::atol(argv[1])) : 200000;
+    if (n < 20000) n = 20000;
+
+    int failures = 0;
+
+    // Knocks and shadows: short steps of 8..12 sigma
+    std::vector<Event> steps;
+    for (size_t at = 5000; at + 100 < n; at += 5000) steps.push_back({at, 5, (at / 5000) % 2 ? 8.0 : -12.0, false});
+
+    anomaly_config_t zcfg = ANOMALY_DEFAULT_CONFIG;
+    zcfg.z_threshold = 5.0f;
+    Result rs = run(zcfg, n, 0.01, 1.0, steps, 1);
+
+    // Fast ramps: 10 sigma per sample for 6 samples, caught by the rate check
+    std::vector<Event> ramps;
+    for (size_t at = 5000; at + 100 < n; at += 5000) ramps.push_back({at, 6, 60.0, true});
+    anomaly_config_t rcfg = zcfg;
+    rcfg.z_threshold = 0.0f;                        // rate check only
+    rcfg.rate_threshold = 7.0f / 0.01f;             // 7 sigma per sample
+    Result rr = run(rcfg, n, 0.01, 1.0, ramps, 2);
+
+    std::printf("steps:  %u/%zu detected, mean delay %.2f samples, %u false alarms in %zu samples\n",
+                rs.detected, steps.size(), rs.detected ? rs.delay_sum / rs.detected : 0.0,
+                rs.false_alarms, n);
+    std::printf("ramps:  %u/%zu detected, mean delay %.2f samples, %u false alarms in %zu samples\n",
+                rr.detected, ramps.size(), rr.detected ? rr.delay_sum / rr.detected : 0.0,
+                rr.false_alarms, n);
+
+    if (rs.detected != steps.size() || rr.detected != ramps.size()) {
+        std::printf("FAIL: missed events\n");
+        ++failures;
+    }
+    // 5 sigma on Gaussian noise: ~6e-7 per sample, allow a few for the EWMA estimate
+    if (rs.false_alarms > n / 20000 || rr.false_alarms > n / 20000) {
+        std::printf("FAIL: too many false alarms\n");
+        ++failures;
+    }
+
+    // A lasting level shift alarms at most max_freeze samples, then becomes normal
+    anomaly_channel_t ch;
+    anomaly_init(&ch, &zcfg);
+    std::mt19937 rng(3);
+    std::normal_distribution<double> noise(0.0, 1.0);
+    unsigned alarms_after = 0;
+    for (int i = 0; i < 4000; ++i) {
+        double x = (i < 1000 ? 0.0 : 50.0) + noise(rng);
+        uint8_t f = anomaly_update(&ch, float(x), 0.01f);
+        if (i >= 1000 + 2 * zcfg.max_freeze + 200 && f) alarms_after++;
+    }
+    std::printf("shift:  %u alarms after the baseline adapted (mean %.1f)\n", alarms_after, ch.mean);
+    if (alarms_after > 2 || std::fabs(ch.mean - 50.0f) > 1.0f) {
+        std::printf("FAIL: baseline does not follow a level shift\n");
+        ++failures;
+    }
+
+    std::printf("%s\n", failures ? "FAILED" : "PASS");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,310 @@
+// Measures the fixed-point noise suppressor (tkjhat/denoise.h).
+//
+// The clean signal is synthetic speech: voiced syllables (a gliding 100-220 Hz
+// pulse train shaped by three moving formants) with short fricatives and pauses,
+// at about -24 dBFS while active. It is mixed with a noise at 0, 5, 10 and 20 dB
+// SNR and run through denoise_process in 256-sample blocks (MEMS_BUFFER_SIZE),
+// like hello_microphone does. The output, realigned by DENOISE_DELAY, is compared
+// with the clean signal after the first second (time for the noise floor
+// estimate to settle):
+//
+//   SNR in / out / improvement    10 log(clean^2 / error^2) before and after
+//   noise                         attenuation of the noise alone
+//
+// Two synthetic noises are always measured: white hiss and a hiss rising with
+// frequency, like the decimated PDM noise. Every file given on the command line
+// is read as raw s16le mono at 8 kHz (what examples/hello_microphone/tools/
+// record_audio.sh stores) and measured twice: as the noise in the mix, and on its
+// own, where the level of its quietest 10 % of 32 ms frames (the floor between
+// sounds) is compared before and after.
+//
+// The cost per frame (one hop of DENOISE_HOP samples) is reported in ns and TSC
+// cycles; a hop lasts 16 ms at 8 kHz, i.e. 2 M cycles of one RP2040 core at
+// 125 MHz. The bench fails if the synthetic noises are not improved by at least
+// 4 dB at 0..10 dB SNR or clean speech is distorted below 20 dB SNR.
+//
+// Usage: bench_denoise [clip.raw ...]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC 1
+#endif
+
+#include "tkjhat/denoise.h"
+
+namespace {
+
+constexpr unsigned kSampleRate = 8000;      // MEMS_SAMPLING_FREQUENCY
+constexpr unsigned kBlock = 256;            // MEMS_BUFFER_SIZE
+constexpr size_t kLength = 20 * kSampleRate;
+constexpr size_t kSettle = kSampleRate;
+constexpr double kSpeechDbfs = -24.0;
+const double kSnrDb[] = { 0, 5, 10, 20 };
+constexpr double kMinImprovementDb = 4.0;   // at 0..10 dB input SNR
+constexpr double kMinCleanSnrDb = 20.0;
+
+std::vector<double> make_speech(unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    std::normal_distribution<double> g(0.0, 1.0);
+    std::vector<double> x(kLength, 0.0);
+
+    size_t n = 0;
+    while (n < kLength) {
+        size_t len = size_t((0.12 + 0.2 * u(rng)) * kSampleRate);
+        double kind = u(rng);
+        if (kind < 0.25) {                                  // pause
+            n += len;
+            continue;
+        }
+        if (kind < 0.4) {                                   // fricative: 2.5-3.8 kHz noise
+            len /= 2;
+            double y1 = 0, y2 = 0;
+            const double r = 0.95, w = 2 * M_PI * (2500 + 1300 * u(rng)) / kSampleRate;
+            for (size_t i = 0; i < len && n + i < kLength; i++) {
+                double env = std::sin(M_PI * double(i) / double(len));
+                double y = g(rng) + 2 * r * std::cos(w) * y1 - r * r * y2;
+                y2 = y1; y1 = y;
+                x[n + i] = 0.08 * env * y;
+            }
+            n += len;
+            continue;
+        }
+        // voiced: pulse train through three resonators with gliding parameters
+        double f0a = 100 + 120 * u(rng), f0b = 100 + 120 * u(rng);
+        double fa[3] = { 300 + 500 * u(rng), 900 + 1300 * u(rng), 2300 + 700 * u(rng) };
+        double fb[3] = { 300 + 500 * u(rng), 900 + 1300 * u(rng), 2300 + 700 * u(rng) };
+        double st[3][2] = {};
+        double phase = 0;
+        for (size_t i = 0; i < len && n + i < kLength; i++) {
+            double a = double(i) / double(len);
+            double env = std::sin(M_PI * a);
+            phase += (f0a + (f0b - f0a) * a) / kSampleRate;
+            double src = 0;
+            if (phase >= 1.0) { phase -= 1.0; src = 1.0; }
+            double y = 0;
+            for (int f = 0; f < 3; f++) {
+                double fr = fa[f] + (fb[f] - fa[f]) * a;
+                double r = 0.97, w = 2 * M_PI * fr / kSampleRate;
+                double v = src + 2 * r * std::cos(w) * st[f][0] - r * r * st[f][1];
+                st[f][1] = st[f][0]; st[f][0] = v;
+                y += v / (f + 1);
+            }
+            x[n + i] = env * y;
+        }
+        n += len;
+    }
+
+    // Scale the active parts to kSpeechDbfs
+    double e = 0; size_t active = 0;
+    for (double v : x) if (v != 0.0) { e += v * v; active++; }
+    double k = 32767.0 * std::pow(10.0, kSpeechDbfs / 20.0) / std::sqrt(e / double(active ? active : 1));
+    for (double &v : x) v *= k;
+    return x;
+}
+
+std::vector<double> make_white(unsigned seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> g(0.0, 1.0);
+    std::vector<double> v(kLength);
+    for (double &s : v) s = g(rng);
+    return v;
+}
+
+// Hiss rising with frequency: mostly first difference of white noise
+std::vector<double> make_pdm_hiss(unsigned seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> g(0.0, 1.0);
+    std::vector<double> v(kLength);
+    double prev = 0;
+    for (double &s : v) { double w = g(rng); s = 0.3 * w + (w - prev); prev = w; }
+    return v;
+}
+
+bool load_clip(const char *path, std::vector<double> &out) {
+    FILE *f = std::fopen(path, "rb");
+    if (!f) return false;
+    std::vector<double> v;
+    int16_t buf[1024];
+    size_t got;
+    while ((got = std::fread(buf, sizeof(buf[0]), 1024, f)) > 0)
+        for (size_t i = 0; i < got; i++) v.push_back(buf[i]);
+    std::fclose(f);
+    if (v.size() < kSampleRate) return false;
+    out = std::move(v);
+    return true;
+}
+
+double power(const std::vector<double> &v, size_t from, size_t to) {
+    double e = 0;
+    for (size_t i = from; i < to; i++) e += v[i] * v[i];
+    return e / double(to > from ? to - from : 1);
+}
+
+int16_t to_pcm(double v) {
+    return int16_t(std::clamp(std::nearbyint(v), -32768.0, 32767.0));
+}
+
+// Runs the suppressor in kBlock blocks and returns the realigned output
+std::vector<double> run(const std::vector<int16_t> &in) {
+    denoise_t dn;
+    denoise_config_t cfg = DENOISE_DEFAULT_CONFIG;
+    cfg.sample_rate = kSampleRate;
+    denoise_init(&dn, &cfg);
+    std::vector<int16_t> buf(in);
+    buf.resize(in.size() + DENOISE_DELAY, 0);
+    for (size_t i = 0; i < buf.size(); i += kBlock)
+        denoise_process(&dn, &buf[i], std::min<size_t>(kBlock, buf.size() - i));
+    return std::vector<double>(buf.begin() + DENOISE_DELAY, buf.end());
+}
+
+struct MixResult {
+    double snr_in, snr_out, noise_db;
+};
+
+MixResult run_mix(const std::vector<double> &speech, const std::vector<double> &noise_src, double snr_db) {
+    std::vector<double> noise(kLength);
+    for (size_t i = 0; i < kLength; i++) noise[i] = noise_src[i % noise_src.size()];
+    double ps = 0; size_t active = 0;
+    for (double v : speech) if (v != 0.0) { ps += v * v; active++; }
+    ps /= double(active);
+    double k = std::sqrt(ps / power(noise, 0, kLength) * std::pow(10.0, -snr_db / 10.0));
+
+    std::vector<int16_t> mix(kLength), noise_only(kLength);
+    std::vector<double> clean(kLength);
+    for (size_t i = 0; i < kLength; i++) {
+        mix[i] = to_pcm(speech[i] + k * noise[i]);
+        noise_only[i] = to_pcm(k * noise[i]);
+        clean[i] = speech[i];
+    }
+    std::vector<double> out = run(mix), nout = run(noise_only);
+
+    double es = 0, ein = 0, eout = 0;
+    for (size_t i = kSettle; i < kLength; i++) {
+        es += clean[i] * clean[i];
+        ein += (mix[i] - clean[i]) * (mix[i] - clean[i]);
+        eout += (out[i] - clean[i]) * (out[i] - clean[i]);
+    }
+    double nin = 0, nres = 0;
+    for (size_t i = kSettle; i < kLength; i++) { nin += double(noise_only[i]) * noise_only[i]; nres += nout[i] * nout[i]; }
+    return { 10 * std::log10(es / ein), 10 * std::log10(es / std::max(eout, 1e-9)),
+             10 * std::log10(std::max(nres, 1e-9) / nin) };
+}
+
+// Level of the quietest 10 % of 32 ms frames, in dBFS
+double floor_dbfs(const std::vector<double> &v) {
+    const size_t frame = 256;
+    std::vector<double> p;
+    for (size_t i = kSettle; i + frame <= v.size(); i += frame) p.push_back(power(v, i, i + frame));
+    if (p.empty()) return -200;
+    std::sort(p.begin(), p.end());
+    double e = 0;
+    size_t cnt = std::max<size_t>(1, p.size() / 10);
+    for (size_t i = 0; i < cnt; i++) e += p[i];
+    return 10 * std::log10(std::max(e / double(cnt), 1e-3) / (32767.0 * 32767.0));
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    std::vector<double> speech = make_speech(7);
+    struct Noise { std::string name; std::vector<double> v; bool synthetic; };
+    std::vector<Noise> noises = {
+        { "white hiss", make_white(11), true },
+        { "PDM-like hiss", make_pdm_hiss(12), true },
+    };
+    for (int a = 1; a < argc; a++) {
+        std::vector<double> v;
+        if (!load_clip(argv[a], v)) {
+            std::fprintf(stderr, "%s: cannot read, or shorter than 1 s\n", argv[a]);
+            return 2;
+        }
+        noises.push_back({ argv[a], std::move(v), false });
+    }
+
+    bool ok = true;
+    std::printf("%-28s %8s %8s %8s %8s %8s\n", "noise", "SNR in", "SNR out", "improve", "noise", "");
+    for (const Noise &nz : noises) {
+        for (double snr : kSnrDb) {
+            MixResult r = run_mix(speech, nz.v, snr);
+            double imp = r.snr_out - r.snr_in;
+            bool bad = nz.synthetic && snr <= 10 && imp < kMinImprovementDb;
+            ok = ok && !bad;
+            std::printf("%-28.28s %8.1f %8.1f %8.1f %8.1f %8s\n", nz.name.c_str(), r.snr_in, r.snr_out, imp,
+                        r.noise_db, bad ? "FAIL" : "");
+        }
+    }
+
+    // Clean speech must go through almost untouched
+    {
+        std::vector<int16_t> in(kLength);
+        for (size_t i = 0; i < kLength; i++) in[i] = to_pcm(speech[i]);
+        std::vector<double> out = run(in);
+        double es = 0, ee = 0;
+        for (size_t i = kSettle; i < kLength; i++) { es += double(in[i]) * in[i]; ee += (out[i] - in[i]) * (out[i] - in[i]); }
+        double snr = 10 * std::log10(es / std::max(ee, 1e-9));
+        bool bad = snr < kMinCleanSnrDb;
+        ok = ok && !bad;
+        std::printf("%-28s %8s %8.1f %8s %8s %8s\n", "clean speech", "-", snr, "", "", bad ? "FAIL" : "");
+    }
+
+    // Recorded clips on their own: floor between sounds before and after
+    for (const Noise &nz : noises) {
+        if (nz.synthetic) continue;
+        std::vector<int16_t> in(nz.v.size());
+        std::vector<double> din(nz.v.size());
+        for (size_t i = 0; i < in.size(); i++) { in[i] = to_pcm(nz.v[i]); din[i] = in[i]; }
+        std::vector<double> out = run(in);
+        double fi = floor_dbfs(din), fo = floor_dbfs(out);
+        std::printf("%-28.28s floor %.1f dBFS -> %.1f dBFS (%.1f dB)\n", nz.name.c_str(), fi, fo, fo - fi);
+    }
+
+    // Cost per frame on the white noise mix
+    std::vector<int16_t> src(kLength);
+    {
+        std::vector<double> w = make_white(3);
+        for (size_t i = 0; i < kLength; i++) src[i] = to_pcm(speech[i] + 300 * w[i]);
+    }
+    denoise_t dn;
+    denoise_config_t cfg = DENOISE_DEFAULT_CONFIG;
+    denoise_init(&dn, &cfg);
+    std::vector<int16_t> buf(kBlock);
+    uint64_t sink = 0;
+    const unsigned passes = 4;
+    using clock = std::chrono::steady_clock;
+    auto t0 = clock::now();
+#ifdef HAVE_RDTSC
+    uint64_t c0 = __rdtsc();
+#endif
+    for (unsigned p = 0; p < passes; p++) {
+        for (size_t i = 0; i + kBlock <= kLength; i += kBlock) {
+            std::copy(src.begin() + long(i), src.begin() + long(i + kBlock), buf.begin());
+            denoise_process(&dn, buf.data(), kBlock);
+            sink += uint16_t(buf[i / kBlock % kBlock]);
+        }
+    }
+#ifdef HAVE_RDTSC
+    uint64_t c1 = __rdtsc();
+#endif
+    auto t1 = clock::now();
+    double frames = dn.frames;
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / frames;
+    std::printf("\ndenoise_process, hop %u samples: %.0f ns per frame", DENOISE_HOP, ns);
+#ifdef HAVE_RDTSC
+    std::printf(", %.0f TSC cycles per frame", double(c1 - c0) / frames);
+#endif
+    std::printf("\nreal-time budget per frame at %u Hz: %.0f us (%.0f cycles at 125 MHz)\n", kSampleRate,
+                1e6 * DENOISE_HOP / kSampleRate, 125e6 * DENOISE_HOP / kSampleRate);
+    std::printf("(checksum %llu)\n%s\n", (unsigned long long)sink, ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
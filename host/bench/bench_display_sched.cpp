@@ -0,0 +1,273 @@
+// Refresh and power scheduling of the OLED panel (tkjhat/display_sched.h).
+//
+// Replays the drawing patterns of the examples in virtual time, once sending
+// every ssd1306_show() to the panel (what the SDK does without the scheduler)
+// and once through the scheduler, driven like the SDK glue does it:
+// display_sched_service() every 50 ms and the deferred flush during the
+// 800 ms pause of write_text(). A flush costs 23 ms of I2C (1 KB at 400 kHz).
+//
+// Checked for every workload: the panel ends up showing the last frame drawn,
+// and no change waits longer than the period plus one service interval.
+// A noisy light trace around a contrast threshold is run with and without
+// hysteresis. Exits non-zero if a check fails.
+//
+// Usage: bench_display_sched
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <tkjhat/display_sched.h>
+
+namespace {
+
+constexpr uint64_t kFlushUs = 23000;
+constexpr uint64_t kServiceUs = 50000;
+constexpr uint32_t kBlank = 0x1000;     // hashes stand for frame contents
+
+// Application timeline: draw calls and pauses, separated by idle gaps
+struct Step {
+    uint64_t gap_us;
+    enum { show, pause, service } kind;
+    uint32_t value;         // frame hash or pause in ms
+};
+
+struct Result {
+    uint64_t requests = 0, flushes = 0, skipped = 0, coalesced = 0, power_downs = 0;
+    uint64_t bus_us = 0, on_us = 0, elapsed_us = 0, max_wait_us = 0;
+    bool final_ok = true;
+};
+
+class Panel {
+public:
+    Panel(bool scheduled, const display_sched_config_t &cfg) : scheduled_(scheduled) {
+        display_sched_init(&s_, &cfg, 0);
+    }
+
+    void run(const std::vector<Step> &steps) {
+        for (const Step &st : steps) {
+            advance(t_ + st.gap_us);
+            if (st.kind == Step::show) show(st.value);
+            else if (st.kind == Step::pause) pause(st.value);
+            else if (scheduled_) service();
+        }
+        advance(t_ + 120'000'000);      // let the pending frame and the power-down happen
+    }
+
+    Result result() const {
+        Result r;
+        if (scheduled_) {
+            display_sched_stats_t st;
+            display_sched_get_stats(&s_, t_, &st);
+            r.requests = st.requests;
+            r.flushes = st.flushes;
+            r.skipped = st.skipped;
+            r.coalesced = st.coalesced;
+            r.power_downs = st.power_downs;
+            r.bus_us = st.bus_us;
+            r.on_us = st.on_us;
+        } else {
+            r.requests = r.flushes = requests_;
+            r.bus_us = requests_ * kFlushUs;
+            r.on_us = t_;
+        }
+        r.elapsed_us = t_;
+        r.max_wait_us = max_wait_us_;
+        r.final_ok = shown_ == drawn_;
+        return r;
+    }
+
+private:
+    void show(uint32_t hash) {
+        requests_++;
+        drawn_ = hash;
+        if (hash == shown_) {
+            waiting_ = false;
+        } else if (!waiting_) {
+            waiting_ = true;
+            changed_at_ = t_;
+        }
+        if (!scheduled_) {
+            flush();
+            return;
+        }
+        if (display_sched_request(&s_, hash, t_) & DISPLAY_SCHED_FLUSH) flush();
+    }
+
+    // write_text(): 800 ms during which a deferred frame is sent when its slot comes
+    void pause(uint32_t ms) {
+        uint64_t end = t_ + ms * 1000ull;
+        while (scheduled_) {
+            int64_t due = display_sched_due_us(&s_, t_);
+            if (due < 0 || t_ + static_cast<uint64_t>(due) >= end) break;
+            t_ += static_cast<uint64_t>(due);
+            service();
+        }
+        advance(end);
+    }
+
+    void advance(uint64_t to) {
+        while (next_service_ <= to) {
+            t_ = std::max(t_, next_service_);
+            next_service_ += kServiceUs;
+            if (scheduled_) service();
+        }
+        t_ = std::max(t_, to);
+    }
+
+    void service() {
+        unsigned a = display_sched_poll(&s_, t_);
+        if (a & DISPLAY_SCHED_FLUSH) flush();
+        if (a & DISPLAY_SCHED_READ_LIGHT) display_sched_light(&s_, 100);
+    }
+
+    void flush() {
+        t_ += kFlushUs;
+        shown_ = drawn_;
+        if (scheduled_) display_sched_flushed(&s_, drawn_, t_, kFlushUs);
+        if (waiting_) {
+            max_wait_us_ = std::max(max_wait_us_, t_ - changed_at_);
+            waiting_ = false;
+        }
+    }
+
+    const bool scheduled_;
+    display_sched_t s_{};
+    uint64_t t_ = 0, next_service_ = kServiceUs;
+    uint64_t requests_ = 0;
+    uint32_t drawn_ = kBlank, shown_ = kBlank;
+    bool waiting_ = false;
+    uint64_t changed_at_ = 0, max_wait_us_ = 0;
+};
+
+void add_show(std::vector<Step> &v, uint64_t gap_ms, uint32_t hash) { v.push_back({gap_ms * 1000, Step::show, hash}); }
+void add_pause(std::vector<Step> &v, uint32_t ms) { v.push_back({0, Step::pause, ms}); }
+void add_service(std::vector<Step> &v) { v.push_back({0, Step::service, 0}); }
+
+// main_project: a received message is shown (clear + write_text), cleared after a
+// while; messages come in bursts separated by a few idle minutes
+std::vector<Step> messages() {
+    std::vector<Step> v;
+    uint32_t msg = 1;
+    for (int burst = 0; burst < 4; burst++) {
+        for (int i = 0; i < 5; i++) {
+            add_show(v, i == 0 ? 180000 : 15000, kBlank);
+            add_show(v, 0, 0x2000 + msg++);
+            add_pause(v, 800);
+            add_show(v, 1300, kBlank);
+        }
+    }
+    return v;
+}
+
+// hello_hat style loop: clear and redraw a clock every 100 ms, the text changes once per second
+std::vector<Step> clock_redraw() {
+    std::vector<Step> v;
+    for (int i = 0; i < 6000; i++) {
+        add_show(v, i ? 100 : 0, kBlank);
+        add_show(v, 0, 0x3000 + i / 10);
+    }
+    return v;
+}
+
+// 10 s of a 60 fps animation, drawn shape by shape (3 shows per frame) with
+// display_sched_service() after each frame, then the last frame redrawn for 50 s
+std::vector<Step> animation() {
+    std::vector<Step> v;
+    for (int f = 0; f < 3600; f++) {
+        uint32_t frame = f < 600 ? 0x4000 + f : 0x4000 + 599;
+        add_show(v, f ? 16 : 0, kBlank);
+        add_show(v, 0, frame ^ 0x10000);
+        add_show(v, 0, frame);
+        add_service(v);
+    }
+    return v;
+}
+
+// Ambient light hovering around the 50 lux threshold, one reading per second for an hour
+unsigned contrast_changes(uint8_t hysteresis_pct) {
+    display_sched_config_t cfg = DISPLAY_SCHED_DEFAULT_CONFIG;
+    cfg.hysteresis_pct = hysteresis_pct;
+    display_sched_t s;
+    display_sched_init(&s, &cfg, 0);
+    std::mt19937 rng(7);
+    std::normal_distribution<double> noise(0.0, 4.0);
+    double level = 50.0;
+    for (int i = 0; i < 3600; i++) {
+        level += noise(rng) * 0.2;
+        level = std::clamp(level, 40.0, 60.0);
+        double lux = std::max(0.0, level + noise(rng));
+        display_sched_light(&s, static_cast<uint32_t>(lux));
+    }
+    display_sched_stats_t st;
+    display_sched_get_stats(&s, 0, &st);
+    // The first reading moves the contrast down from the initial 255 once
+    return st.contrast_changes;
+}
+
+// Contrast steps reached by steady readings
+bool contrast_steps() {
+    struct { uint32_t lux; uint8_t contrast; } cases[] = {{0, 16}, {3, 16}, {20, 64}, {200, 160}, {5000, 255}, {2, 16}};
+    display_sched_t s;
+    display_sched_init(&s, nullptr, 0);
+    bool ok = true;
+    for (auto c : cases) {
+        display_sched_light(&s, c.lux);
+        display_sched_stats_t st;
+        display_sched_get_stats(&s, 0, &st);
+        if (st.contrast != c.contrast) {
+            std::printf("  lux %" PRIu32 ": contrast %u, expected %u\n", c.lux, st.contrast, c.contrast);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+int failures = 0;
+
+void check(bool ok, const char *what) {
+    std::printf("  %-4s %s\n", ok ? "ok" : "FAIL", what);
+    if (!ok) failures++;
+}
+
+void report(const char *name, const std::vector<Step> &steps) {
+    display_sched_config_t cfg = DISPLAY_SCHED_DEFAULT_CONFIG;
+    Panel plain(false, cfg), sched(true, cfg);
+    plain.run(steps);
+    sched.run(steps);
+    Result p = plain.result(), s = sched.result();
+
+    std::printf("\n%s (%.0f s)\n", name, s.elapsed_us / 1e6);
+    std::printf("  %-10s %8s %8s %8s %9s %9s %7s %9s\n", "", "frames", "flushes", "skipped", "coalesced",
+                "i2c ms/s", "on %", "max wait");
+    for (auto [label, r] : {std::pair<const char *, const Result &>{"every", p}, {"scheduled", s}}) {
+        std::printf("  %-10s %8" PRIu64 " %8" PRIu64 " %8" PRIu64 " %9" PRIu64 " %9.1f %7.1f %7.1f ms\n", label,
+                    r.requests, r.flushes, r.skipped, r.coalesced, r.bus_us * 1000.0 / r.elapsed_us,
+                    r.on_us * 100.0 / r.elapsed_us, r.max_wait_us / 1000.0);
+    }
+    check(s.final_ok, "panel shows the last frame drawn");
+    check(s.flushes < p.flushes, "fewer flushes than sending every frame");
+    check(s.max_wait_us <= (cfg.max_period_ms + cfg.settle_ms) * 1000ull + kServiceUs + 2 * kFlushUs,
+          "no change waits longer than a period + one service interval");
+}
+
+}  // namespace
+
+int main() {
+    report("messages (main_project)", messages());
+    report("clock redrawn every 100 ms", clock_redraw());
+    report("animation, then static", animation());
+
+    unsigned with = contrast_changes(25), without = contrast_changes(0);
+    std::printf("\ncontrast, light hovering around 50 lux for 1 h\n");
+    std::printf("  changes with 25 %% hysteresis %u, without %u\n", with, without);
+    check(contrast_steps(), "contrast steps follow the lux table");
+    check(with <= 12, "hysteresis keeps the contrast steady (one change per 5 min at most)");
+    check(without > 10 * with, "hysteresis removes most changes");
+
+    std::printf("\n%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,93 @@
+// Cost and compression of the OLED mirroring delta codec (tkjhat/fb_delta.h).
+//
+// Renders a synthetic UI sequence into a 128x64 SSD1306 framebuffer (a ticking
+// counter, a scrolling bar graph, occasional full-screen clears and inverted
+// screens), encodes every frame against the previous one, decodes it again and
+// checks the reconstruction. Reports bytes per record and encode time per frame,
+// i.e. what display mirroring adds to every ssd1306_show().
+//
+// Usage: bench_fb_delta [frames]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <tkjhat/fb_delta.h>
+
+namespace {
+
+constexpr unsigned kW = 128, kH = 64, kSize = kW * kH / 8;
+
+void pixel(uint8_t *fb, unsigned x, unsigned y, bool on) {
+    if (x >= kW || y >= kH) return;
+    uint8_t bit = static_cast<uint8_t>(1u << (y & 7));
+    if (on) fb[x + kW * (y >> 3)] |= bit;
+    else fb[x + kW * (y >> 3)] &= static_cast<uint8_t>(~bit);
+}
+
+// 3x5 digits, enough to change a few bytes per frame like a text update
+void digit(uint8_t *fb, unsigned x, unsigned y, unsigned d, unsigned scale) {
+    static const uint16_t font[10] = {0x7B6F, 0x2492, 0x73E7, 0x73CF, 0x5BC9, 0x79CF, 0x79EF, 0x7249, 0x7BEF, 0x7BCF};
+    for (unsigned r = 0; r < 5; r++)
+        for (unsigned c = 0; c < 3; c++) {
+            bool on = font[d] & (1u << (14 - (r * 3 + c)));
+            for (unsigned sy = 0; sy < scale; sy++)
+                for (unsigned sx = 0; sx < scale; sx++) pixel(fb, x + c * scale + sx, y + r * scale + sy, on);
+        }
+}
+
+void render(uint8_t *fb, unsigned frame, std::mt19937 &rng, std::vector<unsigned> &bars) {
+    if (frame % 200 == 0) std::memset(fb, 0, kSize);                 // screen change
+    if (frame % 200 == 100) std::memset(fb, 0xFF, kSize);            // splash / inverted
+    unsigned v = frame;
+    for (int i = 4; i >= 0; i--, v /= 10) digit(fb, 4 + i * 16, 4, v % 10, 4);   // big counter
+    if (frame % 4 == 0) {                                              // bar graph scrolls
+        bars.erase(bars.begin());
+        bars.push_back(rng() % 30);
+        for (unsigned x = 0; x < kW; x++)
+            for (unsigned y = 32; y < 64; y++) pixel(fb, x, y, 63 - y < bars[x]);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    unsigned frames = argc > 1 ? static_cast<unsigned>(std::strtoul(argv[1], nullptr, 0)) : 20000;
+    std::mt19937 rng(1);
+    std::vector<unsigned> bars(kW, 0);
+    std::vector<uint8_t> prev(kSize, 0), cur(kSize, 0), rebuilt(kSize, 0);
+    std::vector<uint8_t> ops(FB_DELTA_MAX_OPS);
+
+    uint64_t total_bytes = 0, max_bytes = 0, mismatches = 0, unchanged = 0;
+    double total_ns = 0, max_ns = 0;
+
+    for (unsigned f = 0; f < frames; f++) {
+        render(cur.data(), f, rng, bars);
+
+        auto t0 = std::chrono::steady_clock::now();
+        size_t n = fb_delta_encode(f == 0 ? nullptr : prev.data(), cur.data(), kSize, ops.data());
+        auto t1 = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        total_ns += ns;
+        max_ns = std::max(max_ns, ns);
+
+        if (n == 0) unchanged++;
+        total_bytes += n + FB_MIRROR_OVERHEAD;
+        max_bytes = std::max<uint64_t>(max_bytes, n + FB_MIRROR_OVERHEAD);
+
+        if (fb_delta_apply(rebuilt.data(), kSize, ops.data(), n) != 0 || rebuilt != cur) mismatches++;
+        prev = cur;
+    }
+
+    std::printf("frames=%u unchanged=%llu mismatches=%llu\n", frames,
+                static_cast<unsigned long long>(unchanged), static_cast<unsigned long long>(mismatches));
+    std::printf("record bytes: avg %.1f max %llu (raw frame %u)\n", static_cast<double>(total_bytes) / frames,
+                static_cast<unsigned long long>(max_bytes), kSize);
+    std::printf("encode: avg %.0f ns max %.0f ns per frame\n", total_ns / frames, max_ns);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,114 @@
+// Compares the 8-bit and the 32-bit PDM capture paths of the microphone driver.
+//
+// A synthetic PDM bitstream (first order sigma-delta of a tone plus noise) is packed
+// twice: as bytes, like the 8-bit PIO program pushes them, and as 32-bit words, like
+// the autopush program does (oldest bit in bit 31). Both are decoded with the same
+// OpenPDMFilter settings the driver uses and the PCM outputs are compared sample by
+// sample. The FIFO/DMA transfer counts per block and the decode time are reported.
+//
+// Usage: bench_pdm_capture [blocks]
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "OpenPDMFilter.h"
+
+namespace {
+
+constexpr unsigned kSampleRate = 8000;      // MEMS_SAMPLING_FREQUENCY
+constexpr unsigned kBlockSamples = 256;     // MEMS_BUFFER_SIZE
+constexpr unsigned kDecimation = 64;        // PDM_DECIMATION
+constexpr unsigned kBlockBits = kBlockSamples * kDecimation;
+constexpr uint16_t kVolume = 64;
+
+void init_filter(TPDMFilter_InitStruct &f) {
+    f = TPDMFilter_InitStruct{};
+    f.Fs = kSampleRate;
+    f.LP_HZ = kSampleRate / 2;
+    f.HP_HZ = 10;
+    f.In_MicChannels = 1;
+    f.Out_MicChannels = 1;
+    f.Decimation = kDecimation;
+    f.MaxVolume = 64;
+    Open_PDM_Filter_Init(&f);
+}
+
+// First order sigma-delta modulator producing one bit per PDM clock.
+std::vector<uint8_t> make_pdm_bits(size_t nbits, unsigned seed) {
+    std::vector<uint8_t> bits(nbits);
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> noise(0.0, 0.02);
+    const double fpdm = double(kSampleRate) * kDecimation;
+    double integrator = 0.0;
+    for (size_t n = 0; n < nbits; ++n) {
+        double t = double(n) / fpdm;
+        double x = 0.4 * std::sin(2.0 * M_PI * 440.0 * t) +
+                   0.2 * std::sin(2.0 * M_PI * 1234.0 * t) + noise(rng);
+        integrator += x - (integrator >= 0.0 ? 1.0 : -1.0);
+        bits[n] = integrator >= 0.0 ? 1 : 0;
+    }
+    return bits;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    unsigned blocks = argc > 1 ? unsigned(std::atoi(argv[1])) : 2000;
+    if (blocks == 0) blocks = 1;
+
+    const size_t nbits = size_t(blocks) * kBlockBits;
+    std::vector<uint8_t> bits = make_pdm_bits(nbits, 1234);
+
+    // 8-bit capture: shift left, push every 8 bits -> first bit is the byte MSB.
+    std::vector<uint8_t> bytes(nbits / 8);
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        uint8_t b = 0;
+        for (int k = 0; k < 8; ++k) b = uint8_t((b << 1) | bits[i * 8 + k]);
+        bytes[i] = b;
+    }
+    // 32-bit capture: shift left, autopush every 32 bits -> first bit is bit 31.
+    std::vector<uint32_t> words(nbits / 32);
+    for (size_t i = 0; i < words.size(); ++i) {
+        uint32_t w = 0;
+        for (int k = 0; k < 32; ++k) w = (w << 1) | bits[i * 32 + k];
+        words[i] = w;
+    }
+
+    const unsigned stride = kSampleRate / 1000;
+    std::vector<uint16_t> pcm8(size_t(blocks) * kBlockSamples);
+    std::vector<uint16_t> pcm32(pcm8.size());
+
+    TPDMFilter_InitStruct f8, f32;
+    init_filter(f8);
+    init_filter(f32);
+
+    using clock = std::chrono::steady_clock;
+
+    auto t0 = clock::now();
+    for (size_t s = 0; s < pcm8.size(); s += stride)
+        Open_PDM_Filter_64(&bytes[s * (kDecimation / 8)], &pcm8[s], kVolume, &f8);
+    auto t1 = clock::now();
+    for (size_t s = 0; s < pcm32.size(); s += stride)
+        Open_PDM_Filter_64_W(&words[s * (kDecimation / 32)], &pcm32[s], kVolume, &f32);
+    auto t2 = clock::now();
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < pcm8.size(); ++i)
+        if (pcm8[i] != pcm32[i]) ++mismatches;
+
+    double ns8 = std::chrono::duration<double, std::nano>(t1 - t0).count() / blocks;
+    double ns32 = std::chrono::duration<double, std::nano>(t2 - t1).count() / blocks;
+
+    std::printf("blocks:                    %u x %u samples\n", blocks, kBlockSamples);
+    std::printf("FIFO pushes / DMA xfers:   8-bit %u, 32-bit %u per block\n",
+                kBlockBits / 8, kBlockBits / 32);
+    std::printf("decode time per block:     8-bit %.0f ns, 32-bit %.0f ns\n", ns8, ns32);
+    std::printf("PCM samples compared:      %zu\n", pcm8.size());
+    std::printf("PCM mismatches:            %zu\n", mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
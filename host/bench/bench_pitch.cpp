@@ -0,0 +1,438 @@
+// Measures the fixed-point YIN pitch detector (tkjhat/pitch.h).
+//
+// Synthetic tones from 80 Hz to 1.6 kHz are fed in 256-sample blocks
+// (MEMS_BUFFER_SIZE) at 8 kHz, at -20 dBFS with white noise at 30, 20 and
+// 10 dB SNR, in three shapes:
+//
+//   sine       pure tone
+//   harmonic   sawtooth-like, harmonics at 1/k up to 4 kHz
+//   buzzer     square wave band-limited to 4 kHz (as the PDM decimation
+//              filter leaves it), with the half period rounded to whole
+//              microseconds as buzzer_play_tone() plays it (the reference is
+//              the frequency actually played, not the one requested)
+//
+// For every estimate the error from the true frequency is taken in cents:
+// median and 95th percentile of |error|, voiced rate, and octave errors (more
+// than 600 cents off). A 200 -> 800 Hz glide checks tracking, silence and
+// noise alone check that nothing is reported voiced.
+//
+// The difference function d(tau) kept incrementally by the detector is compared
+// at every estimate with a full recomputation over the window; they must be
+// identical. The cost per estimate (ns and TSC cycles) is reported for
+// pitch_process and for the full recomputation alone, with the number of lags
+// the early-terminating scan examined. An estimate comes every PITCH_HOP
+// samples, 16 ms at 8 kHz, i.e. 2 M cycles of one RP2040 core at 125 MHz.
+//
+// Every file given on the command line is read as raw s16le mono at 8 kHz
+// (what examples/hello_microphone/tools/record_audio.sh stores). Append
+// ":<Hz>" to the name when the clip holds a steady tone of known frequency,
+// e.g. a buzzer recording; it is then measured like the synthetic tones,
+// otherwise only the voiced estimates are listed.
+//
+// Usage: bench_pitch [clip.raw[:Hz] ...]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC 1
+#endif
+
+#include "tkjhat/pitch.h"
+
+namespace {
+
+constexpr unsigned kSampleRate = 8000;      // MEMS_SAMPLING_FREQUENCY
+constexpr unsigned kBlock = 256;            // MEMS_BUFFER_SIZE
+constexpr size_t kToneLength = kSampleRate; // 1 s per tone
+constexpr double kToneDbfs = -20.0;
+const double kSnrDb[] = { 30, 20, 10 };
+
+// Pass criteria
+constexpr double kMinVoiced = 0.95;         // tones at >= 20 dB SNR
+constexpr double kMaxP95Cents = 10.0;       // tones at >= 20 dB SNR
+constexpr double kMaxOctaveErrors = 0.01;
+constexpr double kMaxFalseVoiced = 0.02;    // silence and noise alone
+constexpr double kMinUpdatesPerSecond = 20.0;
+
+enum Shape { sine, harmonic, buzzer };
+const char *const kShapeName[] = { "sine", "harmonic", "buzzer" };
+
+// Frequency buzzer_play_tone(freq) actually plays: two half periods of whole microseconds
+double buzzer_hz(double freq) {
+    uint32_t period_us = uint32_t(1000000 / uint32_t(freq));
+    return 1e6 / (2.0 * (period_us / 2));
+}
+
+std::vector<int16_t> make_tone(Shape shape, double freq, double snr_db, unsigned seed, size_t length) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> g(0.0, 1.0);
+    std::uniform_real_distribution<double> u(0.0, 2 * M_PI);
+    const double amp = 32768.0 * std::pow(10.0, kToneDbfs / 20.0) * std::sqrt(2.0);
+    const double phase0 = u(rng);
+
+    std::vector<double> x(length);
+    double rms = 0;
+    for (size_t n = 0; n < length; n++) {
+        double ph = phase0 + 2 * M_PI * freq * double(n) / kSampleRate;
+        double v = 0;
+        if (shape == sine) {
+            v = std::sin(ph);
+        } else if (shape == harmonic) {
+            for (unsigned k = 1; k * freq < kSampleRate / 2.0; k++) v += std::sin(k * ph) / k;
+        } else {
+            for (unsigned k = 1; k * freq < kSampleRate / 2.0; k += 2) v += std::sin(k * ph) / k;
+        }
+        x[n] = v;
+        rms += v * v;
+    }
+    rms = std::sqrt(rms / double(length));
+    const double noise = amp / std::sqrt(2.0) * std::pow(10.0, -snr_db / 20.0);
+    std::vector<int16_t> out(length);
+    for (size_t n = 0; n < length; n++) {
+        double v = x[n] / rms * amp / std::sqrt(2.0) + noise * g(rng);
+        out[n] = int16_t(std::clamp(std::lround(v), -32768L, 32767L));
+    }
+    return out;
+}
+
+struct Stats {
+    std::vector<double> abs_cents;
+    size_t estimates = 0, voiced = 0, octave = 0;
+
+    void add(const pitch_result_t &r, double truth) {
+        estimates++;
+        if (!r.voiced) return;
+        voiced++;
+        double c = std::fabs(1200.0 * std::log2(r.freq_chz / 100.0 / truth));
+        if (c > 600) octave++;
+        else abs_cents.push_back(c);
+    }
+    void merge(const Stats &o) {
+        abs_cents.insert(abs_cents.end(), o.abs_cents.begin(), o.abs_cents.end());
+        estimates += o.estimates;
+        voiced += o.voiced;
+        octave += o.octave;
+    }
+    double pct(double q) const {
+        if (abs_cents.empty()) return NAN;
+        std::vector<double> v = abs_cents;
+        size_t k = std::min(v.size() - 1, size_t(q * double(v.size())));
+        std::nth_element(v.begin(), v.begin() + long(k), v.end());
+        return v[k];
+    }
+    double voiced_rate() const { return estimates ? double(voiced) / double(estimates) : 0; }
+    double octave_rate() const { return voiced ? double(octave) / double(voiced) : 0; }
+};
+
+// d(tau) over the PITCH_WINDOW samples ending before x[end], recomputed in full
+void reference_diff(const int16_t *x, size_t end, unsigned lags, uint64_t *d) {
+    for (unsigned tau = 1; tau <= lags; tau++) {
+        uint64_t s = 0;
+        for (size_t j = end - PITCH_WINDOW; j < end; j++) {
+            int64_t v = int64_t(x[j]) - x[j - tau];
+            s += uint64_t(v * v);
+        }
+        d[tau - 1] = s;
+    }
+}
+
+int failures = 0;
+
+void check(bool ok, const char *what) {
+    std::printf("  %-4s %s\n", ok ? "ok" : "FAIL", what);
+    if (!ok) failures++;
+}
+
+// Feeds a signal in microphone-sized blocks; calls on_estimate for every estimate
+template <typename F>
+void run(const std::vector<int16_t> &x, F on_estimate) {
+    pitch_t pd;
+    pitch_init(&pd, nullptr);
+    for (size_t i = 0; i < x.size(); i += kBlock) {
+        size_t n = std::min<size_t>(kBlock, x.size() - i);
+        pitch_result_t r;
+        if (pitch_process(&pd, &x[i], n, &r)) on_estimate(r, i + n);
+    }
+}
+
+Stats measure(const std::vector<int16_t> &x, double truth) {
+    Stats s;
+    run(x, [&](const pitch_result_t &r, size_t) { s.add(r, truth); });
+    return s;
+}
+
+std::vector<double> test_frequencies() {
+    std::vector<double> f;
+    for (double v = 80; v < 1650; v *= std::pow(2.0, 1.0 / 4.0)) f.push_back(v);
+    return f;
+}
+
+void tones() {
+    const std::vector<double> freqs = test_frequencies();
+    std::printf("tones %.0f .. %.0f Hz (%zu per shape), 1 s each, %.0f dBFS\n", freqs.front(), freqs.back(),
+                freqs.size(), kToneDbfs);
+    std::printf("  %-9s %5s %8s %11s %10s %8s\n", "shape", "SNR", "voiced", "median |c|", "p95 |c|", "octave");
+    Stats good;
+    unsigned seed = 1;
+    for (Shape shape : { sine, harmonic, buzzer }) {
+        for (double snr : kSnrDb) {
+            Stats all;
+            for (double f : freqs) {
+                double truth = shape == buzzer ? buzzer_hz(f) : f;
+                all.merge(measure(make_tone(shape, truth, snr, seed++, kToneLength), truth));
+            }
+            std::printf("  %-9s %3.0f dB %7.1f%% %9.2f c %8.2f c %7.2f%%\n", kShapeName[shape], snr,
+                        100 * all.voiced_rate(), all.pct(0.5), all.pct(0.95), 100 * all.octave_rate());
+            if (snr >= 20) good.merge(all);
+        }
+    }
+    char what[128];
+    std::snprintf(what, sizeof(what), "voiced >= %.0f %% of estimates at >= 20 dB SNR (%.1f %%)", 100 * kMinVoiced,
+                  100 * good.voiced_rate());
+    check(good.voiced_rate() >= kMinVoiced, what);
+    std::snprintf(what, sizeof(what), "p95 error <= %.0f cents at >= 20 dB SNR (%.2f)", kMaxP95Cents, good.pct(0.95));
+    check(good.pct(0.95) <= kMaxP95Cents, what);
+    std::snprintf(what, sizeof(what), "octave errors <= %.0f %% at >= 20 dB SNR (%.2f %%)", 100 * kMaxOctaveErrors,
+                  100 * good.octave_rate());
+    check(good.octave_rate() <= kMaxOctaveErrors, what);
+}
+
+// Requested vs played vs measured, as a buzzer check on the board would report it
+void buzzer_table() {
+    std::printf("\nbuzzer tones, 30 dB SNR: requested / played / measured (median)\n");
+    bool ok = true;
+    for (double f : { 262.0, 440.0, 523.0, 880.0, 1000.0, 1568.0 }) {
+        double played = buzzer_hz(f);
+        std::vector<double> est;
+        run(make_tone(buzzer, played, 30, unsigned(f), kToneLength), [&](const pitch_result_t &r, size_t) {
+            if (r.voiced) est.push_back(r.freq_chz / 100.0);
+        });
+        if (est.empty()) {
+            ok = false;
+            continue;
+        }
+        std::nth_element(est.begin(), est.begin() + long(est.size() / 2), est.end());
+        double m = est[est.size() / 2];
+        int cents = pitch_cents(uint32_t(std::lround(m * 100)), uint32_t(std::lround(f * 100)));
+        std::printf("  %7.1f Hz  %8.2f Hz  %8.2f Hz  %+4d cents off the request\n", f, played, m, cents);
+        ok = ok && std::fabs(1200 * std::log2(m / played)) < 5;
+    }
+    check(ok, "buzzer tones measured within 5 cents of the frequency played");
+}
+
+void glide() {
+    // 200 -> 800 Hz over 2 s, exponential
+    const size_t len = 2 * kSampleRate;
+    std::mt19937 rng(5);
+    std::normal_distribution<double> g(0.0, 1.0);
+    const double amp = 32768.0 * std::pow(10.0, kToneDbfs / 20.0) * std::sqrt(2.0);
+    std::vector<int16_t> x(len);
+    std::vector<double> inst(len);
+    double ph = 0;
+    for (size_t n = 0; n < len; n++) {
+        inst[n] = 200.0 * std::pow(4.0, double(n) / double(len));
+        ph += 2 * M_PI * inst[n] / kSampleRate;
+        x[n] = int16_t(std::lround(amp * std::sin(ph) + amp * 0.03 * g(rng)));
+    }
+    Stats s;
+    // The window is centred half a window before the last sample
+    run(x, [&](const pitch_result_t &r, size_t end) { s.add(r, inst[end - PITCH_WINDOW / 2]); });
+    std::printf("\nglide 200 -> 800 Hz in 2 s: voiced %.1f %%, median %.2f c, p95 %.2f c\n",
+                100 * s.voiced_rate(), s.pct(0.5), s.pct(0.95));
+    check(s.voiced_rate() >= kMinVoiced && s.pct(0.95) <= 25.0 && s.octave == 0,
+          "glide tracked (voiced >= 95 %, p95 <= 25 cents, no octave error)");
+}
+
+void unvoiced() {
+    std::mt19937 rng(9);
+    std::normal_distribution<double> g(0.0, 1.0);
+    std::vector<int16_t> quiet(4 * kSampleRate), hiss(4 * kSampleRate);
+    for (auto &v : quiet) v = int16_t(std::lround(8 * g(rng)));
+    for (auto &v : hiss) v = int16_t(std::lround(3000 * g(rng)));
+    Stats a = measure(quiet, 1), b = measure(hiss, 1);
+    std::printf("\nunvoiced input: silence %.1f %% voiced, white noise %.1f %% voiced\n", 100 * a.voiced_rate(),
+                100 * b.voiced_rate());
+    check(a.voiced == 0, "silence is never voiced");
+    char what[96];
+    std::snprintf(what, sizeof(what), "white noise voiced in <= %.0f %% of estimates", 100 * kMaxFalseVoiced);
+    check(b.voiced_rate() <= kMaxFalseVoiced, what);
+}
+
+// d(tau) kept by the detector equals the full recomputation at every estimate
+void exactness() {
+    std::vector<int16_t> x = make_tone(harmonic, 123.0, 10, 77, 3 * kSampleRate);
+    for (size_t i = 0; i < x.size(); i += 997) x[i] = i & 1 ? 32767 : -32768;      // full-scale clicks
+    pitch_t pd;
+    pitch_init(&pd, nullptr);
+    unsigned lags = pd.tau_max + 1u;
+    std::vector<uint64_t> ref(lags);
+    size_t compared = 0, mismatches = 0;
+    for (size_t i = 0; i < x.size(); i += 100) {          // odd block size on purpose
+        size_t n = std::min<size_t>(100, x.size() - i);
+        pitch_result_t r;
+        size_t made = pitch_process(&pd, &x[i], n, &r);
+        if (!made) continue;
+        size_t end = (i + n) / PITCH_HOP * PITCH_HOP;     // last estimate ends at a hop boundary
+        reference_diff(x.data(), end, lags, ref.data());
+        compared++;
+        if (std::memcmp(ref.data(), pd.diff, lags * sizeof(uint64_t)) != 0) mismatches++;
+    }
+    std::printf("\nincremental d(tau) vs full recomputation: %zu windows, %zu mismatches\n", compared, mismatches);
+    check(compared > 0 && mismatches == 0, "incremental difference function is exact");
+}
+
+struct Cost {
+    double ns = 0, cycles = 0;
+};
+
+template <typename F>
+Cost time_per(size_t count, F body) {
+    using clock = std::chrono::steady_clock;
+    auto t0 = clock::now();
+#ifdef HAVE_RDTSC
+    uint64_t c0 = __rdtsc();
+#endif
+    body();
+#ifdef HAVE_RDTSC
+    uint64_t c1 = __rdtsc();
+#endif
+    auto t1 = clock::now();
+    Cost c;
+    c.ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / double(count);
+#ifdef HAVE_RDTSC
+    c.cycles = double(c1 - c0) / double(count);
+#endif
+    return c;
+}
+
+void print_cost(const char *what, const Cost &c) {
+    std::printf("  %-32s %9.0f ns", what, c.ns);
+#ifdef HAVE_RDTSC
+    std::printf(" %10.0f TSC cycles", c.cycles);
+#endif
+    std::printf("\n");
+}
+
+void cost() {
+    std::vector<int16_t> x = make_tone(harmonic, 220.0, 30, 3, 10 * kSampleRate);
+    pitch_t pd;
+    pitch_init(&pd, nullptr);
+    const unsigned lags = pd.tau_max + 1u;
+    uint64_t sink = 0, scanned = 0;
+
+    pitch_result_t r{};
+    Cost inc = time_per(x.size() / PITCH_HOP, [&] {
+        for (size_t i = 0; i < x.size(); i += kBlock) {
+            if (pitch_process(&pd, &x[i], kBlock, &r)) {
+                sink += r.freq_chz;
+                scanned += pd.lags_scanned;
+            }
+        }
+    });
+    std::vector<uint64_t> ref(lags);
+    size_t windows = 0;
+    Cost full = time_per((x.size() - PITCH_WINDOW - lags) / PITCH_HOP, [&] {
+        for (size_t end = PITCH_WINDOW + lags; end <= x.size(); end += PITCH_HOP, windows++) {
+            reference_diff(x.data(), end, lags, ref.data());
+            sink += ref[lags / 2];
+        }
+    });
+    pitch_t silent;
+    pitch_init(&silent, nullptr);
+    std::vector<int16_t> zero(x.size(), 0);
+    Cost gated = time_per(x.size() / PITCH_HOP, [&] {
+        for (size_t i = 0; i < zero.size(); i += kBlock) pitch_process(&silent, &zero[i], kBlock, nullptr);
+    });
+
+    const double per_second = double(kSampleRate) / PITCH_HOP;
+    std::printf("\ncost per estimate (one hop of %u samples, window %u, lags %u..%u):\n", PITCH_HOP, PITCH_WINDOW,
+                pd.tau_min, pd.tau_max);
+    print_cost("pitch_process (incremental)", inc);
+    print_cost("d(tau) recomputed over window", full);
+    print_cost("pitch_process, silence", gated);
+    std::printf("  multiply-adds per estimate: %u incremental, %u full window\n", PITCH_HOP * lags,
+                PITCH_WINDOW * lags);
+    std::printf("  lags scanned per estimate: %.1f of %u (early termination)\n",
+                double(scanned) / double(pd.estimates), pd.tau_max - pd.tau_min + 1u);
+    std::printf("  %.1f estimates per second at %u Hz; budget per estimate %.0f us (%.0f cycles at 125 MHz)\n",
+                per_second, kSampleRate, 1e6 * PITCH_HOP / kSampleRate, 125e6 * PITCH_HOP / kSampleRate);
+    std::printf("  (checksum %llu)\n", (unsigned long long)sink);
+    char what[96];
+    std::snprintf(what, sizeof(what), ">= %.0f estimates per second", kMinUpdatesPerSecond);
+    check(per_second >= kMinUpdatesPerSecond, what);
+    check(double(scanned) < double(pd.estimates) * (pd.tau_max - pd.tau_min + 1u),
+          "scan stops early on a voiced signal");
+}
+
+bool load_clip(const std::string &path, std::vector<int16_t> &out) {
+    FILE *f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+    std::vector<int16_t> v;
+    int16_t buf[1024];
+    size_t got;
+    while ((got = std::fread(buf, sizeof(buf[0]), 1024, f)) > 0) v.insert(v.end(), buf, buf + got);
+    std::fclose(f);
+    if (v.size() < PITCH_WINDOW * 2) return false;
+    out = std::move(v);
+    return true;
+}
+
+void clip(const char *arg) {
+    std::string path = arg;
+    double truth = 0;
+    size_t colon = path.rfind(':');
+    if (colon != std::string::npos && colon + 1 < path.size()) {
+        truth = std::atof(path.c_str() + colon + 1);
+        path.resize(colon);
+    }
+    std::vector<int16_t> x;
+    if (!load_clip(path, x)) {
+        std::fprintf(stderr, "%s: cannot read, or too short\n", path.c_str());
+        failures++;
+        return;
+    }
+    std::printf("\n%s (%.1f s)\n", path.c_str(), double(x.size()) / kSampleRate);
+    if (truth > 0) {
+        Stats s = measure(x, truth);
+        std::printf("  expected %.1f Hz: voiced %.1f %%, median %.2f c, p95 %.2f c, octave %.2f %%\n", truth,
+                    100 * s.voiced_rate(), s.pct(0.5), s.pct(0.95), 100 * s.octave_rate());
+        return;
+    }
+    // No reference: list the voiced stretches (note, frequency, confidence)
+    int note = -2;
+    run(x, [&](const pitch_result_t &r, size_t end) {
+        int cents = 0;
+        int n = r.voiced ? pitch_note(r.freq_chz, &cents) : -1;
+        if (n == note) return;
+        if (n >= 0) {
+            std::printf("  %6.2f s  %7.2f Hz  note %3d %+3d c  confidence %.2f\n", double(end) / kSampleRate,
+                        r.freq_chz / 100.0, n, cents, r.confidence / double(PITCH_ONE));
+        }
+        note = n;
+    });
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    tones();
+    buzzer_table();
+    glide();
+    unvoiced();
+    exactness();
+    cost();
+    for (int a = 1; a < argc; a++) clip(argv[a]);
+
+    std::printf("\n%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,212 @@
+// Checks the log-bucketed histogram and the KLL quantile sketch against exact
+// quantiles, and measures their update cost.
+//
+// For several streams (uniform, temperature-like normal, long-tailed latencies,
+// sorted and reverse sorted) the exact rank of every estimated percentile is
+// compared with the requested one. The streams are also split in chunks that are
+// sketched separately, serialized, read back and merged, like telemetry combined
+// on the host; the merged result must stay within the same error.
+//
+// Usage: bench_quantiles [values]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <tkjhat/kll.h>
+#include <tkjhat/log_hist.h>
+
+namespace {
+
+constexpr unsigned kChunks = 8;
+
+int failures = 0;
+
+void check(bool ok, const std::string &what) {
+    if (!ok) {
+        std::printf("FAIL: %s\n", what.c_str());
+        ++failures;
+    }
+}
+
+// Largest |true rank - q| over the percentiles 1..99 of the sketch answers
+template <typename Query>
+double worst_rank_error(const std::vector<float> &sorted, Query query) {
+    double worst = 0.0;
+    for (int p = 1; p < 100; ++p) {
+        double q = p / 100.0;
+        float v = query(float(q));
+        // Any rank in [first >= v, last <= v] is a correct answer for ties
+        double lo = double(std::lower_bound(sorted.begin(), sorted.end(), v) - sorted.begin()) / sorted.size();
+        double hi = double(std::upper_bound(sorted.begin(), sorted.end(), v) - sorted.begin()) / sorted.size();
+        double err = q < lo ? lo - q : (q > hi ? q - hi : 0.0);
+        worst = std::max(worst, err);
+    }
+    return worst;
+}
+
+void test_bins() {
+    std::mt19937 rng(7);
+    for (unsigned sb = 0; sb <= LOG_HIST_MAX_SUB_BITS; ++sb) {
+        unsigned prev = 0;
+        bool ok = true;
+        for (uint32_t v = 0; v < 70000; ++v) {
+            unsigned i = log_hist_index(v, sb);
+            if (i < prev || i > prev + 1) ok = false;
+            if (log_hist_bin_lower(i, sb) > v || log_hist_bin_upper(i, sb) < v) ok = false;
+            prev = i;
+        }
+        for (int n = 0; n < 100000; ++n) {
+            uint32_t v = rng() >> (rng() % 32);
+            unsigned i = log_hist_index(v, sb);
+            if (i >= LOG_HIST_BINS_FOR_U32(sb)) ok = false;
+            if (log_hist_bin_lower(i, sb) > v || log_hist_bin_upper(i, sb) < v) ok = false;
+        }
+        ok = ok && log_hist_index(UINT32_MAX, sb) == LOG_HIST_BINS_FOR_U32(sb) - 1;
+        check(ok, "log_hist bin edges, sub_bits " + std::to_string(sb));
+    }
+}
+
+void test_log_hist(size_t count) {
+    std::mt19937 rng(11);
+    std::lognormal_distribution<double> latency(std::log(800.0), 0.9);
+    std::vector<uint32_t> values(count);
+    for (auto &v : values) v = uint32_t(std::min(latency(rng), 2.0e6));
+
+    log_hist_t whole;
+    log_hist_init(&whole);
+    std::vector<log_hist_t> parts(kChunks);
+    for (auto &h : parts) log_hist_init(&h);
+
+    using clock = std::chrono::steady_clock;
+    auto t0 = clock::now();
+    for (uint32_t v : values) log_hist_add(&whole, v);
+    auto t1 = clock::now();
+    for (size_t i = 0; i < count; ++i) log_hist_add(&parts[i * kChunks / count], values[i]);
+
+    // Telemetry round trip and merge
+    log_hist_t merged;
+    log_hist_init(&merged);
+    size_t bytes = 0;
+    for (auto &h : parts) {
+        uint8_t buf[LOG_HIST_SERIAL_MAX];
+        int n = log_hist_serialize(&h, buf, sizeof(buf));
+        check(n > 0, "log_hist_serialize");
+        check(log_hist_serialize(&h, buf, size_t(n) - 1) < 0, "log_hist_serialize short buffer");
+        log_hist_t back;
+        check(log_hist_deserialize(&back, buf, size_t(n)) == n, "log_hist_deserialize");
+        log_hist_merge(&merged, &back);
+        bytes += size_t(n);
+    }
+    check(std::equal(std::begin(merged.bins), std::end(merged.bins), std::begin(whole.bins)) &&
+              merged.count == whole.count && merged.sum == whole.sum &&
+              merged.min == whole.min && merged.max == whole.max,
+          "log_hist merge of the chunks equals the whole stream");
+
+    // Relative error of the percentiles (half a bin at most)
+    std::vector<uint32_t> sorted = values;
+    std::sort(sorted.begin(), sorted.end());
+    double worst_rel = 0.0;
+    for (int p = 1; p < 100; ++p) {
+        float q = p / 100.0f;
+        uint32_t exact = sorted[size_t(std::ceil(double(q) * count)) - 1];
+        uint32_t est = log_hist_quantile(&merged, q);
+        if (exact >= (1u << LOG_HIST_SUB_BITS))
+            worst_rel = std::max(worst_rel, std::fabs(double(est) - exact) / exact);
+    }
+    const double bound = 0.5 / (1 << LOG_HIST_SUB_BITS);
+    check(log_hist_quantile(&merged, 0.0f) == sorted.front() && log_hist_quantile(&merged, 1.0f) == sorted.back(),
+          "log_hist exact min/max");
+    check(worst_rel <= bound, "log_hist relative error within one bin");
+
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / count;
+    std::printf("log_hist  %2u bins/octave  %6.2f ns/add  worst rel. error %5.2f %% (bound %.1f %%)  "
+                "telemetry %zu B per chunk\n",
+                1u << LOG_HIST_SUB_BITS, ns, 100.0 * worst_rel, 100.0 * bound, bytes / kChunks);
+}
+
+void test_kll(const char *name, std::vector<float> values) {
+    const size_t count = values.size();
+    static kll_sketch_t whole, part, back, merged;
+
+    using clock = std::chrono::steady_clock;
+    kll_init(&whole, 1);
+    auto t0 = clock::now();
+    for (float v : values) kll_update(&whole, v);
+    auto t1 = clock::now();
+
+    kll_init(&merged, 99);
+    size_t bytes = 0;
+    for (unsigned c = 0; c < kChunks; ++c) {
+        kll_init(&part, 100 + c);
+        for (size_t i = c * count / kChunks; i < (c + 1) * count / kChunks; ++i) kll_update(&part, values[i]);
+        std::vector<uint8_t> buf(kll_serialized_size(&part));
+        int n = kll_serialize(&part, buf.data(), buf.size());
+        check(n == int(buf.size()), "kll_serialize");
+        check(kll_deserialize(&back, buf.data(), buf.size(), 200 + c) == n, "kll_deserialize");
+        check(kll_merge(&merged, &back) == 0, "kll_merge");
+        bytes += buf.size();
+    }
+
+    std::sort(values.begin(), values.end());
+    double err_whole = worst_rank_error(values, [](float q) { return kll_quantile(&whole, q); });
+    double err_merged = worst_rank_error(values, [](float q) { return kll_quantile(&merged, q); });
+    double rank_err = std::fabs(kll_rank(&whole, values[count / 2]) - 0.5);
+
+    const double bound = KLL_RANK_ERROR_PCT / 100.0;
+    check(kll_count(&whole) == count && kll_count(&merged) == count, std::string(name) + ": kll count");
+    check(kll_quantile(&merged, 0.0f) == values.front() && kll_quantile(&merged, 1.0f) == values.back(),
+          std::string(name) + ": kll exact min/max");
+    check(err_whole <= bound, std::string(name) + ": kll rank error");
+    check(err_merged <= bound, std::string(name) + ": kll rank error after merge");
+    check(rank_err <= bound, std::string(name) + ": kll_rank of the median");
+    check(kll_retained(&whole) <= KLL_MAX_ITEMS && kll_retained(&merged) <= KLL_MAX_ITEMS,
+          std::string(name) + ": kll memory bound");
+
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / count;
+    std::printf("kll %-10s %6.2f ns/update  rank error %4.2f %% (merged %4.2f %%)  kept %3u items  "
+                "telemetry %zu B per chunk\n",
+                name, ns, 100.0 * err_whole, 100.0 * err_merged, kll_retained(&whole), bytes / kChunks);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? size_t(std::atol(argv[1])) : 1000000;
+    if (count < 1000) count = 1000;
+
+    test_bins();
+    test_log_hist(count);
+
+    std::mt19937 rng(3);
+    std::vector<float> v(count);
+
+    std::uniform_real_distribution<float> uni(0.0f, 1000.0f);
+    for (auto &x : v) x = uni(rng);
+    test_kll("uniform", v);
+
+    std::normal_distribution<float> temp(23.5f, 1.5f);
+    for (auto &x : v) x = std::round(temp(rng) * 100.0f) / 100.0f;  // 0.01 C steps, many ties
+    test_kll("temp", v);
+
+    std::lognormal_distribution<float> lat(6.0f, 1.2f);
+    for (auto &x : v) x = lat(rng);
+    test_kll("latency", v);
+
+    for (size_t i = 0; i < count; ++i) v[i] = float(i);
+    test_kll("sorted", v);
+    std::reverse(v.begin(), v.end());
+    test_kll("reversed", v);
+
+    std::printf("kll sketch size:          %zu bytes (k = %d)\n", sizeof(kll_sketch_t), KLL_K);
+    std::printf("log_hist size:            %zu bytes (%d bins)\n", sizeof(log_hist_t), LOG_HIST_BINS);
+    std::printf("%s\n", failures ? "FAILED" : "PASS");
+    return failures ? 1 : 0;
+}
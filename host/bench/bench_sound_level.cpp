@@ -0,0 +1,270 @@
+// Accuracy check of the fixed-point sound level meter (tkjhat/sound_level.h).
+//
+// Two references are used:
+// - the analog IEC 61672-1 A-weighting curve, for the frequency response of the
+//   digital filter (checked against the class 1 tolerances),
+// - a double-precision replica of the meter (filter built from its z-plane poles
+//   and zeros, same power-of-two time constants), fed with the same int16 samples,
+//   to bound the error added by the fixed-point arithmetic.
+//
+// It also checks level linearity, the Fast/Slow decay rates, Lmax/Lmin of a tone
+// burst and calibration, then times sound_level_process on 256-sample blocks.
+// Exits with 1 if any check fails.
+//
+// Usage: bench_sound_level
+
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "tkjhat/sound_level.h"
+
+namespace {
+
+constexpr double kF1 = 20.598997, kF2 = 107.65265, kF3 = 737.86223, kF4 = 12194.217;
+int failures = 0;
+
+void check(bool ok, const char *what) {
+    if (!ok) {
+        failures++;
+        std::printf("  FAIL: %s\n", what);
+    }
+}
+
+double analog_a_weighting_db(double f) {
+    double f2 = f * f;
+    double ra = kF4 * kF4 * f2 * f2 /
+                ((f2 + kF1 * kF1) * std::sqrt((f2 + kF2 * kF2) * (f2 + kF3 * kF3)) * (f2 + kF4 * kF4));
+    return 20.0 * std::log10(ra) + 2.0;
+}
+
+// IEC 61672-1 class 1 limits (symmetric approximation) at the nominal frequencies
+double class1_tolerance(double f) {
+    if (f < 40) return 1.5;
+    if (f < 900) return 1.0;
+    if (f < 1100) return 0.7;
+    if (f < 5000) return 1.0;
+    return 1.5;
+}
+
+// Double-precision meter: cascade of second-order sections built from poles/zeros
+struct Reference {
+    struct Section { double b[3], a[3], s1 = 0, s2 = 0; };
+    std::vector<Section> sec;
+    double alpha[2];
+    double ms[2] = { 0, 0 };
+
+    Reference(double fs) {
+        double k = 2.0 * fs;
+        auto bil = [k](double f) { double w = 2.0 * M_PI * f; return (k - w) / (k + w); };
+        // 12.2 kHz pair: real double pole matching the analog roll-off at 0.3 fs
+        double fm = 0.3 * fs, target = (kF4 * kF4 + 1e6) / (kF4 * kF4 + fm * fm), lo = 0.0, hi = 0.99;
+        auto lp = [fs](double p, double f) {
+            return std::norm((1.0 - p) / (1.0 - p * std::polar(1.0, -2.0 * M_PI * f / fs)));
+        };
+        for (int i = 0; i < 48; i++) {
+            double m = 0.5 * (lo + hi);
+            (lp(m, fm) / lp(m, 1000.0) > target ? lo : hi) = m;
+        }
+        double p4 = 0.5 * (lo + hi);
+        // zeros at z = 1 (the s^4 of the high-pass part), poles mapped per section
+        const double poles[3][2] = { { bil(kF1), bil(kF1) }, { bil(kF2), bil(kF3) }, { p4, p4 } };
+        for (int i = 0; i < 3; i++) {
+            Section s;
+            if (i < 2) {
+                s.b[0] = 1; s.b[1] = -2; s.b[2] = 1;
+            } else {
+                s.b[0] = 1; s.b[1] = 0; s.b[2] = 0;
+            }
+            s.a[0] = 1;
+            s.a[1] = -(poles[i][0] + poles[i][1]);
+            s.a[2] = poles[i][0] * poles[i][1];
+            sec.push_back(s);
+        }
+        std::complex<double> zi = std::polar(1.0, -2.0 * M_PI * 1000.0 / fs);
+        std::complex<double> h = 1.0;
+        for (const Section &s : sec)
+            h *= (s.b[0] + s.b[1] * zi + s.b[2] * zi * zi) / (s.a[0] + s.a[1] * zi + s.a[2] * zi * zi);
+        for (double &b : sec[2].b) b /= std::abs(h);
+
+        // Same power-of-two time constants as the fixed-point meter
+        for (int w = 0; w < 2; w++) {
+            double samples = (w == 0 ? 0.125 : 1.0) * fs;
+            int shift = 0;
+            while (shift < 24 && (1 << shift) + (1 << shift) / 2 < samples) shift++;
+            alpha[w] = 1.0 / double(1 << shift);
+        }
+    }
+
+    // Returns the squared A-weighted sample and updates the time weighting
+    double step(double x) {
+        for (Section &s : sec) {
+            double y = s.b[0] * x + s.s1;
+            s.s1 = s.b[1] * x - s.a[1] * y + s.s2;
+            s.s2 = s.b[2] * x - s.a[2] * y;
+            x = y;
+        }
+        double e = x * x;
+        for (int w = 0; w < 2; w++) ms[w] += (e - ms[w]) * alpha[w];
+        return e;
+    }
+};
+
+double to_db(double ms) { return 10.0 * std::log10(ms / (32767.0 * 32767.0 / 2.0)); }
+
+std::vector<int16_t> sine(double f, double dbfs, double seconds, double fs, double phase = 0.0) {
+    std::vector<int16_t> v(size_t(seconds * fs));
+    double amp = 32767.0 * std::pow(10.0, dbfs / 20.0);
+    for (size_t n = 0; n < v.size(); n++)
+        v[n] = int16_t(std::lround(amp * std::sin(2.0 * M_PI * f * double(n) / fs + phase)));
+    return v;
+}
+
+struct Capture {
+    std::vector<sound_level_report_t> reports;
+    static void sink(const sound_level_report_t *r, void *ctx) { static_cast<Capture *>(ctx)->reports.push_back(*r); }
+};
+
+// Fixed and reference LAeq of the second half of @p x (the first half settles the filters)
+void leq_pair(const std::vector<int16_t> &x, double fs, double *fixed, double *ref) {
+    sound_level_t sl;
+    Capture cap;
+    sound_level_config_t cfg = SOUND_LEVEL_DEFAULT_CONFIG;
+    cfg.sample_rate = uint32_t(fs);
+    cfg.interval_ms = uint32_t(x.size() / 2 * 1000 / fs);
+    sound_level_init(&sl, &cfg, Capture::sink, &cap);
+    sound_level_process(&sl, x.data(), x.size());
+    *fixed = cap.reports.size() >= 2 ? cap.reports[1].leq_cdb / 100.0 : NAN;
+
+    Reference r(fs);
+    double sum = 0;
+    for (size_t n = 0; n < x.size(); n++) {
+        double e = r.step(double(x[n]));
+        if (n >= x.size() / 2) sum += e;
+    }
+    *ref = to_db(sum / double(x.size() - x.size() / 2));
+}
+
+void frequency_response(double fs) {
+    std::printf("\nfrequency response, fs = %.0f Hz, -20 dBFS tones\n", fs);
+    std::printf("  %8s %9s %9s %9s %7s %9s\n", "f (Hz)", "IEC (dB)", "meter", "dev", "tol", "vs ref");
+    const double freqs[] = { 31.5, 63, 125, 250, 500, 1000, 2000, 3150, 4000, 6300 };
+    for (double f : freqs) {
+        if (f > 0.4 * fs) continue;
+        double fixed, ref;
+        leq_pair(sine(f, -20.0, 4.0, fs), fs, &fixed, &ref);
+        double expect = analog_a_weighting_db(f);
+        double dev = (fixed + 20.0) - expect;
+        std::printf("  %8.1f %9.2f %9.2f %9.2f %7.1f %9.3f\n", f, expect, fixed + 20.0, dev,
+                    class1_tolerance(f), fixed - ref);
+        check(std::fabs(dev) <= class1_tolerance(f), "A-weighting outside class 1 tolerance");
+        check(std::fabs(fixed - ref) <= 0.05, "fixed point differs from the reference by more than 0.05 dB");
+    }
+}
+
+void linearity(double fs) {
+    std::printf("\nlevel linearity, 1 kHz, fs = %.0f Hz\n", fs);
+    std::printf("  %8s %9s %9s %9s\n", "dBFS", "meter", "error", "vs ref");
+    for (int db = 0; db >= -90; db -= 10) {
+        double fixed, ref;
+        leq_pair(sine(1000.0, db, 2.0, fs, 0.3), fs, &fixed, &ref);
+        std::printf("  %8d %9.2f %9.2f %9.3f\n", db, fixed, fixed - db, fixed - ref);
+        if (db >= -70) check(std::fabs(fixed - db) <= 0.1, "level linearity error above 0.1 dB");
+        if (db >= -80) check(std::fabs(fixed - ref) <= 0.05, "fixed point differs from the reference at low level");
+    }
+}
+
+void time_weighting(double fs) {
+    std::printf("\ntime weighting, 1 kHz burst -20 dBFS / 200 ms over -50 dBFS, fs = %.0f Hz\n", fs);
+    std::vector<int16_t> x = sine(1000.0, -50.0, 6.0, fs);
+    std::vector<int16_t> burst = sine(1000.0, -20.0, 0.2, fs);
+    size_t at = size_t(3.0 * fs);
+    for (size_t n = 0; n < burst.size(); n++) x[at + n] = burst[n];
+
+    sound_level_t sl;
+    Capture cap;
+    sound_level_config_t cfg = SOUND_LEVEL_DEFAULT_CONFIG;
+    cfg.sample_rate = uint32_t(fs);
+    cfg.interval_ms = 6000;
+    sound_level_init(&sl, &cfg, Capture::sink, &cap);
+    Reference ref(fs);
+
+    // Decay: level 100 ms and 300 ms after the burst ends
+    size_t t_end = at + burst.size();
+    size_t t_a = t_end + size_t(0.1 * fs), t_b = t_end + size_t(0.3 * fs);
+    double fixed_a[2] = {}, fixed_b[2] = {};
+    double ref_max = 0, ref_min = 1e300;
+    size_t settle = size_t(5 * (ref.alpha[0] > 0 ? 1.0 / ref.alpha[0] : 0));
+    for (size_t n = 0; n < x.size(); n++) {
+        sound_level_process(&sl, &x[n], 1);
+        ref.step(double(x[n]));
+        ref_max = std::max(ref_max, ref.ms[0]);
+        if (n >= settle) ref_min = std::min(ref_min, ref.ms[0]);
+        for (int w = 0; w < 2; w++) {
+            if (n == t_a) fixed_a[w] = sound_level_current(&sl, sound_level_weighting_t(w)) / 100.0;
+            if (n == t_b) fixed_b[w] = sound_level_current(&sl, sound_level_weighting_t(w)) / 100.0;
+        }
+    }
+    double fast_rate = (fixed_a[0] - fixed_b[0]) / 0.2, slow_rate = (fixed_a[1] - fixed_b[1]) / 0.2;
+    std::printf("  decay Fast %.1f dB/s (IEC 34.7 +3.8/-3.7), Slow %.2f dB/s (IEC 4.3 +0.7/-0.8)\n",
+                fast_rate, slow_rate);
+    check(fast_rate >= 31.0 && fast_rate <= 38.5, "Fast decay rate");
+    check(slow_rate >= 3.5 && slow_rate <= 5.0, "Slow decay rate");
+
+    const sound_level_report_t &r = cap.reports.at(0);
+    double burst_expect = -20.0 + 10.0 * std::log10(1.0 - std::exp(-0.2 / (1.0 / (ref.alpha[0] * fs))));
+    std::printf("  LAFmax %.2f (ref %.2f, analytic %.2f), LAFmin %.2f (ref %.2f)\n", r.lmax_cdb / 100.0,
+                to_db(ref_max), burst_expect, r.lmin_cdb / 100.0, to_db(ref_min));
+    check(std::fabs(r.lmax_cdb / 100.0 - to_db(ref_max)) <= 0.05, "LAFmax differs from the reference");
+    check(std::fabs(r.lmin_cdb / 100.0 - to_db(ref_min)) <= 0.05, "LAFmin differs from the reference");
+}
+
+void calibration(double fs) {
+    sound_level_t sl;
+    Capture cap;
+    sound_level_config_t cfg = SOUND_LEVEL_DEFAULT_CONFIG;
+    cfg.sample_rate = uint32_t(fs);
+    cfg.interval_ms = 5000;
+    sound_level_init(&sl, &cfg, Capture::sink, &cap);
+    std::vector<int16_t> tone = sine(1000.0, -26.0, 5.0, fs);
+    sound_level_process(&sl, tone.data(), tone.size());
+    int16_t offset = sound_level_calibrate(&sl, 9400);
+    sound_level_process(&sl, tone.data(), tone.size());
+    double leq = cap.reports.at(1).leq_cdb / 100.0;
+    std::printf("\ncalibration: 94 dB calibrator at -26 dBFS -> offset %.2f dB, next LAeq %.2f dB\n",
+                offset / 100.0, leq);
+    check(std::fabs(leq - 94.0) <= 0.05, "calibrated level");
+}
+
+void timing() {
+    sound_level_t sl;
+    sound_level_config_t cfg = SOUND_LEVEL_DEFAULT_CONFIG;
+    sound_level_init(&sl, &cfg, nullptr, nullptr);
+    std::vector<int16_t> block = sine(440.0, -30.0, 256.0 / 8000.0, 8000.0);
+    const int blocks = 100000;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < blocks; i++) sound_level_process(&sl, block.data(), block.size());
+    auto t1 = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / blocks;
+    uint8_t rec[SOUND_LEVEL_RECORD_SIZE];
+    sound_level_report_t r = {};
+    std::printf("\nsound_level_process: %.0f ns per 256-sample block (%.1f ns per sample)\n", ns, ns / 256.0);
+    std::printf("telemetry: %zu bytes per interval instead of %u bytes/s of PCM\n",
+                sound_level_pack(&r, rec), 8000u * 2u);
+}
+
+}  // namespace
+
+int main() {
+    frequency_response(8000.0);
+    frequency_response(16000.0);
+    linearity(8000.0);
+    time_weighting(8000.0);
+    calibration(8000.0);
+    timing();
+    std::printf("\n%s (%d failed checks)\n", failures ? "FAIL" : "PASS", failures);
+    return failures ? 1 : 0;
+}
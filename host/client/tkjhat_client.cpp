@@ -0,0 +1,375 @@
+// Implementation of tkjhat_client.h. See the header for the threading model.
+
+#include "tkjhat_client.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace tkjhat {
+
+namespace {
+
+constexpr int kPollMs = 20;
+constexpr size_t kReadChunk = 4096;
+
+bool set_raw(int fd) {
+    termios t{};
+    if (tcgetattr(fd, &t) != 0) return false;
+    cfmakeraw(&t);
+    return tcsetattr(fd, TCSANOW, &t) == 0;
+}
+
+// Writes the whole buffer on a non-blocking fd, waiting at most @p timeout_ms for space.
+bool write_all(int fd, const uint8_t *p, size_t n, int timeout_ms) {
+    while (n) {
+        ssize_t w = write(fd, p, n);
+        if (w > 0) {
+            p += w;
+            n -= static_cast<size_t>(w);
+            continue;
+        }
+        if (w < 0 && errno == EINTR) continue;
+        if (w < 0 && errno != EAGAIN) return false;
+        pollfd pf{ fd, POLLOUT, 0 };
+        if (poll(&pf, 1, timeout_ms) <= 0) return false;
+    }
+    return true;
+}
+
+uint32_t get32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+template <typename T>
+uint64_t push_all(std::vector<std::shared_ptr<Subscription<T>>> &subs, const T &v) {
+    uint64_t drops = 0;
+    for (auto &s : subs)
+        if (!s->push(v)) drops++;
+    return drops;
+}
+
+}  // namespace
+
+const char *to_string(Status s) {
+    switch (s) {
+    case Status::ok: return "ok";
+    case Status::unknown_command: return "unknown command";
+    case Status::bad_args: return "bad arguments";
+    case Status::failed: return "failed";
+    case Status::timeout: return "timeout";
+    case Status::disconnected: return "disconnected";
+    }
+    return "?";
+}
+
+Client::Client(std::string path) : Client(std::move(path), Options{}) {}
+
+Client::Client(std::string path, Options opt) : path_(std::move(path)), opt_(opt), rx_buf_(kReadChunk) {
+    link_frame_decoder_init(&dec_);
+}
+
+Client::~Client() { stop(); }
+
+void Client::start() {
+    if (running_.exchange(true)) return;
+    thread_ = std::thread([this] { run(); });
+}
+
+void Client::stop() {
+    if (running_.exchange(false) && thread_.joinable()) thread_.join();
+    for (auto &s : imu_subs_) s->close();
+    for (auto &s : env_subs_) s->close();
+    for (auto &s : light_subs_) s->close();
+    for (auto &s : audio_subs_) s->close();
+}
+
+bool Client::wait_connected(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lk(conn_m_);
+    return conn_cv_.wait_for(lk, timeout, [&] { return connected_.load(); });
+}
+
+std::shared_ptr<Subscription<ImuRecord>> Client::subscribe_imu(size_t depth) {
+    imu_subs_.push_back(std::make_shared<Subscription<ImuRecord>>(depth));
+    return imu_subs_.back();
+}
+
+std::shared_ptr<Subscription<EnvRecord>> Client::subscribe_env(size_t depth) {
+    env_subs_.push_back(std::make_shared<Subscription<EnvRecord>>(depth));
+    return env_subs_.back();
+}
+
+std::shared_ptr<Subscription<LightRecord>> Client::subscribe_light(size_t depth) {
+    light_subs_.push_back(std::make_shared<Subscription<LightRecord>>(depth));
+    return light_subs_.back();
+}
+
+std::shared_ptr<Subscription<AudioPtr>> Client::subscribe_audio(size_t depth) {
+    audio_subs_.push_back(std::make_shared<Subscription<AudioPtr>>(depth));
+    return audio_subs_.back();
+}
+
+Stats Client::stats() const {
+    std::lock_guard<std::mutex> lk(stats_m_);
+    return stats_;
+}
+
+/* ===== commands ===== */
+
+std::future<Response> Client::call(uint8_t cmd, const void *args, size_t len) {
+    std::promise<Response> p;
+    std::future<Response> f = p.get_future();
+    if (len > STREAM_MAX_DATA || (len && !args)) {
+        p.set_value({ Status::bad_args, {} });
+        return f;
+    }
+    if (!connected_) {
+        p.set_value({ Status::disconnected, {} });
+        return f;
+    }
+
+    int id = -1;
+    {
+        std::lock_guard<std::mutex> lk(pend_m_);
+        for (unsigned i = 0; i < 256 && id < 0; i++) {
+            uint8_t cand = static_cast<uint8_t>(next_id_ + i);
+            if (!pending_.count(cand)) id = cand;
+        }
+        if (id < 0) {
+            p.set_value({ Status::failed, {} });
+            return f;
+        }
+        next_id_ = static_cast<uint8_t>(id + 1);
+        pending_[static_cast<uint8_t>(id)] = { std::move(p), std::chrono::steady_clock::now() + opt_.rpc_timeout };
+    }
+    if (!send_request(static_cast<uint8_t>(id), cmd, args, len)) {
+        std::lock_guard<std::mutex> lk(pend_m_);
+        auto it = pending_.find(static_cast<uint8_t>(id));
+        if (it != pending_.end()) {
+            it->second.promise.set_value({ Status::disconnected, {} });
+            pending_.erase(it);
+        }
+    }
+    return f;
+}
+
+std::future<Response> Client::ping(const std::vector<uint8_t> &payload) {
+    return call(STREAM_CMD_PING, payload.data(), payload.size());
+}
+
+std::future<DeviceInfo> Client::info() {
+    return std::async(std::launch::deferred, [f = call(STREAM_CMD_INFO)]() mutable {
+        Response r = f.get();
+        DeviceInfo d;
+        d.status = r.status;
+        if (r.ok() && r.data.size() >= 6) {
+            d.version = r.data[0];
+            d.streams = r.data[1];
+            d.uptime_ms = get32(&r.data[2]);
+            d.name.assign(r.data.begin() + 6, r.data.end());
+        } else if (r.ok()) {
+            d.status = Status::failed;
+        }
+        return d;
+    });
+}
+
+std::future<Response> Client::set_streams(uint8_t mask) {
+    stream_mask_ = mask;
+    return call(STREAM_CMD_SET_STREAMS, &mask, 1);
+}
+
+bool Client::send_request(uint8_t id, uint8_t cmd, const void *args, size_t len) {
+    uint8_t payload[LINK_FRAME_MAX_PAYLOAD];
+    payload[0] = id;
+    payload[1] = cmd;
+    if (len) std::memcpy(&payload[2], args, len);
+    uint8_t frame[LINK_FRAME_MAX_SIZE];
+
+    std::lock_guard<std::mutex> lk(tx_m_);
+    if (fd_ < 0) return false;
+    size_t n = link_frame_encode(STREAM_MSG_REQUEST, tx_seq_++, payload, len + 2, frame, sizeof(frame));
+    return n && write_all(fd_, frame, n, static_cast<int>(opt_.rpc_timeout.count()));
+}
+
+void Client::fail_pending(Status s) {
+    std::lock_guard<std::mutex> lk(pend_m_);
+    for (auto &kv : pending_) kv.second.promise.set_value({ s, {} });
+    pending_.clear();
+}
+
+void Client::expire_pending() {
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lk(pend_m_);
+    for (auto it = pending_.begin(); it != pending_.end();) {
+        if (now >= it->second.deadline) {
+            it->second.promise.set_value({ Status::timeout, {} });
+            it = pending_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+/* ===== reader thread ===== */
+
+bool Client::open_port() {
+    int fd = open(path_.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) return false;
+    if (isatty(fd)) set_raw(fd);
+    {
+        std::lock_guard<std::mutex> lk(tx_m_);
+        fd_ = fd;
+    }
+    link_frame_decoder_init(&dec_);
+    {
+        std::lock_guard<std::mutex> lk(conn_m_);
+        connected_ = true;
+    }
+    conn_cv_.notify_all();
+    return true;
+}
+
+void Client::close_port() {
+    if (fd_ < 0) return;
+    {
+        std::lock_guard<std::mutex> lk(tx_m_);
+        close(fd_);
+        fd_ = -1;
+    }
+    connected_ = false;
+    fail_pending(Status::disconnected);
+    if (conn_cb_) conn_cb_(false);
+}
+
+std::shared_ptr<AudioBlock> Client::acquire_audio() {
+    for (size_t i = 0; i < pool_.size(); i++) {
+        size_t k = (pool_next_ + i) % pool_.size();
+        // Only this thread hands out copies, so a count of 1 cannot go up behind our back
+        if (pool_[k].use_count() == 1) {
+            pool_next_ = k + 1;
+            return pool_[k];
+        }
+    }
+    if (pool_.size() >= opt_.audio_pool) return nullptr;
+    pool_.push_back(std::make_shared<AudioBlock>());
+    return pool_.back();
+}
+
+void Client::dispatch(const link_frame_decoder_t &d) {
+    uint64_t drops = 0;
+    bool bad = false;
+    switch (d.type) {
+    case STREAM_MSG_RESPONSE: {
+        if (d.len < 2) { bad = true; break; }
+        Response r{ static_cast<Status>(static_cast<int8_t>(d.payload[1])),
+                    std::vector<uint8_t>(d.payload + 2, d.payload + d.len) };
+        std::lock_guard<std::mutex> lk(pend_m_);
+        auto it = pending_.find(d.payload[0]);
+        if (it != pending_.end()) {
+            it->second.promise.set_value(std::move(r));
+            pending_.erase(it);
+        }
+        break;
+    }
+    case STREAM_MSG_IMU:
+        if (!(bad = !stream_unpack_imu(d.payload, d.len, &imu_))) {
+            if (imu_cb_) imu_cb_(imu_);
+            drops = push_all(imu_subs_, imu_);
+        }
+        break;
+    case STREAM_MSG_ENV:
+        if (!(bad = !stream_unpack_env(d.payload, d.len, &env_))) {
+            if (env_cb_) env_cb_(env_);
+            drops = push_all(env_subs_, env_);
+        }
+        break;
+    case STREAM_MSG_LIGHT:
+        if (!(bad = !stream_unpack_light(d.payload, d.len, &light_))) {
+            if (light_cb_) light_cb_(light_);
+            drops = push_all(light_subs_, light_);
+        }
+        break;
+    case STREAM_MSG_AUDIO: {
+        std::shared_ptr<AudioBlock> blk = audio_subs_.empty() ? nullptr : acquire_audio();
+        AudioBlock &b = blk ? *blk : audio_;
+        int n = stream_unpack_audio(d.payload, d.len, &b.timestamp_us, &b.sample_rate, b.samples);
+        if ((bad = n < 0)) break;
+        b.count = static_cast<size_t>(n);
+        if (audio_cb_) audio_cb_(b);
+        if (blk) drops = push_all(audio_subs_, AudioPtr(std::move(blk)));
+        else drops = audio_subs_.size();
+        break;
+    }
+    default:
+        bad = true;
+        break;
+    }
+    if (bad || drops) {
+        std::lock_guard<std::mutex> lk(stats_m_);
+        stats_.malformed += bad;
+        stats_.queue_drops += drops;
+    }
+}
+
+void Client::run() {
+    bool first = true;
+    uint64_t base_frames = 0, base_lost = 0, base_crc = 0;
+    while (running_) {
+        if (fd_ < 0) {
+            if (!open_port()) {
+                auto until = std::chrono::steady_clock::now() + opt_.reconnect_interval;
+                while (running_ && std::chrono::steady_clock::now() < until)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(kPollMs));
+                continue;
+            }
+            if (!first) {
+                std::lock_guard<std::mutex> lk(stats_m_);
+                stats_.reconnects++;
+            }
+            first = false;
+            if (conn_cb_) conn_cb_(true);
+            int mask = stream_mask_;
+            if (mask >= 0) {
+                uint8_t m = static_cast<uint8_t>(mask);
+                call(STREAM_CMD_SET_STREAMS, &m, 1);     // answer not needed
+            }
+        }
+
+        pollfd pf{ fd_, POLLIN, 0 };
+        int r = poll(&pf, 1, kPollMs);
+        bool lost_port = false;
+        if (r > 0 && (pf.revents & POLLIN)) {
+            ssize_t n = read(fd_, rx_buf_.data(), rx_buf_.size());
+            if (n > 0) {
+                for (ssize_t i = 0; i < n; i++)
+                    if (link_frame_decode_byte(&dec_, rx_buf_[static_cast<size_t>(i)]) == LINK_FRAME_READY)
+                        dispatch(dec_);
+                std::lock_guard<std::mutex> lk(stats_m_);
+                stats_.bytes += static_cast<uint64_t>(n);
+                stats_.frames = base_frames + dec_.frames;
+                stats_.lost = base_lost + dec_.lost;
+                stats_.crc_errors = base_crc + dec_.crc_errors;
+            } else if (n == 0 || (errno != EAGAIN && errno != EINTR)) {
+                lost_port = true;
+            }
+        } else if (r > 0 && (pf.revents & (POLLHUP | POLLERR | POLLNVAL))) {
+            lost_port = true;
+        }
+        if (lost_port) {
+            base_frames += dec_.frames;
+            base_lost += dec_.lost;
+            base_crc += dec_.crc_errors;
+            close_port();
+            continue;
+        }
+        expire_pending();
+    }
+    close_port();
+}
+
+}  // namespace tkjhat
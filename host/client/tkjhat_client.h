@@ -0,0 +1,267 @@
+// C++17 client for the record streams and commands a TKJHAT board serves on CDC1
+// (usbSerialDebug/stream.h, protocol in usbSerialDebug/stream_proto.h).
+//
+// One reader thread owns the serial port. It decodes the frames, hands records to
+// the registered callbacks and to the subscriptions, completes the futures of the
+// pending commands, and reopens the port when the board goes away (unplug, reset).
+// After a reconnection the last stream mask is sent again, so streams resume on
+// their own; commands in flight at the disconnection complete with
+// Status::disconnected.
+//
+// Records come in two ways:
+//
+//   - callbacks, run on the reader thread. The reference is only valid during the
+//     call; it points to storage reused for the next record, nothing is allocated.
+//   - subscriptions: bounded queues read from any thread with next() or a range-for.
+//     Audio blocks are taken from a pool and go back to it when the last
+//     AudioPtr is released, so a steady stream does not allocate sample buffers.
+//
+//   tkjhat::Client c("/dev/ttyACM1");
+//   c.on_imu([](const tkjhat::ImuRecord &r) { ... });
+//   auto audio = c.subscribe_audio();
+//   c.start();
+//   c.set_streams(STREAM_ALL).get();
+//   for (tkjhat::AudioPtr b : *audio) consume(b->samples, b->count);
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "usbSerialDebug/stream_proto.h"
+
+namespace tkjhat {
+
+using ImuRecord = stream_imu_t;
+using EnvRecord = stream_env_t;
+using LightRecord = stream_light_t;
+
+struct AudioBlock {
+    uint32_t timestamp_us = 0;
+    uint16_t sample_rate = 0;
+    size_t count = 0;
+    int16_t samples[STREAM_AUDIO_MAX_SAMPLES];
+};
+
+using AudioPtr = std::shared_ptr<const AudioBlock>;
+
+enum class Status : int {
+    ok = STREAM_OK,
+    unknown_command = STREAM_ERR_UNKNOWN_CMD,
+    bad_args = STREAM_ERR_BAD_ARGS,
+    failed = STREAM_ERR_FAILED,
+    timeout = -100,         // no response within Options::rpc_timeout
+    disconnected = -101,    // port closed before the response arrived
+};
+
+const char *to_string(Status s);
+
+struct Response {
+    Status status = Status::disconnected;
+    std::vector<uint8_t> data;
+    bool ok() const { return status == Status::ok; }
+};
+
+struct DeviceInfo {
+    Status status = Status::disconnected;
+    unsigned version = 0;
+    unsigned streams = 0;       // STREAM_BIT mask the firmware can send
+    uint32_t uptime_ms = 0;
+    std::string name;
+};
+
+struct Stats {
+    uint64_t frames = 0;            // valid frames received
+    uint64_t bytes = 0;             // bytes read from the port
+    uint64_t lost = 0;              // frames missing according to the sequence numbers
+    uint64_t crc_errors = 0;
+    uint64_t malformed = 0;         // valid frames with an unexpected payload
+    uint64_t queue_drops = 0;       // records dropped because a subscription was full
+    uint64_t reconnects = 0;        // successful opens after the first one
+};
+
+// Bounded queue of records fed by the reader thread. When it is full the newest
+// record is dropped (counted in Stats::queue_drops).
+template <typename T>
+class Subscription {
+public:
+    explicit Subscription(size_t depth) : depth_(depth ? depth : 1) {}
+
+    // Waits up to @p timeout for the next record. false on timeout or once closed and empty.
+    template <typename Rep, typename Period>
+    bool next(T &out, std::chrono::duration<Rep, Period> timeout) {
+        std::unique_lock<std::mutex> lk(m_);
+        if (!cv_.wait_for(lk, timeout, [&] { return !q_.empty() || closed_; }) || q_.empty()) return false;
+        out = std::move(q_.front());
+        q_.pop_front();
+        return true;
+    }
+
+    // Blocks until a record arrives; false once closed and empty.
+    bool next(T &out) {
+        std::unique_lock<std::mutex> lk(m_);
+        cv_.wait(lk, [&] { return !q_.empty() || closed_; });
+        if (q_.empty()) return false;
+        out = std::move(q_.front());
+        q_.pop_front();
+        return true;
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lk(m_);
+        return q_.size();
+    }
+
+    // Input iterator over the records until the subscription is closed.
+    class iterator {
+    public:
+        iterator() = default;
+        explicit iterator(Subscription *s) : s_(s) { ++*this; }
+        const T &operator*() const { return v_; }
+        iterator &operator++() {
+            if (s_ && !s_->next(v_)) s_ = nullptr;
+            return *this;
+        }
+        bool operator!=(const iterator &o) const { return s_ != o.s_; }
+
+    private:
+        Subscription *s_ = nullptr;
+        T v_{};
+    };
+    iterator begin() { return iterator(this); }
+    iterator end() { return iterator(); }
+
+    // Wakes the readers; they drain what is queued and stop.
+    void close() {
+        std::lock_guard<std::mutex> lk(m_);
+        closed_ = true;
+        cv_.notify_all();
+    }
+
+    // Called by the reader thread. false if the queue was full.
+    bool push(const T &v) {
+        std::lock_guard<std::mutex> lk(m_);
+        if (closed_ || q_.size() >= depth_) return false;
+        q_.push_back(v);
+        cv_.notify_one();
+        return true;
+    }
+
+private:
+    const size_t depth_;
+    mutable std::mutex m_;
+    std::condition_variable cv_;
+    std::deque<T> q_;
+    bool closed_ = false;
+};
+
+class Client {
+public:
+    struct Options {
+        std::chrono::milliseconds rpc_timeout{500};
+        std::chrono::milliseconds reconnect_interval{200};
+        size_t audio_pool = 256;        // audio blocks kept for reuse
+    };
+
+    explicit Client(std::string path);
+    Client(std::string path, Options opt);
+    ~Client();
+    Client(const Client &) = delete;
+    Client &operator=(const Client &) = delete;
+
+    // Starts the reader thread; it keeps trying to open the port until stop().
+    void start();
+    // Closes the port, fails the pending commands and closes the subscriptions.
+    void stop();
+    bool connected() const { return connected_.load(); }
+    // Waits until the port is open. false on timeout.
+    bool wait_connected(std::chrono::milliseconds timeout);
+
+    // Callbacks run on the reader thread and must not block. Register them before start().
+    void on_imu(std::function<void(const ImuRecord &)> fn) { imu_cb_ = std::move(fn); }
+    void on_env(std::function<void(const EnvRecord &)> fn) { env_cb_ = std::move(fn); }
+    void on_light(std::function<void(const LightRecord &)> fn) { light_cb_ = std::move(fn); }
+    void on_audio(std::function<void(const AudioBlock &)> fn) { audio_cb_ = std::move(fn); }
+    void on_connection(std::function<void(bool)> fn) { conn_cb_ = std::move(fn); }
+
+    // Subscriptions; create them before start().
+    std::shared_ptr<Subscription<ImuRecord>> subscribe_imu(size_t depth = 4096);
+    std::shared_ptr<Subscription<EnvRecord>> subscribe_env(size_t depth = 256);
+    std::shared_ptr<Subscription<LightRecord>> subscribe_light(size_t depth = 256);
+    std::shared_ptr<Subscription<AudioPtr>> subscribe_audio(size_t depth = 256);
+
+    // Commands. The futures complete on the reader thread.
+    std::future<Response> call(uint8_t cmd, const void *args = nullptr, size_t len = 0);
+    std::future<Response> ping(const std::vector<uint8_t> &payload = {});
+    std::future<DeviceInfo> info();
+    // Enables the streams in @p mask (STREAM_BIT / STREAM_ALL); re-sent after a reconnection.
+    std::future<Response> set_streams(uint8_t mask);
+
+    Stats stats() const;
+
+private:
+    struct Pending {
+        std::promise<Response> promise;
+        std::chrono::steady_clock::time_point deadline;
+    };
+    void run();
+    bool open_port();
+    void close_port();
+    void fail_pending(Status s);
+    void expire_pending();
+    bool send_request(uint8_t id, uint8_t cmd, const void *args, size_t len);
+    void dispatch(const link_frame_decoder_t &d);
+    std::shared_ptr<AudioBlock> acquire_audio();
+
+    const std::string path_;
+    const Options opt_;
+    int fd_ = -1;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> connected_{false};
+    std::mutex conn_m_;
+    std::condition_variable conn_cv_;
+
+    std::mutex tx_m_;                   // port writes and closing, sequence number
+    uint8_t tx_seq_ = 0;
+    std::mutex pend_m_;                 // pending commands, request ids
+    uint8_t next_id_ = 0;
+    std::map<uint8_t, Pending> pending_;
+    std::atomic<int> stream_mask_{-1};  // last mask asked for, -1 = none
+
+    link_frame_decoder_t dec_{};
+    std::vector<uint8_t> rx_buf_;
+    ImuRecord imu_{};
+    EnvRecord env_{};
+    LightRecord light_{};
+    AudioBlock audio_{};
+    std::vector<std::shared_ptr<AudioBlock>> pool_;     // a block is free when only the pool holds it
+    size_t pool_next_ = 0;
+
+    std::function<void(const ImuRecord &)> imu_cb_;
+    std::function<void(const EnvRecord &)> env_cb_;
+    std::function<void(const LightRecord &)> light_cb_;
+    std::function<void(const AudioBlock &)> audio_cb_;
+    std::function<void(bool)> conn_cb_;
+    std::vector<std::shared_ptr<Subscription<ImuRecord>>> imu_subs_;
+    std::vector<std::shared_ptr<Subscription<EnvRecord>>> env_subs_;
+    std::vector<std::shared_ptr<Subscription<LightRecord>>> light_subs_;
+    std::vector<std::shared_ptr<Subscription<AudioPtr>>> audio_subs_;
+
+    mutable std::mutex stats_m_;
+    Stats stats_;
+};
+
+}  // namespace tkjhat
@@ -0,0 +1,55 @@
+// Virtual-time stand-in for the FreeRTOS kernel API used by the applications.
+// Tasks run as coroutines on a discrete-event clock (see sim_kernel.c).
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t StackType_t;
+
+#define configTICK_RATE_HZ                      1000
+#define configMAX_PRIORITIES                    32
+#define configMINIMAL_STACK_SIZE                512
+#define configMAX_TASK_NAME_LEN                 16
+#define configNUMBER_OF_CORES                   2
+#define configSTACK_DEPTH_TYPE                  uint32_t
+#define configRUN_TIME_COUNTER_TYPE             uint32_t
+
+#define pdFALSE                                 ((BaseType_t)0)
+#define pdTRUE                                  ((BaseType_t)1)
+#define pdFAIL                                  pdFALSE
+#define pdPASS                                  pdTRUE
+#define errQUEUE_FULL                           ((BaseType_t)0)
+#define errQUEUE_EMPTY                          ((BaseType_t)0)
+#define portMAX_DELAY                           ((TickType_t)0xffffffffu)
+#define portTICK_PERIOD_MS                      ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)                       ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000u))
+#define pdTICKS_TO_MS(t)                        ((uint32_t)(((uint64_t)(t) * 1000u) / configTICK_RATE_HZ))
+#define tskIDLE_PRIORITY                        ((UBaseType_t)0)
+
+// Coroutines are never preempted in the middle of C code: critical sections are no-ops
+#define taskENTER_CRITICAL()                    ((void)0)
+#define taskEXIT_CRITICAL()                     ((void)0)
+#define taskENTER_CRITICAL_FROM_ISR()           ((UBaseType_t)0)
+#define taskEXIT_CRITICAL_FROM_ISR(x)           ((void)(x))
+#define taskDISABLE_INTERRUPTS()                ((void)0)
+#define taskENABLE_INTERRUPTS()                 ((void)0)
+#define portYIELD_FROM_ISR(x)                   ((void)(x))
+#define portEND_SWITCHING_ISR(x)                ((void)(x))
+#define configASSERT(x)                         sim_assert((x), #x, __FILE__, __LINE__)
+
+void sim_assert(int ok, const char *expr, const char *file, int line);
+void *pvPortMalloc(size_t size);
+void vPortFree(void *p);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,5 @@
+#pragma once
+#include "pico/stdlib.h"
+
+typedef struct i2c_inst i2c_inst_t;
+extern i2c_inst_t *i2c_default;
@@ -0,0 +1,6 @@
+#pragma once
+#include "pico/stdlib.h"
+
+#define IO_IRQ_BANK0    13
+
+void irq_set_enabled(uint num, bool enabled);
@@ -0,0 +1,16 @@
+#pragma once
+#include "pico/stdlib.h"
+
+// The simulator runs every task and interrupt on one host thread, so the
+// hardware spin locks reduce to no-ops
+#define PICO_SPINLOCK_ID_STRIPED_FIRST  16
+
+typedef volatile uint32_t spin_lock_t;
+
+static inline spin_lock_t *spin_lock_instance(uint lock_num) {
+    static spin_lock_t locks[32];
+    return &locks[lock_num];
+}
+
+static inline uint32_t spin_lock_blocking(spin_lock_t *lock) { (void)lock; return 0; }
+static inline void spin_unlock(spin_lock_t *lock, uint32_t saved_irq) { (void)lock; (void)saved_irq; }
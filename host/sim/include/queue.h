@@ -0,0 +1,33 @@
+#pragma once
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct QueueDefinition *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+void vQueueDelete(QueueHandle_t q);
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t wait);
+BaseType_t xQueueSendToFront(QueueHandle_t q, const void *item, TickType_t wait);
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *woken);
+BaseType_t xQueueOverwrite(QueueHandle_t q, const void *item);
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t wait);
+BaseType_t xQueueReceiveFromISR(QueueHandle_t q, void *item, BaseType_t *woken);
+BaseType_t xQueuePeek(QueueHandle_t q, void *item, TickType_t wait);
+BaseType_t xQueueReset(QueueHandle_t q);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q);
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t q);
+
+#define xQueueSendToBack(q, item, wait)         xQueueSend((q), (item), (wait))
+#define xQueueSendToBackFromISR(q, item, w)     xQueueSendFromISR((q), (item), (w))
+
+// Used by semphr.h
+QueueHandle_t sim_queue_create(UBaseType_t length, UBaseType_t item_size, UBaseType_t initial_count, bool mutex);
+TaskHandle_t sim_queue_holder(QueueHandle_t q);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,20 @@
+#pragma once
+#include "queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+// Semaphores are queues of zero-size items. Mutexes record their holder but
+// do not implement priority inheritance.
+#define xSemaphoreCreateBinary()                sim_queue_create(1, 0, 0, false)
+#define xSemaphoreCreateCounting(max, initial)  sim_queue_create((max), 0, (initial), false)
+#define xSemaphoreCreateMutex()                 sim_queue_create(1, 0, 1, true)
+#define xSemaphoreCreateRecursiveMutex()        sim_queue_create(1, 0, 1, true)
+#define xSemaphoreTake(s, wait)                 xQueueReceive((s), NULL, (wait))
+#define xSemaphoreGive(s)                       xQueueSend((s), NULL, 0)
+#define xSemaphoreTakeRecursive(s, wait)        xQueueReceive((s), NULL, (wait))
+#define xSemaphoreGiveRecursive(s)              xQueueSend((s), NULL, 0)
+#define xSemaphoreGiveFromISR(s, woken)         xQueueSendFromISR((s), NULL, (woken))
+#define xSemaphoreTakeFromISR(s, woken)         xQueueReceiveFromISR((s), NULL, (woken))
+#define xSemaphoreGetMutexHolder(s)             sim_queue_holder(s)
+#define uxSemaphoreGetCount(s)                  uxQueueMessagesWaiting(s)
+#define vSemaphoreDelete(s)                     vQueueDelete(s)
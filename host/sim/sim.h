@@ -0,0 +1,65 @@
+// Internal interface of the virtual-time simulator.
+//
+// sim_kernel.c   discrete-event clock, coroutine tasks, FreeRTOS and pico time API
+// sim_hat.c      models of the HAT peripherals (buttons, IMU, display, buzzer, stdio...)
+// sim_scenario.c scenario parser, latency metrics, report and main()
+#pragma once
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define SIM_NEVER                   UINT64_MAX
+
+/* ===== Clock and events ===== */
+typedef void (*sim_event_fn)(void *arg, uint64_t tag);
+
+uint64_t sim_now(void);
+uint64_t sim_schedule(uint64_t t_us, sim_event_fn fn, void *arg, uint64_t tag);    // event id
+bool sim_cancel(uint64_t id);
+
+void sim_set_cores(int cores);
+void sim_set_end(uint64_t t_us);
+uint64_t sim_end(void);
+bool sim_in_task(void);
+
+// Keep the CPU for @p us (busy wait). Blocks the caller's core.
+void sim_busy(uint64_t us);
+// Block the caller for @p us without using the CPU (sleep).
+void sim_sleep(uint64_t us);
+
+/* ===== Task statistics ===== */
+typedef struct {
+    const char *name;
+    unsigned priority;
+    uint32_t activations;       // times the task got the CPU
+    uint64_t busy_us;           // CPU time spent in busy waits
+} sim_task_stats_t;
+
+int sim_task_stats(sim_task_stats_t *out, int max);
+
+/* ===== Effects (observable outputs) ===== */
+typedef enum {
+    SIM_EFFECT_STDOUT = 0,
+    SIM_EFFECT_DISPLAY,
+    SIM_EFFECT_BUZZER,
+    SIM_EFFECT_LED,
+    SIM_EFFECT_KINDS,
+} sim_effect_kind_t;
+
+const char *sim_effect_name(sim_effect_kind_t kind);
+void sim_effect(sim_effect_kind_t kind, const char *fmt, ...);
+
+/* ===== HAT inputs (driven by the scenario) ===== */
+void sim_hat_set_pin(unsigned gpio, bool level);
+void sim_hat_set_imu(const float values[7]);        // ax ay az gx gy gz t
+void sim_hat_set_ambient(float lux, float temp_c, float humidity);
+void sim_hat_serial_input(const char *data, size_t len);
+
+/* ===== Scenario side (sim_scenario.c) ===== */
+void sim_metrics_effect(sim_effect_kind_t kind, const char *text);
+void sim_log(const char *fmt, ...);
@@ -0,0 +1,388 @@
+// Behavioural models of the HAT peripherals and of the pico GPIO / stdio API.
+//
+// Only the timing that shapes the application behaviour is modelled: a full
+// display flush over I2C at 400 kHz (~23 ms of CPU, skipped or deferred by the
+// display scheduler when the application starts it), the blocking delays the
+// SDK functions contain (write_text sleeps 800 ms) and the buzzer, which
+// bit-bangs the tone and so keeps the CPU busy for the whole duration. Every
+// observable output is reported as an effect (see sim_effect).
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#include "hardware/irq.h"
+#include "tkjhat/sdk.h"
+#include "tkjhat/early_log.h"
+#include "tkjhat/display_sched.h"
+
+#include "sim.h"
+
+#define NUM_GPIOS                   30
+#define DISPLAY_FLUSH_US            23000       // 1 KiB framebuffer + addressing at 400 kHz
+#define I2C_SENSOR_READ_US          300         // one short register read
+
+static struct {
+    bool level[NUM_GPIOS];
+    bool out[NUM_GPIOS];
+    uint32_t irq_mask[NUM_GPIOS];
+    gpio_irq_callback_t irq_callback;
+
+    float imu[7];
+    float lux, temp_c, humidity;
+
+    char rx[4096];
+    size_t rx_head, rx_len;
+
+    uint8_t rgb[3];
+} hat = { .imu = { 0, 0, 1, 0, 0, 0, 25 }, .lux = 100, .temp_c = 22, .humidity = 40 };
+
+i2c_inst_t *i2c_default = NULL;
+
+/* =========================
+ *  GPIO
+ * ========================= */
+void gpio_init(uint gpio) { if (gpio < NUM_GPIOS) hat.out[gpio] = false; }
+void gpio_deinit(uint gpio) { (void)gpio; }
+void gpio_set_dir(uint gpio, bool out) { if (gpio < NUM_GPIOS) hat.out[gpio] = out; }
+void gpio_pull_up(uint gpio) { if (gpio < NUM_GPIOS) hat.level[gpio] = true; }
+void gpio_pull_down(uint gpio) { if (gpio < NUM_GPIOS) hat.level[gpio] = false; }
+void gpio_disable_pulls(uint gpio) { (void)gpio; }
+void gpio_set_function(uint gpio, enum gpio_function fn) { (void)gpio; (void)fn; }
+bool gpio_get(uint gpio) { return gpio < NUM_GPIOS && hat.level[gpio]; }
+void gpio_acknowledge_irq(uint gpio, uint32_t events) { (void)gpio; (void)events; }
+
+void gpio_put(uint gpio, bool value) {
+    if (gpio >= NUM_GPIOS || hat.level[gpio] == value) return;
+    hat.level[gpio] = value;
+    if (gpio == RED_LED_PIN) sim_effect(SIM_EFFECT_LED, "red %s", value ? "on" : "off");
+}
+
+void gpio_set_irq_enabled(uint gpio, uint32_t events, bool enabled) {
+    if (gpio >= NUM_GPIOS) return;
+    if (enabled) hat.irq_mask[gpio] |= events;
+    else hat.irq_mask[gpio] &= ~events;
+}
+
+void gpio_set_irq_callback(gpio_irq_callback_t callback) { hat.irq_callback = callback; }
+void irq_set_enabled(uint num, bool enabled) { (void)num; (void)enabled; }
+
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t events, bool enabled, gpio_irq_callback_t callback) {
+    gpio_set_irq_enabled(gpio, events, enabled);
+    if (enabled) hat.irq_callback = callback;
+}
+
+void sim_hat_set_pin(unsigned gpio, bool level) {
+    if (gpio >= NUM_GPIOS || hat.level[gpio] == level) return;
+    hat.level[gpio] = level;
+    uint32_t events = level ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+    events &= hat.irq_mask[gpio];
+    if (events && hat.irq_callback) hat.irq_callback(gpio, events);
+}
+
+/* =========================
+ *  stdio
+ * ========================= */
+bool stdio_init_all(void) { return true; }
+bool stdio_usb_connected(void) { return true; }
+void stdio_flush(void) {}
+
+// The simulated host is connected from reset, so nothing needs buffering
+int early_log_init(bool poll_task) { (void)poll_task; return 0; }
+bool early_log_connected(void) { return true; }
+
+int getchar_timeout_us(uint32_t timeout_us) {
+    if (hat.rx_len == 0) {
+        if (timeout_us) sim_sleep(timeout_us);
+        if (hat.rx_len == 0) return PICO_ERROR_TIMEOUT;
+    }
+    int ch = (unsigned char)hat.rx[hat.rx_head];
+    hat.rx_head = (hat.rx_head + 1) % sizeof(hat.rx);
+    hat.rx_len--;
+    return ch;
+}
+
+void sim_hat_serial_input(const char *data, size_t len) {
+    for (size_t i = 0; i < len && hat.rx_len < sizeof(hat.rx); i++) {
+        hat.rx[(hat.rx_head + hat.rx_len) % sizeof(hat.rx)] = data[i];
+        hat.rx_len++;
+    }
+}
+
+// Output is collected line by line so that one printf is one effect
+static char out_line[512];
+static size_t out_len;
+
+static void out_char(char c) {
+    if (c != '\n' && out_len < sizeof(out_line) - 1) {
+        out_line[out_len++] = c;
+        return;
+    }
+    out_line[out_len] = '\0';
+    sim_effect(SIM_EFFECT_STDOUT, "%s", out_line);
+    out_len = 0;
+}
+
+int sim_printf(const char *fmt, ...) {
+    char buf[1024];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    for (const char *p = buf; *p; p++) out_char(*p);
+    return n;
+}
+
+int stdio_put_string(const char *s, int len, bool newline, bool cr_translation) {
+    (void)cr_translation;
+    for (int i = 0; i < len; i++) out_char(s[i]);
+    if (newline) out_char('\n');
+    return len;
+}
+
+int sim_puts(const char *s) {
+    while (*s) out_char(*s++);
+    out_char('\n');
+    return 1;
+}
+
+int sim_putchar(int c) {
+    out_char((char)c);
+    return c;
+}
+
+/* =========================
+ *  HAT SDK
+ * ========================= */
+void init_hat_sdk(void) {}
+void init_i2c(uint sda_pin, uint scl_pin) { (void)sda_pin; (void)scl_pin; }
+void init_i2c_default(void) {}
+bool i2c_write(uint8_t addr, const uint8_t *src, size_t len, bool nostop) { (void)addr; (void)src; (void)len; (void)nostop; return true; }
+bool i2c_read(uint8_t addr, uint8_t *dst, size_t len, bool nostop) { (void)addr; (void)nostop; memset(dst, 0, len); return true; }
+
+static void init_button(uint gpio) {
+    gpio_init(gpio);
+    gpio_set_dir(gpio, GPIO_IN);
+    gpio_pull_up(gpio);
+}
+
+void init_sw1(void) { init_button(SW1_PIN); }
+void init_sw2(void) { init_button(SW2_PIN); }
+void init_button1(void) { init_button(BUTTON1); }
+void init_button2(void) { init_button(BUTTON2); }
+
+void init_led(void) { gpio_init(RED_LED_PIN); gpio_set_dir(RED_LED_PIN, GPIO_OUT); }
+void init_red_led(void) { init_led(); }
+void toggle_red_led(void) { gpio_put(RED_LED_PIN, !hat.level[RED_LED_PIN]); }
+void toggle_led(void) { toggle_red_led(); }
+void set_red_led_status(bool status) { gpio_put(RED_LED_PIN, status); }
+void set_led_status(bool status) { set_red_led_status(status); }
+
+void blink_red_led(int n) {
+    for (int i = 0; i < n; i++) {
+        gpio_put(RED_LED_PIN, true);
+        sleep_ms(500);
+        gpio_put(RED_LED_PIN, false);
+        sleep_ms(500);
+    }
+}
+
+void blink_led(int n) { blink_red_led(n); }
+
+void init_rgb_led(void) {}
+
+void rgb_led_write(uint8_t r, uint8_t g, uint8_t b) {
+    if (hat.rgb[0] == r && hat.rgb[1] == g && hat.rgb[2] == b) return;
+    hat.rgb[0] = r;
+    hat.rgb[1] = g;
+    hat.rgb[2] = b;
+    sim_effect(SIM_EFFECT_LED, "rgb %u %u %u", r, g, b);
+}
+
+void stop_rgb_led(void) { rgb_led_write(0, 0, 0); }
+
+void init_buzzer(void) {}
+
+void buzzer_play_tone(uint32_t frequency, uint32_t duration_ms) {
+    if (frequency == 0) return;
+    sim_effect(SIM_EFFECT_BUZZER, "%u Hz %u ms", (unsigned)frequency, (unsigned)duration_ms);
+    // Same cycle count and rounding as the bit-banged loop in sdk.c
+    uint32_t period_us = 1000000 / frequency;
+    uint32_t num_cycles = duration_ms * frequency / 1000;
+    sim_busy((uint64_t)num_cycles * (period_us / 2) * 2);
+}
+
+void buzzer_turn_off(void) {}
+void deinit_buzzer(void) {}
+
+int init_pdm_microphone(void) { return 0; }
+int init_microphone_sampling(void) { return 0; }
+void end_microphone_sampling(void) {}
+void pdm_microphone_set_callback(pdm_samples_ready_handler_t handler) { (void)handler; }
+int get_microphone_samples(int16_t *buffer, size_t samples) { memset(buffer, 0, samples * sizeof(*buffer)); return (int)samples; }
+
+// ---- Display: the framebuffer is modelled as the list of what was drawn since
+// the last clear; a flush reports it as a display effect. With the refresh
+// scheduler the real policy (tkjhat/display_sched.h) decides the flushes.
+static struct {
+    char content[256];
+    size_t len;
+    bool sched_active;
+    display_sched_t sched;
+} fb;
+
+static uint32_t fb_hash(void) {
+    return display_sched_hash((const uint8_t *)fb.content, fb.len);
+}
+
+static void fb_draw(const char *fmt, ...) {
+    if (fb.len && fb.len < sizeof(fb.content) - 1) fb.content[fb.len++] = ' ';
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(fb.content + fb.len, sizeof(fb.content) - fb.len, fmt, ap);
+    va_end(ap);
+    if (n > 0) fb.len += (size_t)n < sizeof(fb.content) - fb.len ? (size_t)n : sizeof(fb.content) - 1 - fb.len;
+}
+
+static void fb_flush(void) {
+    uint32_t hash = fb_hash();
+    sim_busy(DISPLAY_FLUSH_US);
+    sim_effect(SIM_EFFECT_DISPLAY, "%s", fb.len ? fb.content : "<clear>");
+    if (fb.sched_active) display_sched_flushed(&fb.sched, hash, time_us_64(), DISPLAY_FLUSH_US);
+}
+
+static void fb_apply(unsigned actions) {
+    if (actions & DISPLAY_SCHED_POWER_OFF) sim_effect(SIM_EFFECT_DISPLAY, "<off>");
+    if (actions & DISPLAY_SCHED_FLUSH) fb_flush();
+    if (actions & DISPLAY_SCHED_READ_LIGHT) {
+        int contrast = display_sched_light(&fb.sched, veml6030_read_light());
+        if (contrast >= 0) set_display_contrast((uint8_t)contrast);
+    }
+}
+
+static void fb_show(void) {
+    if (!fb.sched_active) {
+        fb_flush();
+        return;
+    }
+    fb_apply(display_sched_request(&fb.sched, fb_hash(), time_us_64()) & DISPLAY_SCHED_FLUSH);
+}
+
+// write_text pause: the deferred frame goes out when its slot comes
+static void fb_pause_ms(uint32_t ms) {
+    uint64_t end = time_us_64() + (uint64_t)ms * 1000u;
+    while (fb.sched_active) {
+        int64_t due = display_sched_due_us(&fb.sched, time_us_64());
+        if (due < 0 || time_us_64() + (uint64_t)due >= end) break;
+        if (due > 0) sleep_us((uint64_t)due);
+        display_sched_service();
+    }
+    if (time_us_64() < end) sleep_us(end - time_us_64());
+}
+
+void init_display(void) { fb.len = 0; }
+
+void write_text(const char *text) {
+    if (!text) return;
+    fb_draw("%s", text);
+    fb_show();
+    fb_pause_ms(800);
+}
+
+void write_text_xy(int16_t x0, int16_t y0, const char *text) {
+    if (!text) return;
+    fb_draw("@%d,%d %s", x0, y0, text);
+    fb_show();
+    fb_pause_ms(800);
+}
+
+void set_text_cursor(int16_t x0, int16_t y0) { (void)x0; (void)y0; }
+
+void draw_circle(int16_t x0, int16_t y0, int16_t r, bool fill) {
+    (void)fill;
+    fb_draw("<circle %d,%d r%d>", x0, y0, r);
+    fb_show();
+}
+
+void draw_line(int16_t x0, int16_t y0, int16_t x1, int16_t y1) {
+    fb_draw("<line %d,%d %d,%d>", x0, y0, x1, y1);
+    fb_show();
+}
+
+void draw_square(uint32_t x, uint32_t y, uint32_t w, uint32_t h, bool fill) {
+    (void)fill;
+    fb_draw("<square %u,%u %ux%u>", (unsigned)x, (unsigned)y, (unsigned)w, (unsigned)h);
+    fb_show();
+}
+
+void clear_display(void) {
+    fb.len = 0;
+    fb.content[0] = '\0';
+    fb_show();
+}
+
+void display_sched_start(const display_sched_config_t *cfg) {
+    display_sched_init(&fb.sched, cfg, time_us_64());
+    fb.sched_active = true;
+}
+
+void display_sched_stop(void) { fb.sched_active = false; }
+
+void display_sched_service(void) {
+    if (fb.sched_active) fb_apply(display_sched_poll(&fb.sched, time_us_64()));
+}
+
+void display_sched_stats(display_sched_stats_t *out) { display_sched_get_stats(&fb.sched, time_us_64(), out); }
+
+int display_sched_format_report(char *buf, size_t len) {
+    display_sched_stats_t st;
+    display_sched_stats(&st);
+    return snprintf(buf, len, "[display] frames %lu flushed %lu skipped %lu coalesced %lu\n",
+                    (unsigned long)st.requests, (unsigned long)st.flushes, (unsigned long)st.skipped,
+                    (unsigned long)st.coalesced);
+}
+
+void set_display_contrast(uint8_t contrast) { (void)contrast; }
+
+void stop_display(void) { sim_effect(SIM_EFFECT_DISPLAY, "<off>"); }
+
+void init_veml6030(void) {}
+uint32_t veml6030_read_light(void) { sim_busy(I2C_SENSOR_READ_US); return (uint32_t)hat.lux; }
+void veml6030_stop(void) {}
+
+void init_hdc2021_(void) {}
+void stop_hdc2021(void) {}
+void hdc2021_set_low_temp_threshold(float temp) { (void)temp; }
+void hdc2021_set_high_temp_threshold(float temp) { (void)temp; }
+void hdc2021_set_high_humidity_threshold(float humid) { (void)humid; }
+void hdc2021_set_low_humidity_threshold(float humid) { (void)humid; }
+float hdc2021_read_temperature(void) { sim_busy(I2C_SENSOR_READ_US); return hat.temp_c; }
+float hdc2021_read_humidity(void) { sim_busy(I2C_SENSOR_READ_US); return hat.humidity; }
+
+void sim_hat_set_ambient(float lux, float temp_c, float humidity) {
+    if (lux >= 0) hat.lux = lux;
+    if (temp_c > -274) hat.temp_c = temp_c;
+    if (humidity >= 0) hat.humidity = humidity;
+}
+
+int init_ICM42670(void) { return 0; }
+int ICM42670_startAccel(uint16_t odr_hz, uint16_t fsr_g) { (void)odr_hz; (void)fsr_g; return 0; }
+int ICM42670_startGyro(uint16_t odr_hz, uint16_t fsr_dps) { (void)odr_hz; (void)fsr_dps; return 0; }
+int ICM42670_enable_accel_gyro_ln_mode(void) { return 0; }
+int ICM42670_start_with_default_values(void) { return 0; }
+
+int ICM42670_read_sensor_data(float *ax, float *ay, float *az, float *gx, float *gy, float *gz, float *t) {
+    sim_busy(I2C_SENSOR_READ_US);
+    *ax = hat.imu[0];
+    *ay = hat.imu[1];
+    *az = hat.imu[2];
+    *gx = hat.imu[3];
+    *gy = hat.imu[4];
+    *gz = hat.imu[5];
+    *t = hat.imu[6];
+    return 0;
+}
+
+void sim_hat_set_imu(const float values[7]) { memcpy(hat.imu, values, sizeof(hat.imu)); }
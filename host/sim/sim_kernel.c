@@ -0,0 +1,760 @@
+// Discrete-event clock and coroutine scheduler behind the FreeRTOS / pico time API.
+//
+// Time only moves when every runnable task is blocked or busy: C code between two
+// kernel calls takes zero virtual time. The CPU cost that matters for the
+// applications is modelled explicitly:
+//
+// - busy_wait_*() (and everything built on it, like buzzer_play_tone) keeps one of
+//   the configNUMBER_OF_CORES cores for that long; a higher priority task that
+//   becomes ready preempts the lowest priority busy task.
+// - sleep_*() blocks the task like vTaskDelay (FreeRTOS pico time interop).
+// - vTaskDelay() wakes on tick boundaries (1 ms).
+//
+// Interrupt-like callbacks (GPIO, alarms, timers, scenario events) run from the
+// event loop at their exact due time.
+
+#define _XOPEN_SOURCE 700
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "task.h"
+#include "timers.h"
+
+#include "pico/stdlib.h"
+
+#include "sim.h"
+
+#define MAX_TASKS               32
+#define TASK_STACK_BYTES        (256 * 1024)    // host stacks: printf & co need more than the Pico
+#define TICK_US                 (1000000u / configTICK_RATE_HZ)
+
+typedef enum { T_READY, T_RUNNING, T_BUSY, T_BLOCKED, T_SUSPENDED, T_DELETED } task_state_t;
+
+struct tskTaskControlBlock {
+    char name[configMAX_TASK_NAME_LEN];
+    UBaseType_t priority;
+    TaskFunction_t fn;
+    void *arg;
+    ucontext_t ctx;
+    void *stack;
+
+    task_state_t state;
+    uint64_t order;                 // FIFO among equal priorities
+    uint64_t wake_us;               // BLOCKED: timeout, SIM_NEVER if none
+    uint64_t busy_end_us;           // BUSY: end of the busy wait
+    uint64_t busy_left_us;          // READY after preemption: busy time still owed
+    void *wait_obj;                 // queue the task is blocked on
+    bool wait_notify;               // blocked in ulTaskNotifyTake
+    bool timed_out;
+    uint32_t notify;
+
+    sim_task_stats_t stats;
+};
+
+typedef struct sim_event {
+    uint64_t t;
+    uint64_t id;
+    sim_event_fn fn;
+    void *arg;
+    uint64_t tag;
+    bool cancelled;
+} sim_event_t;
+
+static struct {
+    uint64_t now;
+    uint64_t end;
+    int cores;
+    bool running;
+    uint64_t order;
+
+    struct tskTaskControlBlock *tasks[MAX_TASKS];
+    int task_count;
+    struct tskTaskControlBlock *current;
+    ucontext_t sched_ctx;
+
+    sim_event_t **heap;
+    size_t heap_len, heap_cap;
+    uint64_t next_event_id;
+} k = { .cores = configNUMBER_OF_CORES, .end = SIM_NEVER };
+
+/* =========================
+ *  Event heap
+ * ========================= */
+static bool ev_less(const sim_event_t *a, const sim_event_t *b) {
+    return a->t < b->t || (a->t == b->t && a->id < b->id);
+}
+
+static void heap_push(sim_event_t *e) {
+    if (k.heap_len == k.heap_cap) {
+        k.heap_cap = k.heap_cap ? 2 * k.heap_cap : 256;
+        k.heap = realloc(k.heap, k.heap_cap * sizeof(*k.heap));
+    }
+    size_t i = k.heap_len++;
+    while (i && ev_less(e, k.heap[(i - 1) / 2])) {
+        k.heap[i] = k.heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    k.heap[i] = e;
+}
+
+static sim_event_t *heap_pop(void) {
+    sim_event_t *top = k.heap[0];
+    sim_event_t *last = k.heap[--k.heap_len];
+    size_t i = 0;
+    for (;;) {
+        size_t c = 2 * i + 1;
+        if (c >= k.heap_len) break;
+        if (c + 1 < k.heap_len && ev_less(k.heap[c + 1], k.heap[c])) c++;
+        if (!ev_less(k.heap[c], last)) break;
+        k.heap[i] = k.heap[c];
+        i = c;
+    }
+    if (k.heap_len) k.heap[i] = last;
+    return top;
+}
+
+uint64_t sim_schedule(uint64_t t_us, sim_event_fn fn, void *arg, uint64_t tag) {
+    sim_event_t *e = calloc(1, sizeof(*e));
+    e->t = t_us < k.now ? k.now : t_us;
+    e->id = ++k.next_event_id;
+    e->fn = fn;
+    e->arg = arg;
+    e->tag = tag;
+    heap_push(e);
+    return e->id;
+}
+
+bool sim_cancel(uint64_t id) {
+    for (size_t i = 0; i < k.heap_len; i++) {
+        if (k.heap[i]->id == id && !k.heap[i]->cancelled) {
+            k.heap[i]->cancelled = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* =========================
+ *  Scheduler
+ * ========================= */
+uint64_t sim_now(void) { return k.now; }
+void sim_set_cores(int cores) { k.cores = cores > 0 ? cores : 1; }
+void sim_set_end(uint64_t t_us) { k.end = t_us; }
+uint64_t sim_end(void) { return k.end; }
+bool sim_in_task(void) { return k.current != NULL; }
+
+static void make_ready(struct tskTaskControlBlock *t, bool front) {
+    t->state = T_READY;
+    t->order = front ? 0 : ++k.order;
+    t->wake_us = SIM_NEVER;
+}
+
+// Give the CPU back to the scheduler; returns when the task runs again
+static void task_switch_out(void) {
+    struct tskTaskControlBlock *t = k.current;
+    swapcontext(&t->ctx, &k.sched_ctx);
+}
+
+static void task_trampoline(void) {
+    struct tskTaskControlBlock *t = k.current;
+    t->fn(t->arg);
+    // Returning from a task function is an error in FreeRTOS; treat it as a delete
+    sim_log("task %s returned", t->name);
+    t->state = T_DELETED;
+    task_switch_out();
+}
+
+static struct tskTaskControlBlock *best_ready(void) {
+    struct tskTaskControlBlock *best = NULL;
+    for (int i = 0; i < k.task_count; i++) {
+        struct tskTaskControlBlock *t = k.tasks[i];
+        if (t->state != T_READY) continue;
+        if (!best || t->priority > best->priority ||
+            (t->priority == best->priority && t->order < best->order)) best = t;
+    }
+    return best;
+}
+
+static bool dispatch_one(void) {
+    struct tskTaskControlBlock *t = best_ready();
+    if (!t) return false;
+
+    int busy = 0;
+    struct tskTaskControlBlock *victim = NULL;
+    for (int i = 0; i < k.task_count; i++) {
+        struct tskTaskControlBlock *b = k.tasks[i];
+        if (b->state != T_BUSY) continue;
+        busy++;
+        if (!victim || b->priority < victim->priority) victim = b;
+    }
+    if (busy >= k.cores) {
+        if (!victim || victim->priority >= t->priority) return false;
+        // Preempt the lowest priority busy wait; it keeps the rest for later
+        victim->busy_left_us = victim->busy_end_us - k.now;
+        make_ready(victim, true);
+    }
+
+    if (t->busy_left_us) {
+        t->state = T_BUSY;
+        t->busy_end_us = k.now + t->busy_left_us;
+        t->busy_left_us = 0;
+        return true;
+    }
+
+    t->state = T_RUNNING;
+    t->stats.activations++;
+    k.current = t;
+    swapcontext(&k.sched_ctx, &t->ctx);
+    k.current = NULL;
+    return true;
+}
+
+static uint64_t next_due(void) {
+    uint64_t t = SIM_NEVER;
+    while (k.heap_len && k.heap[0]->cancelled) free(heap_pop());
+    if (k.heap_len) t = k.heap[0]->t;
+    for (int i = 0; i < k.task_count; i++) {
+        struct tskTaskControlBlock *task = k.tasks[i];
+        if (task->state == T_BLOCKED && task->wake_us < t) t = task->wake_us;
+        if (task->state == T_BUSY && task->busy_end_us < t) t = task->busy_end_us;
+    }
+    return t;
+}
+
+static void process_due(void) {
+    // Interrupt-like callbacks first, in time order
+    while (k.heap_len) {
+        sim_event_t *e = k.heap[0];
+        if (e->t > k.now) break;
+        heap_pop();
+        if (!e->cancelled) e->fn(e->arg, e->tag);
+        free(e);
+    }
+    for (int i = 0; i < k.task_count; i++) {
+        struct tskTaskControlBlock *t = k.tasks[i];
+        if (t->state == T_BUSY && t->busy_end_us <= k.now) {
+            make_ready(t, true);            // continues right after its busy wait
+        } else if (t->state == T_BLOCKED && t->wake_us <= k.now) {
+            t->timed_out = t->wait_obj != NULL || t->wait_notify;
+            t->wait_obj = NULL;
+            t->wait_notify = false;
+            make_ready(t, false);
+        }
+    }
+}
+
+// Advance the clock to @p t outside of task context (boot code or ISR)
+static void advance_to(uint64_t t) {
+    while (k.now < t) {
+        uint64_t due = next_due();
+        if (due > t) {
+            k.now = t;
+            break;
+        }
+        k.now = due;
+        process_due();
+    }
+}
+
+static void run(void) {
+    while (k.now < k.end) {
+        if (dispatch_one()) continue;
+        uint64_t due = next_due();
+        if (due == SIM_NEVER || due >= k.end) {
+            k.now = k.end;
+            break;
+        }
+        if (due > k.now) k.now = due;
+        process_due();
+    }
+}
+
+void sim_busy(uint64_t us) {
+    struct tskTaskControlBlock *t = k.current;
+    if (!t) {
+        // Boot code before the scheduler, or an interrupt handler: time just passes
+        if (!k.running) advance_to(k.now + us);
+        else k.now += us;
+        return;
+    }
+    t->stats.busy_us += us;
+    t->state = T_BUSY;
+    t->busy_end_us = k.now + us;
+    task_switch_out();
+}
+
+static void block_until(uint64_t wake) {
+    struct tskTaskControlBlock *t = k.current;
+    t->state = T_BLOCKED;
+    t->wake_us = wake;
+    t->timed_out = false;
+    task_switch_out();
+}
+
+void sim_sleep(uint64_t us) {
+    if (!k.current) {
+        if (!k.running) advance_to(k.now + us);
+        else k.now += us;
+        return;
+    }
+    block_until(k.now + us);
+}
+
+static uint64_t ticks_to_wake(TickType_t ticks) {
+    if (ticks == portMAX_DELAY) return SIM_NEVER;
+    return (k.now / TICK_US + ticks) * TICK_US;
+}
+
+int sim_task_stats(sim_task_stats_t *out, int max) {
+    int n = 0;
+    for (int i = 0; i < k.task_count && n < max; i++) {
+        out[n] = k.tasks[i]->stats;
+        out[n].name = k.tasks[i]->name;
+        out[n].priority = (unsigned)k.tasks[i]->priority;
+        n++;
+    }
+    return n;
+}
+
+void sim_assert(int ok, const char *expr, const char *file, int line) {
+    if (ok) return;
+    fprintf(stderr, "[sim] assert failed at %.3f ms: %s (%s:%d)\n", k.now / 1000.0, expr, file, line);
+    abort();
+}
+
+void *pvPortMalloc(size_t size) { return malloc(size); }
+void vPortFree(void *p) { free(p); }
+
+/* =========================
+ *  FreeRTOS: tasks
+ * ========================= */
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, configSTACK_DEPTH_TYPE stack_depth,
+                       void *params, UBaseType_t priority, TaskHandle_t *created) {
+    (void)stack_depth;
+    if (k.task_count >= MAX_TASKS) return pdFAIL;
+
+    struct tskTaskControlBlock *t = calloc(1, sizeof(*t));
+    snprintf(t->name, sizeof(t->name), "%s", name ? name : "?");
+    t->priority = priority < configMAX_PRIORITIES ? priority : configMAX_PRIORITIES - 1;
+    t->fn = fn;
+    t->arg = params;
+    t->stack = malloc(TASK_STACK_BYTES);
+    getcontext(&t->ctx);
+    t->ctx.uc_stack.ss_sp = t->stack;
+    t->ctx.uc_stack.ss_size = TASK_STACK_BYTES;
+    t->ctx.uc_link = &k.sched_ctx;
+    makecontext(&t->ctx, task_trampoline, 0);
+    make_ready(t, false);
+
+    k.tasks[k.task_count++] = t;
+    if (created) *created = t;
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    struct tskTaskControlBlock *t = task ? task : k.current;
+    if (!t) return;
+    t->state = T_DELETED;
+    if (t == k.current) task_switch_out();      // never comes back
+}
+
+void vTaskDelay(TickType_t ticks) {
+    if (!k.current) {
+        sim_sleep((uint64_t)ticks * TICK_US);
+        return;
+    }
+    if (ticks == 0) {
+        make_ready(k.current, false);           // yield to equal priority tasks
+        task_switch_out();
+        return;
+    }
+    block_until(ticks_to_wake(ticks));
+}
+
+BaseType_t xTaskDelayUntil(TickType_t *previous_wake, TickType_t increment) {
+    TickType_t target = *previous_wake + increment;
+    *previous_wake = target;
+    uint64_t wake = (uint64_t)target * TICK_US;
+    if (wake <= k.now) return pdFALSE;
+    if (k.current) block_until(wake);
+    else advance_to(wake);
+    return pdTRUE;
+}
+
+void vTaskDelayUntil(TickType_t *previous_wake, TickType_t increment) {
+    (void)xTaskDelayUntil(previous_wake, increment);
+}
+
+TickType_t xTaskGetTickCount(void) { return (TickType_t)(k.now / TICK_US); }
+TickType_t xTaskGetTickCountFromISR(void) { return xTaskGetTickCount(); }
+
+void vTaskStartScheduler(void) {
+    k.running = true;
+    run();
+    k.running = false;
+}
+
+void vTaskEndScheduler(void) { k.end = k.now; }
+
+BaseType_t xTaskGetSchedulerState(void) {
+    return k.running ? taskSCHEDULER_RUNNING : taskSCHEDULER_NOT_STARTED;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) { return k.current; }
+char *pcTaskGetName(TaskHandle_t task) { return (task ? task : k.current)->name; }
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task) { return (task ? task : k.current)->priority; }
+void vTaskPrioritySet(TaskHandle_t task, UBaseType_t priority) { (task ? task : k.current)->priority = priority; }
+UBaseType_t uxTaskGetNumberOfTasks(void) { return (UBaseType_t)k.task_count; }
+void vTaskSuspendAll(void) {}
+BaseType_t xTaskResumeAll(void) { return pdFALSE; }
+
+eTaskState eTaskGetState(TaskHandle_t task) {
+    switch (task->state) {
+    case T_RUNNING: return eRunning;
+    case T_READY: return eReady;
+    case T_BUSY: return eRunning;
+    case T_BLOCKED: return eBlocked;
+    case T_SUSPENDED: return eSuspended;
+    default: return eDeleted;
+    }
+}
+
+void vTaskSuspend(TaskHandle_t task) {
+    struct tskTaskControlBlock *t = task ? task : k.current;
+    t->state = T_SUSPENDED;
+    if (t == k.current) task_switch_out();
+}
+
+void vTaskResume(TaskHandle_t task) {
+    if (task && task->state == T_SUSPENDED) make_ready(task, false);
+}
+
+/* =========================
+ *  FreeRTOS: notifications
+ * ========================= */
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t wait) {
+    struct tskTaskControlBlock *t = k.current;
+    if (t->notify == 0 && wait) {
+        t->wait_notify = true;
+        block_until(ticks_to_wake(wait));
+        t->wait_notify = false;
+    }
+    uint32_t v = t->notify;
+    if (v) t->notify = clear_on_exit ? 0 : v - 1;
+    return v;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    task->notify++;
+    if (task->state == T_BLOCKED && task->wait_notify) {
+        task->wait_notify = false;
+        make_ready(task, false);
+    }
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken) {
+    xTaskNotifyGive(task);
+    if (woken) *woken = pdTRUE;
+}
+
+/* =========================
+ *  FreeRTOS: queues and semaphores
+ * ========================= */
+struct QueueDefinition {
+    uint8_t *storage;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t count;
+    UBaseType_t head;
+    bool mutex;
+    TaskHandle_t holder;
+};
+
+QueueHandle_t sim_queue_create(UBaseType_t length, UBaseType_t item_size, UBaseType_t initial_count, bool mutex) {
+    struct QueueDefinition *q = calloc(1, sizeof(*q));
+    q->length = length;
+    q->item_size = item_size;
+    q->storage = item_size ? calloc(length, item_size) : NULL;
+    q->count = initial_count;
+    q->mutex = mutex;
+    return q;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    return sim_queue_create(length, item_size, 0, false);
+}
+
+void vQueueDelete(QueueHandle_t q) {
+    free(q->storage);
+    free(q);
+}
+
+TaskHandle_t sim_queue_holder(QueueHandle_t q) { return q->mutex && q->count == 0 ? q->holder : NULL; }
+
+// Wake the highest priority task blocked on @p q (it retries its operation)
+static void wake_waiter(QueueHandle_t q) {
+    struct tskTaskControlBlock *best = NULL;
+    for (int i = 0; i < k.task_count; i++) {
+        struct tskTaskControlBlock *t = k.tasks[i];
+        if (t->state == T_BLOCKED && t->wait_obj == q && (!best || t->priority > best->priority)) best = t;
+    }
+    if (best) {
+        best->wait_obj = NULL;
+        make_ready(best, false);
+    }
+}
+
+static bool queue_put(QueueHandle_t q, const void *item, bool front) {
+    if (q->count >= q->length) return false;
+    if (q->item_size) {
+        UBaseType_t slot = front ? (q->head + q->length - 1) % q->length : (q->head + q->count) % q->length;
+        memcpy(q->storage + slot * q->item_size, item, q->item_size);
+        if (front) q->head = slot;
+    }
+    q->count++;
+    if (q->mutex) q->holder = NULL;
+    wake_waiter(q);
+    return true;
+}
+
+static bool queue_get(QueueHandle_t q, void *item, bool peek) {
+    if (q->count == 0) return false;
+    if (q->item_size && item) memcpy(item, q->storage + q->head * q->item_size, q->item_size);
+    if (!peek) {
+        if (q->item_size) q->head = (q->head + 1) % q->length;
+        q->count--;
+        if (q->mutex) q->holder = k.current;
+        wake_waiter(q);
+    }
+    return true;
+}
+
+// Retry @p op until it succeeds or the wait expires
+static BaseType_t queue_wait(QueueHandle_t q, TickType_t wait, bool (*op)(QueueHandle_t, void *, bool), void *item, bool flag) {
+    if (op(q, item, flag)) return pdTRUE;
+    if (!k.current || wait == 0) return pdFALSE;
+    uint64_t wake = ticks_to_wake(wait);
+    for (;;) {
+        k.current->wait_obj = q;
+        block_until(wake);
+        if (op(q, item, flag)) return pdTRUE;
+        if (k.current->timed_out || k.now >= wake) return pdFALSE;
+    }
+}
+
+static bool put_back(QueueHandle_t q, void *item, bool unused) { (void)unused; return queue_put(q, item, false); }
+static bool put_front(QueueHandle_t q, void *item, bool unused) { (void)unused; return queue_put(q, item, true); }
+static bool get_item(QueueHandle_t q, void *item, bool peek) { return queue_get(q, item, peek); }
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t wait) {
+    return queue_wait(q, wait, put_back, (void *)item, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t q, const void *item, TickType_t wait) {
+    return queue_wait(q, wait, put_front, (void *)item, false);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *woken) {
+    if (woken) *woken = pdTRUE;
+    return queue_put(q, item, false) ? pdTRUE : errQUEUE_FULL;
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t q, const void *item) {
+    q->count = 0;
+    q->head = 0;
+    return queue_put(q, item, false) ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t wait) {
+    return queue_wait(q, wait, get_item, item, false);
+}
+
+BaseType_t xQueueReceiveFromISR(QueueHandle_t q, void *item, BaseType_t *woken) {
+    if (woken) *woken = pdTRUE;
+    return queue_get(q, item, false) ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xQueuePeek(QueueHandle_t q, void *item, TickType_t wait) {
+    return queue_wait(q, wait, get_item, item, true);
+}
+
+BaseType_t xQueueReset(QueueHandle_t q) {
+    q->count = 0;
+    q->head = 0;
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) { return q->count; }
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t q) { return q->length - q->count; }
+
+/* =========================
+ *  FreeRTOS: software timers
+ * ========================= */
+struct tmrTimerControl {
+    char name[configMAX_TASK_NAME_LEN];
+    TickType_t period;
+    bool auto_reload;
+    void *id;
+    TimerCallbackFunction_t callback;
+    uint64_t event;             // 0 when stopped
+};
+
+static void timer_fire(void *arg, uint64_t tag) {
+    (void)tag;
+    struct tmrTimerControl *t = arg;
+    t->event = t->auto_reload ? sim_schedule(k.now + (uint64_t)t->period * TICK_US, timer_fire, t, 0) : 0;
+    t->callback(t);
+}
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t auto_reload,
+                           void *id, TimerCallbackFunction_t callback) {
+    struct tmrTimerControl *t = calloc(1, sizeof(*t));
+    snprintf(t->name, sizeof(t->name), "%s", name ? name : "?");
+    t->period = period ? period : 1;
+    t->auto_reload = auto_reload;
+    t->id = id;
+    t->callback = callback;
+    return t;
+}
+
+BaseType_t xTimerStart(TimerHandle_t t, TickType_t wait) {
+    (void)wait;
+    if (t->event) sim_cancel(t->event);
+    t->event = sim_schedule(k.now + (uint64_t)t->period * TICK_US, timer_fire, t, 0);
+    return pdPASS;
+}
+
+BaseType_t xTimerStop(TimerHandle_t t, TickType_t wait) {
+    (void)wait;
+    if (t->event) sim_cancel(t->event);
+    t->event = 0;
+    return pdPASS;
+}
+
+BaseType_t xTimerReset(TimerHandle_t t, TickType_t wait) { return xTimerStart(t, wait); }
+
+BaseType_t xTimerChangePeriod(TimerHandle_t t, TickType_t period, TickType_t wait) {
+    t->period = period ? period : 1;
+    return xTimerStart(t, wait);
+}
+
+BaseType_t xTimerDelete(TimerHandle_t t, TickType_t wait) {
+    xTimerStop(t, wait);
+    free(t);
+    return pdPASS;
+}
+
+BaseType_t xTimerIsTimerActive(TimerHandle_t t) { return t->event != 0; }
+void *pvTimerGetTimerID(TimerHandle_t t) { return t->id; }
+
+/* =========================
+ *  pico time API
+ * ========================= */
+uint64_t time_us_64(void) { return k.now; }
+uint32_t time_us_32(void) { return (uint32_t)k.now; }
+absolute_time_t get_absolute_time(void) { return k.now; }
+
+void sleep_us(uint64_t us) { sim_sleep(us); }
+void sleep_ms(uint32_t ms) { sim_sleep(1000ull * ms); }
+void sleep_until(absolute_time_t t) { if (t > k.now) sim_sleep(t - k.now); }
+void busy_wait_us(uint64_t us) { sim_busy(us); }
+void busy_wait_us_32(uint32_t us) { sim_busy(us); }
+void busy_wait_ms(uint32_t ms) { sim_busy(1000ull * ms); }
+uint get_core_num(void) { return 0; }
+
+typedef struct {
+    alarm_id_t id;
+    uint64_t event;
+    uint64_t due;
+    alarm_callback_t callback;
+    repeating_timer_t *rt;
+    void *user_data;
+    bool used;
+} sim_alarm_t;
+
+#define MAX_ALARMS 64
+static sim_alarm_t alarms[MAX_ALARMS];
+static alarm_id_t next_alarm_id = 1;
+
+static void alarm_fire(void *arg, uint64_t tag) {
+    (void)tag;
+    sim_alarm_t *a = arg;
+    int64_t again;
+    if (a->rt) {
+        again = a->rt->callback(a->rt) ? a->rt->delay_us : 0;
+    } else {
+        again = a->callback(a->id, a->user_data);
+    }
+    if (!a->used) return;                   // cancelled from its own callback
+    if (again == 0) {
+        a->used = false;
+        return;
+    }
+    // >0: relative to the previous due time, <0: relative to now (pico semantics)
+    a->due = again > 0 ? a->due + (uint64_t)again : k.now + (uint64_t)(-again);
+    a->event = sim_schedule(a->due, alarm_fire, a, 0);
+}
+
+static alarm_id_t alarm_add(uint64_t due, alarm_callback_t cb, void *user_data, repeating_timer_t *rt) {
+    for (int i = 0; i < MAX_ALARMS; i++) {
+        sim_alarm_t *a = &alarms[i];
+        if (a->used) continue;
+        a->used = true;
+        a->id = next_alarm_id++;
+        a->due = due;
+        a->callback = cb;
+        a->user_data = user_data;
+        a->rt = rt;
+        a->event = sim_schedule(due, alarm_fire, a, 0);
+        return a->id;
+    }
+    return -1;
+}
+
+alarm_id_t add_alarm_at(absolute_time_t time, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    if (time <= k.now && !fire_if_past) return 0;
+    return alarm_add(time, callback, user_data, NULL);
+}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    return add_alarm_at(k.now + us, callback, user_data, fire_if_past || us > 0);
+}
+
+alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    return add_alarm_in_us(1000ull * ms, callback, user_data, fire_if_past);
+}
+
+bool cancel_alarm(alarm_id_t id) {
+    for (int i = 0; i < MAX_ALARMS; i++) {
+        if (alarms[i].used && alarms[i].id == id) {
+            sim_cancel(alarms[i].event);
+            alarms[i].used = false;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void *user_data, repeating_timer_t *out) {
+    if (delay_us == 0) delay_us = 1;
+    out->delay_us = delay_us;
+    out->callback = callback;
+    out->user_data = user_data;
+    uint64_t period = (uint64_t)(delay_us < 0 ? -delay_us : delay_us);
+    out->alarm_id = alarm_add(k.now + period, NULL, NULL, out);
+    return out->alarm_id > 0;
+}
+
+bool add_repeating_timer_ms(int32_t delay_ms, repeating_timer_callback_t callback, void *user_data, repeating_timer_t *out) {
+    return add_repeating_timer_us((int64_t)delay_ms * 1000, callback, user_data, out);
+}
+
+bool cancel_repeating_timer(repeating_timer_t *timer) {
+    return cancel_alarm(timer->alarm_id);
+}
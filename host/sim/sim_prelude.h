@@ -0,0 +1,14 @@
+// Force-included (-include) into the application sources built for the simulator.
+// Console output is captured as effects and main() becomes the scenario entry point.
+#pragma once
+
+#include <stdio.h>
+
+int sim_printf(const char *fmt, ...);
+int sim_puts(const char *s);
+int sim_putchar(int c);
+
+#define printf      sim_printf
+#define puts        sim_puts
+#define putchar     sim_putchar
+#define main        sim_app_main
@@ -0,0 +1,589 @@
+// Scenario runner: feeds stimuli into the simulated HAT, measures the latency from
+// each stimulus to the first effect it causes and checks expectations.
+//
+// Scenario file (one command per line, '#' starts a comment):
+//
+//   name    morse_roundtrip
+//   cores   2                       # virtual cores (default configNUMBER_OF_CORES)
+//   stop    10min                   # end of the simulation
+//
+//   <time>  <command>               # time: 1500 (ms), 1.5s, 200ms, 50us, 2min, +300ms (relative)
+//   repeat  <count> <period>        # the block is replayed count times, period apart;
+//     <time> <command>              # times inside are relative to the iteration start
+//   end
+//
+// Commands:
+//   press <button1|button2|sw1|sw2|gpioN> [hold]   falling edge, rising edge after hold (80 ms)
+//   tilt <left|middle|right|ax>                    accelerometer x in g
+//   imu ax ay az gx gy gz t
+//   serial "text\n"                                bytes arriving on the USB serial port
+//   light <lux> | temp <c> | humidity <pct>
+//   mark <label>                                   a stimulus without an input change
+//   expect <stdout|display|buzzer|led> "substr" within <dur>
+//
+// Usage: sim_main_project [--trace file|-] scenario.scn [more.scn ...]
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tkjhat/pins.h"
+
+#include "sim.h"
+
+int sim_app_main(void);
+
+#define MAX_LINE            512
+#define MAX_STIMULUS_KEYS   32
+#define MAX_EXPECT_REPORT   10
+#define DEFAULT_HOLD_US     80000
+
+/* =========================
+ *  Small dynamic arrays
+ * ========================= */
+typedef struct {
+    uint64_t *v;
+    size_t n, cap;
+} samples_t;
+
+static void samples_add(samples_t *s, uint64_t x) {
+    if (s->n == s->cap) {
+        s->cap = s->cap ? 2 * s->cap : 64;
+        s->v = realloc(s->v, s->cap * sizeof(*s->v));
+    }
+    s->v[s->n++] = x;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+/* =========================
+ *  Scenario actions
+ * ========================= */
+typedef enum { A_PIN, A_IMU, A_SERIAL, A_AMBIENT, A_MARK, A_EXPECT } action_kind_t;
+
+typedef struct action {
+    action_kind_t kind;
+    char key[32];           // stimulus key for the latency metrics ("" = not a stimulus)
+    unsigned gpio;
+    bool level;
+    float values[7];
+    char *text;
+    size_t text_len;
+    sim_effect_kind_t effect;
+    uint64_t within_us;
+    int line;
+} action_t;
+
+typedef struct {
+    char key[32];
+    uint64_t last_us;                       // time of the latest occurrence
+    bool seen[SIM_EFFECT_KINDS];            // effect already attributed to it
+    samples_t latency[SIM_EFFECT_KINDS];
+    uint32_t count;
+} stimulus_t;
+
+typedef struct expectation {
+    const action_t *a;
+    uint64_t start_us;
+    uint64_t deadline_event;
+    bool done;
+    struct expectation *next;
+} expectation_t;
+
+static struct {
+    char name[64];
+    const char *path;
+    FILE *trace;
+
+    stimulus_t stimuli[MAX_STIMULUS_KEYS];
+    int stimulus_count;
+    stimulus_t *latest;                     // effects are attributed to the latest stimulus
+
+    expectation_t *pending;
+    uint32_t expect_total, expect_passed, expect_failed;
+    samples_t expect_latency;
+    char failures[MAX_EXPECT_REPORT][160];
+    uint64_t effects[SIM_EFFECT_KINDS];
+} sc;
+
+static const char *const effect_names[SIM_EFFECT_KINDS] = { "stdout", "display", "buzzer", "led" };
+
+const char *sim_effect_name(sim_effect_kind_t kind) { return effect_names[kind]; }
+
+void sim_log(const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    fprintf(stderr, "[sim %10.3f ms] ", sim_now() / 1000.0);
+    vfprintf(stderr, fmt, ap);
+    fputc('\n', stderr);
+    va_end(ap);
+}
+
+static void trace(const char *what, const char *text) {
+    if (sc.trace) fprintf(sc.trace, "%12.3f %-8s %s\n", sim_now() / 1000.0, what, text);
+}
+
+static stimulus_t *stimulus_get(const char *key) {
+    for (int i = 0; i < sc.stimulus_count; i++)
+        if (strcmp(sc.stimuli[i].key, key) == 0) return &sc.stimuli[i];
+    if (sc.stimulus_count == MAX_STIMULUS_KEYS) return NULL;
+    stimulus_t *s = &sc.stimuli[sc.stimulus_count++];
+    snprintf(s->key, sizeof(s->key), "%s", key);
+    return s;
+}
+
+// A stimulus opens a new window: the first effect of each kind before the next
+// stimulus is its latency
+static void stimulus_fire(const char *key) {
+    stimulus_t *s = stimulus_get(key);
+    if (!s) return;
+    sc.latest = s;
+    s->last_us = sim_now();
+    s->count++;
+    memset(s->seen, 0, sizeof(s->seen));
+    trace("stimulus", key);
+}
+
+static void expectation_close(expectation_t *e, bool passed) {
+    e->done = true;
+    if (passed) {
+        sc.expect_passed++;
+        samples_add(&sc.expect_latency, sim_now() - e->start_us);
+        sim_cancel(e->deadline_event);
+        return;
+    }
+    if (sc.expect_failed < MAX_EXPECT_REPORT) {
+        snprintf(sc.failures[sc.expect_failed], sizeof(sc.failures[0]),
+                 "line %d @ %.3f s: no %s \"%s\" within %.0f ms", e->a->line, e->start_us / 1e6,
+                 effect_names[e->a->effect], e->a->text, e->a->within_us / 1000.0);
+    }
+    sc.expect_failed++;
+}
+
+void sim_metrics_effect(sim_effect_kind_t kind, const char *text) {
+    sc.effects[kind]++;
+    stimulus_t *s = sc.latest;
+    if (s && !s->seen[kind]) {
+        s->seen[kind] = true;
+        samples_add(&s->latency[kind], sim_now() - s->last_us);
+    }
+    for (expectation_t **p = &sc.pending; *p;) {
+        expectation_t *e = *p;
+        if (!e->done && e->a->effect == kind && strstr(text, e->a->text)) expectation_close(e, true);
+        if (e->done) {
+            *p = e->next;
+            free(e);
+        } else {
+            p = &e->next;
+        }
+    }
+}
+
+void sim_effect(sim_effect_kind_t kind, const char *fmt, ...) {
+    char text[512];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(text, sizeof(text), fmt, ap);
+    va_end(ap);
+    trace(effect_names[kind], text);
+    sim_metrics_effect(kind, text);
+}
+
+/* =========================
+ *  Running actions
+ * ========================= */
+static void expectation_deadline(void *arg, uint64_t tag) {
+    (void)tag;
+    expectation_t *e = arg;
+    if (!e->done) expectation_close(e, false);
+}
+
+static void pin_release(void *arg, uint64_t gpio) {
+    (void)arg;
+    sim_hat_set_pin((unsigned)gpio, true);
+}
+
+static void action_run(void *arg, uint64_t hold_us) {
+    const action_t *a = arg;
+    if (a->key[0]) stimulus_fire(a->key);
+
+    switch (a->kind) {
+    case A_PIN:
+        sim_hat_set_pin(a->gpio, a->level);
+        if (hold_us) sim_schedule(sim_now() + hold_us, pin_release, NULL, a->gpio);
+        break;
+    case A_IMU:
+        sim_hat_set_imu(a->values);
+        break;
+    case A_SERIAL:
+        sim_hat_serial_input(a->text, a->text_len);
+        break;
+    case A_AMBIENT:
+        sim_hat_set_ambient(a->values[0], a->values[1], a->values[2]);
+        break;
+    case A_MARK:
+        break;
+    case A_EXPECT: {
+        expectation_t *e = calloc(1, sizeof(*e));
+        e->a = a;
+        e->start_us = sim_now();
+        e->deadline_event = sim_schedule(sim_now() + a->within_us, expectation_deadline, e, 0);
+        e->next = sc.pending;
+        sc.pending = e;
+        sc.expect_total++;
+        break;
+    }
+    }
+}
+
+/* =========================
+ *  Parser
+ * ========================= */
+static int parse_error(int line, const char *msg, const char *tok) {
+    fprintf(stderr, "%s:%d: %s%s%s\n", sc.path, line, msg, tok ? ": " : "", tok ? tok : "");
+    return -1;
+}
+
+// "1500" (ms), "1.5s", "200ms", "50us", "2min"
+static bool parse_duration(const char *s, uint64_t *out) {
+    char *end;
+    errno = 0;
+    double v = strtod(s, &end);
+    if (end == s || errno || v < 0) return false;
+    double scale = 1000.0;
+    if (strcmp(end, "us") == 0) scale = 1.0;
+    else if (strcmp(end, "ms") == 0 || *end == '\0') scale = 1000.0;
+    else if (strcmp(end, "s") == 0) scale = 1e6;
+    else if (strcmp(end, "min") == 0) scale = 60e6;
+    else if (strcmp(end, "h") == 0) scale = 3600e6;
+    else return false;
+    *out = (uint64_t)(v * scale + 0.5);
+    return true;
+}
+
+// Quoted string with \n \r \t \\ \" escapes; returns the rest of the line
+static char *parse_quoted(char *s, char **text, size_t *len) {
+    while (isspace((unsigned char)*s)) s++;
+    if (*s != '"') return NULL;
+    char *out = malloc(strlen(s) + 1);
+    size_t n = 0;
+    for (s++; *s && *s != '"'; s++) {
+        char c = *s;
+        if (c == '\\' && s[1]) {
+            s++;
+            c = *s == 'n' ? '\n' : *s == 'r' ? '\r' : *s == 't' ? '\t' : *s;
+        }
+        out[n++] = c;
+    }
+    if (*s != '"') {
+        free(out);
+        return NULL;
+    }
+    out[n] = '\0';
+    *text = out;
+    *len = n;
+    return s + 1;
+}
+
+static bool parse_pin(const char *s, unsigned *gpio) {
+    if (strcmp(s, "button1") == 0) *gpio = BUTTON1;
+    else if (strcmp(s, "button2") == 0) *gpio = BUTTON2;
+    else if (strcmp(s, "sw1") == 0) *gpio = SW1_PIN;
+    else if (strcmp(s, "sw2") == 0) *gpio = SW2_PIN;
+    else if (strncmp(s, "gpio", 4) == 0 && isdigit((unsigned char)s[4])) *gpio = (unsigned)atoi(s + 4);
+    else return false;
+    return *gpio < 30;
+}
+
+// Parses "<command> args..." into @p a. Returns the hold time for presses via @p hold.
+static int parse_command(char *cmd, int line, action_t *a, uint64_t *hold) {
+    char *rest = cmd + strcspn(cmd, " \t");
+    if (*rest) *rest++ = '\0';
+    while (isspace((unsigned char)*rest)) rest++;
+    a->line = line;
+    *hold = 0;
+
+    if (strcmp(cmd, "press") == 0) {
+        char *pin = strtok(rest, " \t");
+        char *dur = strtok(NULL, " \t");
+        if (!pin || !parse_pin(pin, &a->gpio)) return parse_error(line, "bad pin", pin);
+        *hold = DEFAULT_HOLD_US;
+        if (dur && !parse_duration(dur, hold)) return parse_error(line, "bad hold time", dur);
+        a->kind = A_PIN;
+        a->level = false;
+        snprintf(a->key, sizeof(a->key), "press %s", pin);
+    } else if (strcmp(cmd, "tilt") == 0) {
+        float ax;
+        if (strcmp(rest, "left") == 0) ax = -0.8f;
+        else if (strcmp(rest, "right") == 0) ax = 0.8f;
+        else if (strcmp(rest, "middle") == 0) ax = 0.0f;
+        else if (sscanf(rest, "%f", &ax) != 1) return parse_error(line, "bad tilt", rest);
+        float az = ax * ax < 1.0f ? 1.0f - ax * ax : 0.0f;
+        const float v[7] = { ax, 0.0f, az, 0.0f, 0.0f, 0.0f, 25.0f };
+        memcpy(a->values, v, sizeof(v));
+        a->kind = A_IMU;
+        snprintf(a->key, sizeof(a->key), "tilt %s", rest);
+    } else if (strcmp(cmd, "imu") == 0) {
+        float *v = a->values;
+        if (sscanf(rest, "%f %f %f %f %f %f %f", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6]) != 7)
+            return parse_error(line, "imu needs 7 values", NULL);
+        a->kind = A_IMU;
+        snprintf(a->key, sizeof(a->key), "imu");
+    } else if (strcmp(cmd, "serial") == 0) {
+        if (!parse_quoted(rest, &a->text, &a->text_len)) return parse_error(line, "serial needs a quoted string", NULL);
+        a->kind = A_SERIAL;
+        snprintf(a->key, sizeof(a->key), "serial");
+    } else if (strcmp(cmd, "light") == 0 || strcmp(cmd, "temp") == 0 || strcmp(cmd, "humidity") == 0) {
+        float v;
+        if (sscanf(rest, "%f", &v) != 1) return parse_error(line, "bad value", rest);
+        a->values[0] = -1.0f;
+        a->values[1] = -1000.0f;
+        a->values[2] = -1.0f;
+        a->values[cmd[0] == 'l' ? 0 : cmd[0] == 't' ? 1 : 2] = v;
+        a->kind = A_AMBIENT;
+        snprintf(a->key, sizeof(a->key), "%s", cmd);
+    } else if (strcmp(cmd, "mark") == 0) {
+        a->kind = A_MARK;
+        snprintf(a->key, sizeof(a->key), "mark %.26s", rest);
+    } else if (strcmp(cmd, "expect") == 0) {
+        char *kind = strtok(rest, " \t");
+        char *after = kind ? kind + strlen(kind) + 1 : NULL;
+        int k = -1;
+        for (int i = 0; kind && i < SIM_EFFECT_KINDS; i++)
+            if (strcmp(kind, effect_names[i]) == 0) k = i;
+        if (k < 0) return parse_error(line, "bad effect kind", kind);
+        after = parse_quoted(after, &a->text, &a->text_len);
+        if (!after) return parse_error(line, "expect needs a quoted string", NULL);
+        char *word = strtok(after, " \t");
+        char *dur = strtok(NULL, " \t");
+        if (!word || strcmp(word, "within") != 0 || !dur || !parse_duration(dur, &a->within_us))
+            return parse_error(line, "expect needs 'within <duration>'", NULL);
+        a->kind = A_EXPECT;
+        a->effect = (sim_effect_kind_t)k;
+    } else {
+        return parse_error(line, "unknown command", cmd);
+    }
+    return 0;
+}
+
+typedef struct {
+    uint64_t t;
+    action_t *a;
+    uint64_t hold;
+} timed_action_t;
+
+static int load_scenario(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    sc.path = path;
+    const char *base = strrchr(path, '/');
+    snprintf(sc.name, sizeof(sc.name), "%s", base ? base + 1 : path);
+
+    timed_action_t block[256];
+    int block_len = 0;
+    bool in_repeat = false;
+    unsigned repeat_count = 0;
+    uint64_t repeat_period = 0, repeat_start = 0;
+    uint64_t last_t = 0;
+    bool have_stop = false;
+
+    char buf[MAX_LINE];
+    int line = 0, rc = 0;
+    while (rc == 0 && fgets(buf, sizeof(buf), f)) {
+        line++;
+        char *hash = NULL;
+        bool quoted = false;
+        for (char *p = buf; *p; p++) {
+            if (*p == '"' && (p == buf || p[-1] != '\\')) quoted = !quoted;
+            if (*p == '#' && !quoted) {
+                hash = p;
+                break;
+            }
+        }
+        if (hash) *hash = '\0';
+        char *s = buf;
+        while (isspace((unsigned char)*s)) s++;
+        char *e = s + strlen(s);
+        while (e > s && isspace((unsigned char)e[-1])) *--e = '\0';
+        if (!*s) continue;
+
+        char *word = s;
+        char *rest = s + strcspn(s, " \t");
+        if (*rest) *rest++ = '\0';
+        while (isspace((unsigned char)*rest)) rest++;
+
+        if (strcmp(word, "name") == 0) {
+            snprintf(sc.name, sizeof(sc.name), "%s", rest);
+        } else if (strcmp(word, "cores") == 0) {
+            sim_set_cores(atoi(rest));
+        } else if (strcmp(word, "stop") == 0) {
+            uint64_t t;
+            if (!parse_duration(rest, &t)) rc = parse_error(line, "bad stop time", rest);
+            sim_set_end(t);
+            have_stop = true;
+        } else if (strcmp(word, "repeat") == 0) {
+            char *count = strtok(rest, " \t");
+            char *period = strtok(NULL, " \t");
+            if (in_repeat) rc = parse_error(line, "nested repeat", NULL);
+            else if (!count || !period || atoi(count) <= 0 || !parse_duration(period, &repeat_period))
+                rc = parse_error(line, "repeat needs <count> <period>", NULL);
+            in_repeat = true;
+            repeat_count = count ? (unsigned)atoi(count) : 0;
+            repeat_start = last_t;
+            block_len = 0;
+            last_t = 0;
+        } else if (strcmp(word, "end") == 0) {
+            if (!in_repeat) {
+                rc = parse_error(line, "end without repeat", NULL);
+                break;
+            }
+            for (unsigned i = 0; i < repeat_count; i++) {
+                uint64_t base_t = repeat_start + i * repeat_period;
+                for (int j = 0; j < block_len; j++)
+                    sim_schedule(base_t + block[j].t, action_run, block[j].a, block[j].hold);
+            }
+            in_repeat = false;
+            last_t = repeat_start + repeat_count * repeat_period;
+        } else {
+            uint64_t t;
+            bool relative = word[0] == '+';
+            if (!parse_duration(word + relative, &t)) {
+                rc = parse_error(line, "bad time", word);
+                break;
+            }
+            t = relative ? last_t + t : t;
+            last_t = t;
+            action_t *a = calloc(1, sizeof(*a));
+            uint64_t hold;
+            rc = parse_command(rest, line, a, &hold);
+            if (rc) break;
+            if (in_repeat) {
+                if (block_len == (int)(sizeof(block) / sizeof(block[0]))) {
+                    rc = parse_error(line, "repeat block too long", NULL);
+                    break;
+                }
+                block[block_len++] = (timed_action_t){ t, a, hold };
+            } else {
+                sim_schedule(t, action_run, a, hold);
+            }
+        }
+    }
+    fclose(f);
+    if (rc == 0 && in_repeat) rc = parse_error(line, "missing end", NULL);
+    if (rc == 0 && !have_stop) rc = parse_error(line, "missing stop", NULL);
+    return rc;
+}
+
+/* =========================
+ *  Report
+ * ========================= */
+static void print_samples(const char *label, samples_t *s) {
+    qsort(s->v, s->n, sizeof(*s->v), cmp_u64);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < s->n; i++) sum += s->v[i];
+    printf("  %-28s %7zu %9.2f %9.2f %9.2f %9.2f %9.2f\n", label, s->n,
+           s->v[0] / 1000.0, (double)sum / s->n / 1000.0, s->v[s->n / 2] / 1000.0,
+           s->v[(s->n * 99) / 100] / 1000.0, s->v[s->n - 1] / 1000.0);
+}
+
+static void report(double wall_s) {
+    double sim_s = sim_now() / 1e6;
+    printf("== %s ==\n", sc.name);
+    printf("simulated %.3f s in %.3f s wall (%.0fx real time)\n", sim_s, wall_s,
+           wall_s > 0 ? sim_s / wall_s : 0.0);
+
+    sim_task_stats_t tasks[32];
+    int n = sim_task_stats(tasks, 32);
+    printf("\n  %-16s %4s %10s %10s %6s\n", "task", "prio", "runs", "busy_ms", "cpu%");
+    for (int i = 0; i < n; i++) {
+        const sim_task_stats_t *t = &tasks[i];
+        printf("  %-16s %4u %10u %10.1f %6.2f\n", t->name, t->priority, t->activations,
+               t->busy_us / 1000.0, sim_s > 0 ? t->busy_us / 1e4 / sim_s : 0.0);
+    }
+
+    printf("\n  %-28s %7s %9s %9s %9s %9s %9s\n", "latency (ms)", "n", "min", "avg", "p50", "p99", "max");
+    for (int i = 0; i < sc.stimulus_count; i++) {
+        for (int k = 0; k < SIM_EFFECT_KINDS; k++) {
+            samples_t *s = &sc.stimuli[i].latency[k];
+            if (!s->n) continue;
+            char label[64];
+            snprintf(label, sizeof(label), "%s -> %s", sc.stimuli[i].key, effect_names[k]);
+            print_samples(label, s);
+        }
+    }
+    if (sc.expect_latency.n) print_samples("expectations met", &sc.expect_latency);
+
+    printf("\n  effects: stdout %llu, display %llu, buzzer %llu, led %llu\n",
+           (unsigned long long)sc.effects[SIM_EFFECT_STDOUT], (unsigned long long)sc.effects[SIM_EFFECT_DISPLAY],
+           (unsigned long long)sc.effects[SIM_EFFECT_BUZZER], (unsigned long long)sc.effects[SIM_EFFECT_LED]);
+    uint32_t unfinished = sc.expect_total - sc.expect_passed - sc.expect_failed;
+    printf("  expectations: %u passed, %u failed, %u still open at stop\n",
+           sc.expect_passed, sc.expect_failed, unfinished);
+    for (uint32_t i = 0; i < sc.expect_failed && i < MAX_EXPECT_REPORT; i++)
+        printf("    FAIL %s\n", sc.failures[i]);
+    printf("\n");
+}
+
+static int run_scenario(const char *path, const char *trace_path) {
+    if (load_scenario(path) != 0) return 2;
+    if (trace_path) {
+        sc.trace = strcmp(trace_path, "-") == 0 ? stdout : fopen(trace_path, "w");
+        if (!sc.trace) {
+            fprintf(stderr, "%s: %s\n", trace_path, strerror(errno));
+            return 2;
+        }
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    sim_app_main();                 // returns when the scheduler reaches the stop time
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    if (sc.trace && sc.trace != stdout) fclose(sc.trace);
+    report((t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9);
+    fflush(stdout);
+    return sc.expect_failed ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+    const char *trace_path = NULL;
+    int first = 1;
+    for (; first < argc && argv[first][0] == '-' && argv[first][1]; first++) {
+        if (strcmp(argv[first], "--trace") == 0 && first + 1 < argc) {
+            trace_path = argv[++first];
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[first]);
+            return 2;
+        }
+    }
+    if (first >= argc) {
+        fprintf(stderr, "usage: %s [--trace file|-] scenario.scn [more.scn ...]\n", argv[0]);
+        return 2;
+    }
+
+    // Every scenario starts from a fresh process: the application keeps its state in globals
+    int worst = 0;
+    for (int i = first; i < argc; i++) {
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0) _exit(run_scenario(argv[i], trace_path));
+        int status = 0;
+        waitpid(pid, &status, 0);
+        int rc = WIFEXITED(status) ? WEXITSTATUS(status) : 3;
+        if (!WIFEXITED(status)) fprintf(stderr, "%s: simulator crashed (signal %d)\n", argv[i], WTERMSIG(status));
+        if (rc > worst) worst = rc;
+    }
+    return worst;
+}
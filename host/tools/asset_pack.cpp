@@ -0,0 +1,617 @@
+// Builds the asset packs read in place from flash by the board (tkjhat/asset.h,
+// tkjhat/asset_play.h).
+//
+//   asset_pack <out.bin> <spec>...
+//       write a pack, to be loaded after the program:
+//       picotool load -o 0x10100000 out.bin   (XIP_BASE + ASSET_FLASH_OFFSET)
+//   asset_pack --c <symbol> <out.c> <spec>...
+//       write the pack as a const array to link into the program instead
+//   asset_pack list <pack.bin>
+//       print the index and check every CRC
+//   asset_pack selftest
+//       pack synthetic images and clips, read them back with the SDK code and
+//       compare; damaged packs must be refused. Exit code 0 when all checks pass.
+//
+// A spec is name=file[,file...][@option...]:
+//   images: PBM files (P1 or P4), one per frame, all the same size; black
+//           pixels are lit. @raw or @rle; by default a 128x64 image stays raw
+//           (sent to the panel straight from flash), a smaller one takes
+//           whichever is smaller.
+//   clips:  WAV files (8 or 16-bit PCM, channels mixed). @adpcm (default, 4 bits
+//           per sample) or @pwm (16 bits per sample, played by DMA from flash
+//           without the CPU), @<rate> to resample, e.g. chime=chime.wav@pwm@8000.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <tkjhat/asset.h>
+#include <tkjhat/crc.h>
+
+namespace {
+
+using Bytes = std::vector<uint8_t>;
+
+// ---- Input ----
+struct Image {
+    unsigned width = 0, height = 0;
+    std::vector<uint8_t> pixels;        // 1 = lit, row major
+    bool at(unsigned x, unsigned y) const { return pixels[y * width + x]; }
+};
+
+bool read_file(const std::string &path, Bytes &out) {
+    std::ifstream f(path, std::ios::binary);
+    if (!f) return false;
+    out.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+    return true;
+}
+
+bool read_pbm(const std::string &path, Image &img, std::string &err) {
+    Bytes b;
+    if (!read_file(path, b)) return err = "cannot read " + path, false;
+    size_t pos = 0;
+    auto token = [&]() {
+        std::string t;
+        while (pos < b.size()) {
+            if (b[pos] == '#') {
+                while (pos < b.size() && b[pos] != '\n') pos++;
+            } else if (isspace(b[pos])) {
+                if (!t.empty()) break;
+                pos++;
+            } else {
+                t += static_cast<char>(b[pos++]);
+            }
+        }
+        return t;
+    };
+    std::string magic = token();
+    if (magic != "P1" && magic != "P4") return err = path + ": not a PBM (P1/P4)", false;
+    img.width = static_cast<unsigned>(std::strtoul(token().c_str(), nullptr, 10));
+    img.height = static_cast<unsigned>(std::strtoul(token().c_str(), nullptr, 10));
+    if (!img.width || !img.height || img.width > 4096 || img.height > 4096) return err = path + ": bad size", false;
+    img.pixels.assign(img.width * img.height, 0);
+    if (magic == "P4") {
+        pos++;      // single whitespace after the height
+        unsigned row = (img.width + 7) / 8;
+        if (b.size() < pos + row * img.height) return err = path + ": truncated", false;
+        for (unsigned y = 0; y < img.height; y++)
+            for (unsigned x = 0; x < img.width; x++)
+                img.pixels[y * img.width + x] = (b[pos + y * row + x / 8] >> (7 - x % 8)) & 1;
+    } else {
+        for (auto &p : img.pixels) {
+            while (pos < b.size() && (isspace(b[pos]))) pos++;
+            if (pos >= b.size()) return err = path + ": truncated", false;
+            p = b[pos++] == '1';
+        }
+    }
+    return true;
+}
+
+struct Clip {
+    unsigned rate = 0;
+    std::vector<int16_t> samples;
+};
+
+uint32_t le32(const uint8_t *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24); }
+uint16_t le16(const uint8_t *p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+
+bool read_wav(const std::string &path, Clip &clip, std::string &err) {
+    Bytes b;
+    if (!read_file(path, b)) return err = "cannot read " + path, false;
+    if (b.size() < 12 || std::memcmp(b.data(), "RIFF", 4) || std::memcmp(b.data() + 8, "WAVE", 4))
+        return err = path + ": not a WAV", false;
+    unsigned channels = 0, bits = 0;
+    for (size_t pos = 12; pos + 8 <= b.size();) {
+        uint32_t len = le32(&b[pos + 4]);
+        const uint8_t *d = &b[pos + 8];
+        if (pos + 8 + len > b.size()) return err = path + ": truncated", false;
+        if (!std::memcmp(&b[pos], "fmt ", 4) && len >= 16) {
+            if (le16(d) != 1) return err = path + ": only PCM WAV", false;
+            channels = le16(d + 2);
+            clip.rate = le32(d + 4);
+            bits = le16(d + 14);
+        } else if (!std::memcmp(&b[pos], "data", 4)) {
+            if (!channels || (bits != 8 && bits != 16)) return err = path + ": only 8/16-bit PCM", false;
+            size_t frame = channels * bits / 8;
+            for (size_t i = 0; i + frame <= len; i += frame) {
+                int32_t sum = 0;
+                for (unsigned c = 0; c < channels; c++)
+                    sum += bits == 16 ? static_cast<int16_t>(le16(d + i + c * 2)) : (d[i + c] - 128) * 256;
+                clip.samples.push_back(static_cast<int16_t>(sum / static_cast<int32_t>(channels)));
+            }
+            return true;
+        }
+        pos += 8 + len + (len & 1);
+    }
+    return err = path + ": no data chunk", false;
+}
+
+std::vector<int16_t> resample(const std::vector<int16_t> &in, unsigned from, unsigned to) {
+    if (from == to || in.empty()) return in;
+    size_t n = static_cast<size_t>(static_cast<double>(in.size()) * to / from);
+    std::vector<int16_t> out(n);
+    for (size_t i = 0; i < n; i++) {
+        double t = static_cast<double>(i) * from / to;
+        size_t k = static_cast<size_t>(t);
+        double f = t - k, a = in[std::min(k, in.size() - 1)], b = in[std::min(k + 1, in.size() - 1)];
+        out[i] = static_cast<int16_t>(std::lround(a + (b - a) * f));
+    }
+    return out;
+}
+
+// ---- Encoding ----
+Bytes page_pack(const Image &img) {
+    unsigned pages = (img.height + 7) / 8;
+    Bytes out(img.width * pages, 0);
+    for (unsigned y = 0; y < img.height; y++)
+        for (unsigned x = 0; x < img.width; x++)
+            if (img.at(x, y)) out[x + img.width * (y / 8)] |= static_cast<uint8_t>(1u << (y % 8));
+    return out;
+}
+
+struct Asset {
+    asset_entry_t entry{};
+    Bytes data;
+};
+
+void put32(Bytes &b, size_t at, uint32_t v) {
+    for (int i = 0; i < 4; i++) b[at + i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+enum class ImageMode { automatic, raw, rle };
+
+bool make_image(const std::string &name, const std::vector<Image> &frames, ImageMode mode, Asset &a, std::string &err) {
+    for (const Image &f : frames)
+        if (f.width != frames[0].width || f.height != frames[0].height) return err = name + ": frames differ in size", false;
+    std::vector<Bytes> packed;
+    size_t raw_size = 0, rle_size = 0;
+    for (const Image &f : frames) {
+        packed.push_back(page_pack(f));
+        Bytes tmp(packed.back().size() * 2 + 16);
+        raw_size += packed.back().size() + 1;
+        rle_size += asset_rle_encode(packed.back().data(), packed.back().size(), tmp.data(), tmp.size());
+    }
+    bool fullscreen = frames[0].width == 128 && frames[0].height == 64;
+    bool rle = mode == ImageMode::rle || (mode == ImageMode::automatic && !fullscreen && rle_size < raw_size);
+
+    a.entry.type = rle ? ASSET_IMAGE_RLE : ASSET_IMAGE_RAW;
+    a.entry.frames = static_cast<uint16_t>(frames.size());
+    a.entry.width = static_cast<uint16_t>(frames[0].width);
+    a.entry.height = static_cast<uint16_t>(frames[0].height);
+    size_t table = (frames.size() + 1) * 4;
+    a.data.assign(table, 0);
+    for (size_t i = 0; i < packed.size(); i++) {
+        put32(a.data, i * 4, static_cast<uint32_t>(a.data.size()));
+        if (rle) {
+            Bytes tmp(packed[i].size() * 2 + 16);
+            size_t n = asset_rle_encode(packed[i].data(), packed[i].size(), tmp.data(), tmp.size());
+            a.data.insert(a.data.end(), tmp.begin(), tmp.begin() + static_cast<long>(n));
+        } else {
+            a.data.push_back(ASSET_DATA_CONTROL);
+            a.data.insert(a.data.end(), packed[i].begin(), packed[i].end());
+        }
+    }
+    put32(a.data, packed.size() * 4, static_cast<uint32_t>(a.data.size()));
+    return true;
+}
+
+void make_clip(const Clip &clip, bool adpcm, Asset &a) {
+    a.entry.type = adpcm ? ASSET_AUDIO_ADPCM : ASSET_AUDIO_PWM;
+    a.entry.sample_rate = clip.rate;
+    a.entry.samples = static_cast<uint32_t>(clip.samples.size());
+    if (adpcm) {
+        asset_adpcm_t s;
+        asset_adpcm_init(&s);
+        a.data.assign((clip.samples.size() + 1) / 2, 0);
+        for (size_t i = 0; i < clip.samples.size(); i++) {
+            uint8_t code = asset_adpcm_encode(&s, clip.samples[i]);
+            a.data[i / 2] |= static_cast<uint8_t>(i & 1 ? code << 4 : code);
+        }
+    } else {
+        for (int16_t v : clip.samples) {
+            uint16_t level = asset_pwm_level(v);
+            a.data.push_back(static_cast<uint8_t>(level));
+            a.data.push_back(static_cast<uint8_t>(level >> 8));
+        }
+    }
+}
+
+bool build(std::vector<Asset> &assets, Bytes &out, std::string &err) {
+    size_t index = sizeof(asset_header_t) + assets.size() * sizeof(asset_entry_t);
+    out.assign(index, 0);
+    for (Asset &a : assets) {
+        while (out.size() % ASSET_ALIGN) out.push_back(0);
+        a.entry.offset = static_cast<uint32_t>(out.size());
+        a.entry.size = static_cast<uint32_t>(a.data.size());
+        a.entry.crc = crc16_ccitt(CRC16_CCITT_INIT, a.data.data(), a.data.size());
+        out.insert(out.end(), a.data.begin(), a.data.end());
+    }
+    while (out.size() % ASSET_ALIGN) out.push_back(0);
+    if (out.size() > UINT32_MAX) return err = "pack too large", false;
+
+    for (size_t i = 0; i < assets.size(); i++)
+        std::memcpy(&out[sizeof(asset_header_t) + i * sizeof(asset_entry_t)], &assets[i].entry, sizeof(asset_entry_t));
+    asset_header_t h{};
+    h.magic = ASSET_MAGIC;
+    h.version = ASSET_VERSION;
+    h.count = static_cast<uint16_t>(assets.size());
+    h.size = static_cast<uint32_t>(out.size());
+    h.index_crc = crc16_ccitt(CRC16_CCITT_INIT, &out[sizeof(h)], assets.size() * sizeof(asset_entry_t));
+    std::memcpy(out.data(), &h, sizeof(h));
+    return true;
+}
+
+bool set_name(Asset &a, const std::string &name, std::string &err) {
+    if (name.empty() || name.size() >= ASSET_NAME_MAX) return err = "name '" + name + "' must be 1..15 characters", false;
+    std::memset(a.entry.name, 0, sizeof(a.entry.name));
+    std::memcpy(a.entry.name, name.data(), name.size());
+    return true;
+}
+
+std::vector<std::string> split(const std::string &s, char sep) {
+    std::vector<std::string> out;
+    std::stringstream ss(s);
+    for (std::string item; std::getline(ss, item, sep);) out.push_back(item);
+    return out;
+}
+
+bool parse_spec(const std::string &spec, Asset &a, std::string &err) {
+    size_t eq = spec.find('=');
+    if (eq == std::string::npos) return err = "spec '" + spec + "' is not name=file", false;
+    if (!set_name(a, spec.substr(0, eq), err)) return false;
+    std::vector<std::string> parts = split(spec.substr(eq + 1), '@');
+    std::vector<std::string> files = split(parts[0], ',');
+    if (files.empty()) return err = spec + ": no file", false;
+
+    auto ends_with = [](const std::string &s, const char *ext) {
+        size_t n = std::strlen(ext);
+        return s.size() >= n && s.compare(s.size() - n, n, ext) == 0;
+    };
+    if (ends_with(files[0], ".pbm")) {
+        ImageMode mode = ImageMode::automatic;
+        for (size_t i = 1; i < parts.size(); i++) {
+            if (parts[i] == "raw") mode = ImageMode::raw;
+            else if (parts[i] == "rle") mode = ImageMode::rle;
+            else return err = spec + ": unknown image option @" + parts[i], false;
+        }
+        std::vector<Image> frames(files.size());
+        for (size_t i = 0; i < files.size(); i++)
+            if (!read_pbm(files[i], frames[i], err)) return false;
+        if (frames.size() > UINT16_MAX) return err = spec + ": too many frames", false;
+        return make_image(spec.substr(0, eq), frames, mode, a, err);
+    }
+    if (ends_with(files[0], ".wav")) {
+        if (files.size() != 1) return err = spec + ": one WAV per clip", false;
+        bool adpcm = true;
+        unsigned rate = 0;
+        for (size_t i = 1; i < parts.size(); i++) {
+            if (parts[i] == "adpcm") adpcm = true;
+            else if (parts[i] == "pwm") adpcm = false;
+            else if (!parts[i].empty() && std::isdigit(static_cast<unsigned char>(parts[i][0]))) rate = static_cast<unsigned>(std::stoul(parts[i]));
+            else return err = spec + ": unknown clip option @" + parts[i], false;
+        }
+        Clip clip;
+        if (!read_wav(files[0], clip, err)) return false;
+        if (rate) {
+            clip.samples = resample(clip.samples, clip.rate, rate);
+            clip.rate = rate;
+        }
+        make_clip(clip, adpcm, a);
+        return true;
+    }
+    return err = spec + ": only .pbm and .wav", false;
+}
+
+const char *type_name(uint8_t t) {
+    switch (t) {
+    case ASSET_IMAGE_RAW: return "image raw";
+    case ASSET_IMAGE_RLE: return "image rle";
+    case ASSET_AUDIO_PWM: return "audio pwm";
+    case ASSET_AUDIO_ADPCM: return "audio adpcm";
+    default: return "?";
+    }
+}
+
+int list(const Bytes &pack) {
+    asset_pack_t p;
+    int r = asset_pack_open(&p, pack.data(), static_cast<uint32_t>(pack.size()));
+    if (r) {
+        std::printf("not a valid pack (error %d)\n", r);
+        return 1;
+    }
+    int bad = 0;
+    std::printf("%u assets, %u bytes\n", p.count, p.size);
+    for (uint16_t i = 0; i < p.count; i++) {
+        const asset_entry_t &e = p.entries[i];
+        bool ok = asset_verify(&p, &e) == 0;
+        bad += !ok;
+        std::printf("  %-16.16s %-12s %8u bytes  ", e.name, type_name(e.type), e.size);
+        if (e.type == ASSET_IMAGE_RAW || e.type == ASSET_IMAGE_RLE)
+            std::printf("%ux%u x %u frames", e.width, e.height, e.frames);
+        else
+            std::printf("%u samples at %u Hz (%.2f s)", e.samples, e.sample_rate,
+                        e.sample_rate ? static_cast<double>(e.samples) / e.sample_rate : 0.0);
+        std::printf("%s\n", ok ? "" : "  CRC ERROR");
+    }
+    return bad ? 1 : 0;
+}
+
+bool write_file(const std::string &path, const std::string &text) {
+    std::ofstream f(path, std::ios::binary);
+    f << text;
+    return static_cast<bool>(f);
+}
+
+std::string c_array(const std::string &symbol, const Bytes &pack) {
+    std::string s = "// Generated by host/tools/asset_pack, open with asset_pack_open(&pack, " + symbol + ", " + symbol +
+                    "_size).\n\n#include <stdint.h>\n\n";
+    s += "__attribute__((aligned(4))) const uint8_t " + symbol + "[" + std::to_string(pack.size()) + "] = {";
+    char buf[16];
+    for (size_t i = 0; i < pack.size(); i++) {
+        std::snprintf(buf, sizeof(buf), "%s0x%02x,", i % 16 ? " " : "\n    ", pack[i]);
+        s += buf;
+    }
+    s += "\n};\nconst uint32_t " + symbol + "_size = " + std::to_string(pack.size()) + ";\n";
+    return s;
+}
+
+// ---- Selftest ----
+int failures = 0;
+
+void check(bool ok, const std::string &what) {
+    std::printf("  %-4s %s\n", ok ? "ok" : "FAIL", what.c_str());
+    if (!ok) failures++;
+}
+
+Image ball_frame(unsigned f) {
+    Image img;
+    img.width = 128;
+    img.height = 64;
+    img.pixels.assign(128 * 64, 0);
+    int cx = static_cast<int>(8 + (f * 5) % 112), cy = static_cast<int>(32 + 20 * std::sin(f * 0.3));
+    for (int y = 0; y < 64; y++)
+        for (int x = 0; x < 128; x++) {
+            bool ball = (x - cx) * (x - cx) + (y - cy) * (y - cy) <= 36;
+            bool frame = x == 0 || y == 0 || x == 127 || y == 63;
+            bool ground = y > 58 && ((x + static_cast<int>(f)) / 4) % 2;
+            img.pixels[y * 128 + x] = ball || frame || ground;
+        }
+    return img;
+}
+
+// Reference blit, pixel by pixel: the image replaces what it covers
+void blit_reference(const Image &img, std::vector<uint8_t> &fb, int x0, int y0) {
+    for (unsigned y = 0; y < img.height; y++)
+        for (unsigned x = 0; x < img.width; x++) {
+            int fx = x0 + static_cast<int>(x), fy = y0 + static_cast<int>(y);
+            if (fx < 0 || fy < 0 || fx >= 128 || fy >= 64) continue;
+            uint8_t bit = static_cast<uint8_t>(1u << (fy % 8));
+            if (img.at(x, y)) fb[fx + 128 * (fy / 8)] |= bit;
+            else fb[fx + 128 * (fy / 8)] &= static_cast<uint8_t>(~bit);
+        }
+}
+
+double snr_db(const std::vector<int16_t> &ref, const std::vector<int16_t> &got) {
+    double sig = 0, noise = 0;
+    for (size_t i = 0; i < ref.size(); i++) {
+        sig += static_cast<double>(ref[i]) * ref[i];
+        double d = static_cast<double>(ref[i]) - got[i];
+        noise += d * d;
+    }
+    return 10 * std::log10(sig / std::max(noise, 1.0));
+}
+
+int selftest() {
+    std::mt19937 rng(3);
+    std::string err;
+
+    std::vector<Image> frames;
+    for (unsigned f = 0; f < 24; f++) frames.push_back(ball_frame(f));
+    Image sprite;
+    sprite.width = 21;
+    sprite.height = 13;
+    for (unsigned i = 0; i < 21 * 13; i++) sprite.pixels.push_back(rng() % 3 == 0);
+
+    Clip voice;     // 1 s chirp with a decaying envelope at 8 kHz
+    voice.rate = 8000;
+    for (unsigned i = 0; i < 8000; i++) {
+        double t = i / 8000.0;
+        voice.samples.push_back(static_cast<int16_t>(12000 * std::exp(-1.5 * t) * std::sin(2 * M_PI * (300 + 600 * t) * t)));
+    }
+    Clip tone;
+    tone.rate = 16000;
+    for (unsigned i = 0; i < 8000; i++) tone.samples.push_back(static_cast<int16_t>(16000 * std::sin(2 * M_PI * 880 * i / 16000.0)));
+
+    std::vector<Asset> assets(5);
+    bool built = set_name(assets[0], "anim", err) && make_image("anim", frames, ImageMode::automatic, assets[0], err) &&
+                 set_name(assets[1], "anim_rle", err) && make_image("anim_rle", frames, ImageMode::rle, assets[1], err) &&
+                 set_name(assets[2], "sprite", err) && make_image("sprite", {sprite}, ImageMode::rle, assets[2], err) &&
+                 set_name(assets[3], "voice", err) && set_name(assets[4], "tone", err);
+    make_clip(voice, true, assets[3]);
+    make_clip(tone, false, assets[4]);
+    Bytes pack;
+    built = built && build(assets, pack, err);
+    check(built, "pack built " + err);
+    if (!built) return 1;
+
+    std::printf("\npack: %zu bytes\n", pack.size());
+    asset_pack_t p;
+    check(asset_pack_open(&p, pack.data(), static_cast<uint32_t>(pack.size())) == 0, "pack opens");
+    check(p.count == 5, "5 entries");
+    bool crc_ok = true;
+    for (uint16_t i = 0; i < p.count; i++) crc_ok = crc_ok && asset_verify(&p, &p.entries[i]) == 0;
+    check(crc_ok, "data CRCs match");
+
+    // Full-screen raw frames: exactly what the panel expects, straight from the pack
+    const asset_entry_t *anim = asset_find(&p, "anim");
+    const asset_entry_t *anim_rle = asset_find(&p, "anim_rle");
+    bool raw_ok = anim && anim->type == ASSET_IMAGE_RAW && anim->frames == frames.size();
+    bool draw_ok = raw_ok, rle_ok = anim_rle && anim_rle->type == ASSET_IMAGE_RLE;
+    size_t rle_bytes = 0;
+    std::vector<uint8_t> fb(1024);
+    for (uint16_t f = 0; raw_ok && f < frames.size(); f++) {
+        Bytes expect = page_pack(frames[f]);
+        uint32_t len = 0;
+        const uint8_t *d = asset_frame(&p, anim, f, &len);
+        raw_ok = d && len == 1025 && d[0] == ASSET_DATA_CONTROL && std::memcmp(d + 1, expect.data(), 1024) == 0;
+        std::fill(fb.begin(), fb.end(), 0x5A);
+        draw_ok = draw_ok && asset_draw(&p, anim, f, fb.data(), 128, 64, 0, 0) == 0 && fb == expect;
+        if (rle_ok) {
+            std::fill(fb.begin(), fb.end(), 0xA5);
+            rle_ok = asset_draw(&p, anim_rle, f, fb.data(), 128, 64, 0, 0) == 0 && fb == expect;
+            uint32_t n = 0;
+            rle_ok = rle_ok && asset_frame(&p, anim_rle, f, &n);
+            rle_bytes += n;
+        }
+    }
+    check(raw_ok, "128x64 frames stored raw, control byte first, in panel layout");
+    check(draw_ok, "raw frames drawn into the framebuffer");
+    check(rle_ok, "RLE frames decoded straight into the framebuffer");
+    std::printf("  animation: %zu bytes raw, %zu RLE (%.1f %%)\n", frames.size() * 1025, rle_bytes,
+                100.0 * rle_bytes / (frames.size() * 1025.0));
+    check(asset_frame(&p, anim, static_cast<uint16_t>(frames.size()), nullptr) == nullptr, "frame past the end refused");
+
+    // Sprite at odd positions, partly clipped
+    const asset_entry_t *sp = asset_find(&p, "sprite");
+    bool sprite_ok = sp != nullptr;
+    const int pos[][2] = {{0, 0}, {50, 13}, {-3, -5}, {120, 60}, {7, 3}};
+    for (auto &xy : pos) {
+        if (!sprite_ok) break;
+        std::vector<uint8_t> bg(1024), expect;
+        for (auto &v : bg) v = static_cast<uint8_t>(rng());
+        expect = bg;
+        blit_reference(sprite, expect, xy[0], xy[1]);
+        sprite_ok = asset_draw(&p, sp, 0, bg.data(), 128, 64, static_cast<int16_t>(xy[0]), static_cast<int16_t>(xy[1])) == 0 &&
+                    bg == expect;
+    }
+    check(sprite_ok, "21x13 sprite drawn at unaligned and clipped positions");
+
+    // Clips
+    const asset_entry_t *tn = asset_find(&p, "tone");
+    bool pwm_ok = tn && tn->type == ASSET_AUDIO_PWM && tn->samples == tone.samples.size() && tn->size == 2 * tn->samples;
+    for (size_t i = 0; pwm_ok && i < tone.samples.size(); i++)
+        pwm_ok = le16(asset_data(&p, tn) + 2 * i) == asset_pwm_level(tone.samples[i]);
+    check(pwm_ok, "PWM clip holds the levels the DMA writes");
+
+    const asset_entry_t *vc = asset_find(&p, "voice");
+    bool adpcm_ok = vc && vc->type == ASSET_AUDIO_ADPCM && vc->size == 4000;
+    std::vector<int16_t> decoded;
+    std::vector<uint16_t> levels_once(voice.samples.size()), levels_blocks;
+    if (adpcm_ok) {
+        asset_adpcm_t s;
+        asset_adpcm_init(&s);
+        const uint8_t *d = asset_data(&p, vc);
+        for (size_t i = 0; i < vc->samples; i++) decoded.push_back(asset_adpcm_decode(&s, (i & 1) ? d[i / 2] >> 4 : d[i / 2] & 15));
+        asset_adpcm_init(&s);
+        adpcm_ok = asset_adpcm_decode_pwm(&s, vc, d, 0, levels_once.data(), levels_once.size()) == vc->samples;
+        // Blocks of 256, as the DMA interrupt decodes them
+        asset_adpcm_init(&s);
+        uint16_t block[256];
+        for (uint32_t first = 0;;) {
+            size_t n = asset_adpcm_decode_pwm(&s, vc, d, first, block, 256);
+            if (!n) break;
+            levels_blocks.insert(levels_blocks.end(), block, block + n);
+            first += static_cast<uint32_t>(n);
+        }
+    }
+    double snr = adpcm_ok ? snr_db(voice.samples, decoded) : 0;
+    check(adpcm_ok && levels_blocks == levels_once, "ADPCM decoded in blocks of 256 = in one go");
+    std::printf("  voice: %u samples, %zu bytes PCM16, %u ADPCM, SNR %.1f dB\n", vc ? vc->samples : 0,
+                voice.samples.size() * 2, vc ? vc->size : 0, snr);
+    check(snr > 20, "ADPCM SNR above 20 dB");
+
+    // Damaged packs
+    Bytes bad = pack;
+    bad[sizeof(asset_header_t) + 3] ^= 1;
+    check(asset_pack_open(&p, bad.data(), static_cast<uint32_t>(bad.size())) == ASSET_ERR_CRC, "damaged index refused");
+    bad = pack;
+    bad[0] ^= 0xFF;
+    check(asset_pack_open(&p, bad.data(), static_cast<uint32_t>(bad.size())) == ASSET_ERR_MAGIC, "erased / foreign flash refused");
+    check(asset_pack_open(&p, pack.data(), static_cast<uint32_t>(pack.size() - 4)) == ASSET_ERR_RANGE, "truncated region refused");
+    bad = pack;
+    asset_pack_open(&p, bad.data(), static_cast<uint32_t>(bad.size()));
+    bad[asset_find(&p, "voice")->offset + 10] ^= 0x40;
+    check(asset_verify(&p, asset_find(&p, "voice")) == ASSET_ERR_CRC, "damaged clip data detected");
+
+    // Host cost of the decoders (reference for the device, which is ~20-50x slower)
+    asset_pack_open(&p, pack.data(), static_cast<uint32_t>(pack.size()));
+    auto t0 = std::chrono::steady_clock::now();
+    const unsigned reps = 2000;
+    for (unsigned r = 0; r < reps; r++) asset_draw(&p, anim_rle, static_cast<uint16_t>(r % frames.size()), fb.data(), 128, 64, 0, 0);
+    auto t1 = std::chrono::steady_clock::now();
+    asset_adpcm_t s;
+    for (unsigned r = 0; r < 50; r++) {
+        asset_adpcm_init(&s);
+        asset_adpcm_decode_pwm(&s, vc, asset_data(&p, vc), 0, levels_once.data(), levels_once.size());
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    std::printf("\nhost decode: RLE frame %.2f us, ADPCM %.1f ns/sample\n",
+                std::chrono::duration<double, std::micro>(t1 - t0).count() / reps,
+                std::chrono::duration<double, std::nano>(t2 - t1).count() / (50.0 * levels_once.size()));
+
+    std::printf("\n%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
+
+int usage() {
+    std::fprintf(stderr,
+                 "usage: asset_pack <out.bin> name=file[,file...][@opt...]...\n"
+                 "       asset_pack --c <symbol> <out.c> name=file...\n"
+                 "       asset_pack list <pack.bin>\n"
+                 "       asset_pack selftest\n");
+    return 2;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 2) return usage();
+    std::string cmd = argv[1];
+    if (cmd == "selftest") return selftest();
+    if (cmd == "list") {
+        Bytes b;
+        if (argc != 3 || !read_file(argv[2], b)) return usage();
+        return list(b);
+    }
+
+    std::string symbol, out;
+    int first = 2;
+    if (cmd == "--c") {
+        if (argc < 5) return usage();
+        symbol = argv[2];
+        out = argv[3];
+        first = 4;
+    } else {
+        out = cmd;
+    }
+    if (first >= argc) return usage();
+
+    std::vector<Asset> assets(static_cast<size_t>(argc - first));
+    std::string err;
+    for (int i = first; i < argc; i++) {
+        if (!parse_spec(argv[i], assets[static_cast<size_t>(i - first)], err)) {
+            std::fprintf(stderr, "asset_pack: %s\n", err.c_str());
+            return 1;
+        }
+    }
+    Bytes pack;
+    if (!build(assets, pack, err)) {
+        std::fprintf(stderr, "asset_pack: %s\n", err.c_str());
+        return 1;
+    }
+    bool ok = symbol.empty() ? write_file(out, std::string(pack.begin(), pack.end())) : write_file(out, c_array(symbol, pack));
+    if (!ok) {
+        std::fprintf(stderr, "asset_pack: cannot write %s\n", out.c_str());
+        return 1;
+    }
+    return list(pack);
+}
@@ -0,0 +1,149 @@
+// Rebuilds the OLED frames mirrored by tkjhat/display_mirror.h.
+//
+// Reads the record stream from a capture file or a serial port (e.g. the CDC1 port
+// of the board) and writes every frame as a PBM image plus an index:
+//
+//   display_mirror_rx <input> <outdir> [--scale N]
+//
+//   outdir/frame_000000.pbm ...   one image per record
+//   outdir/frames.csv             index,seq,time_us,keyframe,record_bytes
+//   outdir/frames.ffconcat        ffmpeg concat list with the real frame durations:
+//                                 ffmpeg -f concat -i outdir/frames.ffconcat -vf format=gray out.mp4
+//
+// Deltas received before the first keyframe, or after a gap in the sequence
+// numbers, are skipped until the next keyframe.
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <tkjhat/fb_delta.h>
+
+namespace {
+
+// SSD1306 layout: byte x + width * page holds pixels (x, page * 8 + bit)
+bool write_pbm(const std::string &path, const uint8_t *fb, unsigned w, unsigned h, unsigned scale) {
+    FILE *f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+    unsigned W = w * scale, H = h * scale;
+    std::fprintf(f, "P4\n%u %u\n", W, H);
+    std::vector<uint8_t> row((W + 7) / 8);
+    for (unsigned y = 0; y < H; y++) {
+        std::fill(row.begin(), row.end(), 0);
+        unsigned sy = y / scale;
+        for (unsigned x = 0; x < W; x++) {
+            unsigned sx = x / scale;
+            bool on = fb[sx + w * (sy >> 3)] & (1u << (sy & 7));
+            if (on) row[x / 8] |= static_cast<uint8_t>(0x80u >> (x % 8));   // 1 = black in PBM
+        }
+        std::fwrite(row.data(), 1, row.size(), f);
+    }
+    return std::fclose(f) == 0;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        std::fprintf(stderr, "usage: display_mirror_rx <input> <outdir> [--scale N]\n");
+        return 2;
+    }
+    std::string in = argv[1], outdir = argv[2];
+    unsigned scale = 1;
+    for (int i = 3; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--scale") && i + 1 < argc) scale = std::max(1ul, std::strtoul(argv[++i], nullptr, 0));
+    }
+
+    int fd = open(in.c_str(), O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+        std::perror(in.c_str());
+        return 1;
+    }
+    if (isatty(fd)) {
+        termios t{};
+        tcgetattr(fd, &t);
+        cfmakeraw(&t);
+        tcsetattr(fd, TCSANOW, &t);
+    }
+    mkdir(outdir.c_str(), 0755);
+
+    FILE *csv = std::fopen((outdir + "/frames.csv").c_str(), "w");
+    FILE *concat = std::fopen((outdir + "/frames.ffconcat").c_str(), "w");
+    if (!csv || !concat) {
+        std::perror(outdir.c_str());
+        return 1;
+    }
+    std::fprintf(csv, "index,seq,time_us,keyframe,record_bytes\n");
+    std::fprintf(concat, "ffconcat version 1.0\n");
+
+    static fb_mirror_parser_t parser;
+    fb_mirror_parser_init(&parser);
+    uint8_t fb[FB_DELTA_MAX_FB] = {};
+    bool synced = false;
+    uint16_t next_seq = 0;
+    unsigned frames = 0, skipped = 0, bad_ops = 0;
+    uint32_t last_time = 0;
+    std::string last_name;
+    uint8_t buf[4096];
+
+    for (;;) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+
+        for (ssize_t i = 0; i < n; i++) {
+            if (fb_mirror_parse_byte(&parser, buf[i]) != 1) continue;
+
+            const fb_mirror_header_t &h = parser.header;
+            size_t size = static_cast<size_t>(h.width) * (h.height / 8);
+            bool key = h.flags & FB_MIRROR_FLAG_KEYFRAME;
+            if (size == 0 || size > FB_DELTA_MAX_FB) {
+                bad_ops++;
+                continue;
+            }
+            if (key) {
+                std::memset(fb, 0, size);
+                synced = true;
+            } else if (!synced || h.seq != next_seq) {
+                synced = false;         // wait for the next keyframe
+                skipped++;
+                continue;
+            }
+            if (fb_delta_apply(fb, size, parser.ops, h.ops_len) != 0) {
+                bad_ops++;
+                synced = false;
+                continue;
+            }
+            next_seq = static_cast<uint16_t>(h.seq + 1);
+
+            char name[32];
+            std::snprintf(name, sizeof(name), "frame_%06u.pbm", frames);
+            write_pbm(outdir + "/" + name, fb, h.width, h.height, scale);
+            std::fprintf(csv, "%u,%u,%u,%d,%u\n", frames, h.seq, h.time_us, key ? 1 : 0,
+                         h.ops_len + FB_MIRROR_OVERHEAD);
+            // Duration of the previous frame = time until this one
+            if (!last_name.empty()) {
+                std::fprintf(concat, "file %s\nduration %.6f\n", last_name.c_str(), (h.time_us - last_time) / 1e6);
+            }
+            last_name = name;
+            last_time = h.time_us;
+            frames++;
+        }
+    }
+    if (!last_name.empty()) std::fprintf(concat, "file %s\nduration 0.1\nfile %s\n", last_name.c_str(), last_name.c_str());
+    std::fclose(csv);
+    std::fclose(concat);
+
+    std::printf("frames=%u records=%u crc_errors=%u resync_bytes=%u skipped_deltas=%u bad=%u\n",
+                frames, parser.records, parser.crc_errors, parser.resync_bytes, skipped, bad_ops);
+    return 0;
+}
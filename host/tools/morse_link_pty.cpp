@@ -0,0 +1,499 @@
+// Compares the ASCII Morse format of the course with the compact one (tkjhat/morse_wire.h).
+//
+// Both ends run on a pseudo-terminal. The "board" end repeats the serial loop of
+// examples/main_project: it wakes every --tick ms (receiver_task), reads what
+// arrived, and sends at most one ASCII message per wake-up (sender_task prints
+// one message per pass). The old receiver read a single character per wake-up;
+// that variant is measured too. The "host" end reacts as soon as bytes arrive.
+//
+//   morse_link_pty selftest [--tick MS] [--messages N] [--corrupt N]
+//       bursts of N random messages in both directions and single messages on
+//       an idle link, in both formats. Prints messages/s, latency and bytes per
+//       message, then runs the compact format in both directions at once with
+//       every Nth frame damaged. Exit code 0 when every message arrived once,
+//       intact and in order.
+//   morse_link_pty monitor <tty>
+//       talk to a board running examples/main_project: print the messages it
+//       sends and send the lines typed on stdin (compact once the board has
+//       answered, ASCII before).
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <tkjhat/morse_wire.h>
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+struct Options {
+    unsigned tick_ms = 10;          // receiver_task period
+    unsigned messages = 200;
+    unsigned corrupt = 7;
+};
+
+uint32_t now_ms() {
+    using namespace std::chrono;
+    return static_cast<uint32_t>(duration_cast<milliseconds>(clock_type::now().time_since_epoch()).count());
+}
+
+bool set_raw(int fd) {
+    termios t{};
+    if (tcgetattr(fd, &t) != 0) return false;
+    cfmakeraw(&t);
+    return tcsetattr(fd, TCSANOW, &t) == 0;
+}
+
+bool write_all(int fd, const uint8_t *p, size_t n) {
+    while (n) {
+        ssize_t w = write(fd, p, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN) {
+                pollfd pf{ fd, POLLOUT, 0 };
+                poll(&pf, 1, 10);
+                continue;
+            }
+            return false;
+        }
+        p += w;
+        n -= static_cast<size_t>(w);
+    }
+    return true;
+}
+
+// Random text of 1..5 words of 1..6 letters: letters separated by ' ', words by "  "
+std::string random_message(std::mt19937 &rng) {
+    static const char *const letters[] = {
+        ".-", "-...", "-.-.", "-..", ".", "..-.", "--.", "....", "..", ".---", "-.-", ".-..", "--",
+        "-.", "---", ".--.", "--.-", ".-.", "...", "-", "..-", "...-", ".--", "-..-", "-.--", "--..",
+    };
+    std::string m;
+    int words = 1 + static_cast<int>(rng() % 5);
+    for (int w = 0; w < words; w++) {
+        if (w) m += "  ";
+        int n = 1 + static_cast<int>(rng() % 6);
+        for (int i = 0; i < n; i++) {
+            if (i) m += ' ';
+            m += letters[rng() % 26];
+        }
+    }
+    return m;
+}
+
+// The ASCII format ends a message with "  \n"; compare without it
+std::string trim(const char *s, size_t n) {
+    while (n && s[n - 1] == ' ') n--;
+    return std::string(s, n);
+}
+
+/* ===== one end of the link ===== */
+
+struct EndConfig {
+    unsigned tick_ms = 0;           // 0: react to every byte (host), otherwise the board loop
+    bool one_char_per_tick = false; // old receiver_task
+    bool compact = false;           // send compact once the peer has sent a frame
+    unsigned corrupt = 0;           // damage every Nth frame written (compact only)
+};
+
+struct Delivery {
+    std::string text;
+    clock_type::time_point at;
+};
+
+class End {
+public:
+    End(int fd, EndConfig cfg) : fd_(fd), cfg_(cfg) {
+        morse_wire_config_t wc = MORSE_WIRE_DEFAULT_CONFIG;
+        wc.write = write_frame;
+        wc.on_message = on_message;
+        wc.ctx = this;
+        wc.ack_timeout_ms = std::max(50u, 4 * cfg.tick_ms);
+        morse_wire_init(&wire_, &wc);
+    }
+    ~End() { stop(); }
+
+    void start() {
+        running_ = true;
+        thread_ = std::thread([this] { run(); });
+    }
+    void stop() {
+        if (running_.exchange(false) && thread_.joinable()) thread_.join();
+    }
+
+    void hello() {
+        std::lock_guard<std::mutex> lk(m_);
+        morse_wire_hello(&wire_, now_ms());
+    }
+    void submit(const std::string &text) {
+        std::lock_guard<std::mutex> lk(m_);
+        outbox_.push_back(text);
+    }
+    bool peer_compact() {
+        std::lock_guard<std::mutex> lk(m_);
+        return morse_wire_peer_compact(&wire_);
+    }
+    bool idle() {
+        std::lock_guard<std::mutex> lk(m_);
+        return outbox_.empty() && morse_wire_idle(&wire_);
+    }
+    size_t delivered() {
+        std::lock_guard<std::mutex> lk(m_);
+        return delivered_.size();
+    }
+    std::vector<Delivery> deliveries() {
+        std::lock_guard<std::mutex> lk(m_);
+        return delivered_;
+    }
+    morse_wire_stats_t stats() {
+        std::lock_guard<std::mutex> lk(m_);
+        return wire_.stats;
+    }
+    uint64_t bytes_written() {
+        std::lock_guard<std::mutex> lk(m_);
+        return bytes_;
+    }
+    void on_delivery(std::function<void(const std::string &)> fn) { print_ = std::move(fn); }
+
+private:
+    static bool write_frame(void *ctx, const uint8_t *frame, size_t len) {
+        End *e = static_cast<End *>(ctx);
+        std::vector<uint8_t> f(frame, frame + len);
+        if (e->cfg_.corrupt && ++e->frames_ % e->cfg_.corrupt == 0) f[len / 2] ^= 0x10;
+        e->bytes_ += len;
+        return write_all(e->fd_, f.data(), f.size());
+    }
+
+    static void on_message(void *ctx, const char *symbols, size_t len) {
+        End *e = static_cast<End *>(ctx);
+        e->delivered_.push_back({ trim(symbols, len), clock_type::now() });
+        if (e->print_) e->print_(e->delivered_.back().text);
+    }
+
+    void run() {
+        uint8_t buf[4096];
+        auto next = clock_type::now();
+        while (running_) {
+            ssize_t n;
+            if (cfg_.tick_ms) {
+                next += std::chrono::milliseconds(cfg_.tick_ms);
+                std::this_thread::sleep_until(next);
+                n = read(fd_, buf, cfg_.one_char_per_tick ? 1 : sizeof(buf));
+            } else {
+                pollfd pf{ fd_, POLLIN, 0 };
+                n = poll(&pf, 1, 1) > 0 ? read(fd_, buf, sizeof(buf)) : 0;
+            }
+
+            std::lock_guard<std::mutex> lk(m_);
+            uint32_t now = now_ms();
+            if (n > 0) morse_wire_feed(&wire_, buf, static_cast<size_t>(n), now);
+            morse_wire_poll(&wire_, now);
+
+            if (cfg_.compact && morse_wire_peer_compact(&wire_)) {
+                // Everything waiting goes into the TX queue; the batches follow the ACKs
+                while (!outbox_.empty() &&
+                       morse_wire_send(&wire_, outbox_.front().data(), outbox_.front().size(), now) == 0)
+                    outbox_.pop_front();
+            } else {
+                // One message per wake-up on the board, all of them on the host
+                do {
+                    if (outbox_.empty()) break;
+                    std::string line = outbox_.front() + "  \n";
+                    outbox_.pop_front();
+                    bytes_ += line.size();
+                    write_all(fd_, reinterpret_cast<const uint8_t *>(line.data()), line.size());
+                } while (!cfg_.tick_ms);
+            }
+        }
+    }
+
+    const int fd_;
+    const EndConfig cfg_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::mutex m_;                      // everything below
+    morse_wire_t wire_;
+    std::deque<std::string> outbox_;
+    std::vector<Delivery> delivered_;
+    uint64_t bytes_ = 0;
+    uint64_t frames_ = 0;
+    std::function<void(const std::string &)> print_;
+};
+
+/* ===== selftest ===== */
+
+// Host says hello and both ends learn that the other speaks the compact format
+bool wait_compact(End &board, End &host) {
+    for (int i = 0; i < 2000 && !(board.peer_compact() && host.peer_compact()); i++) {
+        if (i % 100 == 0) host.hello();     // again if the first one was damaged
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return board.peer_compact() && host.peer_compact();
+}
+
+struct Check {
+    int failures = 0;
+    void operator()(bool ok, const char *what) {
+        std::printf("  %-52s %s\n", what, ok ? "ok" : "FAIL");
+        if (!ok) failures++;
+    }
+};
+
+// A board end on the master side of a new pty and a host end on the slave side
+struct Link {
+    int master = -1, slave = -1;
+    bool open() {
+        master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+        if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) return false;
+        const char *name = ptsname(master);
+        if (!name) return false;
+        slave = ::open(name, O_RDWR | O_NOCTTY | O_NONBLOCK);
+        return slave >= 0 && set_raw(master) && set_raw(slave);
+    }
+    ~Link() {
+        if (slave >= 0) close(slave);
+        if (master >= 0) close(master);
+    }
+};
+
+struct Result {
+    bool intact = false;
+    double msgs_per_s = 0;
+    double mean_ms = 0, max_ms = 0;
+    double bytes_per_msg = 0;
+};
+
+// Sends @p msgs from one end to the other, @p spacing_ms apart (0: all at once)
+Result transfer(EndConfig board_cfg, EndConfig host_cfg, bool to_board,
+                const std::vector<std::string> &msgs, unsigned spacing_ms) {
+    Result r;
+    Link link;
+    if (!link.open()) {
+        std::perror("pty");
+        return r;
+    }
+    End board(link.master, board_cfg), host(link.slave, host_cfg);
+    board.start();
+    host.start();
+    if (host_cfg.compact && !wait_compact(board, host)) return r;
+    for (int i = 0; i < 500 && !(board.idle() && host.idle()); i++) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    uint64_t bytes0 = (to_board ? host : board).bytes_written() + (to_board ? board : host).bytes_written();
+
+    End &tx = to_board ? host : board;
+    End &rx = to_board ? board : host;
+    std::vector<clock_type::time_point> sent;
+    for (const std::string &m : msgs) {
+        sent.push_back(clock_type::now());
+        tx.submit(m);
+        if (spacing_ms) std::this_thread::sleep_for(std::chrono::milliseconds(spacing_ms));
+    }
+    auto deadline = clock_type::now() + std::chrono::seconds(60);
+    while (rx.delivered() < msgs.size() && clock_type::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    // Let the last ACK arrive so the byte count is complete
+    for (int i = 0; i < 500 && !tx.idle(); i++) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    board.stop();
+    host.stop();
+
+    std::vector<Delivery> got = rx.deliveries();
+    r.intact = got.size() == msgs.size();
+    double sum = 0;
+    for (size_t i = 0; i < got.size() && i < msgs.size(); i++) {
+        r.intact = r.intact && got[i].text == msgs[i];
+        double ms = std::chrono::duration<double, std::milli>(got[i].at - sent[i]).count();
+        sum += ms;
+        r.max_ms = std::max(r.max_ms, ms);
+    }
+    if (!got.empty()) {
+        r.mean_ms = sum / got.size();
+        double secs = std::chrono::duration<double>(got.back().at - sent.front()).count();
+        r.msgs_per_s = secs > 0 ? got.size() / secs : 0;
+    }
+    uint64_t bytes = board.bytes_written() + host.bytes_written() - bytes0;
+    r.bytes_per_msg = msgs.empty() ? 0 : double(bytes) / msgs.size();
+    return r;
+}
+
+int selftest(const Options &opt) {
+    Check check;
+    std::mt19937 rng(119);
+    std::vector<std::string> burst, singles, slow;
+    size_t symbols = 0;
+    for (unsigned i = 0; i < opt.messages; i++) {
+        burst.push_back(random_message(rng));
+        symbols += burst.back().size();
+    }
+    for (int i = 0; i < 20; i++) singles.push_back(random_message(rng));
+    for (int i = 0; i < 10; i++) slow.push_back(random_message(rng));
+    std::printf("%u messages of %.1f symbols on average, board loop every %u ms\n", opt.messages,
+                double(symbols) / opt.messages, opt.tick_ms);
+
+    EndConfig board_ascii_old{ opt.tick_ms, true, false, 0 };
+    EndConfig board_ascii{ opt.tick_ms, false, false, 0 };
+    EndConfig board_compact{ opt.tick_ms, false, true, 0 };
+    EndConfig host_ascii{ 0, false, false, 0 };
+    EndConfig host_compact{ 0, false, true, 0 };
+
+    struct Row {
+        const char *what;
+        Result burst, single;
+    };
+    std::vector<Row> rows;
+    auto run = [&](const char *what, EndConfig b, EndConfig h, bool to_board, const std::vector<std::string> &msgs) {
+        Row row{ what, transfer(b, h, to_board, msgs, 0), transfer(b, h, to_board, singles, 3 * opt.tick_ms + 7) };
+        rows.push_back(row);
+    };
+    // The old receiver needs a wake-up per character: fewer messages, spaced so each one finds the link idle
+    rows.push_back({ "host->board ASCII, 1 char per wake-up (old)",
+                     transfer(board_ascii_old, host_ascii, true, slow, 0),
+                     transfer(board_ascii_old, host_ascii, true, std::vector<std::string>(slow.begin(), slow.begin() + 4),
+                              80 * opt.tick_ms) });
+    run("host->board ASCII", board_ascii, host_ascii, true, burst);
+    run("host->board compact", board_compact, host_compact, true, burst);
+    run("board->host ASCII", board_ascii, host_ascii, false, burst);
+    run("board->host compact", board_compact, host_compact, false, burst);
+
+    std::printf("\n%-44s %10s %12s %12s %10s\n", "", "msg/s", "burst B/msg", "idle lat ms", "max ms");
+    for (const Row &r : rows)
+        std::printf("%-44s %10.1f %12.1f %12.1f %10.1f\n", r.what, r.burst.msgs_per_s, r.burst.bytes_per_msg,
+                    r.single.mean_ms, r.single.max_ms);
+    std::printf("\n");
+    for (const Row &r : rows) {
+        std::string what = std::string(r.what) + ": delivered intact";
+        check(r.burst.intact && r.single.intact, what.c_str());
+    }
+    check(rows[2].burst.msgs_per_s > 10 * rows[0].burst.msgs_per_s, "compact to the board beats the old receiver");
+    check(rows[4].burst.msgs_per_s > 4 * rows[3].burst.msgs_per_s, "compact batches beat one message per wake-up");
+    check(rows[2].burst.bytes_per_msg < rows[1].burst.bytes_per_msg / 2, "compact uses under half the bytes");
+
+    // Both directions at once over a link that damages frames
+    std::printf("compact, both directions, every %uth frame damaged\n", opt.corrupt);
+    {
+        Link link;
+        if (!link.open()) {
+            std::perror("pty");
+            return 1;
+        }
+        EndConfig b = board_compact, h = host_compact;
+        b.corrupt = h.corrupt = opt.corrupt;
+        End board(link.master, b), host(link.slave, h);
+        board.start();
+        host.start();
+        if (!wait_compact(board, host)) {
+            check(false, "compact format agreed");
+            return 1;
+        }
+        for (const std::string &m : burst) {
+            host.submit(m);
+            board.submit(m);
+        }
+        auto deadline = clock_type::now() + std::chrono::seconds(60);
+        while ((board.delivered() < burst.size() || host.delivered() < burst.size()) && clock_type::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        board.stop();
+        host.stop();
+        auto same = [&](const std::vector<Delivery> &got) {
+            if (got.size() != burst.size()) return false;
+            for (size_t i = 0; i < got.size(); i++)
+                if (got[i].text != burst[i]) return false;
+            return true;
+        };
+        morse_wire_stats_t bs = board.stats(), hs = host.stats();
+        std::printf("  board: %u batches, %u retransmits, %u bad frames, %u duplicates\n", bs.tx_batches,
+                    bs.tx_retransmits, bs.rx_bad_frames, bs.rx_duplicates);
+        std::printf("  host:  %u batches, %u retransmits, %u bad frames, %u duplicates\n", hs.tx_batches,
+                    hs.tx_retransmits, hs.rx_bad_frames, hs.rx_duplicates);
+        check(same(board.deliveries()) && same(host.deliveries()), "every message once, intact and in order");
+        check(!opt.corrupt || (bs.tx_retransmits && hs.tx_retransmits), "damaged batches were retransmitted");
+    }
+
+    std::printf("%s (%d failed)\n", check.failures ? "FAIL" : "PASS", check.failures);
+    return check.failures ? 1 : 0;
+}
+
+/* ===== monitor ===== */
+
+int monitor(const char *tty) {
+    int fd = open(tty, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0 || !set_raw(fd)) {
+        std::perror(tty);
+        return 1;
+    }
+    End host(fd, EndConfig{ 0, false, true, 0 });
+    host.on_delivery([](const std::string &m) { std::printf("< %s\n", m.c_str()); std::fflush(stdout); });
+    host.start();
+    host.hello();
+    std::printf("%s: type Morse ('.', '-', ' ') and Enter to send, Ctrl-D to quit\n", tty);
+
+    char line[512];
+    bool told = false;
+    while (std::fgets(line, sizeof(line), stdin)) {
+        if (!told && host.peer_compact()) {
+            std::printf("board answered: compact format\n");
+            told = true;
+        }
+        size_t n = std::strcspn(line, "\r\n");
+        host.submit(std::string(line, n));
+    }
+    for (int i = 0; i < 500 && !host.idle(); i++) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    host.stop();
+    morse_wire_stats_t s = host.stats();
+    std::printf("sent %u messages in %u batches (%u retransmits), received %u (%u ASCII)\n", s.tx_messages,
+                s.tx_batches, s.tx_retransmits, s.rx_messages, s.rx_ascii_messages);
+    close(fd);
+    return 0;
+}
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: morse_link_pty selftest [--tick MS] [--messages N] [--corrupt N]\n"
+                 "       morse_link_pty monitor <tty>\n");
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        usage();
+        return 2;
+    }
+    std::string mode = argv[1];
+    const char *tty = nullptr;
+    Options opt;
+    for (int i = 2; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() { return i + 1 < argc ? static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 0)) : 0u; };
+        if (a == "--tick") opt.tick_ms = std::max(1u, next());
+        else if (a == "--messages") opt.messages = std::max(1u, next());
+        else if (a == "--corrupt") opt.corrupt = next();
+        else if (!tty) tty = argv[i];
+        else {
+            usage();
+            return 2;
+        }
+    }
+    signal(SIGPIPE, SIG_IGN);
+    if (mode == "selftest") return selftest(opt);
+    if (mode == "monitor" && tty) return monitor(tty);
+    usage();
+    return 2;
+}
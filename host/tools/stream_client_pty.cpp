@@ -0,0 +1,474 @@
+// Tests the host client library (host/client) against a pty stand-in of a board.
+//
+// The stand-in runs the same request server as the firmware (usbSerialDebug/
+// stream_proto.c) on the master side of a pseudo-terminal and publishes a symlink
+// to the slave side, which the client opens like /dev/ttyACM1. It streams
+// records with known contents at board rates (IMU 1 kHz, environment and light
+// 10 Hz, audio 8 kHz in 256-sample blocks), so the receiver can check every
+// record for gaps. "Unplugging" closes the pty and creates a new one behind the
+// same symlink.
+//
+//   stream_client_pty selftest [--seconds N] [--imu-hz N] [--audio-hz N]
+//       commands (ping, info, errors, an application command), streams through
+//       callbacks, subscriptions and the iterator, a reconnection in the middle,
+//       then an audio flood to measure the client throughput. Exit code 0 when
+//       every check passes.
+//   stream_client_pty device [--link PATH] [--imu-hz N] [--audio-hz N]
+//       only the stand-in, for trying other host tools against it.
+//   stream_client_pty monitor <tty> [--seconds N]
+//       connect to a board (or a stand-in), enable every stream and print the
+//       record rates once per second.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "tkjhat_client.h"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+constexpr uint8_t kCmdSum = STREAM_CMD_USER;   // stand-in command: sum of the argument bytes
+constexpr unsigned kAudioBlock = 256;           // MEMS_BUFFER_SIZE
+
+struct Options {
+    unsigned seconds = 3;
+    unsigned imu_hz = 1000;
+    unsigned audio_hz = 8000;
+    std::string link;
+};
+
+uint32_t now_us() {
+    using namespace std::chrono;
+    return static_cast<uint32_t>(duration_cast<microseconds>(clock_type::now().time_since_epoch()).count());
+}
+
+uint32_t now_ms() { return now_us() / 1000; }
+
+bool set_raw(int fd) {
+    termios t{};
+    if (tcgetattr(fd, &t) != 0) return false;
+    cfmakeraw(&t);
+    return tcsetattr(fd, TCSANOW, &t) == 0;
+}
+
+int16_t audio_value(uint64_t index) { return static_cast<int16_t>(index * 7); }
+
+/* ===== stand-in board ===== */
+
+class FakeDevice {
+public:
+    explicit FakeDevice(const Options &opt) : opt_(opt) {}
+    ~FakeDevice() { stop(); }
+
+    bool start() {
+        if (!open_pty()) return false;
+        thread_ = std::thread([this] { run(); });
+        return true;
+    }
+
+    void stop() {
+        if (running_.exchange(false) && thread_.joinable()) thread_.join();
+        close_pty();
+        unlink(opt_.link.c_str());
+    }
+
+    // Ask the device thread to drop the pty and come back on a new one
+    void unplug() { unplug_ = true; }
+    // Ask the device thread to send @p samples of audio back to back
+    void flood(uint64_t samples) { flood_ = samples; }
+
+    const std::string &link() const { return opt_.link; }
+
+private:
+    static bool write_frame(void *ctx, const uint8_t *frame, size_t len, bool wait) {
+        (void)wait;     // a pty has flow control: block like a full USB FIFO would, until stop()
+        FakeDevice *self = static_cast<FakeDevice *>(ctx);
+        int fd = self->master_;
+        while (len) {
+            ssize_t w = write(fd, frame, len);
+            if (w > 0) {
+                frame += w;
+                len -= static_cast<size_t>(w);
+            } else if (w < 0 && errno != EAGAIN && errno != EINTR) {
+                return false;
+            } else {
+                pollfd pf{ fd, POLLOUT, 0 };
+                if (!self->running_ || poll(&pf, 1, 10) < 0) return false;
+            }
+        }
+        return true;
+    }
+
+    static int cmd_sum(void *ctx, const uint8_t *args, size_t len, uint8_t *out, size_t *out_len) {
+        (void)ctx;
+        uint32_t sum = 0;
+        for (size_t i = 0; i < len; i++) sum += args[i];
+        std::memcpy(out, &sum, 4);
+        *out_len = 4;
+        return STREAM_OK;
+    }
+
+    bool open_pty() {
+        master_ = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+        if (master_ < 0 || grantpt(master_) != 0 || unlockpt(master_) != 0) return false;
+        const char *name = ptsname(master_);
+        if (!name) return false;
+        set_raw(master_);
+        // Keep a handle on the slave: raw mode sticks and the master does not see EOF between clients
+        keep_ = open(name, O_RDWR | O_NOCTTY);
+        if (keep_ < 0) return false;
+        set_raw(keep_);
+        std::string tmp = opt_.link + ".new";
+        unlink(tmp.c_str());
+        if (symlink(name, tmp.c_str()) != 0 || rename(tmp.c_str(), opt_.link.c_str()) != 0) return false;
+        stream_server_init(&server_, "pty stand-in", write_frame, this, now_ms);
+        stream_server_register(&server_, kCmdSum, cmd_sum, nullptr);
+        return true;
+    }
+
+    void close_pty() {
+        if (keep_ >= 0) close(keep_);
+        if (master_ >= 0) close(master_);
+        keep_ = master_ = -1;
+    }
+
+    void send_audio_block(uint32_t ts) {
+        int16_t pcm[kAudioBlock];
+        for (unsigned i = 0; i < kAudioBlock; i++) pcm[i] = audio_value(audio_index_ + i);
+        stream_server_send_audio(&server_, ts, static_cast<uint16_t>(opt_.audio_hz), pcm, kAudioBlock);
+        audio_index_ += kAudioBlock;
+    }
+
+    void run() {
+        running_ = true;
+        const auto imu_period = std::chrono::nanoseconds(1000000000ull / std::max(1u, opt_.imu_hz));
+        const auto slow_period = std::chrono::milliseconds(100);
+        const auto audio_period = std::chrono::nanoseconds(1000000000ull * kAudioBlock / std::max(1u, opt_.audio_hz));
+        auto next_imu = clock_type::now(), next_slow = next_imu, next_audio = next_imu;
+        uint8_t buf[512];
+
+        while (running_) {
+            if (unplug_.exchange(false)) {
+                close_pty();
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                if (!open_pty()) {
+                    std::fprintf(stderr, "device: cannot recreate the pty\n");
+                    return;
+                }
+            }
+            uint64_t flood = flood_.exchange(0);
+            for (uint64_t s = 0; s < flood; s += kAudioBlock) send_audio_block(now_us());
+
+            pollfd pf{ master_, POLLIN, 0 };
+            if (poll(&pf, 1, 1) > 0 && (pf.revents & POLLIN)) {
+                ssize_t n = read(master_, buf, sizeof(buf));
+                if (n > 0) stream_server_feed(&server_, buf, static_cast<size_t>(n));
+            }
+
+            // Records are produced whether or not the host listens, like sensors sampled by the board
+            auto now = clock_type::now();
+            while (now >= next_imu) {
+                stream_imu_t r{};
+                r.timestamp_us = now_us();
+                r.accel_mg[0] = static_cast<int16_t>(imu_index_ & 0x7FFF);
+                r.accel_mg[2] = 1000;
+                r.temp_c100 = 2500;
+                r.gyro_mdps[0] = static_cast<int32_t>(imu_index_);
+                r.gyro_mdps[1] = -static_cast<int32_t>(imu_index_);
+                stream_server_send_imu(&server_, &r);
+                imu_index_++;
+                next_imu += imu_period;
+            }
+            while (now >= next_slow) {
+                stream_env_t e{ now_us(), static_cast<int16_t>(slow_index_), static_cast<uint16_t>(4000 + slow_index_) };
+                stream_light_t l{ now_us(), slow_index_ };
+                stream_server_send_env(&server_, &e);
+                stream_server_send_light(&server_, &l);
+                slow_index_++;
+                next_slow += slow_period;
+            }
+            while (now >= next_audio) {
+                send_audio_block(now_us());
+                next_audio += audio_period;
+            }
+        }
+    }
+
+    Options opt_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> unplug_{false};
+    std::atomic<uint64_t> flood_{0};
+    int master_ = -1, keep_ = -1;
+    stream_server_t server_{};
+    uint32_t imu_index_ = 0, slow_index_ = 0;
+    uint64_t audio_index_ = 0;
+};
+
+/* ===== checks ===== */
+
+struct Check {
+    int failures = 0;
+    void operator()(bool ok, const char *what) {
+        std::printf("  %-52s %s\n", what, ok ? "ok" : "FAIL");
+        if (!ok) failures++;
+    }
+};
+
+// Counts records and discontinuities of a counter carried by the records. One
+// thread calls see(), the main thread reads the counts meanwhile.
+struct Sequence {
+    std::atomic<uint64_t> count{0}, gaps{0};
+    bool have = false;
+    uint64_t next = 0;
+    void see(uint64_t v, uint64_t step = 1) {
+        if (have && v != next) gaps++;
+        have = true;
+        next = v + step;
+        count++;
+    }
+};
+
+int selftest(Options opt) {
+    if (opt.link.empty()) opt.link = "/tmp/tkjhat-stream-" + std::to_string(getpid());
+    FakeDevice dev(opt);
+    if (!dev.start()) {
+        std::perror("pty");
+        return 1;
+    }
+
+    tkjhat::Client::Options copt;
+    copt.rpc_timeout = std::chrono::milliseconds(300);
+    copt.reconnect_interval = std::chrono::milliseconds(50);
+    tkjhat::Client client(dev.link(), copt);
+
+    // IMU through a callback, environment and light through next(), audio through the iterator
+    Sequence imu_seq, env_seq, light_seq, audio_seq;
+    std::atomic<uint64_t> audio_samples{0}, audio_bad{0};
+    client.on_imu([&](const tkjhat::ImuRecord &r) { imu_seq.see(static_cast<uint32_t>(r.gyro_mdps[0])); });
+    auto env = client.subscribe_env();
+    auto light = client.subscribe_light();
+    auto audio = client.subscribe_audio(1024);
+
+    std::atomic<bool> done{false};
+    std::thread slow_reader([&] {
+        tkjhat::EnvRecord e;
+        tkjhat::LightRecord l;
+        while (!done || env->size() || light->size()) {
+            if (env->next(e, std::chrono::milliseconds(2))) env_seq.see(static_cast<uint16_t>(e.temp_c100));
+            if (light->next(l, std::chrono::milliseconds(2))) light_seq.see(l.lux);
+        }
+    });
+    std::thread audio_reader([&] {
+        uint64_t expect = 0;
+        bool have = false;
+        for (const tkjhat::AudioPtr &b : *audio) {
+            // Sample k of the stand-in is int16(7 k), so after a gap the first value gives k mod 2^16
+            uint64_t idx = expect;
+            if (!have || b->samples[0] != audio_value(expect)) {
+                uint64_t low = static_cast<uint16_t>(b->samples[0]) * 28087u % 65536u;     // 7 * 28087 = 1 mod 2^16
+                idx = (expect & ~uint64_t(0xFFFF)) | low;
+                if (idx < expect) idx += 0x10000;
+            }
+            audio_seq.see(idx, b->count);
+            for (size_t i = 0; i < b->count; i++)
+                if (b->samples[i] != audio_value(idx + i)) { audio_bad++; break; }
+            audio_samples += b->count;
+            expect = idx + b->count;
+            have = true;
+        }
+    });
+
+    Check check;
+    client.start();
+    std::printf("stand-in on %s\n", dev.link().c_str());
+    check(client.wait_connected(std::chrono::seconds(2)), "client opened the port");
+
+    std::printf("commands\n");
+    tkjhat::DeviceInfo info = client.info().get();
+    check(info.status == tkjhat::Status::ok && info.version == STREAM_PROTO_VERSION && info.name == "pty stand-in",
+          "info: version and name");
+    std::vector<uint8_t> payload(STREAM_MAX_DATA);
+    for (size_t i = 0; i < payload.size(); i++) payload[i] = static_cast<uint8_t>(i * 13);
+    tkjhat::Response pong = client.ping(payload).get();
+    check(pong.ok() && pong.data == payload, "ping: 253-byte payload echoed");
+    check(client.call(0x7E).get().status == tkjhat::Status::unknown_command, "unknown command rejected");
+    uint8_t bad_mask = 0xF0;
+    check(client.call(STREAM_CMD_SET_STREAMS, &bad_mask, 1).get().status == tkjhat::Status::bad_args,
+          "invalid stream mask rejected");
+    uint8_t sum_args[] = { 1, 2, 3, 250 };
+    tkjhat::Response sum = client.call(kCmdSum, sum_args, sizeof(sum_args)).get();
+    uint32_t sum_v = 0;
+    if (sum.data.size() == 4) std::memcpy(&sum_v, sum.data.data(), 4);
+    check(sum.ok() && sum_v == 256, "application command answered");
+    {
+        // Many commands in flight at once
+        std::vector<std::future<tkjhat::Response>> fs;
+        for (int i = 0; i < 64; i++) fs.push_back(client.ping({ static_cast<uint8_t>(i) }));
+        bool all = true;
+        for (int i = 0; i < 64; i++) {
+            tkjhat::Response r = fs[static_cast<size_t>(i)].get();
+            all = all && r.ok() && r.data.size() == 1 && r.data[0] == i;
+        }
+        check(all, "64 concurrent pings matched to their futures");
+    }
+
+    std::printf("streams for %u s, unplugged once in the middle\n", opt.seconds);
+    check(client.set_streams(STREAM_ALL).get().ok(), "all streams enabled");
+    auto t0 = clock_type::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(500 * opt.seconds));
+    dev.unplug();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    tkjhat::Status during = client.ping({ 1 }).get().status;
+    check(during == tkjhat::Status::disconnected || during == tkjhat::Status::timeout,
+          "command during the unplug fails");
+    bool back = false;
+    for (int i = 0; i < 100 && !back; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        back = client.connected() && client.ping().get().ok();
+    }
+    check(back, "client reconnected and answers commands");
+    std::this_thread::sleep_for(std::chrono::milliseconds(500 * opt.seconds));
+    double secs = std::chrono::duration<double>(clock_type::now() - t0).count();
+    tkjhat::Stats st = client.stats();
+
+    double expect_imu = (secs - 0.5) * opt.imu_hz * 0.9;
+    double expect_audio = (secs - 0.5) * opt.audio_hz * 0.9;
+    std::printf("  IMU %llu, env %llu, light %llu records, audio %llu samples in %.2f s\n",
+                (unsigned long long)imu_seq.count.load(), (unsigned long long)env_seq.count.load(),
+                (unsigned long long)light_seq.count.load(), (unsigned long long)audio_samples.load(), secs);
+    check(imu_seq.count >= expect_imu, "IMU records at the board rate");
+    check(audio_samples >= expect_audio, "audio samples at the board rate");
+    check(env_seq.count >= 5 && light_seq.count >= 5, "environment and light records");
+    check(imu_seq.gaps <= 1 && env_seq.gaps <= 1 && light_seq.gaps <= 1 && audio_seq.gaps <= 1,
+          "no gaps except across the unplug");
+    check(audio_bad == 0, "audio samples intact");
+    check(st.reconnects == 1 && st.lost == 0 && st.crc_errors == 0 && st.malformed == 0,
+          "one reconnection, no lost/corrupt frames");
+    check(st.queue_drops == 0, "no subscription overflow");
+
+    std::printf("audio flood\n");
+    const uint64_t flood = 2000000;
+    uint64_t before = audio_samples;
+    auto f0 = clock_type::now();
+    dev.flood(flood);
+    while (audio_samples < before + flood && clock_type::now() - f0 < std::chrono::seconds(20))
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    double fsec = std::chrono::duration<double>(clock_type::now() - f0).count();
+    double rate = double(audio_samples - before) / fsec;
+    std::printf("  %.0f samples/s (%.1f x the 8 kHz stream, %.1f MB/s of frames)\n", rate, rate / 8000.0,
+                double(client.stats().bytes - st.bytes) / fsec / 1e6);
+    check(audio_samples >= before + flood, "flood received completely");
+    check(rate >= 10.0 * 8000, "client keeps up with 10x the audio rate");
+    tkjhat::Stats st2 = client.stats();
+    check(st2.lost == 0 && st2.queue_drops == 0 && audio_bad == 0, "no loss during the flood");
+
+    client.stop();
+    dev.stop();
+    done = true;
+    audio_reader.join();
+    slow_reader.join();
+    std::printf("%s (%d failed)\n", check.failures ? "FAIL" : "PASS", check.failures);
+    return check.failures ? 1 : 0;
+}
+
+volatile sig_atomic_t g_stop = 0;
+void on_signal(int) { g_stop = 1; }
+
+int device(Options opt) {
+    if (opt.link.empty()) opt.link = "/tmp/tkjhat-stream";
+    FakeDevice dev(opt);
+    if (!dev.start()) {
+        std::perror("pty");
+        return 1;
+    }
+    std::printf("device: stand-in on %s (Ctrl-C to stop)\n", dev.link().c_str());
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    while (!g_stop) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    dev.stop();
+    return 0;
+}
+
+int monitor(const char *tty, const Options &opt) {
+    tkjhat::Client client(tty);
+    std::atomic<uint64_t> imu{0}, env{0}, light{0}, samples{0};
+    client.on_imu([&](const tkjhat::ImuRecord &) { imu++; });
+    client.on_env([&](const tkjhat::EnvRecord &) { env++; });
+    client.on_light([&](const tkjhat::LightRecord &) { light++; });
+    client.on_audio([&](const tkjhat::AudioBlock &b) { samples += b.count; });
+    client.on_connection([](bool up) { std::printf("%s\n", up ? "connected" : "disconnected"); });
+    client.start();
+    if (!client.wait_connected(std::chrono::seconds(5))) {
+        std::fprintf(stderr, "%s: cannot open\n", tty);
+        return 1;
+    }
+    tkjhat::DeviceInfo info = client.info().get();
+    std::printf("info: %s, name \"%s\", protocol %u, uptime %u ms\n", tkjhat::to_string(info.status),
+                info.name.c_str(), info.version, info.uptime_ms);
+    client.set_streams(STREAM_ALL).get();
+    signal(SIGINT, on_signal);
+    for (unsigned s = 0; !g_stop && (opt.seconds == 0 || s < opt.seconds); s++) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        tkjhat::Stats st = client.stats();
+        std::printf("imu %llu/s  env %llu/s  light %llu/s  audio %llu samples/s  lost %llu  crc %llu\n",
+                    (unsigned long long)imu.exchange(0), (unsigned long long)env.exchange(0),
+                    (unsigned long long)light.exchange(0), (unsigned long long)samples.exchange(0),
+                    (unsigned long long)st.lost, (unsigned long long)st.crc_errors);
+    }
+    client.stop();
+    return 0;
+}
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: stream_client_pty selftest [--seconds N] [--imu-hz N] [--audio-hz N]\n"
+                 "       stream_client_pty device [--link PATH] [--imu-hz N] [--audio-hz N]\n"
+                 "       stream_client_pty monitor <tty> [--seconds N]\n");
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        usage();
+        return 2;
+    }
+    std::string mode = argv[1];
+    const char *tty = nullptr;
+    Options opt;
+    for (int i = 2; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() { return i + 1 < argc ? static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 0)) : 0u; };
+        if (a == "--seconds") opt.seconds = next();
+        else if (a == "--imu-hz") opt.imu_hz = std::max(1u, next());
+        else if (a == "--audio-hz") opt.audio_hz = std::max(1u, next());
+        else if (a == "--link" && i + 1 < argc) opt.link = argv[++i];
+        else if (!tty) tty = argv[i];
+        else {
+            usage();
+            return 2;
+        }
+    }
+    signal(SIGPIPE, SIG_IGN);
+    if (mode == "selftest") return selftest(opt);
+    if (mode == "device") return device(opt);
+    if (mode == "monitor" && tty) return monitor(tty, opt);
+    usage();
+    return 2;
+}
@@ -0,0 +1,299 @@
+// Pseudo-terminal stand-in for the UART board-to-board link (tkjhat/uart_link.h).
+//
+// Runs the same frame codec as the board (link_frame.c, crc.c) over a pty, so the
+// protocol layer can be tested on a PC without two boards or a USB-UART adapter:
+//
+//   uart_link_pty peer [--corrupt N]       create a pty and behave like a board:
+//                                          echo DATA frames, answer PINGs with PONGs.
+//                                          --corrupt N flips a bit in every Nth reply.
+//   uart_link_pty client <tty> [--frames N] [--size S] [--window W]
+//                                          send N DATA frames of S bytes (W in flight)
+//                                          to <tty> and check the echoes.
+//   uart_link_pty selftest [--corrupt N] [--frames N] [--size S] [--window W]
+//                                          peer and client connected through one pty.
+//
+// The client can also be pointed to a real serial adapter wired to a board that
+// echoes frames. It prints throughput, round-trip latency and the decoder counters;
+// the exit code is 0 when every frame came back intact (or, with --corrupt, when
+// every corrupted frame was rejected by the CRC).
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <tkjhat/link_frame.h>
+
+namespace {
+
+struct Options {
+    unsigned frames = 10000;
+    unsigned size = 64;
+    unsigned window = 8;
+    unsigned corrupt = 0;
+};
+
+uint32_t now_us() {
+    using namespace std::chrono;
+    return static_cast<uint32_t>(duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+bool set_raw(int fd) {
+    termios t{};
+    if (tcgetattr(fd, &t) != 0) return false;
+    cfmakeraw(&t);
+    return tcsetattr(fd, TCSANOW, &t) == 0;
+}
+
+bool write_all(int fd, const uint8_t *p, size_t n) {
+    while (n) {
+        ssize_t w = write(fd, p, n);
+        if (w < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            return false;
+        }
+        p += w;
+        n -= static_cast<size_t>(w);
+    }
+    return true;
+}
+
+void put_u32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+uint32_t get_u32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+void print_decoder(const char *who, const link_frame_decoder_t &d) {
+    std::printf("%s: frames=%u crc_errors=%u lost=%u resync_bytes=%u\n",
+                who, d.frames, d.crc_errors, d.lost, d.resync_bytes);
+}
+
+/* ===== Peer: behaves like a board running uart_link ===== */
+int run_peer(int fd, const Options &opt) {
+    link_frame_decoder_t dec;
+    link_frame_decoder_init(&dec);
+    uint8_t frame[LINK_FRAME_MAX_SIZE];
+    uint8_t buf[4096];
+    uint8_t seq = 0;
+    unsigned replies = 0;
+
+    for (;;) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            break;      // other side closed
+        }
+        for (ssize_t i = 0; i < n; i++) {
+            if (link_frame_decode_byte(&dec, buf[i]) != LINK_FRAME_READY) continue;
+
+            uint8_t type = dec.type == LINK_FRAME_PING ? static_cast<uint8_t>(LINK_FRAME_PONG) : dec.type;
+            size_t len = link_frame_encode(type, seq++, dec.payload, dec.len, frame, sizeof(frame));
+            if (opt.corrupt && ++replies % opt.corrupt == 0) {
+                frame[len / 2] ^= 0x10;
+            }
+            if (!write_all(fd, frame, len)) return 1;
+        }
+    }
+    print_decoder("peer", dec);
+    return 0;
+}
+
+/* ===== Client: sends DATA frames and PINGs, checks the echoes ===== */
+int run_client(int fd, const Options &opt) {
+    link_frame_decoder_t dec;
+    link_frame_decoder_init(&dec);
+    uint8_t frame[LINK_FRAME_MAX_SIZE];
+    uint8_t payload[LINK_FRAME_MAX_PAYLOAD];
+    uint8_t buf[4096];
+    std::vector<uint32_t> rtt;
+    rtt.reserve(opt.frames);
+
+    unsigned size = std::clamp(opt.size, 8u, static_cast<unsigned>(LINK_FRAME_MAX_PAYLOAD));
+    unsigned sent = 0, received = 0, mismatches = 0, timeouts = 0, pongs = 0;
+    unsigned in_flight = 0;
+    uint8_t seq = 0;
+    uint64_t wire_bytes = 0;
+    uint32_t start = now_us();
+
+    while (received + dec.crc_errors + timeouts < opt.frames) {
+        // Keep the window full
+        while (sent < opt.frames && in_flight < opt.window) {
+            put_u32(payload, now_us());
+            put_u32(payload + 4, sent);
+            for (unsigned i = 8; i < size; i++) payload[i] = static_cast<uint8_t>(sent * 31 + i);
+            // Every 64th frame is a PING, like uart_link_ping()
+            uint8_t type = (sent % 64 == 63) ? LINK_FRAME_PING : LINK_FRAME_DATA;
+            size_t len = link_frame_encode(type, seq++, payload, size, frame, sizeof(frame));
+            if (!write_all(fd, frame, len)) return 2;
+            wire_bytes += len;
+            sent++;
+            in_flight++;
+        }
+
+        pollfd p{fd, POLLIN, 0};
+        int r = poll(&p, 1, 500);
+        if (r == 0) {
+            timeouts += in_flight;    // lost on the way; keep going
+            in_flight = 0;
+            continue;
+        }
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            break;
+        }
+        for (ssize_t i = 0; i < n; i++) {
+            link_frame_result_t res = link_frame_decode_byte(&dec, buf[i]);
+            if (res == LINK_FRAME_BAD_CRC) {
+                if (in_flight) in_flight--;
+                continue;
+            }
+            if (res != LINK_FRAME_READY) continue;
+            if (in_flight) in_flight--;
+            received++;
+            wire_bytes += dec.len + LINK_FRAME_OVERHEAD;
+            if (dec.type == LINK_FRAME_PONG) pongs++;
+
+            uint32_t idx = get_u32(dec.payload + 4);
+            bool ok = dec.len == size;
+            for (unsigned k = 8; ok && k < size; k++) ok = dec.payload[k] == static_cast<uint8_t>(idx * 31 + k);
+            if (!ok) mismatches++;
+            rtt.push_back(now_us() - get_u32(dec.payload));
+        }
+    }
+
+    double secs = (now_us() - start) / 1e6;
+    std::sort(rtt.begin(), rtt.end());
+    auto pct = [&](double q) { return rtt.empty() ? 0u : rtt[static_cast<size_t>(q * (rtt.size() - 1))]; };
+
+    std::printf("client: sent=%u echoed=%u (pongs=%u) mismatches=%u timeouts=%u\n",
+                sent, received, pongs, mismatches, timeouts);
+    print_decoder("client", dec);
+    std::printf("client: %.0f frames/s, %.1f kB/s on the wire (both directions)\n",
+                received / secs, wire_bytes / secs / 1000.0);
+    std::printf("client: rtt us min/p50/p99/max = %u/%u/%u/%u\n",
+                pct(0.0), pct(0.5), pct(0.99), pct(1.0));
+
+    bool pass = mismatches == 0 && received + dec.crc_errors == opt.frames;
+    if (!opt.corrupt) pass = pass && dec.crc_errors == 0 && dec.lost == 0;
+    std::printf("client: %s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
+
+int open_pty(std::string &slave) {
+    int fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0) return -1;
+    const char *name = ptsname(fd);
+    if (!name) return -1;
+    slave = name;
+    set_raw(fd);
+    return fd;
+}
+
+int open_tty(const char *path) {
+    int fd = open(path, O_RDWR | O_NOCTTY);
+    if (fd >= 0) set_raw(fd);
+    return fd;
+}
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: uart_link_pty peer [--corrupt N]\n"
+                 "       uart_link_pty client <tty> [--frames N] [--size S] [--window W]\n"
+                 "       uart_link_pty selftest [--corrupt N] [--frames N] [--size S] [--window W]\n");
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        usage();
+        return 2;
+    }
+    std::string mode = argv[1];
+    const char *tty = nullptr;
+    Options opt;
+
+    for (int i = 2; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() { return i + 1 < argc ? static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 0)) : 0u; };
+        if (a == "--frames") opt.frames = next();
+        else if (a == "--size") opt.size = next();
+        else if (a == "--window") opt.window = std::max(1u, next());
+        else if (a == "--corrupt") opt.corrupt = next();
+        else if (!tty) tty = argv[i];
+        else {
+            usage();
+            return 2;
+        }
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    if (mode == "peer") {
+        std::string slave;
+        int fd = open_pty(slave);
+        if (fd < 0) {
+            std::perror("pty");
+            return 1;
+        }
+        std::printf("peer: listening on %s\n", slave.c_str());
+        std::fflush(stdout);
+        // Keep a handle on the slave so the master does not see EOF between clients
+        int keep = open_tty(slave.c_str());
+        int rc = run_peer(fd, opt);
+        close(keep);
+        return rc;
+    }
+
+    if (mode == "client") {
+        if (!tty) {
+            usage();
+            return 2;
+        }
+        int fd = open_tty(tty);
+        if (fd < 0) {
+            std::perror(tty);
+            return 1;
+        }
+        return run_client(fd, opt);
+    }
+
+    if (mode == "selftest") {
+        std::string slave;
+        int master = open_pty(slave);
+        int fd = master >= 0 ? open_tty(slave.c_str()) : -1;
+        if (fd < 0) {
+            std::perror("pty");
+            return 1;
+        }
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(fd);
+            std::exit(run_peer(master, opt));
+        }
+        close(master);
+        int rc = run_client(fd, opt);
+        close(fd);
+        int status = 0;
+        waitpid(pid, &status, 0);
+        return rc;
+    }
+
+    usage();
+    return 2;
+}
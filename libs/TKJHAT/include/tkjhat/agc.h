@@ -0,0 +1,171 @@
+/*
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 , Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+/**
+ * @file tkjhat/agc.h
+ * @brief Fixed-point automatic gain control for the microphone PCM stream.
+ *
+ * @details
+ * Runs once per decimated block (e.g. on the buffer returned by
+ * ::get_microphone_samples) and does, in integer arithmetic only:
+ *
+ * - an envelope follower on |x| with separate attack and release times
+ *   (power-of-two time constants, so the per-sample update is a shift),
+ * - a gain computer that moves the envelope towards @c target_level, between
+ *   @c min_gain and @c max_gain,
+ * - a noise gate: while the envelope is below @c gate_level the gain falls to
+ *   @c gate_gain instead of pumping the background hiss up,
+ * - a block limiter: the block peak never exceeds @c limit_level because the
+ *   whole block is known before the gain is applied (no lookahead delay).
+ *
+ * The gain is ramped linearly across the block to avoid zipper noise.
+ *
+ * ### Filter volume feedback
+ * When @c feedback is set, most of the gain is applied inside OpenPDMFilter
+ * through its @c volume parameter, where the signal is still a 64-bit value,
+ * instead of multiplying an already rounded 16-bit sample. ::agc_process
+ * measures the block with the volume it was produced with and ::agc_volume
+ * tells the volume for the next block. The driver does this automatically
+ * when the AGC is attached with ::pdm_microphone_set_agc.
+ *
+ * ### Typical usage
+ * @code
+ * static agc_t agc;
+ *
+ * agc_config_t cfg = AGC_DEFAULT_CONFIG;
+ * cfg.sample_rate = MEMS_SAMPLING_FREQUENCY;
+ * agc_init(&agc, &cfg);
+ * pdm_microphone_set_agc(&agc);      // runs in get_microphone_samples()
+ * @endcode
+ *
+ * Portable C (no Pico dependencies), so it can also be compiled on a PC
+ * by the host tools.
+ */
+
+#ifndef TKJHAT_AGC_H
+#define TKJHAT_AGC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AGC_GAIN_ONE                            256u    // gains are Q8.8
+#define AGC_GAIN_RISE_SHIFT                     2       // gain rises 1/4 of the way per block
+#define AGC_FEEDBACK_HEADROOM_SHIFT             1       // filter volume leaves 6 dB for the limiter
+
+/**
+ * @brief AGC settings. Levels are absolute sample values (32767 = 0 dBFS).
+ */
+typedef struct {
+    uint32_t sample_rate;       ///< PCM sample rate in Hz
+    uint16_t attack_ms;         ///< Envelope attack time constant
+    uint16_t release_ms;        ///< Envelope release time constant
+    int16_t  target_level;      ///< Envelope level the gain aims for
+    int16_t  gate_level;        ///< Input envelope below which the gate closes
+    int16_t  limit_level;       ///< Output peak ceiling
+    uint16_t gate_gain;         ///< Gain while the gate is closed (Q8.8)
+    uint16_t min_gain;          ///< Lowest gain (Q8.8)
+    uint16_t max_gain;          ///< Highest gain (Q8.8, up to 127.99)
+    bool     feedback;          ///< Apply the gain through the filter volume
+    uint16_t base_volume;       ///< Filter volume that means a gain of 1
+    uint16_t max_volume;        ///< Highest filter volume the AGC may ask for
+} agc_config_t;
+
+/**
+ * @brief Defaults for the HAT microphone: -18 dBFS target, 5 ms attack,
+ * 500 ms release, gate at -60 dBFS, limiter at -1 dBFS, gain 1/4 .. 32.
+ */
+#define AGC_DEFAULT_CONFIG {                    \
+    .sample_rate  = 8000,                       \
+    .attack_ms    = 5,                          \
+    .release_ms   = 500,                        \
+    .target_level = 4096,                       \
+    .gate_level   = 33,                         \
+    .limit_level  = 29204,                      \
+    .gate_gain    = AGC_GAIN_ONE,               \
+    .min_gain     = AGC_GAIN_ONE / 4,           \
+    .max_gain     = AGC_GAIN_ONE * 32,          \
+    .feedback     = false,                      \
+    .base_volume  = 64,                         \
+    .max_volume   = 64 * 16,                    \
+}
+
+/**
+ * @brief AGC state and counters. Treat as opaque except for the counters.
+ */
+typedef struct agc {
+    agc_config_t cfg;
+    uint8_t  attack_shift;      ///< Envelope time constants as shifts
+    uint8_t  release_shift;
+    int32_t  env;               ///< Envelope of the input (Q8, gain 1 domain)
+    uint32_t gain;              ///< Total gain at the end of the last block (Q16.16)
+    uint16_t volume;            ///< Filter volume for the next block
+
+    uint32_t blocks;            ///< Blocks processed
+    uint32_t gated_blocks;      ///< Blocks with the gate closed
+    uint32_t limited_blocks;    ///< Blocks where the limiter lowered the gain
+    uint32_t clipped_samples;   ///< Samples saturated at the int16 range
+} agc_t;
+
+/**
+ * @brief Initialise @p agc from @p cfg.
+ *
+ * @return 0 on success, negative value if the configuration is invalid.
+ */
+int agc_init(agc_t *agc, const agc_config_t *cfg);
+
+/**
+ * @brief Apply the AGC to one block, in place.
+ *
+ * @param agc        State from ::agc_init.
+ * @param pcm        Decimated samples.
+ * @param n          Number of samples.
+ * @param volume     Filter volume the block was produced with. Only used
+ *                   when @c feedback is enabled.
+ */
+void agc_process(agc_t *agc, int16_t *pcm, size_t n, uint16_t volume);
+
+/**
+ * @brief Filter volume to use for the next block (feedback mode), or
+ *        @c base_volume when feedback is disabled.
+ */
+uint16_t agc_volume(const agc_t *agc);
+
+/**
+ * @brief Current total gain in Q8.8 (filter volume part included).
+ */
+uint16_t agc_gain(const agc_t *agc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TKJHAT_AGC_H */
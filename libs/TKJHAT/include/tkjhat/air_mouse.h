@@ -0,0 +1,212 @@
+/*
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 , Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+
+
+/**
+ * @file tkjhat/air_mouse.h
+ * @brief IMU motion to pointer deltas and gamepad axes.
+ *
+ * @details
+ * Turns IMU samples into the values of a USB mouse or gamepad report:
+ *
+ * - **Pointer**: the angular rate of two gyro axes, integrated over the time
+ *   between samples, moves the pointer by @c counts_per_deg counts per degree
+ *   turned. Motion is kept with sub-count precision, and what does not fit the
+ *   ±127 of a report is carried to the next one, so the pointer ends up where
+ *   the total rotation says however the samples and reports line up.
+ * - **Gamepad**: tilt (accelerometer x and y) gives the X and Y axes, full
+ *   deflection at @c tilt_mg; the rate of the pointer X gyro axis gives Rz,
+ *   full deflection at @c yaw_mdps.
+ *
+ * The gyro offset is tracked while the board is still (every axis within
+ * @c still_mdps of the estimate for ::AIR_MOUSE_STILL_US), and a soft dead
+ * zone of @c deadzone_mdps
+ * removes what is left of it and the sensor noise, so a board lying on the
+ * table does not make the pointer creep.
+ *
+ * Samples are added as they come (::air_mouse_update) and reports taken when
+ * the USB endpoint is free (::air_mouse_take): samples that arrive while a
+ * report waits for the host are merged into the next one. Each report carries
+ * the time of the oldest sample in it, for motion-to-report latency
+ * measurements.
+ *
+ * Portable C (no Pico dependencies); the USB side is
+ * @c usbSerialDebug/hid.h, and the host benchmark drives the same code.
+ *
+ * @code
+ * air_mouse_t m;
+ * air_mouse_init(&m, NULL);
+ * // for every IMU sample
+ * air_mouse_update(&m, s.timestamp_us, s.gyro_mdps, s.accel_mg, buttons);
+ * air_mouse_report_t r;
+ * if (endpoint_free && air_mouse_take(&m, &r)) send(r.dx, r.dy, r.buttons);
+ * @endcode
+ */
+
+#ifndef TKJHAT_AIR_MOUSE_H
+#define TKJHAT_AIR_MOUSE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* =========================
+ *  Configuration
+ * ========================= */
+#define AIR_MOUSE_POINTER                       0       ///< Relative pointer motion
+#define AIR_MOUSE_GAMEPAD                       1       ///< Absolute gamepad axes
+
+#define AIR_MOUSE_STILL_US                      500000  ///< Stillness needed before the offset estimate moves
+
+#define AIR_MOUSE_BUTTON1                       0x01
+#define AIR_MOUSE_BUTTON2                       0x02
+
+/**
+ * @brief Settings.
+ */
+typedef struct {
+    uint8_t  mode;              ///< ::AIR_MOUSE_POINTER or ::AIR_MOUSE_GAMEPAD
+    uint8_t  axis_x;            ///< Gyro axis (0..2) moving the pointer horizontally
+    uint8_t  axis_y;            ///< Gyro axis (0..2) moving the pointer vertically
+    int8_t   sign_x;            ///< +1 or -1
+    int8_t   sign_y;            ///< +1 or -1
+    uint16_t counts_per_deg;    ///< Pointer counts per degree turned
+    uint16_t deadzone_mdps;     ///< Angular rate ignored around zero
+    uint16_t still_mdps;        ///< Below this on every axis the board is still (offset tracking), 0 = no tracking
+    uint16_t tilt_mg;           ///< Gamepad: tilt giving full X / Y deflection
+    uint32_t yaw_mdps;          ///< Gamepad: yaw rate giving full Rz deflection
+} air_mouse_config_t;
+
+/** Pointer: yaw moves X, pitch moves Y, 20 counts per degree, 1.5 dps dead zone. */
+#define AIR_MOUSE_DEFAULT_CONFIG {              \
+    .mode           = AIR_MOUSE_POINTER,        \
+    .axis_x         = 2,                        \
+    .axis_y         = 0,                        \
+    .sign_x         = -1,                       \
+    .sign_y         = -1,                       \
+    .counts_per_deg = 20,                       \
+    .deadzone_mdps  = 1500,                     \
+    .still_mdps     = 2500,                     \
+    .tilt_mg        = 500,                      \
+    .yaw_mdps       = 250000,                   \
+}
+
+/**
+ * @brief Values of one report.
+ */
+typedef struct {
+    uint8_t  buttons;           ///< AIR_MOUSE_BUTTON* bits
+    int8_t   dx, dy;            ///< Pointer motion
+    int8_t   x, y, rz;          ///< Gamepad axes
+    uint64_t sample_us;         ///< Time of the oldest sample in the report
+} air_mouse_report_t;
+
+/**
+ * @brief Counters.
+ */
+typedef struct {
+    uint32_t samples;           ///< Samples added
+    uint32_t reports;           ///< Reports taken
+    uint32_t merged;            ///< Samples that shared a report with an earlier one
+    uint32_t carried;           ///< Reports that left motion beyond ±127 for the next
+    int32_t  bias_mdps[3];      ///< Gyro offset estimate
+} air_mouse_stats_t;
+
+/**
+ * @brief State. Treat as opaque.
+ */
+typedef struct {
+    air_mouse_config_t cfg;
+    int32_t  bias_q4[3];        // gyro offset, 1/16 mdps
+    int64_t  rem[2];            // pointer motion below one count, 1e-9 counts
+    int32_t  dx, dy;            // whole counts not reported yet
+    int8_t   axes[3];           // latest gamepad axes
+    int8_t   sent_axes[3];
+    uint8_t  buttons, sent_buttons;
+    bool     dirty;             // something to report
+    bool     started;
+    uint64_t still_since_us;    // start of the current still period, 0 = moving
+    uint32_t batch;             // samples since the last report
+    uint64_t pending_us;        // oldest sample not reported
+    uint64_t last_us;
+    air_mouse_stats_t stats;
+} air_mouse_t;
+
+/* =========================
+ *  API
+ * ========================= */
+
+/**
+ * @brief Reset @p m. @p cfg NULL = ::AIR_MOUSE_DEFAULT_CONFIG.
+ */
+void air_mouse_init(air_mouse_t *m, const air_mouse_config_t *cfg);
+
+/**
+ * @brief Switch between pointer and gamepad. Pending motion is dropped.
+ */
+void air_mouse_set_mode(air_mouse_t *m, uint8_t mode);
+
+/**
+ * @brief Add one IMU sample.
+ *
+ * @param m         State.
+ * @param t_us      Time of the sample. The first sample only sets the time base.
+ * @param gyro_mdps Angular rate x, y, z, milli-degrees per second.
+ * @param accel_mg  Acceleration x, y, z, milli-g.
+ * @param buttons   AIR_MOUSE_BUTTON* bits pressed.
+ */
+void air_mouse_update(air_mouse_t *m, uint64_t t_us, const int32_t gyro_mdps[3], const int32_t accel_mg[3],
+                      uint8_t buttons);
+
+/**
+ * @brief @c true if a report is waiting (motion or a button or axis change).
+ */
+static inline bool air_mouse_pending(const air_mouse_t *m) { return m->dirty; }
+
+/**
+ * @brief Take the next report.
+ *
+ * @return @c true if @p out was filled and should be sent, @c false if
+ *         nothing changed since the last report.
+ */
+bool air_mouse_take(air_mouse_t *m, air_mouse_report_t *out);
+
+/**
+ * @brief Copy the counters.
+ */
+void air_mouse_get_stats(const air_mouse_t *m, air_mouse_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TKJHAT_AIR_MOUSE_H */
@@ -0,0 +1,161 @@
+/*
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 , Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file tkjhat/anomaly.h
+ * @brief Streaming anomaly detector for one sensor channel (EWMA z-score and rate of change).
+ *
+ * @details
+ * Each channel keeps an exponentially weighted mean and variance of its
+ * samples and flags a sample as anomalous when
+ *
+ * - its z-score |x - mean| / sd exceeds @c z_threshold, or
+ * - it changed faster than @c rate_threshold units per second since the
+ *   previous sample.
+ *
+ * While a channel is anomalous its baseline is frozen, so the event does not
+ * teach the detector that it is normal. A level shift that lasts longer than
+ * @c max_freeze samples is accepted as the new normal and the baseline
+ * follows it again.
+ *
+ * The EWMA update is the usual incremental one:
+ *
+ *     d = x - mean;  mean += alpha * d;  var = (1 - alpha) * (var + alpha * d * d)
+ *
+ * Checks are armed after @c warmup samples. The standard deviation is never
+ * taken below @c min_std, so a perfectly flat signal does not trigger on its
+ * first bit of noise.
+ *
+ * ### Typical usage
+ * @code
+ * static anomaly_channel_t lux_ch;
+ *
+ * anomaly_config_t cfg = ANOMALY_DEFAULT_CONFIG;
+ * cfg.min_std = 5.0f;                              // lux
+ * anomaly_init(&lux_ch, &cfg);
+ *
+ * // every sample (dt in seconds since the previous one):
+ * if (anomaly_update(&lux_ch, (float)veml6030_read_light(), 1.0f)) {
+ *     // something is happening
+ * }
+ * @endcode
+ *
+ * The burst sampler (tkjhat/burst.h) runs one detector per source.
+ *
+ * Portable C (no Pico dependencies), so it can also be compiled on a PC
+ * by the host tools.
+ */
+
+#ifndef TKJHAT_ANOMALY_H
+#define TKJHAT_ANOMALY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Reasons reported by ::anomaly_update (bit mask).
+ */
+#define ANOMALY_ZSCORE                          0x01u   ///< |z| above the threshold
+#define ANOMALY_RATE                            0x02u   ///< Rate of change above the threshold
+
+/**
+ * @brief Detector settings.
+ */
+typedef struct {
+    float    alpha;             ///< EWMA weight of a new sample (0 < alpha < 1)
+    float    z_threshold;       ///< z-score that flags a sample, 0 to disable
+    float    rate_threshold;    ///< Units per second that flag a sample, 0 to disable
+    float    min_std;           ///< Floor of the standard deviation (signal units)
+    uint16_t warmup;            ///< Samples before the checks are armed
+    uint16_t max_freeze;        ///< Consecutive anomalous samples after which the baseline adapts
+} anomaly_config_t;
+
+/**
+ * @brief Defaults: alpha 1/32 (about 32 samples of memory), 4 sigma, no rate
+ * check, 32 samples of warm-up, baseline frozen for at most 64 samples.
+ */
+#define ANOMALY_DEFAULT_CONFIG {                \
+    .alpha          = 1.0f / 32.0f,             \
+    .z_threshold    = 4.0f,                     \
+    .rate_threshold = 0.0f,                     \
+    .min_std        = 1e-3f,                    \
+    .warmup         = 32,                       \
+    .max_freeze     = 64,                       \
+}
+
+/**
+ * @brief Detector state of one channel.
+ */
+typedef struct {
+    anomaly_config_t cfg;       ///< Settings
+    float    mean;              ///< EWMA mean
+    float    var;               ///< EWMA variance
+    float    prev;              ///< Previous sample
+    float    last_z;            ///< z-score of the last sample
+    float    last_rate;         ///< Rate of change of the last sample (units per second)
+    uint32_t samples;           ///< Samples seen
+    uint32_t anomalies;         ///< Samples flagged
+    uint16_t frozen;            ///< Consecutive flagged samples
+    uint8_t  last_flags;        ///< Flags of the last sample
+} anomaly_channel_t;
+
+/**
+ * @brief Initialize a channel.
+ *
+ * @param ch  Channel state.
+ * @param cfg Settings, or @c NULL for ::ANOMALY_DEFAULT_CONFIG.
+ */
+void anomaly_init(anomaly_channel_t *ch, const anomaly_config_t *cfg);
+
+/**
+ * @brief Feed one sample.
+ *
+ * @param ch   Channel state.
+ * @param x    Sample.
+ * @param dt_s Seconds since the previous sample (used by the rate check).
+ * @return 0 for a normal sample, otherwise ::ANOMALY_ZSCORE and/or ::ANOMALY_RATE.
+ */
+uint8_t anomaly_update(anomaly_channel_t *ch, float x, float dt_s);
+
+/**
+ * @brief Standard deviation of the baseline (at least @c min_std).
+ */
+float anomaly_std(const anomaly_channel_t *ch);
+
+/**
+ * @brief Forget the baseline (e.g. after the sensor was reconfigured).
+ */
+void anomaly_reset(anomaly_channel_t *ch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TKJHAT_ANOMALY_H */
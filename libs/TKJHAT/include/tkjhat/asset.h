@@ -0,0 +1,261 @@
+/*
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 , Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+
+
+/**
+ * @file tkjhat/asset.h
+ * @brief Packs of images and sound clips kept in flash and used in place.
+ *
+ * @details
+ * A pack is one blob (built on the PC with @c host/tools/asset_pack) that
+ * holds an index and the asset data, 4-byte aligned. It is written to its
+ * own flash region (::asset_flash_open in tkjhat/asset_play.h) or linked
+ * into the program as a @c const array; either way it is read in place
+ * through XIP, nothing is copied to RAM.
+ *
+ * Layout (little endian):
+ *
+ * | Part      | Size        | Notes                                            |
+ * |-----------|-------------|--------------------------------------------------|
+ * | header    | 16          | ::asset_header_t, CRC-16 of the entry table      |
+ * | entries   | 44 x count  | ::asset_entry_t                                  |
+ * | data      | ...         | Each asset at @c offset from the start of the pack |
+ *
+ * Images are stored in the SSD1306 memory layout ("page packed"): a column
+ * of 8 pixels per byte, LSB on top, @c width bytes per 8-pixel page. An
+ * image asset has @c frames frames (animation) and its data starts with a
+ * table of frames + 1 offsets (uint32, relative to the asset data) so any
+ * frame can be found without scanning.
+ *
+ * | Type                 | Frame data                                             |
+ * |----------------------|--------------------------------------------------------|
+ * | ::ASSET_IMAGE_RAW    | ::ASSET_DATA_CONTROL, then width x pages bytes. A 128x64 frame is exactly what the panel expects and is sent straight from flash |
+ * | ::ASSET_IMAGE_RLE    | PackBits: n < 128 = n + 1 literal bytes follow; n >= 128 = next byte repeated n - 125 times |
+ * | ::ASSET_AUDIO_PWM    | uint16 PWM levels (0..::ASSET_PWM_WRAP), fed by DMA to the PWM as they are |
+ * | ::ASSET_AUDIO_ADPCM  | IMA ADPCM, 4 bits per sample, first sample in the low nibble, starting from predictor 0 / index 0 |
+ *
+ * The parsing and decoding functions are portable C (no Pico
+ * dependencies), so the host tool packs and checks with the same code.
+ */
+
+#ifndef TKJHAT_ASSET_H
+#define TKJHAT_ASSET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* =========================
+ *  Format
+ * ========================= */
+#define ASSET_MAGIC                             0x414A4B54u     // "TKJA"
+#define ASSET_VERSION                           1
+#define ASSET_NAME_MAX                          16      // including the NUL padding
+#define ASSET_ALIGN                             4
+#define ASSET_DATA_CONTROL                      0x40    ///< SSD1306 control byte "data follows"
+#define ASSET_PWM_WRAP                          255     ///< PWM top of ::ASSET_AUDIO_PWM levels
+#define ASSET_PWM_MID                           128     ///< Level of silence
+
+#define ASSET_ERR_MAGIC                         -1      ///< Not a pack
+#define ASSET_ERR_VERSION                       -2      ///< Pack of another format version
+#define ASSET_ERR_CRC                           -3      ///< Entry table or asset data damaged
+#define ASSET_ERR_RANGE                         -4      ///< Entry, frame or position outside the data
+#define ASSET_ERR_TYPE                          -5      ///< Operation not valid for this asset type
+
+/**
+ * @brief Kinds of asset.
+ */
+typedef enum {
+    ASSET_IMAGE_RAW   = 1,
+    ASSET_IMAGE_RLE   = 2,
+    ASSET_AUDIO_PWM   = 3,
+    ASSET_AUDIO_ADPCM = 4,
+} asset_type_t;
+
+/**
+ * @brief Start of a pack.
+ */
+typedef struct {
+    uint32_t magic;             ///< ::ASSET_MAGIC
+    uint16_t version;           ///< ::ASSET_VERSION
+    uint16_t count;             ///< Number of entries
+    uint32_t size;              ///< Bytes of the whole pack
+    uint16_t index_crc;         ///< CRC-16/CCITT of the entry table
+    uint16_t reserved;
+} asset_header_t;
+
+/**
+ * @brief One asset of the index.
+ */
+typedef struct {
+    char     name[ASSET_NAME_MAX];  ///< NUL padded
+    uint8_t  type;              ///< ::asset_type_t
+    uint8_t  reserved0;
+    uint16_t frames;            ///< Images: number of frames
+    uint16_t width;             ///< Images: pixels
+    uint16_t height;            ///< Images: pixels
+    uint16_t crc;               ///< CRC-16/CCITT of the data
+    uint16_t reserved1;
+    uint32_t sample_rate;       ///< Audio: Hz
+    uint32_t samples;           ///< Audio: number of samples
+    uint32_t offset;            ///< Data, from the start of the pack
+    uint32_t size;              ///< Bytes of data
+} asset_entry_t;
+
+/**
+ * @brief An opened pack.
+ */
+typedef struct {
+    const uint8_t       *base;
+    uint32_t             size;
+    const asset_entry_t *entries;
+    uint16_t             count;
+} asset_pack_t;
+
+/* =========================
+ *  Index
+ * ========================= */
+
+/**
+ * @brief Check the header and the entry table of the pack at @p base.
+ *
+ * Every entry must lie inside the pack. The asset data is not read (see
+ * ::asset_verify).
+ *
+ * @param size Bytes available at @p base (the pack may be smaller).
+ * @return 0 or an @c ASSET_ERR_* code.
+ */
+int asset_pack_open(asset_pack_t *pack, const void *base, uint32_t size);
+
+/** @brief Entry called @p name, NULL if there is none. */
+const asset_entry_t *asset_find(const asset_pack_t *pack, const char *name);
+
+/** @brief Data of an entry. */
+static inline const uint8_t *asset_data(const asset_pack_t *pack, const asset_entry_t *e) {
+    return pack->base + e->offset;
+}
+
+/** @brief Check the CRC of the data of @p e. @return 0 or ::ASSET_ERR_CRC. */
+int asset_verify(const asset_pack_t *pack, const asset_entry_t *e);
+
+/* =========================
+ *  Images
+ * ========================= */
+
+/** @brief Bytes of one unpacked frame of @p e (width x 8-pixel pages). */
+static inline uint32_t asset_frame_bytes(const asset_entry_t *e) {
+    return (uint32_t)e->width * (((uint32_t)e->height + 7u) / 8u);
+}
+
+/**
+ * @brief Stored data of frame @p frame.
+ *
+ * For ::ASSET_IMAGE_RAW the data starts with ::ASSET_DATA_CONTROL.
+ *
+ * @param[out] len Bytes of the frame data.
+ * @return Pointer into the pack, NULL if @p e is not an image or @p frame is out of range.
+ */
+const uint8_t *asset_frame(const asset_pack_t *pack, const asset_entry_t *e, uint16_t frame, uint32_t *len);
+
+/**
+ * @brief Draw frame @p frame into a page-packed framebuffer.
+ *
+ * The image replaces the pixels it covers (black pixels included), at any
+ * position; parts outside the framebuffer are clipped. RLE frames are
+ * decoded straight into the framebuffer.
+ *
+ * @param fb        Framebuffer in the SSD1306 layout.
+ * @param fb_width  Framebuffer width in pixels.
+ * @param fb_height Framebuffer height in pixels.
+ * @return 0 or an @c ASSET_ERR_* code.
+ */
+int asset_draw(const asset_pack_t *pack, const asset_entry_t *e, uint16_t frame,
+               uint8_t *fb, uint16_t fb_width, uint16_t fb_height, int16_t x, int16_t y);
+
+/**
+ * @brief PackBits-encode @p n bytes.
+ * @return Encoded size, 0 if it does not fit in @p cap.
+ */
+size_t asset_rle_encode(const uint8_t *src, size_t n, uint8_t *dst, size_t cap);
+
+/**
+ * @brief Decode PackBits data.
+ * @return Decoded size, 0 if the data is malformed or does not fit in @p cap.
+ */
+size_t asset_rle_decode(const uint8_t *src, size_t n, uint8_t *dst, size_t cap);
+
+/* =========================
+ *  Audio
+ * ========================= */
+
+/**
+ * @brief IMA ADPCM coder state.
+ */
+typedef struct {
+    int32_t predictor;
+    uint8_t index;
+} asset_adpcm_t;
+
+/** @brief Start state of every clip. */
+static inline void asset_adpcm_init(asset_adpcm_t *s) {
+    s->predictor = 0;
+    s->index = 0;
+}
+
+/** @brief Encode one sample. @return 4-bit code. */
+uint8_t asset_adpcm_encode(asset_adpcm_t *s, int16_t sample);
+
+/** @brief Decode one 4-bit code. */
+int16_t asset_adpcm_decode(asset_adpcm_t *s, uint8_t code);
+
+/** @brief PWM level (0..::ASSET_PWM_WRAP) of a 16-bit sample. */
+static inline uint16_t asset_pwm_level(int16_t sample) {
+    return (uint16_t)(((int32_t)sample + 32768) >> 8);
+}
+
+/**
+ * @brief Decode @p count samples of an ::ASSET_AUDIO_ADPCM clip into PWM levels.
+ *
+ * @param s     State, carried from one call to the next.
+ * @param data  Clip data.
+ * @param first Index of the first sample (the calls must follow each other).
+ * @return Samples written (fewer at the end of the clip).
+ */
+size_t asset_adpcm_decode_pwm(asset_adpcm_t *s, const asset_entry_t *e, const uint8_t *data,
+                              uint32_t first, uint16_t *levels, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TKJHAT_ASSET_H
@@ -0,0 +1,171 @@
+/*
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 , Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+
+
+/**
+ * @file tkjhat/asset_play.h
+ * @brief Showing and playing the assets of a pack (tkjhat/asset.h) from flash.
+ *
+ * @details
+ * Nothing is copied to RAM:
+ *
+ * - ::display_show_frame sends a 128x64 ::ASSET_IMAGE_RAW frame to the
+ *   panel straight from flash: the stored frame already starts with the
+ *   SSD1306 data control byte, so it is one I2C transfer from XIP. The
+ *   framebuffer is left as it was; the show hook (e.g. the display mirror)
+ *   still sees the frame.
+ * - ::display_draw_asset draws any image frame (raw or RLE, any size and
+ *   position) into the framebuffer, decoding RLE on the fly, and shows it.
+ * - ::asset_play_start plays a clip on the buzzer through PWM (488 kHz
+ *   carrier, 8-bit levels). A DMA channel paced by a DMA timer at the sample
+ *   rate writes the levels to the PWM compare register. ::ASSET_AUDIO_PWM
+ *   clips are read by the DMA directly from flash through the XIP alias that
+ *   does not allocate in the cache, so a long clip neither uses the CPU nor
+ *   evicts the program from the XIP cache. ::ASSET_AUDIO_ADPCM clips (4x
+ *   smaller) are decoded by the DMA interrupt into two blocks of
+ *   ::ASSET_PLAY_BLOCK levels that two chained channels play in turn.
+ *
+ * The pack is usually written to its own flash region, after the program:
+ * @code
+ * ./build-host/asset_pack assets.bin intro=f0.pbm,f1.pbm,f2.pbm chime=chime.wav
+ * picotool load -o 0x10100000 assets.bin     // XIP_BASE + ASSET_FLASH_OFFSET
+ * @endcode
+ * @code
+ * asset_pack_t pack;
+ * if (asset_flash_open(&pack) == 0) {
+ *     const asset_entry_t *intro = asset_find(&pack, "intro");
+ *     for (uint16_t f = 0; f < intro->frames; f++) display_show_frame(&pack, intro, f);
+ *     asset_play_init();
+ *     asset_play_start(&pack, asset_find(&pack, "chime"));
+ * }
+ * @endcode
+ *
+ * @note The display functions use the I2C bus like the other display
+ *       functions: call them from the task that owns the bus.
+ * @note While a clip plays the buzzer pin belongs to the PWM;
+ *       ::buzzer_play_tone works again once it has ended or been stopped.
+ */
+
+#ifndef TKJHAT_ASSET_PLAY_H
+#define TKJHAT_ASSET_PLAY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <tkjhat/asset.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* =========================
+ *  Configuration
+ * ========================= */
+#ifndef ASSET_FLASH_OFFSET
+#define ASSET_FLASH_OFFSET                      (1024u * 1024u)     // pack region, from the start of the flash
+#endif
+#ifndef ASSET_PLAY_BLOCK
+#define ASSET_PLAY_BLOCK                        256     // ADPCM levels decoded per interrupt
+#endif
+
+#define ASSET_PLAY_ERR_BUSY                     -10     ///< Player not initialised, or already initialised
+#define ASSET_PLAY_ERR_RESOURCE                 -11     ///< No free DMA channel or DMA timer
+#define ASSET_PLAY_ERR_RATE                     -12     ///< Sample rate the DMA timer cannot produce
+
+/**
+ * @brief Counters of the player.
+ */
+typedef struct {
+    uint32_t clips;             ///< Clips started
+    uint32_t samples;           ///< Samples queued to the PWM
+    uint32_t refills;           ///< ADPCM blocks decoded
+    uint32_t late_refills;      ///< Blocks decoded after their turn (heard as a repeated block)
+    uint32_t refill_us_max;     ///< Longest decode in the interrupt
+} asset_play_stats_t;
+
+/* =========================
+ *  Pack in flash
+ * ========================= */
+
+/** @brief Open the pack at @c XIP_BASE + ::ASSET_FLASH_OFFSET. @return 0 or an @c ASSET_ERR_* code. */
+int asset_flash_open(asset_pack_t *pack);
+
+/* =========================
+ *  Display (sdk.c)
+ * ========================= */
+
+/**
+ * @brief Send a full-screen ::ASSET_IMAGE_RAW frame to the panel straight from flash.
+ *
+ * The framebuffer is not touched: the next drawing call shows it again.
+ *
+ * @return 0, ::ASSET_ERR_TYPE if the frame is not a raw 128x64 frame
+ *         (use ::display_draw_asset), or ::ASSET_ERR_RANGE.
+ */
+int display_show_frame(const asset_pack_t *pack, const asset_entry_t *e, uint16_t frame);
+
+/**
+ * @brief Draw an image frame at (x, y) into the framebuffer and update the panel.
+ * @return 0 or an @c ASSET_ERR_* code.
+ */
+int display_draw_asset(const asset_pack_t *pack, const asset_entry_t *e, uint16_t frame, int16_t x, int16_t y);
+
+/* =========================
+ *  Audio
+ * ========================= */
+
+/**
+ * @brief Claim two DMA channels and a DMA timer for the player.
+ * @return 0, ::ASSET_PLAY_ERR_BUSY or ::ASSET_PLAY_ERR_RESOURCE.
+ */
+int asset_play_init(void);
+
+/**
+ * @brief Start playing @p e; a clip already playing is stopped.
+ * @return 0, ::ASSET_ERR_TYPE, ::ASSET_PLAY_ERR_BUSY or ::ASSET_PLAY_ERR_RATE.
+ */
+int asset_play_start(const asset_pack_t *pack, const asset_entry_t *e);
+
+/** @brief A clip is playing. Also reports the end of a clip to tkjhat/energy.h. */
+bool asset_play_busy(void);
+
+/** @brief Stop the clip, give the buzzer pin back to ::buzzer_play_tone. */
+void asset_play_stop(void);
+
+/** @brief Release the DMA channels and the timer. */
+void asset_play_deinit(void);
+
+/** @brief Counters since ::asset_play_init. */
+void asset_play_get_stats(asset_play_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TKJHAT_ASSET_PLAY_H
@@ -0,0 +1,252 @@
+/*
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 , Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file tkjhat/burst.h
+ * @brief Anomaly-triggered burst sampling with pre-trigger history.
+ *
+ * @details
+ * The board normally samples its sensors slowly and sends nothing. A sampler
+ * task reads every registered *source* at its idle period, keeps the samples
+ * in a small pre-trigger ring and feeds one value (or the norm of a few
+ * values) to an anomaly detector (tkjhat/anomaly.h). When a detector fires,
+ * or ::burst_trigger is called:
+ *
+ * 1. every source is switched to its burst rate through its @c set_rate hook
+ *    (e.g. raise the IMU ODR, read the light sensor at every integration,
+ *    start the microphone),
+ * 2. a @c begin line and the ring samples of the last @c pretrigger_ms are
+ *    written to the sink,
+ * 3. every new sample is written to the sink as it is taken,
+ * 4. @c burst_ms after the last anomalous sample (at most @c max_burst_ms
+ *    after the start) the sources go back to their idle rate and an @c end
+ *    line closes the burst. No new burst starts during @c cooldown_ms.
+ *
+ * So USB bandwidth is spent only while something is happening.
+ *
+ * ### Output
+ * Plain text, one line per record, easy to split on commas:
+ *
+ *     #burst,<id>,begin,<uptime ms>,<source>,<z|rate|manual>,<z-score>
+ *     <source>,<us relative to the trigger>,<v0>,<v1>,...
+ *     #burst,<id>,end,<uptime ms>,<samples>,<lost>
+ *
+ * Pre-trigger samples have negative times.
+ *
+ * ### Typical usage
+ * @code
+ * static int read_imu(float *v, void *ctx) {
+ *     float t;
+ *     return ICM42670_read_sensor_data(&v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &t) == 0 ? 6 : -1;
+ * }
+ * static void imu_rate(bool burst, void *ctx) {
+ *     ICM42670_startAccel(burst ? 400 : 25, ICM42670_ACCEL_FSR_DEFAULT);
+ * }
+ * static int to_cdc1(const char *text, size_t len, void *ctx) {
+ *     return tud_cdc_n_write(1, text, len) == len ? 0 : -1;
+ * }
+ *
+ * burst_source_t imu = BURST_SOURCE_DEFAULT;
+ * imu.name = "imu";
+ * imu.idle_period_ms = 100;
+ * imu.burst_period_ms = 5;
+ * imu.read = read_imu;
+ * imu.set_rate = imu_rate;
+ * imu.detect_first = 0;              // |a| = norm of ax, ay, az
+ * imu.detect_count = 3;
+ * burst_add_source(&imu);
+ *
+ * burst_config_t cfg = BURST_DEFAULT_CONFIG;
+ * burst_init(&cfg, to_cdc1, NULL);
+ * @endcode
+ */
+
+#ifndef BURST_H
+#define BURST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <tkjhat/anomaly.h>
+
+/* =========================
+ *  Configuration
+ * ========================= */
+#ifndef BURST_MAX_SOURCES
+#define BURST_MAX_SOURCES                       4
+#endif
+#ifndef BURST_RING_SAMPLES
+#define BURST_RING_SAMPLES                      96  // pre-trigger history shared by all sources
+#endif
+#ifndef BURST_PRIORITY
+#define BURST_PRIORITY                          (tskIDLE_PRIORITY + 2)
+#endif
+#define BURST_MAX_VALUES                        6   // values per sample
+#define BURST_NAME_LEN                          8
+#define BURST_LINE_SIZE                         112 // longest output line
+#define BURST_REPORT_SIZE                       (64 + BURST_MAX_SOURCES * 96)
+
+/**
+ * @brief Reads one sample of a source.
+ *
+ * @param values Destination for up to ::BURST_MAX_VALUES values.
+ * @param ctx    Context given in ::burst_source_t.
+ * @return Number of values written, or 0 / negative to skip this sample.
+ */
+typedef int (*burst_read_fn)(float *values, void *ctx);
+
+/**
+ * @brief Switches a source between its idle and its burst configuration.
+ */
+typedef void (*burst_rate_fn)(bool burst, void *ctx);
+
+/**
+ * @brief Writes output text (USB CDC, UART...).
+ *
+ * @return 0 if all of @p len was accepted, negative value otherwise (the
+ *         line is counted as lost).
+ */
+typedef int (*burst_sink_fn)(const char *text, size_t len, void *ctx);
+
+/**
+ * @brief A sampled source.
+ */
+typedef struct {
+    const char      *name;              ///< Short name used in the output
+    uint32_t         idle_period_ms;    ///< Period outside bursts, 0 = sampled only during bursts
+    uint32_t         burst_period_ms;   ///< Period during bursts
+    burst_read_fn    read;              ///< Reads one sample
+    burst_rate_fn    set_rate;          ///< Optional rate switch
+    void            *ctx;               ///< Passed to the hooks
+    uint8_t          detect_first;      ///< First value fed to the detector
+    uint8_t          detect_count;      ///< 0 = no detection, 1 = that value, >1 = norm of that many values
+    anomaly_config_t detect;            ///< Detector settings
+} burst_source_t;
+
+/**
+ * @brief Source defaults: 1 s idle, 50 ms burst, detector on value 0 with
+ * ::ANOMALY_DEFAULT_CONFIG. Set @c name and @c read.
+ */
+#define BURST_SOURCE_DEFAULT {                  \
+    .name            = NULL,                    \
+    .idle_period_ms  = 1000,                    \
+    .burst_period_ms = 50,                      \
+    .read            = NULL,                    \
+    .set_rate        = NULL,                    \
+    .ctx             = NULL,                    \
+    .detect_first    = 0,                       \
+    .detect_count    = 1,                       \
+    .detect          = ANOMALY_DEFAULT_CONFIG,  \
+}
+
+/**
+ * @brief Burst timing.
+ */
+typedef struct {
+    uint32_t pretrigger_ms;     ///< History written before the trigger
+    uint32_t burst_ms;          ///< Burst continues this long after the last anomalous sample
+    uint32_t max_burst_ms;      ///< Longest burst
+    uint32_t cooldown_ms;       ///< Quiet time between bursts
+} burst_config_t;
+
+/**
+ * @brief Defaults: 1 s of history, bursts of 2 s after the last anomaly
+ * (10 s at most), 5 s between bursts.
+ */
+#define BURST_DEFAULT_CONFIG {                  \
+    .pretrigger_ms = 1000,                      \
+    .burst_ms      = 2000,                      \
+    .max_burst_ms  = 10000,                     \
+    .cooldown_ms   = 5000,                      \
+}
+
+/**
+ * @brief Usage counters.
+ */
+typedef struct {
+    uint32_t bursts;            ///< Bursts started
+    uint32_t samples;           ///< Samples taken
+    uint32_t sent;              ///< Sample lines written
+    uint32_t lost;              ///< Lines the sink did not accept
+    uint32_t suppressed;        ///< Triggers ignored during the cooldown
+} burst_stats_t;
+
+/**
+ * @brief Register a source. Call before ::burst_init.
+ *
+ * The source is copied. It starts at its idle rate, so @c set_rate(false, ctx)
+ * is called from the sampler task before its first sample.
+ *
+ * @return Source id (>= 0), negative on error.
+ */
+int burst_add_source(const burst_source_t *src);
+
+/**
+ * @brief Start the sampler task.
+ *
+ * @param cfg  Timing, or @c NULL for ::BURST_DEFAULT_CONFIG.
+ * @param sink Output for the bursts.
+ * @param ctx  Passed to @p sink.
+ *
+ * @return 0 on success, negative value on error.
+ *
+ * @note Can be called before ::vTaskStartScheduler().
+ */
+int burst_init(const burst_config_t *cfg, burst_sink_fn sink, void *ctx);
+
+/**
+ * @brief Start a burst now (e.g. from a button), as if a detector had fired.
+ *
+ * Safe to call from any task. Ignored during the cooldown.
+ */
+void burst_trigger(void);
+
+/**
+ * @brief @c true while a burst is running.
+ */
+bool burst_active(void);
+
+/**
+ * @brief Copy of the detector state of source @p id.
+ *
+ * @return 0 on success, negative value if @p id is not valid.
+ */
+int burst_get_channel(int id, anomaly_channel_t *out);
+
+/**
+ * @brief Usage counters.
+ */
+void burst_get_stats(burst_stats_t *out);
+
+/**
+ * @brief Write a short text report (counters and the baseline of each source).
+ *
+ * @return Number of characters written (excluding the terminator).
+ */
+int burst_format_report(char *buf, size_t len);
+
+#endif /* BURST_H */
@@ -0,0 +1,67 @@
+/*
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 , Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+
+/**
+ * @file tkjhat/crc.h
+ * @brief CRC helpers shared by the SDK transports.
+ *
+ * Portable C (no Pico dependencies), so it can also be compiled on a PC
+ * by the host tools.
+ */
+
+#ifndef TKJHAT_CRC_H
+#define TKJHAT_CRC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CRC16_CCITT_INIT                        0xFFFFu
+
+/**
+ * @brief CRC-16/CCITT-FALSE (poly 0x1021, MSB first, no reflection).
+ *
+ * Can be computed incrementally: pass ::CRC16_CCITT_INIT the first time and
+ * the previous result afterwards.
+ *
+ * @param crc  Initial value or running CRC.
+ * @param data Bytes to add.
+ * @param len  Number of bytes.
+ * @return Updated CRC. The check value of "123456789" is 0x29B1.
+ */
+uint16_t crc16_ccitt(uint16_t crc, const void *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TKJHAT_CRC_H */
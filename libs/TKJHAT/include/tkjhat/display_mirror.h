@@ -0,0 +1,112 @@
+/*
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 , Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+
+/**
+ * @file tkjhat/display_mirror.h
+ * @brief Mirror the OLED framebuffer to the host as compressed deltas.
+ *
+ * @details
+ * When started, every ::ssd1306_show() also encodes the bytes that changed
+ * since the previous frame (see tkjhat/fb_delta.h) and passes the record to
+ * a sink, typically a CDC port. Unchanged frames produce nothing. A keyframe
+ * (the whole frame against black) is sent periodically and after any record
+ * the sink could not take, so the host recovers from drops.
+ *
+ * The encoder compares the 1 KB framebuffer with a shadow copy and runs
+ * after the I2C transfer, which takes ~25 ms at 400 kHz; encoding takes a
+ * few microseconds (see host/bench/bench_fb_delta). The sink must not block.
+ *
+ * On the PC, `host/tools/display_mirror_rx` turns the stream into PBM images
+ * with timestamps and an ffmpeg concat list for making a video. The
+ * hat_display_mirror example sends the records on CDC1 with the sink below.
+ *
+ * @code
+ * // Send the records on CDC1 (usb-serial-debug data port), never blocking
+ * static bool cdc1_sink(const uint8_t *data, size_t len, void *ctx) {
+ *     if (!tud_cdc_n_connected(1) || tud_cdc_n_write_available(1) < len) return false;
+ *     tud_cdc_n_write(1, data, len);
+ *     tud_cdc_n_write_flush(1);
+ *     return true;
+ * }
+ *
+ * display_mirror_start(cdc1_sink, NULL, 100);
+ * @endcode
+ */
+
+#ifndef DISPLAY_MIRROR_H
+#define DISPLAY_MIRROR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Receives one encoded record.
+ *
+ * @return @c true if the whole record was accepted, @c false if it was dropped.
+ */
+typedef bool (*display_mirror_sink_t)(const uint8_t *data, size_t len, void *ctx);
+
+/**
+ * @brief Mirroring counters.
+ */
+typedef struct {
+    uint32_t frames;            ///< ssd1306_show() calls seen
+    uint32_t records;           ///< Records accepted by the sink
+    uint32_t keyframes;         ///< Keyframes accepted by the sink
+    uint32_t unchanged;         ///< Frames with no change (nothing sent)
+    uint32_t dropped;           ///< Records refused by the sink
+    uint64_t bytes;             ///< Bytes accepted by the sink
+    uint32_t encode_us_max;     ///< Worst encode time added to ssd1306_show()
+    uint32_t encode_us_avg;
+} display_mirror_stats_t;
+
+/**
+ * @brief Start mirroring.
+ *
+ * @param sink               Destination of the records.
+ * @param ctx                Passed to @p sink.
+ * @param keyframe_interval  Send a keyframe every this many records (0: only
+ *                           the first one and after drops).
+ *
+ * @return 0 on success, negative value on error.
+ */
+int display_mirror_start(display_mirror_sink_t sink, void *ctx, uint16_t keyframe_interval);
+
+/**
+ * @brief Stop mirroring. ::ssd1306_show() goes back to its normal cost.
+ */
+void display_mirror_stop(void);
+
+/**
+ * @brief Copy the mirroring counters.
+ */
+void display_mirror_get_stats(display_mirror_stats_t *out);
+
+#endif /* DISPLAY_MIRROR_H */
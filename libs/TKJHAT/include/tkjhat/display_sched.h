@@ -0,0 +1,257 @@
+/*
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 , Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+
+
+/**
+ * @file tkjhat/display_sched.h
+ * @brief Refresh and power scheduling of the OLED panel.
+ *
+ * @details
+ * Every ::ssd1306_show sends the whole 1 KB framebuffer over I2C (about
+ * 23 ms at 400 kHz), whether or not anything changed, and the panel stays
+ * on at full contrast until ::stop_display. The scheduler sits in front of
+ * the flush:
+ *
+ * - A frame whose hash equals the one on the panel is skipped.
+ * - A changed frame waits @c settle_ms, so the usual ::clear_display
+ *   followed by a redraw reaches the panel as one frame (and not at all if
+ *   the redraw gives back what the panel shows). It is also held until the
+ *   last flush is one refresh period old. A newer frame drawn meanwhile
+ *   replaces it (coalesced); only the last frame of a burst of drawing is
+ *   sent.
+ * - The period adapts to the content: it halves (down to
+ *   @c min_period_ms) when the content changed again within the period
+ *   after a flush, and doubles (up to @c max_period_ms) when it stayed
+ *   static for two periods.
+ * - The panel is powered down after @c idle_off_ms without a change and
+ *   powered up again by the next changed frame.
+ * - The contrast follows the ambient light (VEML6030) in four steps:
+ *
+ * | Lux        | Contrast |
+ * |------------|----------|
+ * | < 5        | 16       |
+ * | 5 .. 50    | 64       |
+ * | 50 .. 500  | 160      |
+ * | >= 500     | 255      |
+ *
+ *   A step only changes once the reading is @c hysteresis_pct beyond the
+ *   threshold, so a reading hovering around a threshold does not make the
+ *   panel flicker.
+ *
+ * The policy below is portable C: it gets timestamps and frame hashes and
+ * returns what to do (@c DISPLAY_SCHED_* action bits). The SDK glue
+ * (::display_sched_start) wires it to the SSD1306 of the HAT through
+ * ::ssd1306_set_show_filter; the host benchmark drives the same code with
+ * synthetic workloads.
+ *
+ * The glue performs deferred flushes, power changes and light readings in
+ * ::display_sched_service, which must run in the task that owns the I2C bus
+ * (the SDK has no bus lock), e.g. next to the IMU reads. ::write_text and
+ * ::write_text_xy also flush a deferred frame during their pause. A task
+ * that animates can call ::display_sched_service after drawing each frame,
+ * so frames go out as soon as the period allows.
+ *
+ * @code
+ * init_display();
+ * init_veml6030();
+ * display_sched_config_t cfg = DISPLAY_SCHED_DEFAULT_CONFIG;
+ * display_sched_start(&cfg);
+ * ...
+ * // every few tens of ms, in the task using the I2C sensors:
+ * display_sched_service();
+ * @endcode
+ */
+
+#ifndef TKJHAT_DISPLAY_SCHED_H
+#define TKJHAT_DISPLAY_SCHED_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* =========================
+ *  Policy
+ * ========================= */
+#define DISPLAY_SCHED_FLUSH                     0x01    ///< Send the framebuffer, then call ::display_sched_flushed
+#define DISPLAY_SCHED_POWER_ON                  0x02    ///< Power the panel up (before the flush)
+#define DISPLAY_SCHED_POWER_OFF                 0x04    ///< Power the panel down
+#define DISPLAY_SCHED_READ_LIGHT                0x08    ///< Read the ambient light, pass it to ::display_sched_light
+
+/**
+ * @brief Settings.
+ */
+typedef struct {
+    uint16_t settle_ms;         ///< Delay of a changed frame, 0 = send at once if the period allows
+    uint16_t min_period_ms;     ///< Shortest time between two flushes
+    uint16_t max_period_ms;     ///< Period reached while the content is static
+    uint32_t idle_off_ms;       ///< Power down after this long without a change, 0 = never
+    uint32_t light_period_ms;   ///< Ambient light sampling period, 0 = fixed contrast
+    uint8_t  hysteresis_pct;    ///< Margin around the lux thresholds of the contrast steps
+} display_sched_config_t;
+
+/** 10 ms settle, 20..100 ms refresh period, off after 60 s, light every second, 25 % hysteresis. */
+#define DISPLAY_SCHED_DEFAULT_CONFIG {          \
+    .settle_ms       = 10,                      \
+    .min_period_ms   = 20,                      \
+    .max_period_ms   = 100,                     \
+    .idle_off_ms     = 60000,                   \
+    .light_period_ms = 1000,                    \
+    .hysteresis_pct  = 25,                      \
+}
+
+/**
+ * @brief Counters.
+ */
+typedef struct {
+    uint32_t requests;          ///< Frames offered (::ssd1306_show calls)
+    uint32_t flushes;           ///< Frames sent to the panel
+    uint32_t skipped;           ///< Frames identical to the one on the panel
+    uint32_t coalesced;         ///< Changed frames replaced by a newer one before their slot
+    uint32_t power_downs;
+    uint32_t power_ups;
+    uint32_t contrast_changes;
+    uint64_t bus_us;            ///< Time spent sending frames
+    uint64_t on_us;             ///< Time the panel was powered
+    uint64_t elapsed_us;        ///< Time since ::display_sched_init
+    uint32_t period_ms;         ///< Current refresh period
+    uint32_t lux;               ///< Last ambient light reading
+    uint8_t  contrast;          ///< Current contrast
+} display_sched_stats_t;
+
+/**
+ * @brief Scheduler state.
+ */
+typedef struct {
+    display_sched_config_t cfg;
+    display_sched_stats_t  stats;
+    uint32_t shown_hash;        ///< Frame on the panel
+    uint32_t pending_hash;      ///< Frame waiting for its slot
+    bool     pending;
+    bool     flushed_once;
+    uint64_t pending_us;        ///< Time the pending frame first differed from the panel
+    bool     powered;
+    uint8_t  level;             ///< Contrast step
+    uint32_t period_ms;
+    uint64_t start_us;
+    uint64_t last_flush_us;
+    uint64_t last_change_us;
+    uint64_t power_on_us;       ///< Start of the current powered interval
+    uint64_t next_light_us;
+} display_sched_t;
+
+/**
+ * @brief Initialise @p s with @p cfg (NULL = ::DISPLAY_SCHED_DEFAULT_CONFIG).
+ *
+ * The panel is assumed powered, at full contrast, with unknown content.
+ */
+void display_sched_init(display_sched_t *s, const display_sched_config_t *cfg, uint64_t now_us);
+
+/** @brief FNV-1a hash of a framebuffer. */
+uint32_t display_sched_hash(const uint8_t *data, size_t len);
+
+/**
+ * @brief A frame with hash @p hash was drawn.
+ * @return Action bits: ::DISPLAY_SCHED_FLUSH (+ ::DISPLAY_SCHED_POWER_ON) to
+ *         send it now (only with @c settle_ms 0), 0 if it was skipped or
+ *         deferred to ::display_sched_poll.
+ */
+unsigned display_sched_request(display_sched_t *s, uint32_t hash, uint64_t now_us);
+
+/**
+ * @brief Periodic work: deferred flush, power-down, light sampling.
+ * @return Action bits.
+ */
+unsigned display_sched_poll(display_sched_t *s, uint64_t now_us);
+
+/**
+ * @brief A frame with hash @p hash was sent (hash it just before the
+ *        transfer); the transfer took @p bus_us.
+ */
+void display_sched_flushed(display_sched_t *s, uint32_t hash, uint64_t now_us, uint32_t bus_us);
+
+/**
+ * @brief The panel was written without going through the framebuffer
+ *        (e.g. a frame sent from flash); its content is unknown.
+ * @return ::DISPLAY_SCHED_POWER_ON if the panel has to be powered up first.
+ */
+unsigned display_sched_external(display_sched_t *s, uint64_t now_us);
+
+/**
+ * @brief Ambient light reading in lux.
+ * @return New contrast to apply, or -1 if it stays.
+ */
+int display_sched_light(display_sched_t *s, uint32_t lux);
+
+/**
+ * @brief Time until the pending frame is due (0 = now), -1 if none is pending.
+ */
+int64_t display_sched_due_us(const display_sched_t *s, uint64_t now_us);
+
+/** @brief Counters, with the on-time and elapsed time brought up to @p now_us. */
+void display_sched_get_stats(const display_sched_t *s, uint64_t now_us, display_sched_stats_t *out);
+
+/* =========================
+ *  SDK display (device only)
+ * ========================= */
+
+/**
+ * @brief Put the scheduler in front of the HAT display.
+ *
+ * Call after ::init_display (and ::init_veml6030 if @c light_period_ms is
+ * not 0). @p cfg NULL = ::DISPLAY_SCHED_DEFAULT_CONFIG.
+ */
+void display_sched_start(const display_sched_config_t *cfg);
+
+/** @brief Remove the scheduler; ::ssd1306_show flushes every frame again. */
+void display_sched_stop(void);
+
+/**
+ * @brief Deferred flushes, power-down and contrast. Call every 10..50 ms
+ *        from the task that owns the I2C bus.
+ */
+void display_sched_service(void);
+
+/** @brief Counters of the running scheduler. */
+void display_sched_stats(display_sched_stats_t *out);
+
+/**
+ * @brief Write a one-line report into @p buf.
+ * @return Number of characters written (excluding the terminator).
+ */
+int display_sched_format_report(char *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TKJHAT_DISPLAY_SCHED_H
@@ -0,0 +1,134 @@
+/*
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 , Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file tkjhat/early_log.h
+ * @brief Early-log ring for USB stdio: boot without waiting for a terminal.
+ *
+ * @details
+ * Applications that print through USB stdio (@c pico_enable_stdio_usb) used
+ * to spin on @c stdio_usb_connected() before doing anything, so a headless
+ * board never started sampling. ::early_log_init puts a stdio driver in
+ * front of the USB one:
+ *
+ * - while no host has the port (CDC0) open, everything written to stdout
+ *   goes into a RAM ring of ::EARLY_LOG_SIZE bytes. When the ring is full
+ *   the oldest bytes are overwritten and counted as dropped,
+ * - once a host opens the port (and it stayed open ::EARLY_LOG_SETTLE_MS),
+ *   the ring is replayed first, preceded by a line with the dropped byte
+ *   count if any, and output goes straight to USB again,
+ * - if the host closes the port, output is buffered again until the next one.
+ *
+ * The replay happens on the next write after the host connects, or from a
+ * small poll task so a quiet application also gets its logs out.
+ * Input (getchar) is passed through to the USB driver.
+ *
+ * ### Typical usage
+ * @code
+ * int main(void) {
+ *     stdio_init_all();
+ *     early_log_init(true);       // instead of while (!stdio_usb_connected()) ...
+ *     printf("boot\n");           // kept until a terminal opens
+ *     init_hat_sdk();
+ *     // create tasks ...
+ *     vTaskStartScheduler();
+ * }
+ * @endcode
+ *
+ * For binary streams (e.g. raw audio) check ::early_log_connected before
+ * writing, so the samples do not fill the ring while nobody listens.
+ *
+ * @note Targets without USB stdio are left untouched (::early_log_init fails).
+ */
+
+#ifndef EARLY_LOG_H
+#define EARLY_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* =========================
+ *  Configuration
+ * ========================= */
+#ifndef EARLY_LOG_SIZE
+#define EARLY_LOG_SIZE                          4096    // bytes kept while no host is connected
+#endif
+#ifndef EARLY_LOG_SETTLE_MS
+#define EARLY_LOG_SETTLE_MS                     100     // the host must keep the port open this long
+#endif
+#ifndef EARLY_LOG_POLL_MS
+#define EARLY_LOG_POLL_MS                       100     // poll task period
+#endif
+#ifndef EARLY_LOG_PRIORITY
+#define EARLY_LOG_PRIORITY                      (tskIDLE_PRIORITY + 1)
+#endif
+
+/**
+ * @brief Counters since boot.
+ */
+typedef struct {
+    uint32_t buffered;      ///< Bytes written while no host was connected
+    uint32_t dropped;       ///< Bytes overwritten before a host read them
+    uint32_t replayed;      ///< Bytes replayed to a host
+    uint32_t replays;       ///< Host connections that received a replay
+    uint32_t held;          ///< Bytes in the ring now
+} early_log_stats_t;
+
+/**
+ * @brief Start buffering stdout until a host connects to CDC0.
+ *
+ * Call right after @c stdio_init_all().
+ *
+ * @param poll_task Also create a FreeRTOS task that replays the ring as soon
+ *                  as a host connects. Without it the replay happens on the
+ *                  next write or ::early_log_connected call.
+ *
+ * @return 0 on success, negative value on error (already started, the
+ *         target has no USB stdio, or the task could not be created).
+ */
+int early_log_init(bool poll_task);
+
+/**
+ * @brief @c true when a host is connected and has received the ring.
+ *
+ * Replays the ring first if a host has just connected.
+ */
+bool early_log_connected(void);
+
+/**
+ * @brief Counters since boot.
+ */
+void early_log_get_stats(early_log_stats_t *out);
+
+/**
+ * @brief Write a one-line text report of the counters.
+ *
+ * @return Number of characters written (excluding the terminator).
+ */
+int early_log_format_report(char *buf, size_t len);
+
+#endif /* EARLY_LOG_H */
@@ -0,0 +1,220 @@
+/*
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 , Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+
+/**
+ * @file tkjhat/energy.h
+ * @brief Per-peripheral energy accounting (time in state x current table).
+ *
+ * @details
+ * Every power-relevant component of the board (both CPU cores, the sensors,
+ * the OLED, the RGB LED, the buzzer, the microphone and USB) has a power
+ * state and an optional 0-255 level (contrast, PWM duty, enabled
+ * sub-sensors). The SDK functions report their transitions with
+ * ::energy_set_state, and the time spent in each state is accumulated.
+ *
+ * The charge a component draws is estimated from a current table: in each
+ * state the component is modelled as
+ *
+ *     I = base_ua + span_ua * level / 255
+ *
+ * and the product of current and time is integrated at every transition.
+ * The defaults are typical datasheet values for the HAT; measure your own
+ * board and change them with ::energy_set_current.
+ *
+ * CPU time is not reported by the SDK: a service task samples the run-time
+ * counters of the idle task of each core every period and splits the
+ * elapsed time into active and idle. Components the SDK cannot observe
+ * (e.g. whether USB is mounted or suspended) can be polled with a probe
+ * registered with ::energy_set_probe.
+ *
+ * ### Typical usage
+ * @code
+ * static energy_state_t usb_state(uint8_t *level) {
+ *     (void)level;
+ *     if (!tud_mounted()) return ENERGY_OFF;
+ *     return tud_suspended() ? ENERGY_IDLE : ENERGY_ON;
+ * }
+ *
+ * static void report_task(void *arg) {
+ *     char buf[ENERGY_REPORT_SIZE];
+ *     for (;;) {
+ *         vTaskDelay(pdMS_TO_TICKS(10000));
+ *         energy_format_report(buf, sizeof(buf));
+ *         usb_serial_print(buf);                  // CDC0
+ *     }
+ * }
+ *
+ * int main(void) {
+ *     energy_init(1000);                          // sample the cores every second
+ *     energy_set_probe(ENERGY_USB, usb_state);
+ *     init_hat_sdk();
+ *     // create tasks ...
+ *     vTaskStartScheduler();
+ * }
+ * @endcode
+ *
+ * @note CPU accounting needs @c configGENERATE_RUN_TIME_STATS and
+ *       @c INCLUDE_xTaskGetIdleTaskHandle (both enabled in config/FreeRTOSConfig.h).
+ *       The run-time counter is 32 bits of microseconds, so the period must
+ *       be well below 71 minutes.
+ */
+
+#ifndef ENERGY_H
+#define ENERGY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* =========================
+ *  Configuration
+ * ========================= */
+#ifndef ENERGY_PRIORITY
+#define ENERGY_PRIORITY                 (tskIDLE_PRIORITY + 1)
+#endif
+#define ENERGY_REPORT_SIZE              768     // enough for ::energy_format_report
+
+/**
+ * @brief Components whose consumption is accounted.
+ */
+typedef enum {
+    ENERGY_CPU0 = 0,        ///< Core 0 (ON = running a task, IDLE = idle task / WFI)
+    ENERGY_CPU1,            ///< Core 1
+    ENERGY_IMU,             ///< ICM-42670 (LOW_POWER/ON level: 0 accel only, 255 accel + gyro)
+    ENERGY_HDC2021,         ///< HDC2021 (ON = auto-measure mode)
+    ENERGY_VEML6030,        ///< VEML6030 (ON = powered, OFF = shut down)
+    ENERGY_OLED,            ///< SSD1306 (ON level: contrast)
+    ENERGY_RGB,             ///< RGB LED (ON level: mean duty of the three channels)
+    ENERGY_BUZZER,          ///< Buzzer (ON level: duty)
+    ENERGY_MIC,             ///< PDM microphone (ON = clocked)
+    ENERGY_USB,             ///< USB device (ON = mounted, IDLE = suspended)
+    ENERGY_NUM_COMPONENTS
+} energy_component_t;
+
+/**
+ * @brief Power states. Not every component uses all of them.
+ */
+typedef enum {
+    ENERGY_OFF = 0,         ///< Powered down / shut down
+    ENERGY_IDLE,            ///< Powered, waiting (sleep, suspend, WFI)
+    ENERGY_LOW_POWER,       ///< Reduced performance mode (e.g. IMU LP)
+    ENERGY_ON,              ///< Fully active (e.g. IMU low-noise)
+    ENERGY_NUM_STATES
+} energy_state_t;
+
+/**
+ * @brief Current model of one component in one state.
+ */
+typedef struct {
+    uint32_t base_ua;       ///< Current at level 0 (uA)
+    uint32_t span_ua;       ///< Extra current at level 255 (uA)
+} energy_current_t;
+
+/**
+ * @brief Accumulated usage of a component.
+ */
+typedef struct {
+    energy_state_t state;                   ///< Current state
+    uint8_t level;                          ///< Current level
+    uint64_t time_us[ENERGY_NUM_STATES];    ///< Time spent in each state
+    uint64_t charge_nc;                     ///< Estimated charge drawn (nC = nA*s)
+} energy_usage_t;
+
+/**
+ * @brief Callback polled by the service task for components the SDK cannot observe.
+ *
+ * @param level Level to report (preset to the current one).
+ * @return Current state of the component.
+ */
+typedef energy_state_t (*energy_probe_t)(uint8_t *level);
+
+/**
+ * @brief Start the service task that samples the cores and polls the probes.
+ *
+ * @param period_ms How often CPU time is sampled and the probes are polled.
+ *
+ * @return 0 on success, negative value on error.
+ *
+ * @note Can be called before ::vTaskStartScheduler(). Peripheral states are
+ *       accounted from this call on, whether or not the service task runs;
+ *       states reported earlier are kept as the starting point.
+ */
+int energy_init(uint32_t period_ms);
+
+/**
+ * @brief Report a state change of a component.
+ *
+ * Called by the SDK; applications only need it for peripherals the SDK
+ * does not drive. Safe to call from both cores, from interrupts and before
+ * the scheduler starts (it takes a spin lock, not a FreeRTOS critical
+ * section). Until ::energy_init it only records the state. CPU components
+ * are sampled by the service task and ignore this call.
+ *
+ * @param c     Component.
+ * @param s     New state.
+ * @param level New level (0-255), meaning depends on the component.
+ */
+void energy_set_state(energy_component_t c, energy_state_t s, uint8_t level);
+
+/**
+ * @brief Change one entry of the current table.
+ *
+ * @return 0 on success, negative value if @p c or @p s is out of range.
+ */
+int energy_set_current(energy_component_t c, energy_state_t s, uint32_t base_ua, uint32_t span_ua);
+
+/**
+ * @brief Poll @p probe every period for the state of @p c. @c NULL removes it.
+ */
+void energy_set_probe(energy_component_t c, energy_probe_t probe);
+
+/**
+ * @brief Usage of a component up to now.
+ *
+ * @return 0 on success, negative value if @p c is out of range.
+ */
+int energy_get(energy_component_t c, energy_usage_t *out);
+
+/**
+ * @brief Clear the accumulated times and charges (states are kept).
+ */
+void energy_reset(void);
+
+/**
+ * @brief Write a text report into @p buf.
+ *
+ * One line per component with its state, share of time in each state,
+ * average current and charge, plus the total. Suitable for
+ * ::usb_serial_print() or printf().
+ *
+ * @return Number of characters written (excluding the terminator).
+ */
+int energy_format_report(char *buf, size_t len);
+
+#endif /* ENERGY_H */
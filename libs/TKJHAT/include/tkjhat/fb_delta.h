@@ -0,0 +1,159 @@
+/*
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 , Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+
+/**
+ * @file tkjhat/fb_delta.h
+ * @brief Delta codec and record format for mirroring the OLED framebuffer.
+ *
+ * @details
+ * A frame is encoded as the difference against the previous one, as a list
+ * of operations over the framebuffer bytes:
+ *
+ * | Opcode      | Followed by | Meaning                                  |
+ * |-------------|-------------|------------------------------------------|
+ * | 0nnnnnnn    | -           | skip n+1 unchanged bytes (1..128)        |
+ * | 10nnnnnn    | n+1 bytes   | XOR the next n+1 bytes with these (1..64)|
+ * | 11nnnnnn    | 1 byte v    | set the next n+1 bytes to v (1..64)      |
+ *
+ * Bytes after the last operation are unchanged. A keyframe is the same
+ * encoding against an all-zero framebuffer.
+ *
+ * On the wire every frame is a record:
+ *
+ * | Field     | Size | Notes                                      |
+ * |-----------|------|--------------------------------------------|
+ * | magic     | 2    | 'F' 'M'                                    |
+ * | flags     | 1    | bit 0: keyframe                            |
+ * | width     | 1    | pixels                                     |
+ * | height    | 1    | pixels                                     |
+ * | seq       | 2    | frame counter (little endian, all LE below)|
+ * | time_us   | 4    | device time of the ssd1306_show() call     |
+ * | ops_len   | 2    | length of the operations                   |
+ * | ops       | n    |                                            |
+ * | crc       | 2    | CRC-16/CCITT of flags..ops                 |
+ *
+ * Portable C (no Pico dependencies): the host tool uses the same code.
+ */
+
+#ifndef FB_DELTA_H
+#define FB_DELTA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FB_DELTA_MAX_FB                         1024    // 128 x 64 / 8
+#define FB_DELTA_MAX_OPS                        (FB_DELTA_MAX_FB + FB_DELTA_MAX_FB / 64 + 2)
+#define FB_MIRROR_MAGIC0                        'F'
+#define FB_MIRROR_MAGIC1                        'M'
+#define FB_MIRROR_HEADER_SIZE                   13
+#define FB_MIRROR_OVERHEAD                      (FB_MIRROR_HEADER_SIZE + 2)
+#define FB_MIRROR_FLAG_KEYFRAME                 0x01
+
+/**
+ * @brief Header of a mirrored frame.
+ */
+typedef struct {
+    uint8_t  flags;
+    uint8_t  width;
+    uint8_t  height;
+    uint16_t seq;
+    uint32_t time_us;
+    uint16_t ops_len;
+} fb_mirror_header_t;
+
+/**
+ * @brief Streaming parser for records (host side).
+ */
+typedef struct {
+    fb_mirror_header_t header;          ///< Valid after ::fb_mirror_parse_byte returns 1
+    uint8_t  ops[FB_DELTA_MAX_OPS];     ///< Valid after ::fb_mirror_parse_byte returns 1
+    uint32_t records;
+    uint32_t crc_errors;
+    uint32_t resync_bytes;
+    // Internal
+    uint8_t  raw[FB_MIRROR_HEADER_SIZE];
+    uint16_t index;
+    uint8_t  state;
+    uint16_t crc;
+    uint16_t rx_crc;
+} fb_mirror_parser_t;
+
+/**
+ * @brief Encode @p cur as a delta against @p prev.
+ *
+ * @param prev Previous frame, or @c NULL for a keyframe.
+ * @param cur  Current frame.
+ * @param size Framebuffer size in bytes (<= ::FB_DELTA_MAX_FB).
+ * @param out  Destination, at least ::FB_DELTA_MAX_OPS bytes.
+ *
+ * @return Length of the operations, 0 if nothing changed.
+ */
+size_t fb_delta_encode(const uint8_t *prev, const uint8_t *cur, size_t size, uint8_t *out);
+
+/**
+ * @brief Apply operations to @p fb.
+ *
+ * @return 0 on success, negative value if the operations are malformed or
+ *         run past @p size.
+ */
+int fb_delta_apply(uint8_t *fb, size_t size, const uint8_t *ops, size_t len);
+
+/**
+ * @brief Write the header and CRC around operations already stored in @p out.
+ *
+ * The caller encodes the operations at @p out + ::FB_MIRROR_HEADER_SIZE
+ * (so no copy is needed); this fills in the header and appends the CRC.
+ *
+ * @return Total record size (::FB_MIRROR_OVERHEAD + ops_len).
+ */
+size_t fb_mirror_finish_record(uint8_t *out, const fb_mirror_header_t *header);
+
+/**
+ * @brief Reset a parser.
+ */
+void fb_mirror_parser_init(fb_mirror_parser_t *p);
+
+/**
+ * @brief Feed one byte of the stream.
+ *
+ * @return 1 when a complete record is available in @c header / @c ops,
+ *         -1 when a record was dropped (bad CRC or length), 0 otherwise.
+ */
+int fb_mirror_parse_byte(fb_mirror_parser_t *p, uint8_t byte);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FB_DELTA_H */
@@ -0,0 +1,173 @@
+/*
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 , Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+
+/**
+ * @file tkjhat/gpio_irq.h
+ * @brief Per-pin GPIO interrupt dispatch shared by the SDK and the application.
+ *
+ * @details
+ * The Pico SDK has a single GPIO callback per core
+ * (@c gpio_set_irq_enabled_with_callback), so every handler has to branch on
+ * the pin and a driver that needs an interrupt (ICM42670_INT, VEML6030_INTERRUPT,
+ * HDC2021_INTERRUPT) would replace the application's callback. This module owns
+ * that callback and dispatches each edge to the handler registered for its pin.
+ *
+ * A handler runs either directly in the interrupt or, when registered as
+ * @e deferred, in a dispatcher task (a queue of events drained by one task at
+ * ::GPIO_IRQ_TASK_PRIORITY), where it may block, print or take mutexes.
+ *
+ * Each event carries the time of the edge, taken on interrupt entry, so
+ * deferred handlers still see when the edge happened. Per pin the module
+ * counts the edges, the deferred events dropped because the queue was full,
+ * and the handler execution time and dispatch latency.
+ *
+ * ### Typical usage
+ * @code
+ * static void button1_pressed(const gpio_irq_event_t *ev, void *ctx) {
+ *     // runs in the interrupt
+ * }
+ *
+ * static void imu_data_ready(const gpio_irq_event_t *ev, void *ctx) {
+ *     // runs in the dispatcher task: may use I2C and block
+ * }
+ *
+ * gpio_irq_register(BUTTON1, GPIO_IRQ_EDGE_FALL, button1_pressed, NULL, false);
+ * gpio_irq_register(ICM42670_INT, GPIO_IRQ_EDGE_FALL, imu_data_ready, NULL, true);
+ * @endcode
+ *
+ * @warning Do not call @c gpio_set_irq_enabled_with_callback or
+ *          @c gpio_set_irq_callback once a handler is registered: they replace
+ *          the dispatcher. Register every pin through this module instead.
+ */
+
+#ifndef GPIO_IRQ_H
+#define GPIO_IRQ_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "pico/stdlib.h"
+
+/* =========================
+ *  Configuration
+ * ========================= */
+#ifndef GPIO_IRQ_NUM_PINS
+#define GPIO_IRQ_NUM_PINS               30      // bank 0 GPIOs of the RP2040
+#endif
+#ifndef GPIO_IRQ_QUEUE_LEN
+#define GPIO_IRQ_QUEUE_LEN              16      // deferred events waiting for the dispatcher
+#endif
+#ifndef GPIO_IRQ_TASK_PRIORITY
+#define GPIO_IRQ_TASK_PRIORITY          (configMAX_PRIORITIES - 1)
+#endif
+#ifndef GPIO_IRQ_TASK_STACK
+#define GPIO_IRQ_TASK_STACK             1024    // words; deferred handlers run on it
+#endif
+
+/**
+ * @brief One GPIO interrupt.
+ */
+typedef struct {
+    uint8_t  gpio;                  ///< Pin
+    uint32_t events;                ///< GPIO_IRQ_EDGE_RISE / _FALL / LEVEL_* bits
+    uint64_t timestamp_us;          ///< Time of the interrupt (time_us_64)
+} gpio_irq_event_t;
+
+/**
+ * @brief Handler of a pin.
+ *
+ * @param ev  The interrupt.
+ * @param ctx Pointer given at registration.
+ */
+typedef void (*gpio_irq_handler_t)(const gpio_irq_event_t *ev, void *ctx);
+
+/**
+ * @brief Counters of a pin.
+ */
+typedef struct {
+    uint32_t count;                 ///< Interrupts seen
+    uint32_t dropped;               ///< Deferred events lost because the queue was full
+    uint32_t last_events;           ///< Events of the last interrupt
+    uint64_t last_edge_us;          ///< Time of the last interrupt
+    uint32_t handler_max_us;        ///< Longest handler execution
+    uint64_t handler_total_us;      ///< Sum of the handler executions
+    uint32_t handled;               ///< Handler executions
+    uint32_t latency_max_us;        ///< Longest edge-to-handler delay (deferred handlers)
+} gpio_irq_stats_t;
+
+/**
+ * @brief Register the handler of a pin and enable its interrupt.
+ *
+ * Replaces the previous handler of the pin, if any. The interrupt is enabled
+ * on the calling core.
+ *
+ * @param gpio       Pin (0 - ::GPIO_IRQ_NUM_PINS-1).
+ * @param event_mask Events to enable (e.g. @c GPIO_IRQ_EDGE_FALL).
+ * @param handler    Handler.
+ * @param ctx        Passed to the handler.
+ * @param deferred   @c true to run the handler in the dispatcher task instead
+ *                   of the interrupt.
+ *
+ * @return 0 on success, negative value on error.
+ */
+int gpio_irq_register(uint gpio, uint32_t event_mask, gpio_irq_handler_t handler, void *ctx, bool deferred);
+
+/**
+ * @brief Disable the interrupt of a pin and remove its handler.
+ *
+ * @return 0 on success, negative value if @p gpio is out of range.
+ */
+int gpio_irq_unregister(uint gpio);
+
+/**
+ * @brief Counters of a pin.
+ *
+ * @return 0 on success, negative value if @p gpio is out of range.
+ */
+int gpio_irq_get_stats(uint gpio, gpio_irq_stats_t *out);
+
+/**
+ * @brief Clear the counters of every pin.
+ */
+void gpio_irq_reset_stats(void);
+
+/**
+ * @brief Write a short text report into @p buf.
+ *
+ * One line per registered pin. Suitable for ::usb_serial_print() or printf().
+ *
+ * @return Number of characters written (excluding the terminator).
+ */
+int gpio_irq_format_report(char *buf, size_t len);
+
+#endif /* GPIO_IRQ_H */
@@ -0,0 +1,126 @@
+/*
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 , Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+/**
+ * @file tkjhat/hat_snapshot.h
+ * @brief One-call snapshot of all the HAT sensors with burst I2C reads.
+ *
+ * @details
+ * Reading every sensor through the per-device calls costs one register
+ * select + read per value and a float conversion each. ::hat_snapshot_read
+ * reads each device once, with a single write-register / repeated-start /
+ * read transaction, and converts the raw values with integer arithmetic:
+ *
+ * | Device   | Registers             | Bytes | Per-call APIs                      |
+ * |----------|-----------------------|-------|------------------------------------|
+ * | VEML6030 | ALS (0x04)            | 2     | ::veml6030_read_light (same)       |
+ * | HDC2021  | 0x00..0x03 auto-inc.  | 4     | temperature + humidity, 2 reads    |
+ * | ICM42670 | 0x09..0x16 auto-inc.  | 14    | ::ICM42670_read_sensor_data (same) |
+ *
+ * The VEML6030 has 16-bit command codes without auto-increment, so the ALS
+ * register stays its own transaction. All values share one timestamp taken
+ * in the middle of the bus transfers.
+ *
+ * The IMU scale comes from the accel/gyro full-scale range registers, read by
+ * ::hat_snapshot_init. Call it again after changing the range with
+ * ::ICM42670_startAccel or ::ICM42670_startGyro.
+ *
+ * ### Typical usage
+ * @code
+ * init_hat_sdk();
+ * init_veml6030();
+ * init_hdc2021_();
+ * init_ICM42670();
+ * ICM42670_start_with_default_values();
+ * hat_snapshot_init();
+ *
+ * hat_snapshot_t s;
+ * if (hat_snapshot_read(&s, HAT_SNAPSHOT_ALL) == 0) {
+ *     printf("%lu lx %d.%02d C\n", s.lux, s.temp_c100 / 100, abs(s.temp_c100 % 100));
+ * }
+ * @endcode
+ *
+ * @note Uses @c i2c_default like the rest of the SDK, so do not call it while
+ *       another task talks to the same bus.
+ */
+
+#ifndef HAT_SNAPSHOT_H
+#define HAT_SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* =========================
+ *  Devices
+ * ========================= */
+#define HAT_SNAPSHOT_LIGHT                      (1u << 0)   ///< VEML6030
+#define HAT_SNAPSHOT_TEMP_HUMIDITY              (1u << 1)   ///< HDC2021
+#define HAT_SNAPSHOT_IMU                        (1u << 2)   ///< ICM42670
+#define HAT_SNAPSHOT_ALL                        (HAT_SNAPSHOT_LIGHT | HAT_SNAPSHOT_TEMP_HUMIDITY | HAT_SNAPSHOT_IMU)
+
+/**
+ * @brief All sensor values at one instant, in integer units.
+ */
+typedef struct {
+    uint64_t timestamp_us;      ///< Middle of the bus transfers (time_us_64)
+    uint32_t bus_us;            ///< Time spent on the bus by this snapshot
+    uint8_t  valid;             ///< HAT_SNAPSHOT_* bits of the devices read successfully
+
+    uint32_t lux;               ///< Ambient light, lux (as ::veml6030_read_light)
+    int16_t  temp_c100;         ///< HDC2021 temperature, 0.01 degC
+    uint16_t humidity_p100;     ///< HDC2021 relative humidity, 0.01 %
+    int16_t  imu_temp_c100;     ///< ICM42670 die temperature, 0.01 degC
+    int32_t  accel_mg[3];       ///< Acceleration x, y, z in milli-g
+    int32_t  gyro_mdps[3];      ///< Angular rate x, y, z in milli-degrees per second
+} hat_snapshot_t;
+
+/**
+ * @brief Read the IMU full-scale ranges used to scale the samples.
+ *
+ * @return 0 on success, negative value if the IMU did not answer.
+ */
+int hat_snapshot_init(void);
+
+/**
+ * @brief Read the selected devices into @p out.
+ *
+ * @param out     Destination. Fields of devices not read are left at 0.
+ * @param devices HAT_SNAPSHOT_* bits, usually ::HAT_SNAPSHOT_ALL.
+ *
+ * @return 0 if every selected device answered, -1 on invalid arguments,
+ *         -2 if some device failed (see @c out->valid).
+ */
+int hat_snapshot_read(hat_snapshot_t *out, uint32_t devices);
+
+/**
+ * @brief VEML6030 ALS count to lux with the datasheet non-linearity
+ *        correction above 1000, in integer arithmetic.
+ */
+uint32_t hat_snapshot_veml_lux(uint16_t raw);
+
+#endif /* HAT_SNAPSHOT_H */
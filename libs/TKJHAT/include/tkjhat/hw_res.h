@@ -0,0 +1,240 @@
+/*
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 , Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+
+
+/**
+ * @file tkjhat/hw_res.h
+ * @brief DMA channel, DMA timer, PIO and IRQ line allocation by named owner, with DMA utilization.
+ *
+ * @details
+ * The TKJHAT drivers share a small set of engines: 12 DMA channels, 4 DMA
+ * pacing timers, 2 PIO blocks of 4 state machines and 32 instructions each,
+ * and the DMA / PIO interrupt lines. This module hands them out on top of the
+ * SDK claim functions (so code that claims directly from the SDK, like the
+ * CYW43 driver, still coexists) and remembers who owns what:
+ *
+ * - ::hw_res_pio_claim() finds a PIO block with a free state machine *and*
+ *   room for the program, and loads a program only once per block when
+ *   several owners run the same one.
+ * - The IRQ helpers refuse, with ::HW_RES_ERR_CONFLICT, an exclusive handler
+ *   on a line that already has one and a shared handler on a line owned
+ *   exclusively, where the SDK would panic.
+ * - Owners report the bytes their channels moved with ::hw_res_dma_note().
+ *   ::hw_res_monitor_start() samples the busy flag of every channel, so the
+ *   report shows bytes/s and busy time per channel and the total DMA
+ *   bandwidth against the bus peak.
+ *
+ * ### Typical usage
+ * @code
+ * int ch = hw_res_dma_claim("display");
+ * if (ch < 0) return ch;
+ * hw_res_irq_add_shared("display", DMA_IRQ_1, display_dma_irq);
+ * // ... in the completion interrupt:
+ * hw_res_dma_note(ch, 1024);
+ *
+ * hw_res_monitor_start(250);                   // sample busy flags every 250 us
+ * hw_res_format_report(text, sizeof(text));    // then usb_serial_print(text)
+ * @endcode
+ *
+ * @note Busy time is sampled: a channel waiting on its DREQ (e.g. paced by a
+ *       PIO FIFO) counts as busy for its whole transfer. The bytes column
+ *       shows how much actually moved.
+ */
+
+#ifndef TKJHAT_HW_RES_H
+#define TKJHAT_HW_RES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/pio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* =========================
+ *  Configuration
+ * ========================= */
+#define HW_RES_OWNER_LEN                12
+#ifndef HW_RES_MAX_PROGRAMS
+#define HW_RES_MAX_PROGRAMS             8   // programs loaded through the manager
+#endif
+#ifndef HW_RES_MAX_IRQ_HANDLERS
+#define HW_RES_MAX_IRQ_HANDLERS         8   // handlers installed through the manager
+#endif
+
+/* =========================
+ *  Errors
+ * ========================= */
+#define HW_RES_ERR_BUSY                 (-1)    ///< Nothing free of that kind
+#define HW_RES_ERR_CONFLICT             (-2)    ///< IRQ line taken in an incompatible way
+#define HW_RES_ERR_ARG                  (-3)    ///< Bad argument
+#define HW_RES_ERR_FULL                 (-4)    ///< Bookkeeping table full
+
+/**
+ * @brief A state machine with its program loaded.
+ */
+typedef struct {
+    PIO pio;                        ///< pio0 or pio1
+    uint sm;                        ///< State machine
+    uint offset;                    ///< Program start in instruction memory
+    const pio_program_t *program;   ///< Program loaded
+} hw_res_pio_t;
+
+/**
+ * @brief Counters of one DMA channel since it was claimed.
+ */
+typedef struct {
+    char     owner[HW_RES_OWNER_LEN];   ///< Owner, "(sdk)" if claimed outside the manager, "" if free
+    uint64_t bytes;                     ///< Bytes reported with ::hw_res_dma_note
+    uint32_t transfers;                 ///< Calls to ::hw_res_dma_note
+    uint32_t busy_samples;              ///< Samples that found the channel busy
+    uint32_t samples;                   ///< Samples taken while claimed
+} hw_res_dma_stats_t;
+
+/* =========================
+ *  DMA
+ * ========================= */
+
+/**
+ * @brief Claim a free DMA channel for @p owner.
+ * @return Channel number, or ::HW_RES_ERR_BUSY.
+ */
+int hw_res_dma_claim(const char *owner);
+
+/**
+ * @brief Release a channel claimed with ::hw_res_dma_claim. The channel must be idle.
+ */
+void hw_res_dma_release(int channel);
+
+/**
+ * @brief Claim a free DMA pacing timer for @p owner.
+ * @return Timer number, or ::HW_RES_ERR_BUSY.
+ */
+int hw_res_dma_timer_claim(const char *owner);
+
+/**
+ * @brief Release a timer claimed with ::hw_res_dma_timer_claim.
+ */
+void hw_res_dma_timer_release(int timer);
+
+/**
+ * @brief Report @p bytes moved by @p channel. Safe from interrupts.
+ */
+void hw_res_dma_note(int channel, uint32_t bytes);
+
+/**
+ * @brief Counters of @p channel since it was claimed.
+ */
+void hw_res_get_dma_stats(uint channel, hw_res_dma_stats_t *out);
+
+/* =========================
+ *  PIO
+ * ========================= */
+
+/**
+ * @brief Claim a state machine and load @p program next to it.
+ *
+ * @param owner   Owner name.
+ * @param program Program the state machine runs. Shared with other owners
+ *                that already loaded it in the same block.
+ * @param pio     Block to use, or @c NULL for the first one with room.
+ * @param out     The claimed state machine.
+ *
+ * @return 0, ::HW_RES_ERR_BUSY when no block has both a free state machine
+ *         and room for the program, ::HW_RES_ERR_FULL or ::HW_RES_ERR_ARG.
+ */
+int hw_res_pio_claim(const char *owner, const pio_program_t *program, PIO pio, hw_res_pio_t *out);
+
+/**
+ * @brief Release the state machine, and the program once no owner runs it.
+ *
+ * The state machine must be stopped.
+ */
+void hw_res_pio_release(hw_res_pio_t *res);
+
+/* =========================
+ *  IRQ lines
+ * ========================= */
+
+/**
+ * @brief Install @p handler as the only handler of @p irq.
+ *
+ * Installing the same handler again is allowed.
+ *
+ * @return 0 or ::HW_RES_ERR_CONFLICT if the line already has another handler.
+ */
+int hw_res_irq_set_exclusive(const char *owner, uint irq, irq_handler_t handler);
+
+/**
+ * @brief Add @p handler to the handlers of @p irq.
+ *
+ * @return 0 or ::HW_RES_ERR_CONFLICT if the line has an exclusive handler.
+ */
+int hw_res_irq_add_shared(const char *owner, uint irq, irq_handler_t handler);
+
+/**
+ * @brief Remove a handler installed with one of the functions above.
+ */
+void hw_res_irq_remove(uint irq, irq_handler_t handler);
+
+/* =========================
+ *  Utilization
+ * ========================= */
+
+/**
+ * @brief Sample the busy flag of every DMA channel every @p sample_us (timer interrupt).
+ *
+ * @return 0, or ::HW_RES_ERR_BUSY when no timer is available.
+ */
+int hw_res_monitor_start(uint32_t sample_us);
+
+/**
+ * @brief Stop sampling.
+ */
+void hw_res_monitor_stop(void);
+
+/**
+ * @brief Write the owner map and the DMA utilization since the previous call into @p buf.
+ *
+ * Suitable for ::usb_serial_print() or printf().
+ *
+ * @return Number of characters written (excluding the terminator).
+ */
+int hw_res_format_report(char *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TKJHAT_HW_RES_H */
@@ -0,0 +1,200 @@
+/*
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 , Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file tkjhat/kll.h
+ * @brief Fixed-memory streaming quantile sketch (KLL).
+ *
+ * @details
+ * Keeps an approximation of the distribution of an unbounded stream of
+ * @c float values (temperature, lux, vibration RMS, timings...) in a fixed
+ * ::kll_sketch_t, and answers "what is the p-th percentile" and "what
+ * fraction of the values is below x" with a bounded error in *rank*: a p99
+ * query returns a value whose true rank is within about ±::KLL_RANK_ERROR_PCT
+ * percentage points of 99 %, whatever the number of values or their range.
+ *
+ * The sketch is the KLL compactor hierarchy of Karnin, Lang and Liberty: level
+ * h keeps items of weight 2^h. When the buffer is full the lowest level over
+ * its capacity is sorted and every other item (chosen at random) is promoted
+ * to the level above, with double weight. The capacity of level h shrinks
+ * geometrically (by 2/3) from ::KLL_K at the top level down to ::KLL_MIN_CAPACITY.
+ *
+ * - ::kll_update is O(1) amortized: most updates just store the value, a
+ *   compaction (a sort of at most ::KLL_K items) happens every few updates.
+ * - All memory is inside ::kll_sketch_t (::KLL_MAX_ITEMS floats), nothing is
+ *   allocated.
+ * - Sketches merge (::kll_merge) without losing the error guarantee, so
+ *   per-interval sketches sent as telemetry (::kll_serialize) can be combined
+ *   on the host.
+ *
+ * ### Typical usage
+ * @code
+ * static kll_sketch_t temp_dist;
+ *
+ * kll_init(&temp_dist, 1);
+ * for (;;) {
+ *     float t;
+ *     read_hdc2021_temperature(&t);
+ *     kll_update(&temp_dist, t);
+ *     // ...
+ * }
+ * float median = kll_quantile(&temp_dist, 0.5f);
+ * float p99    = kll_quantile(&temp_dist, 0.99f);
+ * @endcode
+ *
+ * Not thread safe: protect a sketch shared between tasks yourself.
+ *
+ * Portable C (no Pico dependencies), so it can also be compiled on a PC
+ * by the host tools.
+ */
+
+#ifndef TKJHAT_KLL_H
+#define TKJHAT_KLL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* =========================
+ *  Configuration
+ * ========================= */
+#ifndef KLL_K
+#define KLL_K                                   100 // top level capacity, sets the accuracy
+#endif
+#define KLL_MIN_CAPACITY                        8   // smallest level capacity
+#define KLL_MAX_LEVELS                          30  // enough for ~KLL_K * 2^29 values
+#define KLL_RANK_ERROR_PCT                      2.7f // typical worst rank error for KLL_K = 100
+#define KLL_SERIAL_VERSION                      1
+
+/** @brief Upper bound of the items kept by a sketch with ::KLL_MAX_LEVELS levels. */
+#define KLL_MAX_ITEMS                           (3 * KLL_K + KLL_MIN_CAPACITY * KLL_MAX_LEVELS)
+
+/** @brief Worst case size of ::kll_serialize output. */
+#define KLL_SERIAL_MAX                          (22 + 2 * KLL_MAX_LEVELS + 4 * KLL_MAX_ITEMS)
+
+/**
+ * @brief Sketch state. Treat as opaque.
+ */
+typedef struct {
+    uint64_t n;                             ///< Values added
+    float    min;                           ///< Smallest value
+    float    max;                           ///< Largest value
+    uint32_t rng;                           ///< Random state for the compactions
+    uint8_t  num_levels;                    ///< Levels in use
+    uint16_t levels[KLL_MAX_LEVELS + 1];    ///< Start of each level in @c items
+    float    items[KLL_MAX_ITEMS];          ///< Level 0 (unsorted) .. top level (each sorted)
+} kll_sketch_t;
+
+/**
+ * @brief Clear a sketch.
+ *
+ * @param s    Sketch.
+ * @param seed Seed for the random compactions (any non-zero value). Sketches
+ *             that will be merged should use different seeds.
+ */
+void kll_init(kll_sketch_t *s, uint32_t seed);
+
+/**
+ * @brief Add one value. O(1) amortized.
+ *
+ * @return 0 on success, negative value if the sketch already holds the
+ *         largest stream it can describe (~::KLL_K * 2^29 values) or @p value is NaN.
+ */
+int kll_update(kll_sketch_t *s, float value);
+
+/**
+ * @brief Add every value summarized by @p src to @p dst.
+ *
+ * @return 0 on success, negative value if @p dst would grow past ::KLL_MAX_LEVELS.
+ */
+int kll_merge(kll_sketch_t *dst, const kll_sketch_t *src);
+
+/**
+ * @brief Number of values added.
+ */
+static inline uint64_t kll_count(const kll_sketch_t *s) {
+    return s->n;
+}
+
+/**
+ * @brief Items currently kept (at most ::KLL_MAX_ITEMS).
+ */
+static inline unsigned kll_retained(const kll_sketch_t *s) {
+    return (unsigned)(s->levels[s->num_levels] - s->levels[0]);
+}
+
+/**
+ * @brief Estimate of the @p q quantile.
+ *
+ * Sorts level 0 in place, which does not change what the sketch describes.
+ *
+ * @param s Sketch.
+ * @param q Quantile in [0, 1]. 0 and 1 return the exact min and max.
+ * @return The value, or 0 if the sketch is empty.
+ */
+float kll_quantile(kll_sketch_t *s, float q);
+
+/**
+ * @brief Estimated fraction of the values that are <= @p value.
+ */
+float kll_rank(const kll_sketch_t *s, float value);
+
+/**
+ * @brief Bytes ::kll_serialize needs for @p s.
+ */
+size_t kll_serialized_size(const kll_sketch_t *s);
+
+/**
+ * @brief Write a byte order independent copy of @p s.
+ *
+ * Only the kept items are written: about 4 bytes per item plus a small header.
+ *
+ * @return Bytes written, or negative value if @p len is too small.
+ */
+int kll_serialize(const kll_sketch_t *s, uint8_t *buf, size_t len);
+
+/**
+ * @brief Read a sketch written by ::kll_serialize.
+ *
+ * The writer must use the same ::KLL_K.
+ *
+ * @param s    Destination.
+ * @param buf  Serialized sketch.
+ * @param len  Bytes available.
+ * @param seed Seed for the compactions of @p s from now on.
+ * @return Bytes consumed, or negative value if the data is malformed or was
+ *         written with another ::KLL_K.
+ */
+int kll_deserialize(kll_sketch_t *s, const uint8_t *buf, size_t len, uint32_t seed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TKJHAT_KLL_H */
@@ -0,0 +1,220 @@
+/*
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 , Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+/**
+ * @file tkjhat/led_link.h
+ * @brief Frame coding and receiver for the optical RGB LED link.
+ *
+ * @details
+ * One LED channel is switched on and off at a fixed chip rate. Each frame is:
+ *
+ * | Field    | Size | Notes                                          |
+ * |----------|------|------------------------------------------------|
+ * | preamble | 2    | 0xAA 0xAA, gives the receiver edges to lock to |
+ * | sync     | 2    | 0xD3 0x91                                      |
+ * | len      | 1    | Payload length, 0..::LED_LINK_MAX_PAYLOAD      |
+ * | payload  | len  |                                                |
+ * | crc      | 2    | CRC-16/CCITT of len..payload, little endian    |
+ *
+ * Bytes are sent MSB first with one of two line codes:
+ *
+ * - ::LED_LINK_OOK: on-off keying, one chip per bit (1 = LED on).
+ * - ::LED_LINK_MANCHESTER: two chips per bit, 1 = off→on and 0 = on→off
+ *   (IEEE 802.3). Twice the chips, but there is an edge in every bit and the
+ *   average brightness does not depend on the data.
+ *
+ * ::led_link_encode turns a payload into the chip words the transmitter
+ * shifts out (first chip in bit 31). The LED is left off after the frame.
+ *
+ * The receiver takes intensity samples of a photodiode or light sensor at
+ * a few samples per chip and smooths them over half a chip. It follows the
+ * on and off levels to set the slicing threshold, so ambient light and lamp
+ * flicker are removed. A software PLL places the threshold crossings at the
+ * chip boundaries and each chip is decided in its middle. The sync word is
+ * searched chip by chip, then bytes are collected until the CRC.
+ *
+ * host/bench/bench_led_link runs the encoder and the receiver through a
+ * modeled channel (LED rise time, flicker, noise, clock offset).
+ *
+ * Portable C (no Pico dependencies), so the host tools use the same code.
+ */
+
+#ifndef TKJHAT_LED_LINK_H
+#define TKJHAT_LED_LINK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* =========================
+ *  Configuration
+ * ========================= */
+#define LED_LINK_PREAMBLE                       0xAA
+#define LED_LINK_PREAMBLE_BYTES                 2
+#define LED_LINK_SYNC0                          0xD3
+#define LED_LINK_SYNC1                          0x91
+#ifndef LED_LINK_MAX_PAYLOAD
+#define LED_LINK_MAX_PAYLOAD                    64
+#endif
+#define LED_LINK_OVERHEAD                       7   // preamble(2) + sync(2) + len + crc(2)
+#define LED_LINK_TAIL_CHIPS                     8   // LED off after the frame
+#define LED_LINK_RX_BOX_MAX                     8   // receiver smoothing, samples
+
+/** Chips in a frame with @p len payload bytes, tail included. */
+#define LED_LINK_FRAME_CHIPS(coding, len) \
+    (((len) + LED_LINK_OVERHEAD) * 8u * ((coding) == LED_LINK_MANCHESTER ? 2u : 1u) + LED_LINK_TAIL_CHIPS)
+/** 32-bit chip words needed by ::led_link_encode for @p len payload bytes. */
+#define LED_LINK_FRAME_WORDS(coding, len)       ((LED_LINK_FRAME_CHIPS(coding, len) + 31u) / 32u)
+/** Chip words for the largest frame. */
+#define LED_LINK_MAX_WORDS                      LED_LINK_FRAME_WORDS(LED_LINK_MANCHESTER, LED_LINK_MAX_PAYLOAD)
+
+/**
+ * @brief Line code.
+ */
+typedef enum {
+    LED_LINK_OOK = 0,           ///< One chip per bit, 1 = on
+    LED_LINK_MANCHESTER = 1,    ///< Two chips per bit, 1 = off->on, 0 = on->off
+} led_link_coding_t;
+
+/* =========================
+ *  Transmitter side
+ * ========================= */
+
+/**
+ * @brief Encode a frame into chip words.
+ *
+ * @param coding  Line code.
+ * @param payload Payload bytes (may be @c NULL if @p len is 0).
+ * @param len     Payload length, at most ::LED_LINK_MAX_PAYLOAD.
+ * @param words   Output, first chip in bit 31 of words[0]. Unused chips of
+ *                the last word are 0 (LED off).
+ * @param max_words Capacity of @p words, see ::LED_LINK_FRAME_WORDS.
+ *
+ * @return Number of words written, 0 on error.
+ */
+size_t led_link_encode(led_link_coding_t coding, const void *payload, size_t len,
+                       uint32_t *words, size_t max_words);
+
+/* =========================
+ *  Receiver side
+ * ========================= */
+
+/**
+ * @brief Called by the receiver for every frame with a good CRC.
+ */
+typedef void (*led_link_rx_handler_t)(const uint8_t *payload, size_t len, void *ctx);
+
+/**
+ * @brief Receiver counters.
+ */
+typedef struct {
+    uint32_t frames;        ///< Frames delivered to the handler
+    uint32_t crc_errors;    ///< Frames dropped because of the CRC
+    uint32_t code_errors;   ///< Frames dropped because of a Manchester code violation
+    uint32_t len_errors;    ///< Frames dropped because the length was too large
+    uint32_t resyncs;       ///< Edges that moved the chip clock
+} led_link_rx_stats_t;
+
+/**
+ * @brief Receiver state. Treat as opaque.
+ */
+typedef struct {
+    led_link_coding_t coding;
+    led_link_rx_handler_t handler;
+    void *ctx;
+
+    // slicer
+    int32_t hi, lo;         // envelope, Q4
+    int32_t min_swing;      // Q4
+    uint8_t env_shift;
+    uint8_t level;
+    int32_t prev_x;         // Q4
+    uint16_t box[LED_LINK_RX_BOX_MAX];
+    int32_t box_sum;
+    uint8_t box_len, box_pos;
+
+    // chip clock, Q8 samples
+    int32_t chip_q8;
+    int32_t phase_q8;
+    uint8_t decided;
+
+    // framing
+    uint64_t chips;
+    uint64_t sync_chips;
+    uint64_t sync_mask;
+    uint8_t  state;
+    uint8_t  half;          // Manchester: first chip of the pair
+    uint8_t  nhalf;
+    uint8_t  nbits;
+    uint8_t  cur;
+    uint16_t nbytes;
+    uint16_t need;
+    uint8_t  buf[LED_LINK_MAX_PAYLOAD + 3];
+
+    led_link_rx_stats_t stats;
+} led_link_rx_t;
+
+/**
+ * @brief Initialize a receiver.
+ *
+ * @param rx               Receiver state.
+ * @param coding           Line code of the transmitter.
+ * @param samples_per_chip Nominal sampling rate divided by the chip rate.
+ *                         At least 3, 4..8 is a good range.
+ * @param min_swing        Smallest on/off difference in sample units treated
+ *                         as a signal. Below it the slicer outputs "off".
+ * @param handler          Called for every good frame (may be @c NULL).
+ * @param ctx              Passed to @p handler.
+ *
+ * @return 0 on success, negative value on invalid arguments.
+ */
+int led_link_rx_init(led_link_rx_t *rx, led_link_coding_t coding, float samples_per_chip,
+                     uint16_t min_swing, led_link_rx_handler_t handler, void *ctx);
+
+/**
+ * @brief Feed intensity samples (larger = brighter).
+ *
+ * @return Number of frames delivered during this call.
+ */
+int led_link_rx_push(led_link_rx_t *rx, const uint16_t *samples, size_t n);
+
+/**
+ * @brief Receiver counters.
+ */
+static inline const led_link_rx_stats_t *led_link_rx_stats(const led_link_rx_t *rx) {
+    return &rx->stats;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TKJHAT_LED_LINK_H */
@@ -0,0 +1,114 @@
+/*
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 , Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+/**
+ * @file tkjhat/led_tx.h
+ * @brief Optical data transmitter on one RGB LED channel.
+ *
+ * @details
+ * Sends ::led_link_encode frames by switching one channel of the RGB LED at a
+ * fixed chip rate. A PIO state machine shifts the chips out, 16 PIO cycles
+ * per chip, so the timing does not depend on the CPU or on FreeRTOS. A DMA
+ * channel feeds it the chip words, so the CPU only encodes the frame.
+ * A second board (or a PC with a photodiode) decodes with the receiver in
+ * tkjhat/led_link.h.
+ *
+ * The LED is common anode (active low). The pin output is inverted in the
+ * GPIO, so a 1 chip turns the LED on.
+ *
+ * ### Typical usage
+ * @code
+ * led_tx_init(RGB_LED_G, 2000, LED_LINK_MANCHESTER);  // 2 kbit/s on green
+ * const char msg[] = "hello";
+ * led_tx_send(msg, sizeof msg - 1);
+ * while (led_tx_busy()) vTaskDelay(1);
+ * led_tx_deinit();                                    // back to rgb_led_write()
+ * @endcode
+ *
+ * @note While the transmitter owns a channel, ::rgb_led_write() has no effect
+ *       on it. The other two channels keep working.
+ * @note Uses one free state machine and one DMA channel without interrupts,
+ *       claimed through tkjhat/hw_res.h.
+ */
+
+#ifndef LED_TX_H
+#define LED_TX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "pico/stdlib.h"
+
+#include <tkjhat/led_link.h>
+
+/* =========================
+ *  Configuration
+ * ========================= */
+#define LED_TX_CYCLES_PER_CHIP                  16  // must match src/led_tx.pio
+
+/**
+ * @brief Take over an LED channel for transmission.
+ *
+ * @param pin      ::RGB_LED_R, ::RGB_LED_G or ::RGB_LED_B.
+ * @param bit_rate Data bits per second. Manchester sends two chips per bit.
+ * @param coding   Line code, see ::led_link_coding_t.
+ *
+ * @return 0 on success, negative value on error (bad pin or rate, already
+ *         running, no free state machine or DMA channel).
+ */
+int led_tx_init(uint pin, uint32_t bit_rate, led_link_coding_t coding);
+
+/**
+ * @brief Start sending one frame.
+ *
+ * The payload is encoded into an internal buffer, so it can be reused as
+ * soon as the function returns.
+ *
+ * @return 0 on success, -1 if not initialized, -2 if the length is invalid,
+ *         -3 if the previous frame is still being sent.
+ */
+int led_tx_send(const void *payload, size_t len);
+
+/**
+ * @brief @c true while a frame is being sent (until its last chip ended).
+ */
+bool led_tx_busy(void);
+
+/**
+ * @brief Actual chip rate after the PIO clock divider rounding, 0 if not running.
+ */
+float led_tx_chip_rate(void);
+
+/**
+ * @brief Stop the transmitter and give the pin back to the RGB PWM.
+ *
+ * Any frame in progress is cut.
+ */
+void led_tx_deinit(void);
+
+#endif /* LED_TX_H */
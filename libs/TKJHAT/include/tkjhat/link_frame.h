@@ -0,0 +1,153 @@
+/*
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 , Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+
+/**
+ * @file tkjhat/link_frame.h
+ * @brief Framed packet format used by the UART board-to-board link.
+ *
+ * @details
+ * Every frame on the wire looks like:
+ *
+ * | Field   | Size | Notes                                           |
+ * |---------|------|-------------------------------------------------|
+ * | sync    | 2    | 0xA5 0x5A                                       |
+ * | type    | 1    | ::link_frame_type_t                             |
+ * | seq     | 1    | Sender sequence number, +1 per frame (wraps)    |
+ * | len     | 1    | Payload length, 0..::LINK_FRAME_MAX_PAYLOAD     |
+ * | payload | len  |                                                 |
+ * | crc     | 2    | CRC-16/CCITT of type..payload, little endian    |
+ *
+ * The decoder is a byte-at-a-time state machine. After a CRC error it
+ * searches the next sync pattern, so a corrupted frame costs only that frame.
+ * Gaps in the sequence numbers are counted as lost frames.
+ *
+ * Portable C (no Pico dependencies), so the host tools use the same code.
+ */
+
+#ifndef LINK_FRAME_H
+#define LINK_FRAME_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LINK_FRAME_SYNC0                        0xA5
+#define LINK_FRAME_SYNC1                        0x5A
+#define LINK_FRAME_MAX_PAYLOAD                  255
+#define LINK_FRAME_OVERHEAD                     7   // sync(2) + type + seq + len + crc(2)
+#define LINK_FRAME_MAX_SIZE                     (LINK_FRAME_MAX_PAYLOAD + LINK_FRAME_OVERHEAD)
+
+/**
+ * @brief Frame types.
+ */
+typedef enum {
+    LINK_FRAME_DATA = 0,    ///< Application payload
+    LINK_FRAME_PING = 1,    ///< Latency probe, payload echoed back in a PONG
+    LINK_FRAME_PONG = 2,    ///< Answer to a PING
+} link_frame_type_t;
+
+/**
+ * @brief Result of ::link_frame_decode_byte.
+ */
+typedef enum {
+    LINK_FRAME_NONE = 0,    ///< Frame not complete yet
+    LINK_FRAME_READY = 1,   ///< A valid frame is available in the decoder
+    LINK_FRAME_BAD_CRC = -1,///< A frame was received with a wrong CRC and dropped
+} link_frame_result_t;
+
+/**
+ * @brief Streaming decoder state and counters.
+ */
+typedef struct {
+    // Current frame (valid after LINK_FRAME_READY)
+    uint8_t  type;
+    uint8_t  seq;
+    uint8_t  len;
+    uint8_t  payload[LINK_FRAME_MAX_PAYLOAD];
+
+    // Counters
+    uint32_t frames;        ///< Valid frames
+    uint32_t crc_errors;    ///< Frames dropped because of the CRC
+    uint32_t lost;          ///< Frames missing according to the sequence numbers
+    uint32_t resync_bytes;  ///< Bytes skipped while looking for the sync pattern
+
+    // Internal
+    uint8_t  state;
+    uint16_t index;
+    uint16_t crc;
+    uint16_t rx_crc;
+    uint8_t  next_seq;
+    bool     have_seq;
+} link_frame_decoder_t;
+
+/**
+ * @brief Encode a frame into @p out.
+ *
+ * @param type    Frame type.
+ * @param seq     Sequence number.
+ * @param payload Payload bytes (may be @c NULL if @p len is 0).
+ * @param len     Payload length, at most ::LINK_FRAME_MAX_PAYLOAD.
+ * @param out     Destination buffer.
+ * @param out_len Size of @p out; needs @p len + ::LINK_FRAME_OVERHEAD bytes.
+ *
+ * @return Number of bytes written, 0 if it does not fit.
+ */
+size_t link_frame_encode(uint8_t type, uint8_t seq, const void *payload, size_t len,
+                         uint8_t *out, size_t out_len);
+
+/**
+ * @brief Reset the decoder state and counters.
+ */
+void link_frame_decoder_init(link_frame_decoder_t *d);
+
+/**
+ * @brief Feed one received byte.
+ *
+ * @return ::LINK_FRAME_READY when a valid frame is complete (read it from
+ *         @c type / @c seq / @c len / @c payload before the next call),
+ *         ::LINK_FRAME_BAD_CRC when a frame was dropped, ::LINK_FRAME_NONE otherwise.
+ */
+link_frame_result_t link_frame_decode_byte(link_frame_decoder_t *d, uint8_t byte);
+
+/**
+ * @brief true between frames (the decoder waits for the first sync byte).
+ *
+ * Lets a protocol carry other bytes between frames (tkjhat/morse_wire.h).
+ */
+static inline bool link_frame_decoder_idle(const link_frame_decoder_t *d) { return d->state == 0; }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LINK_FRAME_H */
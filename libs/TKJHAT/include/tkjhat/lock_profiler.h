@@ -0,0 +1,176 @@
+/*
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 , Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+
+/**
+ * @file tkjhat/lock_profiler.h
+ * @brief Contention profiler for FreeRTOS mutexes and semaphores.
+ *
+ * @details
+ * Wrap the take/give of a shared resource with ::lock_prof_take and
+ * ::lock_prof_give instead of @c xSemaphoreTake / @c xSemaphoreGive and the
+ * profiler keeps, for every registered lock:
+ *
+ * - number of acquires, contended acquires (the lock was not free) and timeouts,
+ * - log2 histograms of the wait time (contended acquires) and hold time
+ *   (plain-array bins of tkjhat/log_hist.h),
+ * - the tasks that owned the lock when another task had to wait,
+ * - priority-inheritance events: a higher priority task waited on a mutex held
+ *   by a lower priority task. The time spent waiting in that situation is
+ *   accumulated as priority-inversion time.
+ *
+ * ::lock_prof_format_report writes a summary of the hottest locks (largest
+ * total wait time first).
+ *
+ * ### Typical usage
+ * @code
+ * static SemaphoreHandle_t i2c_mtx;
+ * static int i2c_lock;
+ *
+ * i2c_mtx  = xSemaphoreCreateMutex();
+ * i2c_lock = lock_prof_register(i2c_mtx, "i2c");
+ *
+ * if (lock_prof_take(i2c_lock, pdMS_TO_TICKS(5)) == pdTRUE) {
+ *     // ... use the bus ...
+ *     lock_prof_give(i2c_lock);
+ * }
+ *
+ * char report[512];
+ * lock_prof_format_report(report, sizeof(report), 4);
+ * @endcode
+ *
+ * @note Hold time is measured only when the task that gives the lock is the
+ *       one that took it (mutex usage). Semaphores used for signalling still
+ *       get acquire, contention and wait statistics.
+ * @note Recursive mutexes are not supported.
+ * @note Do not use from ISRs.
+ */
+
+#ifndef LOCK_PROFILER_H
+#define LOCK_PROFILER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <FreeRTOS.h>
+#include <semphr.h>
+
+/* =========================
+ *  Configuration
+ * ========================= */
+#ifndef LOCK_PROF_MAX_LOCKS
+#define LOCK_PROF_MAX_LOCKS                     8   // registered locks
+#endif
+#ifndef LOCK_PROF_MAX_OWNERS
+#define LOCK_PROF_MAX_OWNERS                    3   // distinct owners remembered per lock
+#endif
+#define LOCK_PROF_HIST_BUCKETS                  17  // ::log_hist_t bins with 0 sub bits: 0 us, then [2^(i-1), 2^i) us
+#define LOCK_PROF_NAME_LEN                      12
+
+/**
+ * @brief Task that owned a lock when another task had to wait for it.
+ */
+typedef struct {
+    char     name[LOCK_PROF_NAME_LEN];  ///< Owner task name
+    uint32_t count;                     ///< Contended acquires while it owned the lock
+} lock_prof_owner_t;
+
+/**
+ * @brief Statistics of one lock.
+ */
+typedef struct {
+    char     name[LOCK_PROF_NAME_LEN];              ///< Name given at registration
+    uint32_t acquires;                              ///< Successful takes
+    uint32_t contended;                             ///< Takes that found the lock busy
+    uint32_t timeouts;                              ///< Takes that gave up
+    uint32_t pi_events;                             ///< Waits on a mutex held by a lower priority task
+    uint64_t wait_us_total;                         ///< Sum of contended wait times
+    uint32_t wait_us_max;                           ///< Longest contended wait
+    uint64_t hold_us_total;                         ///< Sum of hold times
+    uint32_t hold_us_max;                           ///< Longest hold
+    uint32_t holds;                                 ///< Number of measured holds
+    uint64_t inversion_us;                          ///< Wait time spent in priority-inheritance events
+    uint32_t wait_hist[LOCK_PROF_HIST_BUCKETS];     ///< Contended wait time histogram
+    uint32_t hold_hist[LOCK_PROF_HIST_BUCKETS];     ///< Hold time histogram
+    lock_prof_owner_t owners[LOCK_PROF_MAX_OWNERS]; ///< Owners seen at contention
+} lock_prof_stats_t;
+
+/**
+ * @brief Register a mutex or semaphore to be profiled.
+ *
+ * @param lock Handle created with @c xSemaphoreCreateMutex(),
+ *             @c xSemaphoreCreateBinary() or @c xSemaphoreCreateCounting().
+ * @param name Short name used in the report.
+ *
+ * @return Lock id (>= 0) to use with the rest of the API, negative on error.
+ */
+int lock_prof_register(SemaphoreHandle_t lock, const char *name);
+
+/**
+ * @brief Profiled replacement for @c xSemaphoreTake().
+ *
+ * @param id   Value returned by ::lock_prof_register.
+ * @param wait Maximum time to wait, in ticks.
+ *
+ * @return @c pdTRUE if the lock was taken, @c pdFALSE otherwise.
+ */
+BaseType_t lock_prof_take(int id, TickType_t wait);
+
+/**
+ * @brief Profiled replacement for @c xSemaphoreGive().
+ *
+ * @return Result of @c xSemaphoreGive(), @c pdFALSE if @p id is invalid.
+ */
+BaseType_t lock_prof_give(int id);
+
+/**
+ * @brief Copy the statistics of a lock.
+ *
+ * @return 0 on success, negative value if @p id is invalid.
+ */
+int lock_prof_get(int id, lock_prof_stats_t *out);
+
+/**
+ * @brief Clear the statistics of every registered lock.
+ */
+void lock_prof_reset(void);
+
+/**
+ * @brief Write a summary of the hottest locks into @p buf.
+ *
+ * Locks are sorted by total wait time. Each line shows acquires, contention
+ * rate, average / p99 / max wait, average / max hold, priority-inheritance
+ * events and the owner most often found holding the lock.
+ *
+ * @param max_locks Number of locks to include, 0 for all.
+ *
+ * @return Number of characters written (excluding the terminator).
+ */
+int lock_prof_format_report(char *buf, size_t len, int max_locks);
+
+#endif /* LOCK_PROFILER_H */
@@ -0,0 +1,220 @@
+/*
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 , Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file tkjhat/log_hist.h
+ * @brief Log-bucketed histogram for latencies and other non-negative values.
+ *
+ * @details
+ * Values are 32-bit unsigned integers (microseconds, lux, milli-g...). Each
+ * power of two is split into 2^@c sub_bits bins of equal width, so the
+ * relative width of a bin is at most 2^-@c sub_bits whatever the magnitude,
+ * and values below 2^@c sub_bits get a bin of their own:
+ *
+ * | sub_bits | bins for 32-bit values | worst relative bin width |
+ * |----------|------------------------|--------------------------|
+ * | 0        | 33                     | 100 % (plain log2)       |
+ * | 2        | 124                    | 25 %                     |
+ * | 3        | 240                    | 12.5 %                   |
+ *
+ * A histogram can keep fewer bins than that: values past the last bin are
+ * counted in it (the exact maximum is still kept in ::log_hist_t::max).
+ *
+ * Adding a value is O(1) (a count-leading-zeros and a shift). Two histograms
+ * with the same @c sub_bits merge by adding their bins, so per-interval
+ * histograms sent as telemetry (::log_hist_serialize) can be combined on the
+ * host into long-term distributions.
+ *
+ * Besides ::log_hist_t, the bin helpers (::log_hist_index, ::log_hist_bins_find,
+ * ...) work on a plain @c uint32_t array, for instrumentation that keeps its
+ * own small histograms (e.g. the lock profiler).
+ *
+ * ### Typical usage
+ * @code
+ * static log_hist_t loop_us;
+ *
+ * log_hist_init(&loop_us);
+ * for (;;) {
+ *     uint32_t t0 = time_us_32();
+ *     // ... work ...
+ *     log_hist_add(&loop_us, time_us_32() - t0);
+ * }
+ * // p99 of the loop time
+ * uint32_t p99 = log_hist_quantile(&loop_us, 0.99f);
+ * @endcode
+ *
+ * Not thread safe: protect a histogram shared between tasks yourself.
+ *
+ * Portable C (no Pico dependencies), so it can also be compiled on a PC
+ * by the host tools.
+ */
+
+#ifndef TKJHAT_LOG_HIST_H
+#define TKJHAT_LOG_HIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* =========================
+ *  Configuration
+ * ========================= */
+#ifndef LOG_HIST_SUB_BITS
+#define LOG_HIST_SUB_BITS                       2   // 4 bins per power of two
+#endif
+#ifndef LOG_HIST_BINS
+#define LOG_HIST_BINS                           80  // with 2 sub bits, values up to ~2^20 get their own bin
+#endif
+#define LOG_HIST_MAX_SUB_BITS                   4
+#define LOG_HIST_SERIAL_VERSION                 1
+
+/** @brief Number of bins needed to keep every 32-bit value apart. */
+#define LOG_HIST_BINS_FOR_U32(sub_bits)         ((33u - (sub_bits)) << (sub_bits))
+
+/** @brief Worst case size of ::log_hist_serialize output. */
+#define LOG_HIST_SERIAL_MAX                     (3 + 2 + 5 + 10 + 5 + 5 + 3 + LOG_HIST_BINS * 7)
+
+/**
+ * @brief Histogram with ::LOG_HIST_BINS bins of ::LOG_HIST_SUB_BITS.
+ */
+typedef struct {
+    uint32_t count;                 ///< Values added
+    uint32_t min;                   ///< Smallest value (UINT32_MAX while empty)
+    uint32_t max;                   ///< Largest value
+    uint64_t sum;                   ///< Sum of the values (for the mean)
+    uint32_t bins[LOG_HIST_BINS];   ///< Counts per bin
+} log_hist_t;
+
+/* =========================
+ *  Bin helpers
+ * ========================= */
+
+/**
+ * @brief Bin of @p value. O(1).
+ *
+ * @param value    Value to classify.
+ * @param sub_bits Bins per power of two, as a power of two (0 .. ::LOG_HIST_MAX_SUB_BITS).
+ * @return Bin index, up to ::LOG_HIST_BINS_FOR_U32(@p sub_bits) - 1.
+ */
+static inline unsigned log_hist_index(uint32_t value, unsigned sub_bits) {
+    if (value < (1u << sub_bits)) return value;
+    unsigned e = 31u - (unsigned)__builtin_clz(value);
+    return ((e - sub_bits + 1u) << sub_bits) | ((value >> (e - sub_bits)) & ((1u << sub_bits) - 1u));
+}
+
+/**
+ * @brief ::log_hist_index clamped to a histogram of @p nbins bins.
+ */
+static inline unsigned log_hist_bin(uint32_t value, unsigned sub_bits, unsigned nbins) {
+    unsigned i = log_hist_index(value, sub_bits);
+    return i < nbins ? i : nbins - 1;
+}
+
+/**
+ * @brief Smallest value that falls in bin @p index.
+ */
+uint32_t log_hist_bin_lower(unsigned index, unsigned sub_bits);
+
+/**
+ * @brief Largest value that falls in bin @p index (ignoring clamping).
+ */
+uint32_t log_hist_bin_upper(unsigned index, unsigned sub_bits);
+
+/**
+ * @brief Bin that holds the @p rank-th smallest value.
+ *
+ * @param bins  Bin counts.
+ * @param nbins Number of bins.
+ * @param rank  1-based rank.
+ * @return Bin index, or -1 if the bins hold fewer than @p rank values.
+ */
+int log_hist_bins_find(const uint32_t *bins, unsigned nbins, uint64_t rank);
+
+/* =========================
+ *  Histogram
+ * ========================= */
+
+/**
+ * @brief Clear a histogram.
+ */
+void log_hist_init(log_hist_t *h);
+
+/**
+ * @brief Add one value. O(1).
+ */
+void log_hist_add(log_hist_t *h, uint32_t value);
+
+/**
+ * @brief Add every value of @p src to @p dst.
+ */
+void log_hist_merge(log_hist_t *dst, const log_hist_t *src);
+
+/**
+ * @brief Estimate of the @p q quantile.
+ *
+ * @param h Histogram.
+ * @param q Quantile in [0, 1] (0.5 = median, 0.99 = p99).
+ * @return Middle of the bin that holds the quantile, limited to the
+ *         [min, max] range seen. Exact for values below 2^::LOG_HIST_SUB_BITS,
+ *         for q = 0 and for q = 1. 0 if the histogram is empty.
+ */
+uint32_t log_hist_quantile(const log_hist_t *h, float q);
+
+/**
+ * @brief Fraction of the values that are <= @p value (estimated at bin resolution).
+ */
+float log_hist_rank(const log_hist_t *h, uint32_t value);
+
+/**
+ * @brief Write a compact, byte order independent copy of @p h.
+ *
+ * Only the non-empty bins are written (as LEB128 varints), so a typical
+ * latency histogram takes a few tens of bytes.
+ *
+ * @return Bytes written, or negative value if @p len is too small
+ *         (::LOG_HIST_SERIAL_MAX is always enough).
+ */
+int log_hist_serialize(const log_hist_t *h, uint8_t *buf, size_t len);
+
+/**
+ * @brief Read a histogram written by ::log_hist_serialize.
+ *
+ * The writer must use the same ::LOG_HIST_SUB_BITS. If it kept more bins,
+ * the extra ones are folded into the last bin of @p h.
+ *
+ * @return Bytes consumed, or negative value if the data is malformed or was
+ *         written with other sub bits.
+ */
+int log_hist_deserialize(log_hist_t *h, const uint8_t *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TKJHAT_LOG_HIST_H */
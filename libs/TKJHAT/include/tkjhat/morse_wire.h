@@ -0,0 +1,270 @@
+/*
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 , Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+
+
+/**
+ * @file tkjhat/morse_wire.h
+ * @brief Compact, batched and acknowledged encoding of Morse messages on a serial link.
+ *
+ * @details
+ * The course protocol sends every message as ASCII: one character per symbol
+ * (@c '.', @c '-', @c ' ') followed by @c "  \n". This module sends the same
+ * messages with 2 bits per symbol:
+ *
+ * | Code | Symbol                    |
+ * |------|---------------------------|
+ * | 0    | end of message            |
+ * | 1    | @c '.'                    |
+ * | 2    | @c '-'                    |
+ * | 3    | @c ' ' (letter/word gap)  |
+ *
+ * Four symbols per byte, first symbol in the two high bits. A message ends
+ * with code 0 and the rest of that byte is padding, so a message of @c n
+ * symbols takes (n + 4) / 4 bytes instead of n + 3.
+ *
+ * The packed messages queued by ::morse_wire_send form a byte stream. It is
+ * sent in batches, each one a link_frame DATA frame (tkjhat/link_frame.h)
+ * with the payload
+ *
+ * | Field | Size    | Notes                                                   |
+ * |-------|---------|---------------------------------------------------------|
+ * | kind  | 1       | ::MORSE_WIRE_BATCH (+ ::MORSE_WIRE_SYNC) or ::MORSE_WIRE_ACK |
+ * | id    | 1       | Batch id, +1 per batch (wraps); the ACK repeats it      |
+ * | data  | 0..253  | Packed messages (batches only)                          |
+ *
+ * One batch is in flight at a time. Whatever is queued while it waits for its
+ * ACK goes out together in the next one, so messages typed slowly leave at
+ * once and a burst of messages shares frames and acknowledgements. A batch
+ * that is not acknowledged within @c ack_timeout_ms is sent again; the
+ * receiver acknowledges but does not deliver a batch id it has already seen.
+ * A message may be split across batches at a byte boundary.
+ *
+ * ::morse_wire_feed also accepts the ASCII format, so a board using this
+ * module still talks to the plain course client. ::morse_wire_peer_compact
+ * tells when the other end has sent a frame, i.e. understands the compact
+ * format; until then the application should keep sending ASCII.
+ *
+ * @code
+ * static morse_wire_t wire;
+ *
+ * static bool write_out(void *ctx, const uint8_t *frame, size_t len) { ... }
+ * static void on_message(void *ctx, const char *symbols, size_t len) { ... }
+ *
+ * morse_wire_config_t cfg = MORSE_WIRE_DEFAULT_CONFIG;
+ * cfg.write = write_out;
+ * cfg.on_message = on_message;
+ * morse_wire_init(&wire, &cfg);
+ *
+ * // received bytes:
+ * morse_wire_feed(&wire, buf, n, now_ms);
+ * // every few ms (retransmissions):
+ * morse_wire_poll(&wire, now_ms);
+ * // outgoing message:
+ * if (morse_wire_peer_compact(&wire)) morse_wire_send(&wire, ".- -...", 7, now_ms);
+ * @endcode
+ *
+ * Not thread-safe: call it from one task or under a mutex. Portable C (no
+ * Pico dependencies), so the host tools use the same code.
+ */
+
+#ifndef TKJHAT_MORSE_WIRE_H
+#define TKJHAT_MORSE_WIRE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <tkjhat/link_frame.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* =========================
+ *  Configuration
+ * ========================= */
+#ifndef MORSE_WIRE_TX_QUEUE
+#define MORSE_WIRE_TX_QUEUE                     1024    // packed bytes waiting to be sent
+#endif
+#ifndef MORSE_WIRE_MAX_MESSAGE
+#define MORSE_WIRE_MAX_MESSAGE                  512     // symbols kept of a received message
+#endif
+
+#define MORSE_WIRE_BATCH                        0x01    ///< Payload kind: packed messages
+#define MORSE_WIRE_ACK                          0x02    ///< Payload kind: acknowledgement of a batch
+#define MORSE_WIRE_SYNC                         0x80    ///< Flag of the first batch after init or reset
+#define MORSE_WIRE_HEADER                       2       // kind + id
+#define MORSE_WIRE_BATCH_MAX                    (LINK_FRAME_MAX_PAYLOAD - MORSE_WIRE_HEADER)
+
+#define MORSE_WIRE_ERR_SYMBOL                   -1      ///< Message has a character other than '.', '-', ' '
+#define MORSE_WIRE_ERR_FULL                     -2      ///< Not enough room in the TX queue
+
+/**
+ * @brief Writes one complete frame to the link. Return false if it could not be sent.
+ */
+typedef bool (*morse_wire_write_t)(void *ctx, const uint8_t *frame, size_t len);
+
+/**
+ * @brief Receives one message (symbols without the terminator, not NUL-terminated).
+ */
+typedef void (*morse_wire_message_t)(void *ctx, const char *symbols, size_t len);
+
+/**
+ * @brief Settings.
+ */
+typedef struct {
+    morse_wire_write_t   write;
+    morse_wire_message_t on_message;
+    void    *ctx;                       ///< Passed to both callbacks
+    uint32_t ack_timeout_ms;            ///< Retransmission timeout of a batch
+} morse_wire_config_t;
+
+/** No callbacks, 200 ms retransmission timeout. */
+#define MORSE_WIRE_DEFAULT_CONFIG {             \
+    .write          = NULL,                     \
+    .on_message     = NULL,                     \
+    .ctx            = NULL,                     \
+    .ack_timeout_ms = 200,                      \
+}
+
+/**
+ * @brief Counters.
+ */
+typedef struct {
+    uint32_t tx_messages;       ///< Messages queued
+    uint32_t tx_batches;        ///< Batches sent (first transmissions)
+    uint32_t tx_retransmits;
+    uint32_t tx_bytes;          ///< Bytes written, framing and ACKs included
+    uint32_t rx_messages;       ///< Messages delivered (both formats)
+    uint32_t rx_ascii_messages; ///< ... of which in ASCII
+    uint32_t rx_batches;        ///< New batches received
+    uint32_t rx_duplicates;     ///< Batches received again (acknowledged, not delivered)
+    uint32_t rx_truncated;      ///< Messages longer than ::MORSE_WIRE_MAX_MESSAGE
+    uint32_t rx_bad_frames;     ///< CRC errors and frames with an unknown payload
+    uint32_t acks;              ///< Batches acknowledged by the peer
+    uint32_t rtt_last_ms;       ///< Batch sent to ACK received
+    uint32_t rtt_max_ms;
+} morse_wire_stats_t;
+
+/**
+ * @brief State of one end of the link.
+ */
+typedef struct {
+    morse_wire_config_t cfg;
+    morse_wire_stats_t  stats;
+
+    // TX: packed byte stream, batch in flight
+    uint8_t  queue[MORSE_WIRE_TX_QUEUE];
+    uint16_t q_head;                    ///< Next byte to send
+    uint16_t q_used;
+    uint8_t  frame[LINK_FRAME_MAX_SIZE];///< Batch in flight, kept for retransmission
+    uint16_t frame_len;                 ///< 0 when nothing is in flight
+    uint8_t  tx_id;                     ///< Id of the next batch
+    uint8_t  tx_seq;                    ///< link_frame sequence number
+    bool     synced;                    ///< A batch with ::MORSE_WIRE_SYNC was acknowledged
+    uint32_t sent_ms;                   ///< Last transmission of the batch in flight
+    uint32_t first_sent_ms;             ///< First transmission of the batch in flight
+
+    // RX
+    link_frame_decoder_t dec;
+    char     msg[MORSE_WIRE_MAX_MESSAGE];
+    uint16_t msg_len;
+    bool     msg_truncated;
+    uint8_t  rx_id;                     ///< Id of the last batch received
+    bool     have_rx_id;
+    bool     rx_sync;                   ///< The last batch received had ::MORSE_WIRE_SYNC
+    bool     peer_compact;              ///< The peer has sent a valid frame
+} morse_wire_t;
+
+/**
+ * @brief Initialize the state.
+ *
+ * @param w   State.
+ * @param cfg Settings, or @c NULL for ::MORSE_WIRE_DEFAULT_CONFIG (no callbacks).
+ */
+void morse_wire_init(morse_wire_t *w, const morse_wire_config_t *cfg);
+
+/**
+ * @brief Drop the queue, the batch in flight and the partial received message
+ * (e.g. when the host closed the port). The next batch carries ::MORSE_WIRE_SYNC.
+ * Counters are kept.
+ */
+void morse_wire_reset(morse_wire_t *w);
+
+/**
+ * @brief Queue one message and send it if no batch is in flight.
+ *
+ * @param symbols @c '.', @c '-' and @c ' '. A trailing @c '\\n' (and @c '\\r')
+ *                is ignored, so an ASCII message can be passed as is.
+ * @param len     Number of characters.
+ * @param now_ms  Current time in milliseconds.
+ * @return 0 on success, ::MORSE_WIRE_ERR_SYMBOL or ::MORSE_WIRE_ERR_FULL
+ *         (nothing is queued then).
+ */
+int morse_wire_send(morse_wire_t *w, const char *symbols, size_t len, uint32_t now_ms);
+
+/**
+ * @brief Process received bytes: compact frames, and ASCII messages between frames.
+ *
+ * Delivers the complete messages through @c on_message and answers batches with an ACK.
+ */
+void morse_wire_feed(morse_wire_t *w, const uint8_t *data, size_t len, uint32_t now_ms);
+
+/**
+ * @brief Retransmit the batch in flight if its ACK is late, or send queued
+ * bytes whose batch could not be written before. Call it every few milliseconds.
+ */
+void morse_wire_poll(morse_wire_t *w, uint32_t now_ms);
+
+/**
+ * @brief Send an empty batch so the peer learns that this end speaks the
+ * compact format. Does nothing while a batch is in flight.
+ */
+void morse_wire_hello(morse_wire_t *w, uint32_t now_ms);
+
+/**
+ * @brief true once the peer has sent a valid frame.
+ */
+static inline bool morse_wire_peer_compact(const morse_wire_t *w) { return w->peer_compact; }
+
+/**
+ * @brief true when nothing is queued or waiting for an ACK.
+ */
+static inline bool morse_wire_idle(const morse_wire_t *w) { return !w->q_used && !w->frame_len; }
+
+/**
+ * @brief Bytes a message of @p symbols symbols takes in a batch.
+ */
+static inline size_t morse_wire_packed_size(size_t symbols) { return symbols / 4 + 1; }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TKJHAT_MORSE_WIRE_H */
@@ -15,13 +15,26 @@
 
 typedef void (*pdm_samples_ready_handler_t)(void);
 
+// Width of each PIO push / DMA transfer of raw PDM data.
+// 32-bit capture moves 4x fewer FIFO entries and DMA transfers than 8-bit.
+// They differ on an overrun (the DMA not draining the RX FIFO in time):
+// the 8-bit program pushes with noblock and silently drops bytes, while the
+// 32-bit one autopushes, so the SM stalls and the microphone clock (side-set)
+// stops until there is room: samples are late and the clock has a gap, but
+// none is lost. pdm_microphone_get_overruns() counts the 32-bit stalls.
+enum pdm_capture_width {
+    PDM_CAPTURE_8BIT = 0,
+    PDM_CAPTURE_32BIT = 1,
+};
+
 struct pdm_microphone_config {
     uint gpio_data;
     uint gpio_clk;
-    PIO pio;
-    uint pio_sm;
+    PIO pio;        // NULL: first block with room (tkjhat/hw_res.h)
+    uint pio_sm;    // ignored: a free state machine is claimed
     uint sample_rate;
     uint sample_buffer_size;
+    enum pdm_capture_width capture_width;
 };
 
 int pdm_microphone_init(const struct pdm_microphone_config* config);
@@ -35,6 +48,16 @@ void pdm_microphone_set_filter_max_volume(uint8_t max_volume);
 void pdm_microphone_set_filter_gain(uint8_t gain);
 void pdm_microphone_set_filter_volume(uint16_t volume);
 
+// Automatic gain control (tkjhat/agc.h) run on every block returned by
+// pdm_microphone_read(). In feedback mode it also drives the filter volume,
+// overriding pdm_microphone_set_filter_volume(). Pass NULL to disable.
+struct agc;
+void pdm_microphone_set_agc(struct agc* agc);
+
 int pdm_microphone_read(int16_t* buffer, size_t samples);
 
+// Raw blocks during which the 32-bit capture stalled on a full RX FIFO
+// (FDEBUG RXSTALL), since pdm_microphone_start(). Always 0 for 8-bit capture.
+uint32_t pdm_microphone_get_overruns();
+
 #endif
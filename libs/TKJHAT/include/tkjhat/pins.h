@@ -33,6 +33,8 @@ SOFTWARE.
 
 #define DEFAULT_UART_0                          0
 #define DEFAULT_UART_1                          1
+#define DEFAULT_UART_TX_PIN                     4   // UART1 TX
+#define DEFAULT_UART_RX_PIN                     5   // UART1 RX
 
 #define SW1_PIN                                 02
 #define SW2_PIN                                 22
@@ -0,0 +1,201 @@
+/*
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 , Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+
+
+/**
+ * @file tkjhat/pitch.h
+ * @brief Fixed-point YIN pitch detector on the decoded microphone stream.
+ *
+ * @details
+ * Gives a frequency and a confidence for every ::PITCH_HOP new samples
+ * (62.5 estimates per second at 8 kHz), e.g. for a tuner or to check the
+ * tone the buzzer actually plays. The analysis window is the last
+ * ::PITCH_WINDOW samples (64 ms at 8 kHz). Everything is integer arithmetic:
+ *
+ * - Incremental difference function: the window is split in ::PITCH_BLOCKS
+ *   hops and the sum of squared differences of every hop is kept per lag.
+ *   A new hop computes only its own sums and replaces the oldest ones in
+ *   d(tau), so an estimate costs ::PITCH_HOP instead of ::PITCH_WINDOW
+ *   multiply-adds per lag. The sums are exact (64-bit), so the result does
+ *   not drift.
+ * - Cumulative mean normalisation and absolute threshold of YIN. The lags are
+ *   scanned upwards and the scan stops at the bottom of the first dip below
+ *   the threshold (early termination); with fractions compared by cross
+ *   multiplication there is no division in the scan.
+ * - A silence gate: a window whose RMS is below @c min_rms is reported
+ *   unvoiced without scanning.
+ * - Parabolic interpolation on d(tau) around the chosen lag. Periods shorter
+ *   than 32 samples are measured again at 2, 4, 8... periods, which keeps
+ *   high tones within a few cents.
+ *
+ * ### Budget
+ * At 8 kHz with lags up to 134 (60 Hz) a hop costs about 17 k multiply-adds,
+ * roughly 170 k cycles on a Cortex-M0+, under 10 % of the 2 M cycles (125 MHz)
+ * a 16 ms hop lasts. The state takes about 10 KB. @c host/bench/bench_pitch reports the cost per estimate
+ * and the accuracy on synthetic tones and on clips recorded with
+ * @c record_audio.sh.
+ *
+ * ### Typical usage
+ * @code
+ * static pitch_t pd;
+ *
+ * pitch_config_t cfg = PITCH_DEFAULT_CONFIG;
+ * cfg.sample_rate = MEMS_SAMPLING_FREQUENCY;
+ * pitch_init(&pd, &cfg);
+ * ...
+ * pitch_result_t r;
+ * if (pitch_process(&pd, samples, n, &r) && r.voiced) {   // after get_microphone_samples()
+ *     int cents;
+ *     int note = pitch_note(r.freq_chz, &cents);           // MIDI note, 69 = A4
+ * }
+ * @endcode
+ *
+ * Portable C (no Pico dependencies), so it can also be compiled on a PC
+ * by the host tools.
+ */
+
+#ifndef TKJHAT_PITCH_H
+#define TKJHAT_PITCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PITCH_HOP                               128     // new samples per estimate
+#define PITCH_BLOCKS                            4       // hops per analysis window
+#define PITCH_WINDOW                            (PITCH_HOP * PITCH_BLOCKS)
+#ifndef PITCH_MAX_TAU
+#define PITCH_MAX_TAU                           200     // longest lag in samples, sizes the state
+#endif
+#define PITCH_ONE                               32768u  // thresholds and confidence are Q15
+
+/**
+ * @brief Detector settings.
+ */
+typedef struct {
+    uint32_t sample_rate;       ///< PCM sample rate in Hz
+    uint16_t min_hz;            ///< Lowest pitch; sample_rate / min_hz must stay below ::PITCH_MAX_TAU
+    uint16_t max_hz;            ///< Highest pitch; keep below sample_rate / 5 (fewer samples per period
+                                ///< can leave the dip between two lags above the threshold)
+    uint16_t threshold;         ///< YIN absolute threshold on the normalised difference (Q15)
+    uint16_t min_rms;           ///< Windows quieter than this are unvoiced (sample units)
+} pitch_config_t;
+
+/**
+ * @brief Defaults for the HAT microphone at 8 kHz: 60 Hz .. 1.6 kHz,
+ * threshold 0.15, silence below RMS 64 (-54 dBFS).
+ */
+#define PITCH_DEFAULT_CONFIG {                  \
+    .sample_rate = 8000,                        \
+    .min_hz      = 60,                          \
+    .max_hz      = 1600,                        \
+    .threshold   = 4915,                        \
+    .min_rms     = 64,                          \
+}
+
+/**
+ * @brief One estimate.
+ */
+typedef struct {
+    uint32_t seq;               ///< Estimate number since init
+    uint32_t freq_chz;          ///< Frequency in centi-Hz (44000 = 440 Hz), 0 when unvoiced
+    uint16_t confidence;        ///< 1 - normalised difference at the chosen lag (Q15)
+    uint16_t rms;               ///< RMS of the window
+    bool     voiced;            ///< A dip below the threshold was found
+} pitch_result_t;
+
+/**
+ * @brief Detector state and counters. Treat as opaque except for the counters.
+ */
+typedef struct pitch {
+    pitch_config_t cfg;
+    uint16_t tau_min;                               ///< Shortest lag searched
+    uint16_t tau_max;                               ///< Longest lag searched
+    uint16_t fill;                                  ///< Samples of the current hop received
+    uint8_t  block;                                 ///< Hop whose sums are replaced next
+    int16_t  x[PITCH_MAX_TAU + PITCH_HOP];          ///< Lag history followed by the current hop
+    uint64_t hop_diff[PITCH_BLOCKS][PITCH_MAX_TAU]; ///< Squared differences per hop and lag (lag 1 at index 0)
+    uint64_t diff[PITCH_MAX_TAU];                   ///< d(tau) of the window
+    uint64_t hop_energy[PITCH_BLOCKS];              ///< Sum of squares per hop
+    uint64_t energy;                                ///< Sum of squares of the window
+    uint32_t cmn_num[PITCH_MAX_TAU];                ///< Normalised difference of the last scan,
+    uint32_t cmn_den[PITCH_MAX_TAU];                ///< as the fraction num / den
+
+    uint32_t hops;                                  ///< Hops processed
+    uint32_t estimates;                             ///< Estimates produced
+    uint32_t gated;                                 ///< Estimates skipped by the silence gate
+    uint16_t lags_scanned;                          ///< Lags examined by the last scan
+    pitch_result_t last;                            ///< Latest estimate
+} pitch_t;
+
+/**
+ * @brief Initialise @p pd from @p cfg (NULL for ::PITCH_DEFAULT_CONFIG).
+ *        The first estimate comes once the window and the lags before it
+ *        are filled (::PITCH_WINDOW plus the longest lag, rounded up to a hop).
+ *
+ * @return 0 on success, negative value if the configuration is invalid.
+ */
+int pitch_init(pitch_t *pd, const pitch_config_t *cfg);
+
+/**
+ * @brief Feed one block of PCM.
+ *
+ * @param pd   State from ::pitch_init.
+ * @param pcm  Samples, any length.
+ * @param n    Number of samples.
+ * @param out  Receives the latest estimate made during this call; may be NULL.
+ *
+ * @return Number of estimates made during this call.
+ */
+size_t pitch_process(pitch_t *pd, const int16_t *pcm, size_t n, pitch_result_t *out);
+
+/**
+ * @brief Nearest equal-tempered note (A4 = 440 Hz).
+ *
+ * @param freq_chz Frequency in centi-Hz, > 0.
+ * @param cents    Receives the offset from that note, -50..50; may be NULL.
+ *
+ * @return MIDI note number (69 = A4), -1 for a frequency of 0.
+ */
+int pitch_note(uint32_t freq_chz, int *cents);
+
+/**
+ * @brief Offset of @p freq_chz from @p ref_chz in cents (1/100 semitone).
+ */
+int32_t pitch_cents(uint32_t freq_chz, uint32_t ref_chz);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TKJHAT_PITCH_H */
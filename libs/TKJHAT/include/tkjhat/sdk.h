@@ -148,6 +148,10 @@ SOFTWARE.
 
 # define MEMS_SAMPLING_FREQUENCY                8000
 # define MEMS_BUFFER_SIZE                       256
+// PDM capture width: PDM_CAPTURE_32BIT (one DMA word per 32 PDM bits) or PDM_CAPTURE_8BIT
+#ifndef MEMS_CAPTURE_WIDTH
+# define MEMS_CAPTURE_WIDTH                     PDM_CAPTURE_32BIT
+#endif
 
 /* =========================
  *  ICM42670
@@ -158,6 +162,8 @@ SOFTWARE.
 #define ICM42670_WHO_AM_I_RESPONSE              0x67
 #define ICM42670_INT_CONFIG                     0x06
 #define ICM42670_INT1_CONFIG_VALUE              0x02
+#define ICM42670_INT_SOURCE0_REG                0x2B
+#define ICM42670_INT_SOURCE0_DRDY_INT1         0x08    // data ready on INT1
 #define ICM42670_MAX_READ_LENGTH                256
 #define ICM42670_MAX_WRITE_LENGTH               256
 
@@ -445,6 +451,8 @@ void deinit_buzzer(void);
  * - Clock pin: GPIO 15
  * - Sample rate: 16 kHz
  * - Buffer size: 256 samples
+ * - Capture width: @ref MEMS_CAPTURE_WIDTH (32-bit autopush by default, so the
+ *   PIO FIFO and the DMA move one word per 32 PDM bits instead of one byte per 8)
  *
  * @return 0 on success, negative value on error.
  */
@@ -591,6 +599,10 @@ bool i2c_read(uint8_t addr, uint8_t *dst, size_t len, bool nostop);
  * @brief Convenience API for the 128×64 SSD1306 I²C OLED (addr 0x3C).
  *
  * Uses the bundled pico-ssd1306 library to draw text and simple shapes.
+ * Every drawing call updates the whole panel; ::display_sched_start
+ * (tkjhat/display_sched.h) puts a scheduler in front of the updates that
+ * skips unchanged frames, coalesces bursts, follows the ambient light and
+ * powers the panel down when nothing changes.
  *
  * @see https://github.com/daschr/pico-ssd1306
  * @see SSD1306 datasheet: https://cdn-shop.adafruit.com/datasheets/SSD1306.pdf
@@ -617,7 +629,8 @@ void init_display(void);
  *
  * @param text Null-terminated C string. Ignored if @c NULL.
  *
- * @note This helper calls @c ssd1306_show() internally.
+ * @note This helper calls @c ssd1306_show() internally, then waits 800 ms.
+ *       With the display scheduler a deferred frame is sent during the wait.
  * @see write_text_xy()
  */
 void write_text(const char *text);
@@ -712,6 +725,16 @@ void clear_display(void);
  */
 void stop_display(void);
 
+/**
+ * @brief Set the contrast of the OLED panel.
+ *
+ * Lower contrast lowers the segment current, which dominates the consumption
+ * of the panel. ::init_display sets the maximum (255).
+ *
+ * @param contrast 0 (dimmest) to 255 (brightest).
+ */
+void set_display_contrast(uint8_t contrast);
+
 /** @} */ // end of group Display
 
 
@@ -966,6 +989,21 @@ int ICM42670_enable_accel_gyro_ln_mode(void);
  */
 int ICM42670_start_with_default_values(void);
 
+/**
+ * @brief Pulse INT1 (@ref ICM42670_INT, falling edge) each time a new sample is ready.
+ *
+ * Configures INT1 as push-pull, active low, pulsed, and routes the data
+ * ready interrupt to it, so a task can read each sample as soon as it exists
+ * instead of polling on a timer (e.g. through ::gpio_irq_register).
+ *
+ * @pre Call after the accelerometer / gyroscope are started: on some boards
+ *      writing the interrupt configuration right after the reset of
+ *      ::init_ICM42670 blocks the next write after a cold power-on.
+ *
+ * @return 0 on success, negative value on error (the register did not read back).
+ */
+int ICM42670_enable_data_ready_int(void);
+
 /**
  * @brief Read accelerometer, gyroscope, and temperature data.
  *
@@ -0,0 +1,215 @@
+/*
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 , Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+/**
+ * @file tkjhat/sound_level.h
+ * @brief A-weighted sound level meter on the decoded microphone stream.
+ *
+ * @details
+ * Turns PCM blocks into the few numbers a noise monitor needs, so only
+ * those have to leave the board:
+ *
+ * - A-weighting: three fixed-point biquads (Q28 coefficients, 64-bit
+ *   accumulators) designed at init from the IEC 61672 poles (bilinear
+ *   transform for the high-pass poles; the 12.2 kHz pair, above Nyquist,
+ *   is fitted to the analog roll-off) and normalised to 0 dB at 1 kHz,
+ * - Fast (125 ms) and Slow (1 s) exponential time weighting of the squared
+ *   signal. The time constants are rounded to a power-of-two number of
+ *   samples (128 ms / 1.02 s at 8 kHz), so each update is a shift,
+ * - per interval: LAeq, and LAFmax / LAFmin (or the Slow variants) of the
+ *   time-weighted level.
+ *
+ * At the end of each interval a ::sound_level_report_t is passed to the sink.
+ * Levels are in centi-dB (dB x 100). Without calibration they are relative
+ * to a full-scale sine (dBFS). ::sound_level_calibrate shifts them to dB
+ * SPL with a reference source, e.g. a 94 dB / 1 kHz acoustic calibrator.
+ *
+ * The meter needs a fixed gain chain: do not run it on a stream processed by
+ * the AGC (tkjhat/agc.h).
+ *
+ * ### Typical usage
+ * @code
+ * static sound_level_t meter;
+ *
+ * static void on_interval(const sound_level_report_t *r, void *ctx) {
+ *     char line[64];
+ *     sound_level_format_report(r, line, sizeof(line));
+ *     usb_serial_print(line);
+ * }
+ *
+ * sound_level_config_t cfg = SOUND_LEVEL_DEFAULT_CONFIG;
+ * cfg.interval_ms = 60000;                 // one record per minute
+ * cfg.calibration_cdb = 12000;             // measured with a calibrator
+ * sound_level_init(&meter, &cfg, on_interval, NULL);
+ *
+ * // for every block returned by get_microphone_samples():
+ * sound_level_process(&meter, samples, n);
+ * @endcode
+ *
+ * Portable C (no Pico dependencies), so it can also be compiled on a PC
+ * by the host tools.
+ */
+
+#ifndef TKJHAT_SOUND_LEVEL_H
+#define TKJHAT_SOUND_LEVEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SOUND_LEVEL_BIQUADS                     3
+#define SOUND_LEVEL_COEF_SHIFT                  28      // biquad coefficients are Q28
+#define SOUND_LEVEL_SAMPLE_SHIFT                12      // samples are filtered in Q12
+#define SOUND_LEVEL_RECORD_SIZE                 14      // bytes of ::sound_level_pack
+#define SOUND_LEVEL_NO_LEVEL                    INT16_MIN
+
+/**
+ * @brief Time weighting used for Lmax / Lmin and ::sound_level_current.
+ */
+typedef enum {
+    SOUND_LEVEL_FAST = 0,       ///< 125 ms
+    SOUND_LEVEL_SLOW = 1,       ///< 1 s
+} sound_level_weighting_t;
+
+/**
+ * @brief Meter settings.
+ */
+typedef struct {
+    uint32_t sample_rate;                   ///< PCM sample rate in Hz
+    uint32_t interval_ms;                   ///< Length of a Leq / Lmax / Lmin interval
+    int16_t  calibration_cdb;               ///< Offset added to every level (centi-dB)
+    sound_level_weighting_t max_min;        ///< Time weighting of Lmax / Lmin
+} sound_level_config_t;
+
+#define SOUND_LEVEL_DEFAULT_CONFIG {            \
+    .sample_rate     = 8000,                    \
+    .interval_ms     = 10000,                   \
+    .calibration_cdb = 0,                       \
+    .max_min         = SOUND_LEVEL_FAST,        \
+}
+
+/**
+ * @brief Result of one interval. Levels in centi-dB, calibrated.
+ */
+typedef struct {
+    uint32_t seq;               ///< Interval number since init
+    uint32_t duration_ms;       ///< Audio covered by the interval
+    int16_t  leq_cdb;           ///< Equivalent continuous level (LAeq)
+    int16_t  lmax_cdb;          ///< Highest time-weighted level
+    int16_t  lmin_cdb;          ///< Lowest time-weighted level, ::SOUND_LEVEL_NO_LEVEL if still settling
+} sound_level_report_t;
+
+/**
+ * @brief Receives a report at the end of each interval, from the context
+ *        that called ::sound_level_process.
+ */
+typedef void (*sound_level_sink_t)(const sound_level_report_t *report, void *ctx);
+
+/**
+ * @brief Direct form I biquad with error feedback. Internal.
+ */
+typedef struct {
+    int32_t b0, b1, b2, a1, a2;             ///< Q28
+    int32_t x1, x2, y1, y2;                 ///< Q12 samples
+    int64_t err;                            ///< Rounding residue fed back
+} sound_level_biquad_t;
+
+/**
+ * @brief Meter state. Treat as opaque.
+ */
+typedef struct {
+    sound_level_config_t cfg;
+    sound_level_sink_t sink;
+    void *ctx;
+
+    sound_level_biquad_t bq[SOUND_LEVEL_BIQUADS];
+    uint8_t  shift[2];                      ///< Fast / Slow time constants as shifts
+    uint64_t ms[2];                         ///< Fast / Slow mean square (Q24)
+    uint32_t settle;                        ///< Samples until Lmin is meaningful
+    int32_t  ref_cdb;                       ///< Level of a full-scale sine, uncalibrated
+
+    uint64_t energy[2];                     ///< Interval sum of squares, 128-bit (lo, hi)
+    uint64_t ms_max, ms_min;
+    uint32_t count;                         ///< Samples in the current interval
+    uint32_t interval_samples;
+    uint32_t seq;
+} sound_level_t;
+
+/**
+ * @brief Design the A-weighting filter for @p cfg->sample_rate and reset.
+ *
+ * @param sink Receives the interval reports. May be @c NULL when only
+ *             ::sound_level_current is used.
+ * @return 0 on success, negative value if the configuration is invalid.
+ */
+int sound_level_init(sound_level_t *sl, const sound_level_config_t *cfg,
+                     sound_level_sink_t sink, void *ctx);
+
+/**
+ * @brief Feed one block of decoded samples. Calls the sink whenever an
+ *        interval completes (possibly more than once for long blocks).
+ */
+void sound_level_process(sound_level_t *sl, const int16_t *pcm, size_t n);
+
+/**
+ * @brief Current A-weighted, time-weighted level in centi-dB.
+ */
+int16_t sound_level_current(const sound_level_t *sl, sound_level_weighting_t w);
+
+/**
+ * @brief Adjust the calibration so that the current Slow level reads
+ *        @p known_cdb (e.g. 9400 with a 94 dB calibrator running for a few
+ *        seconds).
+ *
+ * @return The new calibration offset in centi-dB.
+ */
+int16_t sound_level_calibrate(sound_level_t *sl, int16_t known_cdb);
+
+/**
+ * @brief Serialise @p r into ::SOUND_LEVEL_RECORD_SIZE little-endian bytes
+ *        (seq, duration_ms, leq, lmax, lmin), e.g. as a ::uart_link_send payload.
+ *
+ * @return Number of bytes written.
+ */
+size_t sound_level_pack(const sound_level_report_t *r, uint8_t *out);
+
+/**
+ * @brief Format @p r as one text line ("LAeq 54.31 Lmax 67.02 Lmin 41.50 dB / 60.0 s\n").
+ *
+ * @return Number of characters written (excluding the terminator).
+ */
+int sound_level_format_report(const sound_level_report_t *r, char *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TKJHAT_SOUND_LEVEL_H */
@@ -0,0 +1,161 @@
+/*
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 , Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+
+/**
+ * @file tkjhat/sram.h
+ * @brief Bank-aware SRAM placement for DMA buffers, task stacks and hot data.
+ *
+ * @details
+ * The RP2040 has four 64 KB main SRAM banks and two 4 KB scratch banks, each
+ * with its own bus port. By default the main banks are used through the
+ * striped alias, so the PDM DMA, the USB buffers and both cores all touch all
+ * four banks and stall each other.
+ *
+ * With the CMake option @c TKJHAT_BANKED_SRAM enabled and the executable
+ * linked with @c tkjhat_sram_layout(<target>), the memory map becomes:
+ *
+ * | Bank      | Contents                                                  |
+ * |-----------|-----------------------------------------------------------|
+ * | SRAM0-2   | code in RAM, data, bss, FreeRTOS heap                     |
+ * | SRAM3     | ::TKJHAT_DMA_BUFFER variables, ::sram_dma_alloc arena     |
+ * | SCRATCH_X | core 1 interrupt stack, ::TKJHAT_CORE1_DATA, core 1 arena |
+ * | SCRATCH_Y | core 0 interrupt stack, ::TKJHAT_CORE0_DATA, core 0 arena |
+ *
+ * The SDK uses it for the microphone raw buffers, the UART link rings and
+ * the TinyUSB buffers. Without the option every macro and function below
+ * falls back to the normal placement, so code can use them unconditionally.
+ *
+ * ### Typical usage
+ * @code
+ * static int16_t pcm[256] TKJHAT_CORE0_DATA;     // decimated by a core 0 task
+ *
+ * int main(void) {
+ *     uint8_t *frame = sram_dma_alloc(1024, 4);   // DMA'd by a peripheral
+ *     sram_task_create_on_core(audio_task, "audio", 256, NULL, 3, 0, NULL);
+ *     vTaskStartScheduler();
+ * }
+ * @endcode
+ *
+ * @note RP2040 only. The RP2350 has ten banks and a different map.
+ * @note Each scratch bank also holds the 2 KB interrupt stack of its core
+ *       (PICO_STACK_SIZE / PICO_CORE1_STACK_SIZE); the linker fails if the
+ *       per-core data and arena do not fit in the rest.
+ */
+
+#ifndef TKJHAT_SRAM_H
+#define TKJHAT_SRAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "pico/platform.h"
+
+/* =========================
+ *  Configuration
+ * ========================= */
+#ifndef TKJHAT_BANKED_SRAM
+#define TKJHAT_BANKED_SRAM              0
+#endif
+#ifndef SRAM_CORE_ARENA_SIZE
+#define SRAM_CORE_ARENA_SIZE            1024    // bytes per scratch bank for pinned stacks / hot data
+#endif
+
+#if TKJHAT_BANKED_SRAM
+/** Place a variable in the DMA bank (SRAM3). Zeroed before main. */
+#define TKJHAT_DMA_BUFFER               __attribute__((section(".dma_buffers")))
+/** Place a variable in core 0's scratch bank (SCRATCH_Y). */
+#define TKJHAT_CORE0_DATA               __scratch_y("tkjhat")
+/** Place a variable in core 1's scratch bank (SCRATCH_X). */
+#define TKJHAT_CORE1_DATA               __scratch_x("tkjhat")
+#else
+#define TKJHAT_DMA_BUFFER
+#define TKJHAT_CORE0_DATA
+#define TKJHAT_CORE1_DATA
+#endif
+
+/**
+ * @brief Allocate a buffer for DMA.
+ *
+ * Taken from the SRAM3 arena in the banked layout, from the heap otherwise.
+ * Arena memory is never reused, so allocate DMA buffers once at init.
+ *
+ * @param size  Size in bytes.
+ * @param align Alignment in bytes (power of two, e.g. the ring size of a
+ *              DMA ring buffer).
+ *
+ * @return Pointer to the buffer, or @c NULL if there is no room.
+ */
+void *sram_dma_alloc(size_t size, size_t align);
+
+/**
+ * @brief Release a buffer from ::sram_dma_alloc.
+ *
+ * Heap buffers are freed; arena buffers are kept (the arena only grows).
+ */
+void sram_dma_free(void *p);
+
+/**
+ * @brief Bytes left in the DMA arena (0 without the banked layout).
+ */
+size_t sram_dma_arena_free(void);
+
+/**
+ * @brief Allocate from the scratch arena of a core.
+ *
+ * @param core Core whose scratch bank to use (0 or 1).
+ * @param size Size in bytes (rounded up to 8).
+ *
+ * @return Pointer, or @c NULL without the banked layout or when the arena
+ *         (::SRAM_CORE_ARENA_SIZE) is exhausted.
+ */
+void *sram_core_alloc(uint core, size_t size);
+
+/**
+ * @brief Create a task pinned to @p core with its stack and TCB in that core's scratch bank.
+ *
+ * Same parameters as @c xTaskCreate plus the core. The task is created with
+ * its affinity already set, and the TCB and stack come from one arena block.
+ * Falls back to a heap stack (still pinned) when the banked layout or static
+ * allocation is not available, or the arena is full.
+ *
+ * @return 0 on success, negative value on error.
+ */
+int sram_task_create_on_core(TaskFunction_t fn, const char *name, uint32_t stack_words,
+                             void *arg, UBaseType_t priority, uint core, TaskHandle_t *out);
+
+/**
+ * @brief @c true when the executable uses the banked memory map.
+ */
+bool sram_banked(void);
+
+#endif /* TKJHAT_SRAM_H */
@@ -135,6 +135,54 @@ void ssd1306_invert(ssd1306_t *p, uint8_t inv);
 */
 void ssd1306_show(ssd1306_t *p);
 
+/**
+	@brief send the buffer to the panel now, bypassing the show filter
+
+	@param[in] p : instance of display
+
+*/
+void ssd1306_flush(ssd1306_t *p);
+
+/**
+	@brief send a whole frame that is not the instance buffer (e.g. straight from flash)
+
+	@param[in] p : instance of display
+	@param[in] data : 0x40 control byte followed by bufsize bytes in the buffer layout
+
+	the buffer and the show filter are left alone; the show hook gets a copy of
+	the instance whose buffer points at the frame (data + 1)
+*/
+void ssd1306_flush_data(ssd1306_t *p, const uint8_t *data);
+
+/**
+	@brief hook called at the end of every ssd1306_show (e.g. display mirroring)
+
+	@param[in] p : instance of display that was just flushed
+*/
+typedef void (*ssd1306_show_hook_t)(const ssd1306_t *p);
+
+/**
+	@brief set the hook called after every ssd1306_show, NULL to remove it
+
+	@param[in] hook : function to call
+*/
+void ssd1306_set_show_hook(ssd1306_show_hook_t hook);
+
+/**
+	@brief filter consulted by every ssd1306_show (e.g. a refresh scheduler)
+
+	@param[in] p : instance of display about to be shown
+	@return true to send the buffer now, false to skip or defer it (the filter then calls ssd1306_flush itself)
+*/
+typedef bool (*ssd1306_show_filter_t)(ssd1306_t *p);
+
+/**
+	@brief set the filter consulted by every ssd1306_show, NULL to remove it
+
+	@param[in] filter : function to call
+*/
+void ssd1306_set_show_filter(ssd1306_show_filter_t filter);
+
 /**
 	@brief clear display buffer
 
@@ -0,0 +1,198 @@
+/*
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 , Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+/**
+ * @file tkjhat/task_monitor.h
+ * @brief Task liveness / starvation monitor with hardware watchdog integration.
+ *
+ * @details
+ * Registered tasks declare how often they check in and, optionally, how much
+ * CPU they may use. A monitor task wakes every window and:
+ *
+ * - flags tasks that missed their check-in period,
+ * - uses the FreeRTOS run-time counters to tell a *starved* task (Ready but it
+ *   got no CPU time in the window) from a task that is simply blocked,
+ * - flags tasks that used more CPU than their declared budget (*overrun*),
+ * - names the task that used most CPU in the window (the hog) and the core it
+ *   was running on.
+ *
+ * The hardware watchdog is fed only while every *critical* task is healthy.
+ * When a critical task fails, a compact ::task_monitor_fault_t is written to
+ * uninitialized RAM, so after the watchdog reset the application can read
+ * why the board rebooted with ::task_monitor_last_fault().
+ *
+ * ### Typical usage
+ * @code
+ * static int sensor_id;
+ *
+ * static void sensor_task(void *arg) {
+ *     sensor_id = task_monitor_register(NULL, 1000, 20, true); // 1 s period, <=20% CPU, critical
+ *     for (;;) {
+ *         // ... work ...
+ *         task_monitor_checkin(sensor_id);
+ *         vTaskDelay(pdMS_TO_TICKS(1000));
+ *     }
+ * }
+ *
+ * int main(void) {
+ *     task_monitor_fault_t f;
+ *     if (task_monitor_last_fault(&f)) {
+ *         // previous boot ended with a watchdog reset caused by f.task
+ *     }
+ *     task_monitor_init(500, 2000);  // check every 500 ms, watchdog 2 s
+ *     // create tasks ...
+ *     vTaskStartScheduler();
+ * }
+ * @endcode
+ *
+ * @note Needs @c configGENERATE_RUN_TIME_STATS and @c configUSE_TRACE_FACILITY
+ *       (both enabled in config/FreeRTOSConfig.h).
+ */
+
+#ifndef TASK_MONITOR_H
+#define TASK_MONITOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+/* =========================
+ *  Configuration
+ * ========================= */
+#ifndef TASK_MONITOR_MAX_TASKS
+#define TASK_MONITOR_MAX_TASKS                  8   // registered (monitored) tasks
+#endif
+#ifndef TASK_MONITOR_MAX_SYSTEM_TASKS
+#define TASK_MONITOR_MAX_SYSTEM_TASKS           24  // tasks sampled from the kernel each window
+#endif
+#ifndef TASK_MONITOR_CHECKIN_TOLERANCE
+#define TASK_MONITOR_CHECKIN_TOLERANCE          2   // a check-in is missed after tolerance * period
+#endif
+#ifndef TASK_MONITOR_PRIORITY
+#define TASK_MONITOR_PRIORITY                   (configMAX_PRIORITIES - 2)
+#endif
+#define TASK_MONITOR_NAME_LEN                   12
+#define TASK_MONITOR_CORE_UNKNOWN               0xFF
+
+/**
+ * @brief Health of a monitored task, also used as the fault reason.
+ */
+typedef enum {
+    TASK_MONITOR_OK = 0,            ///< Checked in on time and within budget
+    TASK_MONITOR_MISSED_CHECKIN,    ///< No check-in within tolerance * period
+    TASK_MONITOR_STARVED,           ///< Ready to run but got no CPU during the window
+    TASK_MONITOR_OVERRUN,           ///< Used more CPU than its declared budget
+} task_monitor_status_t;
+
+/**
+ * @brief Compact fault record kept in uninitialized RAM across resets.
+ */
+typedef struct {
+    uint32_t magic;                         ///< Validity marker
+    uint32_t boot_count;                    ///< Boots since the record was created
+    uint32_t uptime_ms;                     ///< Uptime when the fault was detected
+    uint8_t  reason;                        ///< ::task_monitor_status_t of the failing task
+    uint8_t  hog_core;                      ///< Core of the hog, or TASK_MONITOR_CORE_UNKNOWN
+    uint8_t  hog_cpu_pct;                   ///< CPU share of the hog during the window
+    uint8_t  task_cpu_pct;                  ///< CPU share of the failing task during the window
+    char     task[TASK_MONITOR_NAME_LEN];   ///< Failing task
+    char     hog[TASK_MONITOR_NAME_LEN];    ///< Task that used most CPU in the window
+    uint32_t checksum;                      ///< Checksum of all the previous fields
+} task_monitor_fault_t;
+
+/**
+ * @brief Callback invoked (from the monitor task) when a critical task fails.
+ */
+typedef void (*task_monitor_fault_handler_t)(const task_monitor_fault_t *fault);
+
+/**
+ * @brief Start the monitor task and the hardware watchdog.
+ *
+ * @param window_ms           Evaluation window in milliseconds.
+ * @param watchdog_timeout_ms Hardware watchdog timeout. Must be larger than
+ *                            @p window_ms. Pass 0 to monitor without watchdog.
+ *
+ * @return 0 on success, negative value on error.
+ *
+ * @note Can be called before ::vTaskStartScheduler().
+ */
+int task_monitor_init(uint32_t window_ms, uint32_t watchdog_timeout_ms);
+
+/**
+ * @brief Register a task to be monitored.
+ *
+ * @param task        Task handle, or @c NULL for the calling task.
+ * @param period_ms   Maximum expected time between check-ins. 0 disables
+ *                    the check-in test (only starvation/overrun are checked).
+ * @param max_cpu_pct CPU budget in percent of one core, 0 for no budget.
+ * @param critical    If @c true, a failure of this task stops feeding the watchdog.
+ *
+ * @return Monitor id (>= 0) to use with ::task_monitor_checkin, negative on error.
+ */
+int task_monitor_register(TaskHandle_t task, uint32_t period_ms, uint8_t max_cpu_pct, bool critical);
+
+/**
+ * @brief Report that the task identified by @p id is alive.
+ *
+ * @param id Value returned by ::task_monitor_register.
+ */
+void task_monitor_checkin(int id);
+
+/**
+ * @brief Current health of a monitored task (as of the last window).
+ */
+task_monitor_status_t task_monitor_status(int id);
+
+/**
+ * @brief Register a callback invoked when a critical task fails.
+ */
+void task_monitor_set_fault_handler(task_monitor_fault_handler_t handler);
+
+/**
+ * @brief Fault record left by the previous boot.
+ *
+ * @param out Destination for the record.
+ * @return @c true if the previous boot ended with a watchdog reset and left a
+ *         valid record, @c false otherwise.
+ */
+bool task_monitor_last_fault(task_monitor_fault_t *out);
+
+/**
+ * @brief Write a short text report of the last window into @p buf.
+ *
+ * One line per monitored task plus the hog of the window. Suitable for
+ * ::usb_serial_print() or printf().
+ *
+ * @return Number of characters written (excluding the terminator).
+ */
+int task_monitor_format_report(char *buf, size_t len);
+
+#endif /* TASK_MONITOR_H */
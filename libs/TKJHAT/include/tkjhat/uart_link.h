@@ -0,0 +1,196 @@
+/*
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 , Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+
+/**
+ * @file tkjhat/uart_link.h
+ * @brief DMA-driven UART transport for board-to-board links.
+ *
+ * @details
+ * Runs one of the RP2040 UARTs at multi-megabaud rates with no per-byte CPU work:
+ *
+ * - **RX**: a DMA channel writes continuously into a ring buffer (DMA address
+ *   wrapping). The UART receive-timeout interrupt cannot be used because the
+ *   DMA keeps the FIFO empty, so the end of a burst is detected in software:
+ *   an alarm checks the DMA write pointer every @c idle_us and wakes the link
+ *   task when the line went idle (or the ring is half full). The alarm only
+ *   runs during a burst: a falling edge on the RX pin (first start bit, via
+ *   tkjhat/gpio_irq.h) arms it, and it stops when the line is idle again.
+ * - **TX**: frames are encoded into a TX ring and sent by a second DMA
+ *   channel, re-armed from the DMA completion interrupt.
+ * - **Framing**: ::link_frame_encode / ::link_frame_decode_byte (sync, type,
+ *   sequence number, CRC-16). PING frames are answered automatically with a
+ *   PONG to measure round-trip latency.
+ *
+ * Received DATA frames are delivered to a callback from the link task.
+ *
+ * @code
+ * static void on_frame(const uint8_t *data, size_t len, void *ctx) { ... }
+ *
+ * uart_link_config_t cfg = UART_LINK_DEFAULT_CONFIG;
+ * cfg.rx_handler = on_frame;
+ * uart_link_init(&cfg);
+ * uart_link_send(msg, msg_len, pdMS_TO_TICKS(10));
+ * uart_link_ping();                        // result in uart_link_get_stats()
+ * @endcode
+ *
+ * @note The DMA completion interrupt uses @c DMA_IRQ_1 through a shared handler;
+ *       @c DMA_IRQ_0 is owned by the microphone driver.
+ * @note Both boards must use the same baud rate. Connect TX to RX crosswise and GND.
+ *       Use hardware flow control (@c cts_pin / @c rts_pin) above ~3 Mbaud.
+ */
+
+#ifndef UART_LINK_H
+#define UART_LINK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <FreeRTOS.h>
+
+#include <tkjhat/pins.h>
+#include <tkjhat/link_frame.h>
+
+/* =========================
+ *  Configuration
+ * ========================= */
+#ifndef UART_LINK_RX_RING_BITS
+#define UART_LINK_RX_RING_BITS                  11  // 2 KiB RX ring
+#endif
+#ifndef UART_LINK_TX_RING_BITS
+#define UART_LINK_TX_RING_BITS                  11  // 2 KiB TX ring
+#endif
+#ifndef UART_LINK_TASK_PRIORITY
+#define UART_LINK_TASK_PRIORITY                 (configMAX_PRIORITIES - 3)
+#endif
+#define UART_LINK_RX_RING_SIZE                  (1u << UART_LINK_RX_RING_BITS)
+#define UART_LINK_TX_RING_SIZE                  (1u << UART_LINK_TX_RING_BITS)
+#define UART_LINK_PIN_UNUSED                    0xFF
+
+/**
+ * @brief Callback for received DATA frames (called from the link task).
+ */
+typedef void (*uart_link_rx_handler_t)(const uint8_t *data, size_t len, void *ctx);
+
+/**
+ * @brief Link configuration.
+ */
+typedef struct {
+    uint8_t  uart;                      ///< DEFAULT_UART_0 or DEFAULT_UART_1
+    uint8_t  tx_pin;
+    uint8_t  rx_pin;
+    uint8_t  cts_pin;                   ///< UART_LINK_PIN_UNUSED to disable flow control
+    uint8_t  rts_pin;                   ///< UART_LINK_PIN_UNUSED to disable flow control
+    uint32_t baud;
+    uint32_t idle_us;                   ///< Idle-line detection period (while receiving)
+    uart_link_rx_handler_t rx_handler;
+    void    *rx_ctx;
+} uart_link_config_t;
+
+/** UART1 on GP4/GP5 at 3 Mbaud, idle check every 100 us. */
+#define UART_LINK_DEFAULT_CONFIG { \
+    .uart = DEFAULT_UART_1, .tx_pin = DEFAULT_UART_TX_PIN, .rx_pin = DEFAULT_UART_RX_PIN, \
+    .cts_pin = UART_LINK_PIN_UNUSED, .rts_pin = UART_LINK_PIN_UNUSED, \
+    .baud = 3000000, .idle_us = 100, .rx_handler = NULL, .rx_ctx = NULL }
+
+/**
+ * @brief Link counters.
+ */
+typedef struct {
+    uint32_t baud;              ///< Actual baud rate
+    uint32_t tx_frames;
+    uint64_t tx_bytes;          ///< Bytes on the wire, framing included
+    uint32_t tx_dropped;        ///< Frames not sent because the TX ring stayed full
+    uint32_t rx_frames;
+    uint64_t rx_bytes;          ///< Bytes on the wire, framing included
+    uint32_t rx_crc_errors;
+    uint32_t rx_lost;           ///< Frames missing by sequence number
+    uint32_t rx_resync_bytes;
+    uint32_t rx_overruns;       ///< Bytes overwritten in the RX ring before being read
+    uint32_t uart_errors;       ///< Framing / parity / break / FIFO overrun errors
+    uint32_t idle_events;       ///< Wake-ups of the link task from idle detection
+    uint32_t pings;             ///< PONGs received
+    uint32_t rtt_last_us;
+    uint32_t rtt_min_us;
+    uint32_t rtt_max_us;
+    uint32_t rtt_avg_us;
+    uint32_t tx_bytes_per_s;    ///< Rates over the last ::uart_link_format_report interval
+    uint32_t rx_bytes_per_s;
+} uart_link_stats_t;
+
+/**
+ * @brief Configure the UART, the DMA channels and start the link task.
+ *
+ * On failure every step already done is undone, so the call can be retried.
+ *
+ * @return 0 on success, or
+ *         - -1 @p config is @c NULL or the link is already running
+ *         - -2 unknown UART
+ *         - -3 the TX mutex or semaphore could not be created
+ *         - -4 no free DMA channel, or the DMA_IRQ_1 handler could not be added
+ *         - -5 the link task could not be created
+ *         - -6 the RX pin edge interrupt could not be registered (idle detection)
+ *         - -7 the TX mutex could not be registered with the lock profiler
+ */
+int uart_link_init(const uart_link_config_t *config);
+
+/**
+ * @brief Send @p len bytes as one DATA frame.
+ *
+ * Encodes the frame into the TX ring and returns; the DMA sends it.
+ *
+ * @param wait Ticks to wait for room in the TX ring.
+ * @return 0 on success, negative value on error or timeout.
+ *
+ * @note Thread-safe. Do not call from ISRs.
+ */
+int uart_link_send(const void *data, size_t len, TickType_t wait);
+
+/**
+ * @brief Send a PING. The round-trip time is added to the stats when the PONG arrives.
+ *
+ * @return 0 on success, negative value on error.
+ */
+int uart_link_ping(void);
+
+/**
+ * @brief Copy the link counters.
+ */
+void uart_link_get_stats(uart_link_stats_t *out);
+
+/**
+ * @brief Write a one-line summary of the link counters into @p buf.
+ *
+ * Throughput is computed over the time since the previous call.
+ *
+ * @return Number of characters written (excluding the terminator).
+ */
+int uart_link_format_report(char *buf, size_t len);
+
+#endif /* UART_LINK_H */
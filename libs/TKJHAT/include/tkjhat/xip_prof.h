@@ -0,0 +1,236 @@
+/*
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 , Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+
+
+/**
+ * @file tkjhat/xip_prof.h
+ * @brief XIP flash cache hit rate and stall estimate, per window and per task / ISR.
+ *
+ * @details
+ * Code and constants run from QSPI flash through the 16 KB XIP cache. The XIP
+ * controller counts every cached access (@c CTR_ACC) and every hit
+ * (@c CTR_HIT); a miss stalls the bus master for a whole flash read. A
+ * profiling task reads the counters every window and reports the hit rate,
+ * the misses and an estimate of the time lost in them.
+ *
+ * With the CMake option @c TKJHAT_XIP_PROFILE the counters are also read at
+ * every task switch (FreeRTOS @c traceTASK_SWITCHED_IN, see
+ * config/FreeRTOSConfig.h) and on entry / exit of the TKJHAT interrupt
+ * handlers (GPIO, PDM DMA, asset player DMA, UART link DMA), so the accesses
+ * between two events are credited to the task or ISR that was running. The
+ * report then lists the contexts with most misses: those are the candidates
+ * for @c __not_in_flash_func or a copy into SRAM. Without the option nothing
+ * is traced and only the global figures are reported.
+ *
+ * ### Typical usage
+ * @code
+ * int main(void) {
+ *     // create tasks ...
+ *     xip_prof_start(1000, 5, usb_serial_print);  // 1 s windows, report every 5 s on CDC0
+ *     vTaskStartScheduler();
+ * }
+ * @endcode
+ *
+ * Own interrupt handlers can be traced as well:
+ * @code
+ * static void my_irq(void) {
+ *     XIP_PROF_ISR_ENTER(XIP_PROF_ISR_USER0);
+ *     // ...
+ *     XIP_PROF_ISR_EXIT();
+ * }
+ * @endcode
+ *
+ * @note The cache is shared by both cores and the counters cannot tell which
+ *       core made an access. While both cores run non-idle contexts the
+ *       accesses are split evenly between them; an idle core gets nothing
+ *       while the other one is busy.
+ * @note Interrupt handlers that are not traced (USB, timers, ...) are
+ *       credited to the task they interrupted, and the kernel's own switch
+ *       code to the incoming task.
+ * @note Only cached accesses are counted: the @c XIP_NOCACHE aliases and the
+ *       streaming interface do not touch the counters. DMA reads from the
+ *       cached alias are credited to whatever the CPUs run at the time.
+ * @note The stall time is an estimate: misses × ::XIP_PROF_MISS_CYCLES
+ *       system clock cycles.
+ */
+
+#ifndef TKJHAT_XIP_PROF_H
+#define TKJHAT_XIP_PROF_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* =========================
+ *  Configuration
+ * ========================= */
+#ifndef XIP_PROF_MAX_CONTEXTS
+#define XIP_PROF_MAX_CONTEXTS           24  // "other" + ISRs + tasks
+#endif
+#ifndef XIP_PROF_PRIORITY
+#define XIP_PROF_PRIORITY               2
+#endif
+#ifndef XIP_PROF_MISS_CYCLES
+// One miss refills an 8-byte line: continuous-read quad command with address,
+// mode and dummy bits plus 64 data bits, ~30 SCK at the default clkdiv of 2
+#define XIP_PROF_MISS_CYCLES            60
+#endif
+#define XIP_PROF_NAME_LEN               12
+#define XIP_PROF_REPORT_TOP             8   // contexts listed by ::xip_prof_format_report
+
+/**
+ * @brief Interrupt handlers with their own context.
+ */
+typedef enum {
+    XIP_PROF_ISR_GPIO = 0,          ///< GPIO dispatcher (tkjhat/gpio_irq.h)
+    XIP_PROF_ISR_PDM,               ///< PDM microphone DMA
+    XIP_PROF_ISR_ASSET_PLAY,        ///< Asset player audio DMA
+    XIP_PROF_ISR_UART_LINK,         ///< UART link DMA
+    XIP_PROF_ISR_USER0,             ///< Free for application handlers
+    XIP_PROF_ISR_USER1,             ///< Free for application handlers
+    XIP_PROF_ISR_COUNT
+} xip_prof_isr_t;
+
+/**
+ * @brief Global figures.
+ */
+typedef struct {
+    uint32_t windows;           ///< Windows completed
+    uint32_t window_ms;         ///< Window length
+    uint32_t acc;               ///< Cached accesses in the last window
+    uint32_t hit;               ///< Hits in the last window
+    uint32_t stall_us;          ///< Estimated time lost in misses, last window
+    uint64_t total_acc;         ///< Accesses since ::xip_prof_start
+    uint64_t total_hit;         ///< Hits since ::xip_prof_start
+    uint32_t clears;            ///< Counter clears before saturation
+    uint32_t contexts;          ///< Contexts in use
+    uint32_t untracked;         ///< Tasks that did not fit the table (counted as "other")
+    bool tracing;               ///< Built with TKJHAT_XIP_PROFILE
+} xip_prof_stats_t;
+
+/**
+ * @brief Figures of one task or ISR in the last window.
+ */
+typedef struct {
+    char     name[XIP_PROF_NAME_LEN];   ///< Task name, "isr:..." or "other"
+    bool     isr;                       ///< Interrupt handler context
+    uint32_t acc;                       ///< Accesses credited in the window
+    uint32_t hit;                       ///< Hits credited in the window
+    uint32_t run_us;                    ///< Time the context ran in the window (both cores)
+    uint32_t stall_us;                  ///< Estimated time lost in its misses
+} xip_prof_context_t;
+
+/**
+ * @brief Report sink, e.g. ::usb_serial_print().
+ */
+typedef int (*xip_prof_sink_t)(const char *text);
+
+/**
+ * @brief Clear the counters and start the profiling task.
+ *
+ * @param window_ms    Window length in milliseconds.
+ * @param report_every Send a report every this many windows, 0 for none.
+ * @param sink         Where reports go; may be @c NULL when @p report_every is 0.
+ *
+ * @return 0 on success, negative value on error.
+ *
+ * @note Can be called before ::vTaskStartScheduler(). Tracing starts here:
+ *       task switches before the call are not attributed.
+ */
+int xip_prof_start(uint32_t window_ms, uint32_t report_every, xip_prof_sink_t sink);
+
+/**
+ * @brief @c true when built with @c TKJHAT_XIP_PROFILE (per task / ISR figures).
+ */
+bool xip_prof_tracing(void);
+
+/**
+ * @brief Copy the global figures.
+ */
+void xip_prof_get_stats(xip_prof_stats_t *out);
+
+/**
+ * @brief Copy the per-context figures of the last window, most misses first.
+ *
+ * @return Number of contexts written (at most @p max).
+ */
+size_t xip_prof_get_contexts(xip_prof_context_t *out, size_t max);
+
+/**
+ * @brief Write a text report of the last window into @p buf.
+ *
+ * One summary line plus, when tracing, the ::XIP_PROF_REPORT_TOP contexts
+ * with most misses. Suitable for ::usb_serial_print() or printf().
+ *
+ * @return Number of characters written (excluding the terminator).
+ */
+int xip_prof_format_report(char *buf, size_t len);
+
+/* =========================
+ *  Tracing hooks
+ * ========================= */
+
+/**
+ * @brief Task switch hook, called by the kernel (traceTASK_SWITCHED_IN).
+ */
+void xip_prof_task_switched_in(void *task);
+
+/**
+ * @brief Task deletion hook, called by the kernel (traceTASK_DELETE).
+ */
+void xip_prof_task_deleted(void *task);
+
+/**
+ * @brief Credit the accesses from now on to interrupt handler @p id.
+ * @return Context to give back to ::xip_prof_isr_exit.
+ */
+uint32_t xip_prof_isr_enter(xip_prof_isr_t id);
+
+/**
+ * @brief Give the accesses back to the interrupted context.
+ */
+void xip_prof_isr_exit(uint32_t prev);
+
+#if defined(TKJHAT_XIP_PROFILE) && TKJHAT_XIP_PROFILE
+#define XIP_PROF_ISR_ENTER(id)  uint32_t xip_prof_prev_ = xip_prof_isr_enter(id)
+#define XIP_PROF_ISR_EXIT()     xip_prof_isr_exit(xip_prof_prev_)
+#else
+#define XIP_PROF_ISR_ENTER(id)  ((void)0)
+#define XIP_PROF_ISR_EXIT()     ((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TKJHAT_XIP_PROF_H */
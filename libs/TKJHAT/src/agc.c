@@ -0,0 +1,154 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <tkjhat/agc.h>
+
+#define Q16_ONE                 (1u << 16)
+#define MAX_RAW_GAIN_Q16        (32767u << 8)     // keeps x * gain inside int32
+
+// Nearest power of two (as a shift) to the time constant in samples
+static uint8_t time_shift(uint32_t ms, uint32_t sample_rate) {
+    uint32_t samples = (uint32_t)(((uint64_t)ms * sample_rate + 500) / 1000);
+    uint8_t shift = 0;
+    while (shift < 15 && (1u << shift) + (1u << shift) / 2 < samples) shift++;
+    return shift;
+}
+
+static uint32_t scale_u32(uint32_t v, uint32_t mul, uint32_t div) {
+    uint64_t r = (uint64_t)v * mul / div;
+    return r > UINT32_MAX ? UINT32_MAX : (uint32_t)r;
+}
+
+int agc_init(agc_t *agc, const agc_config_t *cfg) {
+    if (!agc || !cfg) return -1;
+    if (cfg->sample_rate == 0 || cfg->target_level <= 0 || cfg->limit_level <= 0) return -1;
+    if (cfg->min_gain == 0 || cfg->min_gain > cfg->max_gain || cfg->max_gain > 32767) return -1;
+    if (cfg->base_volume == 0 || cfg->max_volume < cfg->base_volume) return -1;
+
+    agc->cfg = *cfg;
+    agc->attack_shift = time_shift(cfg->attack_ms, cfg->sample_rate);
+    agc->release_shift = time_shift(cfg->release_ms, cfg->sample_rate);
+    agc->env = 0;
+    agc->gain = Q16_ONE;
+    agc->volume = cfg->base_volume;
+    agc->blocks = 0;
+    agc->gated_blocks = 0;
+    agc->limited_blocks = 0;
+    agc->clipped_samples = 0;
+    return 0;
+}
+
+void agc_process(agc_t *agc, int16_t *pcm, size_t n, uint16_t volume) {
+    const agc_config_t *cfg = &agc->cfg;
+    if (n == 0) return;
+
+    // Everything is measured in the "gain 1" domain: a block produced with a
+    // larger filter volume is scaled back by base_volume / volume.
+    uint32_t base = cfg->base_volume;
+    uint32_t vol = cfg->feedback ? (volume ? volume : 1u) : base;
+
+    /* ----- pass 1: envelope and peak ----- */
+    int32_t env = (int32_t)scale_u32((uint32_t)agc->env, vol, base);
+    if (env < 0) env = INT32_MAX;
+    const uint8_t as = agc->attack_shift, rs = agc->release_shift;
+    int32_t peak = 0;
+    for (size_t i = 0; i < n; i++) {
+        int32_t a = pcm[i] < 0 ? -(int32_t)pcm[i] : pcm[i];
+        if (a > peak) peak = a;
+        int32_t d = (a << 8) - env;
+        env += d > 0 ? (d >> as) : -((-d) >> rs);
+    }
+    uint32_t env_norm = scale_u32((uint32_t)env, base, vol);
+    agc->env = env_norm > INT32_MAX ? INT32_MAX : (int32_t)env_norm;
+
+    /* ----- gain computer and gate ----- */
+    uint32_t level = env_norm >> 8;
+    uint32_t target;
+    if (level < (uint32_t)cfg->gate_level) {
+        target = (uint32_t)cfg->gate_gain << 8;
+        agc->gated_blocks++;
+    } else {
+        target = level ? ((uint32_t)cfg->target_level << 16) / level : (uint32_t)cfg->max_gain << 8;
+        if (target < (uint32_t)cfg->min_gain << 8) target = (uint32_t)cfg->min_gain << 8;
+        if (target > (uint32_t)cfg->max_gain << 8) target = (uint32_t)cfg->max_gain << 8;
+    }
+
+    uint32_t start = agc->gain;
+    uint32_t gain = target > start ? start + ((target - start) >> AGC_GAIN_RISE_SHIFT) : target;
+
+    /* ----- limiter: the whole block is known, so clamp before applying ----- */
+    uint32_t peak_norm = scale_u32((uint32_t)peak, base, vol);
+    if (peak_norm && (uint64_t)peak_norm * gain > ((uint64_t)cfg->limit_level << 16)) {
+        gain = ((uint32_t)cfg->limit_level << 16) / peak_norm;
+        agc->limited_blocks++;
+    }
+    if (start > gain && peak_norm && (uint64_t)peak_norm * start > ((uint64_t)cfg->limit_level << 16))
+        start = gain;
+
+    /* ----- pass 2: apply the gain (in the domain of this block), ramped ----- */
+    uint32_t g0 = scale_u32(start, base, vol);
+    uint32_t g1 = scale_u32(gain, base, vol);
+    if (g0 > MAX_RAW_GAIN_Q16) g0 = MAX_RAW_GAIN_Q16;
+    if (g1 > MAX_RAW_GAIN_Q16) g1 = MAX_RAW_GAIN_Q16;
+
+    int32_t acc = (int32_t)g0;
+    int32_t step = ((int32_t)g1 - (int32_t)g0) / (int32_t)n;
+    uint32_t clipped = 0;
+    for (size_t i = 0; i < n; i++) {
+        acc += step;
+        int32_t y = ((int32_t)pcm[i] * (acc >> 8) + 128) >> 8;
+        if (y > 32767) {
+            y = 32767;
+            clipped++;
+        } else if (y < -32768) {
+            y = -32768;
+            clipped++;
+        }
+        pcm[i] = (int16_t)y;
+    }
+
+    agc->gain = gain;
+    agc->clipped_samples += clipped;
+    agc->blocks++;
+
+    /* ----- filter volume for the next block ----- */
+    if (cfg->feedback) {
+        uint32_t v = (uint32_t)(((uint64_t)gain * base) >> (16 + AGC_FEEDBACK_HEADROOM_SHIFT));
+        if (v < 1) v = 1;
+        if (v > cfg->max_volume) v = cfg->max_volume;
+        agc->volume = (uint16_t)v;
+    }
+}
+
+uint16_t agc_volume(const agc_t *agc) {
+    return agc->volume;
+}
+
+uint16_t agc_gain(const agc_t *agc) {
+    uint32_t g = agc->gain >> 8;
+    return g > UINT16_MAX ? UINT16_MAX : (uint16_t)g;
+}
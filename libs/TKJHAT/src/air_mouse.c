@@ -0,0 +1,150 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <tkjhat/air_mouse.h>
+
+#include <string.h>
+
+#define NANO                                    1000000000LL
+#define MAX_DT_US                               50000   // longer gaps (first sample after a stall) count as this
+
+static int8_t clamp8(int32_t v) {
+    return (int8_t)(v > 127 ? 127 : v < -127 ? -127 : v);
+}
+
+// Soft dead zone: the rate above the threshold, so motion starts without a jump
+static int32_t deadzone(int32_t v, int32_t dz) {
+    if (v > dz) return v - dz;
+    if (v < -dz) return v + dz;
+    return 0;
+}
+
+void air_mouse_init(air_mouse_t *m, const air_mouse_config_t *cfg) {
+    static const air_mouse_config_t defaults = AIR_MOUSE_DEFAULT_CONFIG;
+    memset(m, 0, sizeof(*m));
+    m->cfg = cfg ? *cfg : defaults;
+    if (m->cfg.axis_x > 2) m->cfg.axis_x = 2;
+    if (m->cfg.axis_y > 2) m->cfg.axis_y = 0;
+    if (m->cfg.sign_x == 0) m->cfg.sign_x = 1;
+    if (m->cfg.sign_y == 0) m->cfg.sign_y = 1;
+    if (m->cfg.tilt_mg == 0) m->cfg.tilt_mg = 1;
+    if (m->cfg.yaw_mdps == 0) m->cfg.yaw_mdps = 1;
+}
+
+void air_mouse_set_mode(air_mouse_t *m, uint8_t mode) {
+    m->cfg.mode = mode;
+    m->rem[0] = m->rem[1] = 0;
+    m->dx = m->dy = 0;
+    memset(m->sent_axes, 0, sizeof(m->sent_axes));
+    m->dirty = false;
+    m->batch = 0;
+}
+
+void air_mouse_update(air_mouse_t *m, uint64_t t_us, const int32_t gyro_mdps[3], const int32_t accel_mg[3],
+                      uint8_t buttons) {
+    const air_mouse_config_t *c = &m->cfg;
+    m->stats.samples++;
+
+    // Offset tracking while still: every axis close to the estimate
+    int32_t rate[3];
+    bool still = c->still_mdps != 0;
+    for (int i = 0; i < 3; i++) {
+        int32_t d = gyro_mdps[i] * 16 - m->bias_q4[i];
+        if (d > c->still_mdps * 16 || d < -(int32_t)c->still_mdps * 16) still = false;
+    }
+    // A slow steady turn also stays close to the estimate for a while: only
+    // a long still period moves it
+    if (!still) m->still_since_us = 0;
+    else if (!m->still_since_us) m->still_since_us = t_us ? t_us : 1;
+    bool settled = still && t_us - m->still_since_us >= AIR_MOUSE_STILL_US;
+    for (int i = 0; i < 3; i++) {
+        if (settled) m->bias_q4[i] += (gyro_mdps[i] * 16 - m->bias_q4[i]) / 256;
+        rate[i] = deadzone(gyro_mdps[i] - m->bias_q4[i] / 16, c->deadzone_mdps);
+    }
+
+    uint64_t dt = m->started ? t_us - m->last_us : 0;
+    if (dt > MAX_DT_US) dt = MAX_DT_US;
+    m->started = true;
+    m->last_us = t_us;
+
+    bool was_dirty = m->dirty;
+    m->buttons = buttons;
+    if (c->mode == AIR_MOUSE_POINTER) {
+        // mdps * us * counts/deg = 1e-9 counts
+        int64_t step[2] = {
+            (int64_t)(c->sign_x * rate[c->axis_x]) * (int64_t)dt * c->counts_per_deg,
+            (int64_t)(c->sign_y * rate[c->axis_y]) * (int64_t)dt * c->counts_per_deg,
+        };
+        for (int i = 0; i < 2; i++) {
+            m->rem[i] += step[i];
+            int64_t whole = m->rem[i] / NANO;
+            m->rem[i] -= whole * NANO;
+            if (i == 0) m->dx += (int32_t)whole;
+            else m->dy += (int32_t)whole;
+        }
+        m->dirty = m->dx || m->dy || m->buttons != m->sent_buttons;
+    } else {
+        m->axes[0] = clamp8(c->sign_x * accel_mg[0] * 127 / c->tilt_mg);
+        m->axes[1] = clamp8(c->sign_y * accel_mg[1] * 127 / c->tilt_mg);
+        m->axes[2] = clamp8((int32_t)((int64_t)c->sign_x * rate[c->axis_x] * 127 / (int64_t)c->yaw_mdps));
+        m->dirty = memcmp(m->axes, m->sent_axes, sizeof(m->axes)) != 0 || m->buttons != m->sent_buttons;
+    }
+    if (m->dirty) {
+        if (!was_dirty) m->pending_us = t_us;
+        m->batch++;
+    }
+}
+
+bool air_mouse_take(air_mouse_t *m, air_mouse_report_t *out) {
+    if (!m->dirty) return false;
+    memset(out, 0, sizeof(*out));
+    out->buttons = m->buttons;
+    out->sample_us = m->pending_us;
+    m->sent_buttons = m->buttons;
+    if (m->cfg.mode == AIR_MOUSE_POINTER) {
+        out->dx = clamp8(m->dx);
+        out->dy = clamp8(m->dy);
+        m->dx -= out->dx;
+        m->dy -= out->dy;
+        m->dirty = m->dx || m->dy;
+        if (m->dirty) m->stats.carried++;
+    } else {
+        out->x = m->axes[0];
+        out->y = m->axes[1];
+        out->rz = m->axes[2];
+        memcpy(m->sent_axes, m->axes, sizeof(m->axes));
+        m->dirty = false;
+    }
+    m->stats.reports++;
+    if (m->batch > 1) m->stats.merged += m->batch - 1;
+    m->batch = m->dirty ? 1 : 0;
+    return true;
+}
+
+void air_mouse_get_stats(const air_mouse_t *m, air_mouse_stats_t *out) {
+    *out = m->stats;
+    for (int i = 0; i < 3; i++) out->bias_mdps[i] = m->bias_q4[i] / 16;
+}
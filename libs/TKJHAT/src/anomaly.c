@@ -0,0 +1,97 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <tkjhat/anomaly.h>
+
+#include <math.h>
+#include <string.h>
+
+void anomaly_init(anomaly_channel_t *ch, const anomaly_config_t *cfg) {
+    static const anomaly_config_t defaults = ANOMALY_DEFAULT_CONFIG;
+    memset(ch, 0, sizeof(*ch));
+    ch->cfg = cfg ? *cfg : defaults;
+    if (ch->cfg.alpha <= 0.0f || ch->cfg.alpha >= 1.0f) ch->cfg.alpha = defaults.alpha;
+}
+
+void anomaly_reset(anomaly_channel_t *ch) {
+    anomaly_config_t cfg = ch->cfg;
+    anomaly_init(ch, &cfg);
+}
+
+float anomaly_std(const anomaly_channel_t *ch) {
+    float sd = sqrtf(ch->var);
+    return sd > ch->cfg.min_std ? sd : ch->cfg.min_std;
+}
+
+static void update_baseline(anomaly_channel_t *ch, float x) {
+    float a = ch->cfg.alpha;
+    float d = x - ch->mean;
+    ch->mean += a * d;
+    ch->var = (1.0f - a) * (ch->var + a * d * d);
+}
+
+uint8_t anomaly_update(anomaly_channel_t *ch, float x, float dt_s) {
+    uint8_t flags = 0;
+
+    if (ch->samples == 0) {
+        // First sample seeds the baseline
+        ch->mean = x;
+        ch->var = 0.0f;
+        ch->prev = x;
+        ch->samples = 1;
+        ch->last_z = 0.0f;
+        ch->last_rate = 0.0f;
+        ch->last_flags = 0;
+        return 0;
+    }
+
+    float sd = anomaly_std(ch);
+    ch->last_z = (x - ch->mean) / sd;
+    ch->last_rate = dt_s > 0.0f ? (x - ch->prev) / dt_s : 0.0f;
+    ch->prev = x;
+    ch->samples++;
+
+    if (ch->samples > ch->cfg.warmup) {
+        if (ch->cfg.z_threshold > 0.0f && fabsf(ch->last_z) > ch->cfg.z_threshold) flags |= ANOMALY_ZSCORE;
+        if (ch->cfg.rate_threshold > 0.0f && fabsf(ch->last_rate) > ch->cfg.rate_threshold) flags |= ANOMALY_RATE;
+    }
+
+    if (flags) {
+        ch->anomalies++;
+        // Freeze the baseline during an event, unless it looks like a new level
+        if (ch->frozen < ch->cfg.max_freeze) {
+            ch->frozen++;
+        } else {
+            update_baseline(ch, x);
+        }
+    } else {
+        ch->frozen = 0;
+        update_baseline(ch, x);
+    }
+    ch->last_flags = flags;
+    return flags;
+}
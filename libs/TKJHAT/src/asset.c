@@ -0,0 +1,273 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <tkjhat/asset.h>
+#include <tkjhat/crc.h>
+
+#include <string.h>
+
+/* =========================
+ *  Index
+ * ========================= */
+int asset_pack_open(asset_pack_t *pack, const void *base, uint32_t size) {
+    memset(pack, 0, sizeof(*pack));
+    const asset_header_t *h = (const asset_header_t *)base;
+    if (!base || ((uintptr_t)base & (ASSET_ALIGN - 1)) || size < sizeof(*h)) return ASSET_ERR_RANGE;
+    if (h->magic != ASSET_MAGIC) return ASSET_ERR_MAGIC;
+    if (h->version != ASSET_VERSION) return ASSET_ERR_VERSION;
+    uint32_t table = (uint32_t)h->count * sizeof(asset_entry_t);
+    if (h->size > size || h->size < sizeof(*h) + table) return ASSET_ERR_RANGE;
+
+    const asset_entry_t *entries = (const asset_entry_t *)(h + 1);
+    if (crc16_ccitt(CRC16_CCITT_INIT, entries, table) != h->index_crc) return ASSET_ERR_CRC;
+    for (uint16_t i = 0; i < h->count; i++) {
+        const asset_entry_t *e = &entries[i];
+        if (e->offset & (ASSET_ALIGN - 1)) return ASSET_ERR_RANGE;
+        if (e->offset < sizeof(*h) + table || e->offset > h->size || e->size > h->size - e->offset)
+            return ASSET_ERR_RANGE;
+    }
+
+    pack->base = (const uint8_t *)base;
+    pack->size = h->size;
+    pack->entries = entries;
+    pack->count = h->count;
+    return 0;
+}
+
+const asset_entry_t *asset_find(const asset_pack_t *pack, const char *name) {
+    for (uint16_t i = 0; i < pack->count; i++)
+        if (strncmp(pack->entries[i].name, name, ASSET_NAME_MAX) == 0) return &pack->entries[i];
+    return NULL;
+}
+
+int asset_verify(const asset_pack_t *pack, const asset_entry_t *e) {
+    return crc16_ccitt(CRC16_CCITT_INIT, asset_data(pack, e), e->size) == e->crc ? 0 : ASSET_ERR_CRC;
+}
+
+/* =========================
+ *  Images
+ * ========================= */
+static bool is_image(const asset_entry_t *e) {
+    return e && (e->type == ASSET_IMAGE_RAW || e->type == ASSET_IMAGE_RLE);
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+const uint8_t *asset_frame(const asset_pack_t *pack, const asset_entry_t *e, uint16_t frame, uint32_t *len) {
+    if (!is_image(e) || frame >= e->frames) return NULL;
+    uint32_t table = ((uint32_t)e->frames + 1u) * 4u;
+    if (e->size < table) return NULL;
+    const uint8_t *data = asset_data(pack, e);
+    uint32_t start = get_u32(data + frame * 4u), end = get_u32(data + frame * 4u + 4u);
+    if (start < table || end < start || end > e->size) return NULL;
+    if (len) *len = end - start;
+    return data + start;
+}
+
+// Writes the page-packed image byte by byte, in storage order, into the framebuffer
+typedef struct {
+    uint8_t *fb;
+    int32_t  fb_width, fb_pages;
+    int32_t  x, y;                  // image position
+    uint16_t width;
+    uint8_t  last_mask;             // valid rows of the last page of the image
+    uint16_t pages;
+    uint16_t col, page;             // of the next byte
+} blit_t;
+
+static void blit_put(blit_t *b, uint8_t v) {
+    int32_t fx = b->x + b->col;
+    if (fx >= 0 && fx < b->fb_width) {
+        uint8_t mask = b->page + 1u == b->pages ? b->last_mask : 0xFF;
+        int32_t y0 = b->y + (int32_t)b->page * 8;
+        int32_t tp = y0 >= 0 ? y0 / 8 : -((7 - y0) / 8);    // floor
+        unsigned sh = (unsigned)(y0 - tp * 8);
+        if (tp >= 0 && tp < b->fb_pages) {
+            uint8_t m = (uint8_t)(mask << sh);
+            uint8_t *d = &b->fb[fx + b->fb_width * tp];
+            *d = (uint8_t)((*d & ~m) | ((v << sh) & m));
+        }
+        if (sh && tp + 1 >= 0 && tp + 1 < b->fb_pages) {
+            uint8_t m = (uint8_t)(mask >> (8 - sh));
+            uint8_t *d = &b->fb[fx + b->fb_width * (tp + 1)];
+            *d = (uint8_t)((*d & ~m) | ((v >> (8 - sh)) & m));
+        }
+    }
+    if (++b->col == b->width) {
+        b->col = 0;
+        b->page++;
+    }
+}
+
+int asset_draw(const asset_pack_t *pack, const asset_entry_t *e, uint16_t frame,
+               uint8_t *fb, uint16_t fb_width, uint16_t fb_height, int16_t x, int16_t y) {
+    if (!is_image(e)) return ASSET_ERR_TYPE;
+    uint32_t len;
+    const uint8_t *src = asset_frame(pack, e, frame, &len);
+    if (!src) return ASSET_ERR_RANGE;
+
+    blit_t b = {
+        .fb = fb, .fb_width = fb_width, .fb_pages = (fb_height + 7) / 8,
+        .x = x, .y = y, .width = e->width,
+        .pages = (uint16_t)((e->height + 7u) / 8u),
+        .last_mask = (uint8_t)(e->height % 8u ? (1u << (e->height % 8u)) - 1u : 0xFFu),
+    };
+    uint32_t total = asset_frame_bytes(e);
+    if (total == 0) return 0;
+
+    if (e->type == ASSET_IMAGE_RAW) {
+        if (len != total + 1u || src[0] != ASSET_DATA_CONTROL) return ASSET_ERR_RANGE;
+        for (uint32_t i = 1; i <= total; i++) blit_put(&b, src[i]);
+        return 0;
+    }
+
+    // RLE straight into the framebuffer, no intermediate buffer
+    uint32_t out = 0, i = 0;
+    while (i < len && out < total) {
+        uint8_t n = src[i++];
+        if (n < 128) {
+            uint32_t count = n + 1u;
+            if (i + count > len || out + count > total) return ASSET_ERR_RANGE;
+            for (uint32_t k = 0; k < count; k++) blit_put(&b, src[i + k]);
+            i += count;
+            out += count;
+        } else {
+            uint32_t count = n - 125u;
+            if (i >= len || out + count > total) return ASSET_ERR_RANGE;
+            for (uint32_t k = 0; k < count; k++) blit_put(&b, src[i]);
+            i++;
+            out += count;
+        }
+    }
+    return out == total ? 0 : ASSET_ERR_RANGE;
+}
+
+size_t asset_rle_encode(const uint8_t *src, size_t n, uint8_t *dst, size_t cap) {
+    size_t i = 0, o = 0;
+    while (i < n) {
+        size_t run = 1;
+        while (i + run < n && run < 130 && src[i + run] == src[i]) run++;
+        if (run >= 3) {
+            if (o + 2 > cap) return 0;
+            dst[o++] = (uint8_t)(run + 125);
+            dst[o++] = src[i];
+            i += run;
+            continue;
+        }
+        // Literals up to the next run of 3
+        size_t lit = 0;
+        while (i + lit < n && lit < 128) {
+            if (i + lit + 2 < n && src[i + lit] == src[i + lit + 1] && src[i + lit] == src[i + lit + 2]) break;
+            lit++;
+        }
+        if (o + 1 + lit > cap) return 0;
+        dst[o++] = (uint8_t)(lit - 1);
+        memcpy(dst + o, src + i, lit);
+        o += lit;
+        i += lit;
+    }
+    return o;
+}
+
+size_t asset_rle_decode(const uint8_t *src, size_t n, uint8_t *dst, size_t cap) {
+    size_t i = 0, o = 0;
+    while (i < n) {
+        uint8_t c = src[i++];
+        if (c < 128) {
+            size_t count = c + 1u;
+            if (i + count > n || o + count > cap) return 0;
+            memcpy(dst + o, src + i, count);
+            i += count;
+            o += count;
+        } else {
+            size_t count = c - 125u;
+            if (i >= n || o + count > cap) return 0;
+            memset(dst + o, src[i++], count);
+            o += count;
+        }
+    }
+    return o;
+}
+
+/* =========================
+ *  Audio
+ * ========================= */
+static const int8_t index_table[16] = { -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8 };
+
+static const uint16_t step_table[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+
+int16_t asset_adpcm_decode(asset_adpcm_t *s, uint8_t code) {
+    int32_t step = step_table[s->index];
+    int32_t diff = step >> 3;
+    if (code & 4) diff += step;
+    if (code & 2) diff += step >> 1;
+    if (code & 1) diff += step >> 2;
+    s->predictor += (code & 8) ? -diff : diff;
+    if (s->predictor > 32767) s->predictor = 32767;
+    if (s->predictor < -32768) s->predictor = -32768;
+    int32_t index = (int32_t)s->index + index_table[code & 15];
+    s->index = (uint8_t)(index < 0 ? 0 : index > 88 ? 88 : index);
+    return (int16_t)s->predictor;
+}
+
+uint8_t asset_adpcm_encode(asset_adpcm_t *s, int16_t sample) {
+    int32_t step = step_table[s->index];
+    int32_t diff = (int32_t)sample - s->predictor;
+    uint8_t code = 0;
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+    if (diff >= step) { code |= 4; diff -= step; }
+    step >>= 1;
+    if (diff >= step) { code |= 2; diff -= step; }
+    step >>= 1;
+    if (diff >= step) code |= 1;
+    // Track the decoder exactly
+    asset_adpcm_decode(s, code);
+    return code;
+}
+
+size_t asset_adpcm_decode_pwm(asset_adpcm_t *s, const asset_entry_t *e, const uint8_t *data,
+                              uint32_t first, uint16_t *levels, size_t count) {
+    if (!e || e->type != ASSET_AUDIO_ADPCM || first >= e->samples) return 0;
+    if (count > e->samples - first) count = e->samples - first;
+    if (((uint64_t)first + count + 1u) / 2u > e->size) return 0;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t n = first + (uint32_t)i;
+        uint8_t byte = data[n >> 1];
+        levels[i] = asset_pwm_level(asset_adpcm_decode(s, (n & 1) ? byte >> 4 : byte & 15));
+    }
+    return count;
+}
@@ -0,0 +1,259 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <tkjhat/asset_play.h>
+#include <tkjhat/energy.h>
+#include <tkjhat/hw_res.h>
+#include <tkjhat/pins.h>
+#include <tkjhat/sram.h>
+#include <tkjhat/xip_prof.h>
+
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/pwm.h"
+
+static struct {
+    bool ready;
+    volatile bool playing;
+    bool energy_on;                 // reported to tkjhat/energy.h; updated from tasks only
+    int dma[2];
+    int timer;
+    uint slice;
+    const asset_entry_t *e;
+    const uint8_t *data;
+    uint32_t next;                  // next ADPCM sample to decode
+    volatile int last_block;        // channel playing the end of the clip, -1 until decoded
+    asset_adpcm_t adpcm;
+    asset_play_stats_t stats;
+} ap = { .dma = { -1, -1 }, .timer = -1, .last_block = -1 };
+
+static uint16_t blocks[2][ASSET_PLAY_BLOCK] TKJHAT_DMA_BUFFER;
+
+/* =========================
+ *  Pack in flash
+ * ========================= */
+int asset_flash_open(asset_pack_t *pack) {
+    return asset_pack_open(pack, (const void *)(XIP_BASE + ASSET_FLASH_OFFSET),
+                           PICO_FLASH_SIZE_BYTES - ASSET_FLASH_OFFSET);
+}
+
+// Same flash bytes through the XIP alias that neither looks up nor fills the
+// cache: the DMA streams the clip without evicting the program.
+static const void *no_alloc(const void *p) {
+    uintptr_t a = (uintptr_t)p;
+    if (a >= XIP_BASE && a < XIP_BASE + PICO_FLASH_SIZE_BYTES)
+        return (const void *)(a - XIP_BASE + XIP_NOCACHE_NOALLOC_BASE);
+    return p;   // pack in RAM
+}
+
+/* =========================
+ *  Audio
+ * ========================= */
+// Decodes the next block of the clip into blocks[b], silence after the end.
+// Channel b is idle: it is re-armed here and started by the chain.
+static void refill(int b) {
+    uint32_t t0 = time_us_32();
+    size_t n = asset_adpcm_decode_pwm(&ap.adpcm, ap.e, ap.data, ap.next, blocks[b], ASSET_PLAY_BLOCK);
+    for (size_t i = n; i < ASSET_PLAY_BLOCK; i++) blocks[b][i] = ASSET_PWM_MID;
+    ap.next += (uint32_t)n;
+    if (n && ap.next >= ap.e->samples) ap.last_block = b;
+    dma_channel_set_read_addr(ap.dma[b], blocks[b], false);
+    dma_channel_set_trans_count(ap.dma[b], ASSET_PLAY_BLOCK, false);
+
+    ap.stats.samples += (uint32_t)n;
+    ap.stats.refills++;
+    uint32_t us = time_us_32() - t0;
+    if (us > ap.stats.refill_us_max) ap.stats.refill_us_max = us;
+}
+
+// Called from the interrupt or with it masked
+static void halt(void) {
+    uint32_t mask = 0;
+    for (int b = 0; b < 2; b++) {
+        dma_channel_set_irq1_enabled(ap.dma[b], false);
+        // Break the chain first so that aborting one channel does not start the other
+        dma_channel_config c = dma_get_channel_config(ap.dma[b]);
+        channel_config_set_chain_to(&c, ap.dma[b]);
+        dma_channel_set_config(ap.dma[b], &c, false);
+        mask |= 1u << ap.dma[b];
+    }
+    dma_channel_abort(ap.dma[0]);
+    dma_channel_abort(ap.dma[1]);
+    dma_hw->ints1 = mask;
+
+    pwm_set_enabled(ap.slice, false);
+    gpio_put(BUZZER_PIN, 0);
+    gpio_set_function(BUZZER_PIN, GPIO_FUNC_SIO);
+    ap.playing = false;
+}
+
+// energy_set_state() is not for interrupts: a clip that ended there is
+// reported at the next call from a task.
+static void update_energy(void) {
+    if (ap.energy_on == ap.playing) return;
+    ap.energy_on = ap.playing;
+    energy_set_state(ENERGY_BUZZER, ap.energy_on ? ENERGY_ON : ENERGY_OFF, ap.energy_on ? 128 : 0);
+}
+
+static void dma_irq_handler(void) {
+    XIP_PROF_ISR_ENTER(XIP_PROF_ISR_ASSET_PLAY);
+    for (int b = 0; b < 2; b++) {
+        uint32_t bit = 1u << ap.dma[b];
+        if (!(dma_hw->ints1 & bit)) continue;
+        dma_hw->ints1 = bit;
+        if (!ap.playing) continue;
+        hw_res_dma_note(ap.dma[b], sizeof(blocks[b]));
+        if (ap.last_block == b) {
+            halt();
+            break;
+        }
+        // The other block already ended: the chain restarted this one before the refill
+        if (!dma_channel_is_busy(ap.dma[b ^ 1])) ap.stats.late_refills++;
+        refill(b);
+    }
+    XIP_PROF_ISR_EXIT();
+}
+
+static void release_engines(void) {
+    hw_res_dma_release(ap.dma[0]);
+    hw_res_dma_release(ap.dma[1]);
+    hw_res_dma_timer_release(ap.timer);
+    ap.dma[0] = ap.dma[1] = ap.timer = -1;
+}
+
+int asset_play_init(void) {
+    if (ap.ready) return ASSET_PLAY_ERR_BUSY;
+    ap.dma[0] = hw_res_dma_claim("asset");
+    ap.dma[1] = hw_res_dma_claim("asset");
+    ap.timer = hw_res_dma_timer_claim("asset");
+    if (ap.dma[0] < 0 || ap.dma[1] < 0 || ap.timer < 0) {
+        release_engines();
+        return ASSET_PLAY_ERR_RESOURCE;
+    }
+
+    // 8-bit levels at full speed: 125 MHz / 256 = 488 kHz carrier, far above hearing
+    ap.slice = pwm_gpio_to_slice_num(BUZZER_PIN);
+    pwm_config c = pwm_get_default_config();
+    pwm_config_set_wrap(&c, ASSET_PWM_WRAP);
+    pwm_config_set_clkdiv(&c, 1.0f);
+    pwm_init(ap.slice, &c, false);
+
+    // DMA_IRQ_0 belongs to the microphone
+    if (hw_res_irq_add_shared("asset", DMA_IRQ_1, dma_irq_handler) != 0) {
+        release_engines();
+        return ASSET_PLAY_ERR_RESOURCE;
+    }
+    irq_set_enabled(DMA_IRQ_1, true);
+
+    memset(&ap.stats, 0, sizeof(ap.stats));
+    ap.ready = true;
+    return 0;
+}
+
+int asset_play_start(const asset_pack_t *pack, const asset_entry_t *e) {
+    if (!ap.ready) return ASSET_PLAY_ERR_BUSY;
+    if (!e || (e->type != ASSET_AUDIO_PWM && e->type != ASSET_AUDIO_ADPCM)) return ASSET_ERR_TYPE;
+    if (e->type == ASSET_AUDIO_PWM && e->size < e->samples * 2u) return ASSET_ERR_RANGE;
+    // Timer rate = clk_sys * 1 / den
+    uint32_t den = e->sample_rate ? (clock_get_hz(clk_sys) + e->sample_rate / 2u) / e->sample_rate : 0;
+    if (den == 0 || den > 0xFFFF) return ASSET_PLAY_ERR_RATE;
+
+    asset_play_stop();
+    if (e->samples == 0) return 0;
+    dma_timer_set_fraction((uint)ap.timer, 1, (uint16_t)den);
+
+    ap.e = e;
+    ap.data = asset_data(pack, e);
+    ap.next = 0;
+    ap.last_block = -1;
+    asset_adpcm_init(&ap.adpcm);
+
+    bool adpcm = e->type == ASSET_AUDIO_ADPCM;
+    for (int b = 0; b < 2; b++) {
+        dma_channel_config c = dma_channel_get_default_config(ap.dma[b]);
+        channel_config_set_transfer_data_size(&c, DMA_SIZE_16);     // both halves of CC get the level
+        channel_config_set_read_increment(&c, true);
+        channel_config_set_write_increment(&c, false);
+        channel_config_set_dreq(&c, dma_get_timer_dreq(ap.timer));
+        channel_config_set_chain_to(&c, adpcm ? ap.dma[b ^ 1] : ap.dma[b]);
+        dma_channel_configure(ap.dma[b], &c, &pwm_hw->slice[ap.slice].cc, blocks[b], ASSET_PLAY_BLOCK, false);
+        dma_hw->ints1 = 1u << ap.dma[b];
+        dma_channel_set_irq1_enabled(ap.dma[b], adpcm || b == 0);
+    }
+    if (adpcm) {
+        refill(0);
+        refill(1);
+    } else {
+        // Straight from flash
+        dma_channel_set_read_addr(ap.dma[0], no_alloc(ap.data), false);
+        dma_channel_set_trans_count(ap.dma[0], e->samples, false);
+        ap.last_block = 0;
+        ap.stats.samples += e->samples;
+    }
+
+    pwm_set_gpio_level(BUZZER_PIN, ASSET_PWM_MID);
+    gpio_set_function(BUZZER_PIN, GPIO_FUNC_PWM);
+    pwm_set_enabled(ap.slice, true);
+
+    ap.stats.clips++;
+    ap.playing = true;
+    update_energy();
+    dma_channel_start(ap.dma[0]);
+    return 0;
+}
+
+bool asset_play_busy(void) {
+    update_energy();
+    return ap.playing;
+}
+
+void asset_play_stop(void) {
+    if (!ap.ready) return;
+    uint32_t irq = save_and_disable_interrupts();
+    if (ap.playing) halt();
+    restore_interrupts(irq);
+    update_energy();
+}
+
+void asset_play_deinit(void) {
+    if (!ap.ready) return;
+    asset_play_stop();
+    hw_res_irq_remove(DMA_IRQ_1, dma_irq_handler);
+    release_engines();
+    ap.ready = false;
+}
+
+void asset_play_get_stats(asset_play_stats_t *out) {
+    uint32_t irq = save_and_disable_interrupts();
+    *out = ap.stats;
+    restore_interrupts(irq);
+    update_energy();
+}
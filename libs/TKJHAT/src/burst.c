@@ -0,0 +1,352 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <tkjhat/burst.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+
+#define BURST_STACK_WORDS       1024    // snprintf of floats
+
+// Save/restore spin lock: the channels and statistics are read from other
+// tasks (either core) and may be read before the scheduler starts
+#define LOCK_NUM                (PICO_SPINLOCK_ID_STRIPED_FIRST + 5)
+
+typedef struct {
+    burst_source_t src;
+    char name[BURST_NAME_LEN];
+    anomaly_channel_t ch;
+    uint64_t next_us;                   // next sample
+    uint64_t last_us;                   // previous sample (detector dt)
+} source_t;
+
+typedef struct {
+    uint32_t t_us;                      // low word of time_us_64()
+    uint8_t  source;
+    uint8_t  count;
+    float    v[BURST_MAX_VALUES];
+} record_t;
+
+typedef enum { TRIG_NONE = 0, TRIG_ZSCORE, TRIG_RATE, TRIG_MANUAL } trigger_t;
+
+static struct {
+    source_t sources[BURST_MAX_SOURCES];
+    int count;
+    burst_config_t cfg;
+    burst_sink_fn sink;
+    void *sink_ctx;
+    TaskHandle_t task;
+
+    record_t ring[BURST_RING_SAMPLES];
+    unsigned head;                      // next slot
+    unsigned used;
+
+    volatile bool manual;
+    bool active;
+    uint32_t id;
+    uint64_t start_us;
+    uint64_t trigger_us;
+    uint64_t last_anomaly_us;
+    uint64_t quiet_until_us;
+    uint32_t burst_samples;
+    uint32_t burst_lost;
+    burst_stats_t stats;
+    char line[BURST_LINE_SIZE];
+} bs;
+
+static inline uint32_t lock(void) {
+    return spin_lock_blocking(spin_lock_instance(LOCK_NUM));
+}
+
+static inline void unlock(uint32_t save) {
+    spin_unlock(spin_lock_instance(LOCK_NUM), save);
+}
+
+// Statistics are written by the burst task only; the lock keeps snapshots whole
+static inline void bump(uint32_t *stat) {
+    uint32_t save = lock();
+    (*stat)++;
+    unlock(save);
+}
+
+static const char *const trigger_names[] = { "-", "z", "rate", "manual" };
+
+/* =========================
+ *  Output
+ * ========================= */
+static void emit(int n) {
+    if (n <= 0) return;
+    if ((size_t)n >= sizeof(bs.line)) n = sizeof(bs.line) - 1;
+    if (bs.sink(bs.line, (size_t)n, bs.sink_ctx) < 0) {
+        bs.burst_lost++;
+        bump(&bs.stats.lost);
+    }
+}
+
+static void emit_record(const record_t *r) {
+    int n = snprintf(bs.line, sizeof(bs.line), "%s,%ld", bs.sources[r->source].name,
+                     (long)(int32_t)(r->t_us - (uint32_t)bs.trigger_us));
+    for (unsigned i = 0; i < r->count && n > 0 && (size_t)n < sizeof(bs.line); i++) {
+        n += snprintf(bs.line + n, sizeof(bs.line) - n, ",%.5g", (double)r->v[i]);
+    }
+    if (n > 0 && (size_t)n < sizeof(bs.line) - 1) bs.line[n++] = '\n';
+    emit(n);
+    bs.burst_samples++;
+    bump(&bs.stats.sent);
+}
+
+/* =========================
+ *  Burst state
+ * ========================= */
+static void set_rates(bool burst, uint64_t now) {
+    for (int i = 0; i < bs.count; i++) {
+        source_t *s = &bs.sources[i];
+        if (s->src.set_rate) s->src.set_rate(burst, s->src.ctx);
+        s->next_us = now;               // first sample at the new rate right away
+    }
+}
+
+static void begin_burst(trigger_t why, int source, uint64_t now) {
+    bs.active = true;
+    bs.id++;
+    bump(&bs.stats.bursts);
+    bs.start_us = now;
+    bs.trigger_us = now;
+    bs.last_anomaly_us = now;
+    bs.burst_samples = 0;
+    bs.burst_lost = 0;
+
+    float z = source >= 0 ? bs.sources[source].ch.last_z : 0.0f;
+    emit(snprintf(bs.line, sizeof(bs.line), "#burst,%lu,begin,%lu,%s,%s,%.2f\n",
+                  (unsigned long)bs.id, (unsigned long)(now / 1000),
+                  source >= 0 ? bs.sources[source].name : "-", trigger_names[why], (double)z));
+
+    // Pre-trigger history, oldest first
+    uint32_t window = bs.cfg.pretrigger_ms * 1000u;
+    unsigned first = (bs.head + BURST_RING_SAMPLES - bs.used) % BURST_RING_SAMPLES;
+    for (unsigned k = 0; k < bs.used; k++) {
+        const record_t *r = &bs.ring[(first + k) % BURST_RING_SAMPLES];
+        if ((uint32_t)now - r->t_us <= window) emit_record(r);
+    }
+    bs.used = 0;
+
+    set_rates(true, now);
+}
+
+static void end_burst(uint64_t now) {
+    set_rates(false, now);
+    bs.active = false;
+    bs.quiet_until_us = now + (uint64_t)bs.cfg.cooldown_ms * 1000u;
+    emit(snprintf(bs.line, sizeof(bs.line), "#burst,%lu,end,%lu,%lu,%lu\n",
+                  (unsigned long)bs.id, (unsigned long)(now / 1000),
+                  (unsigned long)bs.burst_samples, (unsigned long)bs.burst_lost));
+}
+
+/* =========================
+ *  Sampling
+ * ========================= */
+// Returns the trigger reason of this sample, TRIG_NONE if it is normal
+static trigger_t take_sample(int i, uint64_t now) {
+    source_t *s = &bs.sources[i];
+    record_t r;
+    int n = s->src.read(r.v, s->src.ctx);
+    if (n <= 0) return TRIG_NONE;
+    if (n > BURST_MAX_VALUES) n = BURST_MAX_VALUES;
+    r.t_us = (uint32_t)now;
+    r.source = (uint8_t)i;
+    r.count = (uint8_t)n;
+    bump(&bs.stats.samples);
+
+    uint8_t flags = 0;
+    unsigned first = s->src.detect_first, cnt = s->src.detect_count;
+    if (cnt && first + cnt <= (unsigned)n) {
+        float x = r.v[first];
+        if (cnt > 1) {
+            float sq = 0.0f;
+            for (unsigned k = first; k < first + cnt; k++) sq += r.v[k] * r.v[k];
+            x = sqrtf(sq);
+        }
+        float dt = s->last_us ? (float)(now - s->last_us) * 1e-6f : 0.0f;
+        uint32_t save = lock();
+        flags = anomaly_update(&s->ch, x, dt);
+        unlock(save);
+    }
+    s->last_us = now;
+
+    if (bs.active) {
+        emit_record(&r);
+    } else {
+        bs.ring[bs.head] = r;
+        bs.head = (bs.head + 1) % BURST_RING_SAMPLES;
+        if (bs.used < BURST_RING_SAMPLES) bs.used++;
+    }
+
+    if (flags & ANOMALY_ZSCORE) return TRIG_ZSCORE;
+    if (flags & ANOMALY_RATE) return TRIG_RATE;
+    return TRIG_NONE;
+}
+
+static void burst_task(void *arg) {
+    (void)arg;
+    set_rates(false, time_us_64());
+
+    for (;;) {
+        uint64_t now = time_us_64();
+        trigger_t why = TRIG_NONE;
+        int who = -1;
+
+        for (int i = 0; i < bs.count; i++) {
+            source_t *s = &bs.sources[i];
+            uint32_t period = bs.active ? s->src.burst_period_ms : s->src.idle_period_ms;
+            if (period == 0 || now < s->next_us) continue;
+            trigger_t t = take_sample(i, now);
+            if (t != TRIG_NONE && why == TRIG_NONE) {
+                why = t;
+                who = i;
+            }
+            // Keep the cadence, but do not try to catch up after a stall
+            s->next_us += (uint64_t)period * 1000u;
+            if (s->next_us <= now) s->next_us = now + (uint64_t)period * 1000u;
+        }
+        if (bs.manual) {
+            bs.manual = false;
+            if (why == TRIG_NONE) why = TRIG_MANUAL;
+        }
+
+        now = time_us_64();
+        if (bs.active) {
+            if (why != TRIG_NONE) bs.last_anomaly_us = now;
+            if (now - bs.last_anomaly_us >= (uint64_t)bs.cfg.burst_ms * 1000u ||
+                now - bs.start_us >= (uint64_t)bs.cfg.max_burst_ms * 1000u) {
+                end_burst(now);
+            }
+        } else if (why != TRIG_NONE) {
+            if (now >= bs.quiet_until_us) {
+                begin_burst(why, who, now);
+            } else {
+                bump(&bs.stats.suppressed);
+            }
+        }
+
+        // Sleep until the next sample is due or a manual trigger arrives
+        uint64_t wake = now + 1000000u;
+        for (int i = 0; i < bs.count; i++) {
+            uint32_t period = bs.active ? bs.sources[i].src.burst_period_ms : bs.sources[i].src.idle_period_ms;
+            if (period && bs.sources[i].next_us < wake) wake = bs.sources[i].next_us;
+        }
+        if (bs.active) {
+            uint64_t end = bs.last_anomaly_us + (uint64_t)bs.cfg.burst_ms * 1000u;
+            if (end < wake) wake = end;
+        }
+        now = time_us_64();
+        TickType_t ticks = wake > now ? pdMS_TO_TICKS((uint32_t)((wake - now + 999u) / 1000u)) : 0;
+        ulTaskNotifyTake(pdTRUE, ticks ? ticks : 1);
+    }
+}
+
+/* =========================
+ *  API
+ * ========================= */
+int burst_add_source(const burst_source_t *src) {
+    if (!src || !src->read || bs.task || bs.count >= BURST_MAX_SOURCES) return -1;
+    if (src->detect_count > BURST_MAX_VALUES || src->detect_first + src->detect_count > BURST_MAX_VALUES) return -2;
+
+    source_t *s = &bs.sources[bs.count];
+    s->src = *src;
+    strncpy(s->name, src->name ? src->name : "?", BURST_NAME_LEN - 1);
+    s->name[BURST_NAME_LEN - 1] = '\0';
+    anomaly_init(&s->ch, &src->detect);
+    return bs.count++;
+}
+
+int burst_init(const burst_config_t *cfg, burst_sink_fn sink, void *ctx) {
+    static const burst_config_t defaults = BURST_DEFAULT_CONFIG;
+    if (!sink || bs.task) return -1;
+    bs.cfg = cfg ? *cfg : defaults;
+    bs.sink = sink;
+    bs.sink_ctx = ctx;
+    if (xTaskCreate(burst_task, "burst", BURST_STACK_WORDS, NULL, BURST_PRIORITY, &bs.task) != pdPASS) {
+        bs.task = NULL;
+        return -2;
+    }
+    return 0;
+}
+
+void burst_trigger(void) {
+    bs.manual = true;
+    if (bs.task) xTaskNotifyGive(bs.task);
+}
+
+bool burst_active(void) {
+    return bs.active;
+}
+
+int burst_get_channel(int id, anomaly_channel_t *out) {
+    if (id < 0 || id >= bs.count || !out) return -1;
+    uint32_t save = lock();
+    *out = bs.sources[id].ch;
+    unlock(save);
+    return 0;
+}
+
+void burst_get_stats(burst_stats_t *out) {
+    uint32_t save = lock();
+    *out = bs.stats;
+    unlock(save);
+}
+
+int burst_format_report(char *buf, size_t len) {
+    if (!buf || len == 0) return 0;
+    buf[0] = '\0';
+
+    burst_stats_t st;
+    burst_get_stats(&st);
+    size_t pos = 0;
+    int n = snprintf(buf, len, "[burst] %s bursts=%lu samples=%lu sent=%lu lost=%lu suppressed=%lu\n",
+                     bs.active ? "ACTIVE" : "idle",
+                     (unsigned long)st.bursts, (unsigned long)st.samples, (unsigned long)st.sent,
+                     (unsigned long)st.lost, (unsigned long)st.suppressed);
+    if (n > 0) pos = (size_t)n;
+
+    for (int i = 0; i < bs.count && pos < len; i++) {
+        anomaly_channel_t ch;
+        burst_get_channel(i, &ch);
+        n = snprintf(buf + pos, len - pos, "[burst] %-*s mean=%.4g sd=%.3g z=%+.2f anomalies=%lu\n",
+                     BURST_NAME_LEN - 1, bs.sources[i].name, (double)ch.mean,
+                     (double)anomaly_std(&ch), (double)ch.last_z, (unsigned long)ch.anomalies);
+        if (n < 0) break;
+        pos += (size_t)n;
+    }
+    return (int)(pos < len ? pos : len - 1);
+}
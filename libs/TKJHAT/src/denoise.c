@@ -0,0 +1,261 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <math.h>
+#include <string.h>
+
+#include <tkjhat/denoise.h>
+
+#define N                       DENOISE_FFT_SIZE
+#define HOP                     DENOISE_HOP
+#define BINS                    DENOISE_BINS
+#define FFT_HEADROOM            (1 << 14)       // largest |value| allowed into a butterfly stage
+#define POWER_FRAC_BITS         8               // absolute powers are stored with 8 fraction bits
+#define SNR_MAX_Q8              65535u          // a posteriori SNR cap (~24 dB), keeps products in 32 bits
+#define SMOOTH_SHIFT            1               // power smoothing between frames (alpha 1/2)
+#define PI                      3.14159265358979323846
+
+/* =========================
+ *  Shared tables
+ * ========================= */
+static int16_t s_cos[N / 2];                    // Q15 twiddles, cos and -sin of 2*pi*k/N
+static int16_t s_sin[N / 2];
+static int16_t s_window[N];                     // Q15 square-root Hann (periodic)
+static uint8_t s_bitrev[N];
+static uint8_t s_tables_ready;
+
+static int16_t q15(double v) {
+    long r = lround(v * 32768.0);
+    return (int16_t)(r > 32767 ? 32767 : r < -32768 ? -32768 : r);
+}
+
+static void build_tables(void) {
+    if (s_tables_ready) return;
+    for (unsigned k = 0; k < N / 2; k++) {
+        s_cos[k] = q15(cos(2.0 * PI * k / N));
+        s_sin[k] = q15(-sin(2.0 * PI * k / N));
+    }
+    for (unsigned n = 0; n < N; n++) {
+        s_window[n] = q15(sin(PI * n / N));
+        unsigned r = 0;
+        for (unsigned b = 0; b < DENOISE_FFT_BITS; b++) r |= ((n >> b) & 1u) << (DENOISE_FFT_BITS - 1 - b);
+        s_bitrev[n] = (uint8_t)r;
+    }
+    s_tables_ready = 1;
+}
+
+/* =========================
+ *  Block floating point FFT
+ * ========================= */
+static uint32_t max_abs(const int32_t *re, const int32_t *im) {
+    uint32_t m = 0;
+    for (unsigned i = 0; i < N; i++) {
+        uint32_t a = (uint32_t)(re[i] < 0 ? -re[i] : re[i]);
+        uint32_t b = (uint32_t)(im[i] < 0 ? -im[i] : im[i]);
+        m |= a | b;
+    }
+    return m;
+}
+
+static void scale(int32_t *re, int32_t *im, int shift) {
+    if (shift > 0) {
+        for (unsigned i = 0; i < N; i++) { re[i] <<= shift; im[i] <<= shift; }
+    } else if (shift < 0) {
+        for (unsigned i = 0; i < N; i++) { re[i] >>= -shift; im[i] >>= -shift; }
+    }
+}
+
+// Forward complex FFT in place. Returns the exponent e: true result = buffer * 2^e.
+static int fft(int32_t *re, int32_t *im) {
+    // Normalise so the largest value lies in [2^13, 2^14)
+    uint32_t m = max_abs(re, im);
+    if (m == 0) return 0;
+    int e = 0;
+    while (m >= FFT_HEADROOM) { m >>= 1; e++; }
+    while (m < FFT_HEADROOM / 2) { m <<= 1; e--; }
+    scale(re, im, -e);
+
+    for (unsigned i = 0; i < N; i++) {
+        unsigned j = s_bitrev[i];
+        if (j > i) {
+            int32_t t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+
+    // Inputs below 2^14 grow to at most (1 + sqrt 2) * 2^14 per stage; the
+    // next stage is halved first when that happened.
+    m = FFT_HEADROOM / 2;
+    for (unsigned half = 1, step = N / 2; half < N; half <<= 1, step >>= 1) {
+        if (m >= FFT_HEADROOM) { scale(re, im, -1); e++; }
+        m = 0;
+        for (unsigned k = 0; k < half; k++) {
+            int32_t wr = s_cos[k * step], wi = s_sin[k * step];
+            for (unsigned i = k; i < N; i += half << 1) {
+                unsigned j = i + half;
+                int32_t tr = (wr * re[j] - wi * im[j]) >> 15;
+                int32_t ti = (wr * im[j] + wi * re[j]) >> 15;
+                int32_t ar = re[i], ai = im[i];
+                re[i] = ar + tr; im[i] = ai + ti;
+                re[j] = ar - tr; im[j] = ai - ti;
+                m |= (uint32_t)(re[i] < 0 ? -re[i] : re[i]) | (uint32_t)(im[i] < 0 ? -im[i] : im[i])
+                   | (uint32_t)(re[j] < 0 ? -re[j] : re[j]) | (uint32_t)(im[j] < 0 ? -im[j] : im[j]);
+            }
+        }
+    }
+    return e;
+}
+
+/* =========================
+ *  Helpers
+ * ========================= */
+static uint64_t shift_u64(uint64_t v, int shift) {
+    if (shift >= 0) return shift >= 64 ? 0 : v << shift;
+    return -shift >= 64 ? 0 : v >> -shift;
+}
+
+// num / den in Q8, saturated at SNR_MAX_Q8. Reduced to a 32-bit division.
+static uint32_t ratio_q8(uint64_t num, uint64_t den) {
+    if (den == 0) return num ? SNR_MAX_Q8 : 0;
+    while (den >= (1u << 16)) { den >>= 1; num >>= 1; }
+    if (den == 0) den = 1;
+    if (num >= ((den * SNR_MAX_Q8) >> 8)) return SNR_MAX_Q8;
+    return (uint32_t)(((uint32_t)num << 8) / (uint32_t)den);
+}
+
+static int16_t sat16(int32_t v) {
+    return (int16_t)(v > 32767 ? 32767 : v < -32768 ? -32768 : v);
+}
+
+// Nearest power of two (as a shift) to the per-frame rise of the noise floor
+static uint8_t rise_shift(uint16_t db_s, uint32_t sample_rate) {
+    // Per-frame growth factor 1 + r with r = ln(10) / 10 * dB/s * HOP / fs
+    double r = 0.2302585 * db_s * HOP / sample_rate;
+    uint8_t shift = 1;
+    while (shift < 15 && ldexp(1.0, -shift) * 0.75 > r) shift++;
+    return shift;
+}
+
+/* =========================
+ *  Public API
+ * ========================= */
+int denoise_init(denoise_t *dn, const denoise_config_t *cfg) {
+    if (!dn || !cfg) return -1;
+    if (cfg->sample_rate == 0 || cfg->noise_rise_db_s == 0 || cfg->over_subtract == 0) return -1;
+    if (cfg->floor_gain == 0 || cfg->floor_gain > 32767 || cfg->dd_alpha > 32767) return -1;
+
+    build_tables();
+    memset(dn, 0, sizeof(*dn));
+    dn->cfg = *cfg;
+    dn->rise_shift = rise_shift(cfg->noise_rise_db_s, cfg->sample_rate);
+    dn->mean_gain = DENOISE_GAIN_ONE - 1;
+    return 0;
+}
+
+static void process_frame(denoise_t *dn) {
+    const denoise_config_t *cfg = &dn->cfg;
+    int32_t *re = dn->re, *im = dn->im;
+
+    /* ----- analysis ----- */
+    for (unsigned n = 0; n < N; n++) {
+        re[n] = ((int32_t)dn->in[n] * s_window[n]) >> 15;
+        im[n] = 0;
+    }
+    int e = fft(re, im);
+
+    /* ----- noise floor and gain per bin ----- */
+    const int pshift = 2 * e + POWER_FRAC_BITS;
+    const uint32_t alpha = cfg->dd_alpha, beta = 32768u - alpha;
+    uint32_t gain_sum = 0;
+    for (unsigned k = 0; k < BINS; k++) {
+        uint32_t p32 = (uint32_t)(re[k] * re[k]) + (uint32_t)(im[k] * im[k]);
+        uint64_t p = shift_u64(p32, pshift);
+
+        uint64_t s = dn->frames ? dn->power[k] - (dn->power[k] >> SMOOTH_SHIFT) + (p >> SMOOTH_SHIFT) : p;
+        dn->power[k] = s;
+        uint64_t nf = dn->noise[k];
+        if (dn->frames == 0 || s < nf) {
+            nf = s;
+        } else {
+            nf += (nf >> dn->rise_shift) + 1;
+            if (nf > s) nf = s;
+        }
+        dn->noise[k] = nf;
+
+        // Wiener gain from the decision-directed a priori SNR (all Q8)
+        uint64_t noise = (nf >> 8) * cfg->over_subtract + (((nf & 0xFF) * cfg->over_subtract) >> 8);
+        uint32_t post = ratio_q8(p, noise);
+        uint32_t inst = post > 256 ? post - 256 : 0;
+        uint32_t prio = (alpha * dn->prev_snr[k] + beta * inst) >> 15;
+        uint32_t g = (prio << 15) / (prio + 256);
+        if (g < cfg->floor_gain) g = cfg->floor_gain;
+        if (g > 32767) g = 32767;
+        dn->prev_snr[k] = (uint16_t)((((g * g) >> 15) * post) >> 15);
+        gain_sum += g;
+
+        re[k] = (re[k] * (int32_t)g) >> 15;
+        im[k] = (im[k] * (int32_t)g) >> 15;
+        if (k != 0 && k != N / 2) {
+            re[N - k] = (re[N - k] * (int32_t)g) >> 15;
+            im[N - k] = (im[N - k] * (int32_t)g) >> 15;
+        }
+    }
+    dn->mean_gain = (uint16_t)(gain_sum / BINS);
+
+    /* ----- synthesis: inverse FFT as conj(FFT(conj X)) / N, then overlap-add ----- */
+    for (unsigned n = 0; n < N; n++) im[n] = -im[n];
+    int oshift = e + fft(re, im) - DENOISE_FFT_BITS;
+    for (unsigned n = 0; n < N; n++) {
+        int32_t y = (re[n] * s_window[n]) >> 15;
+        if (oshift >= 0) {
+            int64_t v = (int64_t)y << (oshift > 31 ? 31 : oshift);
+            y = v > INT32_MAX / 2 ? INT32_MAX / 2 : v < INT32_MIN / 2 ? INT32_MIN / 2 : (int32_t)v;
+        } else {
+            y = -oshift >= 31 ? 0 : (y + (1 << (-oshift - 1))) >> -oshift;
+        }
+        dn->ola[n] += y;
+    }
+    for (unsigned n = 0; n < HOP; n++) {
+        dn->out[n] = sat16(dn->ola[n]);
+        dn->ola[n] = dn->ola[n + HOP];
+        dn->ola[n + HOP] = 0;
+    }
+    memmove(dn->in, dn->in + HOP, HOP * sizeof(dn->in[0]));
+    dn->frames++;
+}
+
+void denoise_process(denoise_t *dn, int16_t *pcm, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        int16_t x = pcm[i];
+        pcm[i] = dn->out[dn->pos];
+        dn->in[HOP + dn->pos] = x;
+        if (++dn->pos == HOP) {
+            process_frame(dn);
+            dn->pos = 0;
+        }
+    }
+}
@@ -0,0 +1,118 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <tkjhat/display_mirror.h>
+#include <tkjhat/fb_delta.h>
+#include <tkjhat/ssd1306.h>
+
+#include <string.h>
+
+#include "pico/stdlib.h"
+
+static struct {
+    display_mirror_sink_t sink;
+    void *ctx;
+    uint16_t keyframe_interval;
+    uint16_t since_keyframe;
+    bool need_keyframe;
+    uint16_t seq;
+    uint64_t encode_us_total;
+    display_mirror_stats_t stats;
+    uint8_t shadow[FB_DELTA_MAX_FB];                        // last frame the host has
+    uint8_t record[FB_MIRROR_OVERHEAD + FB_DELTA_MAX_OPS];
+} mirror;
+
+static void mirror_show_hook(const ssd1306_t *p) {
+    uint32_t t0 = time_us_32();
+    size_t size = p->bufsize;
+    if (!mirror.sink || size > FB_DELTA_MAX_FB) return;
+
+    mirror.stats.frames++;
+
+    bool key = mirror.need_keyframe ||
+               (mirror.keyframe_interval && mirror.since_keyframe >= mirror.keyframe_interval);
+    uint8_t *ops = mirror.record + FB_MIRROR_HEADER_SIZE;
+    size_t ops_len = fb_delta_encode(key ? NULL : mirror.shadow, p->buffer, size, ops);
+
+    if (ops_len == 0 && !key) {
+        mirror.stats.unchanged++;
+    } else {
+        fb_mirror_header_t h = {
+            .flags = key ? FB_MIRROR_FLAG_KEYFRAME : 0,
+            .width = p->width,
+            .height = p->height,
+            .seq = mirror.seq,
+            .time_us = t0,
+            .ops_len = (uint16_t)ops_len,
+        };
+        size_t len = fb_mirror_finish_record(mirror.record, &h);
+
+        if (mirror.sink(mirror.record, len, mirror.ctx)) {
+            memcpy(mirror.shadow, p->buffer, size);
+            mirror.seq++;
+            mirror.stats.records++;
+            mirror.stats.bytes += len;
+            if (key) {
+                mirror.stats.keyframes++;
+                mirror.since_keyframe = 0;
+                mirror.need_keyframe = false;
+            } else {
+                mirror.since_keyframe++;
+            }
+        } else {
+            // The host missed a delta: resynchronise with a keyframe
+            mirror.stats.dropped++;
+            mirror.need_keyframe = true;
+        }
+    }
+
+    uint32_t dt = time_us_32() - t0;
+    mirror.encode_us_total += dt;
+    if (dt > mirror.stats.encode_us_max) mirror.stats.encode_us_max = dt;
+    mirror.stats.encode_us_avg = (uint32_t)(mirror.encode_us_total / mirror.stats.frames);
+}
+
+int display_mirror_start(display_mirror_sink_t sink, void *ctx, uint16_t keyframe_interval) {
+    if (!sink) return -1;
+    ssd1306_set_show_hook(NULL);
+    memset(&mirror, 0, sizeof(mirror));
+    mirror.sink = sink;
+    mirror.ctx = ctx;
+    mirror.keyframe_interval = keyframe_interval;
+    mirror.need_keyframe = true;
+    ssd1306_set_show_hook(mirror_show_hook);
+    return 0;
+}
+
+void display_mirror_stop(void) {
+    ssd1306_set_show_hook(NULL);
+    mirror.sink = NULL;
+}
+
+void display_mirror_get_stats(display_mirror_stats_t *out) {
+    if (out) *out = mirror.stats;
+}
@@ -0,0 +1,192 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <tkjhat/display_sched.h>
+
+#include <string.h>
+
+static const struct {
+    uint32_t lux;               // upper bound of the step
+    uint8_t  contrast;
+} steps[] = {
+    { 5,          16  },
+    { 50,         64  },
+    { 500,        160 },
+    { UINT32_MAX, 255 },
+};
+
+#define STEPS                                   (sizeof(steps) / sizeof(steps[0]))
+
+/* =========================
+ *  Policy
+ * ========================= */
+void display_sched_init(display_sched_t *s, const display_sched_config_t *cfg, uint64_t now_us) {
+    static const display_sched_config_t defaults = DISPLAY_SCHED_DEFAULT_CONFIG;
+    memset(s, 0, sizeof(*s));
+    s->cfg = cfg ? *cfg : defaults;
+    if (s->cfg.min_period_ms == 0) s->cfg.min_period_ms = 1;
+    if (s->cfg.max_period_ms < s->cfg.min_period_ms) s->cfg.max_period_ms = s->cfg.min_period_ms;
+    s->period_ms = s->cfg.max_period_ms;
+    s->powered = true;
+    s->level = STEPS - 1;
+    s->start_us = now_us;
+    s->last_change_us = now_us;
+    s->power_on_us = now_us;
+    s->next_light_us = now_us;
+    s->stats.contrast = steps[s->level].contrast;
+}
+
+uint32_t display_sched_hash(const uint8_t *data, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= data[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static bool due(const display_sched_t *s, uint64_t now_us) {
+    if (!s->pending || now_us - s->pending_us < (uint64_t)s->cfg.settle_ms * 1000u) return false;
+    return !s->flushed_once || now_us - s->last_flush_us >= (uint64_t)s->period_ms * 1000u;
+}
+
+static unsigned power_up(display_sched_t *s, uint64_t now_us) {
+    if (s->powered) return 0;
+    s->powered = true;
+    s->power_on_us = now_us;
+    s->stats.power_ups++;
+    return DISPLAY_SCHED_POWER_ON;
+}
+
+unsigned display_sched_request(display_sched_t *s, uint32_t hash, uint64_t now_us) {
+    s->stats.requests++;
+    if (s->flushed_once && hash == s->shown_hash) {
+        // Drawn back to what the panel shows: nothing to send, not even the pending frame
+        if (s->pending) s->stats.coalesced++;
+        s->pending = false;
+        s->stats.skipped++;
+        return 0;
+    }
+    if (s->pending) {
+        if (hash == s->pending_hash) {
+            s->stats.skipped++;
+            return 0;
+        }
+        s->stats.coalesced++;
+    } else {
+        s->pending = true;
+        s->pending_us = now_us;
+    }
+    s->pending_hash = hash;
+    s->last_change_us = now_us;
+
+    // With a settle time the frame may be half drawn: only ::display_sched_poll sends it
+    if (s->cfg.settle_ms || !due(s, now_us)) return 0;
+    return power_up(s, now_us) | DISPLAY_SCHED_FLUSH;
+}
+
+unsigned display_sched_poll(display_sched_t *s, uint64_t now_us) {
+    unsigned actions = 0;
+    if (s->pending) {
+        if (due(s, now_us)) actions |= power_up(s, now_us) | DISPLAY_SCHED_FLUSH;
+    } else if (s->powered && s->cfg.idle_off_ms &&
+               now_us - s->last_change_us >= (uint64_t)s->cfg.idle_off_ms * 1000u) {
+        s->powered = false;
+        s->stats.on_us += now_us - s->power_on_us;
+        s->stats.power_downs++;
+        actions |= DISPLAY_SCHED_POWER_OFF;
+    }
+    // No point in following the light while the panel is dark
+    if (s->cfg.light_period_ms && s->powered && now_us >= s->next_light_us) {
+        s->next_light_us = now_us + (uint64_t)s->cfg.light_period_ms * 1000u;
+        actions |= DISPLAY_SCHED_READ_LIGHT;
+    }
+    return actions;
+}
+
+void display_sched_flushed(display_sched_t *s, uint32_t hash, uint64_t now_us, uint32_t bus_us) {
+    if (s->flushed_once && s->pending_us >= s->last_flush_us) {
+        // Content changing again right after a flush asks for a faster refresh,
+        // content that stayed static for two periods for a slower one
+        uint64_t gap = s->pending_us - s->last_flush_us, period = (uint64_t)s->period_ms * 1000u;
+        if (gap < period) {
+            s->period_ms /= 2;
+            if (s->period_ms < s->cfg.min_period_ms) s->period_ms = s->cfg.min_period_ms;
+        } else if (gap >= 2 * period) {
+            s->period_ms *= 2;
+            if (s->period_ms > s->cfg.max_period_ms) s->period_ms = s->cfg.max_period_ms;
+        }
+    }
+    s->shown_hash = hash;
+    // A frame drawn during the transfer stays pending
+    if (hash == s->pending_hash) s->pending = false;
+    else s->pending_us = now_us;
+    s->flushed_once = true;
+    s->last_flush_us = now_us;
+    s->stats.flushes++;
+    s->stats.bus_us += bus_us;
+}
+
+unsigned display_sched_external(display_sched_t *s, uint64_t now_us) {
+    // Whatever was pending is covered by the external frame; the next
+    // frame drawn is sent whatever its hash
+    s->pending = false;
+    s->flushed_once = false;
+    s->last_change_us = now_us;
+    return power_up(s, now_us);
+}
+
+int display_sched_light(display_sched_t *s, uint32_t lux) {
+    s->stats.lux = lux;
+    uint64_t margin = s->cfg.hysteresis_pct;
+    unsigned level = s->level;
+    // Up while the reading is clearly above the upper bound of the step,
+    // down while it is clearly below the lower bound
+    while (level + 1 < STEPS && (uint64_t)lux * 100u >= (uint64_t)steps[level].lux * (100u + margin))
+        level++;
+    while (level > 0 && (uint64_t)lux * 100u < (uint64_t)steps[level - 1].lux * (100u - (margin < 100 ? margin : 99)))
+        level--;
+    if (level == s->level) return -1;
+    s->level = (uint8_t)level;
+    s->stats.contrast = steps[level].contrast;
+    s->stats.contrast_changes++;
+    return steps[level].contrast;
+}
+
+int64_t display_sched_due_us(const display_sched_t *s, uint64_t now_us) {
+    if (!s->pending) return -1;
+    uint64_t at = s->pending_us + (uint64_t)s->cfg.settle_ms * 1000u;
+    if (s->flushed_once && s->last_flush_us + (uint64_t)s->period_ms * 1000u > at)
+        at = s->last_flush_us + (uint64_t)s->period_ms * 1000u;
+    return at > now_us ? (int64_t)(at - now_us) : 0;
+}
+
+void display_sched_get_stats(const display_sched_t *s, uint64_t now_us, display_sched_stats_t *out) {
+    *out = s->stats;
+    if (s->powered) out->on_us += now_us - s->power_on_us;
+    out->elapsed_us = now_us - s->start_us;
+    out->period_ms = s->period_ms;
+}
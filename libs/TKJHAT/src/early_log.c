@@ -0,0 +1,231 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <tkjhat/early_log.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "pico/stdlib.h"
+#include "pico/mutex.h"
+#include "pico/stdio/driver.h"
+
+// Weak: the USB stdio driver is only linked into targets built with
+// pico_enable_stdio_usb(<target> 1)
+extern stdio_driver_t stdio_usb __attribute__((weak));
+bool stdio_usb_connected(void) __attribute__((weak));
+
+static struct {
+    stdio_driver_t *usb;                // USB driver we stand in front of
+    mutex_t lock;                       // ring and live state
+    char ring[EARLY_LOG_SIZE];
+    uint32_t head;                      // next write position
+    uint32_t used;                      // bytes held
+    uint32_t dropped_since_replay;
+    uint64_t connected_since_us;        // 0 while disconnected
+    bool live;                          // host connected and ring replayed
+    early_log_stats_t stats;
+} el;
+
+static bool host_connected(void) {
+    return el.usb && stdio_usb_connected && stdio_usb_connected();
+}
+
+/* =========================
+ *  Ring (el.lock held)
+ * ========================= */
+static void ring_put(const char *buf, uint32_t len) {
+    el.stats.buffered += len;
+    if (len > EARLY_LOG_SIZE) {
+        // Only the tail of a huge write fits
+        el.stats.dropped += len - EARLY_LOG_SIZE;
+        el.dropped_since_replay += len - EARLY_LOG_SIZE;
+        buf += len - EARLY_LOG_SIZE;
+        len = EARLY_LOG_SIZE;
+    }
+    if (el.used + len > EARLY_LOG_SIZE) {
+        uint32_t over = el.used + len - EARLY_LOG_SIZE;   // oldest bytes overwritten
+        el.stats.dropped += over;
+        el.dropped_since_replay += over;
+        el.used -= over;
+    }
+    while (len) {
+        uint32_t n = EARLY_LOG_SIZE - el.head;
+        if (n > len) n = len;
+        memcpy(&el.ring[el.head], buf, n);
+        el.head = (el.head + n) % EARLY_LOG_SIZE;
+        el.used += n;
+        buf += n;
+        len -= n;
+    }
+}
+
+static void replay(void) {
+    if (el.dropped_since_replay) {
+        char note[48];
+        int n = snprintf(note, sizeof(note), "[elog] %lu bytes dropped before connect\n",
+                         (unsigned long)el.dropped_since_replay);
+        if (n > 0) el.usb->out_chars(note, n);
+        el.dropped_since_replay = 0;
+    }
+    if (el.used) {
+        uint32_t tail = (el.head + EARLY_LOG_SIZE - el.used) % EARLY_LOG_SIZE;
+        uint32_t first = EARLY_LOG_SIZE - tail;
+        if (first > el.used) first = el.used;
+        el.usb->out_chars(&el.ring[tail], (int)first);
+        if (el.used > first) el.usb->out_chars(el.ring, (int)(el.used - first));
+        el.stats.replayed += el.used;
+        el.stats.replays++;
+        el.used = 0;
+    }
+    if (el.usb->out_flush) el.usb->out_flush();
+}
+
+// Goes live once the host has kept the port open for the settle time
+static void poll(void) {
+    if (!host_connected()) {
+        el.live = false;
+        el.connected_since_us = 0;
+        return;
+    }
+    if (el.live) return;
+    uint64_t now = time_us_64();
+    if (!el.connected_since_us) el.connected_since_us = now;
+    if (now - el.connected_since_us < (uint64_t)EARLY_LOG_SETTLE_MS * 1000u) return;
+    replay();
+    el.live = true;
+}
+
+/* =========================
+ *  stdio driver
+ * ========================= */
+// printf from an interrupt handler must not wait for a task that holds the lock
+static bool lock(void) {
+    if (__get_current_exception()) return mutex_try_enter(&el.lock, NULL);
+    mutex_enter_blocking(&el.lock);
+    return true;
+}
+
+static void early_log_out_chars(const char *buf, int len) {
+    if (len <= 0) return;
+    if (!lock()) {
+        el.stats.dropped += (uint32_t)len;
+        el.dropped_since_replay += (uint32_t)len;
+        return;
+    }
+    poll();
+    if (el.live) {
+        el.usb->out_chars(buf, len);
+    } else {
+        ring_put(buf, (uint32_t)len);
+    }
+    mutex_exit(&el.lock);
+}
+
+static void early_log_out_flush(void) {
+    if (el.live && el.usb->out_flush) el.usb->out_flush();
+}
+
+static int early_log_in_chars(char *buf, int len) {
+    return el.usb->in_chars ? el.usb->in_chars(buf, len) : PICO_ERROR_NO_DATA;
+}
+
+#if PICO_STDIO_ENABLE_IN_CHARS_CALLBACK
+static void early_log_set_chars_available_callback(void (*fn)(void *), void *param) {
+    if (el.usb->set_chars_available_callback) el.usb->set_chars_available_callback(fn, param);
+}
+#endif
+
+static stdio_driver_t early_log_driver = {
+    .out_chars = early_log_out_chars,
+    .out_flush = early_log_out_flush,
+    .in_chars = early_log_in_chars,
+#if PICO_STDIO_ENABLE_IN_CHARS_CALLBACK
+    .set_chars_available_callback = early_log_set_chars_available_callback,
+#endif
+};
+
+static void early_log_task(void *arg) {
+    (void)arg;
+    for (;;) {
+        early_log_connected();
+        vTaskDelay(pdMS_TO_TICKS(EARLY_LOG_POLL_MS));
+    }
+}
+
+/* =========================
+ *  API
+ * ========================= */
+int early_log_init(bool poll_task) {
+    if (el.usb) return -1;
+    if (!&stdio_usb || !stdio_usb_connected) return -2;
+
+    mutex_init(&el.lock);
+    el.usb = &stdio_usb;
+#if PICO_STDIO_ENABLE_CRLF_SUPPORT
+    early_log_driver.crlf_enabled = el.usb->crlf_enabled;
+#endif
+    // Our driver writes to USB itself, after the replay
+    stdio_set_driver_enabled(el.usb, false);
+    stdio_set_driver_enabled(&early_log_driver, true);
+
+    if (poll_task &&
+        xTaskCreate(early_log_task, "elog", 512, NULL, EARLY_LOG_PRIORITY, NULL) != pdPASS) {
+        return -3;
+    }
+    return 0;
+}
+
+bool early_log_connected(void) {
+    if (!el.usb || !lock()) return false;
+    poll();
+    bool live = el.live;
+    mutex_exit(&el.lock);
+    return live;
+}
+
+void early_log_get_stats(early_log_stats_t *out) {
+    if (el.usb) mutex_enter_blocking(&el.lock);
+    *out = el.stats;
+    out->held = el.used;
+    if (el.usb) mutex_exit(&el.lock);
+}
+
+int early_log_format_report(char *buf, size_t len) {
+    if (!buf || len == 0) return 0;
+    early_log_stats_t st;
+    early_log_get_stats(&st);
+    int n = snprintf(buf, len, "[elog] %s buffered=%lu dropped=%lu replayed=%lu replays=%lu held=%lu\n",
+                     el.live ? "live" : "buffering",
+                     (unsigned long)st.buffered, (unsigned long)st.dropped, (unsigned long)st.replayed,
+                     (unsigned long)st.replays, (unsigned long)st.held);
+    if (n < 0) return 0;
+    return (size_t)n < len ? n : (int)len - 1;
+}
@@ -0,0 +1,306 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <tkjhat/energy.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+
+// Save/restore spin lock: usable before the scheduler starts and from both cores
+#define LOCK_NUM                (PICO_SPINLOCK_ID_STRIPED_FIRST + 1)
+
+#if !configGENERATE_RUN_TIME_STATS || !INCLUDE_xTaskGetIdleTaskHandle
+#error "energy needs configGENERATE_RUN_TIME_STATS and INCLUDE_xTaskGetIdleTaskHandle"
+#endif
+
+#define PC_PER_UAH      3600000000ull   // 1 uAh = 3.6 mC = 3.6e9 pC
+
+typedef struct {
+    energy_state_t state;
+    uint8_t level;
+    uint64_t since_us;                  // last time the usage was brought up to date
+    uint64_t time_us[ENERGY_NUM_STATES];
+    uint64_t charge_pc;                 // uA * us
+    energy_probe_t probe;
+} component_t;
+
+// Typical values from the datasheets of the parts on the HAT (uA)
+static energy_current_t currents[ENERGY_NUM_COMPONENTS][ENERGY_NUM_STATES] = {
+    [ENERGY_CPU0]     = { [ENERGY_IDLE] = { 5000, 0 },  [ENERGY_ON] = { 12000, 0 } },
+    [ENERGY_CPU1]     = { [ENERGY_IDLE] = { 5000, 0 },  [ENERGY_ON] = { 12000, 0 } },
+    [ENERGY_IMU]      = { [ENERGY_OFF] = { 4, 0 },      [ENERGY_LOW_POWER] = { 20, 380 },
+                          [ENERGY_ON] = { 200, 350 } },
+    [ENERGY_HDC2021]  = { [ENERGY_ON] = { 1, 0 } },                         // 1 Hz auto-measure
+    [ENERGY_VEML6030] = { [ENERGY_OFF] = { 1, 0 },      [ENERGY_ON] = { 45, 0 } },
+    [ENERGY_OLED]     = { [ENERGY_OFF] = { 10, 0 },     [ENERGY_ON] = { 500, 15000 } },
+    [ENERGY_RGB]      = { [ENERGY_ON] = { 0, 30000 } },                     // 3 x 10 mA
+    [ENERGY_BUZZER]   = { [ENERGY_ON] = { 0, 30000 } },
+    [ENERGY_MIC]      = { [ENERGY_OFF] = { 20, 0 },     [ENERGY_ON] = { 650, 0 } },
+    [ENERGY_USB]      = { [ENERGY_IDLE] = { 2500, 0 },  [ENERGY_ON] = { 5000, 0 } },
+};
+
+static const char *const component_names[ENERGY_NUM_COMPONENTS] = {
+    "cpu0", "cpu1", "imu", "hdc2021", "veml6030", "oled", "rgb", "buzzer", "mic", "usb",
+};
+
+static const char *const state_names[ENERGY_NUM_STATES] = { "off", "idle", "lp", "on" };
+
+static struct {
+    component_t comp[ENERGY_NUM_COMPONENTS];
+    uint32_t period_ms;
+    uint64_t start_us;                  // energy_init() or last reset
+    volatile bool accounting;           // energy_init() has run
+    bool sampling;                      // CPU samples have a valid previous value
+    uint64_t prev_sample_us;
+    configRUN_TIME_COUNTER_TYPE prev_idle[configNUMBER_OF_CORES];
+} en;
+
+static inline uint32_t lock(void) {
+    return spin_lock_blocking(spin_lock_instance(LOCK_NUM));
+}
+
+static inline void unlock(uint32_t save) {
+    spin_unlock(spin_lock_instance(LOCK_NUM), save);
+}
+
+static inline bool is_cpu(energy_component_t c) {
+    return c == ENERGY_CPU0 || c == ENERGY_CPU1;
+}
+
+static inline uint32_t current_ua(energy_component_t c, energy_state_t s, uint8_t level) {
+    const energy_current_t *i = &currents[c][s];
+    return i->base_ua + (uint32_t)(((uint64_t)i->span_ua * level) / 255u);
+}
+
+static void add_time(energy_component_t c, energy_state_t s, uint8_t level, uint64_t us) {
+    component_t *p = &en.comp[c];
+    p->time_us[s] += us;
+    p->charge_pc += (uint64_t)current_ua(c, s, level) * us;
+}
+
+// Called with the lock held
+static void bring_up_to_date(energy_component_t c, uint64_t now) {
+    component_t *p = &en.comp[c];
+    if (now > p->since_us) add_time(c, p->state, p->level, now - p->since_us);
+    p->since_us = now;
+}
+
+/* =========================
+ *  Service task
+ * ========================= */
+static configRUN_TIME_COUNTER_TYPE idle_counter(BaseType_t core) {
+#if configNUMBER_OF_CORES > 1
+    return ulTaskGetRunTimeCounter(xTaskGetIdleTaskHandleForCore(core));
+#else
+    (void)core;
+    return ulTaskGetIdleRunTimeCounter();
+#endif
+}
+
+// Split the time since the last sample of each core into active and idle
+static void sample_cores(void) {
+    uint64_t now = time_us_64();
+    configRUN_TIME_COUNTER_TYPE idle[configNUMBER_OF_CORES];
+    for (BaseType_t core = 0; core < configNUMBER_OF_CORES; core++) idle[core] = idle_counter(core);
+
+    uint32_t save = lock();
+    if (en.sampling) {
+        uint64_t wall = now - en.prev_sample_us;
+        for (BaseType_t core = 0; core < configNUMBER_OF_CORES && core < 2; core++) {
+            energy_component_t c = core == 0 ? ENERGY_CPU0 : ENERGY_CPU1;
+            uint64_t idle_us = (configRUN_TIME_COUNTER_TYPE)(idle[core] - en.prev_idle[core]);
+            if (idle_us > wall) idle_us = wall;
+            add_time(c, ENERGY_IDLE, 0, idle_us);
+            add_time(c, ENERGY_ON, 0, wall - idle_us);
+            // Report the load of the last period as the level
+            en.comp[c].state = idle_us * 2 > wall ? ENERGY_IDLE : ENERGY_ON;
+            en.comp[c].level = wall ? (uint8_t)(((wall - idle_us) * 255u) / wall) : 0;
+            en.comp[c].since_us = now;
+        }
+    }
+    memcpy(en.prev_idle, idle, sizeof(idle));
+    en.prev_sample_us = now;
+    en.sampling = true;
+    unlock(save);
+}
+
+static void poll_probes(void) {
+    for (int c = 0; c < ENERGY_NUM_COMPONENTS; c++) {
+        energy_probe_t probe = en.comp[c].probe;
+        if (!probe || is_cpu((energy_component_t)c)) continue;
+        uint8_t level = en.comp[c].level;
+        energy_state_t s = probe(&level);
+        if (s != en.comp[c].state || level != en.comp[c].level) {
+            energy_set_state((energy_component_t)c, s, level);
+        }
+    }
+}
+
+static void energy_task(void *arg) {
+    (void)arg;
+    TickType_t last_wake = xTaskGetTickCount();
+    for (;;) {
+        sample_cores();
+        poll_probes();
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(en.period_ms));
+    }
+}
+
+/* =========================
+ *  API
+ * ========================= */
+int energy_init(uint32_t period_ms) {
+    if (period_ms == 0 || en.period_ms) return -1;
+    en.period_ms = period_ms;
+    if (xTaskCreate(energy_task, "energy", 512, NULL, ENERGY_PRIORITY, NULL) != pdPASS) {
+        en.period_ms = 0;
+        return -2;
+    }
+
+    // Start accounting now, from the states reported so far
+    uint64_t now = time_us_64();
+    uint32_t save = lock();
+    for (int c = 0; c < ENERGY_NUM_COMPONENTS; c++) en.comp[c].since_us = now;
+    en.start_us = now;
+    en.accounting = true;
+    unlock(save);
+    return 0;
+}
+
+void energy_set_state(energy_component_t c, energy_state_t s, uint8_t level) {
+    if ((unsigned)c >= ENERGY_NUM_COMPONENTS || (unsigned)s >= ENERGY_NUM_STATES || is_cpu(c)) return;
+    if (!en.accounting) {
+        // Nothing is integrated before energy_init(): only remember the state
+        en.comp[c].state = s;
+        en.comp[c].level = level;
+        return;
+    }
+    uint64_t now = time_us_64();
+    uint32_t save = lock();
+    bring_up_to_date(c, now);
+    en.comp[c].state = s;
+    en.comp[c].level = level;
+    unlock(save);
+}
+
+int energy_set_current(energy_component_t c, energy_state_t s, uint32_t base_ua, uint32_t span_ua) {
+    if ((unsigned)c >= ENERGY_NUM_COMPONENTS || (unsigned)s >= ENERGY_NUM_STATES) return -1;
+    uint64_t now = time_us_64();
+    uint32_t save = lock();
+    bring_up_to_date(c, now);   // charge so far used the old value
+    currents[c][s].base_ua = base_ua;
+    currents[c][s].span_ua = span_ua;
+    unlock(save);
+    return 0;
+}
+
+void energy_set_probe(energy_component_t c, energy_probe_t probe) {
+    if ((unsigned)c >= ENERGY_NUM_COMPONENTS) return;
+    en.comp[c].probe = probe;
+}
+
+int energy_get(energy_component_t c, energy_usage_t *out) {
+    if ((unsigned)c >= ENERGY_NUM_COMPONENTS || !out) return -1;
+    uint64_t now = time_us_64();
+    uint32_t save = lock();
+    if (!is_cpu(c)) bring_up_to_date(c, now);
+    const component_t *p = &en.comp[c];
+    out->state = p->state;
+    out->level = p->level;
+    memcpy(out->time_us, p->time_us, sizeof(out->time_us));
+    out->charge_nc = p->charge_pc / 1000u;
+    unlock(save);
+    return 0;
+}
+
+void energy_reset(void) {
+    uint64_t now = time_us_64();
+    uint32_t save = lock();
+    for (int c = 0; c < ENERGY_NUM_COMPONENTS; c++) {
+        component_t *p = &en.comp[c];
+        memset(p->time_us, 0, sizeof(p->time_us));
+        p->charge_pc = 0;
+        p->since_us = now;
+    }
+    en.start_us = now;
+    unlock(save);
+}
+
+/* =========================
+ *  Report
+ * ========================= */
+static unsigned pct(uint64_t part, uint64_t total) {
+    return total ? (unsigned)((part * 100u + total / 2) / total) : 0;
+}
+
+int energy_format_report(char *buf, size_t len) {
+    if (!buf || len == 0) return 0;
+
+    energy_usage_t u[ENERGY_NUM_COMPONENTS];
+    for (int c = 0; c < ENERGY_NUM_COMPONENTS; c++) energy_get((energy_component_t)c, &u[c]);
+
+    size_t pos = 0;
+    int n = snprintf(buf, len, "[energy] %-8s %-4s %4s %4s %4s %4s %9s %10s\n",
+                     "comp", "now", "off%", "idl%", "lp%", "on%", "avg mA", "uAh");
+    if (n > 0) pos += (size_t)n;
+
+    uint64_t total_nc = 0, wall_us = time_us_64() - en.start_us;
+    for (int c = 0; c < ENERGY_NUM_COMPONENTS && pos < len; c++) {
+        uint64_t t = 0;
+        for (int s = 0; s < ENERGY_NUM_STATES; s++) t += u[c].time_us[s];
+        if (t == 0) continue;   // never sampled (e.g. the second core of a single core build)
+        total_nc += u[c].charge_nc;
+
+        uint64_t avg_ua = (u[c].charge_nc * 1000u) / t;
+        uint64_t uah_x10 = (u[c].charge_nc * 10000u) / PC_PER_UAH;
+        n = snprintf(buf + pos, len - pos,
+                     "[energy] %-8s %-4s %4u %4u %4u %4u %5lu.%02lu %8lu.%lu\n",
+                     component_names[c], state_names[u[c].state],
+                     pct(u[c].time_us[ENERGY_OFF], t), pct(u[c].time_us[ENERGY_IDLE], t),
+                     pct(u[c].time_us[ENERGY_LOW_POWER], t), pct(u[c].time_us[ENERGY_ON], t),
+                     (unsigned long)(avg_ua / 1000u), (unsigned long)((avg_ua % 1000u) / 10u),
+                     (unsigned long)(uah_x10 / 10u), (unsigned long)(uah_x10 % 10u));
+        if (n < 0) break;
+        pos += (size_t)n;
+    }
+    if (pos < len) {
+        uint64_t avg_ua = wall_us ? (total_nc * 1000u) / wall_us : 0;
+        uint64_t uah_x10 = (total_nc * 10000u) / PC_PER_UAH;
+        n = snprintf(buf + pos, len - pos, "[energy] total %lu s, avg %lu.%02lu mA, %lu.%lu uAh\n",
+                     (unsigned long)(wall_us / 1000000u),
+                     (unsigned long)(avg_ua / 1000u), (unsigned long)((avg_ua % 1000u) / 10u),
+                     (unsigned long)(uah_x10 / 10u), (unsigned long)(uah_x10 % 10u));
+        if (n > 0) pos += (size_t)n;
+    }
+    return (int)(pos < len ? pos : len - 1);
+}
@@ -0,0 +1,237 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <tkjhat/fb_delta.h>
+#include <tkjhat/crc.h>
+
+#include <string.h>
+
+#define OP_SKIP             0x00
+#define OP_XOR              0x80
+#define OP_FILL             0xC0
+#define OP_KIND_MASK        0xC0
+#define MAX_SKIP            128
+#define MAX_RUN             64
+#define MIN_FILL            3           // shorter runs are cheaper as XOR literals
+
+enum {
+    ST_MAGIC0 = 0,
+    ST_MAGIC1,
+    ST_HEADER,
+    ST_OPS,
+    ST_CRC0,
+    ST_CRC1,
+};
+
+/* =========================
+ *  Delta codec
+ * ========================= */
+static inline uint8_t prev_at(const uint8_t *prev, size_t i) {
+    return prev ? prev[i] : 0;
+}
+
+static size_t run_length(const uint8_t *cur, size_t i, size_t size) {
+    size_t j = i + 1;
+    while (j < size && j - i < MAX_RUN && cur[j] == cur[i]) j++;
+    return j - i;
+}
+
+size_t fb_delta_encode(const uint8_t *prev, const uint8_t *cur, size_t size, uint8_t *out) {
+    size_t o = 0;
+    size_t last_change_end = 0;     // ops length without the trailing skips
+    size_t i = 0;
+
+    if (size > FB_DELTA_MAX_FB) size = FB_DELTA_MAX_FB;
+
+    while (i < size) {
+        if (cur[i] == prev_at(prev, i)) {
+            size_t j = i + 1;
+            while (j < size && j - i < MAX_SKIP && cur[j] == prev_at(prev, j)) j++;
+            out[o++] = (uint8_t)(OP_SKIP | (j - i - 1));
+            i = j;
+            continue;
+        }
+
+        size_t run = run_length(cur, i, size);
+        if (run >= MIN_FILL) {
+            out[o++] = (uint8_t)(OP_FILL | (run - 1));
+            out[o++] = cur[i];
+            i += run;
+            last_change_end = o;
+            continue;
+        }
+
+        // XOR literal until two unchanged bytes or a fill run starts
+        size_t j = i;
+        while (j < size && j - i < MAX_RUN) {
+            if (cur[j] == prev_at(prev, j) &&
+                (j + 1 >= size || cur[j + 1] == prev_at(prev, j + 1))) break;
+            if (j > i && run_length(cur, j, size) > MIN_FILL) break;
+            j++;
+        }
+        out[o++] = (uint8_t)(OP_XOR | (j - i - 1));
+        for (size_t k = i; k < j; k++) out[o++] = cur[k] ^ prev_at(prev, k);
+        i = j;
+        last_change_end = o;
+    }
+    return last_change_end;
+}
+
+int fb_delta_apply(uint8_t *fb, size_t size, const uint8_t *ops, size_t len) {
+    size_t i = 0, o = 0;
+    while (o < len) {
+        uint8_t op = ops[o++];
+        size_t n;
+        switch (op & OP_KIND_MASK) {
+        case OP_XOR:
+            n = (size_t)(op & 0x3F) + 1;
+            if (i + n > size || o + n > len) return -1;
+            for (size_t k = 0; k < n; k++) fb[i++] ^= ops[o++];
+            break;
+        case OP_FILL:
+            n = (size_t)(op & 0x3F) + 1;
+            if (i + n > size || o >= len) return -1;
+            memset(&fb[i], ops[o++], n);
+            i += n;
+            break;
+        default:    // skip
+            n = (size_t)(op & 0x7F) + 1;
+            if (i + n > size) return -1;
+            i += n;
+            break;
+        }
+    }
+    return 0;
+}
+
+/* =========================
+ *  Records
+ * ========================= */
+static void pack_header(uint8_t *h, const fb_mirror_header_t *hdr) {
+    h[0]  = FB_MIRROR_MAGIC0;
+    h[1]  = FB_MIRROR_MAGIC1;
+    h[2]  = hdr->flags;
+    h[3]  = hdr->width;
+    h[4]  = hdr->height;
+    h[5]  = (uint8_t)hdr->seq;
+    h[6]  = (uint8_t)(hdr->seq >> 8);
+    h[7]  = (uint8_t)hdr->time_us;
+    h[8]  = (uint8_t)(hdr->time_us >> 8);
+    h[9]  = (uint8_t)(hdr->time_us >> 16);
+    h[10] = (uint8_t)(hdr->time_us >> 24);
+    h[11] = (uint8_t)hdr->ops_len;
+    h[12] = (uint8_t)(hdr->ops_len >> 8);
+}
+
+static void unpack_header(const uint8_t *h, fb_mirror_header_t *hdr) {
+    hdr->flags   = h[2];
+    hdr->width   = h[3];
+    hdr->height  = h[4];
+    hdr->seq     = (uint16_t)(h[5] | (h[6] << 8));
+    hdr->time_us = (uint32_t)h[7] | ((uint32_t)h[8] << 8) | ((uint32_t)h[9] << 16) | ((uint32_t)h[10] << 24);
+    hdr->ops_len = (uint16_t)(h[11] | (h[12] << 8));
+}
+
+size_t fb_mirror_finish_record(uint8_t *out, const fb_mirror_header_t *header) {
+    pack_header(out, header);
+    size_t body = FB_MIRROR_HEADER_SIZE - 2 + header->ops_len;
+    uint16_t crc = crc16_ccitt(CRC16_CCITT_INIT, out + 2, body);
+    out[2 + body] = (uint8_t)(crc & 0xFF);
+    out[3 + body] = (uint8_t)(crc >> 8);
+    return FB_MIRROR_OVERHEAD + header->ops_len;
+}
+
+void fb_mirror_parser_init(fb_mirror_parser_t *p) {
+    memset(p, 0, sizeof(*p));
+    p->state = ST_MAGIC0;
+}
+
+int fb_mirror_parse_byte(fb_mirror_parser_t *p, uint8_t byte) {
+    switch (p->state) {
+    case ST_MAGIC0:
+        if (byte == FB_MIRROR_MAGIC0) p->state = ST_MAGIC1;
+        else p->resync_bytes++;
+        break;
+
+    case ST_MAGIC1:
+        if (byte == FB_MIRROR_MAGIC1) {
+            p->raw[0] = FB_MIRROR_MAGIC0;
+            p->raw[1] = FB_MIRROR_MAGIC1;
+            p->index = 2;
+            p->state = ST_HEADER;
+        } else if (byte != FB_MIRROR_MAGIC0) {
+            p->resync_bytes += 2;
+            p->state = ST_MAGIC0;
+        } else {
+            p->resync_bytes++;
+        }
+        break;
+
+    case ST_HEADER:
+        p->raw[p->index++] = byte;
+        if (p->index == FB_MIRROR_HEADER_SIZE) {
+            unpack_header(p->raw, &p->header);
+            if (p->header.ops_len > FB_DELTA_MAX_OPS) {
+                p->crc_errors++;
+                p->state = ST_MAGIC0;
+                return -1;
+            }
+            p->crc = crc16_ccitt(CRC16_CCITT_INIT, p->raw + 2, FB_MIRROR_HEADER_SIZE - 2);
+            p->index = 0;
+            p->state = p->header.ops_len ? ST_OPS : ST_CRC0;
+        }
+        break;
+
+    case ST_OPS:
+        p->ops[p->index++] = byte;
+        if (p->index == p->header.ops_len) {
+            p->crc = crc16_ccitt(p->crc, p->ops, p->header.ops_len);
+            p->state = ST_CRC0;
+        }
+        break;
+
+    case ST_CRC0:
+        p->rx_crc = byte;
+        p->state = ST_CRC1;
+        break;
+
+    case ST_CRC1:
+        p->rx_crc |= (uint16_t)byte << 8;
+        p->state = ST_MAGIC0;
+        if (p->rx_crc != p->crc) {
+            p->crc_errors++;
+            return -1;
+        }
+        p->records++;
+        return 1;
+
+    default:
+        p->state = ST_MAGIC0;
+        break;
+    }
+    return 0;
+}
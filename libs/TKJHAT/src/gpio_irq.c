@@ -0,0 +1,230 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <tkjhat/gpio_irq.h>
+#include <tkjhat/xip_prof.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <queue.h>
+
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+
+// Save/restore spin lock: usable before the scheduler starts, and against the
+// dispatcher running on the other core
+#define LOCK_NUM                (PICO_SPINLOCK_ID_STRIPED_FIRST + 2)
+
+typedef struct {
+    volatile gpio_irq_handler_t handler;
+    void *ctx;
+    uint32_t event_mask;
+    bool deferred;
+    gpio_irq_stats_t stats;
+} pin_entry_t;
+
+static pin_entry_t pins[GPIO_IRQ_NUM_PINS];
+static QueueHandle_t deferred_queue;
+
+static inline uint32_t lock(void) {
+    return spin_lock_blocking(spin_lock_instance(LOCK_NUM));
+}
+
+static inline void unlock(uint32_t save) {
+    spin_unlock(spin_lock_instance(LOCK_NUM), save);
+}
+
+static inline void note_handler(pin_entry_t *p, uint32_t us) {
+    uint32_t save = lock();
+    p->stats.handled++;
+    p->stats.handler_total_us += us;
+    if (us > p->stats.handler_max_us) p->stats.handler_max_us = us;
+    unlock(save);
+}
+
+static const char *edge_name(uint32_t mask) {
+    bool rise = mask & GPIO_IRQ_EDGE_RISE, fall = mask & GPIO_IRQ_EDGE_FALL;
+    if (rise && fall) return "both";
+    if (rise) return "rise";
+    if (fall) return "fall";
+    return "level";
+}
+
+/* =========================
+ *  Dispatch
+ * ========================= */
+// The one GPIO callback of the core: the SDK has already acknowledged the edge
+static void gpio_irq_handle(uint gpio, uint32_t events) {
+    uint64_t now = time_us_64();
+    if (gpio >= GPIO_IRQ_NUM_PINS) return;
+    pin_entry_t *p = &pins[gpio];
+
+    // Take the entry and count the edge together; the handler runs unlocked
+    uint32_t save = lock();
+    p->stats.count++;
+    p->stats.last_events = events;
+    p->stats.last_edge_us = now;
+    gpio_irq_handler_t handler = p->handler;
+    void *ctx = p->ctx;
+    bool deferred = p->deferred;
+    unlock(save);
+    if (!handler) return;
+
+    gpio_irq_event_t ev = { .gpio = (uint8_t)gpio, .events = events, .timestamp_us = now };
+    if (deferred) {
+        BaseType_t woken = pdFALSE;
+        if (xQueueSendFromISR(deferred_queue, &ev, &woken) != pdPASS) {
+            save = lock();
+            p->stats.dropped++;
+            unlock(save);
+        }
+        portYIELD_FROM_ISR(woken);
+        return;
+    }
+
+    handler(&ev, ctx);
+    note_handler(p, (uint32_t)(time_us_64() - now));
+}
+
+static void gpio_irq_dispatch(uint gpio, uint32_t events) {
+    XIP_PROF_ISR_ENTER(XIP_PROF_ISR_GPIO);
+    gpio_irq_handle(gpio, events);
+    XIP_PROF_ISR_EXIT();
+}
+
+static void dispatcher_task(void *arg) {
+    (void)arg;
+    gpio_irq_event_t ev;
+    for (;;) {
+        if (xQueueReceive(deferred_queue, &ev, portMAX_DELAY) != pdTRUE) continue;
+        pin_entry_t *p = &pins[ev.gpio];
+        uint64_t start = time_us_64();
+        uint32_t latency = (uint32_t)(start - ev.timestamp_us);
+
+        uint32_t save = lock();
+        gpio_irq_handler_t handler = p->handler;
+        void *ctx = p->ctx;
+        if (handler && latency > p->stats.latency_max_us) p->stats.latency_max_us = latency;
+        unlock(save);
+        if (!handler) continue;     // unregistered while queued
+
+        handler(&ev, ctx);
+        note_handler(p, (uint32_t)(time_us_64() - start));
+    }
+}
+
+static int start_dispatcher(void) {
+    if (deferred_queue) return 0;
+    deferred_queue = xQueueCreate(GPIO_IRQ_QUEUE_LEN, sizeof(gpio_irq_event_t));
+    if (!deferred_queue) return -1;
+    if (xTaskCreate(dispatcher_task, "gpio_irq", GPIO_IRQ_TASK_STACK, NULL,
+                    GPIO_IRQ_TASK_PRIORITY, NULL) != pdPASS) {
+        vQueueDelete(deferred_queue);
+        deferred_queue = NULL;
+        return -2;
+    }
+    return 0;
+}
+
+/* =========================
+ *  API
+ * ========================= */
+int gpio_irq_register(uint gpio, uint32_t event_mask, gpio_irq_handler_t handler, void *ctx, bool deferred) {
+    if (gpio >= GPIO_IRQ_NUM_PINS || !handler || event_mask == 0) return -1;
+    if (deferred && start_dispatcher() != 0) return -2;
+
+    pin_entry_t *p = &pins[gpio];
+    gpio_set_irq_enabled(gpio, p->event_mask, false);
+
+    uint32_t save = lock();
+    p->ctx = ctx;
+    p->event_mask = event_mask;
+    p->deferred = deferred;
+    p->handler = handler;
+    unlock(save);
+
+    // Per core: install the dispatcher and enable the bank interrupt on this core
+    gpio_set_irq_callback(gpio_irq_dispatch);
+    irq_set_enabled(IO_IRQ_BANK0, true);
+    gpio_set_irq_enabled(gpio, event_mask, true);
+    return 0;
+}
+
+int gpio_irq_unregister(uint gpio) {
+    if (gpio >= GPIO_IRQ_NUM_PINS) return -1;
+    pin_entry_t *p = &pins[gpio];
+    gpio_set_irq_enabled(gpio, p->event_mask, false);
+    uint32_t save = lock();
+    p->handler = NULL;
+    p->ctx = NULL;
+    p->event_mask = 0;
+    p->deferred = false;
+    unlock(save);
+    return 0;
+}
+
+int gpio_irq_get_stats(uint gpio, gpio_irq_stats_t *out) {
+    if (gpio >= GPIO_IRQ_NUM_PINS || !out) return -1;
+    uint32_t save = lock();
+    *out = pins[gpio].stats;
+    unlock(save);
+    return 0;
+}
+
+void gpio_irq_reset_stats(void) {
+    uint32_t save = lock();
+    for (int i = 0; i < GPIO_IRQ_NUM_PINS; i++) memset(&pins[i].stats, 0, sizeof(pins[i].stats));
+    unlock(save);
+}
+
+int gpio_irq_format_report(char *buf, size_t len) {
+    if (!buf || len == 0) return 0;
+    buf[0] = '\0';
+    size_t pos = 0;
+    uint64_t now = time_us_64();
+
+    for (uint gpio = 0; gpio < GPIO_IRQ_NUM_PINS && pos < len; gpio++) {
+        const pin_entry_t *p = &pins[gpio];
+        if (!p->handler && p->stats.count == 0) continue;
+
+        gpio_irq_stats_t s;
+        gpio_irq_get_stats(gpio, &s);
+        unsigned long avg = s.handled ? (unsigned long)(s.handler_total_us / s.handled) : 0;
+        unsigned long ago = s.count ? (unsigned long)((now - s.last_edge_us) / 1000u) : 0;
+        int n = snprintf(buf + pos, len - pos,
+                         "[gpio] %2u %-5s %-8s n=%lu drop=%lu run avg=%luus max=%luus lat max=%luus last=%lums ago\n",
+                         gpio, edge_name(p->event_mask),
+                         !p->handler ? "none" : p->deferred ? "deferred" : "isr",
+                         (unsigned long)s.count, (unsigned long)s.dropped, avg,
+                         (unsigned long)s.handler_max_us, (unsigned long)s.latency_max_us, ago);
+        if (n < 0) break;
+        pos += (size_t)n;
+    }
+    return (int)(pos < len ? pos : len - 1);
+}
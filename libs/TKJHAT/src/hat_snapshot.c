@@ -0,0 +1,122 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <tkjhat/hat_snapshot.h>
+#include <tkjhat/sdk.h>
+
+#include <string.h>
+
+#include "hardware/i2c.h"
+#include "pico/stdlib.h"
+
+#define HDC2021_SNAPSHOT_BYTES      4   // TEMP_LOW..HUMIDITY_HIGH
+#define ICM42670_SNAPSHOT_BYTES     14  // TEMP_DATA1..GYRO_DATA_Z0
+
+// IMU scale from the FSR fields (bits 6:5) of ACCEL_CONFIG0 / GYRO_CONFIG0
+static uint8_t accel_shift = 13;        // LSB/g = 1 << shift (+-4 g)
+static uint16_t gyro_lsb_x10 = 1310;    // LSB per dps * 10 (+-250 dps)
+
+// Register select + repeated start + burst read: one bus transaction.
+static bool burst_read(uint8_t addr, uint8_t reg, uint8_t *dst, size_t len) {
+    if (i2c_write_blocking(i2c_default, addr, &reg, 1, true) != 1) return false;
+    return i2c_read_blocking(i2c_default, addr, dst, len, false) == (int)len;
+}
+
+int hat_snapshot_init(void) {
+    // GYRO_CONFIG0 (0x20) and ACCEL_CONFIG0 (0x21) are adjacent: one read.
+    uint8_t cfg[2];
+    if (!burst_read(ICM42670_I2C_ADDRESS, ICM42670_GYRO_CONFIG0_REG, cfg, sizeof cfg)) return -1;
+
+    static const uint16_t gyro_table[4] = { 164, 328, 655, 1310 };     // 2000, 1000, 500, 250 dps
+    uint8_t gyro_fsr = (cfg[0] >> 5) & 0x03;
+    uint8_t accel_fsr = (cfg[1] >> 5) & 0x03;
+    gyro_lsb_x10 = gyro_table[gyro_fsr];
+    accel_shift = (uint8_t)(11 + accel_fsr);                          // 16, 8, 4, 2 g
+    return 0;
+}
+
+uint32_t hat_snapshot_veml_lux(uint16_t raw) {
+    if (raw <= 1000) return raw;
+
+    // lux = x * (1.0023 + 8.1488e-5 x - 9.3924e-9 x^2 + 6.0135e-13 x^3), factor in Q52
+    const int64_t x = raw;
+    int64_t f = 4513957906513448LL
+              + 366989326435LL * x
+              - 42299609LL * x * x
+              + 2708LL * x * x * x;
+    return (uint32_t)((x * (f >> 22)) >> 30);
+}
+
+static inline int16_t be16(const uint8_t *p) {
+    return (int16_t)(((uint16_t)p[0] << 8) | p[1]);
+}
+
+static inline uint16_t le16(const uint8_t *p) {
+    return (uint16_t)(p[0] | ((uint16_t)p[1] << 8));
+}
+
+int hat_snapshot_read(hat_snapshot_t *out, uint32_t devices) {
+    if (!out || !(devices & HAT_SNAPSHOT_ALL)) return -1;
+    memset(out, 0, sizeof *out);
+
+    uint8_t als[2];
+    uint8_t th[HDC2021_SNAPSHOT_BYTES];
+    uint8_t imu[ICM42670_SNAPSHOT_BYTES];
+
+    // Bus first, conversions afterwards, so the reads are as close together
+    // as possible.
+    uint64_t t0 = time_us_64();
+    if ((devices & HAT_SNAPSHOT_LIGHT) && burst_read(VEML6030_I2C_ADDR, VEML6030_ALS_REG, als, sizeof als))
+        out->valid |= HAT_SNAPSHOT_LIGHT;
+    if ((devices & HAT_SNAPSHOT_TEMP_HUMIDITY) && burst_read(HDC2021_I2C_ADDRESS, HDC2021_TEMP_LOW, th, sizeof th))
+        out->valid |= HAT_SNAPSHOT_TEMP_HUMIDITY;
+    if ((devices & HAT_SNAPSHOT_IMU) && burst_read(ICM42670_I2C_ADDRESS, ICM42670_SENSOR_DATA_START_REG, imu, sizeof imu))
+        out->valid |= HAT_SNAPSHOT_IMU;
+    uint64_t t1 = time_us_64();
+
+    out->timestamp_us = t0 + (t1 - t0) / 2;
+    out->bus_us = (uint32_t)(t1 - t0);
+
+    if (out->valid & HAT_SNAPSHOT_LIGHT) {
+        out->lux = hat_snapshot_veml_lux(le16(als));
+    }
+    if (out->valid & HAT_SNAPSHOT_TEMP_HUMIDITY) {
+        // T = raw * 165 / 65536 - 40, RH = raw * 100 / 65536
+        out->temp_c100 = (int16_t)((int32_t)(((uint32_t)le16(&th[0]) * 16500u) >> 16) - 4000);
+        out->humidity_p100 = (uint16_t)(((uint32_t)le16(&th[2]) * 10000u) >> 16);
+    }
+    if (out->valid & HAT_SNAPSHOT_IMU) {
+        // T = raw / 128 + 25
+        out->imu_temp_c100 = (int16_t)(be16(&imu[0]) * 100 / 128 + 2500);
+        for (int i = 0; i < 3; i++) {
+            out->accel_mg[i] = (be16(&imu[2 + 2 * i]) * 1000) / (1 << accel_shift);
+            out->gyro_mdps[i] = (be16(&imu[8 + 2 * i]) * 10000) / gyro_lsb_x10;
+        }
+    }
+
+    return out->valid == (devices & HAT_SNAPSHOT_ALL) ? 0 : -2;
+}
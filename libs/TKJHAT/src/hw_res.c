@@ -0,0 +1,436 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <tkjhat/hw_res.h>
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/sync.h"
+
+// Short sections only, nothing else is taken while it is held except the SDK claim lock
+#define LOCK_NUM        PICO_SPINLOCK_ID_STRIPED_FIRST
+
+typedef struct {
+    char owner[HW_RES_OWNER_LEN];
+    uint64_t bytes;
+    uint32_t transfers;
+    uint32_t busy;                  // samples that found the channel busy
+    uint32_t samples_at_claim;
+} dma_entry_t;
+
+typedef struct {
+    PIO pio;                        // NULL: free slot
+    const pio_program_t *program;
+    uint offset;
+    uint8_t refs;                   // state machines running it
+} program_entry_t;
+
+typedef struct {
+    irq_handler_t handler;          // NULL: free slot
+    uint8_t irq;
+    bool exclusive;
+    char owner[HW_RES_OWNER_LEN];
+} irq_entry_t;
+
+static struct {
+    dma_entry_t dma[NUM_DMA_CHANNELS];
+    char timer_owner[NUM_DMA_TIMERS][HW_RES_OWNER_LEN];
+    char sm_owner[NUM_PIOS][NUM_PIO_STATE_MACHINES][HW_RES_OWNER_LEN];
+    program_entry_t programs[HW_RES_MAX_PROGRAMS];
+    irq_entry_t irqs[HW_RES_MAX_IRQ_HANDLERS];
+
+    // Busy sampling
+    repeating_timer_t timer;
+    bool monitoring;
+    volatile uint32_t samples;
+
+    // Counters at the previous report
+    uint64_t prev_bytes[NUM_DMA_CHANNELS];
+    uint32_t prev_transfers[NUM_DMA_CHANNELS];
+    uint32_t prev_busy[NUM_DMA_CHANNELS];
+    uint32_t prev_samples;
+    uint64_t prev_us;
+} res;
+
+static inline uint32_t lock(void) {
+    return spin_lock_blocking(spin_lock_instance(LOCK_NUM));
+}
+
+static inline void unlock(uint32_t save) {
+    spin_unlock(spin_lock_instance(LOCK_NUM), save);
+}
+
+static void set_owner(char *dst, const char *owner) {
+    strncpy(dst, owner ? owner : "?", HW_RES_OWNER_LEN - 1);
+    dst[HW_RES_OWNER_LEN - 1] = '\0';
+}
+
+/* =========================
+ *  DMA
+ * ========================= */
+int hw_res_dma_claim(const char *owner) {
+    int ch = dma_claim_unused_channel(false);
+    if (ch < 0) return HW_RES_ERR_BUSY;
+    uint32_t save = lock();
+    dma_entry_t *e = &res.dma[ch];
+    set_owner(e->owner, owner);
+    e->bytes = 0;
+    e->transfers = 0;
+    e->busy = 0;
+    e->samples_at_claim = res.samples;
+    res.prev_bytes[ch] = 0;
+    res.prev_transfers[ch] = 0;
+    res.prev_busy[ch] = 0;
+    unlock(save);
+    return ch;
+}
+
+void hw_res_dma_release(int channel) {
+    if (channel < 0 || channel >= NUM_DMA_CHANNELS) return;
+    uint32_t save = lock();
+    res.dma[channel].owner[0] = '\0';
+    unlock(save);
+    dma_channel_unclaim((uint)channel);
+}
+
+int hw_res_dma_timer_claim(const char *owner) {
+    int t = dma_claim_unused_timer(false);
+    if (t < 0) return HW_RES_ERR_BUSY;
+    uint32_t save = lock();
+    set_owner(res.timer_owner[t], owner);
+    unlock(save);
+    return t;
+}
+
+void hw_res_dma_timer_release(int timer) {
+    if (timer < 0 || timer >= NUM_DMA_TIMERS) return;
+    uint32_t save = lock();
+    res.timer_owner[timer][0] = '\0';
+    unlock(save);
+    dma_timer_unclaim((uint)timer);
+}
+
+void hw_res_dma_note(int channel, uint32_t bytes) {
+    if (channel < 0 || channel >= NUM_DMA_CHANNELS) return;
+    uint32_t save = lock();
+    res.dma[channel].bytes += bytes;
+    res.dma[channel].transfers++;
+    unlock(save);
+}
+
+void hw_res_get_dma_stats(uint channel, hw_res_dma_stats_t *out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (channel >= NUM_DMA_CHANNELS) return;
+    uint32_t save = lock();
+    const dma_entry_t *e = &res.dma[channel];
+    if (e->owner[0]) {
+        memcpy(out->owner, e->owner, sizeof(out->owner));
+        out->bytes = e->bytes;
+        out->transfers = e->transfers;
+        out->busy_samples = e->busy;
+        out->samples = res.samples - e->samples_at_claim;
+    } else if (dma_channel_is_claimed(channel)) {
+        set_owner(out->owner, "(sdk)");
+        out->busy_samples = e->busy;
+        out->samples = res.samples;
+    }
+    unlock(save);
+}
+
+/* =========================
+ *  PIO
+ * ========================= */
+static program_entry_t *find_program(PIO pio, const pio_program_t *program) {
+    for (int i = 0; i < HW_RES_MAX_PROGRAMS; i++) {
+        if (res.programs[i].pio == pio && res.programs[i].program == program) return &res.programs[i];
+    }
+    return NULL;
+}
+
+int hw_res_pio_claim(const char *owner, const pio_program_t *program, PIO pio, hw_res_pio_t *out) {
+    if (!program || !out) return HW_RES_ERR_ARG;
+    uint first = pio ? pio_get_index(pio) : 0;
+    uint last = pio ? first : NUM_PIOS - 1;
+    int rc = HW_RES_ERR_BUSY;
+
+    uint32_t save = lock();
+    for (uint i = first; i <= last; i++) {
+        PIO p = pio_get_instance(i);
+        program_entry_t *e = find_program(p, program);
+        if (!e) {
+            e = find_program(NULL, NULL);
+            if (!e) {
+                rc = HW_RES_ERR_FULL;
+                break;
+            }
+            if (!pio_can_add_program(p, program)) continue;
+        }
+        int sm = pio_claim_unused_sm(p, false);
+        if (sm < 0) continue;
+        if (!e->pio) {
+            e->pio = p;
+            e->program = program;
+            e->offset = (uint)pio_add_program(p, program);
+            e->refs = 0;
+        }
+        e->refs++;
+        set_owner(res.sm_owner[i][sm], owner);
+        out->pio = p;
+        out->sm = (uint)sm;
+        out->offset = e->offset;
+        out->program = program;
+        rc = 0;
+        break;
+    }
+    unlock(save);
+    return rc;
+}
+
+void hw_res_pio_release(hw_res_pio_t *r) {
+    if (!r || !r->pio) return;
+    uint32_t save = lock();
+    program_entry_t *e = find_program(r->pio, r->program);
+    if (e && --e->refs == 0) {
+        pio_remove_program(e->pio, e->program, e->offset);
+        memset(e, 0, sizeof(*e));
+    }
+    res.sm_owner[pio_get_index(r->pio)][r->sm][0] = '\0';
+    pio_sm_unclaim(r->pio, r->sm);
+    unlock(save);
+    r->pio = NULL;
+}
+
+/* =========================
+ *  IRQ lines
+ * ========================= */
+static irq_entry_t *find_irq(uint irq, irq_handler_t handler) {
+    for (int i = 0; i < HW_RES_MAX_IRQ_HANDLERS; i++) {
+        irq_entry_t *e = &res.irqs[i];
+        if (e->handler == handler && (!handler || e->irq == irq)) return e;
+    }
+    return NULL;
+}
+
+static int install(const char *owner, uint irq, irq_handler_t handler, bool exclusive) {
+    if (!handler || irq >= NUM_IRQS) return HW_RES_ERR_ARG;
+    int rc = 0;
+    uint32_t save = lock();
+    irq_entry_t *e = find_irq(irq, handler);
+    if (e) {
+        // Installed before, e.g. by an earlier start()
+        rc = e->exclusive == exclusive ? 0 : HW_RES_ERR_CONFLICT;
+    } else if (irq_get_exclusive_handler(irq) || (exclusive && irq_has_shared_handler(irq))) {
+        rc = HW_RES_ERR_CONFLICT;
+    } else if (!(e = find_irq(0, NULL))) {
+        rc = HW_RES_ERR_FULL;
+    } else {
+        e->handler = handler;
+        e->irq = (uint8_t)irq;
+        e->exclusive = exclusive;
+        set_owner(e->owner, owner);
+        if (exclusive) irq_set_exclusive_handler(irq, handler);
+        else irq_add_shared_handler(irq, handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    }
+    unlock(save);
+    return rc;
+}
+
+int hw_res_irq_set_exclusive(const char *owner, uint irq, irq_handler_t handler) {
+    return install(owner, irq, handler, true);
+}
+
+int hw_res_irq_add_shared(const char *owner, uint irq, irq_handler_t handler) {
+    return install(owner, irq, handler, false);
+}
+
+void hw_res_irq_remove(uint irq, irq_handler_t handler) {
+    if (!handler) return;
+    uint32_t save = lock();
+    irq_entry_t *e = find_irq(irq, handler);
+    if (e) {
+        irq_remove_handler(irq, handler);
+        memset(e, 0, sizeof(*e));
+    }
+    unlock(save);
+}
+
+/* =========================
+ *  Utilization
+ * ========================= */
+static bool sample_cb(repeating_timer_t *t) {
+    (void)t;
+    for (uint ch = 0; ch < NUM_DMA_CHANNELS; ch++) {
+        if (dma_channel_is_busy(ch)) res.dma[ch].busy++;
+    }
+    res.samples++;
+    return true;
+}
+
+int hw_res_monitor_start(uint32_t sample_us) {
+    if (sample_us == 0) return HW_RES_ERR_ARG;
+    if (res.monitoring) hw_res_monitor_stop();
+    if (!add_repeating_timer_us(-(int64_t)sample_us, sample_cb, NULL, &res.timer)) return HW_RES_ERR_BUSY;
+    res.monitoring = true;
+    if (!res.prev_us) {
+        res.prev_us = time_us_64();
+        res.prev_samples = res.samples;
+    }
+    return 0;
+}
+
+void hw_res_monitor_stop(void) {
+    if (!res.monitoring) return;
+    cancel_repeating_timer(&res.timer);
+    res.monitoring = false;
+}
+
+static const char *irq_name(uint irq) {
+    switch (irq) {
+    case DMA_IRQ_0:     return "DMA_IRQ_0";
+    case DMA_IRQ_1:     return "DMA_IRQ_1";
+    case PIO0_IRQ_0:    return "PIO0_IRQ_0";
+    case PIO0_IRQ_1:    return "PIO0_IRQ_1";
+    case PIO1_IRQ_0:    return "PIO1_IRQ_0";
+    case PIO1_IRQ_1:    return "PIO1_IRQ_1";
+    default:            return NULL;
+    }
+}
+
+// Appends to buf, keeps pos at the terminator when the buffer is full
+__attribute__((format(printf, 4, 5)))
+static void put(char *buf, size_t len, size_t *pos, const char *fmt, ...) {
+    if (*pos >= len - 1) return;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf + *pos, len - *pos, fmt, ap);
+    va_end(ap);
+    if (n > 0) *pos += (size_t)n;
+    if (*pos >= len) *pos = len - 1;
+}
+
+int hw_res_format_report(char *buf, size_t len) {
+    if (!buf || len == 0) return 0;
+    buf[0] = '\0';
+    size_t pos = 0;
+
+    uint64_t now = time_us_64();
+    uint64_t dt_us = res.prev_us ? now - res.prev_us : 0;
+    res.prev_us = now;
+    uint32_t samples = res.samples;
+    uint32_t d_samples = samples - res.prev_samples;
+    res.prev_samples = samples;
+
+    // DMA channels
+    uint64_t total = 0;
+    put(buf, len, &pos, "[res] dma  ch %-*s %9s %8s %6s\n", HW_RES_OWNER_LEN - 1, "owner", "KB/s", "xfer/s", "busy%");
+    for (uint ch = 0; ch < NUM_DMA_CHANNELS; ch++) {
+        hw_res_dma_stats_t s;
+        hw_res_get_dma_stats(ch, &s);
+        uint32_t busy = res.dma[ch].busy;
+        uint64_t d_bytes = s.bytes - res.prev_bytes[ch];
+        uint32_t d_xfers = s.transfers - res.prev_transfers[ch];
+        uint32_t d_busy = busy - res.prev_busy[ch];
+        res.prev_bytes[ch] = s.bytes;
+        res.prev_transfers[ch] = s.transfers;
+        res.prev_busy[ch] = busy;
+        if (!s.owner[0]) continue;
+        total += d_bytes;
+
+        uint64_t kbps10 = dt_us ? d_bytes * 10000000u / 1024u / dt_us : 0;    // tenths of KB/s
+        uint64_t xps10 = dt_us ? (uint64_t)d_xfers * 10000000u / dt_us : 0;
+        put(buf, len, &pos, "[res] dma %3u %-*s %7lu.%lu %6lu.%lu ", ch, HW_RES_OWNER_LEN - 1, s.owner,
+            (unsigned long)(kbps10 / 10), (unsigned long)(kbps10 % 10),
+            (unsigned long)(xps10 / 10), (unsigned long)(xps10 % 10));
+        if (d_samples) put(buf, len, &pos, "%6lu\n", (unsigned long)((uint64_t)d_busy * 100u / d_samples));
+        else put(buf, len, &pos, "%6s\n", "-");
+    }
+    if (dt_us) {
+        // The DMA moves at most one word per system clock cycle
+        uint64_t peak = (uint64_t)clock_get_hz(clk_sys) * 4u;
+        uint64_t bps = total * 1000000u / dt_us;
+        uint64_t pct = bps * 10000u / peak;
+        put(buf, len, &pos, "[res] dma total %lu KB/s, %lu.%02lu %% of the %lu MB/s bus peak\n",
+            (unsigned long)(bps / 1024u), (unsigned long)(pct / 100), (unsigned long)(pct % 100),
+            (unsigned long)(peak / 1000000u));
+    }
+
+    // Copy of the owner tables, formatted without holding the lock
+    char timer_owner[NUM_DMA_TIMERS][HW_RES_OWNER_LEN];
+    char sm_owner[NUM_PIOS][NUM_PIO_STATE_MACHINES][HW_RES_OWNER_LEN];
+    program_entry_t programs[HW_RES_MAX_PROGRAMS];
+    irq_entry_t irqs[HW_RES_MAX_IRQ_HANDLERS];
+    uint32_t save = lock();
+    memcpy(timer_owner, res.timer_owner, sizeof(timer_owner));
+    memcpy(sm_owner, res.sm_owner, sizeof(sm_owner));
+    memcpy(programs, res.programs, sizeof(programs));
+    memcpy(irqs, res.irqs, sizeof(irqs));
+    unlock(save);
+
+    // DMA timers
+    for (uint t = 0; t < NUM_DMA_TIMERS; t++) {
+        if (timer_owner[t][0]) put(buf, len, &pos, "[res] dma timer %u %s\n", t, timer_owner[t]);
+    }
+
+    // PIO: state machine owners and instruction memory loaded through the manager
+    for (uint i = 0; i < NUM_PIOS; i++) {
+        PIO p = pio_get_instance(i);
+        uint instr = 0;
+        for (int k = 0; k < HW_RES_MAX_PROGRAMS; k++) {
+            if (programs[k].pio == p) instr += programs[k].program->length;
+        }
+        put(buf, len, &pos, "[res] pio%u", i);
+        for (uint sm = 0; sm < NUM_PIO_STATE_MACHINES; sm++) {
+            const char *o = sm_owner[i][sm];
+            put(buf, len, &pos, " sm%u=%s", sm, o[0] ? o : (pio_sm_is_claimed(p, sm) ? "(sdk)" : "-"));
+        }
+        put(buf, len, &pos, ", %u/%u instr\n", instr, (unsigned)PIO_INSTRUCTION_COUNT);
+    }
+
+    // IRQ lines, one line per IRQ
+    for (int k = 0; k < HW_RES_MAX_IRQ_HANDLERS; k++) {
+        const irq_entry_t *e = &irqs[k];
+        if (!e->handler) continue;
+        bool first = true;
+        for (int j = 0; j < k; j++) {
+            if (irqs[j].handler && irqs[j].irq == e->irq) first = false;
+        }
+        if (!first) continue;
+        const char *name = irq_name(e->irq);
+        if (name) put(buf, len, &pos, "[res] irq %s", name);
+        else put(buf, len, &pos, "[res] irq %u", e->irq);
+        put(buf, len, &pos, " %s:", e->exclusive ? "exclusive" : "shared");
+        for (int j = k; j < HW_RES_MAX_IRQ_HANDLERS; j++) {
+            if (irqs[j].handler && irqs[j].irq == e->irq) put(buf, len, &pos, " %s", irqs[j].owner);
+        }
+        put(buf, len, &pos, "\n");
+    }
+    return (int)pos;
+}
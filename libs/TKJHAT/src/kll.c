@@ -0,0 +1,354 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <tkjhat/kll.h>
+
+#include <string.h>
+
+#define SERIAL_MAGIC            'K'
+#define SERIAL_HEADER           22
+
+/* =========================
+ *  Level capacities
+ * ========================= */
+// round(k * (2/3)^depth) without floating point
+static uint32_t depth_capacity(uint32_t k, unsigned depth) {
+    uint64_t pow3 = 1;
+    for (unsigned i = 0; i < depth; i++) pow3 *= 3;
+    uint64_t twice = ((uint64_t)k << (depth + 1)) / pow3;
+    return (uint32_t)((twice + 1) >> 1);
+}
+
+static uint32_t level_capacity(unsigned num_levels, unsigned level) {
+    uint32_t c = depth_capacity(KLL_K, num_levels - level - 1);
+    return c > KLL_MIN_CAPACITY ? c : KLL_MIN_CAPACITY;
+}
+
+static uint32_t total_capacity(unsigned num_levels) {
+    uint32_t total = 0;
+    for (unsigned h = 0; h < num_levels; h++) total += level_capacity(num_levels, h);
+    return total;
+}
+
+/* =========================
+ *  Helpers
+ * ========================= */
+static uint32_t random_bit(kll_sketch_t *s) {
+    uint32_t x = s->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    s->rng = x;
+    return x & 1u;
+}
+
+static void sort_floats(float *a, unsigned n) {
+    // Insertion sort: level 0 holds at most KLL_K items and is often nearly sorted
+    for (unsigned i = 1; i < n; i++) {
+        float v = a[i];
+        unsigned j = i;
+        while (j > 0 && a[j - 1] > v) {
+            a[j] = a[j - 1];
+            j--;
+        }
+        a[j] = v;
+    }
+}
+
+// Keeps one item of every pair, in the lower half of the range
+static void halve_down(kll_sketch_t *s, unsigned start, unsigned len) {
+    unsigned half = len / 2;
+    unsigned j = start + random_bit(s);
+    for (unsigned i = start; i < start + half; i++, j += 2) s->items[i] = s->items[j];
+}
+
+// Keeps one item of every pair, in the upper half of the range
+static void halve_up(kll_sketch_t *s, unsigned start, unsigned len) {
+    unsigned half = len / 2;
+    unsigned j = start + len - 1 - random_bit(s);
+    for (unsigned i = start + len; i-- > start + half; j -= 2) s->items[i] = s->items[j];
+}
+
+// Merges the sorted runs [a, a + na) and [b, b + nb) into [out, ...). The output
+// may overlap the inputs as long as it never overtakes them (true for compaction).
+static void merge_runs(float *items, unsigned a, unsigned na, unsigned b, unsigned nb, unsigned out) {
+    unsigned ea = a + na, eb = b + nb;
+    while (a < ea && b < eb) items[out++] = items[a] <= items[b] ? items[a++] : items[b++];
+    while (a < ea) items[out++] = items[a++];
+    while (b < eb) items[out++] = items[b++];
+}
+
+// Adds an empty top level. The extra capacity is opened below level 0.
+static int add_level(kll_sketch_t *s) {
+    unsigned L = s->num_levels;
+    if (L >= KLL_MAX_LEVELS) return -1;
+    uint32_t delta = total_capacity(L + 1) - total_capacity(L);
+    unsigned start = s->levels[0], end = s->levels[L];
+    memmove(&s->items[start + delta], &s->items[start], (end - start) * sizeof(float));
+    for (unsigned h = 0; h <= L; h++) s->levels[h] = (uint16_t)(s->levels[h] + delta);
+    s->levels[L + 1] = s->levels[L];
+    s->num_levels = (uint8_t)(L + 1);
+    return 0;
+}
+
+// Compacts the lowest level that reached its capacity. Frees at least one slot.
+static int compress(kll_sketch_t *s) {
+    unsigned level = 0;
+    while ((uint32_t)(s->levels[level + 1] - s->levels[level]) < level_capacity(s->num_levels, level)) level++;
+    if (level + 1 >= s->num_levels) {
+        if (add_level(s)) return -1;
+    }
+
+    unsigned raw_beg = s->levels[level];
+    unsigned raw_lim = s->levels[level + 1];
+    unsigned pop_above = s->levels[level + 2] - raw_lim;
+    unsigned raw_pop = raw_lim - raw_beg;
+    unsigned odd = raw_pop & 1u;
+    unsigned adj_beg = raw_beg + odd;
+    unsigned adj_pop = raw_pop - odd;
+    unsigned half = adj_pop / 2;
+
+    if (level == 0) sort_floats(&s->items[adj_beg], adj_pop);
+    if (pop_above == 0) {
+        halve_up(s, adj_beg, adj_pop);
+    } else {
+        halve_down(s, adj_beg, adj_pop);
+        merge_runs(s->items, adj_beg, half, raw_lim, pop_above, adj_beg + half);
+    }
+
+    // The promoted items now start at adj_beg + half
+    s->levels[level + 1] = (uint16_t)(s->levels[level + 1] - half);
+    if (odd) {
+        // The odd item stays on this level, just below the promoted ones
+        s->levels[level] = (uint16_t)(s->levels[level + 1] - 1);
+        s->items[s->levels[level]] = s->items[raw_beg];
+    } else {
+        s->levels[level] = s->levels[level + 1];
+    }
+
+    // Close the gap by moving the lower levels up
+    if (level > 0) {
+        unsigned start = s->levels[0];
+        memmove(&s->items[start + half], &s->items[start], (raw_beg - start) * sizeof(float));
+        for (unsigned h = 0; h < level; h++) s->levels[h] = (uint16_t)(s->levels[h] + half);
+    }
+    return 0;
+}
+
+// Inserts one item of weight 2^level, keeping the level sorted
+static int insert_at(kll_sketch_t *s, unsigned level, float value) {
+    while (s->num_levels <= level) {
+        if (add_level(s)) return -1;
+    }
+    if (s->levels[0] == 0 && compress(s)) return -1;
+
+    unsigned pos = s->levels[level];
+    if (level == 0) {
+        s->items[--s->levels[0]] = value;
+        return 0;
+    }
+    while (pos < s->levels[level + 1] && s->items[pos] <= value) pos++;
+    unsigned start = s->levels[0];
+    memmove(&s->items[start - 1], &s->items[start], (pos - start) * sizeof(float));
+    for (unsigned h = 0; h <= level; h++) s->levels[h]--;
+    s->items[pos - 1] = value;
+    return 0;
+}
+
+/* =========================
+ *  Public API
+ * ========================= */
+void kll_init(kll_sketch_t *s, uint32_t seed) {
+    memset(s, 0, sizeof(*s));
+    s->rng = seed ? seed : 0x9E3779B9u;
+    s->num_levels = 1;
+    s->levels[0] = KLL_K;
+    s->levels[1] = KLL_K;
+}
+
+int kll_update(kll_sketch_t *s, float value) {
+    if (value != value) return -2;
+    if (s->levels[0] == 0 && compress(s)) return -1;
+    s->items[--s->levels[0]] = value;
+    if (s->n == 0 || value < s->min) s->min = value;
+    if (s->n == 0 || value > s->max) s->max = value;
+    s->n++;
+    return 0;
+}
+
+int kll_merge(kll_sketch_t *dst, const kll_sketch_t *src) {
+    if (src->n == 0) return 0;
+    for (unsigned h = 0; h < src->num_levels; h++) {
+        for (unsigned i = src->levels[h]; i < src->levels[h + 1]; i++) {
+            if (insert_at(dst, h, src->items[i])) return -1;
+        }
+    }
+    if (dst->n == 0 || src->min < dst->min) dst->min = src->min;
+    if (dst->n == 0 || src->max > dst->max) dst->max = src->max;
+    dst->n += src->n;
+    return 0;
+}
+
+float kll_quantile(kll_sketch_t *s, float q) {
+    if (s->n == 0) return 0.0f;
+    if (q <= 0.0f) return s->min;
+    if (q >= 1.0f) return s->max;
+
+    sort_floats(&s->items[s->levels[0]], s->levels[1] - s->levels[0]);
+
+    // Walk all levels in value order (k-way merge) until the weight reaches q * n
+    unsigned cursor[KLL_MAX_LEVELS];
+    for (unsigned h = 0; h < s->num_levels; h++) cursor[h] = s->levels[h];
+    uint64_t target = (uint64_t)((double)q * (double)s->n);
+    if (target == 0) target = 1;
+    uint64_t acc = 0;
+    for (;;) {
+        int best = -1;
+        for (unsigned h = 0; h < s->num_levels; h++) {
+            if (cursor[h] < s->levels[h + 1] &&
+                (best < 0 || s->items[cursor[h]] < s->items[cursor[best]])) best = (int)h;
+        }
+        if (best < 0) return s->max;
+        float v = s->items[cursor[best]++];
+        acc += (uint64_t)1 << best;
+        if (acc >= target) return v;
+    }
+}
+
+float kll_rank(const kll_sketch_t *s, float value) {
+    if (s->n == 0) return 0.0f;
+    uint64_t acc = 0;
+    for (unsigned h = 0; h < s->num_levels; h++) {
+        for (unsigned i = s->levels[h]; i < s->levels[h + 1]; i++) {
+            if (s->items[i] <= value) acc += (uint64_t)1 << h;
+        }
+    }
+    return (float)((double)acc / (double)s->n);
+}
+
+/* =========================
+ *  Serialization
+ * ========================= */
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static void put_f32(uint8_t *p, float f) {
+    uint32_t v;
+    memcpy(&v, &f, sizeof(v));
+    put_u32(p, v);
+}
+
+static uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static float get_f32(const uint8_t *p) {
+    uint32_t v = get_u32(p);
+    float f;
+    memcpy(&f, &v, sizeof(f));
+    return f;
+}
+
+size_t kll_serialized_size(const kll_sketch_t *s) {
+    return SERIAL_HEADER + 2u * s->num_levels + 4u * kll_retained(s);
+}
+
+// Layout (little endian): 'K', version, k (u16), levels (u8), 0, n (u64), min, max (f32),
+// items per level (u16 each, level 0 first), items (f32, level 0 first)
+int kll_serialize(const kll_sketch_t *s, uint8_t *buf, size_t len) {
+    size_t need = kll_serialized_size(s);
+    if (len < need) return -1;
+
+    buf[0] = SERIAL_MAGIC;
+    buf[1] = KLL_SERIAL_VERSION;
+    put_u16(buf + 2, KLL_K);
+    buf[4] = s->num_levels;
+    buf[5] = 0;
+    put_u32(buf + 6, (uint32_t)s->n);
+    put_u32(buf + 10, (uint32_t)(s->n >> 32));
+    put_f32(buf + 14, s->min);
+    put_f32(buf + 18, s->max);
+
+    size_t pos = SERIAL_HEADER;
+    for (unsigned h = 0; h < s->num_levels; h++, pos += 2) {
+        put_u16(buf + pos, (uint16_t)(s->levels[h + 1] - s->levels[h]));
+    }
+    for (unsigned i = s->levels[0]; i < s->levels[s->num_levels]; i++, pos += 4) {
+        put_f32(buf + pos, s->items[i]);
+    }
+    return (int)pos;
+}
+
+int kll_deserialize(kll_sketch_t *s, const uint8_t *buf, size_t len, uint32_t seed) {
+    if (len < SERIAL_HEADER || buf[0] != SERIAL_MAGIC || buf[1] != KLL_SERIAL_VERSION) return -1;
+    if (get_u16(buf + 2) != KLL_K) return -2;
+    unsigned num_levels = buf[4];
+    if (num_levels == 0 || num_levels > KLL_MAX_LEVELS) return -1;
+    if (len < SERIAL_HEADER + 2u * num_levels) return -1;
+
+    kll_init(s, seed);
+    while (s->num_levels < num_levels) add_level(s);
+
+    // Level sizes must fit the capacity the writer had with the same k
+    uint32_t retained = 0;
+    uint16_t sizes[KLL_MAX_LEVELS];
+    for (unsigned h = 0; h < num_levels; h++) {
+        sizes[h] = get_u16(buf + SERIAL_HEADER + 2 * h);
+        retained += sizes[h];
+    }
+    uint32_t cap = s->levels[num_levels];
+    if (retained > cap) return -1;
+    size_t need = SERIAL_HEADER + 2u * num_levels + 4u * retained;
+    if (len < need) return -1;
+
+    // Items are packed against the end of the buffer, level 0 first
+    uint32_t at = cap - retained;
+    const uint8_t *p = buf + SERIAL_HEADER + 2 * num_levels;
+    uint64_t weight = 0;
+    for (unsigned h = 0; h < num_levels; h++) {
+        s->levels[h] = (uint16_t)at;
+        for (unsigned i = 0; i < sizes[h]; i++, p += 4) s->items[at++] = get_f32(p);
+        weight += (uint64_t)sizes[h] << h;
+    }
+    s->levels[num_levels] = (uint16_t)at;
+
+    s->n = (uint64_t)get_u32(buf + 6) | ((uint64_t)get_u32(buf + 10) << 32);
+    s->min = get_f32(buf + 14);
+    s->max = get_f32(buf + 18);
+    if (weight != s->n) return -1;
+    return (int)need;
+}
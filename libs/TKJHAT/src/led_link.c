@@ -0,0 +1,265 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <tkjhat/led_link.h>
+#include <tkjhat/crc.h>
+
+#define ENV_CHIPS           16      // envelope decay time constant, in chips
+#define SAMPLE_Q8           256
+
+enum {
+    ST_HUNT = 0,
+    ST_FRAME,
+};
+
+/* =========================
+ *  Encoder
+ * ========================= */
+
+typedef struct {
+    uint32_t *words;
+    size_t   n;
+    uint32_t cur;
+    unsigned fill;
+} chip_writer_t;
+
+static void put_chip(chip_writer_t *w, unsigned chip) {
+    w->cur = (w->cur << 1) | (chip & 1u);
+    if (++w->fill == 32) {
+        w->words[w->n++] = w->cur;
+        w->cur = 0;
+        w->fill = 0;
+    }
+}
+
+static void put_byte(chip_writer_t *w, led_link_coding_t coding, uint8_t b) {
+    for (int i = 7; i >= 0; --i) {
+        unsigned bit = (b >> i) & 1u;
+        if (coding == LED_LINK_MANCHESTER) put_chip(w, !bit);
+        put_chip(w, bit);
+    }
+}
+
+size_t led_link_encode(led_link_coding_t coding, const void *payload, size_t len,
+                       uint32_t *words, size_t max_words) {
+    if (len > LED_LINK_MAX_PAYLOAD || !words) return 0;
+    if (len && !payload) return 0;
+    if (max_words < LED_LINK_FRAME_WORDS(coding, len)) return 0;
+
+    const uint8_t *p = (const uint8_t *)payload;
+    uint8_t l = (uint8_t)len;
+    uint16_t crc = crc16_ccitt(CRC16_CCITT_INIT, &l, 1);
+    crc = crc16_ccitt(crc, p, len);
+
+    chip_writer_t w = { .words = words };
+    for (int i = 0; i < LED_LINK_PREAMBLE_BYTES; ++i) put_byte(&w, coding, LED_LINK_PREAMBLE);
+    put_byte(&w, coding, LED_LINK_SYNC0);
+    put_byte(&w, coding, LED_LINK_SYNC1);
+    put_byte(&w, coding, l);
+    for (size_t i = 0; i < len; ++i) put_byte(&w, coding, p[i]);
+    put_byte(&w, coding, (uint8_t)(crc & 0xFF));
+    put_byte(&w, coding, (uint8_t)(crc >> 8));
+    for (int i = 0; i < LED_LINK_TAIL_CHIPS; ++i) put_chip(&w, 0);
+    if (w.fill) words[w.n++] = w.cur << (32 - w.fill);
+    return w.n;
+}
+
+/* =========================
+ *  Receiver
+ * ========================= */
+
+static uint64_t sync_pattern(led_link_coding_t coding, unsigned *nchips) {
+    static const uint8_t bytes[] = { LED_LINK_PREAMBLE, LED_LINK_SYNC0, LED_LINK_SYNC1 };
+    uint64_t v = 0;
+    unsigned n = 0;
+    for (unsigned k = 0; k < sizeof bytes; ++k) {
+        for (int i = 7; i >= 0; --i) {
+            unsigned bit = (bytes[k] >> i) & 1u;
+            if (coding == LED_LINK_MANCHESTER) { v = (v << 1) | !bit; ++n; }
+            v = (v << 1) | bit;
+            ++n;
+        }
+    }
+    *nchips = n;
+    return v;
+}
+
+int led_link_rx_init(led_link_rx_t *rx, led_link_coding_t coding, float samples_per_chip,
+                     uint16_t min_swing, led_link_rx_handler_t handler, void *ctx) {
+    if (!rx) return -1;
+    if (coding != LED_LINK_OOK && coding != LED_LINK_MANCHESTER) return -2;
+    if (!(samples_per_chip >= 3.0f && samples_per_chip <= 256.0f)) return -3;
+
+    *rx = (led_link_rx_t){0};
+    rx->coding = coding;
+    rx->handler = handler;
+    rx->ctx = ctx;
+    rx->min_swing = (int32_t)min_swing << 4;
+    rx->chip_q8 = (int32_t)(samples_per_chip * SAMPLE_Q8 + 0.5f);
+    rx->box_len = (uint8_t)(samples_per_chip / 2.0f + 0.5f);
+    if (rx->box_len > LED_LINK_RX_BOX_MAX) rx->box_len = LED_LINK_RX_BOX_MAX;
+    rx->env_shift = 0;
+    while ((1.0f * (1u << (rx->env_shift + 1))) <= samples_per_chip * ENV_CHIPS) rx->env_shift++;
+
+    unsigned n;
+    rx->sync_chips = sync_pattern(coding, &n);
+    rx->sync_mask = (n >= 64) ? ~0ull : ((1ull << n) - 1);
+    rx->state = ST_HUNT;
+    return 0;
+}
+
+static void hunt(led_link_rx_t *rx) {
+    rx->state = ST_HUNT;
+    rx->chips = 0;
+}
+
+// Returns 1 when a good frame was delivered.
+static int rx_chip(led_link_rx_t *rx, unsigned chip) {
+    if (rx->state == ST_HUNT) {
+        rx->chips = (rx->chips << 1) | chip;
+        if ((rx->chips & rx->sync_mask) == rx->sync_chips) {
+            rx->state = ST_FRAME;
+            rx->nhalf = 0;
+            rx->nbits = 0;
+            rx->nbytes = 0;
+            rx->need = 1;
+        }
+        return 0;
+    }
+
+    unsigned bit = chip;
+    if (rx->coding == LED_LINK_MANCHESTER) {
+        if (!rx->nhalf) {
+            rx->half = (uint8_t)chip;
+            rx->nhalf = 1;
+            return 0;
+        }
+        rx->nhalf = 0;
+        if (rx->half == chip) {
+            rx->stats.code_errors++;
+            hunt(rx);
+            return 0;
+        }
+    }
+
+    rx->cur = (uint8_t)((rx->cur << 1) | bit);
+    if (++rx->nbits < 8) return 0;
+    rx->nbits = 0;
+    rx->buf[rx->nbytes++] = rx->cur;
+
+    if (rx->nbytes == 1) {
+        if (rx->cur > LED_LINK_MAX_PAYLOAD) {
+            rx->stats.len_errors++;
+            hunt(rx);
+            return 0;
+        }
+        rx->need = (uint16_t)(rx->cur + 3);
+        return 0;
+    }
+    if (rx->nbytes < rx->need) return 0;
+
+    hunt(rx);
+    uint16_t crc = crc16_ccitt(CRC16_CCITT_INIT, rx->buf, rx->need - 2u);
+    uint16_t got = (uint16_t)(rx->buf[rx->need - 2] | (rx->buf[rx->need - 1] << 8));
+    if (crc != got) {
+        rx->stats.crc_errors++;
+        return 0;
+    }
+    rx->stats.frames++;
+    if (rx->handler) rx->handler(&rx->buf[1], rx->buf[0], rx->ctx);
+    return 1;
+}
+
+int led_link_rx_push(led_link_rx_t *rx, const uint16_t *samples, size_t n) {
+    if (!rx || !samples) return 0;
+
+    int frames = 0;
+    const int32_t mid = rx->chip_q8 / 2;
+    // Decide on the sample closest to the middle of the chip.
+    const int32_t decide_at = mid - SAMPLE_Q8 / 2;
+    for (size_t i = 0; i < n; ++i) {
+        // Moving average over about half a chip: averages the noise, and its
+        // delay is the same for edges and decisions so the clock absorbs it.
+        rx->box_sum += (int32_t)samples[i] - rx->box[rx->box_pos];
+        rx->box[rx->box_pos] = samples[i];
+        if (++rx->box_pos == rx->box_len) rx->box_pos = 0;
+        int32_t x = (rx->box_sum << 4) / rx->box_len;
+
+        // Peak envelope: jumps to new extremes, decays towards the middle.
+        // The rail the signal is not on decays 4x slower, so long runs of
+        // the same chip do not drag the threshold along.
+        uint8_t hi_shift = rx->env_shift + (rx->level ? 0 : 2);
+        uint8_t lo_shift = rx->env_shift + (rx->level ? 2 : 0);
+        if (x > rx->hi) rx->hi = x; else rx->hi -= (rx->hi - rx->lo) >> hi_shift;
+        if (x < rx->lo) rx->lo = x; else rx->lo += (rx->hi - rx->lo) >> lo_shift;
+
+        int32_t swing = rx->hi - rx->lo;
+        int32_t thr = rx->lo + swing / 2;
+        bool squelch = swing < rx->min_swing || swing <= 0;
+        uint8_t level = 0;
+        if (!squelch) {
+            int32_t hyst = swing >> 3;
+            level = (x > thr + hyst) ? 1 : (x < thr - hyst) ? 0 : rx->level;
+        }
+
+        if (level != rx->level) {
+            // Place the threshold crossing between the previous sample and
+            // this one; the chip boundary should be at phase 0. With the
+            // hysteresis the crossing may be older, then assume 1.5 samples.
+            int32_t d = x - rx->prev_x;
+            int32_t a = x - thr;
+            int32_t ago = SAMPLE_Q8 + SAMPLE_Q8 / 2;
+            if (d != 0 && (a > 0) == (d > 0) && (a > 0 ? a < d : a > d)) ago = a * SAMPLE_Q8 / d;
+            int32_t err = rx->phase_q8 - ago;
+            if (err >= mid) err -= rx->chip_q8;
+            if (err < -mid) err += rx->chip_q8;
+            if (err >= SAMPLE_Q8 || err <= -SAMPLE_Q8) rx->stats.resyncs++;
+            // Pull half the error, the edges of a clean signal agree anyway.
+            rx->phase_q8 -= err / 2;
+            if (rx->phase_q8 >= rx->chip_q8) {
+                rx->phase_q8 -= rx->chip_q8;
+                rx->decided = 0;
+            } else if (rx->phase_q8 < 0) {
+                rx->phase_q8 += rx->chip_q8;
+                rx->decided = 1;
+            }
+            rx->level = level;
+        }
+        rx->prev_x = x;
+
+        if (!rx->decided && rx->phase_q8 >= decide_at) {
+            rx->decided = 1;
+            frames += rx_chip(rx, !squelch && x > thr);
+        }
+        rx->phase_q8 += SAMPLE_Q8;
+        if (rx->phase_q8 >= rx->chip_q8) {
+            rx->phase_q8 -= rx->chip_q8;
+            rx->decided = 0;
+        }
+    }
+    return frames;
+}
@@ -0,0 +1,144 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <tkjhat/led_tx.h>
+#include <tkjhat/energy.h>
+#include <tkjhat/hw_res.h>
+#include <tkjhat/pins.h>
+#include <tkjhat/sram.h>
+
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/pio.h"
+#include "hardware/pwm.h"
+
+#include "led_tx.pio.h"
+
+static struct {
+    bool running;
+    bool sending;
+    hw_res_pio_t res;               // state machine and program
+    int dma;
+    uint pin;
+    led_link_coding_t coding;
+    float chip_rate;
+} tx;
+
+static uint32_t chip_words[LED_LINK_MAX_WORDS] TKJHAT_DMA_BUFFER;
+
+int led_tx_init(uint pin, uint32_t bit_rate, led_link_coding_t coding) {
+    if (tx.running) return -1;
+    if (pin != RGB_LED_R && pin != RGB_LED_G && pin != RGB_LED_B) return -2;
+    if (coding != LED_LINK_OOK && coding != LED_LINK_MANCHESTER) return -2;
+
+    uint32_t chip_rate = bit_rate * (coding == LED_LINK_MANCHESTER ? 2u : 1u);
+    float div = (float)clock_get_hz(clk_sys) / ((float)chip_rate * LED_TX_CYCLES_PER_CHIP);
+    if (bit_rate == 0 || div < 1.0f || div >= 65536.0f) return -3;
+
+    if (hw_res_pio_claim("led_tx", &led_tx_program, NULL, &tx.res) != 0) return -4;
+
+    tx.dma = hw_res_dma_claim("led_tx");
+    if (tx.dma < 0) {
+        hw_res_pio_release(&tx.res);
+        return -5;
+    }
+
+    tx.pin = pin;
+    tx.coding = coding;
+    tx.chip_rate = (float)clock_get_hz(clk_sys) / (div * LED_TX_CYCLES_PER_CHIP);
+
+    led_tx_program_init(tx.res.pio, tx.res.sm, tx.res.offset, pin, div);
+    gpio_set_outover(pin, GPIO_OVERRIDE_INVERT);    // active low: chip 1 = LED on
+    pio_sm_set_enabled(tx.res.pio, tx.res.sm, true);
+
+    dma_channel_config c = dma_channel_get_default_config(tx.dma);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, pio_get_dreq(tx.res.pio, tx.res.sm, true));
+    dma_channel_configure(tx.dma, &c, &tx.res.pio->txf[tx.res.sm], chip_words, 0, false);
+
+    tx.sending = false;
+    tx.running = true;
+    return 0;
+}
+
+bool led_tx_busy(void) {
+    if (!tx.running || !tx.sending) return false;
+    if (dma_channel_is_busy(tx.dma) || !pio_sm_is_tx_fifo_empty(tx.res.pio, tx.res.sm)) return true;
+    // The FIFO is empty; the frame is over once the state machine stalls on
+    // the next 'out', i.e. after the last chip has been on the pin for its
+    // whole period.
+    uint32_t stall = 1u << (PIO_FDEBUG_TXSTALL_LSB + tx.res.sm);
+    if (!(tx.res.pio->fdebug & stall)) return true;
+
+    tx.sending = false;
+    energy_set_state(ENERGY_RGB, ENERGY_OFF, 0);
+    return false;
+}
+
+int led_tx_send(const void *payload, size_t len) {
+    if (!tx.running) return -1;
+    if (len > LED_LINK_MAX_PAYLOAD || (len && !payload)) return -2;
+    if (led_tx_busy()) return -3;
+
+    size_t n = led_link_encode(tx.coding, payload, len, chip_words, LED_LINK_MAX_WORDS);
+    if (n == 0) return -2;
+
+    tx.res.pio->fdebug = 1u << (PIO_FDEBUG_TXSTALL_LSB + tx.res.sm);    // write 1 to clear
+    tx.sending = true;
+    // Manchester keeps the LED on half of the time, OOK about as much on random data.
+    energy_set_state(ENERGY_RGB, ENERGY_ON, 128);
+    hw_res_dma_note(tx.dma, (uint32_t)(n * sizeof(chip_words[0])));
+    dma_channel_transfer_from_buffer_now(tx.dma, chip_words, (uint)n);
+    return 0;
+}
+
+float led_tx_chip_rate(void) {
+    return tx.running ? tx.chip_rate : 0.0f;
+}
+
+void led_tx_deinit(void) {
+    if (!tx.running) return;
+
+    dma_channel_abort(tx.dma);
+    hw_res_dma_release(tx.dma);
+
+    pio_sm_set_enabled(tx.res.pio, tx.res.sm, false);
+    pio_sm_clear_fifos(tx.res.pio, tx.res.sm);
+    hw_res_pio_release(&tx.res);
+
+    // Back to the PWM set up by init_rgb_led(), LED off until the next rgb_led_write().
+    gpio_set_outover(tx.pin, GPIO_OVERRIDE_NORMAL);
+    pwm_set_gpio_level(tx.pin, 0xFFFF);
+    gpio_set_function(tx.pin, GPIO_FUNC_PWM);
+
+    if (tx.sending) energy_set_state(ENERGY_RGB, ENERGY_OFF, 0);
+    tx.sending = false;
+    tx.running = false;
+}
@@ -0,0 +1,142 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <tkjhat/link_frame.h>
+#include <tkjhat/crc.h>
+
+#include <string.h>
+
+enum {
+    ST_SYNC0 = 0,       // link_frame_decoder_idle()
+    ST_SYNC1,
+    ST_TYPE,
+    ST_SEQ,
+    ST_LEN,
+    ST_PAYLOAD,
+    ST_CRC0,
+    ST_CRC1,
+};
+
+size_t link_frame_encode(uint8_t type, uint8_t seq, const void *payload, size_t len,
+                         uint8_t *out, size_t out_len) {
+    if (len > LINK_FRAME_MAX_PAYLOAD || !out || out_len < len + LINK_FRAME_OVERHEAD) return 0;
+    if (len && !payload) return 0;
+
+    out[0] = LINK_FRAME_SYNC0;
+    out[1] = LINK_FRAME_SYNC1;
+    out[2] = type;
+    out[3] = seq;
+    out[4] = (uint8_t)len;
+    if (len) memcpy(&out[5], payload, len);
+
+    uint16_t crc = crc16_ccitt(CRC16_CCITT_INIT, &out[2], len + 3);
+    out[5 + len] = (uint8_t)(crc & 0xFF);
+    out[6 + len] = (uint8_t)(crc >> 8);
+    return len + LINK_FRAME_OVERHEAD;
+}
+
+void link_frame_decoder_init(link_frame_decoder_t *d) {
+    memset(d, 0, sizeof(*d));
+    d->state = ST_SYNC0;
+}
+
+static void track_seq(link_frame_decoder_t *d) {
+    if (d->have_seq) {
+        d->lost += (uint8_t)(d->seq - d->next_seq);
+    }
+    d->have_seq = true;
+    d->next_seq = (uint8_t)(d->seq + 1);
+}
+
+link_frame_result_t link_frame_decode_byte(link_frame_decoder_t *d, uint8_t byte) {
+    switch (d->state) {
+    case ST_SYNC0:
+        if (byte == LINK_FRAME_SYNC0) d->state = ST_SYNC1;
+        else d->resync_bytes++;
+        break;
+
+    case ST_SYNC1:
+        if (byte == LINK_FRAME_SYNC1) {
+            d->state = ST_TYPE;
+            d->crc = CRC16_CCITT_INIT;
+        } else if (byte != LINK_FRAME_SYNC0) {
+            d->resync_bytes += 2;
+            d->state = ST_SYNC0;
+        } else {
+            d->resync_bytes++;     // A5 A5 5A: the second A5 may start the frame
+        }
+        break;
+
+    case ST_TYPE:
+        d->type = byte;
+        d->crc = crc16_ccitt(d->crc, &byte, 1);
+        d->state = ST_SEQ;
+        break;
+
+    case ST_SEQ:
+        d->seq = byte;
+        d->crc = crc16_ccitt(d->crc, &byte, 1);
+        d->state = ST_LEN;
+        break;
+
+    case ST_LEN:
+        d->len = byte;
+        d->index = 0;
+        d->crc = crc16_ccitt(d->crc, &byte, 1);
+        d->state = byte ? ST_PAYLOAD : ST_CRC0;
+        break;
+
+    case ST_PAYLOAD:
+        d->payload[d->index++] = byte;
+        if (d->index == d->len) {
+            d->crc = crc16_ccitt(d->crc, d->payload, d->len);
+            d->state = ST_CRC0;
+        }
+        break;
+
+    case ST_CRC0:
+        d->rx_crc = byte;
+        d->state = ST_CRC1;
+        break;
+
+    case ST_CRC1:
+        d->rx_crc |= (uint16_t)byte << 8;
+        d->state = ST_SYNC0;
+        if (d->rx_crc != d->crc) {
+            d->crc_errors++;
+            return LINK_FRAME_BAD_CRC;
+        }
+        d->frames++;
+        track_seq(d);
+        return LINK_FRAME_READY;
+
+    default:
+        d->state = ST_SYNC0;
+        break;
+    }
+    return LINK_FRAME_NONE;
+}
@@ -0,0 +1,282 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <tkjhat/lock_profiler.h>
+#include <tkjhat/log_hist.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <task.h>
+
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+
+// Save/restore spin lock: locks are registered before the scheduler starts
+// (driver init from main), and the profiled locks are used from both cores
+#define LOCK_NUM                (PICO_SPINLOCK_ID_STRIPED_FIRST + 4)
+
+typedef struct {
+    SemaphoreHandle_t handle;
+    TaskHandle_t holder;            // task that took it (for hold time)
+    uint32_t acquired_us;
+    lock_prof_stats_t stats;
+} profiled_lock_t;
+
+static profiled_lock_t locks[LOCK_PROF_MAX_LOCKS];
+static int lock_count;
+
+static inline uint32_t prof_lock(void) {
+    return spin_lock_blocking(spin_lock_instance(LOCK_NUM));
+}
+
+static inline void prof_unlock(uint32_t save) {
+    spin_unlock(spin_lock_instance(LOCK_NUM), save);
+}
+
+static inline uint32_t now_us(void) {
+    return time_us_32();
+}
+
+static inline bool valid_id(int id) {
+    return id >= 0 && id < lock_count;
+}
+
+static inline unsigned hist_bucket(uint32_t us) {
+    return log_hist_bin(us, 0, LOCK_PROF_HIST_BUCKETS);
+}
+
+static void copy_name(char *dst, const char *src) {
+    strncpy(dst, src ? src : "?", LOCK_PROF_NAME_LEN - 1);
+    dst[LOCK_PROF_NAME_LEN - 1] = '\0';
+}
+
+// Called with the spin lock held
+static void note_owner(lock_prof_stats_t *s, const char *owner) {
+    int free_slot = -1, min_slot = 0;
+    for (int i = 0; i < LOCK_PROF_MAX_OWNERS; i++) {
+        if (s->owners[i].count == 0) {
+            if (free_slot < 0) free_slot = i;
+            continue;
+        }
+        if (strncmp(s->owners[i].name, owner, LOCK_PROF_NAME_LEN) == 0) {
+            s->owners[i].count++;
+            return;
+        }
+        if (s->owners[i].count < s->owners[min_slot].count) min_slot = i;
+    }
+    // Unknown owner: take a free slot or replace the least seen one
+    int slot = free_slot >= 0 ? free_slot : min_slot;
+    copy_name(s->owners[slot].name, owner);
+    s->owners[slot].count = 1;
+}
+
+/* =========================
+ *  API
+ * ========================= */
+int lock_prof_register(SemaphoreHandle_t lock, const char *name) {
+    if (!lock) return -1;
+
+    uint32_t save = prof_lock();
+    for (int i = 0; i < lock_count; i++) {
+        if (locks[i].handle == lock) {
+            prof_unlock(save);
+            return i;
+        }
+    }
+    if (lock_count >= LOCK_PROF_MAX_LOCKS) {
+        prof_unlock(save);
+        return -2;
+    }
+    int id = lock_count;
+    memset(&locks[id], 0, sizeof(locks[id]));
+    locks[id].handle = lock;
+    copy_name(locks[id].stats.name, name);
+    lock_count++;
+    prof_unlock(save);
+    return id;
+}
+
+BaseType_t lock_prof_take(int id, TickType_t wait) {
+    if (!valid_id(id)) return pdFALSE;
+    profiled_lock_t *l = &locks[id];
+
+    // Fast path: lock is free
+    if (xSemaphoreTake(l->handle, 0) == pdTRUE) {
+        TaskHandle_t self = xTaskGetCurrentTaskHandle();
+        uint32_t save = prof_lock();
+        l->stats.acquires++;
+        l->holder = self;
+        l->acquired_us = now_us();
+        prof_unlock(save);
+        return pdTRUE;
+    }
+
+    // Contended. For a mutex, look at who has it. If the owner runs at a
+    // lower priority the kernel is about to raise it (priority inheritance).
+    uint32_t t0 = now_us();
+    TaskHandle_t owner = xSemaphoreGetMutexHolder(l->handle);
+    char owner_name[LOCK_PROF_NAME_LEN];
+    bool inversion = false;
+    if (owner) {
+        copy_name(owner_name, pcTaskGetName(owner));
+        inversion = uxTaskPriorityGet(owner) < uxTaskPriorityGet(NULL);
+    }
+
+    BaseType_t got = wait ? xSemaphoreTake(l->handle, wait) : pdFALSE;
+    uint32_t t1 = now_us();
+    uint32_t waited = t1 - t0;
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+
+    uint32_t save = prof_lock();
+    lock_prof_stats_t *s = &l->stats;
+    s->contended++;
+    if (owner) note_owner(s, owner_name);
+    if (inversion) {
+        s->pi_events++;
+        s->inversion_us += waited;
+    }
+    if (got == pdTRUE) {
+        s->acquires++;
+        s->wait_us_total += waited;
+        if (waited > s->wait_us_max) s->wait_us_max = waited;
+        s->wait_hist[hist_bucket(waited)]++;
+        l->holder = self;
+        l->acquired_us = t1;
+    } else {
+        s->timeouts++;
+    }
+    prof_unlock(save);
+    return got;
+}
+
+BaseType_t lock_prof_give(int id) {
+    if (!valid_id(id)) return pdFALSE;
+    profiled_lock_t *l = &locks[id];
+
+    // Record before giving: once given, another task may take it
+    uint32_t t = now_us();
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    uint32_t save = prof_lock();
+    if (l->holder && l->holder == self) {
+        lock_prof_stats_t *s = &l->stats;
+        uint32_t held = t - l->acquired_us;
+        s->holds++;
+        s->hold_us_total += held;
+        if (held > s->hold_us_max) s->hold_us_max = held;
+        s->hold_hist[hist_bucket(held)]++;
+    }
+    l->holder = NULL;
+    prof_unlock(save);
+
+    return xSemaphoreGive(l->handle);
+}
+
+int lock_prof_get(int id, lock_prof_stats_t *out) {
+    if (!valid_id(id) || !out) return -1;
+    uint32_t save = prof_lock();
+    *out = locks[id].stats;
+    prof_unlock(save);
+    return 0;
+}
+
+void lock_prof_reset(void) {
+    uint32_t save = prof_lock();
+    for (int i = 0; i < lock_count; i++) {
+        char name[LOCK_PROF_NAME_LEN];
+        memcpy(name, locks[i].stats.name, sizeof(name));
+        memset(&locks[i].stats, 0, sizeof(locks[i].stats));
+        memcpy(locks[i].stats.name, name, sizeof(name));
+    }
+    prof_unlock(save);
+}
+
+/* =========================
+ *  Report
+ * ========================= */
+// Upper edge (us) of the bucket that contains the p-th percentile
+static uint32_t hist_percentile(const uint32_t *hist, uint32_t total, uint32_t pct) {
+    if (total == 0) return 0;
+    uint64_t target = ((uint64_t)total * pct + 99) / 100;
+    int b = log_hist_bins_find(hist, LOCK_PROF_HIST_BUCKETS, target);
+    if (b < 0) b = LOCK_PROF_HIST_BUCKETS - 1;
+    return log_hist_bin_upper((unsigned)b, 0) + 1u;
+}
+
+int lock_prof_format_report(char *buf, size_t len, int max_locks) {
+    if (!buf || len == 0) return 0;
+    buf[0] = '\0';
+
+    static lock_prof_stats_t snap[LOCK_PROF_MAX_LOCKS];
+    int order[LOCK_PROF_MAX_LOCKS];
+    int count = lock_count;
+
+    uint32_t save = prof_lock();
+    for (int i = 0; i < count; i++) snap[i] = locks[i].stats;
+    prof_unlock(save);
+
+    // Hottest first (insertion sort, few locks)
+    for (int i = 0; i < count; i++) {
+        int j = i;
+        while (j > 0 && snap[order[j - 1]].wait_us_total < snap[i].wait_us_total) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+    if (max_locks <= 0 || max_locks > count) max_locks = count;
+
+    size_t pos = 0;
+    int n;
+    for (int k = 0; k < max_locks && pos < len; k++) {
+        const lock_prof_stats_t *s = &snap[order[k]];
+        uint32_t attempts = s->acquires + s->timeouts;
+        uint32_t cont_pct = attempts ? (uint32_t)((100ull * s->contended) / attempts) : 0;
+        uint32_t waits = s->contended - s->timeouts;
+        uint32_t wait_avg = waits ? (uint32_t)(s->wait_us_total / waits) : 0;
+        uint32_t hold_avg = s->holds ? (uint32_t)(s->hold_us_total / s->holds) : 0;
+
+        const lock_prof_owner_t *top = NULL;
+        for (int o = 0; o < LOCK_PROF_MAX_OWNERS; o++) {
+            if (s->owners[o].count && (!top || s->owners[o].count > top->count)) top = &s->owners[o];
+        }
+
+        n = snprintf(buf + pos, len - pos,
+                     "[lock] %-*s acq=%lu cont=%lu%% to=%lu wait avg/p99/max=%lu/%lu/%luus "
+                     "hold avg/max=%lu/%luus pi=%lu inv=%luus owner=%s\n",
+                     LOCK_PROF_NAME_LEN - 1, s->name,
+                     (unsigned long)s->acquires, (unsigned long)cont_pct, (unsigned long)s->timeouts,
+                     (unsigned long)wait_avg, (unsigned long)hist_percentile(s->wait_hist, waits, 99),
+                     (unsigned long)s->wait_us_max,
+                     (unsigned long)hold_avg, (unsigned long)s->hold_us_max,
+                     (unsigned long)s->pi_events, (unsigned long)s->inversion_us,
+                     top ? top->name : "-");
+        if (n < 0) break;
+        pos += (size_t)n;
+    }
+    return (int)(pos < len ? pos : len - 1);
+}
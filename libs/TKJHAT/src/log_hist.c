@@ -0,0 +1,213 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <tkjhat/log_hist.h>
+
+#include <string.h>
+
+#define SERIAL_MAGIC            'H'
+
+/* =========================
+ *  Bin helpers
+ * ========================= */
+uint32_t log_hist_bin_lower(unsigned index, unsigned sub_bits) {
+    if (index < (1u << sub_bits)) return index;
+    unsigned e = (index >> sub_bits) + sub_bits - 1u;
+    uint32_t mant = index & ((1u << sub_bits) - 1u);
+    return ((1u << sub_bits) | mant) << (e - sub_bits);
+}
+
+uint32_t log_hist_bin_upper(unsigned index, unsigned sub_bits) {
+    if (index < (1u << sub_bits)) return index;
+    unsigned e = (index >> sub_bits) + sub_bits - 1u;
+    return log_hist_bin_lower(index, sub_bits) + ((1u << (e - sub_bits)) - 1u);
+}
+
+int log_hist_bins_find(const uint32_t *bins, unsigned nbins, uint64_t rank) {
+    if (rank == 0) rank = 1;
+    uint64_t acc = 0;
+    for (unsigned i = 0; i < nbins; i++) {
+        acc += bins[i];
+        if (acc >= rank) return (int)i;
+    }
+    return -1;
+}
+
+/* =========================
+ *  Histogram
+ * ========================= */
+void log_hist_init(log_hist_t *h) {
+    memset(h, 0, sizeof(*h));
+    h->min = UINT32_MAX;
+}
+
+void log_hist_add(log_hist_t *h, uint32_t value) {
+    h->bins[log_hist_bin(value, LOG_HIST_SUB_BITS, LOG_HIST_BINS)]++;
+    h->count++;
+    h->sum += value;
+    if (value < h->min) h->min = value;
+    if (value > h->max) h->max = value;
+}
+
+void log_hist_merge(log_hist_t *dst, const log_hist_t *src) {
+    for (unsigned i = 0; i < LOG_HIST_BINS; i++) dst->bins[i] += src->bins[i];
+    dst->count += src->count;
+    dst->sum += src->sum;
+    if (src->min < dst->min) dst->min = src->min;
+    if (src->max > dst->max) dst->max = src->max;
+}
+
+uint32_t log_hist_quantile(const log_hist_t *h, float q) {
+    if (h->count == 0) return 0;
+    if (q <= 0.0f) return h->min;
+    if (q >= 1.0f) return h->max;
+
+    // Smallest rank r with r >= q * count
+    double want = (double)q * (double)h->count;
+    uint64_t rank = (uint64_t)want;
+    if ((double)rank < want) rank++;
+    int i = log_hist_bins_find(h->bins, LOG_HIST_BINS, rank);
+    if (i < 0) return h->max;
+
+    uint32_t lo = log_hist_bin_lower((unsigned)i, LOG_HIST_SUB_BITS);
+    uint32_t hi = (i == LOG_HIST_BINS - 1) ? h->max : log_hist_bin_upper((unsigned)i, LOG_HIST_SUB_BITS);
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (mid < h->min) mid = h->min;
+    if (mid > h->max) mid = h->max;
+    return mid;
+}
+
+float log_hist_rank(const log_hist_t *h, uint32_t value) {
+    if (h->count == 0) return 0.0f;
+    if (value < h->min) return 0.0f;
+    if (value >= h->max) return 1.0f;
+
+    unsigned last = log_hist_bin(value, LOG_HIST_SUB_BITS, LOG_HIST_BINS);
+    uint64_t acc = 0;
+    for (unsigned i = 0; i < last; i++) acc += h->bins[i];
+    // Values are assumed to be spread evenly inside the bin
+    uint32_t lo = log_hist_bin_lower(last, LOG_HIST_SUB_BITS);
+    uint32_t hi = (last == LOG_HIST_BINS - 1) ? h->max : log_hist_bin_upper(last, LOG_HIST_SUB_BITS);
+    float frac = (float)(value - lo + 1u) / (float)(hi - lo + 1u);
+    return ((float)acc + frac * (float)h->bins[last]) / (float)h->count;
+}
+
+/* =========================
+ *  Serialization
+ * ========================= */
+// Unsigned LEB128
+static size_t put_varint(uint8_t *p, uint64_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+static int get_varint(const uint8_t *buf, size_t len, size_t *pos, uint64_t *out) {
+    uint64_t v = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (*pos >= len) return -1;
+        uint8_t b = buf[(*pos)++];
+        v |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            *out = v;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int log_hist_serialize(const log_hist_t *h, uint8_t *buf, size_t len) {
+    unsigned used = 0;
+    for (unsigned i = 0; i < LOG_HIST_BINS; i++) if (h->bins[i]) used++;
+
+    // Exact size first, so nothing is written into a buffer that is too small
+    uint8_t tmp[10];
+    size_t need = 3 + put_varint(tmp, LOG_HIST_BINS) + put_varint(tmp, h->count) +
+                  put_varint(tmp, h->sum) + put_varint(tmp, h->min) +
+                  put_varint(tmp, h->max) + put_varint(tmp, used);
+    unsigned prev = 0;
+    for (unsigned i = 0; i < LOG_HIST_BINS; i++) {
+        if (!h->bins[i]) continue;
+        need += put_varint(tmp, i - prev) + put_varint(tmp, h->bins[i]);
+        prev = i;
+    }
+    if (len < need) return -1;
+
+    size_t pos = 0;
+    buf[pos++] = SERIAL_MAGIC;
+    buf[pos++] = LOG_HIST_SERIAL_VERSION;
+    buf[pos++] = LOG_HIST_SUB_BITS;
+    pos += put_varint(buf + pos, LOG_HIST_BINS);
+    pos += put_varint(buf + pos, h->count);
+    pos += put_varint(buf + pos, h->sum);
+    pos += put_varint(buf + pos, h->min);
+    pos += put_varint(buf + pos, h->max);
+    pos += put_varint(buf + pos, used);
+    // Non-empty bins as (distance from the previous one, count)
+    prev = 0;
+    for (unsigned i = 0; i < LOG_HIST_BINS; i++) {
+        if (!h->bins[i]) continue;
+        pos += put_varint(buf + pos, i - prev);
+        pos += put_varint(buf + pos, h->bins[i]);
+        prev = i;
+    }
+    return (int)pos;
+}
+
+int log_hist_deserialize(log_hist_t *h, const uint8_t *buf, size_t len) {
+    if (len < 3 || buf[0] != SERIAL_MAGIC || buf[1] != LOG_HIST_SERIAL_VERSION) return -1;
+    if (buf[2] != LOG_HIST_SUB_BITS) return -2;
+
+    size_t pos = 3;
+    uint64_t nbins, count, sum, min, max, used;
+    if (get_varint(buf, len, &pos, &nbins) || get_varint(buf, len, &pos, &count) ||
+        get_varint(buf, len, &pos, &sum) || get_varint(buf, len, &pos, &min) ||
+        get_varint(buf, len, &pos, &max) || get_varint(buf, len, &pos, &used)) return -1;
+    if (count > UINT32_MAX || min > UINT32_MAX || max > UINT32_MAX || used > nbins) return -1;
+
+    log_hist_init(h);
+    h->count = (uint32_t)count;
+    h->sum = sum;
+    h->min = (uint32_t)min;
+    h->max = (uint32_t)max;
+
+    uint64_t index = 0, total = 0;
+    for (uint64_t k = 0; k < used; k++) {
+        uint64_t gap, c;
+        if (get_varint(buf, len, &pos, &gap) || get_varint(buf, len, &pos, &c)) return -1;
+        index += gap;
+        if (index >= nbins || c > UINT32_MAX) return -1;
+        h->bins[index < LOG_HIST_BINS ? index : LOG_HIST_BINS - 1] += (uint32_t)c;
+        total += c;
+    }
+    if (total != count) return -1;
+    return (int)pos;
+}
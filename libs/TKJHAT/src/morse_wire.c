@@ -0,0 +1,247 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <tkjhat/morse_wire.h>
+
+#include <string.h>
+
+#define CODE_END                                0
+#define CODE_DOT                                1
+#define CODE_DASH                               2
+#define CODE_GAP                                3
+
+static const char code_symbol[4] = { 0, '.', '-', ' ' };
+
+static int symbol_code(char c) {
+    switch (c) {
+    case '.': return CODE_DOT;
+    case '-': return CODE_DASH;
+    case ' ': return CODE_GAP;
+    default:  return -1;
+    }
+}
+
+/* =========================
+ *  TX
+ * ========================= */
+static bool write_frame(morse_wire_t *w, const uint8_t *frame, size_t len) {
+    if (!w->cfg.write || !w->cfg.write(w->cfg.ctx, frame, len)) return false;
+    w->stats.tx_bytes += (uint32_t)len;
+    return true;
+}
+
+static void queue_put(morse_wire_t *w, uint8_t byte) {
+    w->queue[(w->q_head + w->q_used) % MORSE_WIRE_TX_QUEUE] = byte;
+    w->q_used++;
+}
+
+// Moves up to a batch of queued bytes into the frame in flight and sends it
+static void start_batch(morse_wire_t *w, uint32_t now_ms) {
+    uint8_t payload[LINK_FRAME_MAX_PAYLOAD];
+    size_t n = w->q_used < MORSE_WIRE_BATCH_MAX ? w->q_used : MORSE_WIRE_BATCH_MAX;
+
+    payload[0] = MORSE_WIRE_BATCH | (w->synced ? 0 : MORSE_WIRE_SYNC);
+    payload[1] = w->tx_id++;
+    for (size_t i = 0; i < n; i++) payload[MORSE_WIRE_HEADER + i] = w->queue[(w->q_head + i) % MORSE_WIRE_TX_QUEUE];
+    w->q_head = (uint16_t)((w->q_head + n) % MORSE_WIRE_TX_QUEUE);
+    w->q_used = (uint16_t)(w->q_used - n);
+
+    w->frame_len = (uint16_t)link_frame_encode(LINK_FRAME_DATA, w->tx_seq++, payload, n + MORSE_WIRE_HEADER,
+                                               w->frame, sizeof(w->frame));
+    w->first_sent_ms = w->sent_ms = now_ms;
+    w->stats.tx_batches++;
+    write_frame(w, w->frame, w->frame_len);     // retransmitted by poll if it failed
+}
+
+static void send_ack(morse_wire_t *w, uint8_t id) {
+    uint8_t payload[MORSE_WIRE_HEADER] = { MORSE_WIRE_ACK, id };
+    uint8_t frame[MORSE_WIRE_HEADER + LINK_FRAME_OVERHEAD];
+    size_t len = link_frame_encode(LINK_FRAME_DATA, w->tx_seq++, payload, sizeof(payload), frame, sizeof(frame));
+    write_frame(w, frame, len);
+}
+
+static void on_ack(morse_wire_t *w, uint8_t id, uint32_t now_ms) {
+    // Frame in flight: sync, sync, type, seq, len, kind, id, ...
+    if (!w->frame_len || w->frame[6] != id) return;
+    if (w->frame[5] & MORSE_WIRE_SYNC) w->synced = true;
+    w->frame_len = 0;
+    w->stats.acks++;
+    w->stats.rtt_last_ms = now_ms - w->first_sent_ms;
+    if (w->stats.rtt_last_ms > w->stats.rtt_max_ms) w->stats.rtt_max_ms = w->stats.rtt_last_ms;
+    if (w->q_used) start_batch(w, now_ms);
+}
+
+/* =========================
+ *  RX
+ * ========================= */
+static void deliver(morse_wire_t *w) {
+    if (w->msg_truncated) w->stats.rx_truncated++;
+    w->stats.rx_messages++;
+    if (w->cfg.on_message) w->cfg.on_message(w->cfg.ctx, w->msg, w->msg_len);
+    w->msg_len = 0;
+    w->msg_truncated = false;
+}
+
+static void append(morse_wire_t *w, char c) {
+    if (w->msg_len < MORSE_WIRE_MAX_MESSAGE) w->msg[w->msg_len++] = c;
+    else w->msg_truncated = true;
+}
+
+static void unpack(morse_wire_t *w, const uint8_t *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        for (int shift = 6; shift >= 0; shift -= 2) {
+            int code = (data[i] >> shift) & 3;
+            if (code == CODE_END) {
+                deliver(w);
+                break;              // rest of the byte is padding
+            }
+            append(w, code_symbol[code]);
+        }
+    }
+}
+
+static void on_frame(morse_wire_t *w, uint32_t now_ms) {
+    const link_frame_decoder_t *d = &w->dec;
+    if (d->type != LINK_FRAME_DATA || d->len < MORSE_WIRE_HEADER) {
+        w->stats.rx_bad_frames++;
+        return;
+    }
+    uint8_t kind = d->payload[0];
+    uint8_t id = d->payload[1];
+
+    if (kind == MORSE_WIRE_ACK) {
+        w->peer_compact = true;
+        on_ack(w, id, now_ms);
+        return;
+    }
+    if ((kind & ~MORSE_WIRE_SYNC) != MORSE_WIRE_BATCH) {
+        w->stats.rx_bad_frames++;
+        return;
+    }
+    w->peer_compact = true;
+    // Same id again: our ACK was lost. A SYNC batch only repeats a SYNC batch;
+    // otherwise the peer restarted and its ids began again.
+    bool sync = (kind & MORSE_WIRE_SYNC) != 0;
+    if (w->have_rx_id && id == w->rx_id && sync == w->rx_sync) {
+        w->stats.rx_duplicates++;
+    } else {
+        if (sync) {
+            w->msg_len = 0;             // the sender started over
+            w->msg_truncated = false;
+        }
+        w->rx_id = id;
+        w->rx_sync = sync;
+        w->have_rx_id = true;
+        w->stats.rx_batches++;
+        unpack(w, &d->payload[MORSE_WIRE_HEADER], d->len - MORSE_WIRE_HEADER);
+    }
+    send_ack(w, id);
+}
+
+// A byte outside a frame: ASCII format, "...  \n" per message
+static void on_ascii(morse_wire_t *w, uint8_t byte) {
+    if (byte == '\n') {
+        w->stats.rx_ascii_messages++;
+        deliver(w);
+    } else if (symbol_code((char)byte) >= 0) {
+        append(w, (char)byte);
+    }
+    // '\r' and anything else is ignored
+}
+
+/* =========================
+ *  API
+ * ========================= */
+void morse_wire_init(morse_wire_t *w, const morse_wire_config_t *cfg) {
+    static const morse_wire_config_t defaults = MORSE_WIRE_DEFAULT_CONFIG;
+    memset(w, 0, sizeof(*w));
+    w->cfg = cfg ? *cfg : defaults;
+    link_frame_decoder_init(&w->dec);
+}
+
+void morse_wire_reset(morse_wire_t *w) {
+    w->q_head = w->q_used = 0;
+    w->frame_len = 0;
+    w->synced = false;
+    w->msg_len = 0;
+    w->msg_truncated = false;
+    w->have_rx_id = false;
+    w->peer_compact = false;
+    link_frame_decoder_init(&w->dec);
+}
+
+int morse_wire_send(morse_wire_t *w, const char *symbols, size_t len, uint32_t now_ms) {
+    while (len && (symbols[len - 1] == '\n' || symbols[len - 1] == '\r')) len--;
+    for (size_t i = 0; i < len; i++)
+        if (symbol_code(symbols[i]) < 0) return MORSE_WIRE_ERR_SYMBOL;
+    if (morse_wire_packed_size(len) > (size_t)(MORSE_WIRE_TX_QUEUE - w->q_used)) return MORSE_WIRE_ERR_FULL;
+
+    uint8_t byte = 0;
+    int shift = 6;
+    for (size_t i = 0; i < len; i++) {
+        byte |= (uint8_t)(symbol_code(symbols[i]) << shift);
+        shift -= 2;
+        if (shift < 0) {
+            queue_put(w, byte);
+            byte = 0;
+            shift = 6;
+        }
+    }
+    queue_put(w, byte);                 // holds the end code (0) and the padding
+    w->stats.tx_messages++;
+
+    if (!w->frame_len) start_batch(w, now_ms);
+    return 0;
+}
+
+void morse_wire_feed(morse_wire_t *w, const uint8_t *data, size_t len, uint32_t now_ms) {
+    for (size_t i = 0; i < len; i++) {
+        uint8_t b = data[i];
+        if (link_frame_decoder_idle(&w->dec) && b != LINK_FRAME_SYNC0) {
+            on_ascii(w, b);
+            continue;
+        }
+        link_frame_result_t r = link_frame_decode_byte(&w->dec, b);
+        if (r == LINK_FRAME_READY) on_frame(w, now_ms);
+        else if (r == LINK_FRAME_BAD_CRC) w->stats.rx_bad_frames++;
+    }
+}
+
+void morse_wire_poll(morse_wire_t *w, uint32_t now_ms) {
+    if (w->frame_len) {
+        if (now_ms - w->sent_ms < w->cfg.ack_timeout_ms) return;
+        w->sent_ms = now_ms;
+        w->stats.tx_retransmits++;
+        write_frame(w, w->frame, w->frame_len);
+    } else if (w->q_used) {
+        start_batch(w, now_ms);
+    }
+}
+
+void morse_wire_hello(morse_wire_t *w, uint32_t now_ms) {
+    if (!w->frame_len) start_batch(w, now_ms);
+}
@@ -114,6 +114,38 @@ int32_t filter_table_stereo_128(uint8_t *data, uint8_t sincn)
 }
 int32_t (* filter_tables_64[2]) (uint8_t *data, uint8_t sincn) = {filter_table_mono_64, filter_table_stereo_64};
 int32_t (* filter_tables_128[2]) (uint8_t *data, uint8_t sincn) = {filter_table_mono_128, filter_table_stereo_128};
+ 
+/*
+ * Word input (mono only). Each 32-bit word holds 32 PDM samples with the
+ * oldest sample in bit 31, as produced by a left-shifting 32-bit autopush.
+ */
+int32_t filter_table_mono_64_w(uint32_t *data, uint8_t sincn)
+{
+  uint32_t w0 = data[0];
+  uint32_t w1 = data[1];
+  return (int32_t)
+    lut[ w0 >> 24        ][0][sincn] +
+    lut[(w0 >> 16) & 0xff][1][sincn] +
+    lut[(w0 >>  8) & 0xff][2][sincn] +
+    lut[ w0        & 0xff][3][sincn] +
+    lut[ w1 >> 24        ][4][sincn] +
+    lut[(w1 >> 16) & 0xff][5][sincn] +
+    lut[(w1 >>  8) & 0xff][6][sincn] +
+    lut[ w1        & 0xff][7][sincn];
+}
+int32_t filter_table_mono_128_w(uint32_t *data, uint8_t sincn)
+{
+  return filter_table_mono_64_w(data, sincn) +
+         (int32_t)
+    lut[ data[2] >> 24        ][8][sincn] +
+    lut[(data[2] >> 16) & 0xff][9][sincn] +
+    lut[(data[2] >>  8) & 0xff][10][sincn] +
+    lut[ data[2]        & 0xff][11][sincn] +
+    lut[ data[3] >> 24        ][12][sincn] +
+    lut[(data[3] >> 16) & 0xff][13][sincn] +
+    lut[(data[3] >>  8) & 0xff][14][sincn] +
+    lut[ data[3]        & 0xff][15][sincn];
+}
 #else
 int32_t filter_table(uint8_t *data, uint8_t sincn, TPDMFilter_InitStruct *param)
 {
@@ -138,6 +170,27 @@ int32_t filter_table(uint8_t *data, uint8_t sincn, TPDMFilter_InitStruct *param)
   }
   return F;
 }
+ 
+int32_t filter_table_w(uint32_t *data, uint8_t sincn, TPDMFilter_InitStruct *param)
+{
+  uint8_t c, i;
+  uint32_t *coef_p = &coef[sincn][0];
+  int32_t F = 0;
+  uint8_t decimation = param->Decimation;
+ 
+  for (i = 0; i < decimation; i += 8) {
+    c = (uint8_t)(data[i >> 5] >> (24 - (i & 0x18)));
+    F += ((c >> 7)       ) * coef_p[i    ] +
+         ((c >> 6) & 0x01) * coef_p[i + 1] +
+         ((c >> 5) & 0x01) * coef_p[i + 2] +
+         ((c >> 4) & 0x01) * coef_p[i + 3] +
+         ((c >> 3) & 0x01) * coef_p[i + 4] +
+         ((c >> 2) & 0x01) * coef_p[i + 5] +
+         ((c >> 1) & 0x01) * coef_p[i + 6] +
+         ((c     ) & 0x01) * coef_p[i + 7];
+  }
+  return F;
+}
 #endif
  
 void convolve(uint32_t Signal[/* SignalLen */], unsigned short SignalLen,
@@ -312,3 +365,90 @@ void Open_PDM_Filter_128(uint8_t* data, uint16_t* dataOut, uint16_t volume, TPDM
   Param->OldZ = OldZ;
 }
  
+ 
+void Open_PDM_Filter_64_W(uint32_t* data, uint16_t* dataOut, uint16_t volume, TPDMFilter_InitStruct *Param)
+{
+  uint8_t i, data_out_index;
+  uint8_t data_inc = (DECIMATION_MAX >> 6);
+  int64_t Z, Z0, Z1, Z2;
+  int64_t OldOut, OldIn, OldZ;
+ 
+  OldOut = Param->OldOut;
+  OldIn = Param->OldIn;
+  OldZ = Param->OldZ;
+ 
+  for (i = 0, data_out_index = 0; i < Param->Fs / 1000; i++, data_out_index++) {
+#ifdef USE_LUT
+    Z0 = filter_table_mono_64_w(data, 0);
+    Z1 = filter_table_mono_64_w(data, 1);
+    Z2 = filter_table_mono_64_w(data, 2);
+#else
+    Z0 = filter_table_w(data, 0, Param);
+    Z1 = filter_table_w(data, 1, Param);
+    Z2 = filter_table_w(data, 2, Param);
+#endif
+ 
+    Z = Param->Coef[1] + Z2 - sub_const;
+    Param->Coef[1] = Param->Coef[0] + Z1;
+    Param->Coef[0] = Z0;
+ 
+    OldOut = (Param->HP_ALFA * (OldOut + Z - OldIn)) >> 8;
+    OldIn = Z;
+    OldZ = ((256 - Param->LP_ALFA) * OldZ + Param->LP_ALFA * OldOut) >> 8;
+ 
+    Z = OldZ * volume;
+    Z = RoundDiv(Z, div_const);
+    Z = SaturaLH(Z, -32700, 32700);
+ 
+    dataOut[data_out_index] = Z;
+    data += data_inc;
+  }
+ 
+  Param->OldOut = OldOut;
+  Param->OldIn = OldIn;
+  Param->OldZ = OldZ;
+}
+ 
+void Open_PDM_Filter_128_W(uint32_t* data, uint16_t* dataOut, uint16_t volume, TPDMFilter_InitStruct *Param)
+{
+  uint8_t i, data_out_index;
+  uint8_t data_inc = (DECIMATION_MAX >> 5);
+  int64_t Z, Z0, Z1, Z2;
+  int64_t OldOut, OldIn, OldZ;
+ 
+  OldOut = Param->OldOut;
+  OldIn = Param->OldIn;
+  OldZ = Param->OldZ;
+ 
+  for (i = 0, data_out_index = 0; i < Param->Fs / 1000; i++, data_out_index++) {
+#ifdef USE_LUT
+    Z0 = filter_table_mono_128_w(data, 0);
+    Z1 = filter_table_mono_128_w(data, 1);
+    Z2 = filter_table_mono_128_w(data, 2);
+#else
+    Z0 = filter_table_w(data, 0, Param);
+    Z1 = filter_table_w(data, 1, Param);
+    Z2 = filter_table_w(data, 2, Param);
+#endif
+ 
+    Z = Param->Coef[1] + Z2 - sub_const;
+    Param->Coef[1] = Param->Coef[0] + Z1;
+    Param->Coef[0] = Z0;
+ 
+    OldOut = (Param->HP_ALFA * (OldOut + Z - OldIn)) >> 8;
+    OldIn = Z;
+    OldZ = ((256 - Param->LP_ALFA) * OldZ + Param->LP_ALFA * OldOut) >> 8;
+ 
+    Z = OldZ * volume;
+    Z = RoundDiv(Z, div_const);
+    Z = SaturaLH(Z, -32700, 32700);
+ 
+    dataOut[data_out_index] = Z;
+    data += data_inc;
+  }
+ 
+  Param->OldOut = OldOut;
+  Param->OldIn = OldIn;
+  Param->OldZ = OldZ;
+}
+ 
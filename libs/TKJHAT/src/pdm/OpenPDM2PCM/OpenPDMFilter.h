@@ -96,6 +96,13 @@ void Open_PDM_Filter_Init(TPDMFilter_InitStruct *init_struct);
 void Open_PDM_Filter_64(uint8_t* data, uint16_t* data_out, uint16_t mic_gain, TPDMFilter_InitStruct *init_struct);
 void Open_PDM_Filter_128(uint8_t* data, uint16_t* data_out, uint16_t mic_gain, TPDMFilter_InitStruct *init_struct);
  
+/*
+ * Word input variants (mono only): data holds 32-bit words with the oldest
+ * PDM bit in bit 31, i.e. the raw output of a left-shifting 32-bit autopush.
+ */
+void Open_PDM_Filter_64_W(uint32_t* data, uint16_t* data_out, uint16_t mic_gain, TPDMFilter_InitStruct *init_struct);
+void Open_PDM_Filter_128_W(uint32_t* data, uint16_t* data_out, uint16_t mic_gain, TPDMFilter_InitStruct *init_struct);
+ 
 #ifdef __cplusplus
 }
 #endif
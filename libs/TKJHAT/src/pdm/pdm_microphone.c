@@ -19,6 +19,10 @@
 #include "pdm_microphone.pio.h"
 
 #include <tkjhat/pdm_microphone.h>
+#include <tkjhat/agc.h>
+#include <tkjhat/hw_res.h>
+#include <tkjhat/sram.h>
+#include <tkjhat/xip_prof.h>
 
 #define PDM_DECIMATION       64
 #define PDM_RAW_BUFFER_COUNT 2
@@ -26,14 +30,18 @@
 static struct {
     struct pdm_microphone_config config;
     int dma_channel;
+    hw_res_pio_t pio_res;
     uint8_t* raw_buffer[PDM_RAW_BUFFER_COUNT];
     volatile int raw_buffer_write_index;
     volatile int raw_buffer_read_index;
     uint raw_buffer_size;
+    uint dma_transfer_count;
     uint dma_irq;
     TPDMFilter_InitStruct filter;
     uint16_t filter_volume;
     pdm_samples_ready_handler_t samples_ready_handler;
+    agc_t* agc;
+    volatile uint32_t overruns;
     volatile bool stopping; 
 } pdm_mic;
 
@@ -45,6 +53,7 @@ int pdm_microphone_init(const struct pdm_microphone_config* config) {
     memset(&pdm_mic, 0x00, sizeof(pdm_mic));
     memcpy(&pdm_mic.config, config, sizeof(pdm_mic.config));
 
+    pdm_mic.dma_channel = -1;
     pdm_mic.stopping = false;
 
     if (config->sample_buffer_size % (config->sample_rate / 1000)) {
@@ -54,7 +63,8 @@ int pdm_microphone_init(const struct pdm_microphone_config* config) {
     pdm_mic.raw_buffer_size = config->sample_buffer_size * (PDM_DECIMATION / 8);
 
     for (int i = 0; i < PDM_RAW_BUFFER_COUNT; i++) {
-        pdm_mic.raw_buffer[i] = malloc(pdm_mic.raw_buffer_size);
+        // DMA target: keep it off the banks the cores use (tkjhat/sram.h)
+        pdm_mic.raw_buffer[i] = sram_dma_alloc(pdm_mic.raw_buffer_size, 4);
         if (pdm_mic.raw_buffer[i] == NULL) {
             pdm_microphone_deinit();
 
@@ -62,29 +72,55 @@ int pdm_microphone_init(const struct pdm_microphone_config* config) {
         }
     }
 
-    pdm_mic.dma_channel = dma_claim_unused_channel(true);
+    pdm_mic.dma_channel = hw_res_dma_claim("mic");
     if (pdm_mic.dma_channel < 0) {
         pdm_microphone_deinit();
 
         return -1;
     }
 
-    uint pio_sm_offset = pio_add_program(config->pio, &pdm_microphone_data_program);
+    // Any block with a free state machine and room for the program, unless config->pio names one
+    const pio_program_t *program = config->capture_width == PDM_CAPTURE_32BIT
+        ? &pdm_microphone_data_32_program : &pdm_microphone_data_program;
+    if (hw_res_pio_claim("mic", program, config->pio, &pdm_mic.pio_res) != 0) {
+        pdm_microphone_deinit();
+
+        return -1;
+    }
+    pdm_mic.config.pio = pdm_mic.pio_res.pio;
+    pdm_mic.config.pio_sm = pdm_mic.pio_res.sm;
+    config = &pdm_mic.config;
 
     float clk_div = clock_get_hz(clk_sys) / (config->sample_rate * PDM_DECIMATION * 4.0);
 
-    pdm_microphone_data_init(
-        config->pio,
-        config->pio_sm,
-        pio_sm_offset,
-        clk_div,
-        config->gpio_data,
-        config->gpio_clk
-    );
+    if (config->capture_width == PDM_CAPTURE_32BIT) {
+        pdm_microphone_data_32_init(
+            config->pio,
+            config->pio_sm,
+            pdm_mic.pio_res.offset,
+            clk_div,
+            config->gpio_data,
+            config->gpio_clk
+        );
+
+        pdm_mic.dma_transfer_count = pdm_mic.raw_buffer_size / 4;
+    } else {
+        pdm_microphone_data_init(
+            config->pio,
+            config->pio_sm,
+            pdm_mic.pio_res.offset,
+            clk_div,
+            config->gpio_data,
+            config->gpio_clk
+        );
+
+        pdm_mic.dma_transfer_count = pdm_mic.raw_buffer_size;
+    }
 
     dma_channel_config dma_channel_cfg = dma_channel_get_default_config(pdm_mic.dma_channel);
 
-    channel_config_set_transfer_data_size(&dma_channel_cfg, DMA_SIZE_8);
+    channel_config_set_transfer_data_size(&dma_channel_cfg,
+        config->capture_width == PDM_CAPTURE_32BIT ? DMA_SIZE_32 : DMA_SIZE_8);
     channel_config_set_read_increment(&dma_channel_cfg, false);
     channel_config_set_write_increment(&dma_channel_cfg, true);
     channel_config_set_dreq(&dma_channel_cfg, pio_get_dreq(config->pio, config->pio_sm, false));
@@ -96,7 +132,7 @@ int pdm_microphone_init(const struct pdm_microphone_config* config) {
         &dma_channel_cfg,
         pdm_mic.raw_buffer[0],
         &config->pio->rxf[config->pio_sm],
-        pdm_mic.raw_buffer_size,
+        pdm_mic.dma_transfer_count,
         false
     );
 
@@ -116,17 +152,23 @@ int pdm_microphone_init(const struct pdm_microphone_config* config) {
 void pdm_microphone_deinit() {
     for (int i = 0; i < PDM_RAW_BUFFER_COUNT; i++) {
         if (pdm_mic.raw_buffer[i]) {
-            free(pdm_mic.raw_buffer[i]);
+            sram_dma_free(pdm_mic.raw_buffer[i]);
 
             pdm_mic.raw_buffer[i] = NULL;
         }
     }
 
     if (pdm_mic.dma_channel > -1) {
-        dma_channel_unclaim(pdm_mic.dma_channel);
+        hw_res_dma_release(pdm_mic.dma_channel);
 
         pdm_mic.dma_channel = -1;
     }
+
+    hw_res_irq_remove(pdm_mic.dma_irq, pdm_dma_handler);
+    if (pdm_mic.pio_res.pio) {
+        pio_sm_set_enabled(pdm_mic.pio_res.pio, pdm_mic.pio_res.sm, false);
+        hw_res_pio_release(&pdm_mic.pio_res);
+    }
 }
 
 int pdm_microphone_start() {
@@ -138,7 +180,9 @@ int pdm_microphone_start() {
     pio_sm_restart(pdm_mic.config.pio, pdm_mic.config.pio_sm);
 
     // Install handler and clear any stale pending IRQ
-    irq_set_exclusive_handler(pdm_mic.dma_irq, pdm_dma_handler);
+    if (hw_res_irq_set_exclusive("mic", pdm_mic.dma_irq, pdm_dma_handler) != 0) {
+        return -1;
+    }
     if (pdm_mic.dma_irq == DMA_IRQ_0) {
         dma_hw->ints0 = (1u << pdm_mic.dma_channel);      // clear pending
         dma_channel_set_irq0_enabled(pdm_mic.dma_channel, true);
@@ -157,11 +201,13 @@ int pdm_microphone_start() {
 
     pdm_mic.raw_buffer_write_index = 0;
     pdm_mic.raw_buffer_read_index  = 0;
+    pdm_mic.overruns = 0;
+    pdm_mic.config.pio->fdebug = 1u << (PIO_FDEBUG_RXSTALL_LSB + pdm_mic.config.pio_sm);
 
     dma_channel_transfer_to_buffer_now(
         pdm_mic.dma_channel,
         pdm_mic.raw_buffer[0],
-        pdm_mic.raw_buffer_size
+        pdm_mic.dma_transfer_count
     );
 
     return 0;
@@ -202,19 +248,34 @@ static void pdm_dma_handler() {
     if (pdm_mic.stopping) return;  // don't re-arm or callback while stopping
 
     // normal handler body
+    XIP_PROF_ISR_ENTER(XIP_PROF_ISR_PDM);
+    hw_res_dma_note(pdm_mic.dma_channel, pdm_mic.raw_buffer_size);
+
+    // With autopush a full RX FIFO stalls the SM, and the PDM clock with it:
+    // count the blocks during which that happened (write 1 to clear)
+    uint32_t stall = 1u << (PIO_FDEBUG_RXSTALL_LSB + pdm_mic.config.pio_sm);
+    if (pdm_mic.config.pio->fdebug & stall) {
+        pdm_mic.config.pio->fdebug = stall;
+        pdm_mic.overruns++;
+    }
     pdm_mic.raw_buffer_read_index  = pdm_mic.raw_buffer_write_index;
     pdm_mic.raw_buffer_write_index = (pdm_mic.raw_buffer_write_index + 1) % PDM_RAW_BUFFER_COUNT;
 
     dma_channel_transfer_to_buffer_now(
         pdm_mic.dma_channel,
         pdm_mic.raw_buffer[pdm_mic.raw_buffer_write_index],
-        pdm_mic.raw_buffer_size
+        pdm_mic.dma_transfer_count
     );
 
     if (pdm_mic.samples_ready_handler) pdm_mic.samples_ready_handler();
+    XIP_PROF_ISR_EXIT();
 }
 
 
+uint32_t pdm_microphone_get_overruns() {
+    return pdm_mic.overruns;
+}
+
 void pdm_microphone_set_samples_ready_handler(pdm_samples_ready_handler_t handler) {
     pdm_mic.samples_ready_handler = handler;
 }
@@ -231,6 +292,25 @@ void pdm_microphone_set_filter_volume(uint16_t volume) {
     pdm_mic.filter_volume = volume;
 }
 
+void pdm_microphone_set_agc(struct agc* agc) {
+    pdm_mic.agc = agc;
+    if (agc && agc->cfg.feedback) {
+        pdm_mic.filter_volume = agc_volume(agc);
+    }
+}
+
+// Runs the AGC on a freshly decimated block and, in feedback mode, moves the
+// gain into the filter volume used for the next block.
+static void pdm_apply_agc(int16_t* buffer, size_t samples) {
+    agc_t* agc = pdm_mic.agc;
+    if (!agc) return;
+
+    agc_process(agc, buffer, samples, pdm_mic.filter_volume);
+    if (agc->cfg.feedback) {
+        pdm_mic.filter_volume = agc_volume(agc);
+    }
+}
+
 int pdm_microphone_read(int16_t* buffer, size_t samples) {
     int filter_stride = (pdm_mic.filter.Fs / 1000);
     samples = (samples / filter_stride) * filter_stride;
@@ -248,6 +328,25 @@ int pdm_microphone_read(int16_t* buffer, size_t samples) {
 
     pdm_mic.raw_buffer_read_index++;
 
+    if (pdm_mic.config.capture_width == PDM_CAPTURE_32BIT) {
+        // Words straight from the autopush FIFO: oldest bit in bit 31
+        uint32_t* in_w = (uint32_t*)in;
+
+        for (int i = 0; i < samples; i += filter_stride) {
+#if PDM_DECIMATION == 64
+            Open_PDM_Filter_64_W(in_w, out, pdm_mic.filter_volume, &pdm_mic.filter);
+#elif PDM_DECIMATION == 128
+            Open_PDM_Filter_128_W(in_w, out, pdm_mic.filter_volume, &pdm_mic.filter);
+#endif
+
+            in_w += filter_stride * (PDM_DECIMATION / 32);
+            out += filter_stride;
+        }
+
+        pdm_apply_agc(buffer, samples);
+        return samples;
+    }
+
     for (int i = 0; i < samples; i += filter_stride) {
 #if PDM_DECIMATION == 64
         Open_PDM_Filter_64(in, out, pdm_mic.filter_volume, &pdm_mic.filter);
@@ -261,5 +360,6 @@ int pdm_microphone_read(int16_t* buffer, size_t samples) {
         out += filter_stride;
     }
 
+    pdm_apply_agc(buffer, samples);
     return samples;
 }
@@ -0,0 +1,240 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <math.h>
+#include <string.h>
+
+#include <tkjhat/pitch.h>
+
+#define HOP                     ((unsigned)PITCH_HOP)
+#define NORM_BITS               24              // d(tau) is scaled below 2^24 before the scan
+#define REFINE_BELOW            32              // periods shorter than this are refined on a multiple
+
+/* =========================
+ *  Helpers
+ * ========================= */
+static uint32_t isqrt32(uint32_t v) {
+    uint32_t r = 0, bit = 1u << 30;
+    while (bit > v) bit >>= 2;
+    while (bit) {
+        if (v >= r + bit) {
+            v -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return r;
+}
+
+// Normalised difference at lag index i as a Q15 value (only used around the chosen lag)
+static int32_t cmn_q15(const pitch_t *pd, unsigned i) {
+    if (pd->cmn_den[i] == 0) return (int32_t)PITCH_ONE;
+    uint64_t v = ((uint64_t)pd->cmn_num[i] << 15) / pd->cmn_den[i];
+    return v > 4u * PITCH_ONE ? (int32_t)(4u * PITCH_ONE) : (int32_t)v;
+}
+
+// num[a] / den[a] < num[b] / den[b]; a zero denominator stands for 1
+static bool cmn_less(const pitch_t *pd, unsigned a, unsigned b) {
+    uint64_t na = pd->cmn_den[a] ? pd->cmn_num[a] : 1, da = pd->cmn_den[a] ? pd->cmn_den[a] : 1;
+    uint64_t nb = pd->cmn_den[b] ? pd->cmn_num[b] : 1, db = pd->cmn_den[b] ? pd->cmn_den[b] : 1;
+    return na * db < nb * da;
+}
+
+/* =========================
+ *  Difference function
+ * ========================= */
+// Squared differences of the hop just completed for lags 1..tau_max+1,
+// swapped into d(tau) in place of the oldest hop's
+static void update_diff(pitch_t *pd) {
+    const int16_t *cur = &pd->x[PITCH_MAX_TAU];
+    uint64_t *old = pd->hop_diff[pd->block];
+    unsigned lags = pd->tau_max + 1u;
+
+    for (unsigned i = 0; i < lags; i++) {
+        const int16_t *lag = cur - (i + 1);
+        uint64_t s = 0;
+        for (unsigned j = 0; j < HOP; j++) {
+            int32_t d = cur[j] - lag[j];
+            s += (uint32_t)d * (uint32_t)d;         // d * d < 2^32: exact in unsigned arithmetic
+        }
+        pd->diff[i] = pd->diff[i] - old[i] + s;
+        old[i] = s;
+    }
+
+    uint64_t e = 0;
+    for (unsigned j = 0; j < HOP; j++) e += (uint32_t)((int32_t)cur[j] * cur[j]);
+    pd->energy = pd->energy - pd->hop_energy[pd->block] + e;
+    pd->hop_energy[pd->block] = e;
+
+    pd->block = (uint8_t)((pd->block + 1u) % PITCH_BLOCKS);
+}
+
+/* =========================
+ *  YIN search
+ * ========================= */
+// Lag of the parabola through d at lag index i and its neighbours, Q8
+static int32_t interpolate(const pitch_t *pd, unsigned i) {
+    int64_t y0 = (int64_t)pd->diff[i - 1u], y1 = (int64_t)pd->diff[i], y2 = (int64_t)pd->diff[i + 1u];
+    int32_t tau_q8 = (int32_t)(i + 1u) << 8;
+    int64_t curv = y0 - 2 * y1 + y2;
+    if (curv > 0) {
+        int64_t delta = ((y0 - y2) * 128) / curv;
+        tau_q8 += (int32_t)(delta > 128 ? 128 : delta < -128 ? -128 : delta);
+    }
+    return tau_q8;
+}
+
+// A short period spans few samples and the parabola fits its dip poorly: measure
+// the dip again at 2, 4, 8... periods, as far as the lags go, and divide. Each
+// step halves the error, so the next multiple is found within a lag of its guess.
+static int32_t refine(const pitch_t *pd, int32_t tau_q8) {
+    for (int32_t m = 2; tau_q8 < REFINE_BELOW << 8; m *= 2) {
+        int32_t centre = (m * tau_q8 + 128) >> 8;
+        if (centre + 1 > (int32_t)pd->tau_max) break;
+        int32_t lag = centre;
+        if (pd->diff[lag - 2] < pd->diff[lag - 1]) lag--;
+        else if (pd->diff[lag] < pd->diff[lag - 1]) lag++;
+        if (lag + 1 > (int32_t)pd->tau_max) break;
+        tau_q8 = (interpolate(pd, (unsigned)lag - 1u) + m / 2) / m;
+    }
+    return tau_q8;
+}
+
+static void estimate(pitch_t *pd, pitch_result_t *r) {
+    memset(r, 0, sizeof(*r));
+    r->seq = ++pd->estimates;
+    r->rms = (uint16_t)isqrt32((uint32_t)(pd->energy / PITCH_WINDOW));
+    pd->lags_scanned = 0;
+    if (r->rms < pd->cfg.min_rms) {
+        pd->gated++;
+        return;
+    }
+
+    unsigned lags = pd->tau_max + 1u;
+    uint64_t peak = 0;
+    for (unsigned i = 0; i < lags; i++) peak |= pd->diff[i];
+    unsigned shift = 0;
+    while ((peak >> shift) >= (1u << NORM_BITS)) shift++;
+
+    // d'(tau) = d(tau) * tau / sum(d(1..tau)), kept as a fraction
+    const uint64_t thr = pd->cfg.threshold;
+    unsigned lo = pd->tau_min - 1u, hi = pd->tau_max - 1u;     // lag indices searched
+    unsigned best = lo, pick = 0;
+    bool below = false;
+    uint32_t cum = 0;
+    unsigned i;
+    for (i = 0; i < lags; i++) {
+        uint32_t d = (uint32_t)(pd->diff[i] >> shift);
+        cum += d;
+        pd->cmn_num[i] = d * (i + 1u);
+        pd->cmn_den[i] = cum;
+        if (i < lo) continue;
+        if (below) {
+            // Walk down to the bottom of the dip, then stop
+            if (i <= hi && cmn_less(pd, i, i - 1u)) continue;
+            pick = i - 1u;
+            break;
+        }
+        if (i > hi) break;
+        if ((uint64_t)pd->cmn_num[i] * PITCH_ONE < thr * cum) below = true;
+        else if (cmn_less(pd, i, best)) best = i;
+    }
+    pd->lags_scanned = (uint16_t)(i - lo);
+    if (!below) {
+        int32_t c = (int32_t)PITCH_ONE - cmn_q15(pd, best);
+        r->confidence = (uint16_t)(c < 0 ? 0 : c);
+        return;
+    }
+
+    // Parabolic interpolation on d(tau) itself (the normalisation skews short lags)
+    int32_t tau_q8 = refine(pd, interpolate(pd, pick));
+    int32_t c = (int32_t)PITCH_ONE - cmn_q15(pd, pick);
+    r->confidence = (uint16_t)(c < 0 ? 0 : c);
+    r->freq_chz = (uint32_t)(((uint64_t)pd->cfg.sample_rate * 25600u + (uint32_t)tau_q8 / 2) / (uint32_t)tau_q8);
+    r->voiced = true;
+}
+
+/* =========================
+ *  Public API
+ * ========================= */
+int pitch_init(pitch_t *pd, const pitch_config_t *cfg) {
+    static const pitch_config_t defaults = PITCH_DEFAULT_CONFIG;
+    if (!pd) return -1;
+    if (!cfg) cfg = &defaults;
+    if (cfg->sample_rate == 0 || cfg->min_hz == 0 || cfg->max_hz <= cfg->min_hz ||
+        cfg->max_hz * 2u >= cfg->sample_rate || cfg->threshold == 0 || cfg->threshold >= PITCH_ONE) {
+        return -1;
+    }
+    uint32_t tau_min = cfg->sample_rate / cfg->max_hz;
+    uint32_t tau_max = (cfg->sample_rate + cfg->min_hz - 1u) / cfg->min_hz;
+    if (tau_min < 2) tau_min = 2;
+    if (tau_max + 1u > PITCH_MAX_TAU || tau_max <= tau_min) return -1;
+
+    memset(pd, 0, sizeof(*pd));
+    pd->cfg = *cfg;
+    pd->tau_min = (uint16_t)tau_min;
+    pd->tau_max = (uint16_t)tau_max;
+    return 0;
+}
+
+size_t pitch_process(pitch_t *pd, const int16_t *pcm, size_t n, pitch_result_t *out) {
+    size_t made = 0;
+    while (n > 0) {
+        size_t take = HOP - pd->fill;
+        if (take > n) take = n;
+        memcpy(&pd->x[PITCH_MAX_TAU + pd->fill], pcm, take * sizeof(int16_t));
+        pd->fill = (uint16_t)(pd->fill + take);
+        pcm += take;
+        n -= take;
+        if (pd->fill < HOP) break;
+
+        update_diff(pd);
+        pd->fill = 0;
+        memmove(pd->x, &pd->x[HOP], PITCH_MAX_TAU * sizeof(int16_t));
+        // Wait until no hop in the window looks back at the zeros before the first sample
+        if (++pd->hops < PITCH_BLOCKS + (pd->tau_max + HOP) / HOP) continue;
+        estimate(pd, &pd->last);
+        made++;
+    }
+    if (made && out) *out = pd->last;
+    return made;
+}
+
+int pitch_note(uint32_t freq_chz, int *cents) {
+    if (freq_chz == 0) return -1;
+    double semis = 12.0 * log2(freq_chz / 44000.0);
+    long note = lround(semis);
+    if (cents) *cents = (int)lround((semis - (double)note) * 100.0);
+    return (int)(69 + note);
+}
+
+int32_t pitch_cents(uint32_t freq_chz, uint32_t ref_chz) {
+    if (freq_chz == 0 || ref_chz == 0) return 0;
+    return (int32_t)lround(1200.0 * log2((double)freq_chz / (double)ref_chz));
+}
@@ -32,6 +32,10 @@ SOFTWARE.
 #include "hardware/pwm.h"
 #include <tkjhat/ssd1306.h>
 #include <tkjhat/pdm_microphone.h>
+#include <tkjhat/energy.h>
+#include <tkjhat/display_sched.h>
+#include <tkjhat/asset_play.h>
+#include "pico/sync.h"
 #include <stdio.h>
 #include <math.h>
 
@@ -164,6 +168,9 @@ void blink_led(int n){
     pwm_set_enabled(slice_num_r, true);
     pwm_set_enabled(slice_num_g, true);
     pwm_set_enabled(slice_num_b, true);
+
+    // Level 0 drives the (active low) channels fully on
+    energy_set_state(ENERGY_RGB, ENERGY_ON, 255);
 }
 
 //RGB off
@@ -185,6 +192,8 @@ void stop_rgb_led(){
     gpio_set_function(RGB_LED_B, GPIO_FUNC_SIO);
     gpio_set_dir(RGB_LED_B, GPIO_IN);
     gpio_disable_pulls(RGB_LED_B);
+
+    energy_set_state(ENERGY_RGB, ENERGY_OFF, 0);
 }
 
 //Channel active to low level (common anode). We need to invert the value
@@ -208,6 +217,10 @@ void stop_rgb_led(){
     pwm_set_gpio_level(RGB_LED_R, r_value);
     pwm_set_gpio_level(RGB_LED_G, g_value);
     pwm_set_gpio_level(RGB_LED_B, b_value);
+
+    // Mean on-time of the three channels (the output is low for 65536 - value counts)
+    uint32_t on = (3u * 65536u - r_value - g_value - b_value) / 3u;
+    energy_set_state(ENERGY_RGB, ENERGY_ON, on > 0xFFFFu ? 255 : (uint8_t)(on >> 8));
 }
 
 /* =========================
@@ -225,6 +238,7 @@ void stop_rgb_led(){
     uint32_t period_us = 1000000 / frequency;
     uint32_t num_cycles = duration_ms * frequency / 1000;
 
+    energy_set_state(ENERGY_BUZZER, ENERGY_ON, 128);    // 50% duty
     // Generate the tone by toggling the buzzer pin at the specified frequency
     for (uint32_t i = 0; i < num_cycles; i++) {
         gpio_put(BUZZER_PIN, 1);
@@ -232,6 +246,7 @@ void stop_rgb_led(){
         gpio_put(BUZZER_PIN, 0);
         busy_wait_us(period_us / 2);
     }
+    energy_set_state(ENERGY_BUZZER, ENERGY_OFF, 0);
 }
 
  void buzzer_turn_off() {
@@ -288,17 +303,18 @@ bool i2c_read(uint8_t addr, uint8_t *dst, size_t len, bool nostop) {
     // GPIO pin for the PDM CLK signal
     .gpio_clk = PDM_CLK,
 
-    // PIO instance to use
-    .pio = pio0,
-
-    // PIO State Machine instance to use
-    .pio_sm = 0,
+    // PIO instance to use: NULL for any block with a free state machine
+    // and room for the program (tkjhat/hw_res.h)
+    .pio = NULL,
 
     // sample rate in Hz
     .sample_rate = MEMS_SAMPLING_FREQUENCY,
 
     // number of samples to buffer
     .sample_buffer_size = MEMS_BUFFER_SIZE,
+
+    // width of each PIO push and DMA transfer
+    .capture_width = MEMS_CAPTURE_WIDTH,
     };
 
     return pdm_microphone_init(&config);
@@ -306,11 +322,14 @@ bool i2c_read(uint8_t addr, uint8_t *dst, size_t len, bool nostop) {
 }
 
  int init_microphone_sampling(){
-    return pdm_microphone_start();
+    int rc = pdm_microphone_start();
+    if (rc == 0) energy_set_state(ENERGY_MIC, ENERGY_ON, 0);
+    return rc;
 }
 
  void end_microphone_sampling(){
     pdm_microphone_stop();
+    energy_set_state(ENERGY_MIC, ENERGY_OFF, 0);
 }
 
 void pdm_microphone_set_callback(pdm_samples_ready_handler_t handler) {
@@ -337,11 +356,148 @@ int get_microphone_samples(int16_t* buffer, size_t samples) {
 
     //power it on
     ssd1306_poweron(&disp);
+    energy_set_state(ENERGY_OLED, ENERGY_ON, 255);     // ssd1306_init sets full contrast
 
     // Clear the display
     ssd1306_clear(&disp);
 }
 
+/* ---- Refresh and power scheduler (tkjhat/display_sched.h) ---- */
+static display_sched_t sched;
+static bool sched_active;
+static critical_section_t sched_cs;
+
+// Sends the pending frame and applies the power change asked by the policy.
+// Runs in the caller's task; the I2C transfers are outside the critical section.
+static void sched_apply(unsigned actions) {
+    if (actions & DISPLAY_SCHED_POWER_OFF) {
+        ssd1306_poweroff(&disp);
+        energy_set_state(ENERGY_OLED, ENERGY_OFF, 0);
+    }
+    if (actions & DISPLAY_SCHED_POWER_ON) {
+        ssd1306_poweron(&disp);
+        energy_set_state(ENERGY_OLED, ENERGY_ON, sched.stats.contrast);
+    }
+    if (actions & DISPLAY_SCHED_FLUSH) {
+        uint32_t hash = display_sched_hash(disp.buffer, disp.bufsize);
+        uint64_t t0 = time_us_64();
+        ssd1306_flush(&disp);
+        uint64_t t1 = time_us_64();
+        critical_section_enter_blocking(&sched_cs);
+        display_sched_flushed(&sched, hash, t1, (uint32_t)(t1 - t0));
+        critical_section_exit(&sched_cs);
+    }
+    if (actions & DISPLAY_SCHED_READ_LIGHT) {
+        uint32_t lux = veml6030_read_light();
+        critical_section_enter_blocking(&sched_cs);
+        int contrast = display_sched_light(&sched, lux);
+        critical_section_exit(&sched_cs);
+        if (contrast >= 0) set_display_contrast((uint8_t)contrast);
+    }
+}
+
+static bool sched_filter(ssd1306_t *p) {
+    uint32_t hash = display_sched_hash(p->buffer, p->bufsize);
+    critical_section_enter_blocking(&sched_cs);
+    unsigned actions = display_sched_request(&sched, hash, time_us_64());
+    critical_section_exit(&sched_cs);
+    sched_apply(actions & (DISPLAY_SCHED_POWER_ON | DISPLAY_SCHED_FLUSH));
+    return false;
+}
+
+// sleep_ms() that sends a deferred frame when its slot comes during the pause,
+// so text written just before stays visible for the whole pause.
+static void display_pause_ms(uint32_t ms) {
+    uint64_t end = time_us_64() + (uint64_t)ms * 1000u;
+    while (sched_active) {
+        uint64_t now = time_us_64();
+        critical_section_enter_blocking(&sched_cs);
+        int64_t due = display_sched_due_us(&sched, now);
+        critical_section_exit(&sched_cs);
+        if (due < 0 || now + (uint64_t)due >= end) break;
+        if (due > 0) sleep_us((uint64_t)due);
+        display_sched_service();
+    }
+    uint64_t now = time_us_64();
+    if (now < end) sleep_us(end - now);
+}
+
+void display_sched_start(const display_sched_config_t *cfg) {
+    if (!critical_section_is_initialized(&sched_cs)) critical_section_init(&sched_cs);
+    critical_section_enter_blocking(&sched_cs);
+    display_sched_init(&sched, cfg, time_us_64());
+    critical_section_exit(&sched_cs);
+    set_display_contrast(sched.stats.contrast);
+    sched_active = true;
+    ssd1306_set_show_filter(sched_filter);
+}
+
+void display_sched_stop(void) {
+    ssd1306_set_show_filter(NULL);
+    sched_active = false;
+}
+
+void display_sched_service(void) {
+    if (!sched_active) return;
+    critical_section_enter_blocking(&sched_cs);
+    unsigned actions = display_sched_poll(&sched, time_us_64());
+    critical_section_exit(&sched_cs);
+    sched_apply(actions);
+}
+
+void display_sched_stats(display_sched_stats_t *out) {
+    if (!critical_section_is_initialized(&sched_cs)) {
+        *out = (display_sched_stats_t){0};
+        return;
+    }
+    critical_section_enter_blocking(&sched_cs);
+    display_sched_get_stats(&sched, time_us_64(), out);
+    critical_section_exit(&sched_cs);
+}
+
+int display_sched_format_report(char *buf, size_t len) {
+    display_sched_stats_t st;
+    display_sched_stats(&st);
+    uint32_t on_pct = st.elapsed_us ? (uint32_t)(st.on_us * 100u / st.elapsed_us) : 0;
+    int n = snprintf(buf, len,
+                     "[display] frames %lu flushed %lu skipped %lu coalesced %lu bus %lu ms on %lu%% "
+                     "(%lu off) period %lu ms contrast %u lux %lu\n",
+                     (unsigned long)st.requests, (unsigned long)st.flushes, (unsigned long)st.skipped,
+                     (unsigned long)st.coalesced, (unsigned long)(st.bus_us / 1000u), (unsigned long)on_pct,
+                     (unsigned long)st.power_downs, (unsigned long)st.period_ms, st.contrast,
+                     (unsigned long)st.lux);
+    if (n < 0) return 0;
+    return (size_t)n < len ? n : (len ? (int)len - 1 : 0);
+}
+
+
+/* ---- Assets (tkjhat/asset_play.h) ---- */
+int display_show_frame(const asset_pack_t *pack, const asset_entry_t *e, uint16_t frame) {
+    if (!e || e->type != ASSET_IMAGE_RAW) return ASSET_ERR_TYPE;
+    uint32_t len;
+    const uint8_t *data = asset_frame(pack, e, frame, &len);
+    if (!data) return ASSET_ERR_RANGE;
+    if (e->width != disp.width || e->height != disp.height ||
+        len != disp.bufsize + 1u || data[0] != ASSET_DATA_CONTROL)
+        return ASSET_ERR_TYPE;
+
+    if (sched_active) {
+        critical_section_enter_blocking(&sched_cs);
+        unsigned actions = display_sched_external(&sched, time_us_64());
+        critical_section_exit(&sched_cs);
+        sched_apply(actions);
+    }
+    // One I2C transfer from XIP, the frame already starts with the data control byte
+    ssd1306_flush_data(&disp, data);
+    return 0;
+}
+
+int display_draw_asset(const asset_pack_t *pack, const asset_entry_t *e, uint16_t frame, int16_t x, int16_t y) {
+    int r = asset_draw(pack, e, frame, disp.buffer, (uint16_t)disp.width, (uint16_t)disp.height, x, y);
+    if (r == 0) ssd1306_show(&disp);
+    return r;
+}
+
 
 void write_text_xy(int16_t x0, int16_t y0, const char *text) {
     if (!text) return;
@@ -356,7 +512,7 @@ void write_text_xy(int16_t x0, int16_t y0, const char *text) {
     ssd1306_show(&disp);
 
     // Delay for 800 milliseconds
-    sleep_ms(800);
+    display_pause_ms(800);
 }
 
 void write_text(const char *text) {
@@ -370,7 +526,7 @@ void write_text(const char *text) {
     ssd1306_show(&disp);
 
     // Delay for 800 milliseconds
-    sleep_ms(800);
+    display_pause_ms(800);
 }
 
 /**
@@ -500,6 +656,12 @@ void clear_display() {
 
 void stop_display() {
     ssd1306_poweroff(&disp);
+    energy_set_state(ENERGY_OLED, ENERGY_OFF, 0);
+}
+
+void set_display_contrast(uint8_t contrast) {
+    ssd1306_contrast(&disp, contrast);
+    energy_set_state(ENERGY_OLED, ENERGY_ON, contrast);
 }
 
 
@@ -527,6 +689,7 @@ void init_veml6030() {
     // Write configuration to sensor
     i2c_write_blocking(i2c_default, VEML6030_I2C_ADDR, config, sizeof(config), false);
     sleep_ms(10);
+    energy_set_state(ENERGY_VEML6030, ENERGY_ON, 0);
 }
 
 // Read light level from VEML6030
@@ -598,6 +761,7 @@ void veml6030_stop(){
     // Write configuration to sensor
     i2c_write_blocking(i2c_default, VEML6030_I2C_ADDR, config, sizeof(config), false);
     sleep_ms(10);
+    energy_set_state(ENERGY_VEML6030, ENERGY_OFF, 0);
 }
 
 
@@ -694,6 +858,7 @@ void hdc2021_set_low_humidity_threshold(float humid) {
     hdc2021_setTempRes();
     hdc2021_setHumidityRes();
     hdc2021_triggerMeasurement();
+    energy_set_state(ENERGY_HDC2021, ENERGY_ON, 0);    // auto-measure at 1 Hz
 }
 
 // Note that sampling rate is 1Hz
@@ -730,6 +895,7 @@ void stop_hdc2021() {
     //turn heater & DRDY pin off to minimize current
     cfg &= ~(uint8_t)(1<<3); // HEAT_EN=0
     cfg &= ~(uint8_t)(1<<2); // DRDY/INT_EN=0 (pin Hi-Z)
+    energy_set_state(ENERGY_HDC2021, ENERGY_IDLE, 0);  // sleeping between (no) measurements
 
 }
 
@@ -816,6 +982,7 @@ int init_ICM42670() {
     
     //Soft reset
     icm_soft_reset();
+    energy_set_state(ENERGY_IMU, ENERGY_OFF, 0);       // accel and gyro are off after reset
     
     //DETECT ADDRESS FOR AD0 floating pin: 
     int address = ICM42670_autodetect_address();
@@ -939,6 +1106,7 @@ int ICM42670_startGyro(uint16_t odr_hz, uint16_t fsr_dps) {
 int ICM42670_enable_accel_gyro_ln_mode() {
     int rc = icm_i2c_write_byte(ICM42670_PWR_MGMT0_REG , 0x0F); // bits 3:2 = gyro LN, bits 1:0 = accel LN
     busy_wait_us(400);
+    if (rc == 0) energy_set_state(ENERGY_IMU, ENERGY_ON, 255);
     return rc;
 }
 
@@ -948,6 +1116,7 @@ int ICM42670_enable_ultra_low_power_mode(void) {
     // PWR_MGMT0 = 0b00000010 = 0x02
     int rc = icm_i2c_write_byte(ICM42670_PWR_MGMT0_REG , 0x02);
     busy_wait_us(200);
+    if (rc == 0) energy_set_state(ENERGY_IMU, ENERGY_LOW_POWER, 0);
     return rc;
 }
 
@@ -957,6 +1126,7 @@ int ICM42670_enable_accel_gyro_lp_mode(void) {
     // 0b00001010 = 0x0A
     int rc = icm_i2c_write_byte(ICM42670_PWR_MGMT0_REG, 0x0A);
     busy_wait_us(200);
+    if (rc == 0) energy_set_state(ENERGY_IMU, ENERGY_LOW_POWER, 255);
     return rc;
 }
 
@@ -982,6 +1152,18 @@ int ICM42670_start_with_default_values(void) {
 }
 
 
+int ICM42670_enable_data_ready_int(void) {
+    // The sensors are running by now (see the TODO in init_ICM42670)
+    if (icm_i2c_write_byte(ICM42670_INT_CONFIG, ICM42670_INT1_CONFIG_VALUE) != 0) return -1;
+    busy_wait_us(100);
+    if (icm_i2c_write_byte(ICM42670_INT_SOURCE0_REG, ICM42670_INT_SOURCE0_DRDY_INT1) != 0) return -2;
+    busy_wait_us(100);
+    uint8_t v = 0;
+    if (icm_i2c_read_byte(ICM42670_INT_SOURCE0_REG, &v) != 0 || v != ICM42670_INT_SOURCE0_DRDY_INT1) return -3;
+    return 0;
+}
+
+
 int ICM42670_read_sensor_data(float *ax, float *ay, float *az,
     float *gx, float *gy, float *gz,float *t) {
         
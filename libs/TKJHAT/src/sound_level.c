@@ -0,0 +1,300 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <math.h>
+#include <stdio.h>
+
+#include <tkjhat/sound_level.h>
+
+// IEC 61672-1 A-weighting pole frequencies (Hz)
+#define A_F1                    20.598997
+#define A_F2                    107.65265
+#define A_F3                    737.86223
+#define A_F4                    12194.217
+
+#define FAST_TAU_MS             125
+#define SLOW_TAU_MS             1000
+#define SETTLE_TIME_CONSTANTS   5
+
+/* =========================
+ *  Filter design (double, init only)
+ * ========================= */
+// First order analog high pass s / (s + w) through the bilinear transform,
+// s = K (1 - z^-1) / (1 + z^-1):  K (1 - z^-1) / ((K + w) + (w - K) z^-1)
+static void first_order_hp(double k, double f, double num[2], double den[2]) {
+    double w = 2.0 * M_PI * f;
+    num[0] = k;
+    num[1] = -k;
+    den[0] = k + w;
+    den[1] = w - k;
+}
+
+static void design_high_pass(double coef[5], double k, double fa, double fb) {
+    double na[2], da[2], nb[2], db[2];
+    first_order_hp(k, fa, na, da);
+    first_order_hp(k, fb, nb, db);
+    double a0 = da[0] * db[0];
+    coef[0] = na[0] * nb[0] / a0;                       // b0
+    coef[1] = (na[0] * nb[1] + na[1] * nb[0]) / a0;     // b1
+    coef[2] = na[1] * nb[1] / a0;                       // b2
+    coef[3] = (da[0] * db[1] + da[1] * db[0]) / a0;     // a1
+    coef[4] = da[1] * db[1] / a0;                       // a2
+}
+
+// The 12.2 kHz double pole lies above Nyquist at the microphone rates: the
+// bilinear transform bends it down to fs/2 (-2 dB at 3.15 kHz for fs = 8 kHz) and
+// a matched-z pole all but removes it. Instead the digital double pole p is chosen
+// so that the section follows the analog roll-off, relative to 1 kHz, at 0.3 fs.
+static double low_pass_gain(double p, double f, double fs) {
+    double w = 2.0 * M_PI * f / fs;
+    return (1.0 - p) * (1.0 - p) / (1.0 - 2.0 * p * cos(w) + p * p);
+}
+
+static void design_low_pass(double coef[5], double f, double fs) {
+    double fm = 0.3 * fs;
+    double target = (f * f + 1000.0 * 1000.0) / (f * f + fm * fm);
+    double lo = 0.0, hi = 0.99;
+    for (int i = 0; i < 48; i++) {
+        double p = 0.5 * (lo + hi);
+        if (low_pass_gain(p, fm, fs) / low_pass_gain(p, 1000.0, fs) > target) lo = p;
+        else hi = p;
+    }
+    double p = 0.5 * (lo + hi);
+    coef[0] = (1.0 - p) * (1.0 - p);
+    coef[1] = 0.0;
+    coef[2] = 0.0;
+    coef[3] = -2.0 * p;
+    coef[4] = p * p;
+}
+
+static double biquad_gain(const double c[5], double f, double fs) {
+    double w = 2.0 * M_PI * f / fs;
+    double c1 = cos(w), s1 = sin(w), c2 = cos(2.0 * w), s2 = sin(2.0 * w);
+    double nr = c[0] + c[1] * c1 + c[2] * c2, ni = -(c[1] * s1 + c[2] * s2);
+    double dr = 1.0 + c[3] * c1 + c[4] * c2, di = -(c[3] * s1 + c[4] * s2);
+    return sqrt((nr * nr + ni * ni) / (dr * dr + di * di));
+}
+
+static int32_t to_q28(double c) {
+    return (int32_t)lround(c * (double)(1 << SOUND_LEVEL_COEF_SHIFT));
+}
+
+/* =========================
+ *  Fixed-point helpers
+ * ========================= */
+// 1000 * log10(v), i.e. centi-dB of a power value
+static int32_t power_cdb(uint64_t v) {
+    int msb = 63;
+    while (!(v >> msb)) msb--;
+    uint32_t m = msb >= 30 ? (uint32_t)(v >> (msb - 30)) : (uint32_t)(v << (30 - msb));   // Q30, [1, 2)
+    int32_t frac = 0;
+    for (int i = 15; i >= 0; i--) {
+        m = (uint32_t)(((uint64_t)m * m) >> 30);
+        if (m >= (1u << 31)) {
+            m >>= 1;
+            frac |= 1 << i;
+        }
+    }
+    int64_t log2_q16 = ((int64_t)msb << 16) | frac;
+    return (int32_t)((log2_q16 * 301030) >> 16) / 1000;    // 1000 * log10(2) = 301.030
+}
+
+static int16_t level_cdb(const sound_level_t *sl, uint64_t ms, bool calibrated) {
+    if (ms == 0) return SOUND_LEVEL_NO_LEVEL;
+    int32_t l = power_cdb(ms) - sl->ref_cdb + (calibrated ? sl->cfg.calibration_cdb : 0);
+    if (l < INT16_MIN + 1) l = INT16_MIN + 1;
+    if (l > INT16_MAX) l = INT16_MAX;
+    return (int16_t)l;
+}
+
+static inline int32_t biquad_run(sound_level_biquad_t *q, int32_t x) {
+    int64_t acc = q->err
+                + (int64_t)q->b0 * x + (int64_t)q->b1 * q->x1 + (int64_t)q->b2 * q->x2
+                - (int64_t)q->a1 * q->y1 - (int64_t)q->a2 * q->y2;
+    int32_t y = (int32_t)(acc >> SOUND_LEVEL_COEF_SHIFT);
+    q->err = acc - ((int64_t)y << SOUND_LEVEL_COEF_SHIFT);   // error feedback keeps the LF poles quiet
+    q->x2 = q->x1;
+    q->x1 = x;
+    q->y2 = q->y1;
+    q->y1 = y;
+    return y;
+}
+
+static uint8_t tau_shift(uint32_t tau_ms, uint32_t sample_rate) {
+    uint32_t samples = (uint32_t)(((uint64_t)tau_ms * sample_rate + 500) / 1000);
+    uint8_t shift = 0;
+    while (shift < 24 && (1u << shift) + (1u << shift) / 2 < samples) shift++;
+    return shift;
+}
+
+// 128-bit energy / 32-bit count, one 32-bit word at a time
+static uint64_t energy_mean(const uint64_t energy[2], uint32_t count) {
+    const uint32_t words[4] = {
+        (uint32_t)(energy[1] >> 32), (uint32_t)energy[1], (uint32_t)(energy[0] >> 32), (uint32_t)energy[0],
+    };
+    uint64_t rem = 0, q = 0;
+    for (int i = 0; i < 4; i++) {
+        uint64_t cur = (rem << 32) | words[i];
+        q = (q << 32) | (cur / count);      // the top words only ever give 0 (mean < 2^64)
+        rem = cur % count;
+    }
+    return q;
+}
+
+static void interval_reset(sound_level_t *sl) {
+    sl->energy[0] = 0;
+    sl->energy[1] = 0;
+    sl->count = 0;
+    sl->ms_max = 0;
+    sl->ms_min = UINT64_MAX;
+}
+
+/* =========================
+ *  Public API
+ * ========================= */
+int sound_level_init(sound_level_t *sl, const sound_level_config_t *cfg,
+                     sound_level_sink_t sink, void *ctx) {
+    if (!sl || !cfg || cfg->sample_rate < 1000 || cfg->interval_ms == 0) return -1;
+    uint64_t interval = (uint64_t)cfg->interval_ms * cfg->sample_rate / 1000;
+    if (interval == 0 || interval > UINT32_MAX) return -1;
+
+    sl->cfg = *cfg;
+    sl->sink = sink;
+    sl->ctx = ctx;
+
+    double fs = cfg->sample_rate, k = 2.0 * fs;
+    double c[SOUND_LEVEL_BIQUADS][5];
+    design_high_pass(c[0], k, A_F1, A_F1);
+    design_high_pass(c[1], k, A_F2, A_F3);
+    design_low_pass(c[2], A_F4, fs);
+
+    // 0 dB at 1 kHz; the correction goes to the low pass section
+    double g = 1.0;
+    for (int i = 0; i < SOUND_LEVEL_BIQUADS; i++) g *= biquad_gain(c[i], 1000.0, fs);
+    for (int i = 0; i < 3; i++) c[2][i] /= g;
+
+    for (int i = 0; i < SOUND_LEVEL_BIQUADS; i++) {
+        sound_level_biquad_t *q = &sl->bq[i];
+        q->b0 = to_q28(c[i][0]);
+        q->b1 = to_q28(c[i][1]);
+        q->b2 = to_q28(c[i][2]);
+        q->a1 = to_q28(c[i][3]);
+        q->a2 = to_q28(c[i][4]);
+        q->x1 = q->x2 = q->y1 = q->y2 = 0;
+        q->err = 0;
+    }
+
+    sl->shift[SOUND_LEVEL_FAST] = tau_shift(FAST_TAU_MS, cfg->sample_rate);
+    sl->shift[SOUND_LEVEL_SLOW] = tau_shift(SLOW_TAU_MS, cfg->sample_rate);
+    sl->ms[0] = sl->ms[1] = 0;
+    sl->settle = SETTLE_TIME_CONSTANTS << sl->shift[cfg->max_min];
+
+    // Reference: a full-scale sine, in the units of the mean square
+    int64_t fs_amp = (int64_t)32767 << SOUND_LEVEL_SAMPLE_SHIFT;
+    sl->ref_cdb = power_cdb((uint64_t)(fs_amp * fs_amp / 2));
+
+    sl->interval_samples = (uint32_t)interval;
+    sl->seq = 0;
+    interval_reset(sl);
+    return 0;
+}
+
+static void interval_emit(sound_level_t *sl) {
+    sound_level_report_t r;
+    r.seq = sl->seq++;
+    r.duration_ms = (uint32_t)((uint64_t)sl->count * 1000 / sl->cfg.sample_rate);
+    r.leq_cdb = level_cdb(sl, energy_mean(sl->energy, sl->count), true);
+    r.lmax_cdb = level_cdb(sl, sl->ms_max, true);
+    r.lmin_cdb = sl->ms_min == UINT64_MAX ? SOUND_LEVEL_NO_LEVEL : level_cdb(sl, sl->ms_min, true);
+    interval_reset(sl);
+    if (sl->sink) sl->sink(&r, sl->ctx);
+}
+
+void sound_level_process(sound_level_t *sl, const int16_t *pcm, size_t n) {
+    const uint8_t sf = sl->shift[SOUND_LEVEL_FAST], ss = sl->shift[SOUND_LEVEL_SLOW];
+    const int w = sl->cfg.max_min;
+
+    for (size_t i = 0; i < n; i++) {
+        int32_t y = (int32_t)pcm[i] << SOUND_LEVEL_SAMPLE_SHIFT;
+        y = biquad_run(&sl->bq[0], y);
+        y = biquad_run(&sl->bq[1], y);
+        y = biquad_run(&sl->bq[2], y);
+
+        int64_t e = (int64_t)y * y;                         // Q24
+        int64_t f = (int64_t)sl->ms[0], s = (int64_t)sl->ms[1];
+        f += (e - f) >> sf;
+        s += (e - s) >> ss;
+        sl->ms[0] = (uint64_t)f;
+        sl->ms[1] = (uint64_t)s;
+        sl->energy[0] += (uint64_t)e;
+        sl->energy[1] += sl->energy[0] < (uint64_t)e;     // carry
+
+        uint64_t m = sl->ms[w];
+        if (m > sl->ms_max) sl->ms_max = m;
+        if (sl->settle) sl->settle--;
+        else if (m < sl->ms_min) sl->ms_min = m;
+
+        if (++sl->count == sl->interval_samples) interval_emit(sl);
+    }
+}
+
+int16_t sound_level_current(const sound_level_t *sl, sound_level_weighting_t w) {
+    return level_cdb(sl, sl->ms[w], true);
+}
+
+int16_t sound_level_calibrate(sound_level_t *sl, int16_t known_cdb) {
+    int16_t raw = level_cdb(sl, sl->ms[SOUND_LEVEL_SLOW], false);
+    if (raw != SOUND_LEVEL_NO_LEVEL) sl->cfg.calibration_cdb = (int16_t)(known_cdb - raw);
+    return sl->cfg.calibration_cdb;
+}
+
+size_t sound_level_pack(const sound_level_report_t *r, uint8_t *out) {
+    const uint32_t u32[2] = { r->seq, r->duration_ms };
+    const int16_t i16[3] = { r->leq_cdb, r->lmax_cdb, r->lmin_cdb };
+    size_t o = 0;
+    for (int i = 0; i < 2; i++)
+        for (int b = 0; b < 4; b++) out[o++] = (uint8_t)(u32[i] >> (8 * b));
+    for (int i = 0; i < 3; i++) {
+        out[o++] = (uint8_t)((uint16_t)i16[i] & 0xFF);
+        out[o++] = (uint8_t)((uint16_t)i16[i] >> 8);
+    }
+    return o;
+}
+
+int sound_level_format_report(const sound_level_report_t *r, char *buf, size_t len) {
+    if (!buf || len == 0) return 0;
+    int n = snprintf(buf, len, "LAeq %.2f Lmax %.2f Lmin ", r->leq_cdb / 100.0, r->lmax_cdb / 100.0);
+    if (n < 0 || (size_t)n >= len) return n < 0 ? 0 : (int)len - 1;
+    int m = r->lmin_cdb == SOUND_LEVEL_NO_LEVEL
+          ? snprintf(buf + n, len - n, "-")
+          : snprintf(buf + n, len - n, "%.2f", r->lmin_cdb / 100.0);
+    if (m < 0 || (size_t)(n + m) >= len) return (int)len - 1;
+    n += m;
+    m = snprintf(buf + n, len - n, " dB / %.1f s\n", r->duration_ms / 1000.0);
+    if (m < 0 || (size_t)(n + m) >= len) return (int)len - 1;
+    return n + m;
+}
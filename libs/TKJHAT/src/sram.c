@@ -0,0 +1,175 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <tkjhat/sram.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#if TKJHAT_BANKED_SRAM
+#include "hardware/sync.h"
+
+// Save/restore spin lock: the allocators run before the scheduler starts
+// (driver init from main) and from tasks on both cores
+#define LOCK_NUM                (PICO_SPINLOCK_ID_STRIPED_FIRST + 3)
+
+// Provided by memmap_banked_rp2040.ld; a link error here means the
+// executable was not passed to tkjhat_sram_layout()
+extern char __dma_buffers_start__[], __dma_buffers_end__[];
+extern char __dma_arena_start__[], __dma_arena_end__[];
+extern char __tkjhat_banked_sram__[];
+
+static uintptr_t dma_arena_next;
+
+static uint8_t core0_arena[SRAM_CORE_ARENA_SIZE] __attribute__((aligned(8))) TKJHAT_CORE0_DATA;
+static uint8_t core1_arena[SRAM_CORE_ARENA_SIZE] __attribute__((aligned(8))) TKJHAT_CORE1_DATA;
+static size_t core_arena_used[2];
+
+static inline uint32_t lock(void) {
+    return spin_lock_blocking(spin_lock_instance(LOCK_NUM));
+}
+
+static inline void unlock(uint32_t save) {
+    spin_unlock(spin_lock_instance(LOCK_NUM), save);
+}
+
+// .dma_buffers is NOLOAD: give its variables the zero initial value C expects
+static void __attribute__((constructor)) sram_clear_dma_buffers(void) {
+    memset(__dma_buffers_start__, 0, (size_t)(__dma_buffers_end__ - __dma_buffers_start__));
+    dma_arena_next = (uintptr_t)__dma_arena_start__;
+}
+#endif
+
+/* =========================
+ *  DMA bank
+ * ========================= */
+void *sram_dma_alloc(size_t size, size_t align) {
+    if (size == 0) return NULL;
+    if (align < 4) align = 4;
+    if (align & (align - 1)) return NULL;
+#if TKJHAT_BANKED_SRAM
+    void *p = NULL;
+    uint32_t save = lock();
+    uintptr_t start = (dma_arena_next + align - 1) & ~(uintptr_t)(align - 1);
+    if (start + size <= (uintptr_t)__dma_arena_end__) {
+        dma_arena_next = start + size;
+        p = (void *)start;
+    }
+    unlock(save);
+    return p;
+#else
+    // malloc only guarantees 8-byte alignment: over-allocate and keep the
+    // original pointer just before the aligned block
+    uint8_t *raw = malloc(size + align + sizeof(void *));
+    if (!raw) return NULL;
+    uintptr_t start = ((uintptr_t)raw + sizeof(void *) + align - 1) & ~(uintptr_t)(align - 1);
+    ((void **)start)[-1] = raw;
+    return (void *)start;
+#endif
+}
+
+void sram_dma_free(void *p) {
+    if (!p) return;
+#if TKJHAT_BANKED_SRAM
+    (void)p;    // arena memory is not reused
+#else
+    free(((void **)p)[-1]);
+#endif
+}
+
+size_t sram_dma_arena_free(void) {
+#if TKJHAT_BANKED_SRAM
+    return (size_t)((uintptr_t)__dma_arena_end__ - dma_arena_next);
+#else
+    return 0;
+#endif
+}
+
+/* =========================
+ *  Scratch banks
+ * ========================= */
+void *sram_core_alloc(uint core, size_t size) {
+#if TKJHAT_BANKED_SRAM
+    if (core > 1 || size == 0) return NULL;
+    size = (size + 7u) & ~(size_t)7u;
+    void *p = NULL;
+    uint32_t save = lock();
+    if (core_arena_used[core] + size <= SRAM_CORE_ARENA_SIZE) {
+        p = (core == 0 ? core0_arena : core1_arena) + core_arena_used[core];
+        core_arena_used[core] += size;
+    }
+    unlock(save);
+    return p;
+#else
+    (void)core;
+    (void)size;
+    return NULL;
+#endif
+}
+
+#if configNUMBER_OF_CORES > 1 && configUSE_CORE_AFFINITY
+#define CORE_MASK(core)         ((UBaseType_t)1u << (core))
+#endif
+
+int sram_task_create_on_core(TaskFunction_t fn, const char *name, uint32_t stack_words,
+                             void *arg, UBaseType_t priority, uint core, TaskHandle_t *out) {
+    if (!fn || core >= configNUMBER_OF_CORES) return -1;
+    TaskHandle_t task = NULL;
+
+#if TKJHAT_BANKED_SRAM && configSUPPORT_STATIC_ALLOCATION
+    // TCB and stack in one block, so a full arena never strands a lone TCB
+    size_t tcb_size = (sizeof(StaticTask_t) + 7u) & ~(size_t)7u;
+    uint8_t *block = sram_core_alloc(core, tcb_size + stack_words * sizeof(StackType_t));
+    if (block) {
+        StaticTask_t *tcb = (StaticTask_t *)block;
+        StackType_t *stack = (StackType_t *)(block + tcb_size);
+#if configNUMBER_OF_CORES > 1 && configUSE_CORE_AFFINITY
+        task = xTaskCreateStaticAffinitySet(fn, name, stack_words, arg, priority, stack, tcb,
+                                            CORE_MASK(core));
+#else
+        task = xTaskCreateStatic(fn, name, stack_words, arg, priority, stack, tcb);
+#endif
+        if (!task) return -2;
+        if (out) *out = task;
+        return 0;
+    }
+    // Arena full: fall through to a heap stack
+#endif
+
+    // Created pinned: the task never gets a chance to start on the wrong core
+#if configNUMBER_OF_CORES > 1 && configUSE_CORE_AFFINITY
+    if (xTaskCreateAffinitySet(fn, name, stack_words, arg, priority, CORE_MASK(core), &task) != pdPASS) return -2;
+#else
+    if (xTaskCreate(fn, name, stack_words, arg, priority, &task) != pdPASS) return -2;
+#endif
+    if (out) *out = task;
+    return 0;
+}
+
+bool sram_banked(void) {
+    return TKJHAT_BANKED_SRAM != 0;
+}
@@ -33,6 +33,9 @@ SOFTWARE.
 #include <tkjhat/ssd1306.h>
 #include <tkjhat/font.h>
 
+static ssd1306_show_hook_t show_hook;
+static ssd1306_show_filter_t show_filter;
+
 inline static void swap(int32_t *a, int32_t *b) {
     int32_t *t=a;
     *a=*b;
@@ -290,7 +293,7 @@ inline void ssd1306_bmp_show_image(ssd1306_t *p, const uint8_t *data, const long
     ssd1306_bmp_show_image_with_offset(p, data, size, 0, 0);
 }
 
-void ssd1306_show(ssd1306_t *p) {
+static void set_full_window(ssd1306_t *p) {
     uint8_t payload[]= {SET_COL_ADDR, 0, p->width-1, SET_PAGE_ADDR, 0, p->pages-1};
     if(p->width==64) {
         payload[1]+=32;
@@ -299,8 +302,42 @@ void ssd1306_show(ssd1306_t *p) {
 
     for(size_t i=0; i<sizeof(payload); ++i)
         ssd1306_write(p, payload[i]);
+}
+
+void ssd1306_flush(ssd1306_t *p) {
+    set_full_window(p);
 
     *(p->buffer-1)=0x40;
 
     fancy_write(p->i2c_i, p->address, p->buffer-1, p->bufsize+1, "ssd1306_show");
+
+    if(show_hook)
+        show_hook(p);
+}
+
+void ssd1306_flush_data(ssd1306_t *p, const uint8_t *data) {
+    set_full_window(p);
+
+    fancy_write(p->i2c_i, p->address, data, p->bufsize+1, "ssd1306_flush_data");
+
+    if(show_hook) {
+        // The hook sees the frame that was sent through a copy of the instance
+        ssd1306_t view=*p;
+        view.buffer=(uint8_t *)data+1;
+        show_hook(&view);
+    }
+}
+
+void ssd1306_show(ssd1306_t *p) {
+    if(show_filter && !show_filter(p))
+        return;
+    ssd1306_flush(p);
+}
+
+void ssd1306_set_show_hook(ssd1306_show_hook_t hook) {
+    show_hook=hook;
+}
+
+void ssd1306_set_show_filter(ssd1306_show_filter_t filter) {
+    show_filter=filter;
 }
\ No newline at end of file
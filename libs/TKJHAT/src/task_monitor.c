@@ -0,0 +1,365 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <tkjhat/task_monitor.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/watchdog.h"
+
+#if !configGENERATE_RUN_TIME_STATS || !configUSE_TRACE_FACILITY
+#error "task_monitor needs configGENERATE_RUN_TIME_STATS and configUSE_TRACE_FACILITY"
+#endif
+
+#define FAULT_MAGIC     0x544D4F4Eu     // "TMON"
+
+typedef struct {
+    TaskHandle_t handle;
+    uint32_t period_ms;
+    uint8_t max_cpu_pct;
+    bool critical;
+    volatile uint32_t last_checkin_ms;
+    uint8_t cpu_pct;
+    task_monitor_status_t status;
+} monitored_task_t;
+
+typedef struct {
+    UBaseType_t number;                 // xTaskNumber
+    configRUN_TIME_COUNTER_TYPE runtime;
+} runtime_sample_t;
+
+static struct {
+    monitored_task_t tasks[TASK_MONITOR_MAX_TASKS];
+    int count;
+    uint32_t window_ms;
+    bool watchdog;
+    task_monitor_fault_handler_t fault_handler;
+    bool fault_recorded;
+
+    // Kernel sampling
+    TaskStatus_t status[TASK_MONITOR_MAX_SYSTEM_TASKS];
+    runtime_sample_t prev[TASK_MONITOR_MAX_SYSTEM_TASKS];
+    UBaseType_t prev_count;
+    configRUN_TIME_COUNTER_TYPE prev_total;
+
+    // Last window hog
+    char hog[TASK_MONITOR_NAME_LEN];
+    uint8_t hog_cpu_pct;
+    uint8_t hog_core;
+} mon;
+
+// Survives a watchdog reset (not zeroed by the C runtime)
+static task_monitor_fault_t __uninitialized_ram(fault_record);
+static task_monitor_fault_t previous_fault;
+static bool previous_fault_valid;
+static bool fault_record_checked;
+
+static uint32_t now_ms(void) {
+    return to_ms_since_boot(get_absolute_time());
+}
+
+static uint32_t fault_checksum(const task_monitor_fault_t *f) {
+    // FNV-1a over every field but the checksum
+    const uint8_t *p = (const uint8_t *)f;
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < offsetof(task_monitor_fault_t, checksum); i++) {
+        h = (h ^ p[i]) * 16777619u;
+    }
+    return h;
+}
+
+static void fault_record_boot(void) {
+    bool valid = fault_record.magic == FAULT_MAGIC &&
+                 fault_record.checksum == fault_checksum(&fault_record);
+
+    if (valid && watchdog_caused_reboot() && fault_record.reason != TASK_MONITOR_OK) {
+        previous_fault = fault_record;
+        previous_fault_valid = true;
+    }
+
+    fault_record_checked = true;
+
+    uint32_t boots = valid ? fault_record.boot_count + 1 : 1;
+    memset(&fault_record, 0, sizeof(fault_record));
+    fault_record.magic = FAULT_MAGIC;
+    fault_record.boot_count = boots;
+    fault_record.hog_core = TASK_MONITOR_CORE_UNKNOWN;
+    fault_record.checksum = fault_checksum(&fault_record);
+}
+
+static void copy_name(char *dst, const char *src) {
+    strncpy(dst, src ? src : "?", TASK_MONITOR_NAME_LEN - 1);
+    dst[TASK_MONITOR_NAME_LEN - 1] = '\0';
+}
+
+static bool is_idle_task(const TaskStatus_t *s) {
+    return strncmp(s->pcTaskName, "IDLE", 4) == 0;
+}
+
+static configRUN_TIME_COUNTER_TYPE runtime_delta(const TaskStatus_t *s) {
+    for (UBaseType_t i = 0; i < mon.prev_count; i++) {
+        if (mon.prev[i].number == s->xTaskNumber) {
+            return s->ulRunTimeCounter - mon.prev[i].runtime;
+        }
+    }
+    // New task: everything it ran so far happened inside this window at most
+    return s->ulRunTimeCounter;
+}
+
+// Core the task is running on right now, or the only core it may run on
+static uint8_t task_core(TaskHandle_t handle) {
+#if configNUMBER_OF_CORES > 1
+    for (BaseType_t core = 0; core < configNUMBER_OF_CORES; core++) {
+        if (xTaskGetCurrentTaskHandleForCore(core) == handle) {
+            return (uint8_t)core;
+        }
+    }
+#if configUSE_CORE_AFFINITY
+    UBaseType_t mask = vTaskCoreAffinityGet(handle);
+    for (uint8_t core = 0; core < configNUMBER_OF_CORES; core++) {
+        if (mask == (1u << core)) return core;
+    }
+#endif
+    return TASK_MONITOR_CORE_UNKNOWN;
+#else
+    (void)handle;
+    return 0;
+#endif
+}
+
+static uint8_t to_pct(configRUN_TIME_COUNTER_TYPE part, configRUN_TIME_COUNTER_TYPE whole) {
+    if (whole == 0) return 0;
+    uint64_t pct = ((uint64_t)part * 100u) / whole;
+    return pct > 100 ? 100 : (uint8_t)pct;
+}
+
+static void record_fault(const monitored_task_t *t, const TaskStatus_t *s) {
+    fault_record.uptime_ms = now_ms();
+    fault_record.reason = (uint8_t)t->status;
+    fault_record.task_cpu_pct = t->cpu_pct;
+    fault_record.hog_core = mon.hog_core;
+    fault_record.hog_cpu_pct = mon.hog_cpu_pct;
+    copy_name(fault_record.task, s ? s->pcTaskName : pcTaskGetName(t->handle));
+    copy_name(fault_record.hog, mon.hog);
+    fault_record.checksum = fault_checksum(&fault_record);
+}
+
+static void evaluate_window(void) {
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    UBaseType_t n = uxTaskGetSystemState(mon.status, TASK_MONITOR_MAX_SYSTEM_TASKS, &total);
+    if (n == 0) return;  // more tasks than TASK_MONITOR_MAX_SYSTEM_TASKS
+
+    // Elapsed time of the window on one core (the counter runs at 1 MHz)
+    configRUN_TIME_COUNTER_TYPE elapsed = total - mon.prev_total;
+
+    // Find the hog of the window (idle tasks excluded)
+    configRUN_TIME_COUNTER_TYPE hog_delta = 0;
+    const TaskStatus_t *hog = NULL;
+    for (UBaseType_t i = 0; i < n; i++) {
+        if (is_idle_task(&mon.status[i])) continue;
+        configRUN_TIME_COUNTER_TYPE d = runtime_delta(&mon.status[i]);
+        if (d > hog_delta) {
+            hog_delta = d;
+            hog = &mon.status[i];
+        }
+    }
+    if (hog) {
+        copy_name(mon.hog, hog->pcTaskName);
+        mon.hog_cpu_pct = to_pct(hog_delta, elapsed);
+        mon.hog_core = task_core(hog->xHandle);
+    } else {
+        mon.hog[0] = '\0';
+        mon.hog_cpu_pct = 0;
+        mon.hog_core = TASK_MONITOR_CORE_UNKNOWN;
+    }
+
+    // Evaluate the monitored tasks
+    uint32_t now = now_ms();
+    bool healthy = true;
+    for (int i = 0; i < mon.count; i++) {
+        monitored_task_t *t = &mon.tasks[i];
+        const TaskStatus_t *s = NULL;
+        for (UBaseType_t j = 0; j < n; j++) {
+            if (mon.status[j].xHandle == t->handle) {
+                s = &mon.status[j];
+                break;
+            }
+        }
+
+        configRUN_TIME_COUNTER_TYPE d = s ? runtime_delta(s) : 0;
+        t->cpu_pct = to_pct(d, elapsed);
+
+        // A task on the other core may check in after 'now' was read: a
+        // negative age is on time, not a wrapped 4e9 ms
+        int32_t age = (int32_t)(now - t->last_checkin_ms);
+
+        task_monitor_status_t st = TASK_MONITOR_OK;
+        if (s && d == 0 && s->eCurrentState == eReady) {
+            st = TASK_MONITOR_STARVED;
+        } else if (t->period_ms && age > 0 &&
+                   (uint32_t)age > t->period_ms * TASK_MONITOR_CHECKIN_TOLERANCE) {
+            st = TASK_MONITOR_MISSED_CHECKIN;
+        } else if (t->max_cpu_pct && t->cpu_pct > t->max_cpu_pct) {
+            st = TASK_MONITOR_OVERRUN;
+        }
+        t->status = st;
+
+        if (st != TASK_MONITOR_OK && t->critical) {
+            if (healthy && !mon.fault_recorded) {
+                record_fault(t, s);
+                mon.fault_recorded = true;
+                if (mon.fault_handler) mon.fault_handler(&fault_record);
+            }
+            healthy = false;
+        }
+    }
+
+    // Keep this window's counters for the next deltas
+    for (UBaseType_t i = 0; i < n; i++) {
+        mon.prev[i].number = mon.status[i].xTaskNumber;
+        mon.prev[i].runtime = mon.status[i].ulRunTimeCounter;
+    }
+    mon.prev_count = n;
+    mon.prev_total = total;
+
+    if (healthy) {
+        mon.fault_recorded = false;
+        if (mon.watchdog) watchdog_update();
+    }
+}
+
+static void monitor_task(void *arg) {
+    (void)arg;
+    TickType_t last_wake = xTaskGetTickCount();
+    for (;;) {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(mon.window_ms));
+        evaluate_window();
+    }
+}
+
+int task_monitor_init(uint32_t window_ms, uint32_t watchdog_timeout_ms) {
+    if (window_ms == 0) return -1;
+    if (watchdog_timeout_ms && watchdog_timeout_ms <= window_ms) return -2;
+
+    if (!fault_record_checked) fault_record_boot();
+
+    mon.window_ms = window_ms;
+    mon.hog_core = TASK_MONITOR_CORE_UNKNOWN;
+
+    if (xTaskCreate(monitor_task, "monitor", 1024, NULL, TASK_MONITOR_PRIORITY, NULL) != pdPASS) {
+        return -3;
+    }
+
+    if (watchdog_timeout_ms) {
+        // Paused while debugging so breakpoints do not reset the board
+        watchdog_enable(watchdog_timeout_ms, true);
+        mon.watchdog = true;
+    }
+    return 0;
+}
+
+int task_monitor_register(TaskHandle_t task, uint32_t period_ms, uint8_t max_cpu_pct, bool critical) {
+    if (task == NULL) task = xTaskGetCurrentTaskHandle();
+    if (task == NULL) return -1;
+
+    int id = -2;
+    taskENTER_CRITICAL();
+    if (mon.count < TASK_MONITOR_MAX_TASKS) {
+        id = mon.count;
+        monitored_task_t *t = &mon.tasks[id];
+        t->handle = task;
+        t->period_ms = period_ms;
+        t->max_cpu_pct = max_cpu_pct;
+        t->critical = critical;
+        t->last_checkin_ms = now_ms();
+        t->cpu_pct = 0;
+        t->status = TASK_MONITOR_OK;
+        mon.count++;
+    }
+    taskEXIT_CRITICAL();
+    return id;
+}
+
+void task_monitor_checkin(int id) {
+    if (id < 0 || id >= mon.count) return;
+    mon.tasks[id].last_checkin_ms = now_ms();
+}
+
+task_monitor_status_t task_monitor_status(int id) {
+    if (id < 0 || id >= mon.count) return TASK_MONITOR_OK;
+    return mon.tasks[id].status;
+}
+
+void task_monitor_set_fault_handler(task_monitor_fault_handler_t handler) {
+    mon.fault_handler = handler;
+}
+
+bool task_monitor_last_fault(task_monitor_fault_t *out) {
+    // The record is reset by task_monitor_init(): read it once here if needed
+    if (!fault_record_checked) fault_record_boot();
+    if (!previous_fault_valid) return false;
+    if (out) *out = previous_fault;
+    return true;
+}
+
+static const char *status_name(task_monitor_status_t st) {
+    switch (st) {
+        case TASK_MONITOR_OK:             return "ok";
+        case TASK_MONITOR_MISSED_CHECKIN: return "MISSED";
+        case TASK_MONITOR_STARVED:        return "STARVED";
+        case TASK_MONITOR_OVERRUN:        return "OVERRUN";
+        default:                          return "?";
+    }
+}
+
+int task_monitor_format_report(char *buf, size_t len) {
+    if (!buf || len == 0) return 0;
+    size_t pos = 0;
+    int n;
+
+    for (int i = 0; i < mon.count && pos < len; i++) {
+        const monitored_task_t *t = &mon.tasks[i];
+        n = snprintf(buf + pos, len - pos, "[mon] %-*s %-7s cpu=%3u%%%s\n",
+                     TASK_MONITOR_NAME_LEN - 1, pcTaskGetName(t->handle),
+                     status_name(t->status), t->cpu_pct, t->critical ? " (critical)" : "");
+        if (n < 0) break;
+        pos += (size_t)n;
+    }
+    if (pos < len) {
+        if (mon.hog_core == TASK_MONITOR_CORE_UNKNOWN) {
+            n = snprintf(buf + pos, len - pos, "[mon] hog: %s %u%% core ?\n",
+                         mon.hog[0] ? mon.hog : "-", mon.hog_cpu_pct);
+        } else {
+            n = snprintf(buf + pos, len - pos, "[mon] hog: %s %u%% core %u\n",
+                         mon.hog[0] ? mon.hog : "-", mon.hog_cpu_pct, mon.hog_core);
+        }
+        if (n > 0) pos += (size_t)n;
+    }
+    return (int)(pos < len ? pos : len - 1);
+}
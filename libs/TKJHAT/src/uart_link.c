@@ -0,0 +1,501 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <tkjhat/uart_link.h>
+#include <tkjhat/hw_res.h>
+#include <tkjhat/gpio_irq.h>
+#include <tkjhat/lock_profiler.h>
+#include <tkjhat/sram.h>
+#include <tkjhat/xip_prof.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <task.h>
+#include <semphr.h>
+
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/uart.h"
+
+#define RX_MASK             (UART_LINK_RX_RING_SIZE - 1)
+#define TX_MASK             (UART_LINK_TX_RING_SIZE - 1)
+#define RX_XFER_COUNT       0xFFFFFFFFu     // re-armed from the IRQ (~4 h at 3 Mbaud)
+#define UART_RSR_ERRORS     0x0Fu           // FE | PE | BE | OE
+#define LINK_TASK_STACK     512
+#define LINK_POLL_TICKS     pdMS_TO_TICKS(10)
+
+// Save/restore spin lock: the RX edge and the idle alarm may fire on different cores
+#define LOCK_NUM            (PICO_SPINLOCK_ID_STRIPED_FIRST + 6)
+
+// DMA ring buffers must be aligned to their size for address wrapping
+static uint8_t rx_ring[UART_LINK_RX_RING_SIZE] __attribute__((aligned(UART_LINK_RX_RING_SIZE))) TKJHAT_DMA_BUFFER;
+static uint8_t tx_ring[UART_LINK_TX_RING_SIZE] __attribute__((aligned(UART_LINK_TX_RING_SIZE))) TKJHAT_DMA_BUFFER;
+
+static struct {
+    uart_inst_t *uart;
+    uart_link_config_t config;
+    int rx_dma;
+    int tx_dma;
+    TaskHandle_t task;
+    bool running;
+
+    // RX (DMA producer, link task consumer)
+    uint64_t rx_done;                   // bytes of completed RX transfers
+    uint64_t rx_consumed;
+    uint64_t rx_noted;                  // bytes reported to the resource manager
+    uint32_t idle_last_wr;              // write pointer at the previous alarm
+    uint32_t idle_notified_wr;          // write pointer when the task was last woken
+    alarm_id_t idle_alarm;
+    volatile bool idle_armed;           // idle alarm running (RX edge interrupt off)
+    bool rx_edge_on;                    // RX pin registered with gpio_irq
+    link_frame_decoder_t decoder;
+
+    // TX (senders producer, DMA consumer)
+    uint32_t tx_head;
+    uint32_t tx_tail;
+    uint32_t tx_inflight;
+    bool tx_busy;
+    uint8_t tx_seq;
+    SemaphoreHandle_t tx_mtx;
+    int tx_lock;                        // lock profiler id
+    SemaphoreHandle_t tx_space;
+
+    uart_link_stats_t stats;
+    uint64_t rtt_sum_us;
+    uint64_t report_tx_bytes;
+    uint64_t report_rx_bytes;
+    uint32_t report_us;
+} link = { .rx_dma = -1, .tx_dma = -1, .tx_lock = -1 };
+
+static inline uint32_t lock(void) {
+    return spin_lock_blocking(spin_lock_instance(LOCK_NUM));
+}
+
+static inline void unlock(uint32_t save) {
+    spin_unlock(spin_lock_instance(LOCK_NUM), save);
+}
+
+/* =========================
+ *  DMA / timer interrupts
+ * ========================= */
+// Called with interrupts masked / inside a critical section
+static void tx_kick(void) {
+    if (link.tx_busy || link.tx_head == link.tx_tail) return;
+    link.tx_inflight = link.tx_head - link.tx_tail;
+    link.tx_busy = true;
+    hw_res_dma_note(link.tx_dma, link.tx_inflight);
+    // The read ring makes the transfer wrap at the end of tx_ring
+    dma_channel_transfer_from_buffer_now(link.tx_dma, &tx_ring[link.tx_tail & TX_MASK], link.tx_inflight);
+}
+
+static void uart_link_dma_handler(void) {
+    XIP_PROF_ISR_ENTER(XIP_PROF_ISR_UART_LINK);
+    uint32_t ints = dma_hw->ints1;
+    BaseType_t woken = pdFALSE;
+
+    if (link.rx_dma >= 0 && (ints & (1u << link.rx_dma))) {
+        dma_hw->ints1 = 1u << link.rx_dma;
+        UBaseType_t s = taskENTER_CRITICAL_FROM_ISR();
+        link.rx_done += RX_XFER_COUNT;
+        // Write address keeps wrapping inside the ring, only the count is reloaded
+        dma_channel_set_trans_count(link.rx_dma, RX_XFER_COUNT, true);
+        taskEXIT_CRITICAL_FROM_ISR(s);
+    }
+
+    if (link.tx_dma >= 0 && (ints & (1u << link.tx_dma))) {
+        dma_hw->ints1 = 1u << link.tx_dma;
+        UBaseType_t s = taskENTER_CRITICAL_FROM_ISR();
+        link.tx_tail += link.tx_inflight;
+        link.tx_inflight = 0;
+        link.tx_busy = false;
+        tx_kick();
+        taskEXIT_CRITICAL_FROM_ISR(s);
+        xSemaphoreGiveFromISR(link.tx_space, &woken);
+    }
+
+    XIP_PROF_ISR_EXIT();
+    portYIELD_FROM_ISR(woken);
+}
+
+static inline uint32_t rx_write_ptr(void) {
+    return dma_hw->ch[link.rx_dma].write_addr;
+}
+
+// Software idle-line detection: the DMA write pointer did not move for one
+// period. The alarm only runs while bytes arrive: the first start bit (falling
+// edge on the RX pin) arms it and it stops once the line is idle again.
+static int64_t idle_alarm_cb(alarm_id_t id, void *user) {
+    (void)id;
+    (void)user;
+    int64_t again = -(int64_t)link.config.idle_us;      // relative to the last expiry
+    uint32_t wr = rx_write_ptr();
+    bool moved = wr != link.idle_last_wr;
+    link.idle_last_wr = wr;
+
+    uint32_t pending = (wr - link.idle_notified_wr) & RX_MASK;
+    if ((!moved && wr != link.idle_notified_wr) || pending >= UART_LINK_RX_RING_SIZE / 2) {
+        BaseType_t woken = pdFALSE;
+        link.idle_notified_wr = wr;
+        link.stats.idle_events++;
+        vTaskNotifyGiveFromISR(link.task, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+    if (moved) return again;
+
+    // Idle: hand over to the edge interrupt (enabling it drops stale edges).
+    // A byte that started before that shows up as a moved write pointer, and
+    // the alarm keeps running unless the edge handler already re-armed it.
+    uint32_t save = lock();
+    link.idle_armed = false;
+    unlock(save);
+    gpio_set_irq_enabled(link.config.rx_pin, GPIO_IRQ_EDGE_FALL, true);
+    if (rx_write_ptr() == wr) return 0;
+
+    save = lock();
+    bool keep = !link.idle_armed;
+    if (keep) link.idle_armed = true;
+    unlock(save);
+    if (!keep) return 0;
+    gpio_set_irq_enabled(link.config.rx_pin, GPIO_IRQ_EDGE_FALL, false);
+    return again;
+}
+
+// Start bit on an idle line: run the idle alarm until the burst ends
+static void rx_edge_handler(const gpio_irq_event_t *ev, void *ctx) {
+    (void)ev;
+    (void)ctx;
+    gpio_set_irq_enabled(link.config.rx_pin, GPIO_IRQ_EDGE_FALL, false);
+
+    uint32_t save = lock();
+    bool arm = !link.idle_armed;
+    if (arm) link.idle_armed = true;
+    unlock(save);
+    if (!arm) return;
+
+    link.idle_last_wr = rx_write_ptr();
+    link.idle_alarm = add_alarm_in_us(link.config.idle_us, idle_alarm_cb, NULL, true);
+    if (link.idle_alarm <= 0) {
+        // No free alarm: wait for the next edge; the link task's poll covers the gap
+        link.idle_armed = false;
+        gpio_set_irq_enabled(link.config.rx_pin, GPIO_IRQ_EDGE_FALL, true);
+    }
+}
+
+/* =========================
+ *  TX
+ * ========================= */
+static int send_frame(uint8_t type, const void *data, size_t len, TickType_t wait) {
+    uint8_t frame[LINK_FRAME_MAX_SIZE];
+
+    if (!link.running) return -1;
+    if (len > LINK_FRAME_MAX_PAYLOAD) return -2;
+
+    TickType_t start = xTaskGetTickCount();
+    if (lock_prof_take(link.tx_lock, wait) != pdTRUE) {
+        link.stats.tx_dropped++;
+        return -3;
+    }
+
+    size_t n = link_frame_encode(type, link.tx_seq, data, len, frame, sizeof(frame));
+
+    for (;;) {
+        taskENTER_CRITICAL();
+        uint32_t free_bytes = UART_LINK_TX_RING_SIZE - (link.tx_head - link.tx_tail);
+        taskEXIT_CRITICAL();
+        if (free_bytes >= n) break;
+
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= wait || xSemaphoreTake(link.tx_space, wait - elapsed) != pdTRUE) {
+            link.stats.tx_dropped++;
+            lock_prof_give(link.tx_lock);
+            return -4;
+        }
+    }
+
+    // Only this task writes past tx_head, the DMA never reads there
+    uint32_t head = link.tx_head;
+    size_t first = UART_LINK_TX_RING_SIZE - (head & TX_MASK);
+    if (first > n) first = n;
+    memcpy(&tx_ring[head & TX_MASK], frame, first);
+    memcpy(tx_ring, frame + first, n - first);
+
+    taskENTER_CRITICAL();
+    link.tx_head = head + n;
+    link.stats.tx_frames++;
+    link.stats.tx_bytes += n;
+    tx_kick();
+    taskEXIT_CRITICAL();
+
+    link.tx_seq++;
+    lock_prof_give(link.tx_lock);
+    return 0;
+}
+
+/* =========================
+ *  RX
+ * ========================= */
+static uint64_t rx_received(void) {
+    taskENTER_CRITICAL();
+    uint64_t total = link.rx_done + (RX_XFER_COUNT - dma_hw->ch[link.rx_dma].transfer_count);
+    taskEXIT_CRITICAL();
+    return total;
+}
+
+static void handle_frame(const link_frame_decoder_t *d) {
+    switch (d->type) {
+    case LINK_FRAME_DATA:
+        link.stats.rx_frames++;
+        if (link.config.rx_handler) link.config.rx_handler(d->payload, d->len, link.config.rx_ctx);
+        break;
+
+    case LINK_FRAME_PING:
+        send_frame(LINK_FRAME_PONG, d->payload, d->len, 0);
+        break;
+
+    case LINK_FRAME_PONG:
+        if (d->len == 4) {
+            uint32_t sent = (uint32_t)d->payload[0] | ((uint32_t)d->payload[1] << 8) |
+                            ((uint32_t)d->payload[2] << 16) | ((uint32_t)d->payload[3] << 24);
+            uint32_t rtt = time_us_32() - sent;
+            uart_link_stats_t *s = &link.stats;
+            s->pings++;
+            s->rtt_last_us = rtt;
+            if (s->pings == 1 || rtt < s->rtt_min_us) s->rtt_min_us = rtt;
+            if (rtt > s->rtt_max_us) s->rtt_max_us = rtt;
+            link.rtt_sum_us += rtt;
+            s->rtt_avg_us = (uint32_t)(link.rtt_sum_us / s->pings);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+static void rx_drain(void) {
+    uint64_t total = rx_received();
+    uint64_t avail = total - link.rx_consumed;
+    if (total != link.rx_noted) {
+        hw_res_dma_note(link.rx_dma, (uint32_t)(total - link.rx_noted));
+        link.rx_noted = total;
+    }
+
+    if (avail > UART_LINK_RX_RING_SIZE) {
+        // The DMA lapped the reader: skip to the oldest byte still in the ring
+        link.stats.rx_overruns += (uint32_t)(avail - UART_LINK_RX_RING_SIZE);
+        link.rx_consumed = total - UART_LINK_RX_RING_SIZE;
+        avail = UART_LINK_RX_RING_SIZE;
+    }
+
+    while (avail--) {
+        uint8_t b = rx_ring[link.rx_consumed++ & RX_MASK];
+        if (link_frame_decode_byte(&link.decoder, b) == LINK_FRAME_READY) {
+            handle_frame(&link.decoder);
+        }
+    }
+    link.stats.rx_bytes = link.rx_consumed;
+
+    uart_hw_t *hw = uart_get_hw(link.uart);
+    uint32_t errors = hw->rsr & UART_RSR_ERRORS;
+    if (errors) {
+        link.stats.uart_errors++;
+        hw->rsr = errors;       // any write clears the error flags
+    }
+}
+
+static void uart_link_task(void *arg) {
+    (void)arg;
+    for (;;) {
+        // Woken by idle detection; the timeout is a safety net
+        ulTaskNotifyTake(pdTRUE, LINK_POLL_TICKS);
+        rx_drain();
+    }
+}
+
+/* =========================
+ *  API
+ * ========================= */
+// Undoes the steps of a failed uart_link_init(), newest first, so a retry
+// starts from nothing. Steps not reached are still at their sentinels.
+static int init_unwind(int err) {
+    if (link.rx_edge_on) gpio_irq_unregister(link.config.rx_pin);
+    if (link.idle_armed) cancel_alarm(link.idle_alarm);
+    if (link.task) vTaskDelete(link.task);
+    hw_res_irq_remove(DMA_IRQ_1, uart_link_dma_handler);     // no-op if not installed
+    hw_res_dma_release(link.tx_dma);
+    hw_res_dma_release(link.rx_dma);
+    if (link.tx_space) vSemaphoreDelete(link.tx_space);
+    if (link.tx_mtx) vSemaphoreDelete(link.tx_mtx);
+    uart_deinit(link.uart);
+
+    link.rx_edge_on = false;
+    link.idle_armed = false;
+    link.task = NULL;
+    link.tx_space = link.tx_mtx = NULL;
+    link.rx_dma = link.tx_dma = link.tx_lock = -1;
+    return err;
+}
+
+int uart_link_init(const uart_link_config_t *config) {
+    if (!config || link.running) return -1;
+    if (config->uart != DEFAULT_UART_0 && config->uart != DEFAULT_UART_1) return -2;
+
+    memset(&link, 0, sizeof(link));
+    link.rx_dma = link.tx_dma = link.tx_lock = -1;
+    link.config = *config;
+    if (link.config.idle_us == 0) link.config.idle_us = 100;
+    link.uart = config->uart == DEFAULT_UART_0 ? uart0 : uart1;
+    link_frame_decoder_init(&link.decoder);
+
+    // UART. uart_init() also enables the TX/RX DMA requests.
+    link.stats.baud = uart_init(link.uart, config->baud);
+    uart_set_format(link.uart, 8, 1, UART_PARITY_NONE);
+    uart_set_fifo_enabled(link.uart, true);
+    gpio_set_function(config->tx_pin, GPIO_FUNC_UART);
+    gpio_set_function(config->rx_pin, GPIO_FUNC_UART);
+    bool cts = config->cts_pin != UART_LINK_PIN_UNUSED;
+    bool rts = config->rts_pin != UART_LINK_PIN_UNUSED;
+    if (cts) gpio_set_function(config->cts_pin, GPIO_FUNC_UART);
+    if (rts) gpio_set_function(config->rts_pin, GPIO_FUNC_UART);
+    uart_set_hw_flow(link.uart, cts, rts);
+
+    link.tx_mtx = xSemaphoreCreateMutex();
+    link.tx_space = xSemaphoreCreateBinary();
+    if (!link.tx_mtx || !link.tx_space) return init_unwind(-3);
+
+    link.rx_dma = hw_res_dma_claim("uart_rx");
+    link.tx_dma = hw_res_dma_claim("uart_tx");
+    if (link.rx_dma < 0 || link.tx_dma < 0) return init_unwind(-4);
+    // DMA_IRQ_0 belongs to the microphone; share DMA_IRQ_1 (enabled per channel below)
+    if (hw_res_irq_add_shared("uart_link", DMA_IRQ_1, uart_link_dma_handler) != 0) return init_unwind(-4);
+
+    // RX: UART DR -> rx_ring, write address wraps on the ring size
+    dma_channel_config c = dma_channel_get_default_config(link.rx_dma);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, UART_LINK_RX_RING_BITS);
+    channel_config_set_dreq(&c, uart_get_dreq(link.uart, false));
+    dma_channel_configure(link.rx_dma, &c, rx_ring, &uart_get_hw(link.uart)->dr, RX_XFER_COUNT, false);
+
+    // TX: tx_ring -> UART DR, read address wraps on the ring size
+    c = dma_channel_get_default_config(link.tx_dma);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_ring(&c, false, UART_LINK_TX_RING_BITS);
+    channel_config_set_dreq(&c, uart_get_dreq(link.uart, true));
+    dma_channel_configure(link.tx_dma, &c, &uart_get_hw(link.uart)->dr, tx_ring, 0, false);
+
+    if (xTaskCreate(uart_link_task, "uart_link", LINK_TASK_STACK, NULL,
+                    UART_LINK_TASK_PRIORITY, &link.task) != pdPASS) {
+        link.task = NULL;
+        return init_unwind(-5);
+    }
+
+    // Idle detection, armed by the first start bit. The RX channel is not
+    // started yet: the alarm sees the write pointer at rest.
+    link.idle_last_wr = link.idle_notified_wr = (uint32_t)(uintptr_t)rx_ring;
+    if (gpio_irq_register(config->rx_pin, GPIO_IRQ_EDGE_FALL, rx_edge_handler, NULL, false) != 0) {
+        return init_unwind(-6);
+    }
+    link.rx_edge_on = true;
+
+    // Last, so a failed init never leaves the profiler naming a deleted mutex
+    link.tx_lock = lock_prof_register(link.tx_mtx, "uart_tx");
+    if (link.tx_lock < 0) return init_unwind(-7);
+
+    // Nothing can fail from here on
+    dma_hw->ints1 = (1u << link.rx_dma) | (1u << link.tx_dma);
+    dma_channel_set_irq1_enabled(link.rx_dma, true);
+    dma_channel_set_irq1_enabled(link.tx_dma, true);
+    irq_set_enabled(DMA_IRQ_1, true);
+
+    link.report_us = time_us_32();
+    link.running = true;
+    dma_channel_start(link.rx_dma);
+    return 0;
+}
+
+int uart_link_send(const void *data, size_t len, TickType_t wait) {
+    return send_frame(LINK_FRAME_DATA, data, len, wait);
+}
+
+int uart_link_ping(void) {
+    uint32_t now = time_us_32();
+    uint8_t ts[4] = { (uint8_t)now, (uint8_t)(now >> 8), (uint8_t)(now >> 16), (uint8_t)(now >> 24) };
+    return send_frame(LINK_FRAME_PING, ts, sizeof(ts), 0);
+}
+
+void uart_link_get_stats(uart_link_stats_t *out) {
+    if (!out) return;
+    taskENTER_CRITICAL();
+    *out = link.stats;
+    taskEXIT_CRITICAL();
+    // Decoder counters are owned by the link task; a torn read only affects one report
+    out->rx_crc_errors   = link.decoder.crc_errors;
+    out->rx_lost         = link.decoder.lost;
+    out->rx_resync_bytes = link.decoder.resync_bytes;
+}
+
+int uart_link_format_report(char *buf, size_t len) {
+    if (!buf || len == 0) return 0;
+
+    uart_link_stats_t snap;
+    uart_link_get_stats(&snap);
+    const uart_link_stats_t *s = &snap;
+
+    uint32_t now = time_us_32();
+    uint32_t dt = now - link.report_us;
+    if (dt) {
+        snap.tx_bytes_per_s = (uint32_t)(((snap.tx_bytes - link.report_tx_bytes) * 1000000ull) / dt);
+        snap.rx_bytes_per_s = (uint32_t)(((snap.rx_bytes - link.report_rx_bytes) * 1000000ull) / dt);
+    }
+    link.report_us = now;
+    link.report_tx_bytes = snap.tx_bytes;
+    link.report_rx_bytes = snap.rx_bytes;
+    taskENTER_CRITICAL();
+    link.stats.tx_bytes_per_s = snap.tx_bytes_per_s;
+    link.stats.rx_bytes_per_s = snap.rx_bytes_per_s;
+    taskEXIT_CRITICAL();
+
+    int n = snprintf(buf, len,
+                     "[link] %lu baud tx=%lu fr %lu B/s drop=%lu | rx=%lu fr %lu B/s crc=%lu lost=%lu "
+                     "ovr=%lu uerr=%lu | rtt last/min/avg/max=%lu/%lu/%lu/%luus\n",
+                     (unsigned long)s->baud,
+                     (unsigned long)s->tx_frames, (unsigned long)s->tx_bytes_per_s, (unsigned long)s->tx_dropped,
+                     (unsigned long)s->rx_frames, (unsigned long)s->rx_bytes_per_s,
+                     (unsigned long)s->rx_crc_errors, (unsigned long)s->rx_lost,
+                     (unsigned long)s->rx_overruns, (unsigned long)s->uart_errors,
+                     (unsigned long)s->rtt_last_us, (unsigned long)s->rtt_min_us,
+                     (unsigned long)s->rtt_avg_us, (unsigned long)s->rtt_max_us);
+    if (n < 0) return 0;
+    return n < (int)len ? n : (int)len - 1;
+}
@@ -0,0 +1,374 @@
+/*
+
+Version 0.8
+
+MIT License
+
+Copyright (c) 2025 Raisul Islam, Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <tkjhat/xip_prof.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/sync.h"
+#include "hardware/structs/xip_ctrl.h"
+
+#define CTX_OTHER       0u
+#define CTX_FIRST_ISR   1u
+#define CTX_FIRST_TASK  (CTX_FIRST_ISR + XIP_PROF_ISR_COUNT)
+#define CORES           configNUMBER_OF_CORES
+#define CLEAR_AT        0x80000000u     // clear well before the counters saturate
+
+typedef struct {
+    const void *task;           // owning task, NULL for "other", ISRs and deleted tasks
+    bool idle;
+    uint64_t acc, hit, run_us;  // cumulative
+    uint64_t prev_acc, prev_hit, prev_run_us;
+} context_t;
+
+static struct {
+    spin_lock_t *volatile lock; // set last: the hooks do nothing until then
+    uint32_t window_ms;
+    uint32_t report_every;
+    xip_prof_sink_t sink;
+    uint32_t clk_mhz;
+
+    // Accounting, under the spin lock
+    uint32_t cur[CORES];        // context running on each core
+    uint32_t last_acc, last_hit, last_us;
+    uint64_t total_acc, total_hit;
+    uint64_t prev_acc, prev_hit;
+    context_t ctx[XIP_PROF_MAX_CONTEXTS];
+    uint32_t count;
+
+    // Last window, under the spin lock
+    xip_prof_context_t window[XIP_PROF_MAX_CONTEXTS];
+    xip_prof_stats_t stats;
+} prof;
+
+static const char *const isr_names[XIP_PROF_ISR_COUNT] = {
+    "isr:gpio", "isr:pdm", "isr:asset", "isr:uart", "isr:user0", "isr:user1",
+};
+
+/* =========================
+ *  Accounting (runs from SRAM, so it does not disturb what it measures)
+ * ========================= */
+
+// Credit the accesses since the previous event to the contexts running on the cores
+static void __not_in_flash_func(account)(void) {
+    uint32_t hit = xip_ctrl_hw->ctr_hit;
+    uint32_t acc = xip_ctrl_hw->ctr_acc;
+    uint32_t now = time_us_32();
+
+    uint32_t d_acc = acc - prof.last_acc;
+    uint32_t d_hit = hit - prof.last_hit;
+    if (d_hit > d_acc) d_hit = d_acc;
+    if (acc >= CLEAR_AT) {
+        // Writing any value clears a counter
+        xip_ctrl_hw->ctr_acc = 0;
+        xip_ctrl_hw->ctr_hit = 0;
+        acc = hit = 0;
+        prof.stats.clears++;
+    }
+    prof.last_acc = acc;
+    prof.last_hit = hit;
+    uint32_t dt = now - prof.last_us;
+    prof.last_us = now;
+    prof.total_acc += d_acc;
+    prof.total_hit += d_hit;
+
+    // Shared cache: split between the busy cores, idle cores get nothing
+    uint32_t busy = 0;
+    for (int c = 0; c < CORES; c++) {
+        prof.ctx[prof.cur[c]].run_us += dt;
+        if (!prof.ctx[prof.cur[c]].idle) busy++;
+    }
+    uint32_t share = busy ? busy : CORES;
+    for (int c = 0; c < CORES; c++) {
+        context_t *x = &prof.ctx[prof.cur[c]];
+        if (busy && x->idle) continue;
+        uint32_t a = d_acc / share, h = d_hit / share;
+        if (--share == 0) {
+            a = d_acc;      // the last one takes the rounding
+            h = d_hit;
+        }
+        x->acc += a;
+        x->hit += h;
+        d_acc -= a;
+        d_hit -= h;
+    }
+}
+
+static void init_context(uint32_t i, const void *task, const char *name, bool idle) {
+    context_t *x = &prof.ctx[i];
+    memset(x, 0, sizeof(*x));
+    x->task = task;
+    x->idle = idle;
+    memset(&prof.window[i], 0, sizeof(prof.window[i]));
+    strncpy(prof.window[i].name, name, XIP_PROF_NAME_LEN - 1);
+    prof.window[i].isr = i >= CTX_FIRST_ISR && i < CTX_FIRST_TASK;
+}
+
+// First switch to a task: give it a free slot (rare, may run from flash)
+static uint32_t new_task_context(const void *task) {
+    uint32_t i = CTX_FIRST_TASK;
+    while (i < prof.count && (prof.ctx[i].task || prof.window[i].name[0])) i++;
+    if (i == XIP_PROF_MAX_CONTEXTS) {
+        prof.stats.untracked++;
+        return CTX_OTHER;
+    }
+    if (i == prof.count) prof.count++;
+    bool idle = false;
+    for (int c = 0; c < CORES; c++) {
+        if ((const void *)xTaskGetIdleTaskHandleForCore(c) == task) idle = true;
+    }
+    init_context(i, task, pcTaskGetName((TaskHandle_t)task), idle);
+    return i;
+}
+
+static uint32_t __not_in_flash_func(task_context)(const void *task) {
+    for (uint32_t i = CTX_FIRST_TASK; i < prof.count; i++) {
+        if (prof.ctx[i].task == task) return i;
+    }
+    return new_task_context(task);
+}
+
+void __not_in_flash_func(xip_prof_task_switched_in)(void *task) {
+    spin_lock_t *lock = prof.lock;
+    if (!lock || !task) return;
+    uint32_t save = spin_lock_blocking(lock);
+    account();
+    prof.cur[get_core_num()] = task_context(task);
+    spin_unlock(lock, save);
+}
+
+void xip_prof_task_deleted(void *task) {
+    spin_lock_t *lock = prof.lock;
+    if (!lock) return;
+    uint32_t save = spin_lock_blocking(lock);
+    for (uint32_t i = CTX_FIRST_TASK; i < prof.count; i++) {
+        // Keeps its name until its last window is reported, then the slot is reused
+        if (prof.ctx[i].task == task) prof.ctx[i].task = NULL;
+    }
+    spin_unlock(lock, save);
+}
+
+uint32_t __not_in_flash_func(xip_prof_isr_enter)(xip_prof_isr_t id) {
+    spin_lock_t *lock = prof.lock;
+    if (!lock || (unsigned)id >= XIP_PROF_ISR_COUNT) return CTX_OTHER;
+    uint32_t save = spin_lock_blocking(lock);
+    account();
+    uint32_t core = get_core_num();
+    uint32_t prev = prof.cur[core];
+    prof.cur[core] = CTX_FIRST_ISR + (uint32_t)id;
+    spin_unlock(lock, save);
+    return prev;
+}
+
+void __not_in_flash_func(xip_prof_isr_exit)(uint32_t prev) {
+    spin_lock_t *lock = prof.lock;
+    if (!lock || prev >= XIP_PROF_MAX_CONTEXTS) return;
+    uint32_t save = spin_lock_blocking(lock);
+    account();
+    prof.cur[get_core_num()] = prev;
+    spin_unlock(lock, save);
+}
+
+/* =========================
+ *  Windows and reports
+ * ========================= */
+
+static uint32_t stall_us(uint64_t misses) {
+    return (uint32_t)(misses * XIP_PROF_MISS_CYCLES / prof.clk_mhz);
+}
+
+static void close_window(void) {
+    uint32_t save = spin_lock_blocking(prof.lock);
+    account();
+    for (uint32_t i = 0; i < prof.count; i++) {
+        context_t *x = &prof.ctx[i];
+        xip_prof_context_t *w = &prof.window[i];
+        // A deleted task is dropped once a window went by without it
+        if (i >= CTX_FIRST_TASK && !x->task && w->acc == 0 && x->acc == x->prev_acc) w->name[0] = '\0';
+        w->acc = (uint32_t)(x->acc - x->prev_acc);
+        w->hit = (uint32_t)(x->hit - x->prev_hit);
+        w->run_us = (uint32_t)(x->run_us - x->prev_run_us);
+        w->stall_us = stall_us(w->acc - w->hit);
+        x->prev_acc = x->acc;
+        x->prev_hit = x->hit;
+        x->prev_run_us = x->run_us;
+    }
+    xip_prof_stats_t *s = &prof.stats;
+    s->acc = (uint32_t)(prof.total_acc - prof.prev_acc);
+    s->hit = (uint32_t)(prof.total_hit - prof.prev_hit);
+    s->stall_us = stall_us(s->acc - s->hit);
+    s->total_acc = prof.total_acc;
+    s->total_hit = prof.total_hit;
+    s->contexts = prof.count;
+    s->windows++;
+    prof.prev_acc = prof.total_acc;
+    prof.prev_hit = prof.total_hit;
+    spin_unlock(prof.lock, save);
+}
+
+static void prof_task(void *arg) {
+    (void)arg;
+    static char text[768];
+    TickType_t last_wake = xTaskGetTickCount();
+    for (;;) {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(prof.window_ms));
+        close_window();
+        if (prof.report_every && prof.stats.windows % prof.report_every == 0) {
+            xip_prof_format_report(text, sizeof(text));
+            prof.sink(text);
+        }
+    }
+}
+
+int xip_prof_start(uint32_t window_ms, uint32_t report_every, xip_prof_sink_t sink) {
+    if (prof.lock) return -1;
+    if (window_ms == 0) return -2;
+    if (report_every && !sink) return -3;
+    int lock_num = spin_lock_claim_unused(false);
+    if (lock_num < 0) return -4;
+
+    prof.window_ms = window_ms;
+    prof.report_every = report_every;
+    prof.sink = sink;
+    prof.clk_mhz = clock_get_hz(clk_sys) / 1000000u;
+    if (prof.clk_mhz == 0) prof.clk_mhz = 1;
+    memset(&prof.stats, 0, sizeof(prof.stats));
+    prof.stats.window_ms = window_ms;
+    prof.stats.tracing = xip_prof_tracing();
+
+    init_context(CTX_OTHER, NULL, "other", false);
+    for (uint32_t i = 0; i < XIP_PROF_ISR_COUNT; i++) init_context(CTX_FIRST_ISR + i, NULL, isr_names[i], false);
+    prof.count = CTX_FIRST_TASK;
+    for (int c = 0; c < CORES; c++) prof.cur[c] = CTX_OTHER;
+
+    xip_ctrl_hw->ctr_acc = 0;
+    xip_ctrl_hw->ctr_hit = 0;
+    prof.last_acc = prof.last_hit = 0;
+    prof.last_us = time_us_32();
+
+    if (xTaskCreate(prof_task, "xipprof", 1024, NULL, XIP_PROF_PRIORITY, NULL) != pdPASS) {
+        spin_lock_unclaim(lock_num);
+        return -5;
+    }
+    __dmb();
+    prof.lock = spin_lock_init((uint)lock_num);
+    return 0;
+}
+
+bool xip_prof_tracing(void) {
+#if defined(TKJHAT_XIP_PROFILE) && TKJHAT_XIP_PROFILE
+    return true;
+#else
+    return false;
+#endif
+}
+
+void xip_prof_get_stats(xip_prof_stats_t *out) {
+    if (!out) return;
+    if (!prof.lock) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    uint32_t save = spin_lock_blocking(prof.lock);
+    *out = prof.stats;
+    spin_unlock(prof.lock, save);
+}
+
+size_t xip_prof_get_contexts(xip_prof_context_t *out, size_t max) {
+    if (!out || !prof.lock) return 0;
+    size_t n = 0;
+    uint32_t save = spin_lock_blocking(prof.lock);
+    for (uint32_t i = 0; i < prof.count; i++) {
+        const xip_prof_context_t *w = &prof.window[i];
+        if (!w->name[0] || (w->acc == 0 && w->run_us == 0)) continue;
+        // Insertion by misses; the last entry falls off when the output is full
+        uint32_t miss = w->acc - w->hit;
+        size_t j = n < max ? n++ : max;
+        while (j > 0 && out[j - 1].acc - out[j - 1].hit < miss) {
+            if (j < max) out[j] = out[j - 1];
+            j--;
+        }
+        if (j < max) out[j] = *w;
+    }
+    spin_unlock(prof.lock, save);
+    return n;
+}
+
+// Rate with two decimals, as 10000 * part / whole
+static uint32_t per10k(uint64_t part, uint64_t whole) {
+    return whole ? (uint32_t)(part * 10000u / whole) : 0;
+}
+
+int xip_prof_format_report(char *buf, size_t len) {
+    if (!buf || len == 0) return 0;
+    buf[0] = '\0';
+    xip_prof_stats_t s;
+    xip_prof_get_stats(&s);
+    if (s.windows == 0) return 0;
+
+    size_t pos = 0;
+    int n;
+    uint32_t rate = per10k(s.hit, s.acc);
+    uint32_t total = per10k(s.total_hit, s.total_acc);
+    uint32_t stall = per10k(s.stall_us, (uint64_t)s.window_ms * 1000u * CORES);
+    n = snprintf(buf, len, "[xip] %lu ms: %lu acc, hit %lu.%02lu %% (%lu.%02lu %% total), %lu miss, ~%lu us stall (%lu.%02lu %% of %d cores)\n",
+                 (unsigned long)s.window_ms, (unsigned long)s.acc,
+                 (unsigned long)(rate / 100), (unsigned long)(rate % 100),
+                 (unsigned long)(total / 100), (unsigned long)(total % 100),
+                 (unsigned long)(s.acc - s.hit), (unsigned long)s.stall_us,
+                 (unsigned long)(stall / 100), (unsigned long)(stall % 100), CORES);
+    if (n < 0) return 0;
+    pos = (size_t)n < len ? (size_t)n : len - 1;
+    if (!s.tracing) return (int)pos;
+
+    xip_prof_context_t top[XIP_PROF_REPORT_TOP];
+    size_t count = xip_prof_get_contexts(top, XIP_PROF_REPORT_TOP);
+    for (size_t i = 0; i < count && pos < len - 1; i++) {
+        const xip_prof_context_t *c = &top[i];
+        uint32_t hit = per10k(c->hit, c->acc);
+        n = snprintf(buf + pos, len - pos, "[xip] %-*s acc=%8lu hit=%3lu.%02lu%% miss=%7lu ~stall=%6lu us run=%3lu%%\n",
+                     XIP_PROF_NAME_LEN - 1, c->name, (unsigned long)c->acc,
+                     (unsigned long)(hit / 100), (unsigned long)(hit % 100),
+                     (unsigned long)(c->acc - c->hit), (unsigned long)c->stall_us,
+                     (unsigned long)((uint64_t)c->run_us * 100u / ((uint64_t)s.window_ms * 1000u)));
+        if (n < 0) break;
+        pos += (size_t)n;
+    }
+    if (pos >= len) pos = len - 1;
+    if (s.untracked) {
+        n = snprintf(buf + pos, len - pos, "[xip] %lu switches to tasks beyond %d contexts counted as other\n",
+                     (unsigned long)s.untracked, XIP_PROF_MAX_CONTEXTS);
+        if (n > 0) pos += (size_t)n;
+        if (pos >= len) pos = len - 1;
+    }
+    return (int)pos;
+}
@@ -51,6 +51,12 @@ extern "C" {
 #define CFG_TUSB_DEBUG        0
 #endif
 
+// With the banked SRAM layout (TKJHAT_BANKED_SRAM, see tkjhat/sram.h) the
+// class buffers go to the DMA bank instead of the banks the cores work in
+#if defined(TKJHAT_BANKED_SRAM) && TKJHAT_BANKED_SRAM
+#define CFG_TUSB_MEM_SECTION  __attribute__((section(".dma_buffers")))
+#endif
+
 //------------- CLASS DRIVERS -------------//
 
 // Enable CDC (Communication Device Class) - we need TWO CDC interfaces
@@ -59,9 +65,18 @@ extern "C" {
 // CDC buffer sizes
 // These determine how much data can be buffered for USB communication
 #define CFG_TUD_CDC_RX_BUFSIZE (512)   // Receive buffer size: 512 - 64 Depending size of data
-#define CFG_TUD_CDC_TX_BUFSIZE (128)  // Transmit buffer size: 512 - 64 Depending size of data
+#define CFG_TUD_CDC_TX_BUFSIZE (1024) // Transmit buffer size: room for a few stream frames (usbSerialDebug/stream.h)
 #define CFG_TUD_CDC_EP_BUFSIZE (64)   // Size of the Endpoint Buffer. In Pico Must be 64 for full speed. 
 
+// One HID interface: IMU air mouse / gamepad (usbSerialDebug/hid.h).
+// Only in the usb_serial_debug_hid library, which defines USB_SERIAL_DEBUG_HID.
+#if USB_SERIAL_DEBUG_HID
+#define CFG_TUD_HID (1)
+#define CFG_TUD_HID_EP_BUFSIZE (16)   // largest report: gamepad, 11 bytes + report ID
+#else
+#define CFG_TUD_HID (0)
+#endif
+
 //Since Pico is Full Speed, endpoint0 size is always 64
 #ifndef CFG_TUD_ENDPOINT0_SIZE
 #define CFG_TUD_ENDPOINT0_SIZE  (64)
@@ -70,7 +85,6 @@ extern "C" {
 
 // We don't need other USB classes for this case
 #define CFG_TUD_MSC     0  // Mass Storage Class (USB drive functionality)
-#define CFG_TUD_HID     0  // Human Interface Device (keyboard/mouse)
 #define CFG_TUD_MIDI    0  // MIDI
 #define CFG_TUD_AUDIO   0  // Audio
 #define CFG_TUD_VIDEO   0  // Video
@@ -0,0 +1,158 @@
+/*
+
+Version 0.80
+
+MIT License
+
+Copyright (c) 2025 Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <tkjhat/air_mouse.h>
+#include <tkjhat/log_hist.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @file hid.h
+ * @brief IMU air mouse / gamepad on a USB HID interface (TinyUSB + FreeRTOS).
+ *
+ * Link @c usb_serial_debug_hid instead of @c usb_serial_debug to get it: the
+ * composite device then has a HID interface next to the two CDC ones (and its
+ * own PID), with a
+ * mouse (report ::USB_HID_REPORT_ID_MOUSE) and a gamepad
+ * (::USB_HID_REPORT_ID_GAMEPAD) polled by the host every ::USB_HID_POLL_MS.
+ * ::usb_hid_init starts a task that turns every IMU sample into a report
+ * (tkjhat/air_mouse.h) with BUTTON1 and BUTTON2 as the two buttons:
+ *
+ * - The IMU pulses INT1 when a sample is ready
+ *   (::ICM42670_enable_data_ready_int); the interrupt wakes the task, which
+ *   reads the sample in one burst (::hat_snapshot_read) and queues the report
+ *   at once. Without the interrupt the task reads the IMU every tick.
+ * - Samples that arrive while a report waits for the host poll are merged
+ *   into the report queued with the next sample. At 800 Hz every poll finds
+ *   a report at most one sample old; faster rates only merge more samples
+ *   (see @c host/bench/bench_air_mouse).
+ *
+ * Latency is measured per report, from the data-ready edge of its oldest
+ * sample: to the report being queued (bus read and mapping), from queued to
+ * read by the host (completion of the IN transfer), and the total. The delay
+ * of the sensor's own filters before the edge is not included.
+ *
+ * @pre TinyUSB running in a task (@c tud_task()) as for helper.h, the IMU
+ *      initialized and started (e.g. at 800 Hz so every poll gets a fresh
+ *      sample), ::hat_snapshot_init called.
+ * @note The task reads the IMU on @c i2c_default: do not use the bus from
+ *       another task while it runs.
+ *
+ * @code
+ * init_ICM42670();
+ * ICM42670_startAccel(800, 4);
+ * ICM42670_startGyro(800, 500);
+ * ICM42670_enable_accel_gyro_ln_mode();
+ * hat_snapshot_init();
+ * air_mouse_config_t cfg = AIR_MOUSE_DEFAULT_CONFIG;
+ * usb_hid_init(&cfg);
+ * ...
+ * usb_hid_format_report(line, sizeof(line));
+ * usb_serial_print(line);
+ * @endcode
+ */
+
+#define USB_HID_REPORT_ID_MOUSE     1
+#define USB_HID_REPORT_ID_GAMEPAD   2
+#define USB_HID_POLL_MS             1       // bInterval of the interrupt IN endpoint
+#define USB_HID_TASK_STACK          1024    // words
+#define USB_HID_TASK_PRIORITY       4       // above the USB task (3), so a sample is read as soon as it is ready
+
+
+/**
+ * @brief Counters and latency histograms (microseconds).
+ */
+typedef struct {
+    air_mouse_stats_t motion;       ///< Samples, reports, merged samples, gyro offset
+    uint32_t data_ready;            ///< Samples read after a data-ready interrupt
+    uint32_t missed;                ///< Samples overwritten in the IMU before the task read them
+    uint32_t timeouts;              ///< Samples read without an interrupt (none came, or the interrupt is not used)
+    uint32_t read_errors;           ///< IMU reads that failed
+    uint32_t queued;                ///< Reports handed to TinyUSB
+    uint32_t delivered;             ///< Reports read by the host
+    log_hist_t sample_to_queue;     ///< Data-ready edge -> report queued
+    log_hist_t queue_to_host;       ///< Report queued -> read by the host
+    log_hist_t motion_to_host;      ///< Data-ready edge -> read by the host
+} usb_hid_stats_t;
+
+
+/**
+ * @brief Start the air mouse task.
+ *
+ * Configures the two buttons as inputs. The task enables the IMU data-ready
+ * interrupt on ::ICM42670_INT when it starts.
+ *
+ * @param cfg Mapping of the motion, NULL for ::AIR_MOUSE_DEFAULT_CONFIG.
+ *
+ * @pre Call after @c tusb_init(). Can be called before the scheduler starts.
+ * @return @c true on success, @c false if resources could not be created.
+ */
+bool usb_hid_init(const air_mouse_config_t *cfg);
+
+/**
+ * @brief Switch between ::AIR_MOUSE_POINTER and ::AIR_MOUSE_GAMEPAD reports.
+ */
+void usb_hid_set_mode(uint8_t mode);
+
+/**
+ * @brief @c true if the IMU data-ready interrupt paces the reports.
+ */
+bool usb_hid_data_ready_enabled(void);
+
+/**
+ * @brief Copy the counters and histograms.
+ */
+void usb_hid_get_stats(usb_hid_stats_t *out);
+
+/**
+ * @brief Clear the counters and histograms.
+ */
+void usb_hid_reset_stats(void);
+
+/**
+ * @brief Write a short text report (counts and latency percentiles) into @p buf.
+ *
+ * Suitable for ::usb_serial_print() or printf().
+ *
+ * @return Number of characters written (excluding the terminator).
+ */
+int usb_hid_format_report(char *buf, size_t len);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,128 @@
+/*
+
+Version 0.80
+
+MIT License
+
+Copyright (c) 2025 Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "usbSerialDebug/stream_proto.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @file stream.h
+ * @brief Sensor record streams and commands on CDC1 (TinyUSB + FreeRTOS).
+ *
+ * Runs a ::stream_server_t (see stream_proto.h) on CDC interface 1: a service
+ * task answers the host requests, and application tasks publish records with
+ * the @c usb_stream_send_* functions. Publishing never blocks: when the host is
+ * not reading fast enough the record is dropped and counted, so a sampling
+ * task keeps its timing. Records of a stream are only sent after the host
+ * enabled it, so an idle host costs one mask test per record.
+ *
+ * The host side is @c host/client (C++17), which also has a pty stand-in of
+ * this handler for testing without a board.
+ *
+ * @pre TinyUSB running in a task (@c tud_task()) as for helper.h.
+ * @note The application owns @c tud_cdc_rx_cb(); call ::usb_stream_rx from it.
+ *
+ * @code
+ * void tud_cdc_rx_cb(uint8_t itf) {
+ *     if (itf == USB_STREAM_ITF) usb_stream_rx(itf);
+ *     else ...
+ * }
+ *
+ * // in a sensor task
+ * stream_imu_t r = { .timestamp_us = time_us_32(), ... };
+ * usb_stream_send_imu(&r);
+ * @endcode
+ */
+
+#define USB_STREAM_ITF              1       // CDC interface used for the streams
+#define USB_STREAM_TASK_STACK       1024    // words
+#define USB_STREAM_TASK_PRIORITY    3
+
+
+/**
+ * @brief Start the stream service task on CDC1.
+ *
+ * @param name Device name reported by ::STREAM_CMD_INFO.
+ *
+ * @pre Call after @c tusb_init(). Can be called before the scheduler starts.
+ * @return @c true on success, @c false if resources could not be created.
+ */
+bool usb_stream_init(const char *name);
+
+/**
+ * @brief Wake the service task: data arrived on @p itf.
+ *
+ * Call from @c tud_cdc_rx_cb(). Ignores other interfaces.
+ */
+void usb_stream_rx(uint8_t itf);
+
+/**
+ * @brief Add an application command (>= ::STREAM_CMD_USER).
+ *
+ * The handler runs in the service task.
+ *
+ * @return 0 on success, -1 if the command is invalid or the table is full.
+ */
+int usb_stream_register_command(uint8_t cmd, stream_command_fn fn, void *ctx);
+
+/**
+ * @brief @c true if the host enabled the records of type @p msg
+ *        (one of the ::stream_msg_t record types).
+ */
+bool usb_stream_enabled(uint8_t msg);
+
+/**
+ * @brief Publish a record. Thread safe, never blocks.
+ *
+ * @return 1 if sent, 0 if the stream is disabled, -1 if it was dropped.
+ */
+int usb_stream_send_imu(const stream_imu_t *r);
+/** @copydoc usb_stream_send_imu */
+int usb_stream_send_env(const stream_env_t *r);
+/** @copydoc usb_stream_send_imu */
+int usb_stream_send_light(const stream_light_t *r);
+
+/**
+ * @brief Publish audio samples (split into records of ::STREAM_AUDIO_MAX_SAMPLES).
+ *
+ * @return Records sent, 0 if the stream is disabled, -1 if any was dropped.
+ */
+int usb_stream_send_audio(uint32_t timestamp_us, uint16_t sample_rate, const int16_t *pcm, size_t n);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,277 @@
+/*
+
+Version 0.80
+
+MIT License
+
+Copyright (c) 2025 Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <tkjhat/link_frame.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @file stream_proto.h
+ * @brief Record streams and request/response commands carried on CDC1.
+ *
+ * The wire format is the framing of tkjhat/link_frame.h (sync, type, seq,
+ * len, payload, CRC-16), with its own frame types:
+ *
+ * | Type                   | Direction     | Payload                               |
+ * |------------------------|---------------|---------------------------------------|
+ * | ::STREAM_MSG_REQUEST   | host > device | id, cmd, arguments                    |
+ * | ::STREAM_MSG_RESPONSE  | device > host | id, status (int8), data               |
+ * | ::STREAM_MSG_IMU       | device > host | ::stream_imu_t, 24 bytes              |
+ * | ::STREAM_MSG_ENV       | device > host | ::stream_env_t, 8 bytes               |
+ * | ::STREAM_MSG_LIGHT     | device > host | ::stream_light_t, 8 bytes             |
+ * | ::STREAM_MSG_AUDIO     | device > host | timestamp, rate, int16 samples        |
+ *
+ * All fields are little endian. The device advances the sequence number for
+ * every record it tries to send, also for the ones it drops because the USB
+ * buffer is full, so the host sees those as lost frames.
+ *
+ * A record stream is only sent after the host enabled it with
+ * ::STREAM_CMD_SET_STREAMS. The mask is cleared when the host closes the
+ * port, so a host that reconnects asks for its streams again.
+ *
+ * The request side is a small server (::stream_server_t) with the built-in
+ * commands below plus up to ::STREAM_MAX_COMMANDS application commands. It is
+ * portable C: the device handler (usbSerialDebug/stream.h) and the host pty
+ * stand-in run the same code.
+ */
+
+#define STREAM_PROTO_VERSION            1
+#define STREAM_MAX_COMMANDS             8       // application commands
+#define STREAM_MAX_DATA                 (LINK_FRAME_MAX_PAYLOAD - 2)    // request arguments / response data
+#define STREAM_AUDIO_HEADER             6       // timestamp + sample rate
+#define STREAM_AUDIO_MAX_SAMPLES        120     // samples per audio record
+
+/**
+ * @brief Frame types on the stream interface.
+ */
+typedef enum {
+    STREAM_MSG_REQUEST  = 0x01,
+    STREAM_MSG_RESPONSE = 0x02,
+    STREAM_MSG_IMU      = 0x10,
+    STREAM_MSG_ENV      = 0x11,
+    STREAM_MSG_LIGHT    = 0x12,
+    STREAM_MSG_AUDIO    = 0x13,
+} stream_msg_t;
+
+/** @brief Bit of a record type in the ::STREAM_CMD_SET_STREAMS mask. */
+#define STREAM_BIT(msg)                 (1u << ((msg) - STREAM_MSG_IMU))
+#define STREAM_ALL                      (STREAM_BIT(STREAM_MSG_IMU) | STREAM_BIT(STREAM_MSG_ENV) | \
+                                         STREAM_BIT(STREAM_MSG_LIGHT) | STREAM_BIT(STREAM_MSG_AUDIO))
+
+/**
+ * @brief Built-in commands. Application commands start at ::STREAM_CMD_USER.
+ */
+typedef enum {
+    STREAM_CMD_PING        = 0x00,  ///< Echoes the arguments back
+    STREAM_CMD_INFO        = 0x01,  ///< version(1), streams(1), uptime_ms(4), name
+    STREAM_CMD_SET_STREAMS = 0x02,  ///< mask(1); answers the mask now enabled
+    STREAM_CMD_STATS       = 0x03,  ///< requests, records, dropped, rx_crc_errors (4 bytes each)
+    STREAM_CMD_USER        = 0x40,
+} stream_cmd_t;
+
+/**
+ * @brief Response status.
+ */
+typedef enum {
+    STREAM_OK              = 0,
+    STREAM_ERR_UNKNOWN_CMD = -1,    ///< No handler for the command
+    STREAM_ERR_BAD_ARGS    = -2,    ///< Arguments of the wrong size or value
+    STREAM_ERR_FAILED      = -3,    ///< The handler could not carry the command out
+} stream_status_t;
+
+/** @brief IMU record. */
+typedef struct {
+    uint32_t timestamp_us;
+    int16_t  accel_mg[3];
+    int16_t  temp_c100;
+    int32_t  gyro_mdps[3];
+} stream_imu_t;
+
+/** @brief Temperature and humidity record. */
+typedef struct {
+    uint32_t timestamp_us;
+    int16_t  temp_c100;
+    uint16_t humidity_p100;
+} stream_env_t;
+
+/** @brief Ambient light record. */
+typedef struct {
+    uint32_t timestamp_us;
+    uint32_t lux;
+} stream_light_t;
+
+/**
+ * @brief Application command handler.
+ *
+ * @param ctx      Pointer given to ::stream_server_register.
+ * @param args     Request arguments.
+ * @param len      Number of argument bytes.
+ * @param out      Response data, up to ::STREAM_MAX_DATA bytes.
+ * @param out_len  Set to the number of response bytes (starts at 0).
+ *
+ * @return ::STREAM_OK or a negative ::stream_status_t.
+ */
+typedef int (*stream_command_fn)(void *ctx, const uint8_t *args, size_t len, uint8_t *out, size_t *out_len);
+
+/**
+ * @brief Writes one encoded frame to the link.
+ *
+ * @param wait @c false for records: drop the frame rather than block.
+ * @return @c true if the whole frame was written.
+ */
+typedef bool (*stream_write_fn)(void *ctx, const uint8_t *frame, size_t len, bool wait);
+
+/**
+ * @brief Server state and counters. Not thread safe: the caller serialises
+ *        ::stream_server_feed and the send functions.
+ */
+typedef struct {
+    link_frame_decoder_t dec;
+    stream_write_fn write;
+    void    *write_ctx;
+    uint32_t (*clock_ms)(void);
+    const char *name;
+    uint8_t  tx_seq;
+    uint8_t  streams;                           ///< Enabled STREAM_BIT mask
+    uint8_t  n_commands;
+    struct {
+        uint8_t cmd;
+        stream_command_fn fn;
+        void *ctx;
+    } commands[STREAM_MAX_COMMANDS];
+
+    uint32_t requests;                          ///< Requests answered
+    uint32_t records;                           ///< Records written
+    uint32_t dropped;                           ///< Records dropped by the writer
+} stream_server_t;
+
+/**
+ * @brief Initialise a server.
+ *
+ * @param s        Server.
+ * @param name     Device name returned by ::STREAM_CMD_INFO.
+ * @param write    Frame writer.
+ * @param ctx      Passed to @p write.
+ * @param clock_ms Uptime source for ::STREAM_CMD_INFO, may be @c NULL.
+ */
+void stream_server_init(stream_server_t *s, const char *name, stream_write_fn write, void *ctx,
+                        uint32_t (*clock_ms)(void));
+
+/**
+ * @brief Add an application command (>= ::STREAM_CMD_USER).
+ *
+ * @return 0 on success, -1 if the command is invalid or the table is full.
+ */
+int stream_server_register(stream_server_t *s, uint8_t cmd, stream_command_fn fn, void *ctx);
+
+/**
+ * @brief Feed bytes received from the host; requests are answered from here.
+ *
+ * @return Number of requests handled.
+ */
+int stream_server_feed(stream_server_t *s, const uint8_t *data, size_t n);
+
+/**
+ * @brief Forget the enabled streams and the partial request (host went away).
+ */
+void stream_server_reset(stream_server_t *s);
+
+/**
+ * @brief @c true if the host enabled the records of type @p msg.
+ */
+static inline bool stream_server_enabled(const stream_server_t *s, uint8_t msg) {
+    return (s->streams & STREAM_BIT(msg)) != 0;
+}
+
+/**
+ * @brief Send one record if its stream is enabled.
+ *
+ * @return 1 if sent, 0 if the stream is disabled, -1 if the writer dropped it.
+ */
+int stream_server_send_imu(stream_server_t *s, const stream_imu_t *r);
+/** @copydoc stream_server_send_imu */
+int stream_server_send_env(stream_server_t *s, const stream_env_t *r);
+/** @copydoc stream_server_send_imu */
+int stream_server_send_light(stream_server_t *s, const stream_light_t *r);
+
+/**
+ * @brief Send audio samples, split into records of ::STREAM_AUDIO_MAX_SAMPLES.
+ *
+ * @param s            Server.
+ * @param timestamp_us Time of the first sample.
+ * @param sample_rate  Sample rate in Hz, used for the timestamps of the next records.
+ * @param pcm          Samples.
+ * @param n            Number of samples.
+ *
+ * @return Records sent, 0 if the stream is disabled, -1 if any was dropped.
+ */
+int stream_server_send_audio(stream_server_t *s, uint32_t timestamp_us, uint16_t sample_rate,
+                             const int16_t *pcm, size_t n);
+
+/* =========================
+ *  Payload packing (both sides)
+ * ========================= */
+
+/** @brief Pack an IMU record, returns the payload length. */
+size_t stream_pack_imu(const stream_imu_t *r, uint8_t *out);
+/** @brief Unpack an IMU record, @c false if @p len is wrong. */
+bool stream_unpack_imu(const uint8_t *p, size_t len, stream_imu_t *r);
+/** @brief Pack an environment record, returns the payload length. */
+size_t stream_pack_env(const stream_env_t *r, uint8_t *out);
+/** @brief Unpack an environment record, @c false if @p len is wrong. */
+bool stream_unpack_env(const uint8_t *p, size_t len, stream_env_t *r);
+/** @brief Pack a light record, returns the payload length. */
+size_t stream_pack_light(const stream_light_t *r, uint8_t *out);
+/** @brief Unpack a light record, @c false if @p len is wrong. */
+bool stream_unpack_light(const uint8_t *p, size_t len, stream_light_t *r);
+
+/**
+ * @brief Unpack an audio record.
+ *
+ * @param p, len       Frame payload.
+ * @param timestamp_us Time of the first sample.
+ * @param sample_rate  Sample rate in Hz.
+ * @param pcm          Destination for up to ::STREAM_AUDIO_MAX_SAMPLES samples.
+ *
+ * @return Number of samples, -1 if the payload is malformed.
+ */
+int stream_unpack_audio(const uint8_t *p, size_t len, uint32_t *timestamp_us, uint16_t *sample_rate,
+                        int16_t *pcm);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -32,9 +32,16 @@ SOFTWARE.
 
 #include <tusb.h>
 
+#if USB_SERIAL_DEBUG_LOCK_PROFILE
+#include <tkjhat/lock_profiler.h>
+#endif
+
 #include "usbSerialDebug/helper.h"
 
 static SemaphoreHandle_t g_log_mtx;
+#if USB_SERIAL_DEBUG_LOCK_PROFILE
+static int g_log_lock = -1;     // lock profiler id
+#endif
 static const TickType_t wait = pdMS_TO_TICKS(5);
 static const TickType_t io_timeout = pdMS_TO_TICKS(10);
 
@@ -42,9 +49,31 @@ static inline bool cdc0_ready(void) {
     return tud_mounted() && tud_cdc_n_connected(0);
 }
 
-static SemaphoreHandle_t g_log_mtx;
+#if USB_SERIAL_DEBUG_LOCK_PROFILE
+// Mutex take/give through the lock profiler (see tkjhat/lock_profiler.h)
+static inline BaseType_t log_take(TickType_t ticks) {
+    return g_log_lock >= 0 ? lock_prof_take(g_log_lock, ticks) : xSemaphoreTake(g_log_mtx, ticks);
+}
+
+static inline void log_give(void) {
+    if (g_log_lock >= 0) lock_prof_give(g_log_lock);
+    else xSemaphoreGive(g_log_mtx);
+}
+#else
+static inline BaseType_t log_take(TickType_t ticks) {
+    return xSemaphoreTake(g_log_mtx, ticks);
+}
+
+static inline void log_give(void) {
+    xSemaphoreGive(g_log_mtx);
+}
+#endif
+
 bool usb_serial_init(void) {
     g_log_mtx = xSemaphoreCreateMutex();
+#if USB_SERIAL_DEBUG_LOCK_PROFILE
+    if (g_log_mtx) g_log_lock = lock_prof_register(g_log_mtx, "usb_log");
+#endif
     return g_log_mtx != NULL;
 }
 
@@ -53,9 +82,9 @@ void usb_serial_flush(void) {
     if (!cdc0_ready()) return;
 
     // Try to take the mutex for not interfering with current writing
-    if (g_log_mtx && xSemaphoreTake(g_log_mtx, 0) == pdTRUE) {
+    if (g_log_mtx && log_take(0) == pdTRUE) {
         tud_cdc_n_write_flush(0);
-        xSemaphoreGive(g_log_mtx);
+        log_give();
     } else {
         // If we do not get instantly we ask for a flush. 
         // TinyUSB handle it in a safe way (hopefully).
@@ -74,7 +103,7 @@ int usb_serial_print(const char *s) {
     if ( !tud_mounted() || !tud_cdc_connected()) 
         return 0;
     
-    if (xSemaphoreTake(g_log_mtx, wait) != pdTRUE) 
+    if (log_take(wait) != pdTRUE) 
         return 0;
 
     size_t initial, n = strlen(s);
@@ -92,12 +121,12 @@ int usb_serial_print(const char *s) {
         } 
         else {
             if (io_timeout == 0 || (int32_t)(xTaskGetTickCount() - deadline) >= 0) {
-                xSemaphoreGive(g_log_mtx);
+                log_give();
                 return false; // give up to avoid blocking too long
             }
             vTaskDelay(pdMS_TO_TICKS(1));
         }
     }
-    xSemaphoreGive(g_log_mtx);
+    log_give();
     return initial-n;
 }
\ No newline at end of file
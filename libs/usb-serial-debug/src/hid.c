@@ -0,0 +1,226 @@
+/*
+
+Version 0.80
+
+MIT License
+
+Copyright (c) 2025 Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include <task.h>
+
+#include <pico/stdlib.h>
+#include <tusb.h>
+
+#include <tkjhat/sdk.h>
+#include <tkjhat/gpio_irq.h>
+#include <tkjhat/hat_snapshot.h>
+
+#include "usbSerialDebug/hid.h"
+
+static air_mouse_t g_motion;
+static usb_hid_stats_t g_stats;
+static SemaphoreHandle_t g_mtx;             // motion state, report in flight, stats
+static TaskHandle_t g_task;
+static volatile uint32_t g_edge_us;         // last data-ready edge (low 32 bits of time_us_64)
+static bool g_data_ready;
+
+// Report handed to TinyUSB and not read by the host yet
+static bool g_in_flight;
+static uint64_t g_queued_us;
+static uint64_t g_sample_us;
+
+static void on_data_ready(const gpio_irq_event_t *ev, void *ctx) {
+    (void)ctx;
+    g_edge_us = (uint32_t)ev->timestamp_us;
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(g_task, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+// Queue the next report if the endpoint is free. Called with g_mtx held.
+static void send_locked(void) {
+    if (g_in_flight || !air_mouse_pending(&g_motion) || !tud_hid_ready()) return;
+    air_mouse_report_t r;
+    if (!air_mouse_take(&g_motion, &r)) return;
+    bool ok = g_motion.cfg.mode == AIR_MOUSE_GAMEPAD
+        ? tud_hid_gamepad_report(USB_HID_REPORT_ID_GAMEPAD, r.x, r.y, 0, r.rz, 0, 0, GAMEPAD_HAT_CENTERED, r.buttons)
+        : tud_hid_mouse_report(USB_HID_REPORT_ID_MOUSE, r.buttons, r.dx, r.dy, 0, 0);
+    if (!ok) return;
+    uint64_t now = time_us_64();
+    g_in_flight = true;
+    g_queued_us = now;
+    g_sample_us = r.sample_us;
+    g_stats.queued++;
+    log_hist_add(&g_stats.sample_to_queue, (uint32_t)(now - r.sample_us));
+}
+
+static void hid_task(void *arg) {
+    (void)arg;
+    // Here rather than in usb_hid_init: nothing may delay tusb_init() and the
+    // scheduler start. Falls back to reading every tick if the IMU does not
+    // take the interrupt configuration.
+    gpio_init(ICM42670_INT);
+    gpio_set_dir(ICM42670_INT, GPIO_IN);
+    g_data_ready = ICM42670_enable_data_ready_int() == 0 &&
+                   gpio_irq_register(ICM42670_INT, GPIO_IRQ_EDGE_FALL, on_data_ready, NULL, false) == 0;
+    for (;;) {
+        // With the interrupt a sample is due every ODR period; the timeout only
+        // catches a lost edge. Without it, read once per tick.
+        uint32_t edges = ulTaskNotifyTake(pdTRUE, g_data_ready ? pdMS_TO_TICKS(5) : 1);
+        if (!tud_mounted() || tud_suspended()) {
+            xSemaphoreTake(g_mtx, portMAX_DELAY);
+            g_in_flight = false;
+            xSemaphoreGive(g_mtx);
+            continue;
+        }
+
+        hat_snapshot_t s;
+        int rc = hat_snapshot_read(&s, HAT_SNAPSHOT_IMU);
+        uint8_t buttons = (gpio_get(BUTTON1) ? AIR_MOUSE_BUTTON1 : 0) | (gpio_get(BUTTON2) ? AIR_MOUSE_BUTTON2 : 0);
+        // Time of the sample: its data-ready edge, extended to 64 bits (unless a
+        // newer edge came during the read)
+        uint64_t t = s.timestamp_us;
+        uint32_t since_edge = (uint32_t)s.timestamp_us - g_edge_us;
+        if (edges && since_edge < 100000u) t -= since_edge;
+
+        xSemaphoreTake(g_mtx, portMAX_DELAY);
+        if (rc != 0 || !(s.valid & HAT_SNAPSHOT_IMU)) {
+            g_stats.read_errors++;
+        } else {
+            if (edges) {
+                g_stats.data_ready++;
+                g_stats.missed += edges - 1;
+            } else {
+                g_stats.timeouts++;
+            }
+            air_mouse_update(&g_motion, t, s.gyro_mdps, s.accel_mg, buttons);
+            send_locked();
+        }
+        xSemaphoreGive(g_mtx);
+    }
+}
+
+bool usb_hid_init(const air_mouse_config_t *cfg) {
+    g_mtx = xSemaphoreCreateMutex();
+    if (!g_mtx) return false;
+    air_mouse_init(&g_motion, cfg);
+    usb_hid_reset_stats();
+    init_button1();
+    init_button2();
+    if (xTaskCreate(hid_task, "usb_hid", USB_HID_TASK_STACK, NULL, USB_HID_TASK_PRIORITY, &g_task) != pdPASS) {
+        vSemaphoreDelete(g_mtx);
+        g_mtx = NULL;
+        return false;
+    }
+    return true;
+}
+
+void usb_hid_set_mode(uint8_t mode) {
+    if (!g_mtx) return;
+    xSemaphoreTake(g_mtx, portMAX_DELAY);
+    air_mouse_set_mode(&g_motion, mode);
+    xSemaphoreGive(g_mtx);
+}
+
+bool usb_hid_data_ready_enabled(void) {
+    return g_data_ready;
+}
+
+void usb_hid_get_stats(usb_hid_stats_t *out) {
+    if (!g_mtx) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    xSemaphoreTake(g_mtx, portMAX_DELAY);
+    *out = g_stats;
+    air_mouse_get_stats(&g_motion, &out->motion);
+    xSemaphoreGive(g_mtx);
+}
+
+void usb_hid_reset_stats(void) {
+    if (g_mtx) xSemaphoreTake(g_mtx, portMAX_DELAY);
+    memset(&g_stats, 0, sizeof(g_stats));
+    log_hist_init(&g_stats.sample_to_queue);
+    log_hist_init(&g_stats.queue_to_host);
+    log_hist_init(&g_stats.motion_to_host);
+    if (g_mtx) xSemaphoreGive(g_mtx);
+}
+
+int usb_hid_format_report(char *buf, size_t len) {
+    static usb_hid_stats_t st;      // too big for the caller's stack
+    usb_hid_get_stats(&st);
+    const log_hist_t *h[] = { &st.motion_to_host, &st.sample_to_queue, &st.queue_to_host };
+    const char *name[] = { "motion->host", "sample->queue", "queue->host" };
+    int n = snprintf(buf, len, "[hid] %s, %s: samples %lu (missed %lu, no irq %lu, errors %lu) reports %lu/%lu merged %lu\n",
+                     g_motion.cfg.mode == AIR_MOUSE_GAMEPAD ? "gamepad" : "pointer",
+                     g_data_ready ? "data ready" : "polled",
+                     (unsigned long)st.motion.samples, (unsigned long)st.missed, (unsigned long)st.timeouts,
+                     (unsigned long)st.read_errors, (unsigned long)st.delivered, (unsigned long)st.queued,
+                     (unsigned long)st.motion.merged);
+    for (int i = 0; i < 3 && n >= 0 && (size_t)n < len; i++) {
+        n += snprintf(buf + n, len - (size_t)n, "[hid] %-13s us p50 %lu p99 %lu max %lu\n", name[i],
+                      (unsigned long)log_hist_quantile(h[i], 0.5f), (unsigned long)log_hist_quantile(h[i], 0.99f),
+                      (unsigned long)h[i]->max);
+    }
+    return n < 0 ? 0 : ((size_t)n < len ? n : (int)len - 1);
+}
+
+/* =========================
+ *  TinyUSB HID callbacks
+ * ========================= */
+
+// The host read the report: account its latency. What came meanwhile is
+// queued with the next sample, which carries fresher motion than a report
+// queued now would when it is read at the next poll (host/bench/bench_air_mouse).
+void tud_hid_report_complete_cb(uint8_t instance, uint8_t const *report, uint16_t len) {
+    (void)instance; (void)report; (void)len;
+    if (!g_mtx) return;
+    uint64_t now = time_us_64();
+    xSemaphoreTake(g_mtx, portMAX_DELAY);
+    if (g_in_flight) {
+        g_in_flight = false;
+        g_stats.delivered++;
+        log_hist_add(&g_stats.queue_to_host, (uint32_t)(now - g_queued_us));
+        log_hist_add(&g_stats.motion_to_host, (uint32_t)(now - g_sample_us));
+    }
+    xSemaphoreGive(g_mtx);
+}
+
+// GET_REPORT on the control endpoint: not supported, the host reads the interrupt endpoint
+uint16_t tud_hid_get_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type,
+                               uint8_t *buffer, uint16_t reqlen) {
+    (void)instance; (void)report_id; (void)report_type; (void)buffer; (void)reqlen;
+    return 0;
+}
+
+// SET_REPORT / OUT data: the mouse and gamepad have no output reports
+void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type,
+                           uint8_t const *buffer, uint16_t bufsize) {
+    (void)instance; (void)report_id; (void)report_type; (void)buffer; (void)bufsize;
+}
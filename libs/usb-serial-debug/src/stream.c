@@ -0,0 +1,166 @@
+/*
+
+Version 0.80
+
+MIT License
+
+Copyright (c) 2025 Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include <string.h>
+
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include <task.h>
+
+#include <pico/time.h>
+#include <tusb.h>
+
+#include "usbSerialDebug/stream.h"
+
+static stream_server_t g_server;
+static SemaphoreHandle_t g_mtx;             // recursive: handlers may publish
+static TaskHandle_t g_task;
+static const TickType_t poll_period = pdMS_TO_TICKS(10);
+static const TickType_t io_timeout = pdMS_TO_TICKS(10);
+
+static inline bool cdc_ready(void) {
+    return tud_mounted() && tud_cdc_n_connected(USB_STREAM_ITF);
+}
+
+static uint32_t uptime_ms(void) {
+    return to_ms_since_boot(get_absolute_time());
+}
+
+// Records (wait == false) are written whole or not at all; responses wait a little for space
+static bool cdc_write(void *ctx, const uint8_t *frame, size_t len, bool wait) {
+    (void)ctx;
+    if (!cdc_ready()) return false;
+    if (!wait) {
+        if (tud_cdc_n_write_available(USB_STREAM_ITF) < len) return false;
+        tud_cdc_n_write(USB_STREAM_ITF, frame, (uint32_t)len);
+        tud_cdc_n_write_flush(USB_STREAM_ITF);
+        return true;
+    }
+    TickType_t deadline = xTaskGetTickCount() + io_timeout;
+    while (len) {
+        uint32_t avail = tud_cdc_n_write_available(USB_STREAM_ITF);
+        if (avail) {
+            uint32_t chunk = len < avail ? (uint32_t)len : avail;
+            tud_cdc_n_write(USB_STREAM_ITF, frame, chunk);
+            tud_cdc_n_write_flush(USB_STREAM_ITF);
+            frame += chunk;
+            len -= chunk;
+        } else {
+            if ((int32_t)(xTaskGetTickCount() - deadline) >= 0 || !cdc_ready()) return false;
+            vTaskDelay(pdMS_TO_TICKS(1));
+        }
+    }
+    return true;
+}
+
+static void stream_task(void *arg) {
+    (void)arg;
+    uint8_t buf[64];
+    bool was_connected = false;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, poll_period);
+        bool connected = cdc_ready();
+        if (!connected) {
+            if (was_connected) {
+                // Host closed the port: it asks for its streams again when it comes back
+                xSemaphoreTakeRecursive(g_mtx, portMAX_DELAY);
+                stream_server_reset(&g_server);
+                xSemaphoreGiveRecursive(g_mtx);
+            }
+            was_connected = false;
+            continue;
+        }
+        was_connected = true;
+        while (tud_cdc_n_available(USB_STREAM_ITF)) {
+            uint32_t n = tud_cdc_n_read(USB_STREAM_ITF, buf, sizeof(buf));
+            if (n == 0) break;
+            xSemaphoreTakeRecursive(g_mtx, portMAX_DELAY);
+            stream_server_feed(&g_server, buf, n);
+            xSemaphoreGiveRecursive(g_mtx);
+        }
+    }
+}
+
+bool usb_stream_init(const char *name) {
+    g_mtx = xSemaphoreCreateRecursiveMutex();
+    if (!g_mtx) return false;
+    stream_server_init(&g_server, name, cdc_write, NULL, uptime_ms);
+    if (xTaskCreate(stream_task, "usb_stream", USB_STREAM_TASK_STACK, NULL, USB_STREAM_TASK_PRIORITY, &g_task) != pdPASS) {
+        vSemaphoreDelete(g_mtx);
+        g_mtx = NULL;
+        return false;
+    }
+    return true;
+}
+
+void usb_stream_rx(uint8_t itf) {
+    if (itf == USB_STREAM_ITF && g_task) xTaskNotifyGive(g_task);
+}
+
+int usb_stream_register_command(uint8_t cmd, stream_command_fn fn, void *ctx) {
+    if (!g_mtx) return -1;
+    xSemaphoreTakeRecursive(g_mtx, portMAX_DELAY);
+    int r = stream_server_register(&g_server, cmd, fn, ctx);
+    xSemaphoreGiveRecursive(g_mtx);
+    return r;
+}
+
+bool usb_stream_enabled(uint8_t msg) {
+    return g_mtx && stream_server_enabled(&g_server, msg);
+}
+
+// Publishing gives up instead of waiting behind a response being written.
+// Those drops are not counted by the server (the counters belong to the lock holder).
+#define PUBLISH(call)                                                   \
+    do {                                                                \
+        if (!g_mtx) return 0;                                           \
+        if (xSemaphoreTakeRecursive(g_mtx, 0) != pdTRUE) return -1;     \
+        int r_ = (call);                                                \
+        xSemaphoreGiveRecursive(g_mtx);                                 \
+        return r_;                                                      \
+    } while (0)
+
+int usb_stream_send_imu(const stream_imu_t *r) {
+    if (!usb_stream_enabled(STREAM_MSG_IMU)) return 0;
+    PUBLISH(stream_server_send_imu(&g_server, r));
+}
+
+int usb_stream_send_env(const stream_env_t *r) {
+    if (!usb_stream_enabled(STREAM_MSG_ENV)) return 0;
+    PUBLISH(stream_server_send_env(&g_server, r));
+}
+
+int usb_stream_send_light(const stream_light_t *r) {
+    if (!usb_stream_enabled(STREAM_MSG_LIGHT)) return 0;
+    PUBLISH(stream_server_send_light(&g_server, r));
+}
+
+int usb_stream_send_audio(uint32_t timestamp_us, uint16_t sample_rate, const int16_t *pcm, size_t n) {
+    if (!usb_stream_enabled(STREAM_MSG_AUDIO)) return 0;
+    PUBLISH(stream_server_send_audio(&g_server, timestamp_us, sample_rate, pcm, n));
+}
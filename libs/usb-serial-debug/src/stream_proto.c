@@ -0,0 +1,257 @@
+/*
+
+Version 0.80
+
+MIT License
+
+Copyright (c) 2025 Iván Sánchez Milara
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include <string.h>
+
+#include "usbSerialDebug/stream_proto.h"
+
+#define IMU_LEN     24
+#define ENV_LEN     8
+#define LIGHT_LEN   8
+
+/* =========================
+ *  Little-endian helpers
+ * ========================= */
+static void put16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void put32(uint8_t *p, uint32_t v) { put16(p, (uint16_t)v); put16(p + 2, (uint16_t)(v >> 16)); }
+static uint16_t get16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t get32(const uint8_t *p) { return get16(p) | ((uint32_t)get16(p + 2) << 16); }
+
+/* =========================
+ *  Packing
+ * ========================= */
+size_t stream_pack_imu(const stream_imu_t *r, uint8_t *out) {
+    put32(out, r->timestamp_us);
+    for (int i = 0; i < 3; i++) put16(out + 4 + 2 * i, (uint16_t)r->accel_mg[i]);
+    put16(out + 10, (uint16_t)r->temp_c100);
+    for (int i = 0; i < 3; i++) put32(out + 12 + 4 * i, (uint32_t)r->gyro_mdps[i]);
+    return IMU_LEN;
+}
+
+bool stream_unpack_imu(const uint8_t *p, size_t len, stream_imu_t *r) {
+    if (len != IMU_LEN) return false;
+    r->timestamp_us = get32(p);
+    for (int i = 0; i < 3; i++) r->accel_mg[i] = (int16_t)get16(p + 4 + 2 * i);
+    r->temp_c100 = (int16_t)get16(p + 10);
+    for (int i = 0; i < 3; i++) r->gyro_mdps[i] = (int32_t)get32(p + 12 + 4 * i);
+    return true;
+}
+
+size_t stream_pack_env(const stream_env_t *r, uint8_t *out) {
+    put32(out, r->timestamp_us);
+    put16(out + 4, (uint16_t)r->temp_c100);
+    put16(out + 6, r->humidity_p100);
+    return ENV_LEN;
+}
+
+bool stream_unpack_env(const uint8_t *p, size_t len, stream_env_t *r) {
+    if (len != ENV_LEN) return false;
+    r->timestamp_us = get32(p);
+    r->temp_c100 = (int16_t)get16(p + 4);
+    r->humidity_p100 = get16(p + 6);
+    return true;
+}
+
+size_t stream_pack_light(const stream_light_t *r, uint8_t *out) {
+    put32(out, r->timestamp_us);
+    put32(out + 4, r->lux);
+    return LIGHT_LEN;
+}
+
+bool stream_unpack_light(const uint8_t *p, size_t len, stream_light_t *r) {
+    if (len != LIGHT_LEN) return false;
+    r->timestamp_us = get32(p);
+    r->lux = get32(p + 4);
+    return true;
+}
+
+int stream_unpack_audio(const uint8_t *p, size_t len, uint32_t *timestamp_us, uint16_t *sample_rate,
+                        int16_t *pcm) {
+    if (len < STREAM_AUDIO_HEADER || (len - STREAM_AUDIO_HEADER) % 2) return -1;
+    size_t n = (len - STREAM_AUDIO_HEADER) / 2;
+    if (n > STREAM_AUDIO_MAX_SAMPLES) return -1;
+    *timestamp_us = get32(p);
+    *sample_rate = get16(p + 4);
+    for (size_t i = 0; i < n; i++) pcm[i] = (int16_t)get16(p + STREAM_AUDIO_HEADER + 2 * i);
+    return (int)n;
+}
+
+/* =========================
+ *  Server
+ * ========================= */
+static bool send_frame(stream_server_t *s, uint8_t type, const uint8_t *payload, size_t len, bool wait) {
+    uint8_t frame[LINK_FRAME_MAX_SIZE];
+    size_t n = link_frame_encode(type, s->tx_seq++, payload, len, frame, sizeof(frame));
+    return n && s->write(s->write_ctx, frame, n, wait);
+}
+
+static int send_record(stream_server_t *s, uint8_t type, const uint8_t *payload, size_t len) {
+    if (!stream_server_enabled(s, type)) return 0;
+    if (!send_frame(s, type, payload, len, false)) {
+        s->dropped++;
+        return -1;
+    }
+    s->records++;
+    return 1;
+}
+
+void stream_server_init(stream_server_t *s, const char *name, stream_write_fn write, void *ctx,
+                        uint32_t (*clock_ms)(void)) {
+    memset(s, 0, sizeof(*s));
+    link_frame_decoder_init(&s->dec);
+    s->write = write;
+    s->write_ctx = ctx;
+    s->clock_ms = clock_ms;
+    s->name = name ? name : "";
+}
+
+int stream_server_register(stream_server_t *s, uint8_t cmd, stream_command_fn fn, void *ctx) {
+    if (cmd < STREAM_CMD_USER || !fn || s->n_commands >= STREAM_MAX_COMMANDS) return -1;
+    for (unsigned i = 0; i < s->n_commands; i++)
+        if (s->commands[i].cmd == cmd) return -1;
+    s->commands[s->n_commands].cmd = cmd;
+    s->commands[s->n_commands].fn = fn;
+    s->commands[s->n_commands].ctx = ctx;
+    s->n_commands++;
+    return 0;
+}
+
+void stream_server_reset(stream_server_t *s) {
+    s->streams = 0;
+    uint32_t crc_errors = s->dec.crc_errors;
+    link_frame_decoder_init(&s->dec);
+    s->dec.crc_errors = crc_errors;
+}
+
+static int builtin(stream_server_t *s, uint8_t cmd, const uint8_t *args, size_t len, uint8_t *out, size_t *out_len) {
+    switch (cmd) {
+    case STREAM_CMD_PING:
+        memcpy(out, args, len);
+        *out_len = len;
+        return STREAM_OK;
+    case STREAM_CMD_INFO: {
+        size_t name_len = strlen(s->name);
+        if (name_len > STREAM_MAX_DATA - 6) name_len = STREAM_MAX_DATA - 6;
+        out[0] = STREAM_PROTO_VERSION;
+        out[1] = STREAM_ALL;
+        put32(out + 2, s->clock_ms ? s->clock_ms() : 0);
+        memcpy(out + 6, s->name, name_len);
+        *out_len = 6 + name_len;
+        return STREAM_OK;
+    }
+    case STREAM_CMD_SET_STREAMS:
+        if (len != 1 || (args[0] & ~STREAM_ALL)) return STREAM_ERR_BAD_ARGS;
+        s->streams = args[0];
+        out[0] = s->streams;
+        *out_len = 1;
+        return STREAM_OK;
+    case STREAM_CMD_STATS:
+        put32(out, s->requests);
+        put32(out + 4, s->records);
+        put32(out + 8, s->dropped);
+        put32(out + 12, s->dec.crc_errors);
+        *out_len = 16;
+        return STREAM_OK;
+    default:
+        return STREAM_ERR_UNKNOWN_CMD;
+    }
+}
+
+static void handle_request(stream_server_t *s) {
+    const link_frame_decoder_t *d = &s->dec;
+    if (d->type != STREAM_MSG_REQUEST || d->len < 2) return;
+
+    uint8_t resp[LINK_FRAME_MAX_PAYLOAD];
+    size_t out_len = 0;
+    uint8_t cmd = d->payload[1];
+    const uint8_t *args = &d->payload[2];
+    size_t len = d->len - 2u;
+    int status = STREAM_ERR_UNKNOWN_CMD;
+
+    if (cmd < STREAM_CMD_USER) {
+        status = builtin(s, cmd, args, len, &resp[2], &out_len);
+    } else {
+        for (unsigned i = 0; i < s->n_commands; i++) {
+            if (s->commands[i].cmd == cmd) {
+                status = s->commands[i].fn(s->commands[i].ctx, args, len, &resp[2], &out_len);
+                break;
+            }
+        }
+    }
+    if (out_len > STREAM_MAX_DATA || status != STREAM_OK) out_len = 0;
+    resp[0] = d->payload[0];
+    resp[1] = (uint8_t)(int8_t)status;
+    s->requests++;
+    send_frame(s, STREAM_MSG_RESPONSE, resp, out_len + 2, true);
+}
+
+int stream_server_feed(stream_server_t *s, const uint8_t *data, size_t n) {
+    int handled = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (link_frame_decode_byte(&s->dec, data[i]) == LINK_FRAME_READY && s->dec.type == STREAM_MSG_REQUEST) {
+            handle_request(s);
+            handled++;
+        }
+    }
+    return handled;
+}
+
+int stream_server_send_imu(stream_server_t *s, const stream_imu_t *r) {
+    uint8_t p[IMU_LEN];
+    return send_record(s, STREAM_MSG_IMU, p, stream_pack_imu(r, p));
+}
+
+int stream_server_send_env(stream_server_t *s, const stream_env_t *r) {
+    uint8_t p[ENV_LEN];
+    return send_record(s, STREAM_MSG_ENV, p, stream_pack_env(r, p));
+}
+
+int stream_server_send_light(stream_server_t *s, const stream_light_t *r) {
+    uint8_t p[LIGHT_LEN];
+    return send_record(s, STREAM_MSG_LIGHT, p, stream_pack_light(r, p));
+}
+
+int stream_server_send_audio(stream_server_t *s, uint32_t timestamp_us, uint16_t sample_rate,
+                             const int16_t *pcm, size_t n) {
+    if (!stream_server_enabled(s, STREAM_MSG_AUDIO)) return 0;
+    uint8_t p[STREAM_AUDIO_HEADER + 2 * STREAM_AUDIO_MAX_SAMPLES];
+    int sent = 0;
+    bool dropped = false;
+    size_t done = 0;
+    while (done < n) {
+        size_t k = n - done < STREAM_AUDIO_MAX_SAMPLES ? n - done : STREAM_AUDIO_MAX_SAMPLES;
+        uint32_t ts = timestamp_us + (sample_rate ? (uint32_t)((uint64_t)done * 1000000u / sample_rate) : 0);
+        put32(p, ts);
+        put16(p + 4, sample_rate);
+        for (size_t i = 0; i < k; i++) put16(p + STREAM_AUDIO_HEADER + 2 * i, (uint16_t)pcm[done + i]);
+        if (send_record(s, STREAM_MSG_AUDIO, p, STREAM_AUDIO_HEADER + 2 * k) > 0) sent++;
+        else dropped = true;
+        done += k;
+    }
+    return dropped ? -1 : sent;
+}
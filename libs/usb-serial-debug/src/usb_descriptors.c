@@ -30,12 +30,17 @@ SOFTWARE.
  * Creates TWO separate CDC interfaces:
  * - CDC0: For printf/debug output
  * - CDC1: For communication messages  
+ * and, with USB_SERIAL_DEBUG_HID (usb_serial_debug_hid library), one HID
+ * interface (mouse + gamepad) for the IMU air mouse
  * 
  */
 
 #include "tusb.h"
 #include "pico/unique_id.h"
 #include "bsp/board_api.h"
+#if CFG_TUD_HID
+#include "usbSerialDebug/hid.h"
+#endif
 
 
 // set some example Vendor and Product ID
@@ -43,7 +48,9 @@ SOFTWARE.
 #define _PID_MAP(itf, n)  ( (CFG_TUD_##itf) << (n) )
 #define CDC_EXAMPLE_VID     0xCafe                  // If problem use 0x2E8A (Raspberry pi)
 // use _PID_MAP to generate unique PID for each interface
-#define CDC_EXAMPLE_PID     (0x4000 | _PID_MAP(CDC, 0))  //If using Raspberry Pi VID 0x000A
+// (a new PID when the interfaces change, so hosts do not reuse a cached configuration;
+// without USB_SERIAL_DEBUG_HID the PID is the plain dual CDC one)
+#define CDC_EXAMPLE_PID     (0x4000 | _PID_MAP(CDC, 0) | _PID_MAP(HID, 2))  //If using Raspberry Pi VID 0x000A
 // set USB 2.0
 #define CDC_BCD     0x0200  
 
@@ -80,6 +87,9 @@ enum {
     ITF_NUM_CDC_0_DATA,
     ITF_NUM_CDC_1,
     ITF_NUM_CDC_1_DATA,
+#if CFG_TUD_HID
+    ITF_NUM_HID,
+#endif
     ITF_NUM_TOTAL
 };
 
@@ -88,8 +98,8 @@ enum {
 // This creates a composite device with TWO CDC interfaces
 //--------------------------------------------------------------------
 
-// Calculate total length: config + 2 CDC interfaces
-#define CONFIG_TOTAL_LEN (TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN + TUD_CDC_DESC_LEN)
+// Calculate total length: config + 2 CDC interfaces (+ HID)
+#define CONFIG_TOTAL_LEN (TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN + TUD_CDC_DESC_LEN + CFG_TUD_HID * TUD_HID_DESC_LEN)
 
 // Endpoint numbers for first CDC interface (CDC0 - Debug/Printf)
 #define EPNUM_CDC0_NOTIF 0x81    // CDC0 notification endpoint
@@ -101,11 +111,28 @@ enum {
 #define EPNUM_CDC1_OUT   0x04    // CDC1 data out endpoint
 #define EPNUM_CDC1_IN    0x84    // CDC1 data in endpoint
 
+#if CFG_TUD_HID
+// Endpoint of the HID interface (air mouse reports)
+#define EPNUM_HID_IN     0x85    // HID interrupt in endpoint
+
+//--------------------------------------------------------------------
+// HID REPORT DESCRIPTOR
+// A mouse and a gamepad, told apart by the report ID
+//--------------------------------------------------------------------
+uint8_t const desc_hid_report[] = {
+    TUD_HID_REPORT_DESC_MOUSE(HID_REPORT_ID(USB_HID_REPORT_ID_MOUSE)),
+    TUD_HID_REPORT_DESC_GAMEPAD(HID_REPORT_ID(USB_HID_REPORT_ID_GAMEPAD)),
+};
+
+// called when host requests to get HID report descriptor
+uint8_t const * tud_hid_descriptor_report_cb(uint8_t instance);
+#endif
+
 // configure descriptor (for 2 CDC interfaces)
 uint8_t const desc_configuration[] = {
     // config descriptor | how much power in mA, count of interfaces, ...
     TUD_CONFIG_DESCRIPTOR(1,             // Configuration number
-                          ITF_NUM_TOTAL, // Number of interfaces (2 CDC = 4 interfaces total)
+                          ITF_NUM_TOTAL, // Number of interfaces (2 CDC = 4 interfaces + HID)
                           0,             // String index
                           CONFIG_TOTAL_LEN, 
                           TUSB_DESC_CONFIG_ATT_SELF_POWERED,          //  TUSB_DESC_CONFIG_ATT_SELF_POWERED | TUSB_DESC_CONFIG_ATT_REMOTE_WAKEUP attributes: bit7=1, bit6=self-powered, bit5=remote-wakeup
@@ -129,6 +156,17 @@ uint8_t const desc_configuration[] = {
                                    EPNUM_CDC1_IN, 
                                    CFG_TUD_CDC_EP_BUFSIZE),
 
+#if CFG_TUD_HID
+    // HID: air mouse / gamepad, polled every USB_HID_POLL_MS
+    TUD_HID_DESCRIPTOR(ITF_NUM_HID,
+                       6,                       // String index
+                       HID_ITF_PROTOCOL_NONE,   // not a boot mouse: reports carry an ID
+                       sizeof(desc_hid_report),
+                       EPNUM_HID_IN,
+                       CFG_TUD_HID_EP_BUFSIZE,
+                       USB_HID_POLL_MS),
+#endif
+
 };
 
 // called when host requests to get configuration descriptor
@@ -165,6 +203,9 @@ enum {
     STRID_SERIAL,       // 3: Serials
     STRID_CDC_0,        // 4: CDC Interface 0
     STRID_CDC_1,        // 5: CDC Interface 1
+#if CFG_TUD_HID
+    STRID_HID,          // 6: HID Interface
+#endif
 };
 
 
@@ -175,7 +216,10 @@ char const* string_desc_arr [] = {
     "123456",                        // 3: Serial number (overwritten with unique ID)
     "Stdout CDC",                    // 4: CDC0 Interface (Debug/Printf)
     "Communication CDC",             // 5: CDC1 Interface (Messages)
-    //"Reset"                          // 6: Reset interface (not added)
+#if CFG_TUD_HID
+    "Air mouse HID",                 // 6: HID Interface (IMU pointer / gamepad)
+#endif
+    //"Reset"                          // 7: Reset interface (not added)
 };
 
 // buffer to hold the string descriptor during the request | plus 1 for the null terminator
@@ -200,6 +244,13 @@ uint8_t const * tud_descriptor_configuration_cb(uint8_t index) {
     return desc_configuration;
 }
 
+#if CFG_TUD_HID
+uint8_t const * tud_hid_descriptor_report_cb(uint8_t instance) {
+    (void)instance;
+    return desc_hid_report;
+}
+#endif
+
 uint16_t const* tud_descriptor_string_cb(uint8_t index, uint16_t langid) {
     (void) langid;
     size_t char_count;
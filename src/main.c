@@ -8,6 +8,7 @@
 #include <task.h>
 
 #include "tkjhat/sdk.h"
+#include "tkjhat/early_log.h"
 
 // Exercise 4. Include the libraries necessaries to use the usb-serial-debug, and tinyusb
 // Tehtävä 4 . Lisää usb-serial-debugin ja tinyusbin käyttämiseen tarvittavat kirjastot.
@@ -163,10 +164,9 @@ int main() {
 
     stdio_init_all();
 
-    // Uncomment this lines if you want to wait till the serial monitor is connected
-    while (!stdio_usb_connected()){
-        sleep_ms(10);
-    }
+    // Do not wait for the serial monitor: output is kept in RAM and replayed when it connects
+    // Älä odota sarjamonitoria: tulosteet puskuroidaan ja toistetaan kun se yhdistetään
+    early_log_init(true);
     
     init_hat_sdk();
     sleep_ms(300); //Wait some time so initialization of USB and hat is done.
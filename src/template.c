@@ -11,6 +11,7 @@
 #include <task.h>
 
 #include "tkjhat/sdk.h"
+#include "tkjhat/early_log.h"
 
 // Default stack size for the tasks. It can be reduced to 1024 if task is not using lot of memory.
 #define DEFAULT_STACK_SIZE 2048
@@ -249,10 +250,8 @@ static void sender_task(void *pvParameters) {
 int main() {
     stdio_init_all();
     
-    // odotetaan että USB on yhdistetty
-    while (!stdio_usb_connected()) {
-        sleep_ms(100);
-    }
+    // ei odoteta USB:tä: tulosteet puskuroidaan ja toistetaan kun terminaali avataan
+    early_log_init(true);
     
     printf("Starting...\n");
     